@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+# Runs the same PrototypeBench scenarios once per physics backend and prints the physics stage
+# percentiles side by side, the reports are kept next to each other in the output folder.
+#
+#   python compare_physics.py --bench path/to/PrototypeBench.exe [--scene name] [--frames n] [--output folder] [--lockstep]
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+BACKENDS = ["PHYSX", "BULLET"]
+
+# name, extra PrototypeBench arguments
+SCENARIOS = [
+    ("cubes-256", ["--cubes", "256"]),
+    ("cubes-1024", ["--cubes", "1024"]),
+    ("cubes-4096", ["--cubes", "4096"]),
+    # debris doesn't collide with itself in the settings layer matrix, most pairs get filtered out before the narrowphase
+    ("cubes-1024-debris", ["--cubes", "1024", "--layer", "Debris"]),
+    ("vehicles-16", ["--vehicles", "16"]),
+    # traffic sized, spread over the parallel vehicle batches
+    ("vehicles-1024", ["--vehicles", "1024"]),
+    ("mixed", ["--cubes", "1024", "--vehicles", "8"]),
+    # batched scene queries against the triangle mesh colliders of the stalingrad bundle
+    ("rays-10k", ["--scene", "Stalingrad", "--rays", "10000"]),
+    # 256 pooled cubes leave and join the physics scene every frame
+    ("spawn-256", ["--spawn", "256"]),
+    # the physics steps share the threadpool with 8 loader like jobs that never let up
+    ("cubes-1024-loading", ["--cubes", "1024", "--background", "8"]),
+]
+
+
+def run(bench, scene, frames, warmup, lockstep, scenario, backend, output):
+    name, extra = scenario
+    report_path = os.path.join(output, "%s-%s.json" % (name, backend.lower()))
+    args = [bench, "--physics", backend, "--frames", str(frames), "--warmup", str(warmup), "--output", report_path]
+    if scene:
+        args += ["--scene", scene]
+    if lockstep:
+        args += ["--lockstep"]
+    args += extra
+    if subprocess.call(args) != 0:
+        print("%s on %s failed" % (name, backend), file=sys.stderr)
+        return None
+    with open(report_path) as report_file:
+        return json.load(report_file)
+
+
+def stage(report, name, percentile):
+    return report["stages"].get(name, {}).get(percentile, 0.0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="compare the physics backends throughput")
+    parser.add_argument("--bench", required=True, help="path to the PrototypeBench executable")
+    parser.add_argument("--scene", default="", help="scene to load, defaults to the settings default scene")
+    parser.add_argument("--frames", type=int, default=1000)
+    parser.add_argument("--warmup", type=int, default=60)
+    parser.add_argument("--output", default="physics_comparison")
+    # both backends simulate the same fixed steps whatever their frame times, so their workloads match
+    parser.add_argument("--lockstep", action="store_true")
+    args = parser.parse_args()
+
+    os.makedirs(args.output, exist_ok=True)
+
+    failed = False
+    rows = []
+    for scenario in SCENARIOS:
+        reports = {}
+        for backend in BACKENDS:
+            report = run(args.bench, args.scene, args.frames, args.warmup, args.lockstep, scenario, backend, args.output)
+            if report is None:
+                failed = True
+                break
+            reports[backend] = report
+        if len(reports) == len(BACKENDS):
+            rows.append((scenario[0], reports))
+
+    # physics stage percentiles in milliseconds, ratio is bullet over physx at p50
+    header = "%-18s" % "scenario"
+    for backend in BACKENDS:
+        header += "  %10s  %10s" % (backend.lower() + " p50", backend.lower() + " p95")
+    header += "  %8s" % "ratio"
+    print(header)
+    print("-" * len(header))
+    for name, reports in rows:
+        line = "%-18s" % name
+        for backend in BACKENDS:
+            line += "  %10.3f  %10.3f" % (stage(reports[backend], "Physics", "p50"), stage(reports[backend], "Physics", "p95"))
+        physx = stage(reports["PHYSX"], "Physics", "p50")
+        bullet = stage(reports["BULLET"], "Physics", "p50")
+        line += "  %8.2f" % (bullet / physx if physx > 0.0 else 0.0)
+        print(line)
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
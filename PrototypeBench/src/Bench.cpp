@@ -0,0 +1,1053 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#include "Bench.h"
+
+#include <PrototypeCommon/Definitions.h>
+#include <PrototypeCommon/FrameArena.h>
+#include <PrototypeCommon/IO.h>
+#include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/MemoryTracker.h>
+
+#include <PrototypeEngine/../../src/core/PrototypeBulk.h>
+#include <PrototypeEngine/../../src/core/PrototypeDatabase.h>
+#include <PrototypeEngine/../../src/core/PrototypeEngine.h>
+#include <PrototypeEngine/../../src/core/PrototypeObjectPool.h>
+#include <PrototypeEngine/../../src/core/PrototypePhysics.h>
+#include <PrototypeEngine/../../src/core/PrototypePluginInstance.h>
+#include <PrototypeEngine/../../src/core/PrototypeRecorder.h>
+#include <PrototypeEngine/../../src/core/PrototypeRenderer.h>
+#include <PrototypeEngine/../../src/core/PrototypeScene.h>
+#include <PrototypeEngine/../../src/core/PrototypeSceneLayer.h>
+#include <PrototypeEngine/../../src/core/PrototypeSceneNode.h>
+#include <PrototypeEngine/../../src/core/PrototypeSceneParser.h>
+#include <PrototypeEngine/../../src/core/PrototypeSceneStreamer.h>
+#include <PrototypeEngine/../../src/core/PrototypeShortcuts.h>
+#include <PrototypeEngine/../../src/core/PrototypeThreadpool.h>
+#include <PrototypeEngine/../../src/core/PrototypeTransformHierarchy.h>
+
+#include <PrototypeCommon/Maths.h>
+
+#include <PrototypeTraitSystem/PrototypeTraitSystem.h>
+
+#include <glm/glm.hpp>
+
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <optional>
+#include <string.h>
+#include <thread>
+
+#define PROTOTYPE_BENCH_GRID_ROW       32
+#define PROTOTYPE_BENCH_GRID_SPACING   3.0f
+#define PROTOTYPE_BENCH_NOISE_FLOOR_MS 0.05 // percentiles below that are too noisy to flag
+#define PROTOTYPE_BENCH_RAYS_SEED      0x2545f491u
+#define PROTOTYPE_BENCH_MATHS_ROUNDS   64
+#define PROTOTYPE_BENCH_STREAMING_ROW  16    // the nodes of a streamed layer are a square of this many per row
+#define PROTOTYPE_BENCH_STREAMING_GAP  64.0f // distance between the centers of two streamed layers
+#define PROTOTYPE_BENCH_STREAMING_LAP  600   // frames the streaming focus takes to sweep over every layer and back
+#define PROTOTYPE_BENCH_PARSE_ROUNDS   8
+#define PROTOTYPE_BENCH_PARSE_LAYERS   8    // layers the nodes of the generated scene are spread over
+#define PROTOTYPE_BENCH_PARSE_CHILDREN 3    // children every root node of the generated scene gets
+#define PROTOTYPE_BENCH_LOG_PRODUCERS  8    // threads logging at the same time
+#define PROTOTYPE_BENCH_BACKGROUND_MS  20.0 // length of one synthetic background job, about a texture decode
+
+static std::vector<PrototypePhysicsQuery>    benchQueries;
+static std::vector<PrototypePhysicsQueryHit> benchHits;
+static u64                                   benchRayHits = 0;
+static std::vector<PrototypeObject*>         benchTransforms;
+static std::vector<glm::vec3>                benchTranslations;
+static bool                                  benchBulk  = false;
+static u32                                   benchFrame = 0;
+static bool                                  benchHierarchyMove  = false;
+static u32                                   benchHierarchyFrame = 0;
+static std::vector<PrototypeObject*>         benchHierarchyRoots;
+static std::vector<PrototypeObject*>         benchSpawned;
+static std::vector<glm::vec3>                benchSpawnPositions;
+static f64                                   benchSpawnColdMs   = 0.0; // first batch, every object gets created
+static f64                                   benchSpawnPooledMs = 0.0; // every later batch, objects come from the pool
+static u64                                   benchSpawnBatches  = 0;
+// streamed layers declared by generate, the focus sweeps over them every PROTOTYPE_BENCH_STREAMING_LAP frames
+static u32 benchStreamingLayers = 0;
+static u32 benchStreamingFrame  = 0;
+// physics statistics summed over every frame, warmup included
+static u64 benchActiveBodies     = 0;
+static u64 benchContactPairs     = 0;
+static u64 benchTouchingPairs    = 0;
+static u64 benchStatisticsFrames = 0;
+// read back after every maths round so the compiler can't drop the glm loops
+static volatile f32 benchMathsSink = 0.0f;
+// synthetic loader jobs keeping the threadpool busy at low priority while the frames run
+static std::atomic<bool> benchBackgroundStop(false);
+static std::atomic<u32>  benchBackgroundJobs(0);
+static std::atomic<u64>  benchBackgroundDone(0);
+static volatile f64      benchBackgroundSink = 0.0;
+
+static const char* percentileNames[] = { "p50", "p95", "p99" };
+static const f64   percentiles[]     = { 0.50, 0.95, 0.99 };
+
+static u64
+peakResidentBytes()
+{
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) { return (u64)counters.PeakWorkingSetSize; }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+#if defined(PROTOTYPE_PLATFORM_DARWIN)
+    return (u64)usage.ru_maxrss; // bytes
+#else
+    return (u64)usage.ru_maxrss * 1024; // kilobytes
+#endif
+#endif
+}
+
+static nlohmann::json
+summarize(std::vector<f32>& samples)
+{
+    nlohmann::json j;
+    if (samples.empty()) { return j; }
+    std::sort(samples.begin(), samples.end());
+    f64 sum = 0.0;
+    for (f32 sample : samples) { sum += sample; }
+    j["mean"] = sum / (f64)samples.size();
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+        // nearest rank
+        size_t rank           = (size_t)std::ceil(percentiles[i] * (f64)samples.size());
+        j[percentileNames[i]] = samples[rank > 0 ? rank - 1 : 0];
+    }
+    j["max"] = samples.back();
+    return j;
+}
+
+// averages PROTOTYPE_BENCH_MATHS_ROUNDS runs of fn in milliseconds
+template<typename Fn>
+static f64
+measureMaths(const Fn& fn, const std::vector<glm::mat4>& results)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (u32 round = 0; round < PROTOTYPE_BENCH_MATHS_ROUNDS; ++round) {
+        fn();
+        benchMathsSink = benchMathsSink + results[round % results.size()][3][0];
+    }
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count() /
+           (f64)PROTOTYPE_BENCH_MATHS_ROUNDS;
+}
+
+static nlohmann::json
+summarizeMaths(f64 glmMs, f64 batchedMs)
+{
+    nlohmann::json j;
+    j["glmMs"]     = glmMs;
+    j["batchedMs"] = batchedMs;
+    j["speedup"]   = batchedMs > 0.0 ? glmMs / batchedMs : 0.0;
+    return j;
+}
+
+// averages PROTOTYPE_BENCH_PARSE_ROUNDS parses of the scene text in milliseconds, the full json parse stages its layers
+// the way PrototypeScene::from_json does so both sides end up with the same staged nodes
+static nlohmann::json
+measureParse(const std::string& text)
+{
+    f64    domMs      = 0.0;
+    f64    onDemandMs = 0.0;
+    size_t nodes      = 0;
+    for (u32 round = 0; round < PROTOTYPE_BENCH_PARSE_ROUNDS; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        {
+            const nlohmann::json                   j = nlohmann::json::parse(text, nullptr, false);
+            std::vector<PrototypeSceneParsedLayer> layers;
+            if (!j.is_discarded() && j.contains("layers")) {
+                for (const auto& jlayer : j.at("layers")) {
+                    if (jlayer.is_null()) continue;
+                    layers.emplace_back();
+                    PrototypeSceneParser::stageLayer(jlayer, layers.back());
+                }
+            }
+        }
+        const auto middle = std::chrono::steady_clock::now();
+        {
+            nlohmann::json                         j;
+            std::vector<PrototypeSceneParsedLayer> layers;
+            PrototypeSceneParser::parseScene(text, j, layers);
+            nodes = 0;
+            for (const auto& layer : layers) { nodes += layer.nodes.size(); }
+        }
+        const auto end = std::chrono::steady_clock::now();
+        domMs      += std::chrono::duration<f64, std::milli>(middle - start).count();
+        onDemandMs += std::chrono::duration<f64, std::milli>(end - middle).count();
+    }
+    nlohmann::json j;
+    j["domMs"]      = domMs / (f64)PROTOTYPE_BENCH_PARSE_ROUNDS;
+    j["onDemandMs"] = onDemandMs / (f64)PROTOTYPE_BENCH_PARSE_ROUNDS;
+    j["speedup"]    = onDemandMs > 0.0 ? domMs / onDemandMs : 0.0;
+    j["nodes"]      = nodes;
+    j["bytes"]      = text.size();
+    return j;
+}
+
+// times the scene parser against a full json parse on every shipped scene and on a generated scene of count nodes
+static nlohmann::json
+benchParse(u32 count)
+{
+    nlohmann::json  parse;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(PROTOTYPE_SCENE_PATH(""), error)) {
+        if (entry.path().extension() != ".json") continue;
+        std::string text;
+        if (!PrototypeIo::readFileBlock(entry.path().string().c_str(), text)) continue;
+        // the settings, resources and schemas live next to the scenes
+        const nlohmann::json j = nlohmann::json::parse(text, nullptr, false);
+        if (j.is_discarded() || !j.is_object() || !j.contains("layers") || !j.contains("filters")) continue;
+        parse["scenes"][entry.path().stem().string()] = measureParse(text);
+    }
+
+    // every root node gets PROTOTYPE_BENCH_PARSE_CHILDREN children, the way props hang off their parent objects
+    const glm::vec3 zero(0.0f, 0.0f, 0.0f);
+    nlohmann::json  jlayers = nlohmann::json::array();
+    for (u32 l = 0; l < PROTOTYPE_BENCH_PARSE_LAYERS; ++l) {
+        nlohmann::json jlayer;
+        jlayer["name"]  = "Bench Parse " + std::to_string(l);
+        jlayer["nodes"] = nlohmann::json::array();
+        jlayers.push_back(jlayer);
+    }
+    nlohmann::json* root = nullptr;
+    for (u32 i = 0; i < count; ++i) {
+        nlohmann::json jtransform;
+        jtransform["name"]     = "Transform";
+        jtransform["position"] = glm::vec3((f32)(i % 1000), 0.0f, (f32)(i / 1000));
+        jtransform["rotation"] = zero;
+        jtransform["scale"]    = glm::vec3(1.0f, 1.0f, 1.0f);
+        nlohmann::json jmesh;
+        jmesh["mesh"]     = "CUBE";
+        jmesh["material"] = PROTOTYPE_DEFAULT_MATERIAL;
+        nlohmann::json jmeshRenderer;
+        jmeshRenderer["name"] = "MeshRenderer";
+        jmeshRenderer["data"] = nlohmann::json::array({ jmesh });
+        nlohmann::json jnode;
+        jnode["name"]       = "Bench Parse Node " + std::to_string(i);
+        jnode["components"] = nlohmann::json::array({ jtransform, jmeshRenderer });
+        jnode["nodes"]      = nlohmann::json::array();
+        if (i % (PROTOTYPE_BENCH_PARSE_CHILDREN + 1) != 0 && root) {
+            (*root)["nodes"].push_back(jnode);
+            continue;
+        }
+        nlohmann::json& jnodes = jlayers[(i / (PROTOTYPE_BENCH_PARSE_CHILDREN + 1)) % PROTOTYPE_BENCH_PARSE_LAYERS]["nodes"];
+        jnodes.push_back(jnode);
+        root = &jnodes.back();
+    }
+    nlohmann::json jscene;
+    jscene["name"]    = "Bench Parse";
+    jscene["filters"] = nlohmann::json::array();
+    jscene["bundles"] = nlohmann::json::array();
+    jscene["layers"]  = jlayers;
+
+    parse["generated"] = measureParse(jscene.dump());
+    parse["count"]     = count;
+    return parse;
+}
+
+// burns a core for PROTOTYPE_BENCH_BACKGROUND_MS then queues the next job, the way a loader works through its assets
+static void
+benchBackgroundJob()
+{
+    const auto start = std::chrono::steady_clock::now();
+    while (std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count() <
+           PROTOTYPE_BENCH_BACKGROUND_MS) {
+        benchBackgroundSink = benchBackgroundSink + 1.0;
+    }
+    benchBackgroundDone.fetch_add(1, std::memory_order_relaxed);
+    if (benchBackgroundStop.load(std::memory_order_acquire)) {
+        benchBackgroundJobs.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+    PrototypeEngineInternalApplication::threadpool->submit(benchBackgroundJob, PrototypeThreadpoolPriority_Low);
+}
+
+// nanoseconds per trace call of PROTOTYPE_BENCH_LOG_PRODUCERS threads logging count messages each at the same time
+// every measurement starts fresh threads, so their rings come from the threads of the previous one
+static f64
+measureLogging(u32 count, PrototypeLoggerOverflowPolicy_ policy, u64& dropped)
+{
+    PrototypeLoggerData* data          = PrototypeLogger::data();
+    const u64            droppedBefore = data->droppedCount.load(std::memory_order_relaxed);
+    std::atomic<u64>     elapsedNs(0);
+    PrototypeLogger::setOverflowPolicy(policy);
+    std::vector<std::thread> producers;
+    for (u32 p = 0; p < PROTOTYPE_BENCH_LOG_PRODUCERS; ++p) {
+        producers.emplace_back([count, p, &elapsedNs]() {
+            const auto start = std::chrono::steady_clock::now();
+            for (u32 i = 0; i < count; ++i) {
+                PrototypeLogger::trace("Bench producer %u message %u value %f", p, i, (f64)i * 0.5);
+            }
+            const auto end = std::chrono::steady_clock::now();
+            elapsedNs.fetch_add((u64)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        });
+    }
+    for (auto& producer : producers) { producer.join(); }
+    PrototypeLogger::flush();
+    dropped = data->droppedCount.load(std::memory_order_relaxed) - droppedBefore;
+    return (f64)elapsedNs.load() / ((f64)count * PROTOTYPE_BENCH_LOG_PRODUCERS);
+}
+
+// times the logger producers with both overflow policies, the sinks are off meanwhile so the worker only decodes
+static nlohmann::json
+benchLogging(u32 count)
+{
+    nlohmann::json       logging;
+    PrototypeLoggerData* data = PrototypeLogger::data();
+    if (!data) { return logging; }
+    PrototypeLogger::flush();
+    const i32 level  = data->level.load(std::memory_order_relaxed);
+    const i32 policy = data->overflowPolicy.load(std::memory_order_relaxed);
+    const u32 sinks  = data->sinks.load(std::memory_order_relaxed);
+    PrototypeLogger::setLevel(PrototypeLoggerLevel_Trace);
+    PrototypeLogger::setSinks(0);
+
+    u64 dropped = 0;
+
+    logging["dropNsPerCall"]  = measureLogging(count, PrototypeLoggerOverflowPolicy_Drop, dropped);
+    logging["dropped"]        = dropped;
+    logging["blockNsPerCall"] = measureLogging(count, PrototypeLoggerOverflowPolicy_Block, dropped);
+    logging["producers"]      = PROTOTYPE_BENCH_LOG_PRODUCERS;
+    logging["count"]          = count;
+
+    PrototypeLogger::setSinks(sinks);
+    PrototypeLogger::setOverflowPolicy((PrototypeLoggerOverflowPolicy_)policy);
+    PrototypeLogger::setLevel((PrototypeLoggerLevel_)level);
+    return logging;
+}
+
+// times the batched PrototypeMaths kernels against the glm calls they replace, on the same count transforms
+static nlohmann::json
+benchMaths(u32 count)
+{
+    u32  state  = PROTOTYPE_BENCH_RAYS_SEED;
+    auto random = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return (f32)(state >> 8) / (f32)(1u << 24);
+    };
+    std::vector<glm::vec3> positions(count);
+    std::vector<glm::vec3> rotations(count);
+    std::vector<glm::vec3> scales(count);
+    std::vector<glm::quat> orientations(count);
+    std::vector<glm::mat4> models(count);
+    std::vector<glm::mat4> results(count);
+    for (u32 i = 0; i < count; ++i) {
+        positions[i] = glm::vec3(random(), random(), random()) * 100.0f;
+        rotations[i] = glm::vec3(random(), random(), random()) * 360.0f;
+        scales[i]    = glm::vec3(random(), random(), random()) + 0.5f;
+    }
+
+    nlohmann::json maths;
+    // the batched path converts the euler angles as well, like the transforms do before composing
+    const f64 glmCompose = measureMaths(
+      [&]() {
+          for (u32 i = 0; i < count; ++i) {
+              PrototypeMaths::buildModelMatrix(results[i], positions[i], rotations[i]);
+              PrototypeMaths::buildModelMatrixWithScale(results[i], scales[i]);
+          }
+      },
+      results);
+    const f64 batchedCompose = measureMaths(
+      [&]() {
+          for (u32 i = 0; i < count; ++i) { PrototypeMaths::buildModelOrientation(orientations[i], rotations[i]); }
+          PrototypeMaths::composeModelMatrices(results.data(), positions.data(), orientations.data(), scales.data(), count);
+      },
+      results);
+    maths["compose"] = summarizeMaths(glmCompose, batchedCompose);
+    models           = results;
+
+    const f64 glmMultiply = measureMaths(
+      [&]() {
+          for (u32 i = 0; i < count; ++i) { results[i] = models[i] * models[count - 1 - i]; }
+      },
+      results);
+    std::vector<glm::mat4> reversed(models.rbegin(), models.rend());
+    const f64              batchedMultiply =
+      measureMaths([&]() { PrototypeMaths::multiplyMatrices(results.data(), models.data(), reversed.data(), count); }, results);
+    maths["multiply"] = summarizeMaths(glmMultiply, batchedMultiply);
+
+    const f64 glmInvert = measureMaths(
+      [&]() {
+          for (u32 i = 0; i < count; ++i) { results[i] = glm::inverse(models[i]); }
+      },
+      results);
+    const f64 batchedInvert =
+      measureMaths([&]() { PrototypeMaths::invertAffineMatrices(results.data(), models.data(), count); }, results);
+    maths["invert"] = summarizeMaths(glmInvert, batchedInvert);
+    maths["count"]  = count;
+    return maths;
+}
+
+bool
+PrototypeBench::parseArguments(int argc, char const* argv[], PrototypeBenchOptions& options)
+{
+    options.sceneName      = "";
+    options.physicsApi     = "";
+    options.frames         = 1000;
+    options.warmup         = 60;
+    options.plugins        = false;
+    options.lockstep       = false;
+    options.cubes          = 0;
+    options.cubesLayer     = "";
+    options.vehicles       = 0;
+    options.hierarchyDepth = 0;
+    options.hierarchyWidth = 0;
+    options.hierarchyMove  = false;
+    options.rays           = 0;
+    options.transforms     = 0;
+    options.bulk           = false;
+    options.spawn          = 0;
+    options.maths          = 0;
+    options.streaming      = 0;
+    options.parse          = 0;
+    options.logging        = 0;
+    options.background     = 0;
+    options.output         = "";
+    options.baseline       = "";
+    options.threshold      = 0.1f;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg     = argv[i];
+        const char* value   = i + 1 < argc ? argv[i + 1] : nullptr;
+        bool        hasNext = value != nullptr;
+        if (strcmp(arg, "--plugins") == 0) {
+            options.plugins = true;
+            continue;
+        }
+        if (strcmp(arg, "--lockstep") == 0) {
+            options.lockstep = true;
+            continue;
+        }
+        if (strcmp(arg, "--hierarchy-move") == 0) {
+            options.hierarchyMove = true;
+            continue;
+        }
+        if (strcmp(arg, "--bulk") == 0) {
+            options.bulk = true;
+            continue;
+        }
+        if (strcmp(arg, "--help") == 0) { return false; }
+        if (!hasNext) {
+            PrototypeLogger::error("Missing value for argument %s", arg);
+            return false;
+        }
+        if (strcmp(arg, "--scene") == 0) {
+            options.sceneName = value;
+        } else if (strcmp(arg, "--physics") == 0) {
+            options.physicsApi = value;
+            if (options.physicsApi != "PHYSX" && options.physicsApi != "BULLET") {
+                PrototypeLogger::error("Unknown physics api %s", value);
+                return false;
+            }
+        } else if (strcmp(arg, "--frames") == 0) {
+            options.frames = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--warmup") == 0) {
+            options.warmup = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--cubes") == 0) {
+            options.cubes = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--layer") == 0) {
+            options.cubesLayer = value;
+        } else if (strcmp(arg, "--vehicles") == 0) {
+            options.vehicles = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--hierarchy-depth") == 0) {
+            options.hierarchyDepth = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--hierarchy-width") == 0) {
+            options.hierarchyWidth = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--rays") == 0) {
+            options.rays = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--transforms") == 0) {
+            options.transforms = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--spawn") == 0) {
+            options.spawn = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--maths") == 0) {
+            options.maths = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--streaming") == 0) {
+            options.streaming = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--parse") == 0) {
+            options.parse = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--logging") == 0) {
+            options.logging = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--background") == 0) {
+            options.background = (u32)std::stoul(value);
+        } else if (strcmp(arg, "--output") == 0) {
+            options.output = value;
+        } else if (strcmp(arg, "--baseline") == 0) {
+            options.baseline = value;
+        } else if (strcmp(arg, "--threshold") == 0) {
+            options.threshold = std::stof(value);
+        } else {
+            PrototypeLogger::error("Unknown argument %s", arg);
+            return false;
+        }
+        ++i;
+    }
+    if (options.frames == 0) {
+        PrototypeLogger::error("--frames must be greater than 0");
+        return false;
+    }
+    return true;
+}
+
+void
+PrototypeBench::printUsage()
+{
+    printf("usage: PrototypeBench [options]\n"
+           "  --scene <name>            scene to load, defaults to the settings default scene\n"
+           "  --physics <PHYSX|BULLET>  physics backend, defaults to the settings default physics api\n"
+           "  --frames <n>              measured frames (1000)\n"
+           "  --warmup <n>              frames run before measuring (60)\n"
+           "  --plugins                 load the plugins found in the plugins folder\n"
+           "  --lockstep                one fixed physics step per frame, runs of the same options end on the same hashes\n"
+           "  --cubes <n>               spawn n rigidbody cubes\n"
+           "  --layer <name>            collision layer of the spawned cubes, defaults to the first settings layer\n"
+           "  --vehicles <n>            spawn n vehicles\n"
+           "  --hierarchy-depth <n>     add a chain of n nested scene nodes\n"
+           "  --hierarchy-width <n>     add a scene node with n children\n"
+           "  --hierarchy-move          move the roots of the --hierarchy-depth and --hierarchy-width nodes every frame\n"
+           "  --rays <n>                cast n rays every frame as one batched scene query\n"
+           "  --transforms <n>          spawn n transform only objects and move them every frame\n"
+           "  --bulk                    move the --transforms objects with the bulk calls instead of one object at a time\n"
+           "  --spawn <n>               release and spawn n pooled rigidbody cubes every frame\n"
+           "  --maths <n>               time the batched matrix kernels against glm on n matrices after the run\n"
+           "  --streaming <n>           sweep the streaming focus over n streamed layers of 256 cubes each\n"
+           "  --parse <n>               time the scene parser against a full json parse on the shipped scenes and n nodes\n"
+           "  --logging <n>             time n log calls on each of 8 threads logging at the same time after the run\n"
+           "  --background <n>          keep n low priority loader like jobs running on the threadpool during the run\n"
+           "  --output <file>           write the json report there instead of stdout\n"
+           "  --baseline <file>         compare against a previous report, exits with 1 on regressions\n"
+           "  --threshold <ratio>       allowed relative slowdown before flagging a regression (0.1)\n");
+}
+
+void
+PrototypeBench::generate(const PrototypeBenchOptions& options)
+{
+    const glm::vec3 zero = { 0.0f, 0.0f, 0.0f };
+
+    // the physics scene only exists after the first record pass, the spawned rigidbodies need it
+    PrototypeEngineInternalApplication::physics->beginRecordPass();
+    PrototypeEngineInternalApplication::physics->endRecordPass();
+
+    std::optional<u32> cubesLayer;
+    if (!options.cubesLayer.empty()) {
+        cubesLayer = PrototypeEngineInternalApplication::scene->collisionLayers().layerByName(options.cubesLayer);
+        if (!cubesLayer.has_value()) { PrototypeLogger::warn("Unknown collision layer %s", options.cubesLayer.c_str()); }
+    }
+
+    // stacked grids of PROTOTYPE_BENCH_GRID_ROW x PROTOTYPE_BENCH_GRID_ROW cubes
+    for (u32 i = 0; i < options.cubes; ++i) {
+        const u32       column   = i % PROTOTYPE_BENCH_GRID_ROW;
+        const u32       row      = (i / PROTOTYPE_BENCH_GRID_ROW) % PROTOTYPE_BENCH_GRID_ROW;
+        const u32       level    = i / (PROTOTYPE_BENCH_GRID_ROW * PROTOTYPE_BENCH_GRID_ROW);
+        const glm::vec3 position = { (f32)column * PROTOTYPE_BENCH_GRID_SPACING,
+                                     10.0f + (f32)level * 2.0f,
+                                     (f32)row * PROTOTYPE_BENCH_GRID_SPACING };
+        PrototypeObject* cube = shortcutSpawnCube(position, zero, zero);
+        if (cube && cubesLayer.has_value()) {
+            cube->getColliderTrait()->setLayer(cubesLayer.value());
+            PrototypeEngineInternalApplication::physics->updateColliderLayer(cube);
+        }
+    }
+
+    for (u32 i = 0; i < options.vehicles; ++i) {
+        const glm::vec3 position = { (f32)(i % PROTOTYPE_BENCH_GRID_ROW) * PROTOTYPE_BENCH_GRID_SPACING * 3.0f,
+                                     2.0f,
+                                     -(f32)(i / PROTOTYPE_BENCH_GRID_ROW) * PROTOTYPE_BENCH_GRID_SPACING * 3.0f - 10.0f };
+        shortcutSpawnVehicle(position, zero, zero, "CUBE", PROTOTYPE_DEFAULT_MATERIAL);
+    }
+
+    if (options.hierarchyDepth > 0) {
+        auto             defaultLayer = PrototypeEngineInternalApplication::scene->layers().begin()->second;
+        const MASK_TYPE  traitMask    = PrototypeTraitTypeMaskTransform | PrototypeTraitTypeMaskMeshRenderer;
+        const glm::vec3  offset       = { 0.0f, 1.0f, 0.0f };
+        const glm::vec3  scale        = { 0.5f, 0.5f, 0.5f };
+        PrototypeObject* object       = shotcutCreateCloneObjectToLayer("Bench Hierarchy 0", traitMask, defaultLayer);
+        if (object) { benchHierarchyRoots.push_back(object); }
+        for (u32 depth = 1; object != nullptr; ++depth) {
+            shortcutSetupObjectTransformTrait(object, offset, zero, scale);
+            shortcutSetupObjectMeshRendererTrait(object, "CUBE", PROTOTYPE_DEFAULT_MATERIAL);
+            if (depth == options.hierarchyDepth) { break; }
+            PrototypeSceneNode* node = static_cast<PrototypeSceneNode*>(object->parentNode());
+            object = shotcutCreateCloneObjectToNode("Bench Hierarchy " + std::to_string(depth), traitMask, node);
+        }
+        PrototypeEngineInternalApplication::renderer->scheduleRecordPass();
+    }
+
+    if (options.hierarchyWidth > 0) {
+        auto             defaultLayer = PrototypeEngineInternalApplication::scene->layers().begin()->second;
+        const MASK_TYPE  traitMask    = PrototypeTraitTypeMaskTransform | PrototypeTraitTypeMaskMeshRenderer;
+        const glm::vec3  position     = { 0.0f, 5.0f, -20.0f };
+        const glm::vec3  scale        = { 0.25f, 0.25f, 0.25f };
+        PrototypeObject* root         = shotcutCreateCloneObjectToLayer("Bench Wide Hierarchy", traitMask, defaultLayer);
+        if (root) {
+            shortcutSetupObjectTransformTrait(root, position, zero, { 1.0f, 1.0f, 1.0f });
+            shortcutSetupObjectMeshRendererTrait(root, "CUBE", PROTOTYPE_DEFAULT_MATERIAL);
+            benchHierarchyRoots.push_back(root);
+            PrototypeSceneNode* node = static_cast<PrototypeSceneNode*>(root->parentNode());
+            for (u32 i = 0; i < options.hierarchyWidth; ++i) {
+                const u32         column = i % PROTOTYPE_BENCH_GRID_ROW;
+                const u32         row    = (i / PROTOTYPE_BENCH_GRID_ROW) % PROTOTYPE_BENCH_GRID_ROW;
+                const u32         level  = i / (PROTOTYPE_BENCH_GRID_ROW * PROTOTYPE_BENCH_GRID_ROW);
+                const glm::vec3   offset = { (f32)column, (f32)level, (f32)row };
+                const std::string name   = "Bench Wide Child " + std::to_string(i);
+                PrototypeObject*  child  = shotcutCreateCloneObjectToNode(name, traitMask, node);
+                if (!child) { continue; }
+                shortcutSetupObjectTransformTrait(child, offset, zero, scale);
+                shortcutSetupObjectMeshRendererTrait(child, "CUBE", PROTOTYPE_DEFAULT_MATERIAL);
+            }
+        }
+        PrototypeEngineInternalApplication::renderer->scheduleRecordPass();
+    }
+    benchHierarchyMove = options.hierarchyMove;
+
+    if (options.transforms > 0) {
+        auto            defaultLayer = PrototypeEngineInternalApplication::scene->layers().begin()->second;
+        const glm::vec3 scale        = { 0.5f, 0.5f, 0.5f };
+        benchTransforms.reserve(options.transforms);
+        for (u32 i = 0; i < options.transforms; ++i) {
+            const u32         column   = i % PROTOTYPE_BENCH_GRID_ROW;
+            const u32         row      = (i / PROTOTYPE_BENCH_GRID_ROW) % PROTOTYPE_BENCH_GRID_ROW;
+            const u32         level    = i / (PROTOTYPE_BENCH_GRID_ROW * PROTOTYPE_BENCH_GRID_ROW);
+            const glm::vec3   position = { (f32)column * PROTOTYPE_BENCH_GRID_SPACING,
+                                           20.0f + (f32)level * 2.0f,
+                                           (f32)row * PROTOTYPE_BENCH_GRID_SPACING };
+            const std::string name     = "Bench Transform " + std::to_string(i);
+            PrototypeObject*  object   = shotcutCreateCloneObjectToLayer(name, PrototypeTraitTypeMaskTransform, defaultLayer);
+            if (!object) { continue; }
+            shortcutSetupObjectTransformTrait(object, position, zero, scale);
+            benchTransforms.push_back(object);
+        }
+        benchTranslations.resize(benchTransforms.size());
+        benchBulk = options.bulk;
+    }
+
+    if (options.spawn > 0) {
+        benchSpawned.resize(options.spawn, nullptr);
+        benchSpawnPositions.resize(options.spawn);
+        for (u32 i = 0; i < options.spawn; ++i) {
+            const u32 column       = i % PROTOTYPE_BENCH_GRID_ROW;
+            const u32 row          = (i / PROTOTYPE_BENCH_GRID_ROW) % PROTOTYPE_BENCH_GRID_ROW;
+            const u32 level        = i / (PROTOTYPE_BENCH_GRID_ROW * PROTOTYPE_BENCH_GRID_ROW);
+            benchSpawnPositions[i] = { -(f32)column * PROTOTYPE_BENCH_GRID_SPACING - 10.0f,
+                                       30.0f + (f32)level * 2.0f,
+                                       (f32)row * PROTOTYPE_BENCH_GRID_SPACING };
+        }
+    }
+
+    if (options.streaming > 0) {
+        // one file per layer, the layers line up along the x axis far enough apart for only a few to be loaded at once
+        const std::filesystem::path folder = std::filesystem::temp_directory_path() / "PrototypeBenchStreaming";
+        std::error_code             error;
+        std::filesystem::create_directories(folder, error);
+        PrototypeScene* scene = PrototypeEngineInternalApplication::scene;
+        for (u32 l = 0; l < options.streaming; ++l) {
+            const std::string layerName = "Bench Streaming " + std::to_string(l);
+            const glm::vec3   center    = { (f32)l * PROTOTYPE_BENCH_STREAMING_GAP, 0.0f, 100.0f };
+            nlohmann::json    jnodes    = nlohmann::json::array();
+            for (u32 i = 0; i < PROTOTYPE_BENCH_STREAMING_ROW * PROTOTYPE_BENCH_STREAMING_ROW; ++i) {
+                const glm::vec3 offset = { (f32)(i % PROTOTYPE_BENCH_STREAMING_ROW) * 2.0f,
+                                           1.0f,
+                                           (f32)(i / PROTOTYPE_BENCH_STREAMING_ROW) * 2.0f };
+                nlohmann::json  jtransform;
+                jtransform["name"]     = "Transform";
+                jtransform["position"] = center + offset;
+                jtransform["rotation"] = zero;
+                jtransform["scale"]    = glm::vec3(0.5f, 0.5f, 0.5f);
+                nlohmann::json jmesh;
+                jmesh["mesh"]     = "CUBE";
+                jmesh["material"] = PROTOTYPE_DEFAULT_MATERIAL;
+                nlohmann::json jmeshRenderer;
+                jmeshRenderer["name"] = "MeshRenderer";
+                jmeshRenderer["data"] = nlohmann::json::array({ jmesh });
+                nlohmann::json jnode;
+                jnode["name"]       = layerName + " Node " + std::to_string(i);
+                jnode["components"] = nlohmann::json::array({ jtransform, jmeshRenderer });
+                jnodes.push_back(jnode);
+            }
+            const std::string filepath = (folder / (std::to_string(l) + ".json")).string();
+            nlohmann::json    jlayer;
+            jlayer["nodes"] = jnodes;
+            std::ofstream file(filepath);
+            file << jlayer.dump();
+            file.close();
+
+            auto layer = PrototypeEngineInternalApplication::database->allocateSceneLayer(layerName);
+            layer->setParentScene(scene);
+            if (!scene->addLayer(layer)) {
+                PrototypeEngineInternalApplication::database->deallocateSceneLayer(layer);
+                continue;
+            }
+            PrototypeEngineInternalApplication::database->sceneLayers[scene].insert({ layer->name(), layer });
+            PrototypeEngineInternalApplication::sceneStreamer->declare(
+              scene, layer, filepath, center, PROTOTYPE_BENCH_STREAMING_GAP * 0.75f, 0);
+        }
+        benchStreamingLayers = options.streaming;
+    }
+
+    // physics has to keep its step times while the workers are busy loading
+    for (u32 i = 0; i < options.background; ++i) {
+        benchBackgroundJobs.fetch_add(1, std::memory_order_relaxed);
+        PrototypeEngineInternalApplication::threadpool->submit(benchBackgroundJob, PrototypeThreadpoolPriority_Low);
+    }
+
+    if (options.rays > 0) {
+        // rays start inside the bounds of the scene objects and point downwards in random directions,
+        // the same ones are cast every frame so runs of the same scene are comparable
+        glm::vec3   boundsMin(-50.0f);
+        glm::vec3   boundsMax(50.0f);
+        const auto& transformObjects =
+          PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(PrototypeTraitTypeMaskTransform);
+        if (!transformObjects.empty()) {
+            boundsMin = glm::vec3(std::numeric_limits<f32>::max());
+            boundsMax = glm::vec3(std::numeric_limits<f32>::lowest());
+            for (PrototypeObject* object : transformObjects) {
+                const glm::vec3& position = object->getTransformTrait()->position();
+                boundsMin                 = glm::min(boundsMin, position);
+                boundsMax                 = glm::max(boundsMax, position);
+            }
+        }
+        const glm::vec3 extent = glm::max(boundsMax - boundsMin, glm::vec3(1.0f));
+        const f32       length = glm::length(extent) * 2.0f;
+
+        u32  state  = PROTOTYPE_BENCH_RAYS_SEED;
+        auto random = [&state]() {
+            state = state * 1664525u + 1013904223u;
+            return (f32)(state >> 8) / (f32)(1u << 24);
+        };
+        benchQueries.resize(options.rays);
+        benchHits.resize(options.rays);
+        for (PrototypePhysicsQuery& query : benchQueries) {
+            query.type       = PrototypePhysicsQueryType_Ray;
+            query.filterMask = PrototypePhysicsQueryFilter_All;
+            query.layerMask  = 0;
+            query.origin     = boundsMin + glm::vec3(random(), random(), random()) * extent;
+            query.origin.y   = boundsMax.y + 1.0f;
+            query.direction  = { random() * 2.0f - 1.0f, -1.0f, random() * 2.0f - 1.0f };
+            query.length     = length;
+            query.radius     = 0.0f;
+        }
+    }
+}
+
+void PROTOTYPE_DYNAMIC_FN_CALL
+PrototypeBench::update()
+{
+    PrototypePhysicsStatistics statistics;
+    PrototypeEngineInternalApplication::physics->fetchStatistics(statistics);
+    benchActiveBodies += statistics.activeBodies;
+    benchContactPairs += statistics.contactPairs;
+    benchTouchingPairs += statistics.touchingPairs;
+    ++benchStatisticsFrames;
+
+    if (!benchTransforms.empty()) {
+        // bobs every object up and down, the same moves either way so both runs end in the same state
+        const glm::vec3 offset = { 0.0f, std::sin((f32)benchFrame++ * 0.1f) * 0.05f, 0.0f };
+        if (benchBulk) {
+            PrototypeBulk::getTranslations(benchTransforms.data(), benchTransforms.size(), benchTranslations.data(), 0);
+            for (glm::vec3& translation : benchTranslations) { translation += offset; }
+            PrototypeBulk::setTranslations(benchTransforms.data(), benchTransforms.size(), benchTranslations.data(), 0);
+        } else {
+            // what a plugin calling TransformTraitGetTranslation and TransformTraitSetTranslation per object goes through
+            for (PrototypeObject* object : benchTransforms) {
+                Transform* transform     = object->getTransformTrait();
+                transform->positionMut() = transform->position() + offset;
+                transform->updateMatrixFromComponents();
+                if (object->hasColliderTrait()) { transform->setNeedsPhysicsSync(true); }
+            }
+        }
+    }
+
+    if (benchHierarchyMove) {
+        // only the roots change, every node under them gets its world matrix from the transform hierarchy
+        const glm::vec3 offset = { std::cos((f32)benchHierarchyFrame++ * 0.1f) * 0.05f, 0.0f, 0.0f };
+        for (PrototypeObject* root : benchHierarchyRoots) {
+            Transform* transform     = root->getTransformTrait();
+            transform->positionMut() = transform->position() + offset;
+            transform->updateMatrixFromComponents();
+        }
+    }
+
+    if (benchStreamingLayers > 0) {
+        // back and forth over the layers, they get loaded in front of the focus and unloaded behind it
+        const f32 lap    = (f32)(benchStreamingFrame++ % PROTOTYPE_BENCH_STREAMING_LAP) / (f32)PROTOTYPE_BENCH_STREAMING_LAP;
+        const f32 extent = (f32)(benchStreamingLayers - 1) * PROTOTYPE_BENCH_STREAMING_GAP;
+        const f32 x      = (1.0f - std::abs(lap * 2.0f - 1.0f)) * extent;
+        PrototypeEngineInternalApplication::sceneStreamer->setFocus({ x, 0.0f, 100.0f });
+    }
+
+    if (!benchSpawned.empty()) {
+        // projectile like churn, last frame batch goes back to the pool and comes out again at the spawn points
+        PrototypeSpawnArchetype archetype = {};
+        archetype.shape                   = PrototypeSpawnShape_Cube;
+        archetype.layer                   = 0;
+        const auto start                  = std::chrono::steady_clock::now();
+        PrototypeEngineInternalApplication::objectPool->release(benchSpawned.data(), benchSpawned.size());
+        PrototypeEngineInternalApplication::objectPool->spawnBatch(
+          archetype, benchSpawned.size(), benchSpawnPositions.data(), 0, nullptr, 0, nullptr, 0, benchSpawned.data());
+        const f64 ms = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (benchSpawnBatches++ == 0) {
+            benchSpawnColdMs = ms;
+        } else {
+            benchSpawnPooledMs += ms;
+        }
+    }
+
+    if (benchQueries.empty()) { return; }
+    // the previous batch ran at the end of the last physics update
+    for (const PrototypePhysicsQueryHit& hit : benchHits) { benchRayHits += hit.object ? 1 : 0; }
+    PrototypeEngineInternalApplication::physics->submitQueryBatch(benchQueries.data(), benchQueries.size(), benchHits.data());
+}
+
+nlohmann::json
+PrototypeBench::collect(const PrototypeBenchOptions& options)
+{
+    benchBackgroundStop.store(true, std::memory_order_release);
+    while (benchBackgroundJobs.load(std::memory_order_acquire) > 0) { std::this_thread::yield(); }
+
+    const bool     isBullet = PrototypeEngineInternalApplication::physicsApi == PrototypeEngineEPhysicsApi_BULLET;
+    nlohmann::json report;
+    report["scene"]          = PrototypeEngineInternalApplication::scene->name();
+    report["physics"]        = isBullet ? "BULLET" : "PHYSX";
+    report["warmup"]         = options.warmup;
+    report["plugins"]        = options.plugins;
+    report["lockstep"]       = options.lockstep;
+    report["cubes"]          = options.cubes;
+    report["cubesLayer"]     = options.cubesLayer;
+    report["vehicles"]       = options.vehicles;
+    report["hierarchyDepth"] = options.hierarchyDepth;
+    report["hierarchyWidth"] = options.hierarchyWidth;
+    report["hierarchyMove"]  = options.hierarchyMove;
+    report["rays"]           = options.rays;
+    report["transforms"]     = options.transforms;
+    report["bulk"]           = options.bulk;
+    report["spawn"]          = options.spawn;
+    report["streaming"]      = options.streaming;
+    report["background"]     = options.background;
+    report["backgroundJobs"] = benchBackgroundDone.load(); // over every frame, warmup included
+    report["rayHits"]        = benchRayHits;               // over every frame, warmup included
+
+    // per frame averages, the pairs the layer matrix filters out never show up here
+    nlohmann::json& physicsStatistics  = report["physicsStatistics"];
+    const f64       statisticsFrames   = (f64)std::max(benchStatisticsFrames, (u64)1);
+    physicsStatistics["activeBodies"]  = (f64)benchActiveBodies / statisticsFrames;
+    physicsStatistics["contactPairs"]  = (f64)benchContactPairs / statisticsFrames;
+    physicsStatistics["touchingPairs"] = (f64)benchTouchingPairs / statisticsFrames;
+
+    // time spent inside every loaded plugin, warmup included
+    for (const auto& pair : PrototypeEngineInternalApplication::database->pluginInstances) {
+        const PrototypePluginTimings& pluginTimings = pair.second->timings();
+        nlohmann::json&               plugin        = report["pluginTimings"][pair.second->name()];
+        plugin["averageMs"]                         = pluginTimings.averageMs;
+        plugin["peakMs"]                            = pluginTimings.peakMs;
+        plugin["overruns"]                          = pluginTimings.overruns;
+        plugin["throttled"]                         = pluginTimings.throttled;
+    }
+
+    // batches per millisecond, the cold batch creates every object while the pooled ones only reuse them
+    if (options.spawn > 0) {
+        const PrototypeObjectPoolStats poolStats = PrototypeEngineInternalApplication::objectPool->stats();
+        const f64 pooledMs = benchSpawnBatches > 1 ? benchSpawnPooledMs / (f64)(benchSpawnBatches - 1) : 0.0;
+        nlohmann::json& spawn       = report["spawnTimings"];
+        spawn["coldMs"]             = benchSpawnColdMs;
+        spawn["pooledMs"]           = pooledMs;
+        spawn["coldObjectsPerMs"]   = benchSpawnColdMs > 0.0 ? (f64)options.spawn / benchSpawnColdMs : 0.0;
+        spawn["pooledObjectsPerMs"] = pooledMs > 0.0 ? (f64)options.spawn / pooledMs : 0.0;
+        spawn["created"]            = poolStats.created;
+        spawn["reused"]             = poolStats.reused;
+    }
+
+    // layers merged and unloaded over the whole run, warmup included, the time it took is the Streaming stage
+    if (options.streaming > 0) {
+        const PrototypeSceneStreamerStats& streamerStats = PrototypeEngineInternalApplication::sceneStreamer->stats();
+        nlohmann::json&                    streaming     = report["streamingStats"];
+        streaming["loads"]                               = streamerStats.loads;
+        streaming["unloads"]                             = streamerStats.unloads;
+        streaming["evictions"]                           = streamerStats.evictions;
+        streaming["resident"]                            = streamerStats.resident;
+        streaming["bytes"]                               = streamerStats.bytes;
+    }
+
+    // milliseconds per call over the whole array
+    if (options.maths > 0) { report["mathsTimings"] = benchMaths(options.maths); }
+
+    // milliseconds per parse of the whole text
+    if (options.parse > 0) { report["parseTimings"] = benchParse(options.parse); }
+
+    // nanoseconds per log call on the producer side
+    if (options.logging > 0) { report["loggingTimings"] = benchLogging(options.logging); }
+
+    const auto&  timings = PrototypeEngineInternalApplication::recorder->timings();
+    const size_t first   = std::min((size_t)options.warmup, timings.size());
+    report["frames"]     = timings.size() - first;
+
+    std::vector<f32> samples;
+    samples.reserve(timings.size() - first);
+    for (size_t row = first; row < timings.size(); ++row) { samples.push_back(timings[row][0]); }
+    report["deltaTime"] = summarize(samples);
+    for (u32 stage = 0; stage < PrototypeRecorderStage_Count; ++stage) {
+        samples.clear();
+        for (size_t row = first; row < timings.size(); ++row) { samples.push_back(timings[row][stage + 1]); }
+        report["stages"][PrototypeRecorder::stageName((PrototypeRecorderStage_)stage)] = summarize(samples);
+    }
+
+    nlohmann::json& memory            = report["memory"];
+    memory["peakResidentBytes"]       = peakResidentBytes();
+    memory["frameArenaHighWaterMark"] = PrototypeEngineInternalApplication::frameArena->lastFrameStats().highWaterMark;
+    if (PrototypeMemoryTracker::enabled()) {
+        for (u32 tag = 0; tag < PrototypeMemoryTag_Count; ++tag) {
+            const PrototypeMemoryTagStats stats = PrototypeMemoryTracker::stats((PrototypeMemoryTag_)tag);
+            memory["tags"][PrototypeMemoryTracker::tagName((PrototypeMemoryTag_)tag)] = stats.peakBytes;
+        }
+    }
+
+    char hash[32];
+    snprintf(hash,
+             sizeof(hash),
+             "%016llx",
+             (unsigned long long)PrototypeRecorder::hashScene(PrototypeEngineInternalApplication::scene));
+    report["stateHash"] = hash;
+    snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)PrototypeEngineInternalApplication::physics->stateHash());
+    report["physicsStateHash"] = hash;
+    return report;
+}
+
+bool
+PrototypeBench::compare(const nlohmann::json& report, const nlohmann::json& baseline, f32 threshold)
+{
+    bool passed = true;
+    if (report.value("scene", "") != baseline.value("scene", "") || report.value("cubes", 0) != baseline.value("cubes", 0) ||
+        report.value("vehicles", 0) != baseline.value("vehicles", 0) ||
+        report.value("hierarchyDepth", 0) != baseline.value("hierarchyDepth", 0) ||
+        report.value("hierarchyWidth", 0) != baseline.value("hierarchyWidth", 0) ||
+        report.value("hierarchyMove", false) != baseline.value("hierarchyMove", false) ||
+        report.value("rays", 0) != baseline.value("rays", 0) ||
+        report.value("transforms", 0) != baseline.value("transforms", 0) ||
+        report.value("spawn", 0) != baseline.value("spawn", 0) ||
+        report.value("streaming", 0) != baseline.value("streaming", 0) ||
+        report.value("background", 0) != baseline.value("background", 0) ||
+        report.value("cubesLayer", "") != baseline.value("cubesLayer", "")) {
+        // timings of another workload can't regress against these, don't fail the run over them
+        PrototypeLogger::warn("Baseline was captured with a different scene or generators, skipping the comparison");
+        return true;
+    }
+    if (report.value("bulk", false) != baseline.value("bulk", false)) {
+        PrototypeLogger::trace("Comparing %s transform updates against baseline %s transform updates",
+                               report.value("bulk", false) ? "bulk" : "per object",
+                               baseline.value("bulk", false) ? "bulk" : "per object");
+    }
+    if (report.value("physics", "") != baseline.value("physics", "")) {
+        PrototypeLogger::trace("Comparing physics api %s against baseline physics api %s",
+                               report.value("physics", "").c_str(),
+                               baseline.value("physics", "").c_str());
+    }
+
+    // lockstep runs of the same scenario have to end up in the same state, a different hash is a determinism bug
+    if (report.value("lockstep", false) && baseline.value("lockstep", false) &&
+        report.value("physics", "") == baseline.value("physics", "") &&
+        report.value("frames", 0) + report.value("warmup", 0) == baseline.value("frames", 0) + baseline.value("warmup", 0)) {
+        for (const char* field : { "stateHash", "physicsStateHash" }) {
+            if (report.value(field, "") != baseline.value(field, "")) {
+                PrototypeLogger::error("Lockstep %s %s differs from baseline %s",
+                                       field,
+                                       report.value(field, "").c_str(),
+                                       baseline.value(field, "").c_str());
+                passed = false;
+            }
+        }
+    }
+
+    if (baseline.contains("stages")) {
+        for (const auto& stage : baseline.at("stages").items()) {
+            if (!report["stages"].contains(stage.key())) { continue; }
+            const nlohmann::json& current = report["stages"][stage.key()];
+            for (const char* percentile : percentileNames) {
+                if (!stage.value().contains(percentile) || !current.contains(percentile)) { continue; }
+                const f64 before = stage.value().at(percentile).get<f64>();
+                const f64 after  = current.at(percentile).get<f64>();
+                if (after < PROTOTYPE_BENCH_NOISE_FLOOR_MS) { continue; }
+                if (after > before * (1.0 + threshold)) {
+                    PrototypeLogger::error("Regression in stage %s %s: %.3f ms -> %.3f ms (%+.1f%%)",
+                                           stage.key().c_str(),
+                                           percentile,
+                                           before,
+                                           after,
+                                           before > 0.0 ? (after / before - 1.0) * 100.0 : 100.0);
+                    passed = false;
+                }
+            }
+        }
+    }
+
+    if (baseline.contains("mathsTimings") && report.contains("mathsTimings") &&
+        baseline["mathsTimings"].value("count", 0) == report["mathsTimings"].value("count", 0)) {
+        for (const char* kernel : { "compose", "multiply", "invert" }) {
+            const f64 before = baseline["mathsTimings"][kernel].value("batchedMs", 0.0);
+            const f64 after  = report["mathsTimings"][kernel].value("batchedMs", 0.0);
+            if (after < PROTOTYPE_BENCH_NOISE_FLOOR_MS) { continue; }
+            if (after > before * (1.0 + threshold)) {
+                PrototypeLogger::error("Regression in maths kernel %s: %.3f ms -> %.3f ms", kernel, before, after);
+                passed = false;
+            }
+        }
+    }
+
+    if (baseline.contains("parseTimings") && report.contains("parseTimings") &&
+        baseline["parseTimings"].value("count", 0) == report["parseTimings"].value("count", 0)) {
+        const f64 before = baseline["parseTimings"]["generated"].value("onDemandMs", 0.0);
+        const f64 after  = report["parseTimings"]["generated"].value("onDemandMs", 0.0);
+        if (after >= PROTOTYPE_BENCH_NOISE_FLOOR_MS && after > before * (1.0 + threshold)) {
+            PrototypeLogger::error("Regression in scene parsing: %.3f ms -> %.3f ms", before, after);
+            passed = false;
+        }
+    }
+
+    if (baseline.contains("loggingTimings") && report.contains("loggingTimings") &&
+        baseline["loggingTimings"].value("count", 0) == report["loggingTimings"].value("count", 0)) {
+        const f64 before = baseline["loggingTimings"].value("dropNsPerCall", 0.0);
+        const f64 after  = report["loggingTimings"].value("dropNsPerCall", 0.0);
+        if (after > before * (1.0 + threshold)) {
+            PrototypeLogger::error("Regression in logging: %.1f ns -> %.1f ns per call", before, after);
+            passed = false;
+        }
+    }
+
+    if (baseline.contains("memory")) {
+        for (const char* field : { "peakResidentBytes", "frameArenaHighWaterMark" }) {
+            if (!baseline["memory"].contains(field)) { continue; }
+            const u64 before = baseline["memory"][field].get<u64>();
+            const u64 after  = report["memory"][field].get<u64>();
+            if ((f64)after > (f64)before * (1.0 + threshold)) {
+                PrototypeLogger::error(
+                  "Regression in memory %s: %llu -> %llu bytes", field, (unsigned long long)before, (unsigned long long)after);
+                passed = false;
+            }
+        }
+    }
+    return passed;
+}
@@ -0,0 +1,75 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#pragma once
+
+#include <PrototypeCommon/Definitions.h>
+#include <PrototypeCommon/Types.h>
+
+#include <nlohmann/json.hpp>
+
+#include <string>
+
+struct PrototypeBenchOptions
+{
+    std::string sceneName;      // empty keeps the settings default scene
+    std::string physicsApi;     // PHYSX or BULLET, empty keeps the settings default physics api
+    u32         frames;         // measured frames
+    u32         warmup;         // frames run before measuring, dropped from the report
+    bool        plugins;        // load the plugins the scene scripts link to
+    bool        lockstep;       // one fixed physics step per frame so runs are comparable step for step
+    u32         cubes;          // synthetic rigidbody cubes dropped on the scene
+    std::string cubesLayer;     // collision layer of the synthetic cubes, empty keeps the default layer
+    u32         vehicles;       // synthetic vehicles
+    u32         hierarchyDepth; // length of a synthetic parent/child chain of scene nodes
+    u32         hierarchyWidth; // children of a synthetic flat parent scene node
+    bool        hierarchyMove;  // move the roots of the synthetic hierarchies every frame
+    u32         rays;           // synthetic rays cast every frame as one batched scene query
+    u32         transforms;     // synthetic transform only objects moved every frame
+    bool        bulk;           // move the synthetic transforms with the bulk calls instead of one object at a time
+    u32         spawn;          // synthetic cubes released and spawned again through the object pool every frame
+    u32         maths;          // matrices the batched maths kernels get timed on against glm after the run
+    u32         streaming;      // synthetic streamed layers the streaming focus sweeps over during the run
+    u32         parse;          // generated scene nodes the scene parser gets timed on against a full json parse after the run
+    u32         logging;        // log calls every one of 8 producer threads gets timed on after the run
+    u32         background;     // synthetic low priority jobs kept running on the threadpool, the way the loaders do
+    std::string output;         // report path, empty prints to stdout
+    std::string baseline;       // report to compare against, empty skips the comparison
+    f32         threshold;      // allowed relative slowdown before a stage counts as a regression
+};
+
+// Runs a scene for a fixed amount of frames without showing a window and reports per stage frame timings
+// percentiles, memory high-water marks and the final scene state hash as json.
+struct PrototypeBench
+{
+    PrototypeBench()  = delete;
+    ~PrototypeBench() = delete;
+
+    // returns false and prints the usage on unknown or malformed arguments
+    static bool parseArguments(int argc, char const* argv[], PrototypeBenchOptions& options);
+    static void printUsage();
+
+    // spawns the synthetic content, call between PrototypeEngineInit and PrototypeEngineLoop
+    static void generate(const PrototypeBenchOptions& options);
+
+    // submits the per frame synthetic queries and samples the physics statistics, set it as the application onUpdateFn
+    static void PROTOTYPE_DYNAMIC_FN_CALL update();
+
+    // call between PrototypeEngineLoop and PrototypeEngineDeInit
+    static nlohmann::json collect(const PrototypeBenchOptions& options);
+
+    // logs every stage percentile that got slower than baseline * (1 + threshold), returns false if any did,
+    // reports of different physics apis are compared as well so one backend can be held against the other
+    static bool compare(const nlohmann::json& report, const nlohmann::json& baseline, f32 threshold);
+};
@@ -0,0 +1,79 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#include <PrototypeCommon/Definitions.h>
+
+#include "Bench.h"
+
+#include <PrototypeCommon/Logger.h>
+#include <PrototypeEngine/PrototypeEngineApplication.h>
+
+#include <fstream>
+#include <iostream>
+
+int
+main(int argc, char const* argv[])
+{
+    PrototypeBenchOptions options;
+    if (!PrototypeBench::parseArguments(argc, argv, options)) {
+        PrototypeBench::printUsage();
+        return 2;
+    }
+
+    nlohmann::json baseline;
+    if (!options.baseline.empty()) {
+        std::ifstream baselineFile(options.baseline);
+        if (!baselineFile.is_open()) {
+            PrototypeLogger::error("Failed to open baseline %s", options.baseline.c_str());
+            return 2;
+        }
+        baselineFile >> baseline;
+    }
+
+    PrototypeEngineRunOptions runOptions;
+    runOptions.sceneName     = options.sceneName;
+    runOptions.physicsApi    = options.physicsApi;
+    runOptions.maxFrames     = options.warmup + options.frames;
+    runOptions.headless      = true;
+    runOptions.loadPlugins   = options.plugins;
+    runOptions.measureStages = true;
+    runOptions.lockstep      = options.lockstep;
+    PrototypeEngineSetRunOptions(runOptions);
+
+    PrototypeEngineApplication application;
+    application.name         = "PrototypeBench";
+    application.versionMajor = 1;
+    application.versionMinor = 0;
+    application.onStartFn    = nullptr;
+    application.onRender3DFn = nullptr;
+    application.onRender2DFn = nullptr;
+    application.onUpdateFn   = PrototypeBench::update;
+    application.onEndFn      = nullptr;
+
+    if (!PrototypeEngineInit(application)) { return 2; }
+    PrototypeBench::generate(options);
+    PrototypeEngineLoop();
+    nlohmann::json report = PrototypeBench::collect(options);
+    PrototypeEngineDeInit();
+
+    if (options.output.empty()) {
+        std::cout << report.dump(4) << std::endl;
+    } else {
+        std::ofstream reportFile(options.output);
+        reportFile << report.dump(4);
+    }
+
+    if (!options.baseline.empty() && !PrototypeBench::compare(report, baseline, options.threshold)) { return 1; }
+    return 0;
+}
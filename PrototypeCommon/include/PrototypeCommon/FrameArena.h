@@ -0,0 +1,191 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#pragma once
+
+#include "Definitions.h"
+#include "Types.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// number of frames whose transient memory is kept alive at the same time
+// memory allocated in frame N stays valid until the beginning of frame N + PROTOTYPE_FRAME_ARENA_FRAMES_IN_FLIGHT
+#define PROTOTYPE_FRAME_ARENA_FRAMES_IN_FLIGHT 3
+#define PROTOTYPE_FRAME_ARENA_DEFAULT_CAPACITY (4 * 1024 * 1024)
+// every thread bumps from its own chunk of the frame block, larger allocations skip the chunks
+#define PROTOTYPE_FRAME_ARENA_THREAD_CHUNK (32 * 1024)
+
+struct PrototypeFrameArenaStats
+{
+    u64    frame;           // index of the frame these stats were gathered for
+    size_t bytesUsed;       // bytes bumped from the linear block
+    size_t bytesOverflow;   // bytes that didn't fit and went to the general purpose heap
+    size_t highWaterMark;   // highest bytesUsed seen since the arena was created
+    u64    heapAllocations; // operator new calls during the frame (needs PROTOTYPE_ENABLE_HEAP_COUNTER or the memory tracker)
+};
+
+struct PrototypeFrameArena
+{
+    explicit PrototypeFrameArena(size_t capacityPerFrame = PROTOTYPE_FRAME_ARENA_DEFAULT_CAPACITY);
+    ~PrototypeFrameArena();
+
+    PrototypeFrameArena(const PrototypeFrameArena&) = delete;
+    PrototypeFrameArena& operator=(const PrototypeFrameArena&) = delete;
+
+    // bump allocate from the current frame, safe to call from any thread
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+    // allocate an uninitialized array of trivially destructible elements
+    template<typename T>
+    T* allocateArray(size_t count)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "frame arena never runs destructors");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    // construct a trivially destructible object inside the current frame
+    template<typename T, typename... Args>
+    T* make(Args&&... args)
+    {
+        static_assert(std::is_trivially_destructible<T>::value, "frame arena never runs destructors");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // called by the engine once at the beginning of every frame, from one thread only
+    // recycles the oldest frame block, switches to it and waits for allocations other threads still have in flight
+    // in the frame that just ended before gathering its stats
+    void nextFrame();
+
+    // position of the calling thread inside its chunk of the current frame, used to rewind scratch allocations
+    size_t marker();
+
+    // drops the allocations the calling thread made from its chunk after the given marker
+    // other threads are never affected, markers taken on another thread or frame are ignored
+    void rewind(size_t marker);
+
+    bool                            owns(const void* ptr) const;
+    size_t                          capacity() const;
+    size_t                          used() const;
+    u64                             frame() const;
+    const PrototypeFrameArenaStats& lastFrameStats() const;
+
+    // regression hook, asserts when a steady-state frame exceeds the given number of operator new calls
+    // pass ~0ull to disable, only meaningful when built with PROTOTYPE_ENABLE_HEAP_COUNTER
+    void setHeapAllocationsBudget(u64 budget);
+
+    // total number of operator new calls made by the process so far (0 when the counter is disabled)
+    static u64  heapAllocationsCount();
+    static bool heapCounterEnabled();
+
+  private:
+    struct Block
+    {
+        u8*                 data;
+        std::atomic<size_t> offset;
+        std::atomic<u32>    allocating; // allocate calls in flight that bump from this block
+        std::vector<void*>  overflow;
+        size_t              overflowBytes;
+    };
+
+    struct Chunk
+    {
+        u64 arena;
+        u64 frame;
+        u32 block;
+        u8* begin;
+        u8* head;
+        u8* end;
+    };
+
+    Block&       current();
+    const Block& current() const;
+    Chunk&       threadChunk(u32 block);
+    u32          beginAllocation();
+    void*        allocateShared(Block& block, size_t size, size_t alignment);
+    void         releaseOverflow(Block& block);
+
+    std::array<Block, PROTOTYPE_FRAME_ARENA_FRAMES_IN_FLIGHT> _blocks;
+    std::mutex                                                _overflowMutex;
+    PrototypeFrameArenaStats                                  _lastFrameStats;
+    size_t                                                    _capacity;
+    u64                                                       _id;
+    std::atomic<u64>                                          _frame;
+    u64                                                       _heapAllocationsAtFrameStart;
+    u64                                                       _heapAllocationsBudget;
+    std::atomic<u32>                                          _index;
+};
+
+// rewinds the calling thread chunk to where it was when the scope was entered
+// use it for scratch memory that doesn't need to outlive a function
+struct PrototypeFrameArenaScope
+{
+    explicit PrototypeFrameArenaScope(PrototypeFrameArena* arena)
+      : _arena(arena)
+      , _marker(arena->marker())
+      , _frame(arena->frame())
+    {}
+    ~PrototypeFrameArenaScope()
+    {
+        // a frame boundary inside the scope already recycled the memory
+        if (_arena->frame() == _frame) { _arena->rewind(_marker); }
+    }
+
+    PrototypeFrameArenaScope(const PrototypeFrameArenaScope&) = delete;
+    PrototypeFrameArenaScope& operator=(const PrototypeFrameArenaScope&) = delete;
+
+  private:
+    PrototypeFrameArena* _arena;
+    size_t               _marker;
+    u64                  _frame;
+};
+
+// stl compatible adapter, deallocate is a no-op since the whole frame is dropped at once
+template<typename T>
+struct PrototypeFrameArenaAllocator
+{
+    typedef T value_type;
+
+    explicit PrototypeFrameArenaAllocator(PrototypeFrameArena* arena) noexcept
+      : arena(arena)
+    {}
+    template<typename U>
+    PrototypeFrameArenaAllocator(const PrototypeFrameArenaAllocator<U>& other) noexcept
+      : arena(other.arena)
+    {}
+
+    T* allocate(size_t n) { return static_cast<T*>(arena->allocate(sizeof(T) * n, alignof(T))); }
+    void deallocate(T*, size_t) noexcept {}
+
+    template<typename U>
+    bool operator==(const PrototypeFrameArenaAllocator<U>& other) const noexcept
+    {
+        return arena == other.arena;
+    }
+    template<typename U>
+    bool operator!=(const PrototypeFrameArenaAllocator<U>& other) const noexcept
+    {
+        return arena != other.arena;
+    }
+
+    PrototypeFrameArena* arena;
+};
+
+template<typename T>
+using PrototypeFrameVector = std::vector<T, PrototypeFrameArenaAllocator<T>>;
@@ -39,6 +39,7 @@ class PrototypeIo
     static bool                     readFileText(const char* path, std::string& text);
     static bool                     readFileBlock(const char* path, std::string& text);
     static void                     writeFileBlock(const char* path, std::string& text);
+    static void                     appendFileBlock(const char* path, std::string& text);
     static void                     copyFile(const char* fromPath, const char* toPath);
     static time_t                   filestamp(const std::string& filepath);
     static std::vector<std::string> listFiles(const std::string& filepath, u8 levelLimit);
@@ -15,10 +15,61 @@
 #pragma once
 
 #include "Definitions.h"
+#include "Types.h"
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <map>
+#include <mutex>
+#include <stdarg.h>
+#include <stdio.h>
 #include <string>
+#include <thread>
+
+enum PrototypeLoggerLevel_
+{
+    PrototypeLoggerLevel_Trace = 0,
+    PrototypeLoggerLevel_Log,
+    PrototypeLoggerLevel_Warn,
+    PrototypeLoggerLevel_Error,
+    PrototypeLoggerLevel_Fatal,
+
+    PrototypeLoggerLevel_Count
+};
+
+// what producers do when their ring is full
+enum PrototypeLoggerOverflowPolicy_
+{
+    PrototypeLoggerOverflowPolicy_Drop = 0, // never stall the caller, count the message as dropped
+    PrototypeLoggerOverflowPolicy_Block,    // wait for the worker to make room
+
+    PrototypeLoggerOverflowPolicy_Count
+};
+
+enum PrototypeLoggerSinkMask_
+{
+    PrototypeLoggerSinkMask_Console = 1 << 0,
+    PrototypeLoggerSinkMask_File    = 1 << 1,
+    PrototypeLoggerSinkMask_Editor  = 1 << 2,
+
+    PrototypeLoggerSinkMask_All = PrototypeLoggerSinkMask_Console | PrototypeLoggerSinkMask_File | PrototypeLoggerSinkMask_Editor
+};
+
+// messages below this level are stripped from the build
+#if !defined(PROTOTYPE_LOGGER_COMPILE_LEVEL)
+#define PROTOTYPE_LOGGER_COMPILE_LEVEL PrototypeLoggerLevel_Trace
+#endif
+
+// guard expensive argument preparation with this
+#define PROTOTYPE_LOGGER_LEVEL_ENABLED(LEVEL) ((LEVEL) >= PROTOTYPE_LOGGER_COMPILE_LEVEL && PrototypeLogger::isEnabled(LEVEL))
+
+#define PROTOTYPE_LOGGER_MAX_PRODUCERS 64   // maximum number of threads logging at the same time
+#define PROTOTYPE_LOGGER_RING_CAPACITY 1024 // records per producer thread, must be a power of 2
+#define PROTOTYPE_LOGGER_RECORD_SIZE   512  // bytes per record, longer messages get truncated
+
+struct PrototypeLoggerRing;
 
 struct PrototypeLoggerReferencedLog
 {
@@ -34,11 +85,31 @@ struct PrototypeLoggerReferencedLog
 
 struct PrototypeLoggerData
 {
-    PrototypeLoggerData()
-      : maxLogsCount(1024)
-    {}
+    PrototypeLoggerData();
+    ~PrototypeLoggerData();
+
+    // editor console logs, written by the worker thread, lock logsMutex before reading them
     std::deque<PrototypeLoggerReferencedLog> logs;
+    std::mutex                               logsMutex;
     size_t                                   maxLogsCount;
+
+    std::atomic<i32> level;
+    std::atomic<i32> overflowPolicy;
+    std::atomic<u32> sinks;
+    std::atomic<u64> droppedCount;
+
+  private:
+    friend struct PrototypeLogger;
+    std::array<std::atomic<PrototypeLoggerRing*>, PROTOTYPE_LOGGER_MAX_PRODUCERS> _rings;
+    std::atomic<u32>                                                              _numRings;
+    std::mutex                                                                    _registerMutex;
+    std::mutex                                                                    _fileMutex;
+    FILE*                                                                         _file;
+    std::thread                                                                   _worker;
+    std::atomic<bool>                                                             _isRunning;
+    std::atomic<u64>                                                              _flushRequested;
+    std::atomic<u64>                                                              _flushCompleted;
+    std::chrono::steady_clock::time_point                                         _startTime;
 };
 
 struct PrototypeLogger
@@ -56,8 +127,32 @@ struct PrototypeLogger
     static PrototypeLoggerData* data();
     static void                 setData(PrototypeLoggerData* data);
 
+    // starts the background thread that formats and sinks the records
+    // until then (or when there is no data) logging falls back to formatting on the calling thread
+    static void startWorker();
+    static void stopWorker();
+    // blocks until everything logged before the call has been written to the sinks
+    static void flush();
+
+    static bool isEnabled(PrototypeLoggerLevel_ level);
+    static void setLevel(PrototypeLoggerLevel_ level);
+    static void setOverflowPolicy(PrototypeLoggerOverflowPolicy_ policy);
+    static void setSinks(u32 sinkMask);
+    static bool setFileSink(const char* path);
+
   private:
-    static void print(const char* status, const char* message, va_list args);
+    static PrototypeLoggerRing* acquireRing(PrototypeLoggerData* data);
+    static u64                  now(PrototypeLoggerData* data);
+    static void                 sink(PrototypeLoggerData*  data,
+                                     PrototypeLoggerLevel_ level,
+                                     u64                   timestamp,
+                                     const char*           filepath,
+                                     int                   line,
+                                     const std::string&    text);
+    static void                 write(PrototypeLoggerLevel_ level, const char* message, va_list args);
+    static void                 print(const char* status, const char* message, va_list args);
+    static void                 workerProcedure(PrototypeLoggerData* data);
+    static bool                 drain(PrototypeLoggerData* data);
 
     static PrototypeLoggerData* _data;
-};
\ No newline at end of file
+};
@@ -225,6 +225,34 @@ buildModelMatrix(glm::mat4& model, const glm::vec3& position, const glm::vec3& r
 extern void
 buildModelMatrixWithScale(glm::mat4& model, const glm::vec3& scale);
 
+// the orientation buildModelMatrix rotates by, rotation holds euler angles in degrees
+extern void
+buildModelOrientation(glm::quat& orientation, const glm::vec3& rotation);
+
+// the euler angles in degrees buildModelOrientation builds the orientation back from,
+// x and z within [-180, 180] and y within [-90, 90]
+extern void
+decomposeModelOrientation(const glm::quat& orientation, glm::vec3& rotation);
+
+// Batched kernels over arrays of count elements, four elements at a time with sse2 or neon and through glm for the rest.
+// They expect the arrays as separate streams rather than whole objects so callers can keep transforms in soa form.
+
+// models[i] = translate(positions[i]) * orientations[i] * scale(scales[i]), scales may be null for unit scales
+extern void
+composeModelMatrices(glm::mat4*       models,
+                     const glm::vec3* positions,
+                     const glm::quat* orientations,
+                     const glm::vec3* scales,
+                     size_t           count);
+
+// results[i] = lhs[i] * rhs[i], results may alias lhs or rhs
+extern void
+multiplyMatrices(glm::mat4* results, const glm::mat4* lhs, const glm::mat4* rhs, size_t count);
+
+// results[i] = inverse(models[i]) for affine models whose last row is 0 0 0 1, results may alias models
+extern void
+invertAffineMatrices(glm::mat4* results, const glm::mat4* models, size_t count);
+
 extern void
 buildTargetViewMatrix(glm::mat4& view, const glm::vec3& position, const glm::vec3& point);
 
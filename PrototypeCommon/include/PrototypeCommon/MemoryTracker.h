@@ -0,0 +1,110 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#pragma once
+
+#include "Definitions.h"
+#include "Types.h"
+
+#include <stddef.h>
+
+#define PROTOTYPE_MEMORY_TRACKER_MAX_FRAMES    12   // frames captured per call-site stack
+#define PROTOTYPE_MEMORY_TRACKER_MAX_CALLSITES 4096 // distinct call-site stacks kept, must be a power of 2
+#define PROTOTYPE_MEMORY_TRACKER_INVALID_SITE  0xffffffff
+
+enum PrototypeMemoryTag_
+{
+    PrototypeMemoryTag_Untagged = 0,
+    PrototypeMemoryTag_Scene,
+    PrototypeMemoryTag_Meshes,
+    PrototypeMemoryTag_Textures,
+    PrototypeMemoryTag_Shaders,
+    PrototypeMemoryTag_Renderer,
+    PrototypeMemoryTag_Physics,
+    PrototypeMemoryTag_Scripts,
+    PrototypeMemoryTag_Editor,
+
+    PrototypeMemoryTag_Count
+};
+
+struct PrototypeMemoryTagStats
+{
+    u64 liveBytes;
+    u64 liveAllocations;
+    u64 peakBytes;
+    u64 totalBytes;
+    u64 totalAllocations;
+    f64 bytesPerSecond;       // over the last sample() interval
+    f64 allocationsPerSecond; // over the last sample() interval
+};
+
+// Optional allocation tracking, compiled in with PROTOTYPE_ENABLE_MEMORY_TRACKER.
+// Global operator new/delete record every allocation of the module with the tag of the innermost
+// PROTOTYPE_MEMORY_TAG scope of the calling thread, allocators that bypass operator new (physx) call
+// recordAllocation/recordFree directly. Without the define every call here is a no-op.
+struct PrototypeMemoryTracker
+{
+    PrototypeMemoryTracker()  = delete;
+    ~PrototypeMemoryTracker() = delete;
+
+    static bool enabled();
+
+    static void recordAllocation(void* ptr, size_t size);
+    static void recordFree(void* ptr);
+
+    // tag of the calling thread, returns the previous one
+    static PrototypeMemoryTag_ setTag(PrototypeMemoryTag_ tag);
+    static PrototypeMemoryTag_ tag();
+    static const char*         tagName(PrototypeMemoryTag_ tag);
+
+    // capturing stacks costs a stack walk and a lock per allocation, off by default
+    static void setCaptureStacks(bool status);
+
+    // operator new calls made by the module so far, also counted by PROTOTYPE_ENABLE_HEAP_COUNTER
+    static u64 allocationsCount();
+
+    // refreshes the allocation rates, the engine calls it once per frame
+    static void                    sample();
+    static PrototypeMemoryTagStats stats(PrototypeMemoryTag_ tag);
+
+    // writes the per tag stats and the top call sites (by live bytes) as json, stable enough to diff between runs
+    static bool writeSnapshot(const char* path, u32 maxCallsites = 32);
+};
+
+struct PrototypeMemoryTagScope
+{
+    explicit PrototypeMemoryTagScope(PrototypeMemoryTag_ tag)
+      : _previous(PrototypeMemoryTracker::setTag(tag))
+    {}
+    ~PrototypeMemoryTagScope() { PrototypeMemoryTracker::setTag(_previous); }
+
+    PrototypeMemoryTagScope(const PrototypeMemoryTagScope&) = delete;
+    PrototypeMemoryTagScope& operator=(const PrototypeMemoryTagScope&) = delete;
+
+  private:
+    PrototypeMemoryTag_ _previous;
+};
+
+// clang-format off
+
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    #define PROTOTYPE_MEMORY_TAG_CONCAT_IMPL(A, B) A##B
+    #define PROTOTYPE_MEMORY_TAG_CONCAT(A, B)      PROTOTYPE_MEMORY_TAG_CONCAT_IMPL(A, B)
+    #define PROTOTYPE_MEMORY_TAG(TAG)                                                                                  \
+        PrototypeMemoryTagScope PROTOTYPE_MEMORY_TAG_CONCAT(prototypeMemoryTag, __LINE__)(TAG);
+#else
+    #define PROTOTYPE_MEMORY_TAG(TAG)
+#endif
+
+// clang-format on
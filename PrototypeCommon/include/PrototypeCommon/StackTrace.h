@@ -0,0 +1,31 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#pragma once
+
+#include "Definitions.h"
+#include "Types.h"
+
+#include <stddef.h>
+
+struct PrototypeStackTrace
+{
+    PrototypeStackTrace()  = delete;
+    ~PrototypeStackTrace() = delete;
+
+    // writes "symbol (module+offset)" or "module+offset" for a code address, the raw address when it isn't in any module,
+    // windows only gets module relative offsets, they stay the same between runs and resolve offline against the pdb
+    static void describeFrame(void* frame, char* text, size_t size);
+};
@@ -0,0 +1,168 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#pragma once
+
+#include "Definitions.h"
+#include "Types.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#define PROTOTYPE_TRACER_MAX_THREADS       64        // maximum number of threads that ever traced
+#define PROTOTYPE_TRACER_EVENTS_PER_THREAD (1 << 16) // events kept per thread, must be a power of 2
+#define PROTOTYPE_TRACER_INVALID_ID        0xffffffff
+
+enum PrototypeTracerEventType_
+{
+    PrototypeTracerEventType_ZoneBegin = 0,
+    PrototypeTracerEventType_ZoneEnd,
+    PrototypeTracerEventType_Counter,
+    PrototypeTracerEventType_Frame,
+
+    PrototypeTracerEventType_Count
+};
+
+struct PrototypeTracerEvent
+{
+    u64 ticks;      // PrototypeTracer::ticks() at the time of the event
+    i64 value;      // counter value, frame index for frame markers
+    u32 descriptor; // index of the zone/counter descriptor
+    u32 type;       // PrototypeTracerEventType_
+};
+
+// registered once per call site, events only carry its index
+struct PrototypeTracerDescriptor
+{
+    std::string               name;
+    std::string               file;
+    u32                       line;
+    PrototypeTracerEventType_ type;
+};
+
+struct PrototypeTracerBuffer;
+
+struct PrototypeTracerData
+{
+    PrototypeTracerData();
+    ~PrototypeTracerData();
+
+    std::atomic<bool> enabled;
+
+  private:
+    friend struct PrototypeTracer;
+    std::array<std::atomic<PrototypeTracerBuffer*>, PROTOTYPE_TRACER_MAX_THREADS> _buffers;
+    std::atomic<u32>                                                              _numBuffers;
+    std::mutex                                                                    _registerMutex;
+    std::deque<PrototypeTracerDescriptor>                                         _descriptors;
+    std::atomic<u64>                                                              _frame;
+    u64                                                                           _startTicks;
+    std::chrono::steady_clock::time_point                                         _startTime;
+};
+
+// Scoped zone profiler, every thread records into its own ring so recording never takes a lock.
+// The rings keep the last PROTOTYPE_TRACER_EVENTS_PER_THREAD events and can be exported at any time
+// to the chrome trace json format (chrome://tracing, ui.perfetto.dev).
+// Build with PROTOTYPE_TRACER_USE_TSC to timestamp with the cpu cycle counter instead of steady_clock.
+struct PrototypeTracer
+{
+    PrototypeTracer()  = delete;
+    ~PrototypeTracer() = delete;
+
+    static PrototypeTracerData* data();
+    static void                 setData(PrototypeTracerData* data);
+
+    static bool isEnabled();
+    static void setEnabled(bool status);
+
+    // call sites register once (through the macros below) and get back a descriptor id
+    static u32 registerZone(const char* name, const char* file, u32 line);
+    static u32 registerCounter(const char* name);
+
+    static void setThreadName(const char* name);
+
+    // returns false when nothing was recorded, the matching endZone must then be skipped
+    static bool beginZone(u32 id);
+    static void endZone(u32 id);
+    static void counter(u32 id, i64 value);
+    // marks the beginning of a new frame
+    static void frame();
+
+    static u64 ticks();
+
+    // writes everything still held by the rings, safe to call while other threads are recording
+    static bool exportChromeTrace(const char* path);
+
+    // average cost in nanoseconds of one begin/end pair recorded on the calling thread
+    static f64 measureZoneOverhead(u32 iterations);
+
+  private:
+    static PrototypeTracerBuffer* acquireBuffer(PrototypeTracerData* data);
+    static void                   emit(PrototypeTracerData* data, u32 type, u32 descriptor, i64 value);
+    static u32                    registerDescriptor(const char* name, const char* file, u32 line, PrototypeTracerEventType_ type);
+
+    static PrototypeTracerData* _data;
+};
+
+struct PrototypeTracerScope
+{
+    explicit PrototypeTracerScope(u32 id)
+      : _id(PrototypeTracer::beginZone(id) ? id : PROTOTYPE_TRACER_INVALID_ID)
+    {}
+    ~PrototypeTracerScope()
+    {
+        if (_id != PROTOTYPE_TRACER_INVALID_ID) { PrototypeTracer::endZone(_id); }
+    }
+
+    PrototypeTracerScope(const PrototypeTracerScope&) = delete;
+    PrototypeTracerScope& operator=(const PrototypeTracerScope&) = delete;
+
+  private:
+    u32 _id;
+};
+
+// clang-format off
+
+#if defined(PROTOTYPE_DISABLE_TRACER)
+    #define PROTOTYPE_TRACE_ZONE(NAME)
+    #define PROTOTYPE_TRACE_FUNCTION()
+    #define PROTOTYPE_TRACE_COUNTER(NAME, VALUE)
+    #define PROTOTYPE_TRACE_FRAME()
+#else
+    #define PROTOTYPE_TRACE_CONCAT_IMPL(A, B) A##B
+    #define PROTOTYPE_TRACE_CONCAT(A, B)      PROTOTYPE_TRACE_CONCAT_IMPL(A, B)
+
+    // NAME is copied the first time the call site runs, descriptors are shared with the plugins
+    #define PROTOTYPE_TRACE_ZONE(NAME)                                                                                 \
+        static const u32 PROTOTYPE_TRACE_CONCAT(prototypeTraceZone, __LINE__) =                                        \
+          PrototypeTracer::registerZone(NAME, __FILE__, __LINE__);                                                     \
+        PrototypeTracerScope PROTOTYPE_TRACE_CONCAT(prototypeTraceScope, __LINE__)(                                    \
+          PROTOTYPE_TRACE_CONCAT(prototypeTraceZone, __LINE__));
+
+    #define PROTOTYPE_TRACE_FUNCTION() PROTOTYPE_TRACE_ZONE(PROTOTYPE_FUNCTION_NAME)
+
+    #define PROTOTYPE_TRACE_COUNTER(NAME, VALUE)                                                                       \
+        {                                                                                                              \
+            static const u32 prototypeTraceCounter = PrototypeTracer::registerCounter(NAME);                           \
+            PrototypeTracer::counter(prototypeTraceCounter, (i64)(VALUE));                                             \
+        }
+
+    #define PROTOTYPE_TRACE_FRAME() PrototypeTracer::frame();
+#endif
+
+// clang-format on
@@ -0,0 +1,266 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#include "../include/PrototypeCommon/FrameArena.h"
+#include "../include/PrototypeCommon/Logger.h"
+#include "../include/PrototypeCommon/MemoryTracker.h"
+
+#include <cstdlib>
+#include <thread>
+
+// arenas are told apart by id rather than address so a new arena at a recycled address never picks up a stale chunk
+static std::atomic<u64> frameArenaIds(1);
+
+static u8*
+alignUp(u8* ptr, size_t alignment)
+{
+    size_t p = reinterpret_cast<size_t>(ptr);
+    return reinterpret_cast<u8*>((p + alignment - 1) & ~(alignment - 1));
+}
+
+// counts the calling thread as allocating from a block until the scope ends
+struct FrameArenaAllocationGuard
+{
+    explicit FrameArenaAllocationGuard(std::atomic<u32>& allocating)
+      : allocating(allocating)
+    {}
+    ~FrameArenaAllocationGuard() { allocating.fetch_sub(1); }
+
+    std::atomic<u32>& allocating;
+};
+
+PrototypeFrameArena::PrototypeFrameArena(size_t capacityPerFrame)
+  : _lastFrameStats({})
+  , _capacity(capacityPerFrame)
+  , _id(frameArenaIds.fetch_add(1, std::memory_order_relaxed))
+  , _frame(0)
+  , _heapAllocationsAtFrameStart(heapAllocationsCount())
+  , _heapAllocationsBudget(~0ull)
+  , _index(0)
+{
+    for (Block& block : _blocks) {
+        block.data = static_cast<u8*>(std::malloc(_capacity));
+        block.offset.store(0, std::memory_order_relaxed);
+        block.allocating.store(0, std::memory_order_relaxed);
+        block.overflowBytes = 0;
+    }
+}
+
+PrototypeFrameArena::~PrototypeFrameArena()
+{
+    for (Block& block : _blocks) {
+        releaseOverflow(block);
+        std::free(block.data);
+    }
+}
+
+void*
+PrototypeFrameArena::allocate(size_t size, size_t alignment)
+{
+    PROTOTYPE_ASSERT_DEBUG((alignment & (alignment - 1)) == 0);
+    const u32                 index = beginAllocation();
+    Block&                    block = _blocks[index];
+    FrameArenaAllocationGuard guard(block.allocating);
+    if (size + alignment > PROTOTYPE_FRAME_ARENA_THREAD_CHUNK / 2) { return allocateShared(block, size, alignment); }
+
+    Chunk& chunk   = threadChunk(index);
+    u8*    aligned = alignUp(chunk.head, alignment);
+    if (!chunk.head || aligned + size > chunk.end) {
+        // the rest of the old chunk stays unused until the frame is recycled
+        chunk.begin =
+          static_cast<u8*>(allocateShared(block, PROTOTYPE_FRAME_ARENA_THREAD_CHUNK, alignof(std::max_align_t)));
+        chunk.head  = chunk.begin;
+        chunk.end   = chunk.begin + PROTOTYPE_FRAME_ARENA_THREAD_CHUNK;
+        aligned     = alignUp(chunk.head, alignment);
+    }
+    chunk.head = aligned + size;
+    return aligned;
+}
+
+u32
+PrototypeFrameArena::beginAllocation()
+{
+    // registers with the block before using it, a frame boundary in between makes it register with the fresh one
+    for (;;) {
+        const u32 index = _index.load();
+        _blocks[index].allocating.fetch_add(1);
+        if (_index.load() == index) { return index; }
+        _blocks[index].allocating.fetch_sub(1);
+    }
+}
+
+void*
+PrototypeFrameArena::allocateShared(Block& block, size_t size, size_t alignment)
+{
+    size_t offset = block.offset.load(std::memory_order_relaxed);
+    for (;;) {
+        size_t base    = reinterpret_cast<size_t>(block.data);
+        size_t aligned = ((base + offset + alignment - 1) & ~(alignment - 1)) - base;
+        size_t end     = aligned + size;
+        if (end > _capacity) { break; }
+        if (block.offset.compare_exchange_weak(offset, end, std::memory_order_relaxed)) { return block.data + aligned; }
+    }
+
+    // out of frame memory, fall back to the heap and keep track of it so it's freed with the frame
+    void* ptr = std::malloc(size + alignment);
+    std::lock_guard<std::mutex> lock(_overflowMutex);
+    if (block.overflow.empty()) {
+        PrototypeLogger::warn("Frame arena exhausted (%zu bytes), falling back to heap allocations", _capacity);
+    }
+    block.overflow.push_back(ptr);
+    block.overflowBytes += size;
+    size_t p = reinterpret_cast<size_t>(ptr);
+    return reinterpret_cast<void*>((p + alignment - 1) & ~(alignment - 1));
+}
+
+void
+PrototypeFrameArena::nextFrame()
+{
+    const u32 endedIndex = _index.load();
+    const u32 freshIndex = (endedIndex + 1) % PROTOTYPE_FRAME_ARENA_FRAMES_IN_FLIGHT;
+    Block&    ended      = _blocks[endedIndex];
+    Block&    fresh      = _blocks[freshIndex];
+
+    // nobody bumped from the oldest block since the previous frame boundaries waited for it, recycle it before it's
+    // handed out again
+    releaseOverflow(fresh);
+    fresh.offset.store(0, std::memory_order_relaxed);
+
+    // the index moves first, a thread that already sees the new frame registers with the fresh block
+    _index.store(freshIndex);
+    const u64 endedFrame = _frame.fetch_add(1);
+
+    // allocations registered with the ended block still bump from it, new ones go to the fresh block so this only waits
+    // for the calls already in flight, the stats are final afterwards and the next recycle can't pull a block from
+    // under a worker
+    while (ended.allocating.load() != 0) { std::this_thread::yield(); }
+
+    _lastFrameStats.frame         = endedFrame;
+    _lastFrameStats.bytesUsed     = ended.offset.load(std::memory_order_relaxed);
+    _lastFrameStats.bytesOverflow = ended.overflowBytes;
+    if (_lastFrameStats.bytesUsed > _lastFrameStats.highWaterMark) {
+        _lastFrameStats.highWaterMark = _lastFrameStats.bytesUsed;
+    }
+    u64 heapAllocations             = heapAllocationsCount();
+    _lastFrameStats.heapAllocations = heapAllocations - _heapAllocationsAtFrameStart;
+    _heapAllocationsAtFrameStart    = heapAllocations;
+    PROTOTYPE_ASSERT_MSG(_lastFrameStats.heapAllocations <= _heapAllocationsBudget,
+                         "Steady-state frame exceeded its heap allocations budget");
+}
+
+size_t
+PrototypeFrameArena::marker()
+{
+    return reinterpret_cast<size_t>(threadChunk(_index.load()).head);
+}
+
+void
+PrototypeFrameArena::rewind(size_t marker)
+{
+    // the shared block is never moved back, other threads may still be using what they bumped after the marker
+    Chunk& chunk = threadChunk(_index.load());
+    u8*    ptr   = reinterpret_cast<u8*>(marker);
+    if (!ptr) {
+        chunk.head = chunk.begin;
+    } else if (ptr >= chunk.begin && ptr <= chunk.head) {
+        chunk.head = ptr;
+    }
+    // a marker from an older chunk of this thread keeps what was allocated since, it's dropped with the frame
+}
+
+bool
+PrototypeFrameArena::owns(const void* ptr) const
+{
+    for (const Block& block : _blocks) {
+        if (ptr >= block.data && ptr < block.data + _capacity) { return true; }
+    }
+    return false;
+}
+
+size_t
+PrototypeFrameArena::capacity() const
+{
+    return _capacity;
+}
+
+size_t
+PrototypeFrameArena::used() const
+{
+    return current().offset.load(std::memory_order_relaxed);
+}
+
+u64
+PrototypeFrameArena::frame() const
+{
+    return _frame.load(std::memory_order_relaxed);
+}
+
+const PrototypeFrameArenaStats&
+PrototypeFrameArena::lastFrameStats() const
+{
+    return _lastFrameStats;
+}
+
+void
+PrototypeFrameArena::setHeapAllocationsBudget(u64 budget)
+{
+    _heapAllocationsBudget = budget;
+}
+
+u64
+PrototypeFrameArena::heapAllocationsCount()
+{
+    return PrototypeMemoryTracker::allocationsCount();
+}
+
+bool
+PrototypeFrameArena::heapCounterEnabled()
+{
+#if defined(PROTOTYPE_ENABLE_HEAP_COUNTER) || defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    return true;
+#else
+    return false;
+#endif
+}
+
+PrototypeFrameArena::Block&
+PrototypeFrameArena::current()
+{
+    return _blocks[_index.load()];
+}
+
+const PrototypeFrameArena::Block&
+PrototypeFrameArena::current() const
+{
+    return _blocks[_index.load()];
+}
+
+PrototypeFrameArena::Chunk&
+PrototypeFrameArena::threadChunk(u32 block)
+{
+    thread_local Chunk chunk = {};
+    u64                frame = _frame.load();
+    if (chunk.arena != _id || chunk.frame != frame || chunk.block != block) {
+        chunk = { _id, frame, block, nullptr, nullptr, nullptr };
+    }
+    return chunk;
+}
+
+void
+PrototypeFrameArena::releaseOverflow(Block& block)
+{
+    for (void* ptr : block.overflow) { std::free(ptr); }
+    block.overflow.clear();
+    block.overflowBytes = 0;
+}
@@ -173,6 +173,14 @@ PrototypeIo::writeFileBlock(const char* path, std::string& text)
     file.close();
 }
 
+void
+PrototypeIo::appendFileBlock(const char* path, std::string& text)
+{
+    std::ofstream file(path, std::ios::app | std::ios::binary);
+    file << text;
+    file.close();
+}
+
 void
 PrototypeIo::copyFile(const char* fromPath, const char* toPath)
 {
@@ -16,16 +16,508 @@
 
 #include "../include/PrototypeCommon/IO.h"
 
-#define FMT_HEADER_ONLY
-#include <fmt/format.h>
-#include <fmt/printf.h>
-
+#include <algorithm>
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <string>
 
+// A record is what a producer writes into its ring, the format string is kept by pointer (its id) and
+// the arguments are copied raw into the payload, the worker thread does the actual formatting.
+// Records with a null format carry already formatted text (PrototypeLogger::log) as "file\0text\0".
+struct PrototypeLoggerRecord
+{
+    u64         timestamp;
+    const char* format;
+    i32         line;
+    u16         payloadSize;
+    u8          level;
+    u8          truncated;
+    char        payload[PROTOTYPE_LOGGER_RECORD_SIZE - 24];
+};
+
+static_assert(sizeof(PrototypeLoggerRecord) == PROTOTYPE_LOGGER_RECORD_SIZE, "unexpected logger record padding");
+static_assert((PROTOTYPE_LOGGER_RING_CAPACITY & (PROTOTYPE_LOGGER_RING_CAPACITY - 1)) == 0,
+              "logger ring capacity must be a power of 2");
+
+// single producer (the owning thread) single consumer (the worker) ring
+// a ring is handed over to the next thread that logs once its owner exits, the worker keeps draining it meanwhile
+struct PrototypeLoggerRing
+{
+    alignas(64) std::atomic<u32> head     = { 0 };
+    alignas(64) std::atomic<u32> tail     = { 0 };
+    std::atomic<bool>            released = { false };
+    PrototypeLoggerRecord        records[PROTOTYPE_LOGGER_RING_CAPACITY];
+};
+
+static const char* PrototypeLoggerLevelStatus[PrototypeLoggerLevel_Count] = {
+    "[TRACE] ", "[LOG] ", "[WARN] ", "[ERROR] ", "[FATAL] "
+};
+
+// gives the ring of the thread back when the thread exits
+struct PrototypeLoggerThreadRing
+{
+    ~PrototypeLoggerThreadRing()
+    {
+        // the rings die with their data, skip the release if the data is already gone
+        if (ring && owner == PrototypeLogger::data()) { ring->released.store(true, std::memory_order_release); }
+    }
+
+    PrototypeLoggerRing* ring  = nullptr;
+    PrototypeLoggerData* owner = nullptr;
+};
+
+static thread_local PrototypeLoggerThreadRing tRing;
+
 PrototypeLoggerData* PrototypeLogger::_data = nullptr;
 
+// ----------------------------------------------------------------------------------------------------------
+// printf arguments encoding
+// ----------------------------------------------------------------------------------------------------------
+
+enum PrototypeLoggerArgLength_
+{
+    PrototypeLoggerArgLength_None,
+    PrototypeLoggerArgLength_hh,
+    PrototypeLoggerArgLength_h,
+    PrototypeLoggerArgLength_l,
+    PrototypeLoggerArgLength_ll,
+    PrototypeLoggerArgLength_j,
+    PrototypeLoggerArgLength_z,
+    PrototypeLoggerArgLength_t,
+    PrototypeLoggerArgLength_L
+};
+
+struct PrototypeLoggerSpec
+{
+    const char*               begin; // points at '%'
+    const char*               end;   // one past the conversion character
+    PrototypeLoggerArgLength_ length;
+    char                      conversion;
+    bool                      starWidth;
+    bool                      starPrecision;
+};
+
+// parses the next conversion specification starting from p, returns false when the format ends
+static bool
+nextSpec(const char*& p, PrototypeLoggerSpec& spec)
+{
+    for (; *p; ++p) {
+        if (*p != '%') { continue; }
+        if (p[1] == '%') {
+            ++p;
+            continue;
+        }
+        spec.begin         = p++;
+        spec.starWidth     = false;
+        spec.starPrecision = false;
+        spec.length        = PrototypeLoggerArgLength_None;
+        while (*p && strchr("-+ #0", *p)) { ++p; }
+        if (*p == '*') {
+            spec.starWidth = true;
+            ++p;
+        } else {
+            while (*p >= '0' && *p <= '9') { ++p; }
+        }
+        if (*p == '.') {
+            ++p;
+            if (*p == '*') {
+                spec.starPrecision = true;
+                ++p;
+            } else {
+                while (*p >= '0' && *p <= '9') { ++p; }
+            }
+        }
+        switch (*p) {
+            case 'h': {
+                ++p;
+                if (*p == 'h') {
+                    spec.length = PrototypeLoggerArgLength_hh;
+                    ++p;
+                } else {
+                    spec.length = PrototypeLoggerArgLength_h;
+                }
+            } break;
+            case 'l': {
+                ++p;
+                if (*p == 'l') {
+                    spec.length = PrototypeLoggerArgLength_ll;
+                    ++p;
+                } else {
+                    spec.length = PrototypeLoggerArgLength_l;
+                }
+            } break;
+            case 'j': spec.length = PrototypeLoggerArgLength_j, ++p; break;
+            case 'z': spec.length = PrototypeLoggerArgLength_z, ++p; break;
+            case 't': spec.length = PrototypeLoggerArgLength_t, ++p; break;
+            case 'L': spec.length = PrototypeLoggerArgLength_L, ++p; break;
+            default: break;
+        }
+        if (*p == '\0') { return false; }
+        spec.conversion = *p++;
+        spec.end        = p;
+        return true;
+    }
+    return false;
+}
+
+struct PrototypeLoggerWriter
+{
+    char*  data;
+    size_t size;
+    size_t capacity;
+    bool   truncated;
+
+    template<typename T>
+    bool put(const T& value)
+    {
+        if (size + sizeof(T) > capacity) {
+            truncated = true;
+            return false;
+        }
+        memcpy(data + size, &value, sizeof(T));
+        size += sizeof(T);
+        return true;
+    }
+
+    bool putString(const char* str)
+    {
+        if (!str) { str = "(null)"; }
+        if (size + sizeof(u16) + 1 > capacity) {
+            truncated = true;
+            return false;
+        }
+        size_t room = capacity - size - sizeof(u16) - 1;
+        size_t len  = strlen(str);
+        if (len > room) {
+            len       = room;
+            truncated = true;
+        }
+        u16 len16 = (u16)len;
+        memcpy(data + size, &len16, sizeof(u16));
+        size += sizeof(u16);
+        memcpy(data + size, str, len);
+        size += len;
+        data[size++] = '\0';
+        return !truncated;
+    }
+};
+
+struct PrototypeLoggerReader
+{
+    const char* data;
+    size_t      size;
+    size_t      offset;
+
+    template<typename T>
+    bool get(T& value)
+    {
+        if (offset + sizeof(T) > size) { return false; }
+        memcpy(&value, data + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+
+    bool getString(const char*& str)
+    {
+        u16 len;
+        if (!get(len)) { return false; }
+        if (offset + len + 1 > size) { return false; }
+        str = data + offset;
+        offset += len + 1;
+        return true;
+    }
+};
+
+static void
+encodeArgs(const char* format, va_list args, PrototypeLoggerWriter& writer)
+{
+    PrototypeLoggerSpec spec;
+    const char*         p = format;
+    while (nextSpec(p, spec)) {
+        if (spec.starWidth && !writer.put((i32)va_arg(args, int))) { return; }
+        if (spec.starPrecision && !writer.put((i32)va_arg(args, int))) { return; }
+        switch (spec.conversion) {
+            case 'd':
+            case 'i': {
+                i64 v;
+                switch (spec.length) {
+                    case PrototypeLoggerArgLength_hh: v = (signed char)va_arg(args, int); break;
+                    case PrototypeLoggerArgLength_h: v = (short)va_arg(args, int); break;
+                    case PrototypeLoggerArgLength_l: v = va_arg(args, long); break;
+                    case PrototypeLoggerArgLength_ll: v = va_arg(args, long long); break;
+                    case PrototypeLoggerArgLength_j: v = va_arg(args, intmax_t); break;
+                    case PrototypeLoggerArgLength_z: v = (i64)va_arg(args, size_t); break;
+                    case PrototypeLoggerArgLength_t: v = va_arg(args, ptrdiff_t); break;
+                    default: v = va_arg(args, int); break;
+                }
+                if (!writer.put(v)) { return; }
+            } break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X': {
+                u64 v;
+                switch (spec.length) {
+                    case PrototypeLoggerArgLength_hh: v = (unsigned char)va_arg(args, unsigned int); break;
+                    case PrototypeLoggerArgLength_h: v = (unsigned short)va_arg(args, unsigned int); break;
+                    case PrototypeLoggerArgLength_l: v = va_arg(args, unsigned long); break;
+                    case PrototypeLoggerArgLength_ll: v = va_arg(args, unsigned long long); break;
+                    case PrototypeLoggerArgLength_j: v = va_arg(args, uintmax_t); break;
+                    case PrototypeLoggerArgLength_z: v = va_arg(args, size_t); break;
+                    case PrototypeLoggerArgLength_t: v = (u64)va_arg(args, ptrdiff_t); break;
+                    default: v = va_arg(args, unsigned int); break;
+                }
+                if (!writer.put(v)) { return; }
+            } break;
+            case 'c': {
+                if (!writer.put((i32)va_arg(args, int))) { return; }
+            } break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A': {
+                f64 v = spec.length == PrototypeLoggerArgLength_L ? (f64)va_arg(args, long double) : va_arg(args, double);
+                if (!writer.put(v)) { return; }
+            } break;
+            case 's': {
+                if (!writer.putString(va_arg(args, const char*))) { return; }
+            } break;
+            case 'p': {
+                if (!writer.put(va_arg(args, void*))) { return; }
+            } break;
+            case 'n': {
+                // writing back through %n makes no sense once formatting happens on another thread
+                (void)va_arg(args, void*);
+            } break;
+            default: return;
+        }
+    }
+}
+
+static void
+decodeArgs(const char* format, PrototypeLoggerReader& reader, std::string& out)
+{
+    PrototypeLoggerSpec spec;
+    const char*         p      = format;
+    const char*         cursor = format;
+    char                specBuffer[64];
+    char                valueBuffer[512];
+    while (true) {
+        bool found = nextSpec(p, spec);
+        // literal text between the previous spec and this one (handles "%%" too)
+        const char* literalEnd = found ? spec.begin : p;
+        for (const char* c = cursor; c < literalEnd; ++c) {
+            if (c[0] == '%' && c[1] == '%') { ++c; }
+            out.push_back(*c);
+        }
+        if (!found) { return; }
+        cursor = spec.end;
+
+        i32 width = 0, precision = 0;
+        if (spec.starWidth && !reader.get(width)) { return; }
+        if (spec.starPrecision && !reader.get(precision)) { return; }
+
+        // rebuild the conversion with the stored widths and without the original length modifier
+        size_t n             = 0;
+        bool   widthResolved = !spec.starWidth;
+        for (const char* c = spec.begin; c < spec.end - 1 && n < sizeof(specBuffer) - 24; ++c) {
+            if (*c == '*') {
+                n += snprintf(specBuffer + n, sizeof(specBuffer) - n, "%d", widthResolved ? precision : width);
+                widthResolved = true;
+            } else if (strchr("hljztL", *c)) {
+                continue;
+            } else {
+                specBuffer[n++] = *c;
+            }
+        }
+
+        int written = 0;
+        switch (spec.conversion) {
+            case 'd':
+            case 'i': {
+                i64 v;
+                if (!reader.get(v)) { return; }
+                specBuffer[n++] = 'l';
+                specBuffer[n++] = 'l';
+                specBuffer[n++] = spec.conversion;
+                specBuffer[n]   = '\0';
+                written         = snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, (long long)v);
+            } break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X': {
+                u64 v;
+                if (!reader.get(v)) { return; }
+                specBuffer[n++] = 'l';
+                specBuffer[n++] = 'l';
+                specBuffer[n++] = spec.conversion;
+                specBuffer[n]   = '\0';
+                written         = snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, (unsigned long long)v);
+            } break;
+            case 'c': {
+                i32 v;
+                if (!reader.get(v)) { return; }
+                specBuffer[n++] = spec.conversion;
+                specBuffer[n]   = '\0';
+                written         = snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, v);
+            } break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A': {
+                f64 v;
+                if (!reader.get(v)) { return; }
+                specBuffer[n++] = spec.conversion;
+                specBuffer[n]   = '\0';
+                written         = snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, v);
+            } break;
+            case 's': {
+                const char* v;
+                if (!reader.getString(v)) { return; }
+                specBuffer[n++] = spec.conversion;
+                specBuffer[n]   = '\0';
+                written         = snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, v);
+            } break;
+            case 'p': {
+                void* v;
+                if (!reader.get(v)) { return; }
+                specBuffer[n++] = spec.conversion;
+                specBuffer[n]   = '\0';
+                written         = snprintf(valueBuffer, sizeof(valueBuffer), specBuffer, v);
+            } break;
+            case 'n': break;
+            default: return;
+        }
+        if (written > 0) { out.append(valueBuffer, std::min((size_t)written, sizeof(valueBuffer) - 1)); }
+    }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// sinks
+// ----------------------------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------------------------
+// PrototypeLoggerData
+// ----------------------------------------------------------------------------------------------------------
+
+PrototypeLoggerData::PrototypeLoggerData()
+  : maxLogsCount(1024)
+  , level(PrototypeLoggerLevel_Trace)
+  , overflowPolicy(PrototypeLoggerOverflowPolicy_Drop)
+  , sinks(PrototypeLoggerSinkMask_Console | PrototypeLoggerSinkMask_Editor)
+  , droppedCount(0)
+  , _numRings(0)
+  , _file(nullptr)
+  , _isRunning(false)
+  , _flushRequested(0)
+  , _flushCompleted(0)
+  , _startTime(std::chrono::steady_clock::now())
+{
+    for (auto& ring : _rings) { ring.store(nullptr, std::memory_order_relaxed); }
+}
+
+PrototypeLoggerData::~PrototypeLoggerData()
+{
+    if (_worker.joinable()) {
+        _isRunning.store(false, std::memory_order_release);
+        _worker.join();
+    }
+    u32 numRings = _numRings.load(std::memory_order_acquire);
+    for (u32 i = 0; i < numRings; ++i) { delete _rings[i].load(std::memory_order_relaxed); }
+    if (_file) { fclose(_file); }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// PrototypeLogger
+// ----------------------------------------------------------------------------------------------------------
+
+PrototypeLoggerRing*
+PrototypeLogger::acquireRing(PrototypeLoggerData* data)
+{
+    if (!data->_isRunning.load(std::memory_order_acquire)) { return nullptr; }
+    if (tRing.owner == data) { return tRing.ring; }
+
+    // first message from this thread, take over the ring of a thread that exited or register a new one
+    std::lock_guard<std::mutex> lock(data->_registerMutex);
+    u32                         numRings = data->_numRings.load(std::memory_order_relaxed);
+    PrototypeLoggerRing*        ring     = nullptr;
+    for (u32 i = 0; i < numRings && !ring; ++i) {
+        PrototypeLoggerRing* candidate = data->_rings[i].load(std::memory_order_relaxed);
+        if (candidate->released.load(std::memory_order_acquire)) {
+            candidate->released.store(false, std::memory_order_relaxed);
+            ring = candidate;
+        }
+    }
+    if (!ring) {
+        if (numRings >= PROTOTYPE_LOGGER_MAX_PRODUCERS) { return nullptr; }
+        ring = PROTOTYPE_NEW PrototypeLoggerRing();
+        data->_rings[numRings].store(ring, std::memory_order_release);
+        data->_numRings.store(numRings + 1, std::memory_order_release);
+    }
+    tRing.ring  = ring;
+    tRing.owner = data;
+    return ring;
+}
+
+void
+PrototypeLogger::sink(PrototypeLoggerData*  data,
+                      PrototypeLoggerLevel_ level,
+                      u64                   timestamp,
+                      const char*           filepath,
+                      int                   line,
+                      const std::string&    text)
+{
+    u32 sinks = data->sinks.load(std::memory_order_relaxed);
+    if (level == PrototypeLoggerLevel_Log) {
+        if (sinks & PrototypeLoggerSinkMask_Editor) {
+            std::string f(filepath ? filepath : "");
+            std::replace(f.begin(), f.end(), '\\', '/');
+            std::lock_guard<std::mutex> lock(data->logsMutex);
+            data->logs.emplace_front(f, line, text);
+            if (data->logs.size() > data->maxLogsCount) { data->logs.pop_back(); }
+        }
+    } else {
+#ifndef PROTOTYPE_TARGET_RELEASE_BUILD
+        if (sinks & PrototypeLoggerSinkMask_Console) {
+            fputs(PrototypeLoggerLevelStatus[level], stdout);
+            fputs(text.c_str(), stdout);
+            fputc('\n', stdout);
+        }
+#endif
+    }
+    if ((sinks & PrototypeLoggerSinkMask_File) && data->_file) {
+        std::lock_guard<std::mutex> lock(data->_fileMutex);
+        if (filepath) {
+            fprintf(data->_file,
+                    "[%12.3f ms] %s%s:%i %s\n",
+                    (f64)timestamp / 1000000.0,
+                    PrototypeLoggerLevelStatus[level],
+                    filepath,
+                    line,
+                    text.c_str());
+        } else {
+            fprintf(data->_file, "[%12.3f ms] %s%s\n", (f64)timestamp / 1000000.0, PrototypeLoggerLevelStatus[level], text.c_str());
+        }
+    }
+}
+
+u64
+PrototypeLogger::now(PrototypeLoggerData* data)
+{
+    return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - data->_startTime)
+      .count();
+}
+
 void
 PrototypeLogger::print(const char* status, const char* message, va_list args)
 {
@@ -34,22 +526,163 @@ PrototypeLogger::print(const char* status, const char* message, va_list args)
 #endif
 }
 
+void
+PrototypeLogger::write(PrototypeLoggerLevel_ level, const char* message, va_list args)
+{
+    if (level < PROTOTYPE_LOGGER_COMPILE_LEVEL) { return; }
+
+    PrototypeLoggerData* data = _data;
+    if (!data) {
+        // no shared data yet (tools, early startup), behave like a plain printf
+        PrototypeLogger::print(PrototypeLoggerLevelStatus[level], message, args);
+        return;
+    }
+    if (level < data->level.load(std::memory_order_relaxed)) { return; }
+
+    PrototypeLoggerRing* ring = PrototypeLogger::acquireRing(data);
+
+    if (!ring) {
+        // the worker isn't running or too many threads are logging, format on the calling thread
+        char buffer[PROTOTYPE_LOGGER_RECORD_SIZE];
+        vsnprintf(buffer, sizeof(buffer), message, args);
+        PrototypeLogger::sink(data, level, PrototypeLogger::now(data), nullptr, 0, buffer);
+        return;
+    }
+
+    u32 head = ring->head.load(std::memory_order_relaxed);
+    while (head - ring->tail.load(std::memory_order_acquire) >= PROTOTYPE_LOGGER_RING_CAPACITY) {
+        if (level < PrototypeLoggerLevel_Fatal &&
+            data->overflowPolicy.load(std::memory_order_relaxed) == PrototypeLoggerOverflowPolicy_Drop) {
+            data->droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::this_thread::yield();
+    }
+
+    PrototypeLoggerRecord& record = ring->records[head & (PROTOTYPE_LOGGER_RING_CAPACITY - 1)];
+    record.timestamp              = PrototypeLogger::now(data);
+    record.format                 = message;
+    record.line                   = 0;
+    record.level                  = (u8)level;
+
+    PrototypeLoggerWriter writer = { record.payload, 0, sizeof(record.payload), false };
+    encodeArgs(message, args, writer);
+    record.payloadSize = (u16)writer.size;
+    record.truncated   = writer.truncated ? 1 : 0;
+
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+bool
+PrototypeLogger::drain(PrototypeLoggerData* data)
+{
+    bool drainedAny = false;
+    u32  numRings   = data->_numRings.load(std::memory_order_acquire);
+    for (u32 i = 0; i < numRings; ++i) {
+        PrototypeLoggerRing* ring = data->_rings[i].load(std::memory_order_acquire);
+        u32                  tail = ring->tail.load(std::memory_order_relaxed);
+        u32                  head = ring->head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            const PrototypeLoggerRecord& record = ring->records[tail & (PROTOTYPE_LOGGER_RING_CAPACITY - 1)];
+            PrototypeLoggerLevel_        level  = (PrototypeLoggerLevel_)record.level;
+            if (record.format) {
+                std::string           text;
+                PrototypeLoggerReader reader = { record.payload, record.payloadSize, 0 };
+                decodeArgs(record.format, reader, text);
+                if (record.truncated) { text.append(" ..."); }
+                PrototypeLogger::sink(data, level, record.timestamp, nullptr, 0, std::move(text));
+            } else {
+                const char* filepath = record.payload;
+                const char* text     = record.payload + strlen(filepath) + 1;
+                PrototypeLogger::sink(data, level, record.timestamp, filepath, record.line, text);
+            }
+            // hand the slot back to the producer only after we're done reading it
+            ring->tail.store(tail + 1, std::memory_order_release);
+            drainedAny = true;
+        }
+    }
+    return drainedAny;
+}
+
+void
+PrototypeLogger::workerProcedure(PrototypeLoggerData* data)
+{
+    u64 droppedReported = 0;
+    while (true) {
+        bool isRunning      = data->_isRunning.load(std::memory_order_acquire);
+        u64  flushRequested = data->_flushRequested.load(std::memory_order_acquire);
+        bool drainedAny     = PrototypeLogger::drain(data);
+        u64  dropped        = data->droppedCount.load(std::memory_order_relaxed);
+        if (dropped != droppedReported) {
+            char buffer[128];
+            snprintf(buffer, sizeof(buffer), "%llu log messages were dropped", (unsigned long long)(dropped - droppedReported));
+            PrototypeLogger::sink(data, PrototypeLoggerLevel_Warn, 0, nullptr, 0, buffer);
+            droppedReported = dropped;
+        }
+        if (data->_file) { fflush(data->_file); }
+        data->_flushCompleted.store(flushRequested, std::memory_order_release);
+        if (!isRunning) { break; }
+        if (!drainedAny) { std::this_thread::sleep_for(std::chrono::microseconds(500)); }
+    }
+    fflush(stdout);
+}
+
 void
 PrototypeLogger::trace(const char* message, ...)
 {
     va_list args;
     va_start(args, message);
-    PrototypeLogger::print("[TRACE] ", message, args);
+    PrototypeLogger::write(PrototypeLoggerLevel_Trace, message, args);
     va_end(args);
 }
 
 void
 PrototypeLogger::log(const char* file, int line, const char* message)
 {
-    std::string f(file);
-    std::replace(f.begin(), f.end(), '\\', '/');
-    _data->logs.emplace_front(f, line, std::string(message));
-    if (_data->logs.size() > _data->maxLogsCount) { _data->logs.pop_back(); }
+    if (PrototypeLoggerLevel_Log < PROTOTYPE_LOGGER_COMPILE_LEVEL) { return; }
+
+    PrototypeLoggerData* data = _data;
+    if (!data || PrototypeLoggerLevel_Log < data->level.load(std::memory_order_relaxed)) { return; }
+
+    PrototypeLoggerRing* ring = PrototypeLogger::acquireRing(data);
+
+    if (!ring) {
+        PrototypeLogger::sink(data, PrototypeLoggerLevel_Log, PrototypeLogger::now(data), file, line, message);
+        return;
+    }
+
+    u32 head = ring->head.load(std::memory_order_relaxed);
+    while (head - ring->tail.load(std::memory_order_acquire) >= PROTOTYPE_LOGGER_RING_CAPACITY) {
+        if (data->overflowPolicy.load(std::memory_order_relaxed) == PrototypeLoggerOverflowPolicy_Drop) {
+            data->droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        std::this_thread::yield();
+    }
+
+    PrototypeLoggerRecord& record = ring->records[head & (PROTOTYPE_LOGGER_RING_CAPACITY - 1)];
+    record.timestamp              = PrototypeLogger::now(data);
+    record.format                 = nullptr;
+    record.line                   = line;
+    record.level                  = PrototypeLoggerLevel_Log;
+
+    // keep the tail of long paths, it's the part that identifies the file
+    const size_t capacity    = sizeof(record.payload);
+    const size_t maxFileSize = capacity / 3;
+    size_t       fileSize    = strlen(file);
+    const char*  fileStart   = fileSize > maxFileSize ? file + (fileSize - maxFileSize) : file;
+    fileSize                 = std::min(fileSize, maxFileSize);
+    memcpy(record.payload, fileStart, fileSize);
+    record.payload[fileSize] = '\0';
+    size_t textCapacity      = capacity - fileSize - 2;
+    size_t textSize          = strlen(message);
+    record.truncated         = textSize > textCapacity ? 1 : 0;
+    textSize                 = std::min(textSize, textCapacity);
+    memcpy(record.payload + fileSize + 1, message, textSize);
+    record.payload[fileSize + 1 + textSize] = '\0';
+    record.payloadSize                      = (u16)(fileSize + textSize + 2);
+
+    ring->head.store(head + 1, std::memory_order_release);
 }
 
 void
@@ -57,7 +690,7 @@ PrototypeLogger::warn(const char* message, ...)
 {
     va_list args;
     va_start(args, message);
-    PrototypeLogger::print("[WARN] ", message, args);
+    PrototypeLogger::write(PrototypeLoggerLevel_Warn, message, args);
     va_end(args);
 }
 
@@ -66,7 +699,7 @@ PrototypeLogger::error(const char* message, ...)
 {
     va_list args;
     va_start(args, message);
-    PrototypeLogger::print("[ERROR] ", message, args);
+    PrototypeLogger::write(PrototypeLoggerLevel_Error, message, args);
     va_end(args);
 }
 
@@ -75,9 +708,12 @@ PrototypeLogger::fatal(const char* message, ...)
 {
     va_list args;
     va_start(args, message);
-    PrototypeLogger::print("[FATAL] ", message, args);
+    PrototypeLogger::write(PrototypeLoggerLevel_Fatal, message, args);
     va_end(args);
 
+    // make sure the message is out before we go down
+    PrototypeLogger::flush();
+
     PROTOTYPE_ASSERT(false)
 }
 
@@ -98,4 +734,72 @@ void
 PrototypeLogger::setData(PrototypeLoggerData* data)
 {
     _data = data;
-}
\ No newline at end of file
+}
+
+void
+PrototypeLogger::startWorker()
+{
+    if (!_data || _data->_worker.joinable()) { return; }
+    _data->_isRunning.store(true, std::memory_order_release);
+    _data->_worker = std::thread(PrototypeLogger::workerProcedure, _data);
+}
+
+void
+PrototypeLogger::stopWorker()
+{
+    if (!_data || !_data->_worker.joinable()) { return; }
+    _data->_isRunning.store(false, std::memory_order_release);
+    _data->_worker.join();
+}
+
+void
+PrototypeLogger::flush()
+{
+    PrototypeLoggerData* data = _data;
+    if (!data || !data->_isRunning.load(std::memory_order_acquire)) {
+        fflush(stdout);
+        return;
+    }
+    u64 ticket = data->_flushRequested.fetch_add(1, std::memory_order_acq_rel) + 1;
+    while (data->_flushCompleted.load(std::memory_order_acquire) < ticket && data->_isRunning.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+bool
+PrototypeLogger::isEnabled(PrototypeLoggerLevel_ level)
+{
+    if (level < PROTOTYPE_LOGGER_COMPILE_LEVEL) { return false; }
+    return !_data || level >= _data->level.load(std::memory_order_relaxed);
+}
+
+void
+PrototypeLogger::setLevel(PrototypeLoggerLevel_ level)
+{
+    if (_data) { _data->level.store(level, std::memory_order_relaxed); }
+}
+
+void
+PrototypeLogger::setOverflowPolicy(PrototypeLoggerOverflowPolicy_ policy)
+{
+    if (_data) { _data->overflowPolicy.store(policy, std::memory_order_relaxed); }
+}
+
+void
+PrototypeLogger::setSinks(u32 sinkMask)
+{
+    if (_data) { _data->sinks.store(sinkMask, std::memory_order_relaxed); }
+}
+
+bool
+PrototypeLogger::setFileSink(const char* path)
+{
+    if (!_data) { return false; }
+    FILE* file = fopen(path, "w");
+    if (!file) { return false; }
+    std::lock_guard<std::mutex> lock(_data->_fileMutex);
+    if (_data->_file) { fclose(_data->_file); }
+    _data->_file = file;
+    _data->sinks.fetch_or(PrototypeLoggerSinkMask_File, std::memory_order_relaxed);
+    return true;
+}
@@ -14,7 +14,15 @@
 
 #include "../include/PrototypeCommon/Maths.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PROTOTYPE_MATHS_SSE
+#define PROTOTYPE_MATHS_LANES
 #include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PROTOTYPE_MATHS_NEON
+#define PROTOTYPE_MATHS_LANES
+#include <arm_neon.h>
+#endif
 
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
@@ -413,6 +421,170 @@ from_json(const nlohmann::json& j, glm::mat4& v)
 }
 // --------------------------------------------------------------------------------------------------
 
+// --------------------------------------------------------------------------------------------------
+// Lanes
+// --------------------------------------------------------------------------------------------------
+// four floats worked on at once, the batched kernels are written against these and run through glm
+// one element at a time where neither sse2 nor neon is available
+#if defined(PROTOTYPE_MATHS_SSE)
+typedef __m128 lane4;
+
+static inline lane4
+laneLoad(const f32* values)
+{
+    return _mm_loadu_ps(values);
+}
+
+static inline void
+laneStore(f32* values, lane4 a)
+{
+    _mm_storeu_ps(values, a);
+}
+
+static inline lane4
+laneSet(f32 a, f32 b, f32 c, f32 d)
+{
+    return _mm_setr_ps(a, b, c, d);
+}
+
+static inline lane4
+laneSplat(f32 a)
+{
+    return _mm_set1_ps(a);
+}
+
+static inline lane4
+laneAdd(lane4 a, lane4 b)
+{
+    return _mm_add_ps(a, b);
+}
+
+static inline lane4
+laneSub(lane4 a, lane4 b)
+{
+    return _mm_sub_ps(a, b);
+}
+
+static inline lane4
+laneMul(lane4 a, lane4 b)
+{
+    return _mm_mul_ps(a, b);
+}
+
+static inline lane4
+laneDiv(lane4 a, lane4 b)
+{
+    return _mm_div_ps(a, b);
+}
+
+template<int i>
+static inline lane4
+laneBroadcast(lane4 a)
+{
+    return _mm_shuffle_ps(a, a, _MM_SHUFFLE(i, i, i, i));
+}
+
+static inline void
+laneTranspose(lane4& a, lane4& b, lane4& c, lane4& d)
+{
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+}
+#elif defined(PROTOTYPE_MATHS_NEON)
+typedef float32x4_t lane4;
+
+static inline lane4
+laneLoad(const f32* values)
+{
+    return vld1q_f32(values);
+}
+
+static inline void
+laneStore(f32* values, lane4 a)
+{
+    vst1q_f32(values, a);
+}
+
+static inline lane4
+laneSet(f32 a, f32 b, f32 c, f32 d)
+{
+    const f32 values[4] = { a, b, c, d };
+    return vld1q_f32(values);
+}
+
+static inline lane4
+laneSplat(f32 a)
+{
+    return vdupq_n_f32(a);
+}
+
+static inline lane4
+laneAdd(lane4 a, lane4 b)
+{
+    return vaddq_f32(a, b);
+}
+
+static inline lane4
+laneSub(lane4 a, lane4 b)
+{
+    return vsubq_f32(a, b);
+}
+
+static inline lane4
+laneMul(lane4 a, lane4 b)
+{
+    return vmulq_f32(a, b);
+}
+
+static inline lane4
+laneDiv(lane4 a, lane4 b)
+{
+    return vdivq_f32(a, b);
+}
+
+template<int i>
+static inline lane4
+laneBroadcast(lane4 a)
+{
+    return vdupq_laneq_f32(a, i);
+}
+
+static inline void
+laneTranspose(lane4& a, lane4& b, lane4& c, lane4& d)
+{
+    const float32x4x2_t ab = vtrnq_f32(a, b);
+    const float32x4x2_t cd = vtrnq_f32(c, d);
+    a                      = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b                      = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c                      = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d                      = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+#endif
+
+#if defined(PROTOTYPE_MATHS_LANES)
+// stores four columns given one lane per matrix, column of models[0] .. models[3]
+static inline void
+laneStoreColumns(glm::mat4* models, int column, lane4 x, lane4 y, lane4 z, lane4 w)
+{
+    laneTranspose(x, y, z, w);
+    laneStore(&models[0][column][0], x);
+    laneStore(&models[1][column][0], y);
+    laneStore(&models[2][column][0], z);
+    laneStore(&models[3][column][0], w);
+}
+
+// loads a column of models[0] .. models[3] as one lane per component
+static inline void
+laneLoadColumns(const glm::mat4* models, int column, lane4& x, lane4& y, lane4& z, lane4& w)
+{
+    x = laneLoad(&models[0][column][0]);
+    y = laneLoad(&models[1][column][0]);
+    z = laneLoad(&models[2][column][0]);
+    w = laneLoad(&models[3][column][0]);
+    laneTranspose(x, y, z, w);
+}
+#endif
+// --------------------------------------------------------------------------------------------------
+
 // --------------------------------------------------------------------------------------------------
 // Free Functions
 // --------------------------------------------------------------------------------------------------
@@ -425,7 +597,7 @@ decomposeModelMatrix(const glm::mat4& model, glm::vec3& position, glm::vec3& rot
     glm::vec3 skew;
     glm::vec4 perspective;
     glm::decompose(model, scale, orientation, position, skew, perspective);
-    rotation = glm::degrees(glm::eulerAngles(orientation));
+    decomposeModelOrientation(orientation, rotation);
 }
 
 extern void
@@ -446,6 +618,193 @@ buildModelMatrixWithScale(glm::mat4& model, const glm::vec3& scale)
     model = glm::scale(model, scale);
 }
 
+extern void
+buildModelOrientation(glm::quat& orientation, const glm::vec3& rotation)
+{
+    static const glm::vec3 right   = glm::vec3(1.0f, 0.0f, 0.0f);
+    static const glm::vec3 up      = glm::vec3(0.0f, 1.0f, 0.0f);
+    static const glm::vec3 forward = glm::vec3(0.0f, 0.0f, 1.0f);
+    const glm::quat        x       = glm::angleAxis(glm::radians(rotation.x), right);
+    const glm::quat        y       = glm::angleAxis(glm::radians(rotation.y), up);
+    const glm::quat        z       = glm::angleAxis(glm::radians(rotation.z), forward);
+    orientation                    = x * y * z;
+}
+
+extern void
+decomposeModelOrientation(const glm::quat& orientation, glm::vec3& rotation)
+{
+    // glm::eulerAngles undoes a z * y * x composition, this one undoes the x * y * z one above,
+    // z comes out of the matrix with the x rotation taken off so it stays well defined when y reaches +-90
+    const glm::mat3 m  = glm::mat3_cast(orientation);
+    const f32       x  = glm::atan(-m[2][1], m[2][2]);
+    const f32       y  = glm::atan(m[2][0], glm::sqrt(m[0][0] * m[0][0] + m[1][0] * m[1][0]));
+    const f32       cx = glm::cos(x);
+    const f32       sx = glm::sin(x);
+    const f32       z  = glm::atan(cx * m[0][1] + sx * m[0][2], cx * m[1][1] + sx * m[1][2]);
+    rotation           = glm::degrees(glm::vec3(x, y, z));
+}
+
+extern void
+composeModelMatrices(glm::mat4*       models,
+                     const glm::vec3* positions,
+                     const glm::quat* orientations,
+                     const glm::vec3* scales,
+                     size_t           count)
+{
+    size_t i = 0;
+#if defined(PROTOTYPE_MATHS_LANES)
+    const lane4 zero = laneSplat(0.0f);
+    const lane4 one  = laneSplat(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        const glm::quat* q  = orientations + i;
+        const glm::vec3* p  = positions + i;
+        const lane4      x  = laneSet(q[0].x, q[1].x, q[2].x, q[3].x);
+        const lane4      y  = laneSet(q[0].y, q[1].y, q[2].y, q[3].y);
+        const lane4      z  = laneSet(q[0].z, q[1].z, q[2].z, q[3].z);
+        const lane4      w  = laneSet(q[0].w, q[1].w, q[2].w, q[3].w);
+        const lane4      x2 = laneAdd(x, x);
+        const lane4      y2 = laneAdd(y, y);
+        const lane4      z2 = laneAdd(z, z);
+        const lane4      xx = laneMul(x, x2);
+        const lane4      yy = laneMul(y, y2);
+        const lane4      zz = laneMul(z, z2);
+        const lane4      xy = laneMul(x, y2);
+        const lane4      xz = laneMul(x, z2);
+        const lane4      yz = laneMul(y, z2);
+        const lane4      wx = laneMul(w, x2);
+        const lane4      wy = laneMul(w, y2);
+        const lane4      wz = laneMul(w, z2);
+        lane4            sx = one;
+        lane4            sy = one;
+        lane4            sz = one;
+        if (scales) {
+            const glm::vec3* s = scales + i;
+            sx                 = laneSet(s[0].x, s[1].x, s[2].x, s[3].x);
+            sy                 = laneSet(s[0].y, s[1].y, s[2].y, s[3].y);
+            sz                 = laneSet(s[0].z, s[1].z, s[2].z, s[3].z);
+        }
+        laneStoreColumns(models + i,
+                         0,
+                         laneMul(laneSub(one, laneAdd(yy, zz)), sx),
+                         laneMul(laneAdd(xy, wz), sx),
+                         laneMul(laneSub(xz, wy), sx),
+                         zero);
+        laneStoreColumns(models + i,
+                         1,
+                         laneMul(laneSub(xy, wz), sy),
+                         laneMul(laneSub(one, laneAdd(xx, zz)), sy),
+                         laneMul(laneAdd(yz, wx), sy),
+                         zero);
+        laneStoreColumns(models + i,
+                         2,
+                         laneMul(laneAdd(xz, wy), sz),
+                         laneMul(laneSub(yz, wx), sz),
+                         laneMul(laneSub(one, laneAdd(xx, yy)), sz),
+                         zero);
+        laneStoreColumns(models + i,
+                         3,
+                         laneSet(p[0].x, p[1].x, p[2].x, p[3].x),
+                         laneSet(p[0].y, p[1].y, p[2].y, p[3].y),
+                         laneSet(p[0].z, p[1].z, p[2].z, p[3].z),
+                         one);
+    }
+#endif
+    for (; i < count; ++i) {
+        glm::mat4 model = glm::mat4_cast(orientations[i]);
+        if (scales) {
+            model[0] *= scales[i].x;
+            model[1] *= scales[i].y;
+            model[2] *= scales[i].z;
+        }
+        model[3]  = glm::vec4(positions[i], 1.0f);
+        models[i] = model;
+    }
+}
+
+extern void
+multiplyMatrices(glm::mat4* results, const glm::mat4* lhs, const glm::mat4* rhs, size_t count)
+{
+    size_t i = 0;
+#if defined(PROTOTYPE_MATHS_LANES)
+    for (; i < count; ++i) {
+        const lane4 a0 = laneLoad(&lhs[i][0][0]);
+        const lane4 a1 = laneLoad(&lhs[i][1][0]);
+        const lane4 a2 = laneLoad(&lhs[i][2][0]);
+        const lane4 a3 = laneLoad(&lhs[i][3][0]);
+        lane4       columns[4];
+        for (int c = 0; c < 4; ++c) {
+            const lane4 b = laneLoad(&rhs[i][c][0]);
+            columns[c]    = laneAdd(laneAdd(laneMul(a0, laneBroadcast<0>(b)), laneMul(a1, laneBroadcast<1>(b))),
+                                 laneAdd(laneMul(a2, laneBroadcast<2>(b)), laneMul(a3, laneBroadcast<3>(b))));
+        }
+        // stored once both inputs are read, results may alias either of them
+        for (int c = 0; c < 4; ++c) { laneStore(&results[i][c][0], columns[c]); }
+    }
+#endif
+    for (; i < count; ++i) { results[i] = lhs[i] * rhs[i]; }
+}
+
+extern void
+invertAffineMatrices(glm::mat4* results, const glm::mat4* models, size_t count)
+{
+    size_t i = 0;
+#if defined(PROTOTYPE_MATHS_LANES)
+    const lane4 zero = laneSplat(0.0f);
+    const lane4 one  = laneSplat(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        lane4 ax, ay, az, aw, bx, by, bz, bw, cx, cy, cz, cw, tx, ty, tz, tw;
+        laneLoadColumns(models + i, 0, ax, ay, az, aw);
+        laneLoadColumns(models + i, 1, bx, by, bz, bw);
+        laneLoadColumns(models + i, 2, cx, cy, cz, cw);
+        laneLoadColumns(models + i, 3, tx, ty, tz, tw);
+        // the rows of the inverse basis are the cross products of the columns over the determinant
+        const lane4 r0x = laneSub(laneMul(by, cz), laneMul(bz, cy));
+        const lane4 r0y = laneSub(laneMul(bz, cx), laneMul(bx, cz));
+        const lane4 r0z = laneSub(laneMul(bx, cy), laneMul(by, cx));
+        const lane4 r1x = laneSub(laneMul(cy, az), laneMul(cz, ay));
+        const lane4 r1y = laneSub(laneMul(cz, ax), laneMul(cx, az));
+        const lane4 r1z = laneSub(laneMul(cx, ay), laneMul(cy, ax));
+        const lane4 r2x = laneSub(laneMul(ay, bz), laneMul(az, by));
+        const lane4 r2y = laneSub(laneMul(az, bx), laneMul(ax, bz));
+        const lane4 r2z = laneSub(laneMul(ax, by), laneMul(ay, bx));
+        const lane4 det = laneAdd(laneAdd(laneMul(ax, r0x), laneMul(ay, r0y)), laneMul(az, r0z));
+        const lane4 inv = laneDiv(one, det);
+        const lane4 i0x = laneMul(r0x, inv);
+        const lane4 i0y = laneMul(r0y, inv);
+        const lane4 i0z = laneMul(r0z, inv);
+        const lane4 i1x = laneMul(r1x, inv);
+        const lane4 i1y = laneMul(r1y, inv);
+        const lane4 i1z = laneMul(r1z, inv);
+        const lane4 i2x = laneMul(r2x, inv);
+        const lane4 i2y = laneMul(r2y, inv);
+        const lane4 i2z = laneMul(r2z, inv);
+        const lane4 itx = laneSub(zero, laneAdd(laneAdd(laneMul(i0x, tx), laneMul(i0y, ty)), laneMul(i0z, tz)));
+        const lane4 ity = laneSub(zero, laneAdd(laneAdd(laneMul(i1x, tx), laneMul(i1y, ty)), laneMul(i1z, tz)));
+        const lane4 itz = laneSub(zero, laneAdd(laneAdd(laneMul(i2x, tx), laneMul(i2y, ty)), laneMul(i2z, tz)));
+        laneStoreColumns(results + i, 0, i0x, i1x, i2x, zero);
+        laneStoreColumns(results + i, 1, i0y, i1y, i2y, zero);
+        laneStoreColumns(results + i, 2, i0z, i1z, i2z, zero);
+        laneStoreColumns(results + i, 3, itx, ity, itz, one);
+    }
+#endif
+    for (; i < count; ++i) {
+        const glm::vec3 a   = models[i][0];
+        const glm::vec3 b   = models[i][1];
+        const glm::vec3 c   = models[i][2];
+        const glm::vec3 t   = models[i][3];
+        const f32       inv = 1.0f / glm::dot(a, glm::cross(b, c));
+        const glm::vec3 r0  = glm::cross(b, c) * inv;
+        const glm::vec3 r1  = glm::cross(c, a) * inv;
+        const glm::vec3 r2  = glm::cross(a, b) * inv;
+        glm::mat4       result;
+        result[0]  = glm::vec4(r0.x, r1.x, r2.x, 0.0f);
+        result[1]  = glm::vec4(r0.y, r1.y, r2.y, 0.0f);
+        result[2]  = glm::vec4(r0.z, r1.z, r2.z, 0.0f);
+        result[3]  = glm::vec4(-glm::dot(r0, t), -glm::dot(r1, t), -glm::dot(r2, t), 1.0f);
+        results[i] = result;
+    }
+}
+
 extern void
 buildTargetViewMatrix(glm::mat4& view, const glm::vec3& position, const glm::vec3& point)
 {
@@ -0,0 +1,528 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#include "../include/PrototypeCommon/MemoryTracker.h"
+#include "../include/PrototypeCommon/StackTrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+#include <windows.h>
+#elif defined(PROTOTYPE_PLATFORM_LINUX) || defined(PROTOTYPE_PLATFORM_DARWIN)
+#include <execinfo.h>
+#endif
+#endif
+
+static std::atomic<u64> gAllocationsCount = { 0 };
+
+#if defined(PROTOTYPE_ENABLE_HEAP_COUNTER) || defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+
+// plain malloc/free underneath so memory can still cross into modules built without the hooks
+
+void*
+operator new(size_t size)
+{
+    gAllocationsCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) { size = 1; }
+    void* ptr = std::malloc(size);
+    if (!ptr) { throw std::bad_alloc(); }
+    PrototypeMemoryTracker::recordAllocation(ptr, size);
+    return ptr;
+}
+
+void*
+operator new[](size_t size)
+{
+    gAllocationsCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) { size = 1; }
+    void* ptr = std::malloc(size);
+    if (!ptr) { throw std::bad_alloc(); }
+    PrototypeMemoryTracker::recordAllocation(ptr, size);
+    return ptr;
+}
+
+void*
+operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    gAllocationsCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) { size = 1; }
+    void* ptr = std::malloc(size);
+    PrototypeMemoryTracker::recordAllocation(ptr, size);
+    return ptr;
+}
+
+void*
+operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    gAllocationsCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) { size = 1; }
+    void* ptr = std::malloc(size);
+    PrototypeMemoryTracker::recordAllocation(ptr, size);
+    return ptr;
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+    PrototypeMemoryTracker::recordFree(ptr);
+    std::free(ptr);
+}
+
+void
+operator delete[](void* ptr) noexcept
+{
+    PrototypeMemoryTracker::recordFree(ptr);
+    std::free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t) noexcept
+{
+    PrototypeMemoryTracker::recordFree(ptr);
+    std::free(ptr);
+}
+
+void
+operator delete[](void* ptr, size_t) noexcept
+{
+    PrototypeMemoryTracker::recordFree(ptr);
+    std::free(ptr);
+}
+
+#endif
+
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+
+#define PROTOTYPE_MEMORY_TRACKER_SHARDS 64
+
+// Every state below is constant initialized, operator new can run before any dynamic initializer.
+// Live allocations are kept in a sharded open addressing table (ptr -> size, tag, call site) that
+// grows with malloc so the tracker never calls back into itself.
+
+struct PrototypeMemoryRecord
+{
+    size_t ptr; // 0 is empty, 1 is a tombstone
+    u64    size;
+    u32    callsite;
+    u32    tag;
+};
+
+struct PrototypeMemoryShard
+{
+    std::mutex             mutex;
+    PrototypeMemoryRecord* slots;
+    size_t                 capacity;
+    size_t                 occupied; // live records and tombstones
+};
+
+struct PrototypeMemoryTagCounters
+{
+    std::atomic<u64> liveBytes;
+    std::atomic<u64> liveAllocations;
+    std::atomic<u64> peakBytes;
+    std::atomic<u64> totalBytes;
+    std::atomic<u64> totalAllocations;
+    u64              sampledBytes;
+    u64              sampledAllocations;
+    f64              bytesPerSecond;
+    f64              allocationsPerSecond;
+};
+
+struct PrototypeMemoryCallsite
+{
+    u64   hash; // 0 is empty
+    void* frames[PROTOTYPE_MEMORY_TRACKER_MAX_FRAMES];
+    u32   numFrames;
+    u32   tag;
+    u64   liveBytes;
+    u64   liveAllocations;
+    u64   totalAllocations;
+};
+
+static PrototypeMemoryShard                  gShards[PROTOTYPE_MEMORY_TRACKER_SHARDS];
+static PrototypeMemoryTagCounters            gTags[PrototypeMemoryTag_Count];
+static PrototypeMemoryCallsite               gCallsites[PROTOTYPE_MEMORY_TRACKER_MAX_CALLSITES];
+static std::mutex                            gCallsitesMutex;
+static std::mutex                            gSampleMutex;
+static std::chrono::steady_clock::time_point gLastSample;
+static std::atomic<bool>                     gCaptureStacks = { false };
+static thread_local u32                      tTag           = PrototypeMemoryTag_Untagged;
+static thread_local bool                     tInside        = false;
+
+static const char* PrototypeMemoryTagNames[PrototypeMemoryTag_Count] = {
+    "Untagged", "Scene", "Meshes", "Textures", "Shaders", "Renderer", "Physics", "Scripts", "Editor"
+};
+
+static u64
+hashPointer(size_t ptr)
+{
+    return ((u64)ptr >> 4) * 0x9E3779B97F4A7C15ull;
+}
+
+static bool
+shardInsert(PrototypeMemoryShard& shard, const PrototypeMemoryRecord& record)
+{
+    if ((shard.occupied + 1) * 2 > shard.capacity) {
+        // rehash into a table sized for the live records only, tombstones are dropped on the way
+        size_t live = 0;
+        for (size_t i = 0; i < shard.capacity; ++i) { live += shard.slots[i].ptr > 1 ? 1 : 0; }
+        size_t capacity = 1024;
+        while (capacity < (live + 1) * 4) { capacity *= 2; }
+        PrototypeMemoryRecord* slots    = (PrototypeMemoryRecord*)std::calloc(capacity, sizeof(PrototypeMemoryRecord));
+        if (!slots) { return false; }
+        size_t occupied = 0;
+        for (size_t i = 0; i < shard.capacity; ++i) {
+            const PrototypeMemoryRecord& old = shard.slots[i];
+            if (old.ptr <= 1) { continue; }
+            size_t index = (size_t)hashPointer(old.ptr) & (capacity - 1);
+            while (slots[index].ptr != 0) { index = (index + 1) & (capacity - 1); }
+            slots[index] = old;
+            ++occupied;
+        }
+        std::free(shard.slots);
+        shard.slots    = slots;
+        shard.capacity = capacity;
+        shard.occupied = occupied;
+    }
+    size_t index = (size_t)hashPointer(record.ptr) & (shard.capacity - 1);
+    while (shard.slots[index].ptr > 1) { index = (index + 1) & (shard.capacity - 1); }
+    if (shard.slots[index].ptr == 0) { ++shard.occupied; }
+    shard.slots[index] = record;
+    return true;
+}
+
+static bool
+shardErase(PrototypeMemoryShard& shard, size_t ptr, PrototypeMemoryRecord& record)
+{
+    if (shard.capacity == 0) { return false; }
+    size_t index = (size_t)hashPointer(ptr) & (shard.capacity - 1);
+    while (shard.slots[index].ptr != 0) {
+        if (shard.slots[index].ptr == ptr) {
+            record                 = shard.slots[index];
+            shard.slots[index].ptr = 1;
+            return true;
+        }
+        index = (index + 1) & (shard.capacity - 1);
+    }
+    return false;
+}
+
+static u32
+captureCallsite(u32 tag, u64 size)
+{
+    void* frames[PROTOTYPE_MEMORY_TRACKER_MAX_FRAMES + 2];
+    u32   numFrames = 0;
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+    numFrames = RtlCaptureStackBackTrace(2, PROTOTYPE_MEMORY_TRACKER_MAX_FRAMES, frames, nullptr);
+#elif defined(PROTOTYPE_PLATFORM_LINUX) || defined(PROTOTYPE_PLATFORM_DARWIN)
+    int captured = backtrace(frames, PROTOTYPE_MEMORY_TRACKER_MAX_FRAMES + 2);
+    // skip captureCallsite and recordAllocation
+    numFrames = captured > 2 ? (u32)captured - 2 : 0;
+    memmove(frames, frames + 2, numFrames * sizeof(void*));
+#endif
+    if (numFrames == 0) { return PROTOTYPE_MEMORY_TRACKER_INVALID_SITE; }
+
+    u64 hash = 14695981039346656037ull;
+    for (u32 i = 0; i < numFrames; ++i) { hash = (hash ^ (u64)(size_t)frames[i]) * 1099511628211ull; }
+    if (hash == 0) { hash = 1; }
+
+    std::lock_guard<std::mutex> lock(gCallsitesMutex);
+    u32                         index = (u32)(hash & (PROTOTYPE_MEMORY_TRACKER_MAX_CALLSITES - 1));
+    for (u32 probe = 0; probe < PROTOTYPE_MEMORY_TRACKER_MAX_CALLSITES; ++probe) {
+        PrototypeMemoryCallsite& callsite = gCallsites[index];
+        if (callsite.hash == 0) {
+            callsite.hash      = hash;
+            callsite.numFrames = numFrames;
+            callsite.tag       = tag;
+            memcpy(callsite.frames, frames, numFrames * sizeof(void*));
+        }
+        if (callsite.hash == hash && callsite.numFrames == numFrames &&
+            memcmp(callsite.frames, frames, numFrames * sizeof(void*)) == 0) {
+            callsite.liveBytes += size;
+            callsite.liveAllocations += 1;
+            callsite.totalAllocations += 1;
+            return index;
+        }
+        index = (index + 1) & (PROTOTYPE_MEMORY_TRACKER_MAX_CALLSITES - 1);
+    }
+    // table is full, the allocation is still accounted for in its tag
+    return PROTOTYPE_MEMORY_TRACKER_INVALID_SITE;
+}
+
+static void
+writeFrame(FILE* file, void* frame)
+{
+    char text[512];
+    PrototypeStackTrace::describeFrame(frame, text, sizeof(text));
+    fputc('"', file);
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') { fputc('\\', file); }
+        fputc(*c, file);
+    }
+    fputc('"', file);
+}
+
+#endif // #if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+
+bool
+PrototypeMemoryTracker::enabled()
+{
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void
+PrototypeMemoryTracker::recordAllocation(void* ptr, size_t size)
+{
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    if (!ptr || tInside) { return; }
+    tInside = true;
+
+    PrototypeMemoryRecord record = {};
+    record.ptr                   = (size_t)ptr;
+    record.size                  = size;
+    record.tag                   = tTag;
+    record.callsite              = PROTOTYPE_MEMORY_TRACKER_INVALID_SITE;
+    if (gCaptureStacks.load(std::memory_order_relaxed)) { record.callsite = captureCallsite(record.tag, size); }
+
+    PrototypeMemoryShard& shard = gShards[hashPointer(record.ptr) >> 58];
+    bool                  inserted;
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        inserted = shardInsert(shard, record);
+    }
+    if (!inserted) {
+        tInside = false;
+        return;
+    }
+
+    PrototypeMemoryTagCounters& counters = gTags[record.tag];
+    u64                         live     = counters.liveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    counters.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+    counters.totalBytes.fetch_add(size, std::memory_order_relaxed);
+    counters.totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    u64 peak = counters.peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+
+    tInside = false;
+#else
+    (void)ptr;
+    (void)size;
+#endif
+}
+
+void
+PrototypeMemoryTracker::recordFree(void* ptr)
+{
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    if (!ptr || tInside) { return; }
+
+    PrototypeMemoryRecord record = {};
+    PrototypeMemoryShard& shard  = gShards[hashPointer((size_t)ptr) >> 58];
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        // allocated by a module without the hooks, or before tracking could record it
+        if (!shardErase(shard, (size_t)ptr, record)) { return; }
+    }
+
+    PrototypeMemoryTagCounters& counters = gTags[record.tag];
+    counters.liveBytes.fetch_sub(record.size, std::memory_order_relaxed);
+    counters.liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+
+    if (record.callsite != PROTOTYPE_MEMORY_TRACKER_INVALID_SITE) {
+        std::lock_guard<std::mutex> lock(gCallsitesMutex);
+        PrototypeMemoryCallsite&    callsite = gCallsites[record.callsite];
+        callsite.liveBytes -= record.size;
+        callsite.liveAllocations -= 1;
+    }
+#else
+    (void)ptr;
+#endif
+}
+
+PrototypeMemoryTag_
+PrototypeMemoryTracker::setTag(PrototypeMemoryTag_ tag)
+{
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    PrototypeMemoryTag_ previous = (PrototypeMemoryTag_)tTag;
+    tTag                         = tag;
+    return previous;
+#else
+    (void)tag;
+    return PrototypeMemoryTag_Untagged;
+#endif
+}
+
+PrototypeMemoryTag_
+PrototypeMemoryTracker::tag()
+{
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    return (PrototypeMemoryTag_)tTag;
+#else
+    return PrototypeMemoryTag_Untagged;
+#endif
+}
+
+const char*
+PrototypeMemoryTracker::tagName(PrototypeMemoryTag_ tag)
+{
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    return tag < PrototypeMemoryTag_Count ? PrototypeMemoryTagNames[tag] : "Unknown";
+#else
+    (void)tag;
+    return "Untagged";
+#endif
+}
+
+void
+PrototypeMemoryTracker::setCaptureStacks(bool status)
+{
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    gCaptureStacks.store(status, std::memory_order_relaxed);
+#else
+    (void)status;
+#endif
+}
+
+u64
+PrototypeMemoryTracker::allocationsCount()
+{
+    return gAllocationsCount.load(std::memory_order_relaxed);
+}
+
+void
+PrototypeMemoryTracker::sample()
+{
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    std::lock_guard<std::mutex> lock(gSampleMutex);
+    auto                        now     = std::chrono::steady_clock::now();
+    f64                         seconds = std::chrono::duration<f64>(now - gLastSample).count();
+    bool                        first   = gLastSample.time_since_epoch().count() == 0;
+    gLastSample                         = now;
+    for (PrototypeMemoryTagCounters& counters : gTags) {
+        u64 bytes       = counters.totalBytes.load(std::memory_order_relaxed);
+        u64 allocations = counters.totalAllocations.load(std::memory_order_relaxed);
+        if (!first && seconds > 0.0) {
+            counters.bytesPerSecond       = (f64)(bytes - counters.sampledBytes) / seconds;
+            counters.allocationsPerSecond = (f64)(allocations - counters.sampledAllocations) / seconds;
+        }
+        counters.sampledBytes       = bytes;
+        counters.sampledAllocations = allocations;
+    }
+#endif
+}
+
+PrototypeMemoryTagStats
+PrototypeMemoryTracker::stats(PrototypeMemoryTag_ tag)
+{
+    PrototypeMemoryTagStats stats = {};
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    if (tag >= PrototypeMemoryTag_Count) { return stats; }
+    const PrototypeMemoryTagCounters& counters = gTags[tag];
+    stats.liveBytes                            = counters.liveBytes.load(std::memory_order_relaxed);
+    stats.liveAllocations                      = counters.liveAllocations.load(std::memory_order_relaxed);
+    stats.peakBytes                            = counters.peakBytes.load(std::memory_order_relaxed);
+    stats.totalBytes                           = counters.totalBytes.load(std::memory_order_relaxed);
+    stats.totalAllocations                     = counters.totalAllocations.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(gSampleMutex);
+    stats.bytesPerSecond       = counters.bytesPerSecond;
+    stats.allocationsPerSecond = counters.allocationsPerSecond;
+#else
+    (void)tag;
+#endif
+    return stats;
+}
+
+bool
+PrototypeMemoryTracker::writeSnapshot(const char* path, u32 maxCallsites)
+{
+#if defined(PROTOTYPE_ENABLE_MEMORY_TRACKER)
+    FILE* file = fopen(path, "w");
+    if (!file) { return false; }
+
+    // the snapshot's own allocations are left out of the picture
+    bool wasInside = tInside;
+    tInside        = true;
+
+    fputs("{\n  \"tags\": [", file);
+    for (u32 t = 0; t < PrototypeMemoryTag_Count; ++t) {
+        PrototypeMemoryTagStats s = stats((PrototypeMemoryTag_)t);
+        fprintf(file,
+                "%s\n    { \"name\": \"%s\", \"liveBytes\": %llu, \"liveAllocations\": %llu, \"peakBytes\": %llu, "
+                "\"totalBytes\": %llu, \"totalAllocations\": %llu, \"bytesPerSecond\": %.1f, \"allocationsPerSecond\": %.1f }",
+                t == 0 ? "" : ",",
+                PrototypeMemoryTagNames[t],
+                (unsigned long long)s.liveBytes,
+                (unsigned long long)s.liveAllocations,
+                (unsigned long long)s.peakBytes,
+                (unsigned long long)s.totalBytes,
+                (unsigned long long)s.totalAllocations,
+                s.bytesPerSecond,
+                s.allocationsPerSecond);
+    }
+    fputs("\n  ],\n  \"callsites\": [", file);
+
+    std::vector<PrototypeMemoryCallsite> callsites(PROTOTYPE_MEMORY_TRACKER_MAX_CALLSITES);
+    size_t                               numCallsites = 0;
+    {
+        std::lock_guard<std::mutex> lock(gCallsitesMutex);
+        for (const PrototypeMemoryCallsite& callsite : gCallsites) {
+            if (callsite.hash != 0 && callsite.liveBytes > 0) { callsites[numCallsites++] = callsite; }
+        }
+    }
+    callsites.resize(numCallsites);
+    std::sort(callsites.begin(), callsites.end(), [](const PrototypeMemoryCallsite& a, const PrototypeMemoryCallsite& b) {
+        return a.liveBytes > b.liveBytes;
+    });
+    if (callsites.size() > maxCallsites) { callsites.resize(maxCallsites); }
+
+    for (size_t c = 0; c < callsites.size(); ++c) {
+        const PrototypeMemoryCallsite& callsite = callsites[c];
+        fprintf(file,
+                "%s\n    { \"tag\": \"%s\", \"liveBytes\": %llu, \"liveAllocations\": %llu, \"totalAllocations\": %llu, "
+                "\"frames\": [",
+                c == 0 ? "" : ",",
+                PrototypeMemoryTagNames[callsite.tag],
+                (unsigned long long)callsite.liveBytes,
+                (unsigned long long)callsite.liveAllocations,
+                (unsigned long long)callsite.totalAllocations);
+        for (u32 f = 0; f < callsite.numFrames; ++f) {
+            if (f > 0) { fputs(", ", file); }
+            writeFrame(file, callsite.frames[f]);
+        }
+        fputs("] }", file);
+    }
+    fputs("\n  ]\n}\n", file);
+    fclose(file);
+
+    tInside = wasInside;
+    return true;
+#else
+    (void)path;
+    (void)maxCallsites;
+    return false;
+#endif
+}
@@ -0,0 +1,58 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#include "../include/PrototypeCommon/StackTrace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+#include <windows.h>
+#elif defined(PROTOTYPE_PLATFORM_LINUX) || defined(PROTOTYPE_PLATFORM_DARWIN)
+#include <dlfcn.h>
+#endif
+
+void
+PrototypeStackTrace::describeFrame(void* frame, char* text, size_t size)
+{
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+    HMODULE module = nullptr;
+    char    modulePath[MAX_PATH];
+    if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           (LPCSTR)frame,
+                           &module) &&
+        GetModuleFileNameA(module, modulePath, MAX_PATH)) {
+        const char* moduleName = strrchr(modulePath, '\\');
+        snprintf(text, size, "%s+0x%zx", moduleName ? moduleName + 1 : modulePath, (size_t)frame - (size_t)module);
+    } else {
+        snprintf(text, size, "0x%zx", (size_t)frame);
+    }
+#elif defined(PROTOTYPE_PLATFORM_LINUX) || defined(PROTOTYPE_PLATFORM_DARWIN)
+    Dl_info info;
+    if (dladdr(frame, &info) && info.dli_fname) {
+        const char* moduleName = strrchr(info.dli_fname, '/');
+        moduleName             = moduleName ? moduleName + 1 : info.dli_fname;
+        if (info.dli_sname) {
+            snprintf(text, size, "%s (%s+0x%zx)", info.dli_sname, moduleName, (size_t)frame - (size_t)info.dli_fbase);
+        } else {
+            snprintf(text, size, "%s+0x%zx", moduleName, (size_t)frame - (size_t)info.dli_fbase);
+        }
+    } else {
+        snprintf(text, size, "0x%zx", (size_t)frame);
+    }
+#else
+    snprintf(text, size, "0x%zx", (size_t)frame);
+#endif
+}
@@ -0,0 +1,371 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#include "../include/PrototypeCommon/Tracer.h"
+#include "../include/PrototypeCommon/Logger.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#if defined(PROTOTYPE_TRACER_USE_TSC)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+static_assert((PROTOTYPE_TRACER_EVENTS_PER_THREAD & (PROTOTYPE_TRACER_EVENTS_PER_THREAD - 1)) == 0,
+              "tracer ring capacity must be a power of 2");
+
+// Single producer ring, only the owning thread writes events and bumps head.
+// Readers copy a window of events then read head again to discard whatever got overwritten meanwhile.
+struct PrototypeTracerBuffer
+{
+    alignas(64) std::atomic<u64> head = { 0 };
+    std::thread::id              threadId;
+    char                         threadName[64];
+    PrototypeTracerEvent         events[PROTOTYPE_TRACER_EVENTS_PER_THREAD];
+};
+
+static thread_local PrototypeTracerBuffer* tBuffer      = nullptr;
+static thread_local PrototypeTracerData*   tBufferOwner = nullptr;
+
+PrototypeTracerData* PrototypeTracer::_data = nullptr;
+
+static void
+writeJsonString(FILE* file, const char* str)
+{
+    fputc('"', file);
+    for (const char* c = str; *c; ++c) {
+        switch (*c) {
+            case '"': fputs("\\\"", file); break;
+            case '\\': fputs("\\\\", file); break;
+            case '\n': fputs("\\n", file); break;
+            case '\t': fputs("\\t", file); break;
+            default: {
+                if ((u8)*c < 0x20) {
+                    fprintf(file, "\\u%04x", (u32)(u8)*c);
+                } else {
+                    fputc(*c, file);
+                }
+            } break;
+        }
+    }
+    fputc('"', file);
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// PrototypeTracerData
+// ----------------------------------------------------------------------------------------------------------
+
+PrototypeTracerData::PrototypeTracerData()
+  : enabled(true)
+  , _numBuffers(0)
+  , _frame(0)
+  , _startTicks(PrototypeTracer::ticks())
+  , _startTime(std::chrono::steady_clock::now())
+{
+    for (auto& buffer : _buffers) { buffer.store(nullptr, std::memory_order_relaxed); }
+}
+
+PrototypeTracerData::~PrototypeTracerData()
+{
+    u32 numBuffers = _numBuffers.load(std::memory_order_acquire);
+    for (u32 i = 0; i < numBuffers; ++i) { delete _buffers[i].load(std::memory_order_relaxed); }
+}
+
+// ----------------------------------------------------------------------------------------------------------
+// PrototypeTracer
+// ----------------------------------------------------------------------------------------------------------
+
+PrototypeTracerData*
+PrototypeTracer::data()
+{
+    return _data;
+}
+
+void
+PrototypeTracer::setData(PrototypeTracerData* data)
+{
+    _data = data;
+}
+
+bool
+PrototypeTracer::isEnabled()
+{
+    return _data && _data->enabled.load(std::memory_order_relaxed);
+}
+
+void
+PrototypeTracer::setEnabled(bool status)
+{
+    if (_data) { _data->enabled.store(status, std::memory_order_relaxed); }
+}
+
+u32
+PrototypeTracer::registerZone(const char* name, const char* file, u32 line)
+{
+    return registerDescriptor(name, file, line, PrototypeTracerEventType_ZoneBegin);
+}
+
+u32
+PrototypeTracer::registerCounter(const char* name)
+{
+    return registerDescriptor(name, "", 0, PrototypeTracerEventType_Counter);
+}
+
+void
+PrototypeTracer::setThreadName(const char* name)
+{
+    if (!_data) { return; }
+    PrototypeTracerBuffer* buffer = acquireBuffer(_data);
+    if (!buffer) { return; }
+    strncpy(buffer->threadName, name, sizeof(buffer->threadName) - 1);
+    buffer->threadName[sizeof(buffer->threadName) - 1] = '\0';
+}
+
+bool
+PrototypeTracer::beginZone(u32 id)
+{
+    PrototypeTracerData* data = _data;
+    if (!data || id == PROTOTYPE_TRACER_INVALID_ID || !data->enabled.load(std::memory_order_relaxed)) { return false; }
+    emit(data, PrototypeTracerEventType_ZoneBegin, id, 0);
+    return true;
+}
+
+void
+PrototypeTracer::endZone(u32 id)
+{
+    // always recorded, even when tracing got disabled inside the zone, so begin/end pairs stay balanced
+    if (_data) { emit(_data, PrototypeTracerEventType_ZoneEnd, id, 0); }
+}
+
+void
+PrototypeTracer::counter(u32 id, i64 value)
+{
+    PrototypeTracerData* data = _data;
+    if (!data || id == PROTOTYPE_TRACER_INVALID_ID || !data->enabled.load(std::memory_order_relaxed)) { return; }
+    emit(data, PrototypeTracerEventType_Counter, id, value);
+}
+
+void
+PrototypeTracer::frame()
+{
+    PrototypeTracerData* data = _data;
+    if (!data) { return; }
+    u64 frame = data->_frame.fetch_add(1, std::memory_order_relaxed);
+    if (data->enabled.load(std::memory_order_relaxed)) {
+        emit(data, PrototypeTracerEventType_Frame, PROTOTYPE_TRACER_INVALID_ID, (i64)frame);
+    }
+}
+
+u64
+PrototypeTracer::ticks()
+{
+#if defined(PROTOTYPE_TRACER_USE_TSC)
+    return __rdtsc();
+#else
+    return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
+bool
+PrototypeTracer::exportChromeTrace(const char* path)
+{
+    PrototypeTracerData* data = _data;
+    if (!data) { return false; }
+
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        PrototypeLogger::warn("Couldn't open trace file <%s> for writing", path);
+        return false;
+    }
+
+    // calibrate ticks against wall time, only really needed for the tsc but the math is the same
+    u64 endTicks = ticks();
+    f64 elapsedUs =
+      (f64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - data->_startTime).count() /
+      1000.0;
+    f64 ticksPerUs = elapsedUs > 0.0 ? (f64)(endTicks - data->_startTicks) / elapsedUs : 1000.0;
+    if (ticksPerUs <= 0.0) { ticksPerUs = 1000.0; }
+
+    std::vector<PrototypeTracerDescriptor> descriptors;
+    std::vector<PrototypeTracerEvent>      events;
+    std::vector<bool>                      open; // one entry per open zone, false for the begins that weren't written
+    u32                                    numBuffers;
+    {
+        std::lock_guard<std::mutex> lock(data->_registerMutex);
+        descriptors.assign(data->_descriptors.begin(), data->_descriptors.end());
+        numBuffers = data->_numBuffers.load(std::memory_order_acquire);
+    }
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+    fputs("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Prototype\"}}", file);
+
+    for (u32 t = 0; t < numBuffers; ++t) {
+        PrototypeTracerBuffer* buffer = data->_buffers[t].load(std::memory_order_acquire);
+        u32                    tid    = t + 1;
+
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", tid);
+        writeJsonString(file, buffer->threadName[0] ? buffer->threadName : "Thread");
+        fputs("}}", file);
+
+        u64 head  = buffer->head.load(std::memory_order_acquire);
+        u64 first = head > PROTOTYPE_TRACER_EVENTS_PER_THREAD ? head - PROTOTYPE_TRACER_EVENTS_PER_THREAD : 0;
+        events.resize((size_t)(head - first));
+        for (u64 i = first; i < head; ++i) {
+            events[(size_t)(i - first)] = buffer->events[i & (PROTOTYPE_TRACER_EVENTS_PER_THREAD - 1)];
+        }
+        // the owner kept recording while we copied, drop the slots it may have overwritten
+        u64 headAfter = buffer->head.load(std::memory_order_acquire);
+        u64 valid     = headAfter > PROTOTYPE_TRACER_EVENTS_PER_THREAD ? headAfter - PROTOTYPE_TRACER_EVENTS_PER_THREAD : 0;
+        size_t skip   = valid > first ? (size_t)(valid - first) : 0;
+
+        open.clear();
+        for (size_t i = skip; i < events.size(); ++i) {
+            const PrototypeTracerEvent& event = events[i];
+            f64                         ts    = (f64)(event.ticks - data->_startTicks) / ticksPerUs;
+            switch (event.type) {
+                case PrototypeTracerEventType_ZoneBegin: {
+                    // its end still has to pop it, or it would close the parent zone
+                    open.push_back(event.descriptor < descriptors.size());
+                    if (!open.back()) { continue; }
+                    const PrototypeTracerDescriptor& descriptor = descriptors[event.descriptor];
+                    fputs(",\n{\"name\":", file);
+                    writeJsonString(file, descriptor.name.c_str());
+                    fprintf(file, ",\"cat\":\"zone\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"file\":", ts, tid);
+                    writeJsonString(file, descriptor.file.c_str());
+                    fprintf(file, ",\"line\":%u}}", descriptor.line);
+                } break;
+                case PrototypeTracerEventType_ZoneEnd: {
+                    // its begin event was overwritten by the ring
+                    if (open.empty()) { continue; }
+                    const bool written = open.back();
+                    open.pop_back();
+                    if (!written) { continue; }
+                    fprintf(file, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}", ts, tid);
+                } break;
+                case PrototypeTracerEventType_Counter: {
+                    if (event.descriptor >= descriptors.size()) { continue; }
+                    fputs(",\n{\"name\":", file);
+                    writeJsonString(file, descriptors[event.descriptor].name.c_str());
+                    fprintf(file,
+                            ",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%lld}}",
+                            ts,
+                            tid,
+                            (long long)event.value);
+                } break;
+                case PrototypeTracerEventType_Frame: {
+                    fprintf(file,
+                            ",\n{\"name\":\"Frame %lld\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+                            (long long)event.value,
+                            ts,
+                            tid);
+                } break;
+            }
+        }
+    }
+
+    fputs("\n]}\n", file);
+    fclose(file);
+    return true;
+}
+
+f64
+PrototypeTracer::measureZoneOverhead(u32 iterations)
+{
+    PrototypeTracerData* data = _data;
+    if (!data || iterations == 0) { return 0.0; }
+    PrototypeTracerBuffer* buffer = acquireBuffer(data);
+    if (!buffer) { return 0.0; }
+
+    static const u32 id         = registerZone("PrototypeTracer::measureZoneOverhead", __FILE__, __LINE__);
+    bool             wasEnabled = data->enabled.exchange(true, std::memory_order_relaxed);
+    u64              head       = buffer->head.load(std::memory_order_relaxed);
+
+    auto t1 = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < iterations; ++i) { PrototypeTracerScope scope(id); }
+    auto t2 = std::chrono::steady_clock::now();
+
+    // forget the measurement events, they would only flood the trace
+    buffer->head.store(head, std::memory_order_release);
+    data->enabled.store(wasEnabled, std::memory_order_relaxed);
+
+    return (f64)std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() / (f64)iterations;
+}
+
+PrototypeTracerBuffer*
+PrototypeTracer::acquireBuffer(PrototypeTracerData* data)
+{
+    if (tBufferOwner == data) { return tBuffer; }
+
+    // first event from this thread (in this module), plugins share the buffer of the thread if it already has one
+    std::thread::id             threadId = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(data->_registerMutex);
+    u32                         numBuffers = data->_numBuffers.load(std::memory_order_relaxed);
+    PrototypeTracerBuffer*      buffer     = nullptr;
+    for (u32 i = 0; i < numBuffers; ++i) {
+        PrototypeTracerBuffer* candidate = data->_buffers[i].load(std::memory_order_relaxed);
+        if (candidate->threadId == threadId) {
+            buffer = candidate;
+            break;
+        }
+    }
+    if (!buffer) {
+        if (numBuffers >= PROTOTYPE_TRACER_MAX_THREADS) { return nullptr; }
+        buffer                = PROTOTYPE_NEW PrototypeTracerBuffer();
+        buffer->threadId      = threadId;
+        buffer->threadName[0] = '\0';
+        data->_buffers[numBuffers].store(buffer, std::memory_order_release);
+        data->_numBuffers.store(numBuffers + 1, std::memory_order_release);
+    }
+    tBuffer      = buffer;
+    tBufferOwner = data;
+    return buffer;
+}
+
+void
+PrototypeTracer::emit(PrototypeTracerData* data, u32 type, u32 descriptor, i64 value)
+{
+    PrototypeTracerBuffer* buffer = tBufferOwner == data ? tBuffer : acquireBuffer(data);
+    if (!buffer) { return; }
+    u64                   head  = buffer->head.load(std::memory_order_relaxed);
+    PrototypeTracerEvent& event = buffer->events[head & (PROTOTYPE_TRACER_EVENTS_PER_THREAD - 1)];
+    event.ticks                 = ticks();
+    event.value                 = value;
+    event.descriptor            = descriptor;
+    event.type                  = type;
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+u32
+PrototypeTracer::registerDescriptor(const char* name, const char* file, u32 line, PrototypeTracerEventType_ type)
+{
+    // call sites hit before the data was set stay silent
+    PrototypeTracerData* data = _data;
+    if (!data) { return PROTOTYPE_TRACER_INVALID_ID; }
+
+    std::lock_guard<std::mutex> lock(data->_registerMutex);
+    PrototypeTracerDescriptor   descriptor = {};
+    descriptor.name                        = name;
+    descriptor.file                        = file;
+    descriptor.line                        = line;
+    descriptor.type                        = type;
+    data->_descriptors.push_back(std::move(descriptor));
+    return (u32)(data->_descriptors.size() - 1);
+}
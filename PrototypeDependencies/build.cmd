@@ -6,6 +6,14 @@ cmake --build . --config Debug
 cmake --build . --config Release
 cd ../../
 
+cd bullet3
+mkdir build
+cd build
+cmake -DBUILD_SHARED_LIBS=OFF -DUSE_MSVC_RUNTIME_LIBRARY_DLL=ON -DBULLET2_MULTITHREADING=ON -DCMAKE_DEBUG_POSTFIX= -DBUILD_BULLET2_DEMOS=OFF -DBUILD_CPU_DEMOS=OFF -DBUILD_OPENGL3_DEMOS=OFF -DBUILD_EXTRAS=OFF -DBUILD_UNIT_TESTS=OFF -DINSTALL_LIBS=OFF ..
+cmake --build . --config Debug
+cmake --build . --config Release
+cd ../../
+
 cd glfw
 mkdir build
 cd build
@@ -2,6 +2,10 @@ cd assimp
 rmdir build /Q /S
 cd ../
 
+cd bullet3
+rmdir build /Q /S
+cd ../
+
 cd glfw
 rmdir build /Q /S
 cd ../
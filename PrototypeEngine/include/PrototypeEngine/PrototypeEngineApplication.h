@@ -38,6 +38,22 @@ PROTOTYPE_EXTERN struct PROTOTYPE_ENGINE_API PrototypeEngineApplication
     OnEndFn      onEndFn;
 };
 
+// optional overrides for tools that drive the engine unattended (PrototypeBench)
+PROTOTYPE_EXTERN struct PROTOTYPE_ENGINE_API PrototypeEngineRunOptions
+{
+    std::string sceneName;     // replaces the "DefaultScene" settings field when not empty
+    std::string physicsApi;    // replaces the "DefaultPhysicsApi" settings field when not empty (PHYSX, BULLET)
+    u32         maxFrames;     // the loop quits on its own after that many frames, 0 runs until the window closes
+    bool        headless;      // hidden window and no vsync
+    bool        loadPlugins;   // load the plugins found in the plugins folder before looping
+    bool        measureStages; // keep per frame stage timings, see PrototypeRecorder
+    bool        lockstep;      // forces the "Lockstep" settings on, one fixed physics step per frame
+};
+
+// call before PrototypeEngineInit
+PROTOTYPE_EXTERN PROTOTYPE_ENGINE_API void
+PrototypeEngineSetRunOptions(const PrototypeEngineRunOptions& options);
+
 PROTOTYPE_EXTERN PROTOTYPE_ENGINE_API bool
 PrototypeEngineInit(const PrototypeEngineApplication& application);
 
@@ -12,42 +12,655 @@
 /// See the License for the specific language governing permissions and
 /// limitations under the License.
 
+
 #include "PrototypeBulletPhysics.h"
 
+#include "../core/PrototypeDatabase.h"
+#include "../core/PrototypeMeshBuffer.h"
+#include "../core/PrototypeSceneNode.h"
+
 #include "../core/PrototypeEngine.h"
 #include "../core/PrototypeRenderer.h"
-#include "../core/PrototypeShortcuts.h"
-
 #include "../core/PrototypeScene.h"
+#include "../core/PrototypeShortcuts.h"
+#include "../core/PrototypeWindow.h"
 
 #include <PrototypeTraitSystem/PrototypeTraitSystem.h>
 
 #include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/MemoryTracker.h>
+
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+// same surface as the physx default material (friction, restitution)
+static const btScalar gMaterialFriction    = 0.5f;
+static const btScalar gMaterialRestitution = 0.6f;
+
+// vehicle dimensions follow the physx 4 wheels drive snippet so both backends drive the same car
+static const btVector3 gVehicleChasisHalfExtents(1.19f, 0.7845f, 2.825f);
+static const btScalar  gVehicleChasisMass     = 1000.0f;
+static const btScalar  gVehicleWheelRadius    = 0.55f;
+static const btScalar  gVehicleWheelWidth     = 0.344f;
+static const btScalar  gVehicleSuspensionRest = 0.6f;
+static const btScalar  gVehicleMaxEngineForce = 6000.0f;
+static const btScalar  gVehicleMaxBrakeForce  = 150.0f;
+static const btScalar  gVehicleMaxSteer       = 0.5f;
+static const int       gVehicleFrontWheels[2] = { 0, 1 }; // FR, FL
+static const int       gVehicleRearWheels[2]  = { 2, 3 }; // BR, BL
+
+PrototypeBulletTaskScheduler*                    PrototypeBulletPhysics::gTaskScheduler          = nullptr;
+btDefaultCollisionConfiguration*                 PrototypeBulletPhysics::gCollisionConfiguration = nullptr;
+btDiscreteDynamicsWorld*                         PrototypeBulletPhysics::gWorld                  = nullptr;
+btVehicleRaycaster*                              PrototypeBulletPhysics::gVehicleRaycaster       = nullptr;
+std::vector<BulletVehicleData>*                  PrototypeBulletPhysics::gVehicles               = nullptr;
+size_t*                                          PrototypeBulletPhysics::gControlledVehicleIndex = nullptr;
+std::vector<BulletTouchingPair>*                 PrototypeBulletPhysics::gTouchingPairs          = nullptr;
+std::vector<BulletTouchingPair>                  PrototypeBulletPhysics::gTouchingPairsScratch;
+std::vector<PrototypePhysicsEvent>               PrototypeBulletPhysics::gEvents;
+bool                                             PrototypeBulletPhysics::_isPlaying              = true;
+std::unordered_map<std::string, BulletSceneData> PrototypeBulletPhysics::_scenes;
+
+std::unordered_map<std::string, PrototypePhysicsSceneActivity> PrototypeBulletPhysics::_sceneActivities;
+
+static void*
+PrototypeBulletAllocate(size_t size)
+{
+    void* ptr = malloc(size);
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Physics)
+    PrototypeMemoryTracker::recordAllocation(ptr, size);
+    return ptr;
+}
+
+static void
+PrototypeBulletDeallocate(void* ptr)
+{
+    PrototypeMemoryTracker::recordFree(ptr);
+    free(ptr);
+}
+
+// fills vertices with the positions of the given mesh buffer, returns nullptr if the mesh buffer doesn't exist
+static const PrototypeMeshBufferSource*
+PrototypeBulletMeshSource(const std::string& meshName, std::vector<glm::vec3>& vertices)
+{
+    auto it = PrototypeEngineInternalApplication::database->meshBuffers.find(meshName);
+    if (it == PrototypeEngineInternalApplication::database->meshBuffers.end()) { return nullptr; }
+    const PrototypeMeshBufferSource& source = it->second->source();
+    vertices.resize(source.vertices.size());
+    for (size_t v = 0; v < source.vertices.size(); ++v) {
+        vertices[v].x = source.vertices[v].positionU.x;
+        vertices[v].y = source.vertices[v].positionU.y;
+        vertices[v].z = source.vertices[v].positionU.z;
+    }
+    return &source;
+}
+
+// below this many queries per range the dispatch overhead outweighs running them on the calling thread
+static const int PrototypeBulletQueryGrainSize = 64;
+
+static int
+PrototypeBulletQueryFilterMask(u32 filterMask)
+{
+    int mask = 0;
+    if (filterMask & PrototypePhysicsQueryFilter_Static) { mask |= btBroadphaseProxy::StaticFilter; }
+    if (filterMask & PrototypePhysicsQueryFilter_Dynamic) {
+        mask |= btBroadphaseProxy::AllFilter ^ btBroadphaseProxy::StaticFilter;
+    }
+    return mask;
+}
+
+// collision objects keep their collision layer in the user index which bullet defaults to -1
+static u32
+PrototypeBulletLayer(const btCollisionObject* object)
+{
+    const int layer = object->getUserIndex();
+    return layer < 0 ? 0 : (u32)layer % PROTOTYPE_MAX_COLLISION_LAYERS;
+}
+
+// collision objects keep their RigidbodyEvents_ in the user index 2 which bullet defaults to -1
+static u32
+PrototypeBulletEvents(const btCollisionObject* object)
+{
+    const int events = object->getUserIndex2();
+    return events < 0 ? 0 : (u32)events;
+}
+
+// a zero mask hits every layer
+static bool
+PrototypeBulletLayerMaskHits(u32 layerMask, const btBroadphaseProxy* proxy)
+{
+    if (layerMask == 0) { return true; }
+    return (layerMask & (1u << PrototypeBulletLayer(static_cast<const btCollisionObject*>(proxy->m_clientObject)))) != 0;
+}
+
+// skips the collision objects outside of the layer mask of the query
+template<typename Callback>
+struct PrototypeBulletLayerMaskCallback final : Callback
+{
+    template<typename... Args>
+    explicit PrototypeBulletLayerMaskCallback(u32 layerMask, Args&&... args)
+      : Callback(std::forward<Args>(args)...)
+      , layerMask(layerMask)
+    {}
+
+    bool needsCollision(btBroadphaseProxy* proxy0) const final
+    {
+        return Callback::needsCollision(proxy0) && PrototypeBulletLayerMaskHits(layerMask, proxy0);
+    }
+
+    u32 layerMask;
+};
+
+typedef PrototypeBulletLayerMaskCallback<btCollisionWorld::ClosestRayResultCallback>    PrototypeBulletRayCallback;
+typedef PrototypeBulletLayerMaskCallback<btCollisionWorld::ClosestConvexResultCallback> PrototypeBulletSweepCallback;
+
+static void
+PrototypeBulletFillQueryHit(const btCollisionObject*  object,
+                            const btVector3&          position,
+                            const btVector3&          normal,
+                            btScalar                  distance,
+                            PrototypePhysicsQueryHit& hit)
+{
+    hit.object   = static_cast<PrototypeObject*>(object->getUserPointer());
+    hit.position = { position.x(), position.y(), position.z() };
+    hit.normal   = { normal.x(), normal.y(), normal.z() };
+    hit.distance = distance;
+}
+
+// rays and sweeps only walk the broadphase (per thread stacks in BT_THREADSAFE builds) and the shapes, so the ranges
+// of a batch can run concurrently, overlaps are skipped here since they go through the dispatcher
+struct PrototypeBulletQueryBody final : btIParallelForBody
+{
+    PrototypeBulletQueryBody(btCollisionWorld* world, const PrototypePhysicsQuery* queries, PrototypePhysicsQueryHit* hits)
+      : _world(world)
+      , _queries(queries)
+      , _hits(hits)
+    {}
+
+    void forLoop(int iBegin, int iEnd) const final
+    {
+        for (int i = iBegin; i < iEnd; ++i) {
+            const PrototypePhysicsQuery& query = _queries[i];
+            PrototypePhysicsQueryHit&    hit   = _hits[i];
+            if (query.type == PrototypePhysicsQueryType_Overlap) { continue; }
+            btVector3 direction(query.direction.x, query.direction.y, query.direction.z);
+            if (direction.fuzzyZero()) { continue; }
+            direction.normalize();
+            const btVector3 from(query.origin.x, query.origin.y, query.origin.z);
+            const btVector3 to = from + direction * query.length;
+            if (query.type == PrototypePhysicsQueryType_Ray) {
+                PrototypeBulletRayCallback callback(query.layerMask, from, to);
+                callback.m_collisionFilterMask = PrototypeBulletQueryFilterMask(query.filterMask);
+                _world->rayTest(from, to, callback);
+                if (callback.hasHit()) {
+                    PrototypeBulletFillQueryHit(callback.m_collisionObject,
+                                                callback.m_hitPointWorld,
+                                                callback.m_hitNormalWorld,
+                                                callback.m_closestHitFraction * query.length,
+                                                hit);
+                }
+            } else if (query.type == PrototypePhysicsQueryType_Sweep) {
+                btSphereShape                sphere(query.radius);
+                const btTransform            fromTransform(btQuaternion::getIdentity(), from);
+                const btTransform            toTransform(btQuaternion::getIdentity(), to);
+                PrototypeBulletSweepCallback callback(query.layerMask, from, to);
+                callback.m_collisionFilterMask = PrototypeBulletQueryFilterMask(query.filterMask);
+                _world->convexSweepTest(&sphere, fromTransform, toTransform, callback);
+                if (callback.hasHit()) {
+                    PrototypeBulletFillQueryHit(callback.m_hitCollisionObject,
+                                                callback.m_hitPointWorld,
+                                                callback.m_hitNormalWorld,
+                                                callback.m_closestHitFraction * query.length,
+                                                hit);
+                }
+            }
+        }
+    }
+
+  private:
+    btCollisionWorld*            _world;
+    const PrototypePhysicsQuery* _queries;
+    PrototypePhysicsQueryHit*    _hits;
+};
+
+// keeps the first object the probe touches
+struct PrototypeBulletOverlapCallback final : btCollisionWorld::ContactResultCallback
+{
+    PrototypeBulletOverlapCallback(const btCollisionObject* probe, u32 layerMask)
+      : probe(probe)
+      , object(nullptr)
+      , layerMask(layerMask)
+    {}
+
+    bool needsCollision(btBroadphaseProxy* proxy0) const final
+    {
+        return ContactResultCallback::needsCollision(proxy0) && PrototypeBulletLayerMaskHits(layerMask, proxy0);
+    }
+
+    btScalar addSingleResult(btManifoldPoint&                cp,
+                             const btCollisionObjectWrapper* colObj0Wrap,
+                             int                             partId0,
+                             int                             index0,
+                             const btCollisionObjectWrapper* colObj1Wrap,
+                             int                             partId1,
+                             int                             index1) final
+    {
+        if (!object) {
+            const btCollisionObject* object0 = colObj0Wrap->getCollisionObject();
+            object                           = object0 == probe ? colObj1Wrap->getCollisionObject() : object0;
+        }
+        return btScalar(0);
+    }
+
+    const btCollisionObject* probe;
+    const btCollisionObject* object;
+    u32                      layerMask;
+};
+
+PrototypeBulletLayerFilter::PrototypeBulletLayerFilter(const PrototypeCollisionLayers& collisionLayers)
+  : _matrix(collisionLayers.matrix())
+{}
+
+bool
+PrototypeBulletLayerFilter::needBroadphaseCollision(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1) const
+{
+    // bullet's own group and mask test, replaced as soon as a filter callback is set
+    if ((proxy0->m_collisionFilterGroup & proxy1->m_collisionFilterMask) == 0 ||
+        (proxy1->m_collisionFilterGroup & proxy0->m_collisionFilterMask) == 0) {
+        return false;
+    }
+    const u32 layer0 = PrototypeBulletLayer(static_cast<const btCollisionObject*>(proxy0->m_clientObject));
+    const u32 layer1 = PrototypeBulletLayer(static_cast<const btCollisionObject*>(proxy1->m_clientObject));
+    return (_matrix[layer0] & (1u << layer1)) != 0;
+}
+
+PrototypeBulletTaskScheduler::PrototypeBulletTaskScheduler(PrototypeThreadpool* threadpool)
+  : btITaskScheduler("PrototypeThreadpool")
+  , _threadpool(threadpool)
+  , _maxNumThreads(std::min((int)threadpool->numThreads() + 1, BT_MAX_THREAD_COUNT))
+  , _numThreads(_maxNumThreads)
+{}
+
+int
+PrototypeBulletTaskScheduler::getMaxNumThreads() const
+{
+    return _maxNumThreads;
+}
+
+int
+PrototypeBulletTaskScheduler::getNumThreads() const
+{
+    return _numThreads;
+}
+
+void
+PrototypeBulletTaskScheduler::setNumThreads(int numThreads)
+{
+    _numThreads = std::max(1, std::min(numThreads, _maxNumThreads));
+}
+
+void
+PrototypeBulletTaskScheduler::parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+{
+    int       begins[BT_MAX_THREAD_COUNT];
+    int       ends[BT_MAX_THREAD_COUNT];
+    const int numRanges = split(iBegin, iEnd, grainSize, begins, ends);
+    if (numRanges == 0) { return; }
+
+    // tasks capture the shared state and their range index only so std::function keeps them inline
+    struct Ranges
+    {
+        const btIParallelForBody& body;
+        const int*                begins;
+        const int*                ends;
+        std::atomic<size_t>       pending;
+    } ranges = { body, begins, ends, { (size_t)numRanges - 1 } };
+
+    for (int r = 1; r < numRanges; ++r) {
+        _threadpool->submit(
+          [&ranges, r]() {
+              ranges.body.forLoop(ranges.begins[r], ranges.ends[r]);
+              ranges.pending.fetch_sub(1, std::memory_order_release);
+          },
+          PrototypeThreadpoolPriority_High);
+    }
+    body.forLoop(begins[0], ends[0]);
+    _threadpool->helpUntil(ranges.pending, PrototypeThreadpoolPriority_High);
+}
+
+btScalar
+PrototypeBulletTaskScheduler::parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body)
+{
+    int       begins[BT_MAX_THREAD_COUNT];
+    int       ends[BT_MAX_THREAD_COUNT];
+    btScalar  sums[BT_MAX_THREAD_COUNT];
+    const int numRanges = split(iBegin, iEnd, grainSize, begins, ends);
+    if (numRanges == 0) { return btScalar(0); }
+
+    struct Ranges
+    {
+        const btIParallelSumBody& body;
+        const int*                begins;
+        const int*                ends;
+        btScalar*                 sums;
+        std::atomic<size_t>       pending;
+    } ranges = { body, begins, ends, sums, { (size_t)numRanges - 1 } };
+
+    for (int r = 1; r < numRanges; ++r) {
+        _threadpool->submit(
+          [&ranges, r]() {
+              ranges.sums[r] = ranges.body.sumLoop(ranges.begins[r], ranges.ends[r]);
+              ranges.pending.fetch_sub(1, std::memory_order_release);
+          },
+          PrototypeThreadpoolPriority_High);
+    }
+    sums[0] = body.sumLoop(begins[0], ends[0]);
+    _threadpool->helpUntil(ranges.pending, PrototypeThreadpoolPriority_High);
+
+    btScalar total = btScalar(0);
+    for (int r = 0; r < numRanges; ++r) { total += sums[r]; }
+    return total;
+}
+
+int
+PrototypeBulletTaskScheduler::split(int iBegin, int iEnd, int grainSize, int* begins, int* ends) const
+{
+    const int count = iEnd - iBegin;
+    if (count <= 0) { return 0; }
+    const int maxRanges = std::max(1, std::min(_numThreads, count / std::max(1, grainSize)));
+    const int rangeSize = (count + maxRanges - 1) / maxRanges;
+    int       numRanges = 0;
+    for (int i = iBegin; i < iEnd; i += rangeSize) {
+        begins[numRanges] = i;
+        ends[numRanges]   = std::min(i + rangeSize, iEnd);
+        ++numRanges;
+    }
+    return numRanges;
+}
 
-#include <GLFW/glfw3.h>
+void
+PrototypeBulletPhysics::vehicleReleaseAllControls(size_t vehicleIndex)
+{
+    BulletVehicleData& vehicleData = (*gVehicles)[vehicleIndex];
+    vehicleData.acceleration       = 0.0f;
+    vehicleData.brake              = 0.0f;
+    vehicleData.steer              = 0.0f;
+}
 
-#include <stdarg.h>
+void
+PrototypeBulletPhysics::vehicleResetPose(size_t vehicleIndex, const btVector3& position)
+{
+    btRaycastVehicle* vehicle = (*gVehicles)[vehicleIndex].vehicle;
+    btRigidBody*      chasis  = vehicle->getRigidBody();
+    btTransform       startTransform(btQuaternion::getIdentity(), position);
+    chasis->setWorldTransform(startTransform);
+    chasis->setInterpolationWorldTransform(startTransform);
+    chasis->setLinearVelocity(btVector3(0.0f, 0.0f, 0.0f));
+    chasis->setAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
+    chasis->clearForces();
+    vehicle->resetSuspension();
+    for (int w = 0; w < vehicle->getNumWheels(); ++w) { vehicle->updateWheelTransform(w, false); }
+    chasis->activate(true);
+}
 
-bool PrototypeBulletPhysics::_isPlaying = false;
+void
+PrototypeBulletPhysics::vehicleApplyControls()
+{
+    for (BulletVehicleData& vehicleData : *gVehicles) {
+        btRaycastVehicle* vehicle     = vehicleData.vehicle;
+        const btScalar    engineForce = vehicleData.acceleration * gVehicleMaxEngineForce * (vehicleData.reverse ? -1.0f : 1.0f);
+        const btScalar    brakeForce  = vehicleData.brake * gVehicleMaxBrakeForce;
+        const btScalar    steer       = vehicleData.steer * gVehicleMaxSteer;
+        for (int w : gVehicleRearWheels) { vehicle->applyEngineForce(engineForce, w); }
+        for (int w : gVehicleFrontWheels) { vehicle->setSteeringValue(steer, w); }
+        for (int w = 0; w < vehicle->getNumWheels(); ++w) { vehicle->setBrake(brakeForce, w); }
+    }
+}
+
+void
+PrototypeBulletPhysics::vehicleSyncTransforms()
+{
+    for (BulletVehicleData& vehicleData : *gVehicles) {
+        btRaycastVehicle* vehicle = vehicleData.vehicle;
+        if (!vehicle->getRigidBody()->isActive()) { continue; }
+        VehicleChasis* vehicleChasis = vehicleData.chasisObject->getVehicleChasisTrait();
+        if (!vehicleChasis->wheelBLObject() || !vehicleChasis->wheelBRObject() || !vehicleChasis->wheelFLObject() ||
+            !vehicleChasis->wheelFRObject()) {
+            continue;
+        }
+        PrototypeObject* wheelObjects[4] = { vehicleChasis->wheelFRObject(),
+                                             vehicleChasis->wheelFLObject(),
+                                             vehicleChasis->wheelBRObject(),
+                                             vehicleChasis->wheelBLObject() };
+
+        const btTransform& chasisTransform = vehicle->getChassisWorldTransform();
+        const btTransform  chasisInverse   = chasisTransform.inverse();
+        btScalar           chasisMat[16];
+        chasisTransform.getOpenGLMatrix(chasisMat);
+        Transform* chasisTr = vehicleData.chasisObject->getTransformTrait();
+        chasisTr->setModel(chasisMat);
+        chasisTr->setModelScaled(chasisMat);
+
+        for (int w = 0; w < 4; ++w) {
+            vehicle->updateWheelTransform(w, true);
+            const btTransform& wheelTransform = vehicle->getWheelTransformWS(w);
+            btScalar           wheelMat[16];
+            (chasisInverse * wheelTransform).getOpenGLMatrix(wheelMat);
+            Transform* wheelTr = wheelObjects[w]->getTransformTrait();
+            wheelTr->setModel(wheelMat);
+            wheelTransform.getOpenGLMatrix(wheelMat);
+            wheelTr->setModelScaled(wheelMat);
+        }
+    }
+}
+
+void
+PrototypeBulletPhysics::pullRigidbody(PrototypeObject* object, btRigidBody* rigidbody, bool syncVelocities)
+{
+    Transform*         tr       = object->getTransformTrait();
+    const btVector3&   origin   = rigidbody->getWorldTransform().getOrigin();
+    const btQuaternion rotation = rigidbody->getWorldTransform().getRotation();
+    tr->setWorldPose({ origin.x(), origin.y(), origin.z() }, glm::quat(rotation.w(), rotation.x(), rotation.y(), rotation.z()));
+    if (syncVelocities) {
+        Rigidbody*       rb              = object->getRigidbodyTrait();
+        const btVector3& linearVelocity  = rigidbody->getLinearVelocity();
+        const btVector3& angularVelocity = rigidbody->getAngularVelocity();
+        rb->setLinearVelocity(glm::vec3(linearVelocity.x(), linearVelocity.y(), linearVelocity.z()));
+        rb->setLinearDamping(rigidbody->getLinearDamping());
+        rb->setAngularVelocity(glm::vec3(angularVelocity.x(), angularVelocity.y(), angularVelocity.z()));
+        rb->setAngularDamping(rigidbody->getAngularDamping());
+    }
+}
+
+void
+PrototypeBulletPhysics::pushRigidbody(Transform* tr, btRigidBody* rigidbody)
+{
+    btTransform t;
+    t.setFromOpenGLMatrix(&tr->worldModel()[0][0]);
+    rigidbody->setWorldTransform(t);
+    rigidbody->setInterpolationWorldTransform(t);
+    gWorld->updateSingleAabb(rigidbody);
+    rigidbody->activate(true);
+    tr->setNeedsPhysicsSync(false);
+}
+
+void
+PrototypeBulletPhysics::internalCreateRigidbody(PrototypeObject* object, btCollisionShape* shape, bool forceStatic, f32 mass)
+{
+    Transform*       tr              = object->getTransformTrait();
+    Rigidbody*       rb              = object->getRigidbodyTrait();
+    Collider*        collider        = object->getColliderTrait();
+    const glm::vec3& position        = tr->position();
+    const glm::vec3& rotation        = tr->rotation();
+    glm::vec3        linearVelocity  = rb->linearVelocity();
+    f32              linearDamping   = rb->linearDamping();
+    glm::vec3        angularVelocity = rb->angularVelocity();
+    f32              angularDamping  = rb->angularDamping();
+    bool             lockLinearX     = rb->lockLinearX();
+    bool             lockLinearY     = rb->lockLinearY();
+    bool             lockLinearZ     = rb->lockLinearZ();
+    bool             lockAngularX    = rb->lockAngularX();
+    bool             lockAngularY    = rb->lockAngularY();
+    bool             lockAngularZ    = rb->lockAngularZ();
+    bool             isStatic        = forceStatic || rb->isStatic();
+
+    glm::quat   qat = glm::quat(glm::vec3(rotation.x, rotation.y, rotation.z));
+    btTransform t(btQuaternion(qat.x, qat.y, qat.z, qat.w), btVector3(position.x, position.y, position.z));
+
+    btScalar  bodyMass = isStatic ? btScalar(0) : btScalar(mass);
+    btVector3 inertia(0.0f, 0.0f, 0.0f);
+    if (!isStatic) { shape->calculateLocalInertia(bodyMass, inertia); }
+
+    btRigidBody::btRigidBodyConstructionInfo info(bodyMass, nullptr, shape, inertia);
+    info.m_startWorldTransform = t;
+    info.m_friction            = gMaterialFriction;
+    info.m_restitution         = gMaterialRestitution;
+    info.m_linearDamping       = linearDamping;
+    info.m_angularDamping      = angularDamping;
+
+    btRigidBody* rigidbody = new btRigidBody(info);
+    if (!isStatic) {
+        rigidbody->setLinearVelocity(btVector3(linearVelocity.x, linearVelocity.y, linearVelocity.z));
+        rigidbody->setAngularVelocity(btVector3(angularVelocity.x, angularVelocity.y, angularVelocity.z));
+        rigidbody->setLinearFactor(btVector3(lockLinearX ? 0.0f : 1.0f, lockLinearY ? 0.0f : 1.0f, lockLinearZ ? 0.0f : 1.0f));
+        rigidbody->setAngularFactor(
+          btVector3(lockAngularX ? 0.0f : 1.0f, lockAngularY ? 0.0f : 1.0f, lockAngularZ ? 0.0f : 1.0f));
+    }
+    if (rb->isTrigger()) {
+        rigidbody->setCollisionFlags(rigidbody->getCollisionFlags() | btCollisionObject::CF_NO_CONTACT_RESPONSE);
+    }
+
+    rigidbody->setUserPointer((void*)object);
+    rigidbody->setUserIndex((int)collider->layer());
+    rigidbody->setUserIndex2((int)rb->events());
+    rb->setRigidbodyRef(static_cast<void*>(rigidbody));
+    shape->setUserPointer((void*)object);
+    collider->setShapeRef(static_cast<void*>(shape));
+    gWorld->addRigidBody(rigidbody);
+}
+
+void
+PrototypeBulletPhysics::internalDestroyRigidbody(btRigidBody* rigidbody)
+{
+    internalForgetTouchingPairs(rigidbody);
+    gWorld->removeRigidBody(rigidbody);
+    internalDestroyShape(rigidbody->getCollisionShape());
+    delete rigidbody;
+}
+
+void
+PrototypeBulletPhysics::internalForgetTouchingPairs(btRigidBody* rigidbody)
+{
+    if (!gTouchingPairs) { return; }
+    gTouchingPairs->erase(std::remove_if(gTouchingPairs->begin(),
+                                         gTouchingPairs->end(),
+                                         [rigidbody](const BulletTouchingPair& pair) {
+                                             return pair.first == rigidbody || pair.second == rigidbody;
+                                         }),
+                          gTouchingPairs->end());
+}
+
+void
+PrototypeBulletPhysics::internalDestroyShape(btCollisionShape* shape)
+{
+    if (!shape) { return; }
+    if (shape->isCompound()) {
+        btCompoundShape* compound = static_cast<btCompoundShape*>(shape);
+        for (int i = compound->getNumChildShapes() - 1; i >= 0; --i) {
+            btCollisionShape* child = compound->getChildShape(i);
+            compound->removeChildShapeByIndex(i);
+            internalDestroyShape(child);
+        }
+    } else if (shape->getShapeType() == TRIANGLE_MESH_SHAPE_PROXYTYPE) {
+        delete static_cast<btBvhTriangleMeshShape*>(shape)->getMeshInterface();
+    }
+    delete shape;
+}
 
 PrototypeBulletPhysics::PrototypeBulletPhysics()
   : _needsRecord(true)
+  , _lockstep({ false, 1.0f / 60.0f })
 {}
 
 bool
 PrototypeBulletPhysics::init()
 {
+    // has to happen before anything is allocated by bullet
+    btAlignedAllocSetCustom(PrototypeBulletAllocate, PrototypeBulletDeallocate);
+
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Physics)
+    gTaskScheduler = PROTOTYPE_NEW PrototypeBulletTaskScheduler(PrototypeEngineInternalApplication::threadpool);
+    // bullet hands out thread indices in first come order and expects the main thread to own index 0
+    setLockstep(_lockstep);
+
+    btDefaultCollisionConstructionInfo collisionConstructionInfo;
+    collisionConstructionInfo.m_defaultMaxPersistentManifoldPoolSize = 80000;
+    collisionConstructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = 80000;
+    gCollisionConfiguration = new btDefaultCollisionConfiguration(collisionConstructionInfo);
+
     return true;
 }
 
 void
 PrototypeBulletPhysics::deInit()
-{}
+{
+    for (auto& pair : _scenes) {
+        BulletSceneData& sceneData = pair.second;
+        gWorld                     = sceneData.world;
+        for (BulletVehicleData& vehicleData : sceneData.vehicles) {
+            sceneData.world->removeVehicle(vehicleData.vehicle);
+            btRigidBody* chasis = vehicleData.vehicle->getRigidBody();
+            delete vehicleData.vehicle;
+            internalDestroyRigidbody(chasis);
+        }
+        btCollisionObjectArray& collisionObjects = sceneData.world->getCollisionObjectArray();
+        for (int i = collisionObjects.size() - 1; i >= 0; --i) {
+            btRigidBody* rigidbody = btRigidBody::upcast(collisionObjects[i]);
+            if (rigidbody) {
+                PrototypeObject* object = static_cast<PrototypeObject*>(rigidbody->getUserPointer());
+                if (object && object->hasRigidbodyTrait()) { object->getRigidbodyTrait()->setRigidbodyRef(nullptr); }
+                if (object && object->hasColliderTrait()) { object->getColliderTrait()->setShapeRef(nullptr); }
+                internalDestroyRigidbody(rigidbody);
+            } else {
+                sceneData.world->removeCollisionObject(collisionObjects[i]);
+            }
+        }
+        delete sceneData.vehicleRaycaster;
+        delete sceneData.world;
+        delete sceneData.layerFilter;
+        delete sceneData.solver;
+        delete sceneData.solverPool;
+        delete sceneData.dispatcher;
+        delete sceneData.broadphase;
+    }
+    _scenes.clear();
+    _sceneActivities.clear();
+    _queryBatches.clear();
+    gWorld                  = nullptr;
+    gVehicleRaycaster       = nullptr;
+    gVehicles               = nullptr;
+    gControlledVehicleIndex = nullptr;
+    gTouchingPairs          = nullptr;
+    gTouchingPairsScratch.clear();
+    gEvents.clear();
+
+    delete gCollisionConfiguration;
+    gCollisionConfiguration = nullptr;
+
+    btSetTaskScheduler(btGetSequentialTaskScheduler());
+    delete gTaskScheduler;
+    gTaskScheduler = nullptr;
+}
 
 void
 PrototypeBulletPhysics::play()
 {
     _isPlaying = true;
+    PrototypeEngineInternalApplication::window->resetDeltaTime();
 }
 
 void
@@ -59,16 +672,135 @@ PrototypeBulletPhysics::pause()
 bool
 PrototypeBulletPhysics::update()
 {
+    // bullet's task scheduler is global, so unlike physx the other registered worlds can't step alongside this one
+    gEvents.clear();
+    f32 timestep = 0.0f;
+    if (_isPlaying) {
+        f32 deltaTime = (f32)PrototypeEngineInternalApplication::window->deltaTime();
+        if (_lockstep.enabled) { deltaTime = _lockstep.timestep; }
+        timestep = sceneTimestep(PrototypeEngineInternalApplication::scene->name(), deltaTime);
+    }
+    if (timestep > 0.0f) {
+        PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Physics)
+        vehicleApplyControls();
+        // no sub-stepping, one simulation step of the frame's delta time just like the physx backend
+        gWorld->stepSimulation(timestep, 0);
+        vehicleSyncTransforms();
+        collectEvents();
+
+        const auto& colliderObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(
+          PrototypeTraitTypeMaskCollider | PrototypeTraitTypeMaskTransform | PrototypeTraitTypeMaskRigidbody);
+        for (const auto& colliderObject : colliderObjects) {
+            Rigidbody* rb = colliderObject->getRigidbodyTrait();
+            if (!rb) { continue; }
+            auto rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+            if (!rigidbody) { continue; }
+            Transform* tr = colliderObject->getTransformTrait();
+            if (!tr->needsPhysicsSync()) {
+                if (rb->isStatic()) { continue; }
+                if (rigidbody->isActive()) {
+                    bool isSelected = static_cast<PrototypeSceneNode*>(colliderObject->parentNode())->isSelected();
+                    pullRigidbody(colliderObject, rigidbody, isSelected);
+                }
+            } else {
+                pushRigidbody(tr, rigidbody);
+            }
+        }
+    } else {
+        const auto& colliderObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(
+          PrototypeTraitTypeMaskCollider | PrototypeTraitTypeMaskTransform | PrototypeTraitTypeMaskRigidbody);
+        for (const auto& colliderObject : colliderObjects) {
+            Rigidbody* rb        = colliderObject->getRigidbodyTrait();
+            auto       rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+            if (!rigidbody) { continue; }
+            Transform* tr = colliderObject->getTransformTrait();
+            if (tr->needsPhysicsSync()) { pushRigidbody(tr, rigidbody); }
+        }
+    }
+
+    auto selectedObjects = PrototypeEngineInternalApplication::scene->selectedNodes();
+    for (const auto& node : selectedObjects) {
+        auto optObj = node->object();
+        if (optObj.has_value()) {
+            auto obj = optObj.value();
+            if (obj->has(PrototypeTraitTypeMaskCollider | PrototypeTraitTypeMaskTransform | PrototypeTraitTypeMaskRigidbody)) {
+                Rigidbody* rb = obj->getRigidbodyTrait();
+                if (!rb) { continue; }
+                auto rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+                if (!rigidbody) { continue; }
+                auto tr = obj->getTransformTrait();
+                if (tr->needsPhysicsSync()) {
+                    pushRigidbody(tr, rigidbody);
+                } else {
+                    if (rb->isStatic()) { continue; }
+                    if (rigidbody->isActive()) { pullRigidbody(obj, rigidbody, true); }
+                }
+            }
+        }
+    }
+
+    // queued batches see this frame's simulation results, they run whether the simulation is playing or not
+    for (const PrototypePhysicsQueryBatch& batch : _queryBatches) { queryBatch(batch.queries, batch.count, batch.hits); }
+    _queryBatches.clear();
     return true;
 }
 
 void
 PrototypeBulletPhysics::scheduleRecordPass()
-{}
+{
+    _needsRecord = true;
+}
 
 void
 PrototypeBulletPhysics::beginRecordPass()
-{}
+{
+    if (!_needsRecord) return;
+
+    _needsRecord = false;
+
+    std::string currentSceneName = PrototypeEngineInternalApplication::scene->name();
+    auto        it               = _scenes.find(currentSceneName);
+    if (it == _scenes.end()) {
+        PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Physics)
+        BulletSceneData sceneData = {};
+        sceneData.broadphase      = new btDbvtBroadphase();
+        sceneData.dispatcher      = new btCollisionDispatcherMt(gCollisionConfiguration);
+        sceneData.solverPool      = new btConstraintSolverPoolMt(gTaskScheduler->getMaxNumThreads());
+        sceneData.solver          = new btSequentialImpulseConstraintSolverMt();
+        sceneData.world           = new btDiscreteDynamicsWorldMt(
+          sceneData.dispatcher, sceneData.broadphase, sceneData.solverPool, sceneData.solver, gCollisionConfiguration);
+        sceneData.world->setGravity(btVector3(0.0f, -9.81f, 0.0f));
+        sceneData.world->getDispatchInfo().m_deterministicOverlappingPairs = _lockstep.enabled;
+        sceneData.layerFilter = new PrototypeBulletLayerFilter(PrototypeEngineInternalApplication::scene->collisionLayers());
+        sceneData.world->getPairCache()->setOverlapFilterCallback(sceneData.layerFilter);
+        sceneData.vehicleRaycaster       = new btDefaultVehicleRaycaster(sceneData.world);
+        sceneData.controlledVehicleIndex = -1;
+
+        // insert scene data
+        _scenes.insert({ currentSceneName, std::move(sceneData) });
+        gWorld                  = _scenes[currentSceneName].world;
+        gVehicleRaycaster       = _scenes[currentSceneName].vehicleRaycaster;
+        gVehicles               = &_scenes[currentSceneName].vehicles;
+        gControlledVehicleIndex = &_scenes[currentSceneName].controlledVehicleIndex;
+        gTouchingPairs          = &_scenes[currentSceneName].touchingPairs;
+
+        // the objects come out of an unordered set, creating the bodies in id order keeps the order the simulation
+        // visits them in the same from one run to the next
+        const auto& colliderObjectsSet = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(
+          PrototypeTraitTypeMaskCollider | PrototypeTraitTypeMaskTransform | PrototypeTraitTypeMaskRigidbody);
+        std::vector<PrototypeObject*> colliderObjects(colliderObjectsSet.begin(), colliderObjectsSet.end());
+        std::sort(colliderObjects.begin(), colliderObjects.end(), [](PrototypeObject* a, PrototypeObject* b) {
+            return a->id() < b->id();
+        });
+        for (auto& colliderObject : colliderObjects) { createColliderActor(colliderObject); }
+    } else {
+        gWorld                  = it->second.world;
+        gVehicleRaycaster       = it->second.vehicleRaycaster;
+        gVehicles               = &it->second.vehicles;
+        gControlledVehicleIndex = &it->second.controlledVehicleIndex;
+        gTouchingPairs          = &it->second.touchingPairs;
+    }
+}
 
 void
 PrototypeBulletPhysics::endRecordPass()
@@ -80,56 +812,386 @@ PrototypeBulletPhysics::isPlaying()
     return _isPlaying;
 }
 
+void
+PrototypeBulletPhysics::setLockstep(const PrototypePhysicsLockstep& lockstep)
+{
+    _lockstep = lockstep;
+    // the parallel narrowphase appends the manifolds in whichever order the workers get to them and the islands get
+    // solved in that order, lockstep gives the threads up for the sequential scheduler
+    if (gTaskScheduler) { btSetTaskScheduler(_lockstep.enabled ? btGetSequentialTaskScheduler() : gTaskScheduler); }
+    // sorts the overlapping pairs before the narrowphase so they don't depend on the broadphase history
+    for (auto& pair : _scenes) { pair.second.world->getDispatchInfo().m_deterministicOverlappingPairs = _lockstep.enabled; }
+}
+
+const PrototypePhysicsLockstep&
+PrototypeBulletPhysics::lockstep()
+{
+    return _lockstep;
+}
+
+u64
+PrototypeBulletPhysics::stateHash()
+{
+    u64 hash = PROTOTYPE_PHYSICS_HASH_OFFSET;
+    if (!gWorld) { return hash; }
+    // the collision objects come in insertion order, the same between two runs that created and removed the same bodies
+    const btCollisionObjectArray& collisionObjects = gWorld->getCollisionObjectArray();
+    for (int i = 0; i < collisionObjects.size(); ++i) {
+        const btRigidBody* body = btRigidBody::upcast(collisionObjects[i]);
+        if (!body || body->isStaticOrKinematicObject()) { continue; }
+        const PrototypeObject* object   = static_cast<const PrototypeObject*>(body->getUserPointer());
+        const u32              id       = object ? object->id() : 0;
+        const btVector3&       origin   = body->getWorldTransform().getOrigin();
+        const btQuaternion     rotation = body->getWorldTransform().getRotation();
+        const btVector3&       linear   = body->getLinearVelocity();
+        const btVector3&       angular  = body->getAngularVelocity();
+        // btVector3 pads to four scalars, only the three used ones get hashed
+        const btScalar state[] = { origin.x(),   origin.y(),   origin.z(),   rotation.x(), rotation.y(),
+                                   rotation.z(), rotation.w(), linear.x(),   linear.y(),   linear.z(),
+                                   angular.x(),  angular.y(),  angular.z() };
+        hash                   = PrototypePhysicsHash(hash, &id, sizeof(id));
+        hash                   = PrototypePhysicsHash(hash, state, sizeof(state));
+    }
+    return hash;
+}
+
 void
 PrototypeBulletPhysics::overrideRigidbodyGlobalPos(PrototypeObject* object)
 {}
 
 std::optional<PrototypeObject*>
-PrototypeBulletPhysics::raycast(const glm::vec3& origin, const glm::vec3& dir, const f32 length)
+PrototypeBulletPhysics::raycast(const glm::vec3& origin, const glm::vec3& dir, const f32 length, u32 layerMask)
 {
+    btVector3                  from(origin.x, origin.y, origin.z);
+    btVector3                  to = from + btVector3(dir.x, dir.y, dir.z) * length;
+    PrototypeBulletRayCallback hit(layerMask, from, to);
+    gWorld->rayTest(from, to, hit);
+    if (hit.hasHit() && hit.m_collisionObject->getUserPointer()) {
+        return { (PrototypeObject*)hit.m_collisionObject->getUserPointer() };
+    }
     return {};
 }
 
+void
+PrototypeBulletPhysics::queryBatch(const PrototypePhysicsQuery* queries, size_t count, PrototypePhysicsQueryHit* hits)
+{
+    if (count == 0) { return; }
+
+    for (size_t i = 0; i < count; ++i) {
+        hits[i].object   = nullptr;
+        hits[i].position = glm::vec3(0.0f);
+        hits[i].normal   = glm::vec3(0.0f);
+        hits[i].distance = 0.0f;
+    }
+
+    PrototypeBulletQueryBody body(gWorld, queries, hits);
+    btParallelFor(0, (int)count, PrototypeBulletQueryGrainSize, body);
+
+    // contact tests get their manifolds from btCollisionDispatcherMt which is only thread safe while the world is
+    // dispatching its own narrowphase, so overlaps stay on the calling thread
+    for (size_t i = 0; i < count; ++i) {
+        const PrototypePhysicsQuery& query = queries[i];
+        if (query.type != PrototypePhysicsQueryType_Overlap) { continue; }
+        const int filterMask = PrototypeBulletQueryFilterMask(query.filterMask);
+        if (filterMask == 0) { continue; }
+        const btVector3   origin(query.origin.x, query.origin.y, query.origin.z);
+        btSphereShape     sphere(query.radius);
+        btCollisionObject probe;
+        probe.setCollisionShape(&sphere);
+        probe.setWorldTransform(btTransform(btQuaternion::getIdentity(), origin));
+        PrototypeBulletOverlapCallback callback(&probe, query.layerMask);
+        callback.m_collisionFilterMask = filterMask;
+        gWorld->contactTest(&probe, callback);
+        if (callback.object) {
+            hits[i].object   = static_cast<PrototypeObject*>(callback.object->getUserPointer());
+            hits[i].position = query.origin;
+        }
+    }
+}
+
+void
+PrototypeBulletPhysics::submitQueryBatch(const PrototypePhysicsQuery* queries, size_t count, PrototypePhysicsQueryHit* hits)
+{
+    if (count == 0) { return; }
+    _queryBatches.push_back({ queries, count, hits });
+}
+
+void
+PrototypeBulletPhysics::fetchStatistics(PrototypePhysicsStatistics& statistics)
+{
+    statistics = {};
+    if (!gWorld) return;
+    const btCollisionObjectArray& collisionObjects = gWorld->getCollisionObjectArray();
+    for (int i = 0; i < collisionObjects.size(); ++i) {
+        if (!collisionObjects[i]->isStaticOrKinematicObject() && collisionObjects[i]->isActive()) { ++statistics.activeBodies; }
+    }
+    // every overlapping pair that passed the layer filter gets a narrowphase pass through the dispatcher
+    statistics.contactPairs = (u32)gWorld->getPairCache()->getNumOverlappingPairs();
+    btDispatcher* dispatcher = gWorld->getDispatcher();
+    for (int i = 0; i < dispatcher->getNumManifolds(); ++i) {
+        if (dispatcher->getManifoldByIndexInternal(i)->getNumContacts() > 0) { ++statistics.touchingPairs; }
+    }
+}
+
+const std::vector<PrototypePhysicsEvent>&
+PrototypeBulletPhysics::events()
+{
+    return gEvents;
+}
+
+void
+PrototypeBulletPhysics::collectEvents()
+{
+    std::vector<BulletTouchingPair>& previousPairs = *gTouchingPairs;
+    std::vector<BulletTouchingPair>& currentPairs  = gTouchingPairsScratch;
+    currentPairs.clear();
+
+    btDispatcher* dispatcher = gWorld->getDispatcher();
+    for (int i = 0; i < dispatcher->getNumManifolds(); ++i) {
+        const btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+        if (manifold->getNumContacts() == 0) { continue; }
+        const btCollisionObject* body0 = manifold->getBody0();
+        const btCollisionObject* body1 = manifold->getBody1();
+        if (!body0->getUserPointer() || !body1->getUserPointer()) { continue; }
+        const bool isTrigger = (body0->getCollisionFlags() | body1->getCollisionFlags()) &
+                               btCollisionObject::CF_NO_CONTACT_RESPONSE;
+        const u32 events = PrototypeBulletEvents(body0) | PrototypeBulletEvents(body1);
+        if (0 == (events & (isTrigger ? RigidbodyEvents_Trigger : RigidbodyEvents_Contact))) { continue; }
+
+        const BulletTouchingPair pair = body0 < body1 ? BulletTouchingPair(body0, body1) : BulletTouchingPair(body1, body0);
+        currentPairs.push_back(pair);
+        if (std::binary_search(previousPairs.begin(), previousPairs.end(), pair)) { continue; }
+
+        PrototypePhysicsEvent event = {};
+        if (isTrigger) {
+            // the trigger is the object, whichever side of the manifold it's on
+            const bool trigger0 = body0->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE;
+            event.type          = PrototypePhysicsEventType_TriggerEnter;
+            event.object        = static_cast<PrototypeObject*>((trigger0 ? body0 : body1)->getUserPointer());
+            event.other         = static_cast<PrototypeObject*>((trigger0 ? body1 : body0)->getUserPointer());
+        } else {
+            const btManifoldPoint& point    = manifold->getContactPoint(0);
+            const btVector3&       position = point.getPositionWorldOnA();
+            event.type                      = PrototypePhysicsEventType_ContactFound;
+            event.object                    = static_cast<PrototypeObject*>(body0->getUserPointer());
+            event.other                     = static_cast<PrototypeObject*>(body1->getUserPointer());
+            event.position                  = { position.x(), position.y(), position.z() };
+            // bullet normals point from the second body to the first one just like physx
+            event.normal = { point.m_normalWorldOnB.x(), point.m_normalWorldOnB.y(), point.m_normalWorldOnB.z() };
+            for (int p = 0; p < manifold->getNumContacts(); ++p) {
+                event.impulse += manifold->getContactPoint(p).getAppliedImpulse();
+            }
+        }
+        gEvents.push_back(event);
+    }
+    std::sort(currentPairs.begin(), currentPairs.end());
+    currentPairs.erase(std::unique(currentPairs.begin(), currentPairs.end()), currentPairs.end());
+
+    for (const BulletTouchingPair& pair : previousPairs) {
+        if (std::binary_search(currentPairs.begin(), currentPairs.end(), pair)) { continue; }
+        PrototypePhysicsEvent event = {};
+        if ((pair.first->getCollisionFlags() | pair.second->getCollisionFlags()) & btCollisionObject::CF_NO_CONTACT_RESPONSE) {
+            const bool trigger0 = pair.first->getCollisionFlags() & btCollisionObject::CF_NO_CONTACT_RESPONSE;
+            event.type          = PrototypePhysicsEventType_TriggerExit;
+            event.object        = static_cast<PrototypeObject*>((trigger0 ? pair.first : pair.second)->getUserPointer());
+            event.other         = static_cast<PrototypeObject*>((trigger0 ? pair.second : pair.first)->getUserPointer());
+        } else {
+            event.type   = PrototypePhysicsEventType_ContactLost;
+            event.object = static_cast<PrototypeObject*>(pair.first->getUserPointer());
+            event.other  = static_cast<PrototypeObject*>(pair.second->getUserPointer());
+        }
+        gEvents.push_back(event);
+    }
+    previousPairs.swap(currentPairs);
+
+    // the user index 3 remembers whether the body was awake after the previous step, -1 until the first one
+    const btCollisionObjectArray& collisionObjects = gWorld->getCollisionObjectArray();
+    for (int i = 0; i < collisionObjects.size(); ++i) {
+        btCollisionObject* collisionObject = collisionObjects[i];
+        if (0 == (PrototypeBulletEvents(collisionObject) & RigidbodyEvents_Sleep) || !collisionObject->getUserPointer()) {
+            continue;
+        }
+        const int wasActive = collisionObject->getUserIndex3();
+        const int isActive  = collisionObject->isActive() ? 1 : 0;
+        collisionObject->setUserIndex3(isActive);
+        if (wasActive < 0 || wasActive == isActive) { continue; }
+        PrototypePhysicsEvent event = {};
+        event.type                  = isActive ? PrototypePhysicsEventType_Wake : PrototypePhysicsEventType_Sleep;
+        event.object                = static_cast<PrototypeObject*>(collisionObject->getUserPointer());
+        gEvents.push_back(event);
+    }
+}
+
+void
+PrototypeBulletPhysics::setSceneActivity(const std::string& sceneName, PrototypePhysicsSceneActivity_ activity, f32 rate)
+{
+    PrototypePhysicsSceneActivity& sceneActivity = _sceneActivities[sceneName];
+    sceneActivity.activity                       = activity;
+    sceneActivity.rate                           = rate;
+    sceneActivity.accumulator                    = 0.0f;
+}
+
+f32
+PrototypeBulletPhysics::sceneTimestep(const std::string& sceneName, f32 deltaTime)
+{
+    auto it = _sceneActivities.find(sceneName);
+    if (it == _sceneActivities.end()) { return deltaTime; }
+    PrototypePhysicsSceneActivity& activity = it->second;
+    switch (activity.activity) {
+        case PrototypePhysicsSceneActivity_Paused: return 0.0f;
+        case PrototypePhysicsSceneActivity_Throttled: {
+            activity.accumulator += deltaTime;
+            if (activity.rate <= 0.0f || activity.accumulator < 1.0f / activity.rate) { return 0.0f; }
+            const f32 timestep   = activity.accumulator;
+            activity.accumulator = 0.0f;
+            return timestep;
+        }
+        default: return deltaTime;
+    }
+}
+
 void
 PrototypeBulletPhysics::fetchModelMatrix(void* rigidbody, void* shape, glm::mat4& model)
-{}
+{
+    auto _rigidbody = static_cast<btRigidBody*>(rigidbody);
+    _rigidbody->getWorldTransform().getOpenGLMatrix(&model[0][0]);
+}
+
+void
+PrototypeBulletPhysics::createColliderActor(PrototypeObject* object)
+{
+    Collider* collider = object->getColliderTrait();
+    switch (collider->shapeType()) {
+        case ColliderShape_Plane: {
+            createPlaneCollider(object);
+            collider->setNameRef("PLANE");
+        } break;
+
+        case ColliderShape_Box: {
+            createBoxCollider(object);
+            collider->setNameRef("CUBE");
+        } break;
+
+        case ColliderShape_Sphere: {
+            createSphereCollider(object);
+            collider->setNameRef("SPHERE");
+        } break;
+
+        case ColliderShape_Capsule: {
+            createCapsuleCollider(collider->radius(), collider->height(), collider->density(), object);
+            collider->setNameRef("CAPSULE");
+        } break;
+
+        case ColliderShape_ConvexMesh: {
+            const std::string                meshName = object->getMeshRendererTrait()->data()[0].mesh;
+            std::vector<glm::vec3>           vertices;
+            const PrototypeMeshBufferSource* source = PrototypeBulletMeshSource(meshName, vertices);
+            if (!source) { return; }
+            createConvexMeshCollider(vertices, source->indices, object);
+            collider->setNameRef(std::string("(CONVEX) ").append(meshName));
+        } break;
+
+        case ColliderShape_TriangleMesh: {
+            const std::string                meshName = object->getMeshRendererTrait()->data()[0].mesh;
+            std::vector<glm::vec3>           vertices;
+            const PrototypeMeshBufferSource* source = PrototypeBulletMeshSource(meshName, vertices);
+            if (!source) { return; }
+            createTriMeshCollider(vertices, source->indices, object);
+            collider->setNameRef(std::string("(TRIMESH) ").append(meshName));
+        } break;
+
+        default: {
+            PrototypeLogger::fatal("Unhandled collider type");
+        } break;
+    }
+}
 
 void
 PrototypeBulletPhysics::createPlaneCollider(PrototypeObject* object)
-{}
+{
+    // physx planes face +x in their local space, keep the same convention so rotations carry over
+    btCollisionShape* shape = new btStaticPlaneShape(btVector3(1.0f, 0.0f, 0.0f), 0.0f);
+    internalCreateRigidbody(object, shape, true, 0.0f);
+}
 
 void
 PrototypeBulletPhysics::createBoxCollider(PrototypeObject* object)
-{}
+{
+    const glm::vec3&  scale = object->getTransformTrait()->scale();
+    btCollisionShape* shape = new btBoxShape(btVector3(1.0f, 1.0f, 1.0f));
+    shape->setLocalScaling(btVector3(scale.x, scale.y, scale.z));
+    internalCreateRigidbody(object, shape, false, object->getRigidbodyTrait()->mass());
+}
 
 void
 PrototypeBulletPhysics::createSphereCollider(PrototypeObject* object)
-{}
+{
+    const glm::vec3&  scale = object->getTransformTrait()->scale();
+    btCollisionShape* shape = new btSphereShape(1.0f);
+    shape->setLocalScaling(btVector3(scale.x, scale.x, scale.x));
+    internalCreateRigidbody(object, shape, false, object->getRigidbodyTrait()->mass());
+}
 
 void
 PrototypeBulletPhysics::createCapsuleCollider(const float&     radius,
                                               const float&     halfHeight,
                                               const float&     density,
                                               PrototypeObject* object)
-{}
+{
+    // bullet capsules already stand on the y axis, the mass comes from the density like physx's updateMassAndInertia
+    btCollisionShape* shape  = new btCapsuleShape(radius, 2.0f * halfHeight);
+    const f32         volume = SIMD_PI * radius * radius * (2.0f * halfHeight + (4.0f / 3.0f) * radius);
+    internalCreateRigidbody(object, shape, false, density * volume);
+}
 
 void
 PrototypeBulletPhysics::createConvexMeshCollider(const std::vector<glm::vec3>& vertices,
                                                  const std::vector<u32>&       indices,
                                                  PrototypeObject*              object)
-{}
+{
+    if (vertices.empty()) {
+        PrototypeLogger::error("Convex mesh collider needs at least one vertex");
+        return;
+    }
+    const glm::vec3&   scale = object->getTransformTrait()->scale();
+    btConvexHullShape* shape = new btConvexHullShape((const btScalar*)vertices.data(), (int)vertices.size(), sizeof(glm::vec3));
+    shape->optimizeConvexHull();
+    shape->setLocalScaling(btVector3(scale.x, scale.y, scale.z));
+    internalCreateRigidbody(object, shape, false, object->getRigidbodyTrait()->mass());
+}
 
 void
 PrototypeBulletPhysics::createTriMeshCollider(const std::vector<glm::vec3>& vertices,
                                               const std::vector<u32>&       indices,
                                               PrototypeObject*              object)
-{}
+{
+    if (indices.size() < 3) {
+        PrototypeLogger::error("Triangle mesh collider needs at least one triangle");
+        return;
+    }
+    // bvh triangle meshes can only be static in bullet, same as the kinematic actor the physx backend creates
+    btTriangleMesh* mesh = new btTriangleMesh(true, false);
+    mesh->preallocateVertices((int)vertices.size());
+    mesh->preallocateIndices((int)indices.size());
+    for (const glm::vec3& v : vertices) { mesh->findOrAddVertex(btVector3(v.x, v.y, v.z), false); }
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        mesh->addTriangleIndices((int)indices[i + 0], (int)indices[i + 1], (int)indices[i + 2]);
+    }
+
+    const glm::vec3&        scale = object->getTransformTrait()->scale();
+    btBvhTriangleMeshShape* shape = new btBvhTriangleMeshShape(mesh, true);
+    shape->setLocalScaling(btVector3(scale.x, scale.y, scale.z));
+    internalCreateRigidbody(object, shape, true, 0.0f);
+    object->getRigidbodyTrait()->setStatic(true);
+}
 
 void
 PrototypeBulletPhysics::createStaticCollider(const std::vector<glm::vec3>& vertices,
                                              const std::vector<u32>&       indices,
                                              PrototypeObject*              object)
-{}
+{
+    createTriMeshCollider(vertices, indices, object);
+}
 
 void
 PrototypeBulletPhysics::createVehicle(const std::vector<glm::vec3>& chasisVertices,
@@ -141,91 +1203,492 @@ PrototypeBulletPhysics::createVehicle(const std::vector<glm::vec3>& chasisVertic
                                       PrototypeObject*              wheelFLObject,
                                       PrototypeObject*              wheelBRObject,
                                       PrototypeObject*              wheelBLObject)
-{}
+{
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Physics)
+
+    // the chasis box sits above the body origin so the suspension rays start right under it
+    btCompoundShape* chasisShape = new btCompoundShape();
+    btTransform      chasisLocal(btQuaternion::getIdentity(), btVector3(0.0f, 0.5f, 0.0f));
+    chasisShape->addChildShape(chasisLocal, new btBoxShape(gVehicleChasisHalfExtents));
+
+    btVector3 inertia(0.0f, 0.0f, 0.0f);
+    chasisShape->calculateLocalInertia(gVehicleChasisMass, inertia);
+    btRigidBody::btRigidBodyConstructionInfo info(gVehicleChasisMass, nullptr, chasisShape, inertia);
+    info.m_startWorldTransform.setIdentity();
+    info.m_startWorldTransform.setOrigin(
+      btVector3(0.0f, gVehicleChasisHalfExtents.y() + gVehicleWheelRadius + 1.0f, 0.0f));
+    btRigidBody* chasis = new btRigidBody(info);
+    chasis->setActivationState(DISABLE_DEACTIVATION);
+    chasis->setUserPointer((void*)chasisObject);
+    chasisShape->setUserPointer((void*)chasisObject);
+    gWorld->addRigidBody(chasis);
+
+    btRaycastVehicle::btVehicleTuning tuning;
+    btRaycastVehicle*                 vehicle = new btRaycastVehicle(tuning, chasis, gVehicleRaycaster);
+    vehicle->setCoordinateSystem(0, 1, 2);
+
+    // front wheels are at -z, the vehicle forward direction used by the physx backend
+    const btVector3 wheelDirection(0.0f, -1.0f, 0.0f);
+    const btVector3 wheelAxle(-1.0f, 0.0f, 0.0f);
+    const btScalar  wheelX              = gVehicleChasisHalfExtents.x() - 0.5f * gVehicleWheelWidth;
+    const btScalar  wheelY              = 0.5f - gVehicleChasisHalfExtents.y();
+    const btScalar  wheelZ              = gVehicleChasisHalfExtents.z() - gVehicleWheelRadius;
+    const btVector3 wheelConnections[4] = {
+        btVector3(wheelX, wheelY, -wheelZ), btVector3(-wheelX, wheelY, -wheelZ), // FR, FL
+        btVector3(wheelX, wheelY, wheelZ),  btVector3(-wheelX, wheelY, wheelZ)   // BR, BL
+    };
+    for (int w = 0; w < 4; ++w) {
+        const bool isFrontWheel = w < 2;
+        vehicle->addWheel(
+          wheelConnections[w], wheelDirection, wheelAxle, gVehicleSuspensionRest, gVehicleWheelRadius, tuning, isFrontWheel);
+        btWheelInfo& wheel               = vehicle->getWheelInfo(w);
+        wheel.m_suspensionStiffness      = 20.0f;
+        wheel.m_wheelsDampingRelaxation  = 2.3f;
+        wheel.m_wheelsDampingCompression = 4.4f;
+        wheel.m_frictionSlip             = 1000.0f;
+        wheel.m_rollInfluence            = 0.1f;
+    }
+    gWorld->addVehicle(vehicle);
+
+    VehicleChasis* vch = chasisObject->getVehicleChasisTrait();
+    vch->setVehicleRef(vehicle);
+    vch->setWheelFRObject(wheelFRObject);
+    vch->setWheelFLObject(wheelFLObject);
+    vch->setWheelBRObject(wheelBRObject);
+    vch->setWheelBLObject(wheelBLObject);
+    vch->setVehicleIndex(gVehicles->size());
+
+    // rest with the brakes on until something takes control
+    BulletVehicleData vehicleData = {};
+    vehicleData.vehicle           = vehicle;
+    vehicleData.chasisObject      = chasisObject;
+    vehicleData.brake             = 1.0f;
+    gVehicles->push_back(vehicleData);
+}
 
 void
 PrototypeBulletPhysics::updateVehicleController(PrototypeObject* object, f32 acceleration, f32 brake, f32 steer)
-{}
+{
+    VehicleChasis*     vch         = object->getVehicleChasisTrait();
+    BulletVehicleData& vehicleData = (*gVehicles)[vch->vehicleIndex()];
+    vehicleData.acceleration       = acceleration;
+    vehicleData.brake              = brake;
+    vehicleData.steer              = steer;
+}
 
 void
 PrototypeBulletPhysics::updateRigidbodyStatic(PrototypeObject* object)
-{}
+{
+    // a body can't switch between static and dynamic in place, build it again from the traits
+    updateCollider(object, std::string(object->getColliderTrait()->nameRef()));
+}
 
 void
 PrototypeBulletPhysics::updateRigidbodyTrigger(PrototypeObject* object)
-{}
+{
+    Rigidbody* rb        = object->getRigidbodyTrait();
+    auto       rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+    if (!rigidbody) { return; }
+    int flags = rigidbody->getCollisionFlags();
+    if (rb->isTrigger()) {
+        flags |= btCollisionObject::CF_NO_CONTACT_RESPONSE;
+    } else {
+        flags &= ~btCollisionObject::CF_NO_CONTACT_RESPONSE;
+    }
+    rigidbody->setCollisionFlags(flags);
+    rigidbody->activate(true);
+}
+
+void
+PrototypeBulletPhysics::updateRigidbodyEvents(PrototypeObject* object)
+{
+    Rigidbody* rb        = object->getRigidbodyTrait();
+    auto       rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+    if (!rigidbody) { return; }
+    rigidbody->setUserIndex2((int)rb->events());
+    rigidbody->setUserIndex3(-1);
+}
 
 void
 PrototypeBulletPhysics::updateRigidbodyLinearVelocity(PrototypeObject* object)
-{}
+{
+    Rigidbody* rb        = object->getRigidbodyTrait();
+    auto       rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+    if (!rigidbody || rb->isStatic()) { return; }
+    const glm::vec3& linearVelocity = rb->linearVelocity();
+    rigidbody->setLinearVelocity(btVector3(linearVelocity.x, linearVelocity.y, linearVelocity.z));
+    rigidbody->activate(true);
+}
 
 void
 PrototypeBulletPhysics::updateRigidbodyLinearDamping(PrototypeObject* object)
-{}
+{
+    Rigidbody* rb        = object->getRigidbodyTrait();
+    auto       rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+    if (!rigidbody || rb->isStatic()) { return; }
+    rigidbody->setDamping(rb->linearDamping(), rigidbody->getAngularDamping());
+}
 
 void
 PrototypeBulletPhysics::updateRigidbodyAngularVelocity(PrototypeObject* object)
-{}
+{
+    Rigidbody* rb        = object->getRigidbodyTrait();
+    auto       rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+    if (!rigidbody || rb->isStatic()) { return; }
+    const glm::vec3& angularVelocity = rb->angularVelocity();
+    rigidbody->setAngularVelocity(btVector3(angularVelocity.x, angularVelocity.y, angularVelocity.z));
+    rigidbody->activate(true);
+}
 
 void
 PrototypeBulletPhysics::updateRigidbodyAngularDamping(PrototypeObject* object)
-{}
+{
+    Rigidbody* rb        = object->getRigidbodyTrait();
+    auto       rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+    if (!rigidbody || rb->isStatic()) { return; }
+    rigidbody->setDamping(rigidbody->getLinearDamping(), rb->angularDamping());
+}
 
 void
 PrototypeBulletPhysics::updateRigidbodyMass(PrototypeObject* object)
-{}
+{
+    Rigidbody* rb        = object->getRigidbodyTrait();
+    auto       rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+    if (!rigidbody || rb->isStatic()) { return; }
+    // the world keeps bodies in static/dynamic buckets by mass, take it out while the mass changes
+    gWorld->removeRigidBody(rigidbody);
+    btVector3 inertia(0.0f, 0.0f, 0.0f);
+    rigidbody->getCollisionShape()->calculateLocalInertia(rb->mass(), inertia);
+    rigidbody->setMassProps(rb->mass(), inertia);
+    rigidbody->updateInertiaTensor();
+    gWorld->addRigidBody(rigidbody);
+    rigidbody->activate(true);
+}
 
 void
 PrototypeBulletPhysics::updateRigidbodyLockLinear(PrototypeObject* object)
-{}
+{
+    Rigidbody* rb        = object->getRigidbodyTrait();
+    auto       rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+    if (!rigidbody || rb->isStatic()) { return; }
+    rigidbody->setLinearFactor(
+      btVector3(rb->lockLinearX() ? 0.0f : 1.0f, rb->lockLinearY() ? 0.0f : 1.0f, rb->lockLinearZ() ? 0.0f : 1.0f));
+}
 
 void
 PrototypeBulletPhysics::updateRigidbodyLockAngular(PrototypeObject* object)
-{}
+{
+    Rigidbody* rb        = object->getRigidbodyTrait();
+    auto       rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+    if (!rigidbody || rb->isStatic()) { return; }
+    rigidbody->setAngularFactor(
+      btVector3(rb->lockAngularX() ? 0.0f : 1.0f, rb->lockAngularY() ? 0.0f : 1.0f, rb->lockAngularZ() ? 0.0f : 1.0f));
+}
 
 void
 PrototypeBulletPhysics::updateCollider(PrototypeObject* object, const std::string& shapeName)
-{}
+{
+    Collider*  collider = object->getColliderTrait();
+    Rigidbody* rb       = object->getRigidbodyTrait();
+    if (!rb) return;
+
+    std::vector<glm::vec3>           vertices;
+    const PrototypeMeshBufferSource* source = nullptr;
+    if (shapeName.rfind("(CONVEX) ", 0) == 0) {
+        source = PrototypeBulletMeshSource(shapeName.substr(strlen("(CONVEX) ")), vertices);
+        if (!source) { return; }
+    } else if (shapeName.rfind("(TRIMESH) ", 0) == 0) {
+        source = PrototypeBulletMeshSource(shapeName.substr(strlen("(TRIMESH) ")), vertices);
+        if (!source) { return; }
+    } else if (shapeName != "PLANE" && shapeName != "CUBE" && shapeName != "SPHERE" && shapeName != "CAPSULE") {
+        return;
+    }
+
+    if (rb->rigidbodyRef()) {
+        internalDestroyRigidbody(static_cast<btRigidBody*>(rb->rigidbodyRef()));
+        rb->setRigidbodyRef(nullptr);
+        collider->setShapeRef(nullptr);
+    }
+
+    if (shapeName == "PLANE") {
+        createPlaneCollider(object);
+    } else if (shapeName == "CUBE") {
+        createBoxCollider(object);
+    } else if (shapeName == "SPHERE") {
+        createSphereCollider(object);
+    } else if (shapeName == "CAPSULE") {
+        createCapsuleCollider(collider->radius(), collider->height(), collider->density(), object);
+    } else if (shapeName.rfind("(CONVEX) ", 0) == 0) {
+        createConvexMeshCollider(vertices, source->indices, object);
+    } else {
+        createTriMeshCollider(vertices, source->indices, object);
+    }
+    collider->setNameRef(shapeName);
+}
+
+void
+PrototypeBulletPhysics::updateColliderLayer(PrototypeObject* object)
+{
+    if (!object->hasColliderTrait() || !object->hasRigidbodyTrait()) { return; }
+    auto rigidbody = static_cast<btRigidBody*>(object->getRigidbodyTrait()->rigidbodyRef());
+    if (!rigidbody) { return; }
+    rigidbody->setUserIndex((int)object->getColliderTrait()->layer());
+    // drops the cached pairs of the body so the layer filter sees them again
+    gWorld->refreshBroadphaseProxy(rigidbody);
+}
 
 void
 PrototypeBulletPhysics::scaleCollider(PrototypeObject* object, const glm::vec3& scale)
-{}
+{
+    if (object->hasColliderTrait()) {
+        Collider*  collider  = object->getColliderTrait();
+        Rigidbody* rb        = object->getRigidbodyTrait();
+        auto       rigidbody = static_cast<btRigidBody*>(rb->rigidbodyRef());
+        auto       shape     = static_cast<btCollisionShape*>(collider->shapeRef());
+        if (!rigidbody || !shape) { return; }
+        // planes are infinite and capsules are sized from the collider trait
+        if (collider->shapeType() == ColliderShape_Plane || collider->shapeType() == ColliderShape_Capsule) { return; }
+        if (shape->getShapeType() == SPHERE_SHAPE_PROXYTYPE) {
+            shape->setLocalScaling(btVector3(scale.x, scale.x, scale.x));
+        } else {
+            shape->setLocalScaling(btVector3(scale.x, scale.y, scale.z));
+        }
+        if (!rb->isStatic()) {
+            btVector3 inertia(0.0f, 0.0f, 0.0f);
+            shape->calculateLocalInertia(rigidbody->getMass(), inertia);
+            rigidbody->setMassProps(rigidbody->getMass(), inertia);
+            rigidbody->updateInertiaTensor();
+        }
+        gWorld->updateSingleAabb(rigidbody);
+        rigidbody->activate(true);
+    }
+}
 
 void
 PrototypeBulletPhysics::createRigidbody(PrototypeObject* object)
-{}
+{
+    Collider*  collider  = object->getColliderTrait();
+    Rigidbody* rigidbody = object->getRigidbodyTrait();
+    if (rigidbody->isStatic()) {
+        if (object->hasMeshRendererTrait()) {
+            MeshRenderer*          mr       = object->getMeshRendererTrait();
+            const std::string&     meshName = mr->data()[0].mesh;
+            std::vector<glm::vec3> vertices;
+            auto                   source = PrototypeBulletMeshSource(meshName, vertices);
+            if (source) {
+                createTriMeshCollider(vertices, source->indices, &(*object));
+                collider->setNameRef(std::string("(TRIMESH) ").append(meshName));
+                return;
+            }
+        }
+        createBoxCollider(&(*object));
+        collider->setNameRef("CUBE");
+    } else {
+        switch (collider->shapeType()) {
+            case ColliderShape_Plane: {
+                createPlaneCollider(&(*object));
+                collider->setNameRef("PLANE");
+            } break;
+
+            case ColliderShape_Box: {
+                createBoxCollider(&(*object));
+                collider->setNameRef("CUBE");
+            } break;
+
+            case ColliderShape_Sphere: {
+                createSphereCollider(&(*object));
+                collider->setNameRef("SPHERE");
+            } break;
+
+            case ColliderShape_Capsule: {
+                createCapsuleCollider(collider->radius(), collider->height(), collider->density(), &(*object));
+                collider->setNameRef("CAPSULE");
+            } break;
+
+            case ColliderShape_ConvexMesh:
+            case ColliderShape_TriangleMesh: {
+                if (object->hasMeshRendererTrait()) {
+                    const std::string      meshName = object->getMeshRendererTrait()->data()[0].mesh;
+                    std::vector<glm::vec3> vertices;
+                    auto                   source = PrototypeBulletMeshSource(meshName, vertices);
+                    if (source) {
+                        if (collider->shapeType() == ColliderShape_ConvexMesh) {
+                            createConvexMeshCollider(vertices, source->indices, &(*object));
+                            collider->setNameRef(std::string("(CONVEX) ").append(meshName));
+                        } else {
+                            createTriMeshCollider(vertices, source->indices, &(*object));
+                            collider->setNameRef(std::string("(TRIMESH) ").append(meshName));
+                        }
+                        return;
+                    }
+                }
+                createBoxCollider(&(*object));
+                collider->setNameRef("CUBE");
+            } break;
+
+            default: {
+                PrototypeLogger::fatal("Unhandled collider type");
+            } break;
+        }
+    }
+}
 
 void
 PrototypeBulletPhysics::destroyRigidbody(void* rigidbody)
+{
+    if (!rigidbody) return;
+    auto             body   = static_cast<btRigidBody*>(rigidbody);
+    PrototypeObject* object = static_cast<PrototypeObject*>(body->getUserPointer());
+    if (object && object->hasColliderTrait()) { object->getColliderTrait()->setShapeRef(nullptr); }
+    internalDestroyRigidbody(body);
+}
+
+void
+PrototypeBulletPhysics::beginActorBatch()
 {}
 
 void
-PrototypeBulletPhysics::spawnVehicle()
+PrototypeBulletPhysics::endActorBatch()
 {}
 
+void
+PrototypeBulletPhysics::setRigidbodyActive(PrototypeObject* object, bool active)
+{
+    if (!object || !object->hasRigidbodyTrait()) return;
+    Rigidbody* rb   = object->getRigidbodyTrait();
+    auto       body = static_cast<btRigidBody*>(rb->rigidbodyRef());
+    if (!body) return;
+    if (!active) {
+        if (!body->isInWorld()) return;
+        internalForgetTouchingPairs(body);
+        gWorld->removeRigidBody(body);
+        return;
+    }
+    if (body->isInWorld()) return;
+    // set before adding the body back, the broadphase proxy gets created from its world transform
+    Transform*  tr = object->getTransformTrait();
+    btTransform t;
+    t.setFromOpenGLMatrix(&tr->worldModel()[0][0]);
+    body->setWorldTransform(t);
+    body->setInterpolationWorldTransform(t);
+    tr->setNeedsPhysicsSync(false);
+    if (!body->isStaticObject()) {
+        const glm::vec3& linearVelocity  = rb->linearVelocity();
+        const glm::vec3& angularVelocity = rb->angularVelocity();
+        body->setLinearVelocity(btVector3(linearVelocity.x, linearVelocity.y, linearVelocity.z));
+        body->setAngularVelocity(btVector3(angularVelocity.x, angularVelocity.y, angularVelocity.z));
+        body->clearForces();
+    }
+    gWorld->addRigidBody(body);
+    body->activate(true);
+}
+
+void
+PrototypeBulletPhysics::createActors(PrototypeObject* const* objects, size_t count)
+{
+    // the record pass creates the actors of every object of a scene it meets for the first time
+    if (_scenes.find(PrototypeEngineInternalApplication::scene->name()) == _scenes.end()) return;
+    std::vector<PrototypeObject*> colliderObjects;
+    colliderObjects.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        PrototypeObject* object = objects[i];
+        if (object && object->hasTransformTrait() && object->hasColliderTrait() && object->hasRigidbodyTrait()) {
+            colliderObjects.push_back(object);
+        }
+    }
+    std::sort(colliderObjects.begin(), colliderObjects.end(), [](PrototypeObject* a, PrototypeObject* b) {
+        return a->id() < b->id();
+    });
+    beginActorBatch();
+    for (auto& colliderObject : colliderObjects) { createColliderActor(colliderObject); }
+    endActorBatch();
+}
+
+void
+PrototypeBulletPhysics::spawnVehicle()
+{
+    if (gVehicles->empty()) { return; }
+    if (*gControlledVehicleIndex < gVehicles->size()) {
+        vehicleReleaseAllControls(*gControlledVehicleIndex);
+        (*gVehicles)[*gControlledVehicleIndex].brake = 1.0f;
+    }
+    *gControlledVehicleIndex = gVehicles->size() - 1;
+    vehicleReleaseAllControls(*gControlledVehicleIndex);
+    (*gVehicles)[*gControlledVehicleIndex].reverse = false;
+    (*gVehicles)[*gControlledVehicleIndex].brake   = 1.0f;
+    const btVector3& p = (*gVehicles)[*gControlledVehicleIndex].vehicle->getRigidBody()->getWorldTransform().getOrigin();
+    vehicleResetPose(*gControlledVehicleIndex, btVector3(p.x(), 5.0f, p.z()));
+}
+
 void
 PrototypeBulletPhysics::toggleVehicleAccessControl(PrototypeObject* object)
 {}
 
 void
 PrototypeBulletPhysics::requestNextVehicleAccessControl()
-{}
+{
+    if (gVehicles->empty()) {
+        *gControlledVehicleIndex = -1;
+    } else {
+        size_t numVehicles = gVehicles->size();
+        if (*gControlledVehicleIndex < numVehicles) {
+            vehicleReleaseAllControls(*gControlledVehicleIndex);
+            (*gVehicles)[*gControlledVehicleIndex].brake = 1.0f;
+        }
+        *gControlledVehicleIndex = (*gControlledVehicleIndex % numVehicles + numVehicles - 1) % numVehicles;
+        vehicleReleaseAllControls(*gControlledVehicleIndex);
+        (*gVehicles)[*gControlledVehicleIndex].reverse = false;
+        (*gVehicles)[*gControlledVehicleIndex].brake   = 1.0f;
+        vehicleResetPose(*gControlledVehicleIndex, btVector3(0.0f, 5.0f, 0.0f));
+    }
+}
 
 void
 PrototypeBulletPhysics::requestPreviousVehicleAccessControl()
-{}
+{
+    if (gVehicles->empty()) {
+        *gControlledVehicleIndex = -1;
+    } else {
+        size_t numVehicles = gVehicles->size();
+        if (*gControlledVehicleIndex < numVehicles) {
+            vehicleReleaseAllControls(*gControlledVehicleIndex);
+            (*gVehicles)[*gControlledVehicleIndex].brake = 1.0f;
+        }
+        *gControlledVehicleIndex = (*gControlledVehicleIndex + 1) % numVehicles;
+        vehicleReleaseAllControls(*gControlledVehicleIndex);
+        (*gVehicles)[*gControlledVehicleIndex].reverse = false;
+        (*gVehicles)[*gControlledVehicleIndex].brake   = 1.0f;
+        const btVector3& p = (*gVehicles)[*gControlledVehicleIndex].vehicle->getRigidBody()->getWorldTransform().getOrigin();
+        vehicleResetPose(*gControlledVehicleIndex, btVector3(p.x(), 5.0f, p.z()));
+    }
+}
 
 void
 PrototypeBulletPhysics::controlledVehiclesSetGear(PrototypePhysicsVehicleGear gear)
-{}
+{
+    // raycast vehicles have no gearbox, only the direction of the engine force is kept
+    if (*gControlledVehicleIndex >= gVehicles->size()) { return; }
+    (*gVehicles)[*gControlledVehicleIndex].reverse = gear == PrototypePhysicsVehicleGear::Reverse;
+}
 
 void
 PrototypeBulletPhysics::controlledVehiclesToggleGearDirection()
-{}
+{
+    if (*gControlledVehicleIndex >= gVehicles->size()) { return; }
+    (*gVehicles)[*gControlledVehicleIndex].reverse = !(*gVehicles)[*gControlledVehicleIndex].reverse;
+}
 
 void
 PrototypeBulletPhysics::controlledVehiclesFlip()
-{}
+{
+    if (*gControlledVehicleIndex < gVehicles->size()) {
+        vehicleReleaseAllControls(*gControlledVehicleIndex);
+        (*gVehicles)[*gControlledVehicleIndex].reverse = false;
+        (*gVehicles)[*gControlledVehicleIndex].brake   = 1.0f;
+        const btVector3& p = (*gVehicles)[*gControlledVehicleIndex].vehicle->getRigidBody()->getWorldTransform().getOrigin();
+        vehicleResetPose(*gControlledVehicleIndex, btVector3(p.x(), p.y() + 1.0f, p.z()));
+    }
+}
 
 void
 PrototypeBulletPhysics::onMouse(i32 button, i32 action, i32 mods)
@@ -14,11 +14,87 @@
 
 #pragma once
 
+#include "../../include/PrototypeEngine/PrototypeEngineApi.h"
+
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <LinearMath/btThreads.h>
+#include <btBulletDynamicsCommon.h>
+
+#include "../core/PrototypeCollisionLayers.h"
 #include "../core/PrototypePhysics.h"
+#include "../core/PrototypeThreadpool.h"
 
 #include <PrototypeCommon/Maths.h>
 
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 struct PrototypeObject;
+struct Transform;
+
+struct BulletVehicleData
+{
+    btRaycastVehicle* vehicle;
+    PrototypeObject*  chasisObject;
+    f32               acceleration;
+    f32               brake;
+    f32               steer;
+    bool              reverse;
+};
+
+// rejects the broadphase pairs of collision layers that don't interact, the layer of a collision object is its user index
+struct PrototypeBulletLayerFilter final : btOverlapFilterCallback
+{
+    explicit PrototypeBulletLayerFilter(const PrototypeCollisionLayers& collisionLayers);
+    ~PrototypeBulletLayerFilter() final = default;
+
+    bool needBroadphaseCollision(btBroadphaseProxy* proxy0, btBroadphaseProxy* proxy1) const final;
+
+  private:
+    std::array<u32, PROTOTYPE_MAX_COLLISION_LAYERS> _matrix;
+};
+
+// two bodies whose manifold had contacts after a step and that report events, the lower address first
+typedef std::pair<const btCollisionObject*, const btCollisionObject*> BulletTouchingPair;
+
+struct BulletSceneData
+{
+    btBroadphaseInterface*         broadphase;
+    btCollisionDispatcher*         dispatcher;
+    btConstraintSolverPoolMt*      solverPool;
+    btConstraintSolver*            solver;
+    btDiscreteDynamicsWorld*       world;
+    btVehicleRaycaster*            vehicleRaycaster;
+    PrototypeBulletLayerFilter*    layerFilter;
+    std::vector<BulletVehicleData> vehicles;
+    size_t                         controlledVehicleIndex;
+    // sorted, the step's touching pairs get diffed against them to tell found contacts and triggers from lost ones
+    std::vector<BulletTouchingPair> touchingPairs;
+};
+
+// runs bullet's parallel loops (narrowphase, island solving, integration) on the engine threadpool at high priority,
+// the calling thread always takes the first chunk and helps with the rest while it waits
+struct PrototypeBulletTaskScheduler final : btITaskScheduler
+{
+    explicit PrototypeBulletTaskScheduler(PrototypeThreadpool* threadpool);
+    ~PrototypeBulletTaskScheduler() final = default;
+
+    int      getMaxNumThreads() const final;
+    int      getNumThreads() const final;
+    void     setNumThreads(int numThreads) final;
+    void     parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body) final;
+    btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body) final;
+
+  private:
+    // splits [iBegin, iEnd) in at most _numThreads ranges of at least grainSize elements, returns the ranges count
+    int split(int iBegin, int iEnd, int grainSize, int* begins, int* ends) const;
+
+    PrototypeThreadpool* _threadpool;
+    int                  _maxNumThreads;
+    int                  _numThreads;
+};
 
 struct PrototypeBulletPhysics final : PrototypePhysics
 {
@@ -52,11 +128,35 @@ struct PrototypeBulletPhysics final : PrototypePhysics
     // check if simulation is playing
     bool isPlaying() final;
 
+    // switch the lockstep mode on or off, call before the first record pass so the scenes get created accordingly
+    void setLockstep(const PrototypePhysicsLockstep& lockstep) final;
+
+    // current lockstep mode
+    const PrototypePhysicsLockstep& lockstep() final;
+
+    // hash of the object ids, poses and velocities of the dynamic bodies of the current scene as of the last step
+    u64 stateHash() final;
+
     // force move the rigidbody from a random transformation, overwrite the simulation constraints and forces etc ..
     void overrideRigidbodyGlobalPos(PrototypeObject* object) final;
 
-    // shoot a ray to the unknown from a point and a direction and length of the ray
-    std::optional<PrototypeObject*> raycast(const glm::vec3& origin, const glm::vec3& dir, f32 length) final;
+    // shoot a ray to the unknown from a point and a direction and length of the ray, restricted to the layers of layerMask
+    std::optional<PrototypeObject*> raycast(const glm::vec3& origin, const glm::vec3& dir, f32 length, u32 layerMask) final;
+
+    // run count queries split across the physics worker threads and wait for them, hits[i] is the result of queries[i]
+    void queryBatch(const PrototypePhysicsQuery* queries, size_t count, PrototypePhysicsQueryHit* hits) final;
+
+    // queue count queries to run as a batch at the end of the next update after the simulation step
+    void submitQueryBatch(const PrototypePhysicsQuery* queries, size_t count, PrototypePhysicsQueryHit* hits) final;
+
+    // how the physics scene of the named PrototypeScene gets stepped, only the current scene is ever stepped here
+    void setSceneActivity(const std::string& sceneName, PrototypePhysicsSceneActivity_ activity, f32 rate) final;
+
+    // pair counts of the current scene, counted from the pair cache and the dispatcher manifolds
+    void fetchStatistics(PrototypePhysicsStatistics& statistics) final;
+
+    // contact, trigger and sleep events of the last step, bullet has no callbacks for them so they're diffed after the step
+    const std::vector<PrototypePhysicsEvent>& events() final;
 
     // get the model matrix for the given rigidbody
     void fetchModelMatrix(void* rigidbody, void* shape, glm::mat4& model) final;
@@ -108,6 +208,9 @@ struct PrototypeBulletPhysics final : PrototypePhysics
     // update the rigidbody for whther it's trigger or not
     void updateRigidbodyTrigger(PrototypeObject* object) final;
 
+    // update which physics events get generated for the rigidbody, they're kept in the user index 2 of the body
+    void updateRigidbodyEvents(PrototypeObject* object) final;
+
     // overwrite the simulation's linear velocity for the given object's rigidbody
     void updateRigidbodyLinearVelocity(PrototypeObject* object) final;
 
@@ -132,6 +235,9 @@ struct PrototypeBulletPhysics final : PrototypePhysics
     // changes collider for the given object
     void updateCollider(PrototypeObject* object, const std::string& shapeName) final;
 
+    // moves the collider of the given object to the collision layer of its collider trait
+    void updateColliderLayer(PrototypeObject* object) final;
+
     // scales collider for the given object
     void scaleCollider(PrototypeObject* object, const glm::vec3& scale) final;
 
@@ -141,6 +247,16 @@ struct PrototypeBulletPhysics final : PrototypePhysics
     // destroys a rigidbody
     void destroyRigidbody(void* rigidbody) final;
 
+    // bullet inserts the bodies in its broadphase one at a time either way, the batch only keeps the api symmetric
+    void beginActorBatch() final;
+    void endActorBatch() final;
+
+    // takes the body of the object out of the world without destroying it, or puts it back
+    void setRigidbodyActive(PrototypeObject* object, bool active) final;
+
+    // creates the actors of objects that joined the current scene after its physics scene got recorded
+    void createActors(PrototypeObject* const* objects, size_t count) final;
+
     // spawn a new vehicle
     void spawnVehicle() final;
 
@@ -184,7 +300,41 @@ struct PrototypeBulletPhysics final : PrototypePhysics
     void onWindowDragDrop(i32 numFiles, const char** names) final;
 
   private:
-    static bool _isPlaying;
-
-    bool _needsRecord;
+    // creates the body of the object out of its collider trait shape
+    void        createColliderActor(PrototypeObject* object);
+    static void vehicleReleaseAllControls(size_t vehicleIndex);
+    static void vehicleResetPose(size_t vehicleIndex, const btVector3& position);
+    static void vehicleApplyControls();
+    static void vehicleSyncTransforms();
+    // copies the simulated pose (and velocities when asked) of the body back to the object's traits
+    static void pullRigidbody(PrototypeObject* object, btRigidBody* rigidbody, bool syncVelocities);
+    // moves the body to the transform that was edited outside the simulation
+    static void pushRigidbody(Transform* tr, btRigidBody* rigidbody);
+    static void internalCreateRigidbody(PrototypeObject* object, btCollisionShape* shape, bool forceStatic, f32 mass);
+    static void internalDestroyRigidbody(btRigidBody* rigidbody);
+    // a body leaving the world doesn't get to report lost contacts
+    static void internalForgetTouchingPairs(btRigidBody* rigidbody);
+    static void internalDestroyShape(btCollisionShape* shape);
+    // the time to step the named scene by this update given its activity, 0 when it shouldn't be stepped
+    static f32 sceneTimestep(const std::string& sceneName, f32 deltaTime);
+    // walks the manifolds and the sleep opted in bodies after a step and appends the events they changed to gEvents
+    static void collectEvents();
+
+    static PrototypeBulletTaskScheduler*                     gTaskScheduler;
+    static btDefaultCollisionConfiguration*                  gCollisionConfiguration;
+    static btDiscreteDynamicsWorld*                          gWorld;
+    static btVehicleRaycaster*                               gVehicleRaycaster;
+    static std::vector<BulletVehicleData>*                   gVehicles;
+    static size_t*                                           gControlledVehicleIndex;
+    static std::vector<BulletTouchingPair>*                  gTouchingPairs;
+    static std::vector<BulletTouchingPair>                   gTouchingPairsScratch;
+    static std::vector<PrototypePhysicsEvent>                gEvents;
+    static bool                                              _isPlaying;
+    bool                                                     _needsRecord;
+    PrototypePhysicsLockstep                                 _lockstep;
+    std::vector<PrototypePhysicsQueryBatch>                  _queryBatches;
+    static std::unordered_map<std::string, BulletSceneData> _scenes;
+
+    // stepping policy by scene name, scenes without an entry are active
+    static std::unordered_map<std::string, PrototypePhysicsSceneActivity> _sceneActivities;
 };
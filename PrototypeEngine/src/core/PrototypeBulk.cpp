@@ -0,0 +1,260 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#include "PrototypeBulk.h"
+
+#include "PrototypeEngine.h"
+#include "PrototypePhysics.h"
+#include "PrototypeShortcuts.h"
+#include "PrototypeThreadpool.h"
+
+#include <PrototypeCommon/Maths.h>
+#include <PrototypeCommon/Tracer.h>
+
+#include <PrototypeTraitSystem/PrototypeTraitSystem.h>
+
+template<typename T>
+static inline T&
+strided(T* values, size_t stride, size_t i)
+{
+    return *(T*)((u8*)values + i * (stride == 0 ? sizeof(T) : stride));
+}
+
+template<typename T>
+static inline const T&
+strided(const T* values, size_t stride, size_t i)
+{
+    return *(const T*)((const u8*)values + i * (stride == 0 ? sizeof(T) : stride));
+}
+
+// runs fn(object, i) for every object that has a transform trait, split across the threadpool
+template<typename Fn>
+static void
+forEachTransform(PrototypeObject* const* objects, size_t count, const Fn& fn)
+{
+    PrototypeEngineInternalApplication::threadpool->parallelFor(
+      count, PROTOTYPE_BULK_GRAIN_SIZE, [objects, &fn](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+              PrototypeObject* o = objects[i];
+              if (o && o->hasTransformTrait()) { fn(o->getTransformTrait(), i); }
+          }
+      });
+}
+
+// runs fn(transform, i) like forEachTransform, then composes the models of each worker range out of the components in
+// one batched call, they're already in sync so there is nothing to decompose later
+template<typename Fn>
+static void
+forEachTransformComposed(PrototypeObject* const* objects, size_t count, const Fn& fn)
+{
+    PrototypeEngineInternalApplication::threadpool->parallelFor(
+      count, PROTOTYPE_BULK_GRAIN_SIZE, [objects, &fn](size_t begin, size_t end) {
+          Transform* transforms[PROTOTYPE_BULK_GRAIN_SIZE];
+          size_t     batched = 0;
+          for (size_t i = begin; i < end; ++i) {
+              PrototypeObject* o = objects[i];
+              if (!o || !o->hasTransformTrait()) { continue; }
+              Transform* transform = o->getTransformTrait();
+              fn(transform, i);
+              transforms[batched++] = transform;
+              if (batched == PROTOTYPE_BULK_GRAIN_SIZE) {
+                  Transform::updateMatricesFromComponents(transforms, batched);
+                  batched = 0;
+              }
+          }
+          Transform::updateMatricesFromComponents(transforms, batched);
+      });
+}
+
+template<typename Fn>
+static void
+forEachRigidbody(PrototypeObject* const* objects, size_t count, const Fn& fn)
+{
+    PrototypeEngineInternalApplication::threadpool->parallelFor(
+      count, PROTOTYPE_BULK_GRAIN_SIZE, [objects, &fn](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+              PrototypeObject* o = objects[i];
+              if (o && o->hasRigidbodyTrait()) { fn(o->getRigidbodyTrait(), i); }
+          }
+      });
+}
+
+// the physics sync list isn't thread safe, flag the colliders once the parallel part is done
+static void
+syncColliders(PrototypeObject* const* objects, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        PrototypeObject* o = objects[i];
+        if (o && o->hasTransformTrait() && o->hasColliderTrait()) { o->getTransformTrait()->setNeedsPhysicsSync(true); }
+    }
+}
+
+void
+PrototypeBulk::getTranslations(PrototypeObject* const* objects, size_t count, glm::vec3* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachTransform(objects, count, [values, stride](Transform* transform, size_t i) {
+        strided(values, stride, i) = transform->position();
+    });
+}
+
+void
+PrototypeBulk::setTranslations(PrototypeObject* const* objects, size_t count, const glm::vec3* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachTransformComposed(objects, count, [values, stride](Transform* transform, size_t i) {
+        transform->positionMut() = strided(values, stride, i);
+    });
+    syncColliders(objects, count);
+}
+
+void
+PrototypeBulk::getRotations(PrototypeObject* const* objects, size_t count, glm::vec3* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachTransform(objects, count, [values, stride](Transform* transform, size_t i) {
+        strided(values, stride, i) = transform->rotation();
+    });
+}
+
+void
+PrototypeBulk::setRotations(PrototypeObject* const* objects, size_t count, const glm::vec3* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachTransformComposed(objects, count, [values, stride](Transform* transform, size_t i) {
+        transform->rotationMut() = strided(values, stride, i);
+    });
+    syncColliders(objects, count);
+}
+
+void
+PrototypeBulk::getScales(PrototypeObject* const* objects, size_t count, glm::vec3* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachTransform(objects, count, [values, stride](Transform* transform, size_t i) {
+        strided(values, stride, i) = transform->scale();
+    });
+}
+
+void
+PrototypeBulk::setScales(PrototypeObject* const* objects, size_t count, const glm::vec3* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachTransformComposed(objects, count, [values, stride](Transform* transform, size_t i) {
+        transform->scaleMut() = strided(values, stride, i);
+    });
+    for (size_t i = 0; i < count; ++i) {
+        PrototypeObject* o = objects[i];
+        if (o && o->hasTransformTrait() && o->hasColliderTrait()) {
+            PrototypeEngineInternalApplication::physics->scaleCollider(o, o->getTransformTrait()->scale());
+        }
+    }
+}
+
+void
+PrototypeBulk::getModels(PrototypeObject* const* objects, size_t count, glm::mat4* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachTransform(objects, count, [values, stride](Transform* transform, size_t i) {
+        strided(values, stride, i) = transform->modelScaled();
+    });
+}
+
+void
+PrototypeBulk::setModels(PrototypeObject* const* objects, size_t count, const glm::mat4* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachTransform(objects, count, [values, stride](Transform* transform, size_t i) {
+        const glm::mat4& model = strided(values, stride, i);
+        transform->setModelScaled(&model[0][0]);
+        transform->updateComponentsFromMatrix();
+        // decompose here while on the workers, then derive the unscaled model out of the new scale
+        transform->scale();
+        transform->setModelScaled(&model[0][0]);
+    });
+    syncColliders(objects, count);
+}
+
+void
+PrototypeBulk::getLinearVelocities(PrototypeObject* const* objects, size_t count, glm::vec3* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachRigidbody(objects, count, [values, stride](Rigidbody* rigidbody, size_t i) {
+        strided(values, stride, i) = rigidbody->linearVelocity();
+    });
+}
+
+void
+PrototypeBulk::setLinearVelocities(PrototypeObject* const* objects, size_t count, const glm::vec3* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachRigidbody(objects, count, [values, stride](Rigidbody* rigidbody, size_t i) {
+        rigidbody->setLinearVelocity(strided(values, stride, i));
+    });
+    for (size_t i = 0; i < count; ++i) {
+        PrototypeObject* o = objects[i];
+        if (o && o->hasRigidbodyTrait()) { PrototypeEngineInternalApplication::physics->updateRigidbodyLinearVelocity(o); }
+    }
+}
+
+void
+PrototypeBulk::getAngularVelocities(PrototypeObject* const* objects, size_t count, glm::vec3* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachRigidbody(objects, count, [values, stride](Rigidbody* rigidbody, size_t i) {
+        strided(values, stride, i) = rigidbody->angularVelocity();
+    });
+}
+
+void
+PrototypeBulk::setAngularVelocities(PrototypeObject* const* objects, size_t count, const glm::vec3* values, size_t stride)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    forEachRigidbody(objects, count, [values, stride](Rigidbody* rigidbody, size_t i) {
+        rigidbody->setAngularVelocity(strided(values, stride, i));
+    });
+    for (size_t i = 0; i < count; ++i) {
+        PrototypeObject* o = objects[i];
+        if (o && o->hasRigidbodyTrait()) { PrototypeEngineInternalApplication::physics->updateRigidbodyAngularVelocity(o); }
+    }
+}
+
+void
+PrototypeBulk::spawnCubes(size_t            count,
+                          const glm::vec3*  positions,
+                          size_t            positionsStride,
+                          const glm::vec3*  velocities,
+                          size_t            velocitiesStride,
+                          PrototypeObject** spawned)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    const glm::vec3 zero = { 0.0f, 0.0f, 0.0f };
+    // the rigidbodies reach the physics scene together when the batch ends
+    PrototypeEngineInternalApplication::physics->beginActorBatch();
+    for (size_t i = 0; i < count; ++i) {
+        const glm::vec3& velocity = velocities ? strided(velocities, velocitiesStride, i) : zero;
+        PrototypeObject* object   = shortcutSpawnCube(strided(positions, positionsStride, i), zero, velocity);
+        if (spawned) { spawned[i] = object; }
+    }
+    PrototypeEngineInternalApplication::physics->endActorBatch();
+}
+
+void
+PrototypeBulk::destroy(PrototypeObject* const* objects, size_t count)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    for (size_t i = 0; i < count; ++i) {
+        if (objects[i]) { objects[i]->destroy(); }
+    }
+}
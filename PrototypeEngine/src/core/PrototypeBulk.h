@@ -0,0 +1,63 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#pragma once
+
+#include <PrototypeCommon/Definitions.h>
+#include <PrototypeCommon/Types.h>
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+#define PROTOTYPE_BULK_GRAIN_SIZE 256 // objects per range below which splitting the work costs more than it saves
+
+struct PrototypeObject;
+
+// Reads and writes a trait field of many objects in one call, the per object work is split across the engine threadpool.
+// Values are strided, stride is the distance in bytes between two consecutive values and 0 means tightly packed.
+// An object must not be listed twice in the same call, null objects and objects missing the trait are skipped.
+// Whatever reaches the physics backend runs serially on the calling thread after the parallel part.
+struct PrototypeBulk
+{
+    PrototypeBulk()  = delete;
+    ~PrototypeBulk() = delete;
+
+    static void getTranslations(PrototypeObject* const* objects, size_t count, glm::vec3* values, size_t stride);
+    static void setTranslations(PrototypeObject* const* objects, size_t count, const glm::vec3* values, size_t stride);
+    // euler angles in degrees
+    static void getRotations(PrototypeObject* const* objects, size_t count, glm::vec3* values, size_t stride);
+    static void setRotations(PrototypeObject* const* objects, size_t count, const glm::vec3* values, size_t stride);
+    // sets the absolute scale, unlike TransformTraitSetScale which adds to it
+    static void getScales(PrototypeObject* const* objects, size_t count, glm::vec3* values, size_t stride);
+    static void setScales(PrototypeObject* const* objects, size_t count, const glm::vec3* values, size_t stride);
+    // the scaled model matrices
+    static void getModels(PrototypeObject* const* objects, size_t count, glm::mat4* values, size_t stride);
+    static void setModels(PrototypeObject* const* objects, size_t count, const glm::mat4* values, size_t stride);
+
+    static void getLinearVelocities(PrototypeObject* const* objects, size_t count, glm::vec3* values, size_t stride);
+    static void setLinearVelocities(PrototypeObject* const* objects, size_t count, const glm::vec3* values, size_t stride);
+    static void getAngularVelocities(PrototypeObject* const* objects, size_t count, glm::vec3* values, size_t stride);
+    static void setAngularVelocities(PrototypeObject* const* objects, size_t count, const glm::vec3* values, size_t stride);
+
+    // spawns count rigidbody cubes in the default layer, velocities may be null, spawned gets the new objects or null
+    // for the ones that failed and may be null as well
+    static void spawnCubes(size_t            count,
+                           const glm::vec3*  positions,
+                           size_t            positionsStride,
+                           const glm::vec3*  velocities,
+                           size_t            velocitiesStride,
+                           PrototypeObject** spawned);
+    static void destroy(PrototypeObject* const* objects, size_t count);
+};
@@ -37,6 +37,7 @@ CameraSystemUpdateViewMatrix(Camera* camera, f32 xdir, f32 ydir, f32 zdir)
         camera->_rotation.x   = glm::clamp(camera->_rotation.x, -80.0f, 80.0f);
         camera->_rotation.y   = fmod(camera->_rotation.y, 360.0f);
         camera->_rotationQuat = glm::eulerAngleYX(glm::radians(camera->_rotation.y), glm::radians(camera->_rotation.x));
+        PrototypeTraitSystem::dispatchTraitChange(camera->object(), PrototypeTraitTypeMaskCamera);
     }
 
     if (camera->orbital()) {
@@ -61,12 +62,14 @@ CameraSystemSetRotation(Camera* camera, const glm::vec2& rotation)
     camera->_rotation.y        = fmod(camera->_rotation.y, 360.0f);
     camera->_rotationQuat      = glm::eulerAngleYX(glm::radians(rotation.y), glm::radians(rotation.x));
     camera->_interpolationTime = 1.0f;
+    PrototypeTraitSystem::dispatchTraitChange(camera->object(), PrototypeTraitTypeMaskCamera);
 }
 
 extern void
 CameraSystemSetTranslation(Camera* camera, const glm::vec3& translation)
 {
     camera->_position = translation;
+    PrototypeTraitSystem::dispatchTraitChange(camera->object(), PrototypeTraitTypeMaskCamera);
 }
 
 extern void
@@ -80,6 +83,10 @@ CameraSystemRotate(Camera* camera, f32 x, f32 y)
 extern void
 CameraSystemTranslate(Camera* camera, f32 x, f32 y, f32 z)
 {
+    // the view matrix update translates by zero every frame, that isn't an edit
+    if (x != 0.0f || y != 0.0f || z != 0.0f) {
+        PrototypeTraitSystem::dispatchTraitChange(camera->object(), PrototypeTraitTypeMaskCamera);
+    }
     if (camera->_orbital) {
         camera->_position.x -= x * camera->_moveSensitivity;
         camera->_position.y -= y * camera->_moveSensitivity;
@@ -103,18 +110,21 @@ extern void
 CameraSystemSetFov(Camera* camera, f32 fov)
 {
     camera->_fov = fov;
+    PrototypeTraitSystem::dispatchTraitChange(camera->object(), PrototypeTraitTypeMaskCamera);
 }
 
 extern void
 CameraSystemSetNear(Camera* camera, f32 near)
 {
     camera->_near = near;
+    PrototypeTraitSystem::dispatchTraitChange(camera->object(), PrototypeTraitTypeMaskCamera);
 }
 
 extern void
 CameraSystemSetFar(Camera* camera, f32 far)
 {
     camera->_far = far;
+    PrototypeTraitSystem::dispatchTraitChange(camera->object(), PrototypeTraitTypeMaskCamera);
 }
 
 extern void
@@ -0,0 +1,100 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#include "PrototypeCollisionLayers.h"
+
+#include <PrototypeCommon/Logger.h>
+
+#include <algorithm>
+
+PrototypeCollisionLayers::PrototypeCollisionLayers()
+  : _names({ "Default" })
+{
+    _matrix.fill(UINT32_MAX);
+}
+
+bool
+PrototypeCollisionLayers::addLayer(const std::string& name)
+{
+    if (std::find(_names.begin(), _names.end(), name) != _names.end()) {
+        PrototypeLogger::warn("Collision layer %s is defined twice", name.c_str());
+        return false;
+    }
+    if (_names.size() == PROTOTYPE_MAX_COLLISION_LAYERS) {
+        PrototypeLogger::warn("Collision layer %s doesn't fit, %u layers at most", name.c_str(), PROTOTYPE_MAX_COLLISION_LAYERS);
+        return false;
+    }
+    _names.push_back(name);
+    return true;
+}
+
+void
+PrototypeCollisionLayers::setInteraction(u32 layerA, u32 layerB, bool interacts)
+{
+    if (layerA >= PROTOTYPE_MAX_COLLISION_LAYERS || layerB >= PROTOTYPE_MAX_COLLISION_LAYERS) { return; }
+    if (interacts) {
+        _matrix[layerA] |= 1u << layerB;
+        _matrix[layerB] |= 1u << layerA;
+    } else {
+        _matrix[layerA] &= ~(1u << layerB);
+        _matrix[layerB] &= ~(1u << layerA);
+    }
+}
+
+std::optional<u32>
+PrototypeCollisionLayers::layerByName(const std::string& name) const
+{
+    auto it = std::find(_names.begin(), _names.end(), name);
+    if (it == _names.end()) { return {}; }
+    return { (u32)(it - _names.begin()) };
+}
+
+bool
+PrototypeCollisionLayers::interacts(u32 layerA, u32 layerB) const
+{
+    if (layerA >= PROTOTYPE_MAX_COLLISION_LAYERS || layerB >= PROTOTYPE_MAX_COLLISION_LAYERS) { return true; }
+    return (_matrix[layerA] & (1u << layerB)) != 0;
+}
+
+const std::vector<std::string>&
+PrototypeCollisionLayers::names() const
+{
+    return _names;
+}
+
+const std::array<u32, PROTOTYPE_MAX_COLLISION_LAYERS>&
+PrototypeCollisionLayers::matrix() const
+{
+    return _matrix;
+}
+
+void
+PrototypeCollisionLayers::ignorePairs(const nlohmann::json& j)
+{
+    for (const auto& jpair : j) {
+        if (!jpair.is_array() || jpair.size() != 2) {
+            PrototypeLogger::warn("Collision layers pairs are expected as [\"LayerA\", \"LayerB\"]");
+            continue;
+        }
+        const std::string  nameA  = jpair[0].get<std::string>();
+        const std::string  nameB  = jpair[1].get<std::string>();
+        std::optional<u32> layerA = layerByName(nameA);
+        std::optional<u32> layerB = layerByName(nameB);
+        if (!layerA.has_value() || !layerB.has_value()) {
+            PrototypeLogger::warn("Unknown collision layers pair %s, %s", nameA.c_str(), nameB.c_str());
+            continue;
+        }
+        setInteraction(layerA.value(), layerB.value(), false);
+    }
+}
@@ -0,0 +1,53 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#pragma once
+
+#include "../../include/PrototypeEngine/PrototypeEngineApi.h"
+
+#include <array>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#define PROTOTYPE_MAX_COLLISION_LAYERS 32
+
+// named collision layers and which of them interact, layer 0 is the default layer every collider starts on,
+// bit b of matrix[a] is set when colliders of layer a and layer b generate pairs, the matrix is kept symmetric
+// and every row doubles as the query mask of the layers its layer can hit
+struct PrototypeCollisionLayers
+{
+    PrototypeCollisionLayers();
+
+    // appends a layer interacting with every other one, returns false when the name is taken or no layer is left
+    bool addLayer(const std::string& name);
+
+    // stops or restores the pairs between both layers
+    void setInteraction(u32 layerA, u32 layerB, bool interacts);
+
+    std::optional<u32> layerByName(const std::string& name) const;
+    bool               interacts(u32 layerA, u32 layerB) const;
+
+    const std::vector<std::string>&                        names() const;
+    const std::array<u32, PROTOTYPE_MAX_COLLISION_LAYERS>& matrix() const;
+
+    // reads the pairs of layer names listed in j as [["Debris", "Debris"], ..] and stops them from interacting
+    void ignorePairs(const nlohmann::json& j);
+
+  private:
+    std::vector<std::string>                        _names;
+    std::array<u32, PROTOTYPE_MAX_COLLISION_LAYERS> _matrix;
+};
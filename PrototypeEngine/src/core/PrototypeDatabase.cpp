@@ -19,14 +19,17 @@
 #include "PrototypeFrameBuffer.h"
 #include "PrototypeMaterial.h"
 #include "PrototypeMeshBuffer.h"
+#include "PrototypeObjectPool.h"
 #include "PrototypePhysics.h"
 #include "PrototypePluginInstance.h"
 #include "PrototypeShaderBuffer.h"
 #include "PrototypeTextureBuffer.h"
 
 #include "PrototypeScene.h"
+#include "PrototypeSceneJournal.h"
 #include "PrototypeSceneLayer.h"
 #include "PrototypeSceneNode.h"
+#include "PrototypeSceneStreamer.h"
 
 #include <PrototypeCommon/IO.h>
 #include <PrototypeCommon/Logger.h>
@@ -216,10 +219,9 @@ void
 PrototypeDatabase::dump(PrototypeScene* scene)
 {
     PrototypeIo::createDirectory(PROTOTYPE_LOG_PATH(""));
-    std::vector<std::thread> scenesThreads;
-    scenesThreads.reserve(scenes.size());
-    for (const auto& pair : scenes) {
-        scenesThreads.emplace_back([=]() { dumpScene(pair.second); });
+    // only what changed since the last save gets written, the workers do the writing
+    if (PrototypeEngineInternalApplication::sceneJournal) {
+        for (const auto& pair : scenes) { PrototypeEngineInternalApplication::sceneJournal->save(pair.second); }
     }
     {
         {
@@ -283,17 +285,6 @@ PrototypeDatabase::dump(PrototypeScene* scene)
             PrototypeLogger::dump(PROTOTYPE_LOG_PATH("database.framebuffers.json"), ss.str().c_str());
         }
     }
-    for (auto& sceneThread : scenesThreads) { sceneThread.join(); }
-}
-
-void
-PrototypeDatabase::dumpScene(const PrototypeScene* scene)
-{
-    std::stringstream ss;
-    nlohmann::json    j;
-    PrototypeScene::to_json(j, *scene);
-    ss << j;
-    PrototypeLogger::dump((PROTOTYPE_LOG_PATH("scenes.") + scene->name() + ".json").c_str(), ss.str().c_str());
 }
 
 void
@@ -519,6 +510,12 @@ PrototypeDatabase::deallocateSceneFilter(PrototypeSceneFilter* sceneFilter)
 void
 PrototypeDatabase::deallocateSceneLayer(PrototypeSceneLayer* sceneLayer)
 {
+    if (PrototypeEngineInternalApplication::objectPool) {
+        PrototypeEngineInternalApplication::objectPool->forgetLayer(sceneLayer);
+    }
+    if (PrototypeEngineInternalApplication::sceneStreamer) {
+        PrototypeEngineInternalApplication::sceneStreamer->forget(sceneLayer);
+    }
     for (auto it = scenes.begin(); it != scenes.end(); ++it) {
         auto sceneIt = sceneLayers.find(it->second);
         if (sceneIt == sceneLayers.end()) continue;
@@ -537,6 +534,13 @@ PrototypeDatabase::deallocateSceneNode(PrototypeSceneNode* sceneNode)
         auto nodeIt = sceneIt->second.find(sceneNode->name());
         if (nodeIt != sceneIt->second.end()) { sceneIt->second.erase(nodeIt); }
     }
+    const auto optObject = sceneNode->object();
+    if (optObject.has_value() && PrototypeEngineInternalApplication::objectPool) {
+        PrototypeEngineInternalApplication::objectPool->forget(optObject.value());
+    }
+    if (PrototypeEngineInternalApplication::sceneJournal) {
+        PrototypeEngineInternalApplication::sceneJournal->forget(sceneNode);
+    }
     _SceneNodesPool.deleteElement(sceneNode);
 }
 
@@ -118,7 +118,6 @@ struct PrototypeDatabase
     std::unordered_map<std::string, PrototypePluginInstance*>                        pluginInstances;
 
   private:
-    void dumpScene(const PrototypeScene* scene);
     void refreshDirectories(std::vector<std::string> directories);
 
     std::vector<onMeshBufferReloadFn>      meshBuffersChangeCallbacks;
@@ -17,26 +17,38 @@
 #include "../opengl/PrototypeOpenglWindow.h"
 #include "../physx/PrototypePhysxPhysics.h"
 #include "../vulkan/PrototypeVulkanWindow.h"
+#include "PrototypeCollisionLayers.h"
 #include "PrototypeDatabase.h"
+#include "PrototypeObjectPool.h"
 #include "PrototypePhysics.h"
 #include "PrototypePipelines.h"
 #include "PrototypePluginInstance.h"
+#include "PrototypePluginWatchdog.h"
 #include "PrototypeProfiler.h"
+#include "PrototypeRecorder.h"
 #include "PrototypeRenderer.h"
 #include "PrototypeScene.h"
+#include "PrototypeSceneJournal.h"
 #include "PrototypeSceneLoader.h"
+#include "PrototypeSceneStreamer.h"
 #include "PrototypeShaderBuffer.h"
 #include "PrototypeShortcuts.h"
 #include "PrototypeStaticInitializer.h"
 #include "PrototypeTextureBuffer.h"
+#include "PrototypeThreadpool.h"
+#include "PrototypeTransformHierarchy.h"
 #include "PrototypeUI.h"
 
 #include "PrototypeSceneNode.h"
 
+#include <PrototypeCommon/FrameArena.h>
 #include <PrototypeCommon/IO.h>
 #include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/MemoryTracker.h>
+#include <PrototypeCommon/Tracer.h>
 #include <PrototypeTraitSystem/PrototypeTraitSystem.h>
 
+#include <algorithm>
 #include <chrono>
 #include <filesystem>
 #include <fstream>
@@ -45,16 +57,52 @@ PrototypeEngineApplication    PrototypeEngineInternalApplication::application;
 PrototypeEngineERenderingApi_ PrototypeEngineInternalApplication::renderingApi;
 PrototypeEngineEPhysicsApi_   PrototypeEngineInternalApplication::physicsApi;
 bool                          PrototypeEngineInternalApplication::shouldQuit;
+bool                          PrototypeEngineInternalApplication::headless;
 PrototypeDatabase*            PrototypeEngineInternalApplication::database;
 PrototypeWindow*              PrototypeEngineInternalApplication::window;
 PrototypeRenderer*            PrototypeEngineInternalApplication::renderer;
 PrototypePhysics*             PrototypeEngineInternalApplication::physics;
 PrototypeScene*               PrototypeEngineInternalApplication::scene;
+PrototypeFrameArena*          PrototypeEngineInternalApplication::frameArena;
+PrototypeRecorder*            PrototypeEngineInternalApplication::recorder;
+PrototypeThreadpool*          PrototypeEngineInternalApplication::threadpool;
+PrototypeCollisionLayers*     PrototypeEngineInternalApplication::collisionLayers;
+PrototypeObjectPool*          PrototypeEngineInternalApplication::objectPool;
+PrototypeTransformHierarchy*  PrototypeEngineInternalApplication::transformHierarchy;
+PrototypeSceneStreamer*       PrototypeEngineInternalApplication::sceneStreamer;
+PrototypeSceneJournal*        PrototypeEngineInternalApplication::sceneJournal;
 #if defined(PROTOTYPE_ENABLE_PROFILER)
 PrototypeProfiler* PrototypeEngineInternalApplication::profiler;
 #endif
 void** PrototypeEngineInternalApplication::traitSystemData;
 
+// overrides set by tools before initializing the engine, the defaults match a regular interactive run
+static PrototypeEngineRunOptions runOptions = { "", "", 0, false, true, false, false };
+// chrome trace written on exit, set through the optional "TraceFile" settings field
+static std::string traceFilepath;
+// seconds between two memory snapshots written to the logs folder, set through the optional "MemorySnapshotInterval"
+// settings field, 0 only writes the one on exit (needs PROTOTYPE_ENABLE_MEMORY_TRACKER)
+static f64 memorySnapshotInterval = 0.0;
+static u32 memorySnapshotIndex    = 0;
+// session log recorded to or replayed from, set through the optional "RecordFile" / "ReplayFile" settings fields,
+// replaying wins when both are set
+static std::string recordFilepath;
+static std::string replayFilepath;
+// fixed step deterministic simulation, set through the optional "Lockstep" settings field
+static PrototypePhysicsLockstep lockstep = { false, 1.0f / 60.0f };
+// reports plugin calls that don't return within the "HangMs" of the optional "Plugins" settings field, null when disabled
+static PrototypePluginWatchdog* pluginWatchdog = nullptr;
+
+static void
+writeMemorySnapshot(const char* suffix)
+{
+    if (!PrototypeMemoryTracker::enabled()) { return; }
+    std::string filepath = PROTOTYPE_LOG_PATH("memory_") + std::string(suffix) + ".json";
+    if (PrototypeMemoryTracker::writeSnapshot(filepath.c_str())) {
+        PrototypeLogger::log(__FILE__, __LINE__, ("Memory snapshot saved to " + filepath).c_str());
+    }
+}
+
 #define PROTOTYOE_TRAIT_SYSTEM_SET_CALLBACKS()                                                                                   \
     PrototypeTraitSystem::setCameraTraitAddCbFnPtr(shortcutDefaultCameraTraitAddInitializer);                                    \
     PrototypeTraitSystem::setTransformTraitAddCbFnPtr(shortcutDefaultTransformTraitAddInitializer);                              \
@@ -121,12 +169,26 @@ void** PrototypeEngineInternalApplication::traitSystemData;
     PrototypeTraitSystem::setColliderTraitLogCbFnPtr(nullptr);                                                                   \
     PrototypeTraitSystem::setVehicleChasisTraitLogCbFnPtr(nullptr);
 
+PROTOTYPE_EXTERN PROTOTYPE_ENGINE_API void
+PrototypeEngineSetRunOptions(const PrototypeEngineRunOptions& options)
+{
+    runOptions = options;
+}
+
 PROTOTYPE_EXTERN PROTOTYPE_ENGINE_API bool
 PrototypeEngineInit(const PrototypeEngineApplication& application)
 {
     PrototypeStaticInitializer::reset();
 
     PrototypeLogger::setData(PROTOTYPE_NEW PrototypeLoggerData);
+    PrototypeLogger::startWorker();
+
+    PrototypeTracer::setData(PROTOTYPE_NEW PrototypeTracerData);
+    PrototypeTracer::setThreadName("Main");
+    PrototypeLogger::trace("Tracer zone overhead %.1f ns", PrototypeTracer::measureZoneOverhead(100000));
+
+    PrototypeEngineInternalApplication::frameArena = PROTOTYPE_NEW PrototypeFrameArena();
+    PrototypeEngineInternalApplication::recorder   = PROTOTYPE_NEW PrototypeRecorder();
 
     PrototypeTraitSystemInit();
     PrototypeEngineInternalApplication::traitSystemData = PrototypeTraitSystemGetData();
@@ -142,6 +204,7 @@ PrototypeEngineInit(const PrototypeEngineApplication& application)
 
     PrototypeEngineInternalApplication::application = application;
     PrototypeEngineInternalApplication::shouldQuit  = false;
+    PrototypeEngineInternalApplication::headless    = runOptions.headless;
 
     std::string SettingsSceneName    = "";
     std::string SettingsRenderingApi = "";
@@ -165,6 +228,24 @@ PrototypeEngineInit(const PrototypeEngineApplication& application)
         const char* field_default_physics_api   = "DefaultPhysicsApi";
         const char* field_resources             = "Resources";
         const char* field_scenes                = "Scenes";
+        const char* field_trace_file            = "TraceFile";
+        const char* field_memory_interval       = "MemorySnapshotInterval";
+        const char* field_memory_stacks         = "MemoryCaptureStacks";
+        const char* field_record_file           = "RecordFile";
+        const char* field_replay_file           = "ReplayFile";
+        const char* field_threads               = "Threads";
+        const char* field_threads_workers       = "Workers";
+        const char* field_collision_layers      = "CollisionLayers";
+        const char* field_collision_layers_list = "Layers";
+        const char* field_collision_ignored     = "Ignored";
+        const char* field_lockstep              = "Lockstep";
+        const char* field_lockstep_enabled      = "Enabled";
+        const char* field_lockstep_timestep     = "Timestep";
+        const char* field_plugins               = "Plugins";
+        const char* field_plugins_budget        = "BudgetMs";
+        const char* field_plugins_throttle      = "ThrottleInterval";
+        const char* field_plugins_hang          = "HangMs";
+        const char* field_plugins_budgets       = "Budgets";
 
         if (!j.contains(field_default_scene)) {
             PrototypeLogger::warn("Settings doesn't have a default scene field \"%s\"", field_default_scene);
@@ -195,6 +276,98 @@ PrototypeEngineInit(const PrototypeEngineApplication& application)
         std::string defaultRenderingApi = j.at(field_default_rendering_api).get<std::string>();
         std::string defaultPhysicsApi   = j.at(field_default_physics_api).get<std::string>();
         std::string resourcesFilename   = "";
+        if (!runOptions.sceneName.empty()) { defaultSceneName = runOptions.sceneName; }
+        if (!runOptions.physicsApi.empty()) { defaultPhysicsApi = runOptions.physicsApi; }
+
+        if (j.contains(field_trace_file)) { traceFilepath = PROTOTYPE_LOG_PATH("") + j.at(field_trace_file).get<std::string>(); }
+        if (j.contains(field_memory_interval)) { memorySnapshotInterval = j.at(field_memory_interval).get<f64>(); }
+        if (j.contains(field_memory_stacks)) { PrototypeMemoryTracker::setCaptureStacks(j.at(field_memory_stacks).get<bool>()); }
+        if (j.contains(field_record_file)) {
+            recordFilepath = PROTOTYPE_LOG_PATH("") + j.at(field_record_file).get<std::string>();
+        }
+        if (j.contains(field_replay_file)) {
+            replayFilepath = PROTOTYPE_LOG_PATH("") + j.at(field_replay_file).get<std::string>();
+        }
+
+        if (j.contains(field_lockstep)) {
+            const auto& jlockstep = j.at(field_lockstep);
+            if (jlockstep.contains(field_lockstep_enabled)) {
+                lockstep.enabled = jlockstep.at(field_lockstep_enabled).get<bool>();
+            }
+            if (jlockstep.contains(field_lockstep_timestep)) {
+                lockstep.timestep = jlockstep.at(field_lockstep_timestep).get<f32>();
+            }
+        }
+        if (runOptions.lockstep) { lockstep.enabled = true; }
+        if (lockstep.enabled && lockstep.timestep <= 0.0f) {
+            PrototypeLogger::warn("Lockstep timestep %f isn't positive, falling back to 1/60", lockstep.timestep);
+            lockstep.timestep = 1.0f / 60.0f;
+        }
+
+        // one pool shared by physics, asset loading and plugins so they don't oversubscribe the cores between them,
+        // 0 workers keeps one core for the main thread and gives the pool the rest
+        {
+            u32 numWorkers = 0;
+            if (j.contains(field_threads) && j.at(field_threads).contains(field_threads_workers)) {
+                numWorkers = j.at(field_threads).at(field_threads_workers).get<u32>();
+            }
+            if (numWorkers == 0) { numWorkers = std::max(2u, std::thread::hardware_concurrency()) - 1; }
+            numWorkers = std::min(numWorkers, (u32)UINT8_MAX);
+            PrototypeEngineInternalApplication::threadpool = PROTOTYPE_NEW PrototypeThreadpool((u8)numWorkers);
+            PrototypeLogger::trace("Threadpool workers %u", numWorkers);
+        }
+
+        // per plugin frame budgets in milliseconds, plugins that keep overrunning theirs get updated every ThrottleInterval
+        // frames only, a plugin call that doesn't return within HangMs gets its stack dumped to the log
+        {
+            f32                                  budgetMs         = 0.0f;
+            u32                                  throttleInterval = 0;
+            f64                                  hangMs           = 0.0;
+            std::unordered_map<std::string, f32> budgetsByName;
+            if (j.contains(field_plugins)) {
+                const auto& jplugins = j.at(field_plugins);
+                if (jplugins.contains(field_plugins_budget)) { budgetMs = jplugins.at(field_plugins_budget).get<f32>(); }
+                if (jplugins.contains(field_plugins_throttle)) {
+                    throttleInterval = jplugins.at(field_plugins_throttle).get<u32>();
+                }
+                if (jplugins.contains(field_plugins_hang)) { hangMs = jplugins.at(field_plugins_hang).get<f64>(); }
+                if (jplugins.contains(field_plugins_budgets)) {
+                    for (const auto& jbudget : jplugins.at(field_plugins_budgets).items()) {
+                        budgetsByName[jbudget.key()] = jbudget.value().get<f32>();
+                    }
+                }
+            }
+            PrototypePluginInstance::setBudgets(budgetMs, throttleInterval, budgetsByName);
+            if (hangMs > 0.0) {
+                pluginWatchdog = PROTOTYPE_NEW PrototypePluginWatchdog(hangMs);
+                PrototypePluginInstance::setWatchdog(pluginWatchdog);
+            }
+        }
+
+        // named collision layers shared by every scene, the ignored pairs never generate contacts or trigger events
+        {
+            PrototypeCollisionLayers* collisionLayers           = PROTOTYPE_NEW PrototypeCollisionLayers();
+            PrototypeEngineInternalApplication::collisionLayers = collisionLayers;
+            if (j.contains(field_collision_layers)) {
+                const auto& jcollisionLayers = j.at(field_collision_layers);
+                if (jcollisionLayers.contains(field_collision_layers_list)) {
+                    for (const auto& jname : jcollisionLayers.at(field_collision_layers_list)) {
+                        collisionLayers->addLayer(jname.get<std::string>());
+                    }
+                }
+                if (jcollisionLayers.contains(field_collision_ignored)) {
+                    collisionLayers->ignorePairs(jcollisionLayers.at(field_collision_ignored));
+                }
+            }
+            Collider::setLayerNames(collisionLayers->names());
+        }
+
+        PrototypeEngineInternalApplication::objectPool         = PROTOTYPE_NEW PrototypeObjectPool();
+        PrototypeEngineInternalApplication::transformHierarchy = PROTOTYPE_NEW PrototypeTransformHierarchy();
+        PrototypeEngineInternalApplication::sceneStreamer      = PROTOTYPE_NEW PrototypeSceneStreamer();
+        PrototypeEngineInternalApplication::sceneJournal       = PROTOTYPE_NEW PrototypeSceneJournal();
+        Transform::setOnWorldSyncHandler(PrototypeTransformHierarchy::onTransformWorldSync);
+        PrototypeTraitSystem::setTraitChangeCbFnPtr(PrototypeSceneJournal::onTraitChange);
 
         // Pick a rendering api
         {
@@ -257,6 +430,15 @@ PrototypeEngineInit(const PrototypeEngineApplication& application)
         }
     }
 
+    // the window needs to know whether it runs headless before it gets created
+    PrototypeEngineInternalApplication::recorder->setMeasuring(runOptions.measureStages);
+    if (!replayFilepath.empty()) {
+        PrototypeEngineInternalApplication::headless = true;
+        PrototypeEngineInternalApplication::recorder->startReplaying(replayFilepath, PrototypeEngineInternalApplication::scene);
+    } else if (!recordFilepath.empty()) {
+        PrototypeEngineInternalApplication::recorder->startRecording(recordFilepath, PrototypeEngineInternalApplication::scene);
+    }
+
     // dump scene to logs
     // PrototypeEngineInternalApplication::database->dump(PrototypeEngineInternalApplication::scene);
 
@@ -287,6 +469,7 @@ PrototypeEngineInit(const PrototypeEngineApplication& application)
     }
 
     if (!PrototypeEngineInternalApplication::window->init(1250, 800)) { return false; }
+    PrototypeEngineInternalApplication::physics->setLockstep(lockstep);
     if (!PrototypeEngineInternalApplication::physics->init()) { return false; }
     if (!PrototypeEngineInternalApplication::renderer->init()) { return false; }
 
@@ -299,44 +482,160 @@ mainLoopProcedureBlock()
     static auto t1       = std::chrono::high_resolution_clock::now();
     static auto t2       = std::chrono::high_resolution_clock::now();
     static auto duration = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
-    if (PrototypeEngineInternalApplication::window->isIconified()) {
+    // replays dispatch the iconify restore themselves, waiting here would never return
+    if (PrototypeEngineInternalApplication::window->isIconified() &&
+        !PrototypeEngineInternalApplication::recorder->isReplaying()) {
         if (PrototypeEngineInternalApplication::physics) { PrototypeEngineInternalApplication::physics->pause(); }
         while (PrototypeEngineInternalApplication::window->isIconified()) { glfwPollEvents(); }
         if (PrototypeEngineInternalApplication::physics) { PrototypeEngineInternalApplication::physics->play(); }
     }
 
+    PROTOTYPE_TRACE_FRAME()
+    PROTOTYPE_TRACE_ZONE("Frame")
+    PrototypeEngineInternalApplication::recorder->beginFrame();
+
+    // frame boundary, transient memory from PROTOTYPE_FRAME_ARENA_FRAMES_IN_FLIGHT frames ago gets recycled
+    PrototypeEngineInternalApplication::frameArena->nextFrame();
+    PROTOTYPE_TRACE_COUNTER("FrameArena bytes", PrototypeEngineInternalApplication::frameArena->lastFrameStats().bytesUsed)
+
+    PrototypeMemoryTracker::sample();
+    if (memorySnapshotInterval > 0.0) {
+        static auto lastSnapshot = std::chrono::steady_clock::now();
+        auto        now          = std::chrono::steady_clock::now();
+        if (std::chrono::duration<f64>(now - lastSnapshot).count() >= memorySnapshotInterval) {
+            lastSnapshot = now;
+            writeMemorySnapshot(std::to_string(memorySnapshotIndex++).c_str());
+        }
+    }
+
 #if defined(PROTOTYPE_ENABLE_PROFILER)
     PrototypeEngineInternalApplication::profiler->advanceTimeline();
 #endif
     for (auto& command : PrototypePipelines::shortcutsQueue) { command.dispatch(); }
     PrototypePipelines::shortcutsQueue.clear();
+    {
+        PROTOTYPE_TRACE_ZONE("Streaming")
+        PrototypeRecorderStageScope stage(PrototypeEngineInternalApplication::recorder, PrototypeRecorderStage_Streaming);
+        PrototypeEngineInternalApplication::sceneStreamer->update();
+    }
+    PrototypeEngineInternalApplication::recorder->beginStage(PrototypeRecorderStage_Record);
 #if defined(PROTOTYPE_ENGINE_DEVELOPMENT_MODE)
-    PrototypeEngineInternalApplication::renderer->ui()->beginRecordPass();
-    PrototypeEngineInternalApplication::renderer->ui()->endRecordPass();
+    {
+        PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Editor)
+        PrototypeEngineInternalApplication::renderer->ui()->beginRecordPass();
+        PrototypeEngineInternalApplication::renderer->ui()->endRecordPass();
+    }
 #endif
-    PrototypeEngineInternalApplication::renderer->beginRecordPass();
-    PrototypeEngineInternalApplication::renderer->endRecordPass();
+    {
+        PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Renderer)
+        PrototypeEngineInternalApplication::renderer->beginRecordPass();
+        PrototypeEngineInternalApplication::renderer->endRecordPass();
+    }
     PrototypeEngineInternalApplication::physics->beginRecordPass();
     PrototypeEngineInternalApplication::physics->endRecordPass();
-    auto scriptableObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(PrototypeTraitTypeMaskScript);
-    for (PrototypeObject* scriptableObject : scriptableObjects) {
-        Script* script = scriptableObject->getScriptTrait();
-        for (const auto& codeLinkPair : script->codeLinks) {
-            PrototypePluginInstance::safeCallUpdateProtocol(&codeLinkPair.second, scriptableObject);
+    PrototypeEngineInternalApplication::recorder->endStage(PrototypeRecorderStage_Record);
+    const auto& scriptableObjectsSet =
+      PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(PrototypeTraitTypeMaskScript);
+    PrototypeFrameVector<PrototypeObject*> scriptableObjects(
+      scriptableObjectsSet.begin(),
+      scriptableObjectsSet.end(),
+      PrototypeFrameArenaAllocator<PrototypeObject*>(PrototypeEngineInternalApplication::frameArena));
+    // scripts spawning objects or pushing bodies around have to run in the same order every run to stay in lockstep
+    if (lockstep.enabled) {
+        std::sort(scriptableObjects.begin(), scriptableObjects.end(), [](PrototypeObject* a, PrototypeObject* b) {
+            return a->id() < b->id();
+        });
+    }
+    {
+        PROTOTYPE_TRACE_ZONE("Scripts")
+        PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scripts)
+        PrototypeRecorderStageScope stage(PrototypeEngineInternalApplication::recorder, PrototypeRecorderStage_Scripts);
+        // events of the previous physics step, one call per plugin instead of one per event and script
+        const std::vector<PrototypePhysicsEvent>& physicsEvents = PrototypeEngineInternalApplication::physics->events();
+        if (!physicsEvents.empty()) {
+            for (auto& pluginInstancePair : PrototypeEngineInternalApplication::database->pluginInstances) {
+                pluginInstancePair.second->onPhysicsEvents(physicsEvents.data(), (u32)physicsEvents.size());
+            }
+        }
+        // objects are grouped per plugin so each plugin is timed once per frame, plugins exporting PluginUpdateBatchProtocol
+        // get all of their objects in a single call
+        PrototypeFrameArenaAllocator<PrototypeObject*> objectsAllocator(PrototypeEngineInternalApplication::frameArena);
+        PrototypeFrameVector<std::pair<const ScriptCodeLink*, PrototypeFrameVector<PrototypeObject*>>> updateBatches(
+          objectsAllocator);
+        for (PrototypeObject* scriptableObject : scriptableObjects) {
+            Script* script = scriptableObject->getScriptTrait();
+            for (const auto& codeLinkPair : script->codeLinks) {
+                const ScriptCodeLink* codeLink = &codeLinkPair.second;
+                auto batch = std::find_if(updateBatches.begin(), updateBatches.end(), [codeLink](const auto& updateBatch) {
+                    return updateBatch.first->filepath == codeLink->filepath;
+                });
+                if (batch == updateBatches.end()) {
+                    updateBatches.emplace_back(codeLink, PrototypeFrameVector<PrototypeObject*>(objectsAllocator));
+                    batch = std::prev(updateBatches.end());
+                }
+                batch->second.push_back(scriptableObject);
+            }
+        }
+        for (const auto& updateBatch : updateBatches) {
+            if (PrototypePluginInstance::hasUpdateBatchProtocol(updateBatch.first)) {
+                PrototypePluginInstance::safeCallUpdateBatchProtocol(
+                  updateBatch.first, updateBatch.second.data(), updateBatch.second.size());
+            } else {
+                PrototypePluginInstance::safeCallUpdateProtocol(
+                  updateBatch.first, updateBatch.second.data(), updateBatch.second.size());
+            }
+        }
+        if (PrototypeEngineInternalApplication::application.onUpdateFn) {
+            PrototypeEngineInternalApplication::application.onUpdateFn();
+        }
+        for (auto& pluginInstancePair : PrototypeEngineInternalApplication::database->pluginInstances) {
+            pluginInstancePair.second->endFrame();
         }
     }
 
-    PrototypeEngineInternalApplication::physics->update();
-    PrototypeEngineInternalApplication::renderer->update();
-    PrototypeEngineInternalApplication::renderer->render3D();
-    PrototypeEngineInternalApplication::renderer->render2D();
+    // world matrices before the physics pushes the moved transforms and again before drawing what the physics moved
+    {
+        PROTOTYPE_TRACE_ZONE("Transforms")
+        PrototypeRecorderStageScope stage(PrototypeEngineInternalApplication::recorder, PrototypeRecorderStage_Transforms);
+        PrototypeEngineInternalApplication::transformHierarchy->update();
+    }
+    {
+        PROTOTYPE_TRACE_ZONE("Physics")
+        PrototypeRecorderStageScope stage(PrototypeEngineInternalApplication::recorder, PrototypeRecorderStage_Physics);
+        PrototypeEngineInternalApplication::physics->update();
+    }
+    {
+        PROTOTYPE_TRACE_ZONE("Transforms")
+        PrototypeRecorderStageScope stage(PrototypeEngineInternalApplication::recorder, PrototypeRecorderStage_Transforms);
+        PrototypeEngineInternalApplication::transformHierarchy->update();
+    }
+    // a replay then reports the first frame whose simulation diverged instead of only a mismatching final hash
+    if (lockstep.enabled && PrototypeEngineInternalApplication::recorder->mode() != PrototypeRecorderMode_Off) {
+        const u64 stateHash = PrototypeEngineInternalApplication::physics->stateHash();
+        PrototypeEngineInternalApplication::recorder->pluginCall(
+          PrototypeRecorderPluginCall_PhysicsStateHash, &stateHash, sizeof(stateHash));
+    }
+    {
+        PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Renderer)
+        PrototypeRecorderStageScope stage(PrototypeEngineInternalApplication::recorder, PrototypeRecorderStage_Submit);
+        PrototypeEngineInternalApplication::renderer->update();
+        PrototypeEngineInternalApplication::renderer->render3D();
+        PrototypeEngineInternalApplication::renderer->render2D();
+    }
 
     if (PrototypeEngineInternalApplication::window->needsReload()) {}
     if (PrototypeEngineInternalApplication::window->needsInspector()) {
         PrototypeEngineInternalApplication::database->dump(PrototypeEngineInternalApplication::scene);
         PrototypeEngineInternalApplication::window->consumeNeedsInspector();
     }
-    PrototypeEngineInternalApplication::shouldQuit = PrototypeEngineInternalApplication::window->update();
+    {
+        PrototypeRecorderStageScope stage(PrototypeEngineInternalApplication::recorder, PrototypeRecorderStage_Window);
+        PrototypeEngineInternalApplication::shouldQuit = PrototypeEngineInternalApplication::window->update();
+    }
+    PrototypeEngineInternalApplication::recorder->endFrame();
+
+    static u32 frames = 0;
+    if (runOptions.maxFrames > 0 && ++frames >= runOptions.maxFrames) { PrototypeEngineInternalApplication::shouldQuit = true; }
 }
 
 PROTOTYPE_EXTERN PROTOTYPE_ENGINE_API void
@@ -350,7 +649,8 @@ PrototypeEngineLoop()
 
     PrototypeEngineInternalApplication::shouldQuit = PrototypeEngineInternalApplication::window->update();
 
-    std::vector<std::string> pluginFiles = PrototypeIo::listFiles(PROTOTYPE_PLUGIN_PATH(""), 5);
+    std::vector<std::string> pluginFiles;
+    if (runOptions.loadPlugins) { pluginFiles = PrototypeIo::listFiles(PROTOTYPE_PLUGIN_PATH(""), 5); }
     for (const auto& pluginFile : pluginFiles) {
 #if defined(PROTOTYPE_PLATFORM_WINDOWS)
         const char* stem = ".dll";
@@ -375,6 +675,8 @@ PrototypeEngineLoop()
 
     while (!PrototypeEngineInternalApplication::shouldQuit) { mainLoopProcedureBlock(); }
 
+    PrototypeEngineInternalApplication::recorder->finish(PrototypeEngineInternalApplication::scene);
+
     auto scriptableObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(PrototypeTraitTypeMaskScript);
     for (const auto& scriptableObject : scriptableObjects) {
         Script* script = scriptableObject->getScriptTrait();
@@ -406,6 +708,12 @@ PrototypeEngineDeInit()
     delete PrototypeEngineInternalApplication::physics;
     PrototypeEngineInternalApplication::window->deInit();
     delete PrototypeEngineInternalApplication::window;
+    // saves still being written need the workers
+    PrototypeTraitSystem::setTraitChangeCbFnPtr(nullptr);
+    delete PrototypeEngineInternalApplication::sceneJournal;
+    PrototypeEngineInternalApplication::sceneJournal = nullptr;
+    delete PrototypeEngineInternalApplication::threadpool;
+    PrototypeEngineInternalApplication::threadpool = nullptr;
 
     PROTOTYOE_TRAIT_SYSTEM_UNSET_CALLBACKS()
     PrototypeTraitSystem::clearObjects();
@@ -413,6 +721,28 @@ PrototypeEngineDeInit()
 
     PrototypeEngineInternalApplication::database->deallocate();
     delete PrototypeEngineInternalApplication::database;
-
+    delete PrototypeEngineInternalApplication::collisionLayers;
+    PrototypeEngineInternalApplication::collisionLayers = nullptr;
+    delete PrototypeEngineInternalApplication::objectPool;
+    PrototypeEngineInternalApplication::objectPool = nullptr;
+    Transform::setOnWorldSyncHandler(nullptr);
+    delete PrototypeEngineInternalApplication::transformHierarchy;
+    PrototypeEngineInternalApplication::transformHierarchy = nullptr;
+    delete PrototypeEngineInternalApplication::sceneStreamer;
+    PrototypeEngineInternalApplication::sceneStreamer = nullptr;
+    PrototypePluginInstance::setWatchdog(nullptr);
+    delete pluginWatchdog;
+    pluginWatchdog = nullptr;
+
+    delete PrototypeEngineInternalApplication::frameArena;
+    delete PrototypeEngineInternalApplication::recorder;
+
+    if (!traceFilepath.empty()) { PrototypeTracer::exportChromeTrace(traceFilepath.c_str()); }
+    writeMemorySnapshot("exit");
+    delete PrototypeTracer::data();
+    PrototypeTracer::setData(nullptr);
+
+    PrototypeLogger::stopWorker();
     delete PrototypeLogger::data();
+    PrototypeLogger::setData(nullptr);
 }
\ No newline at end of file
@@ -22,6 +22,15 @@ struct PrototypePhysics;
 struct PrototypeScene;
 struct PrototypeProfiler;
 struct PrototypeLogger;
+struct PrototypeFrameArena;
+struct PrototypeTracerData;
+struct PrototypeRecorder;
+struct PrototypeThreadpool;
+struct PrototypeCollisionLayers;
+struct PrototypeObjectPool;
+struct PrototypeTransformHierarchy;
+struct PrototypeSceneStreamer;
+struct PrototypeSceneJournal;
 
 enum PROTOTYPE_ENGINE_API PrototypeEngineERenderingApi_
 {
@@ -62,11 +71,20 @@ struct PrototypeEngineInternalApplication
     static PrototypeEngineERenderingApi_ renderingApi;
     static PrototypeEngineEPhysicsApi_   physicsApi;
     static bool                          shouldQuit;
+    static bool                          headless;
     static PrototypeDatabase*            database;
     static PrototypeWindow*              window;
     static PrototypeRenderer*            renderer;
     static PrototypePhysics*             physics;
     static PrototypeScene*               scene;
+    static PrototypeFrameArena*          frameArena;
+    static PrototypeRecorder*            recorder;
+    static PrototypeThreadpool*          threadpool;
+    static PrototypeCollisionLayers*     collisionLayers;
+    static PrototypeObjectPool*          objectPool;
+    static PrototypeTransformHierarchy*  transformHierarchy;
+    static PrototypeSceneStreamer*       sceneStreamer;
+    static PrototypeSceneJournal*        sceneJournal;
 #if defined(PROTOTYPE_ENABLE_PROFILER)
     static PrototypeProfiler* profiler;
 #endif
@@ -79,11 +97,20 @@ struct PrototypeEngineContext
     PrototypeEngineERenderingApi_ renderingApi;
     PrototypeEngineEPhysicsApi_   physicsApi;
     bool                          shouldQuit;
+    bool                          headless;
     PrototypeDatabase*            database;
     PrototypeWindow*              window;
     PrototypeRenderer*            renderer;
     PrototypePhysics*             physics;
     PrototypeScene*               scene;
+    PrototypeFrameArena*          frameArena;
+    PrototypeRecorder*            recorder;
+    PrototypeThreadpool*          threadpool;
+    PrototypeObjectPool*          objectPool;
+    PrototypeTransformHierarchy*  transformHierarchy;
+    PrototypeSceneStreamer*       sceneStreamer;
+    PrototypeSceneJournal*        sceneJournal;
+    PrototypeTracerData*          tracerData;
 #if defined(PROTOTYPE_ENABLE_PROFILER)
     PrototypeProfiler* profiler;
 #endif
@@ -21,6 +21,7 @@
 
 #include <PrototypeCommon/IO.h>
 #include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/MemoryTracker.h>
 
 #include <assimp/Importer.hpp>
 #include <assimp/cimport.h>
@@ -46,6 +47,7 @@ struct hash<PrototypeMeshVertex>
 void
 loadSourceFromFile(PrototypeMeshBufferSource* meshBufferSource, const std::string& meshFullPath)
 {
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Meshes)
     i32              defaultFlags = aiProcess_Triangulate | aiProcess_FlipUVs;
     Assimp::Importer importer;
     const aiScene*   scene = importer.ReadFile(meshFullPath, defaultFlags);
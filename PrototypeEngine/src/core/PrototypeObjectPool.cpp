@@ -0,0 +1,258 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#include "PrototypeObjectPool.h"
+
+#include "PrototypeDatabase.h"
+#include "PrototypeEngine.h"
+#include "PrototypePhysics.h"
+#include "PrototypeRenderer.h"
+#include "PrototypeScene.h"
+#include "PrototypeSceneLayer.h"
+#include "PrototypeSceneNode.h"
+#include "PrototypeShortcuts.h"
+
+#include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/Tracer.h>
+
+#include <PrototypeTraitSystem/PrototypeTraitSystem.h>
+
+#include <algorithm>
+#include <sstream>
+
+static const MASK_TYPE PooledTraitMask = PrototypeTraitTypeMaskTransform | PrototypeTraitTypeMaskRigidbody |
+                                         PrototypeTraitTypeMaskCollider | PrototypeTraitTypeMaskMeshRenderer;
+
+template<typename T>
+static inline const T&
+strided(const T* values, size_t stride, size_t i)
+{
+    return *(const T*)((const u8*)values + i * (stride == 0 ? sizeof(T) : stride));
+}
+
+PrototypeObjectPool::PrototypeObjectPool()
+  : _stats({})
+{}
+
+PrototypeObjectPool::~PrototypeObjectPool() {}
+
+void
+PrototypeObjectPool::spawnBatch(const PrototypeSpawnArchetype& archetype,
+                                size_t                         count,
+                                const glm::vec3*               positions,
+                                size_t                         positionsStride,
+                                const glm::vec3*               rotations,
+                                size_t                         rotationsStride,
+                                const glm::vec3*               velocities,
+                                size_t                         velocitiesStride,
+                                PrototypeObject**              spawned)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    Pool* pool = poolOf(archetype);
+    if (!pool) {
+        if (spawned) {
+            for (size_t i = 0; i < count; ++i) { spawned[i] = nullptr; }
+        }
+        return;
+    }
+
+    const glm::vec3 zero = { 0.0f, 0.0f, 0.0f };
+    PrototypeEngineInternalApplication::physics->beginActorBatch();
+    for (size_t i = 0; i < count; ++i) {
+        const glm::vec3& position = strided(positions, positionsStride, i);
+        const glm::vec3& rotation = rotations ? strided(rotations, rotationsStride, i) : zero;
+        const glm::vec3& velocity = velocities ? strided(velocities, velocitiesStride, i) : zero;
+        PrototypeObject* object   = nullptr;
+        if (!pool->inactive.empty()) {
+            object = pool->inactive.back();
+            pool->inactive.pop_back();
+            _owners[object].active = true;
+            activate(object, position, rotation, velocity);
+            ++_stats.reused;
+        } else {
+            object = create(*pool, position, rotation, velocity);
+        }
+        if (spawned) { spawned[i] = object; }
+    }
+    PrototypeEngineInternalApplication::physics->endActorBatch();
+
+    // both are dirty flags, one pass records the whole batch
+    PrototypeEngineInternalApplication::renderer->scheduleRecordPass();
+    PrototypeEngineInternalApplication::physics->scheduleRecordPass();
+}
+
+void
+PrototypeObjectPool::release(PrototypeObject* const* objects, size_t count)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    bool anyDestroyed = false;
+    for (size_t i = 0; i < count; ++i) {
+        PrototypeObject* object = objects[i];
+        if (!object) continue;
+        auto it = _owners.find(object);
+        if (it == _owners.end()) {
+            object->destroy();
+            anyDestroyed = true;
+            continue;
+        }
+        if (!it->second.active) {
+            PrototypeLogger::warn("Object pool: object <%s> released twice",
+                                  ((PrototypeSceneNode*)object->parentNode())->name().c_str());
+            continue;
+        }
+        it->second.active = false;
+        deactivate(object);
+        it->second.pool->inactive.push_back(object);
+        ++_stats.released;
+    }
+    PrototypeEngineInternalApplication::renderer->scheduleRecordPass();
+    if (anyDestroyed) { PrototypeEngineInternalApplication::physics->scheduleRecordPass(); }
+}
+
+void
+PrototypeObjectPool::forget(PrototypeObject* object)
+{
+    auto it = _owners.find(object);
+    if (it == _owners.end()) return;
+    std::vector<PrototypeObject*>& inactive = it->second.pool->inactive;
+    auto                           objIt    = std::find(inactive.begin(), inactive.end(), object);
+    if (objIt != inactive.end()) {
+        *objIt = inactive.back();
+        inactive.pop_back();
+    }
+    _owners.erase(it);
+}
+
+void
+PrototypeObjectPool::forgetLayer(PrototypeSceneLayer* layer)
+{
+    for (auto it = _pools.begin(); it != _pools.end();) {
+        if (it->second.layer != layer) {
+            ++it;
+            continue;
+        }
+        Pool* pool = &it->second;
+        for (auto ownerIt = _owners.begin(); ownerIt != _owners.end();) {
+            if (ownerIt->second.pool == pool) {
+                ownerIt = _owners.erase(ownerIt);
+            } else {
+                ++ownerIt;
+            }
+        }
+        it = _pools.erase(it);
+    }
+}
+
+PrototypeObjectPoolStats
+PrototypeObjectPool::stats() const
+{
+    PrototypeObjectPoolStats stats = _stats;
+    stats.inactive                 = 0;
+    for (const auto& pair : _pools) { stats.inactive += pair.second.inactive.size(); }
+    return stats;
+}
+
+PrototypeObjectPool::Pool*
+PrototypeObjectPool::poolOf(const PrototypeSpawnArchetype& archetype)
+{
+    PrototypeScene* scene = PrototypeEngineInternalApplication::scene;
+    if (!scene || scene->layers().empty()) {
+        PrototypeLogger::warn("Object pool: no scene layer to spawn in");
+        return nullptr;
+    }
+    if (archetype.shape == PrototypeSpawnShape_ConvexMesh &&
+        PrototypeEngineInternalApplication::database->meshBuffers.find(archetype.mesh) ==
+          PrototypeEngineInternalApplication::database->meshBuffers.end()) {
+        PrototypeLogger::warn("Object pool: unknown convex mesh <%s>", archetype.mesh.c_str());
+        return nullptr;
+    }
+
+    // keyed on the layer itself, a layer with the same name loaded again later gets a pool of its own
+    PrototypeSceneLayer* layer = scene->layers().begin()->second;
+    std::stringstream    ss;
+    ss << layer << '|' << archetype.shape << '|' << archetype.mesh << '|' << archetype.material << '|' << archetype.layer;
+    auto it = _pools.find(ss.str());
+    if (it != _pools.end()) return &it->second;
+
+    Pool pool      = {};
+    pool.archetype = archetype;
+    pool.layer     = layer;
+    if (pool.archetype.material.empty()) { pool.archetype.material = PROTOTYPE_DEFAULT_MATERIAL; }
+    return &_pools.emplace(ss.str(), std::move(pool)).first->second;
+}
+
+PrototypeObject*
+PrototypeObjectPool::create(Pool& pool, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& velocity)
+{
+    static const char* shapeNames[PrototypeSpawnShape_Count] = { "Cube", "Sphere", "Convex" };
+
+    std::stringstream ss;
+    ss << shapeNames[pool.archetype.shape] << " (Pooled) " << _stats.created;
+    PrototypeObject* object = shotcutCreateCloneObjectToLayer(ss.str(), PooledTraitMask, pool.layer);
+    if (!object) return nullptr;
+
+    const glm::vec3 sca = { 1.0f, 1.0f, 1.0f };
+    shortcutSetupObjectTransformTrait(object, position, rotation, sca);
+    // the physics reads the collision layer while creating the actor
+    object->getColliderTrait()->setLayer(pool.archetype.layer);
+    switch (pool.archetype.shape) {
+        case PrototypeSpawnShape_Cube: {
+            shortcutSetupObjectMeshRendererTrait(object, "CUBE", pool.archetype.material);
+            shortcutSetupObjectCubeColliderTrait(object, sca.x, sca.y, sca.z, velocity);
+        } break;
+
+        case PrototypeSpawnShape_Sphere: {
+            shortcutSetupObjectMeshRendererTrait(object, "sphere.obj", pool.archetype.material);
+            shortcutSetupObjectSphereColliderTrait(object, 1.0f, velocity);
+        } break;
+
+        case PrototypeSpawnShape_ConvexMesh: {
+            shortcutSetupObjectMeshRendererTrait(object, pool.archetype.mesh, pool.archetype.material);
+            shortcutSetupObjectConvexMeshColliderTrait(object, velocity);
+        } break;
+
+        default: break;
+    }
+    _owners[object] = { &pool, true };
+    ++_stats.created;
+    return object;
+}
+
+void
+PrototypeObjectPool::activate(PrototypeObject*  object,
+                              const glm::vec3& position,
+                              const glm::vec3& rotation,
+                              const glm::vec3& velocity)
+{
+    const glm::vec3 sca = { 1.0f, 1.0f, 1.0f };
+    shortcutSetupObjectTransformTrait(object, position, rotation, sca);
+    Rigidbody* rb = object->getRigidbodyTrait();
+    rb->setLinearVelocity(velocity);
+    rb->setAngularVelocity({ 0.0f, 0.0f, 0.0f });
+
+    PrototypeSceneNode* node = (PrototypeSceneNode*)object->parentNode();
+    PrototypeEngineInternalApplication::scene->addNodeToTraitFilters(node, PooledTraitMask);
+    node->show();
+    PrototypeEngineInternalApplication::physics->setRigidbodyActive(object, true);
+}
+
+void
+PrototypeObjectPool::deactivate(PrototypeObject* object)
+{
+    PrototypeEngineInternalApplication::physics->setRigidbodyActive(object, false);
+    PrototypeSceneNode* node = (PrototypeSceneNode*)object->parentNode();
+    PrototypeEngineInternalApplication::scene->removeNodeFromTraitFilters(node, PooledTraitMask);
+    node->hide();
+}
@@ -0,0 +1,111 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#pragma once
+
+#include <PrototypeCommon/Definitions.h>
+#include <PrototypeCommon/Types.h>
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct PrototypeObject;
+struct PrototypeSceneLayer;
+
+enum PrototypeSpawnShape_
+{
+    PrototypeSpawnShape_Cube = 0,
+    PrototypeSpawnShape_Sphere,
+    PrototypeSpawnShape_ConvexMesh, // cooked when the object gets created, reused objects skip the cooking
+
+    PrototypeSpawnShape_Count
+};
+
+// what a batch spawns, objects of equal archetypes in the same scene share a pool
+struct PrototypeSpawnArchetype
+{
+    PrototypeSpawnShape_ shape;
+    std::string          mesh;     // convex meshes only, cubes and spheres use the builtin meshes
+    std::string          material; // empty uses the default material
+    u32                  layer;    // collision layer
+};
+
+struct PrototypeObjectPoolStats
+{
+    u64 created;  // objects created since startup
+    u64 reused;   // spawns served by a released object
+    u64 released; // objects returned to their pool
+    u64 inactive; // objects currently waiting in a pool
+};
+
+// Spawns rigidbody objects in batches and keeps the released ones around, inactive, to be handed out again.
+// Inactive objects stay in their scene layer but leave the trait filters and the simulation, so nothing renders,
+// simulates or updates them until they get spawned again.
+struct PrototypeObjectPool
+{
+    PrototypeObjectPool();
+    ~PrototypeObjectPool();
+
+    // spawns count objects of the archetype in the first layer of the current scene, reusing released ones first,
+    // rotations (euler angles) and velocities may be null, spawned gets the objects or null for the ones that failed,
+    // the rigidbodies of the batch are added to the physics scene at once and the record passes get scheduled once
+    void spawnBatch(const PrototypeSpawnArchetype& archetype,
+                    size_t                         count,
+                    const glm::vec3*               positions,
+                    size_t                         positionsStride,
+                    const glm::vec3*               rotations,
+                    size_t                         rotationsStride,
+                    const glm::vec3*               velocities,
+                    size_t                         velocitiesStride,
+                    PrototypeObject**              spawned);
+
+    // returns the objects spawned by spawnBatch to their pool, any other object is destroyed, null objects are skipped,
+    // objects already back in their pool are skipped with a warning
+    void release(PrototypeObject* const* objects, size_t count);
+
+    // drops an object the pool created without destroying it, called when its scene node gets deallocated
+    void forget(PrototypeObject* object);
+
+    // drops the pools spawning into the layer, called when the layer gets deallocated
+    void forgetLayer(PrototypeSceneLayer* layer);
+
+    PrototypeObjectPoolStats stats() const;
+
+  private:
+    struct Pool
+    {
+        PrototypeSpawnArchetype       archetype;
+        PrototypeSceneLayer*          layer;
+        std::vector<PrototypeObject*> inactive;
+    };
+
+    struct Owner
+    {
+        Pool* pool;
+        bool  active; // false while waiting in the pool
+    };
+
+    Pool*            poolOf(const PrototypeSpawnArchetype& archetype);
+    PrototypeObject* create(Pool& pool, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& velocity);
+    void activate(PrototypeObject* object, const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& velocity);
+    void deactivate(PrototypeObject* object);
+
+    std::unordered_map<std::string, Pool>       _pools;  // by layer and archetype
+    std::unordered_map<PrototypeObject*, Owner> _owners; // every object a pool created, active or not
+    PrototypeObjectPoolStats                    _stats;
+};
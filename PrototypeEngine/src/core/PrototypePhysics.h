@@ -18,6 +18,8 @@
 #include <PrototypeCommon/Maths.h>
 
 #include <optional>
+#include <string>
+#include <vector>
 
 struct PrototypeScene;
 struct PrototypeObject;
@@ -58,6 +60,122 @@ enum class PrototypePhysicsVehicleGear
     THIRTIETH     = 31
 };
 
+enum PrototypePhysicsQueryType_
+{
+    PrototypePhysicsQueryType_Ray,     // closest hit along origin + direction * length
+    PrototypePhysicsQueryType_Sweep,   // closest hit of a sphere of radius moved along origin + direction * length
+    PrototypePhysicsQueryType_Overlap, // any object overlapping a sphere of radius at origin
+
+    PrototypePhysicsQueryType_Count
+};
+
+enum PrototypePhysicsQueryFilter_
+{
+    PrototypePhysicsQueryFilter_Static  = 1 << 0,
+    PrototypePhysicsQueryFilter_Dynamic = 1 << 1,
+
+    PrototypePhysicsQueryFilter_All = PrototypePhysicsQueryFilter_Static | PrototypePhysicsQueryFilter_Dynamic
+};
+
+struct PrototypePhysicsQuery
+{
+    u32       type;       // PrototypePhysicsQueryType_
+    u32       filterMask; // PrototypePhysicsQueryFilter_ bits, the kind of bodies the query can hit
+    u32       layerMask;  // bit per collision layer the query can hit, 0 hits every layer
+    glm::vec3 origin;
+    glm::vec3 direction; // doesn't need to be normalized, ignored by overlaps
+    f32       length;    // ignored by overlaps
+    f32       radius;    // ignored by rays
+};
+
+struct PrototypePhysicsQueryHit
+{
+    PrototypeObject* object; // nullptr when nothing got hit
+    glm::vec3        position;
+    glm::vec3        normal;
+    f32              distance;
+};
+
+enum PrototypePhysicsEventType_
+{
+    PrototypePhysicsEventType_ContactFound, // object and other started touching
+    PrototypePhysicsEventType_ContactLost,  // object and other stopped touching
+    PrototypePhysicsEventType_TriggerEnter, // other entered the trigger object
+    PrototypePhysicsEventType_TriggerExit,  // other left the trigger object
+    PrototypePhysicsEventType_Wake,         // object woke up, other is nullptr
+    PrototypePhysicsEventType_Sleep,        // object went to sleep, other is nullptr
+
+    PrototypePhysicsEventType_Count
+};
+
+// one event of the last simulation step, only generated for the rigidbodies that opted in through their RigidbodyEvents_
+struct PrototypePhysicsEvent
+{
+    u32              type; // PrototypePhysicsEventType_
+    PrototypeObject* object;
+    PrototypeObject* other;
+    glm::vec3        position; // first contact point, contacts found only
+    glm::vec3        normal;   // at the first contact point pointing from other to object, contacts found only
+    f32              impulse;  // summed over the contact points of the step, contacts found only
+};
+
+// how a registered physics scene gets stepped while the simulation is playing
+enum PrototypePhysicsSceneActivity_
+{
+    PrototypePhysicsSceneActivity_Active,    // stepped every update
+    PrototypePhysicsSceneActivity_Paused,    // kept as it is until activated again
+    PrototypePhysicsSceneActivity_Throttled, // stepped at its own rate, each step covers the time elapsed since the last one
+
+    PrototypePhysicsSceneActivity_Count
+};
+
+struct PrototypePhysicsSceneActivity
+{
+    u32 activity;    // PrototypePhysicsSceneActivity_
+    f32 rate;        // steps per second when throttled
+    f32 accumulator; // time elapsed since the last throttled step
+};
+
+// counts of the last simulation step of the current scene
+struct PrototypePhysicsStatistics
+{
+    u32 activeBodies;  // awake dynamic bodies
+    u32 contactPairs;  // overlapping shape pairs that passed the collision layers filtering and went through the narrowphase
+    u32 touchingPairs; // pairs that ended up with contacts
+};
+
+// fixed step simulation for replays, server validation and rollback, every update advances the simulation by exactly
+// timestep whatever the frame's delta time, the bodies get created in object id order and the backends trade some
+// parallelism for a reproducible order so the same inputs give bit identical states
+struct PrototypePhysicsLockstep
+{
+    bool enabled;
+    f32  timestep; // seconds per update
+};
+
+#define PROTOTYPE_PHYSICS_HASH_OFFSET 0xcbf29ce484222325ull
+#define PROTOTYPE_PHYSICS_HASH_PRIME  0x100000001b3ull
+
+// fnv-1a, folds the raw bytes so any difference in the last bit of a float shows up
+inline u64
+PrototypePhysicsHash(u64 hash, const void* data, size_t size)
+{
+    const u8* bytes = static_cast<const u8*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= PROTOTYPE_PHYSICS_HASH_PRIME;
+    }
+    return hash;
+}
+
+// a batch queued with submitQueryBatch, kept by the backends until their next update
+struct PrototypePhysicsQueryBatch
+{
+    const PrototypePhysicsQuery* queries;
+    size_t                       count;
+    PrototypePhysicsQueryHit*    hits;
+};
+
 struct PROTOTYPE_PURE_ABSTRACT PrototypePhysics
 {
     // deconstructor
@@ -90,11 +208,42 @@ struct PROTOTYPE_PURE_ABSTRACT PrototypePhysics
     // check if simulation is playing
     virtual bool isPlaying() = 0;
 
+    // switch the lockstep mode on or off, call before the first record pass so the scenes get created accordingly
+    virtual void setLockstep(const PrototypePhysicsLockstep& lockstep) = 0;
+
+    // current lockstep mode
+    virtual const PrototypePhysicsLockstep& lockstep() = 0;
+
+    // hash of the object ids, poses and velocities of the dynamic bodies of the current scene as of the last step,
+    // equal between two runs fed the same inputs in lockstep mode
+    virtual u64 stateHash() = 0;
+
     // force move the rigidbody from a random transformation, overwrite the simulation constraints and forces etc ..
     virtual void overrideRigidbodyGlobalPos(PrototypeObject* object) = 0;
 
-    // shoot a ray to the unknown from a point and a direction and length of the ray
-    virtual std::optional<PrototypeObject*> raycast(const glm::vec3& origin, const glm::vec3& dir, const f32 length) = 0;
+    // shoot a ray to the unknown from a point and a direction and length of the ray, layerMask has a bit per collision
+    // layer the ray can hit, 0 hits every layer
+    virtual std::optional<PrototypeObject*> raycast(const glm::vec3& origin,
+                                                    const glm::vec3& dir,
+                                                    const f32        length,
+                                                    u32              layerMask) = 0;
+
+    // run count queries split across the physics worker threads and wait for them, hits[i] is the result of queries[i]
+    virtual void queryBatch(const PrototypePhysicsQuery* queries, size_t count, PrototypePhysicsQueryHit* hits) = 0;
+
+    // queue count queries to run as a batch at the end of the next update after the simulation step,
+    // both arrays must stay alive until then
+    virtual void submitQueryBatch(const PrototypePhysicsQuery* queries, size_t count, PrototypePhysicsQueryHit* hits) = 0;
+
+    // how the physics scene of the named PrototypeScene gets stepped, scenes are active until told otherwise,
+    // rate is the steps per second of a throttled scene and ignored otherwise
+    virtual void setSceneActivity(const std::string& sceneName, PrototypePhysicsSceneActivity_ activity, f32 rate) = 0;
+
+    // pair counts of the last step of the current scene
+    virtual void fetchStatistics(PrototypePhysicsStatistics& statistics) = 0;
+
+    // contact, trigger and sleep events of the last update in one flat buffer, valid until the next update
+    virtual const std::vector<PrototypePhysicsEvent>& events() = 0;
 
     // get the model matrix for the given rigidbody
     virtual void fetchModelMatrix(void* rigidbody, void* shape, glm::mat4& model) = 0;
@@ -149,6 +298,9 @@ struct PROTOTYPE_PURE_ABSTRACT PrototypePhysics
     // update the rigidbody for whther it's trigger or not
     virtual void updateRigidbodyTrigger(PrototypeObject* object) = 0;
 
+    // update which physics events get generated for the rigidbody from its RigidbodyEvents_ opt-in bits
+    virtual void updateRigidbodyEvents(PrototypeObject* object) = 0;
+
     // overwrite the simulation's linear velocity for the given object's rigidbody
     virtual void updateRigidbodyLinearVelocity(PrototypeObject* object) = 0;
 
@@ -173,6 +325,9 @@ struct PROTOTYPE_PURE_ABSTRACT PrototypePhysics
     // changes collider for the given object
     virtual void updateCollider(PrototypeObject* object, const std::string& shapeName) = 0;
 
+    // moves the collider of the given object to the collision layer of its collider trait
+    virtual void updateColliderLayer(PrototypeObject* object) = 0;
+
     // scales collider for the given object
     virtual void scaleCollider(PrototypeObject* object, const glm::vec3& scale) = 0;
 
@@ -182,6 +337,20 @@ struct PROTOTYPE_PURE_ABSTRACT PrototypePhysics
     // destroys a rigidbody
     virtual void destroyRigidbody(void* rigidbody) = 0;
 
+    // the rigidbodies created or reactivated until endActorBatch are added to the scene at once instead of one at a time,
+    // batches don't nest and must be ended before the next update
+    virtual void beginActorBatch() = 0;
+    virtual void endActorBatch()   = 0;
+
+    // takes the rigidbody of the object out of the simulation without destroying it, or puts it back at the pose and
+    // velocities of its traits, lets pooled objects be reused without creating (or cooking) their actors again
+    virtual void setRigidbodyActive(PrototypeObject* object, bool active) = 0;
+
+    // creates the actors of objects that joined the current scene after its physics scene got recorded, like streamed
+    // layers, the record pass creates the ones of the objects that were already there, objects without a transform,
+    // collider and rigidbody are skipped
+    virtual void createActors(PrototypeObject* const* objects, size_t count) = 0;
+
     // spawn a new vehicle
     virtual void spawnVehicle() = 0;
 
@@ -14,6 +14,10 @@
 
 #include "PrototypePipelines.h"
 
+#include "PrototypeEngine.h"
+
+#include <PrototypeCommon/FrameArena.h>
+
 #include <PrototypeTraitSystem/PrototypeTraitSystem.h>
 
 std::vector<PrototypePipelineQueue> PrototypePipelines::shortcutsQueue;
@@ -56,14 +60,44 @@ PROTOTYPE_PIPELINE_COMMAND_CALL_DEFINITION(shortcutEditorCommitReloadPlugin, plu
 
 // clang-format on
 
-void
-PrototypePipelineQueue::record(std::unique_ptr<PrototypePipelineAbstractCommand> command)
+PrototypePipelineQueue::PrototypePipelineQueue(PrototypePipelineQueue&& other) noexcept
+  : _head(other._head)
+  , _tail(other._tail)
+{
+    other._head = nullptr;
+    other._tail = nullptr;
+}
+
+PrototypePipelineQueue::~PrototypePipelineQueue()
 {
-    _commands.push_back(std::move(command));
+    // the arena takes the memory back at its frame boundary, only the destructors are left to run
+    PrototypePipelineAbstractCommand* command = _head;
+    while (command) {
+        PrototypePipelineAbstractCommand* next = command->next;
+        command->~PrototypePipelineAbstractCommand();
+        command = next;
+    }
 }
 
 void
 PrototypePipelineQueue::dispatch()
 {
-    for (const auto& command : _commands) { command->call(); }
+    for (const PrototypePipelineAbstractCommand* command = _head; command; command = command->next) { command->call(); }
+}
+
+void*
+PrototypePipelineQueue::allocate(size_t size, size_t alignment)
+{
+    return PrototypeEngineInternalApplication::frameArena->allocate(size, alignment);
+}
+
+void
+PrototypePipelineQueue::append(PrototypePipelineAbstractCommand* command)
+{
+    if (_tail) {
+        _tail->next = command;
+    } else {
+        _head = command;
+    }
+    _tail = command;
 }
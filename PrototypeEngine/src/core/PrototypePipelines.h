@@ -19,6 +19,7 @@
 #include "PrototypeCameraSystem.h"
 #include "PrototypeShortcuts.h"
 
+#include <new>
 #include <set>
 
 struct ScriptCodeLink;
@@ -27,6 +28,8 @@ struct PrototypePipelineAbstractCommand
 {
     virtual ~PrototypePipelineAbstractCommand() {}
     virtual void call() const = 0;
+
+    PrototypePipelineAbstractCommand* next = nullptr; // next command of the same queue
 };
 
 // clang-format off
@@ -69,13 +72,34 @@ PROTOTYPE_PIPELINE_COMMAND_CALL_DECLARATION(shortcutEditorCommitReloadPlugin, Pr
 
 // clang-format on
 
+// commands are constructed in the frame arena and destroyed with the queue, a queue has to be dispatched and dropped
+// within PROTOTYPE_FRAME_ARENA_FRAMES_IN_FLIGHT frames of recording it
 struct PrototypePipelineQueue
 {
-    void record(std::unique_ptr<PrototypePipelineAbstractCommand> command);
+    PrototypePipelineQueue() = default;
+    PrototypePipelineQueue(PrototypePipelineQueue&& other) noexcept;
+    ~PrototypePipelineQueue();
+
+    PrototypePipelineQueue(const PrototypePipelineQueue&) = delete;
+    PrototypePipelineQueue& operator=(const PrototypePipelineQueue&) = delete;
+    PrototypePipelineQueue& operator=(PrototypePipelineQueue&&) = delete;
+
+    // appends a value initialized command and returns it so the caller fills its arguments
+    template<typename Command>
+    Command* record()
+    {
+        Command* command = new (allocate(sizeof(Command), alignof(Command))) Command();
+        append(command);
+        return command;
+    }
     void dispatch();
 
   private:
-    std::vector<std::unique_ptr<PrototypePipelineAbstractCommand>> _commands;
+    void* allocate(size_t size, size_t alignment);
+    void  append(PrototypePipelineAbstractCommand* command);
+
+    PrototypePipelineAbstractCommand* _head = nullptr;
+    PrototypePipelineAbstractCommand* _tail = nullptr;
 };
 
 struct PrototypePipelines
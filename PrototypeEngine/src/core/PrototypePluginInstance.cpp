@@ -15,13 +15,19 @@
 #include "PrototypePluginInstance.h"
 
 #include "PrototypeEngine.h"
+#include "PrototypePhysics.h"
+#include "PrototypePluginWatchdog.h"
+#include "PrototypeRecorder.h"
 #include "PrototypeRenderer.h"
 #include "PrototypeScene.h"
 #include "PrototypeSceneNode.h"
+#include "PrototypeThreadpool.h"
 #include "PrototypeUI.h"
 
 #include <PrototypeCommon/IO.h>
 #include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/MemoryTracker.h>
+#include <PrototypeCommon/Tracer.h>
 #include <PrototypeTraitSystem/PrototypeTraitSystem.h>
 
 #include <exception>
@@ -30,6 +36,41 @@
 #define TRY   try
 #define CATCH catch (...)
 
+#define PROTOTYPE_PLUGIN_UPDATE_BATCH_GRAIN_SIZE 64    // objects per range when a thread safe batch gets split
+#define PROTOTYPE_PLUGIN_THROTTLE_OVERRUNS       3     // consecutive frames over budget before a plugin gets throttled
+#define PROTOTYPE_PLUGIN_TIMINGS_SMOOTHING       0.05f // weight of the last frame in the moving average
+
+static PrototypePluginWatchdog*             gWatchdog         = nullptr;
+static f32                                  gBudgetMs         = 0.0f;
+static u32                                  gThrottleInterval = 0;
+static std::unordered_map<std::string, f32> gBudgetsByName;
+
+// times one call into a plugin and keeps the watchdog informed, scripts linked before the instance existed are not timed
+struct PrototypePluginCallScope
+{
+    PrototypePluginCallScope(PrototypePluginInstance* instance, PrototypePluginProtocol_ protocol)
+      : _instance(instance)
+      , _protocol(protocol)
+      , _startNs(0)
+    {
+        if (!_instance) { return; }
+        _startNs = PrototypePluginWatchdog::now();
+        if (gWatchdog) { gWatchdog->enter(_instance->name().c_str(), PrototypePluginInstance::protocolName(_protocol), _startNs); }
+    }
+
+    ~PrototypePluginCallScope()
+    {
+        if (!_instance) { return; }
+        if (gWatchdog) { gWatchdog->leave(); }
+        _instance->recordCall(_protocol, PrototypePluginWatchdog::now() - _startNs);
+    }
+
+  private:
+    PrototypePluginInstance* _instance;
+    PrototypePluginProtocol_ _protocol;
+    u64                      _startNs;
+};
+
 static bool
 defaultPluginLoadProtocol(PrototypeEngineContext*, PrototypeLoggerData*)
 {
@@ -110,6 +151,10 @@ static void
 defaultPluginOnWindowMaximizeRestore(PrototypeObject*)
 {}
 
+static void
+defaultPluginOnPhysicsEvents(const PrototypePhysicsEvent*, u32)
+{}
+
 PrototypePluginInstance::PrototypePluginInstance(const std::string& filepath)
   : _filepath(filepath)
   , _LoadProtocol(nullptr)
@@ -118,11 +163,26 @@ PrototypePluginInstance::PrototypePluginInstance(const std::string& filepath)
   , _UpdateProtocol(nullptr)
   , _EndProtocol(nullptr)
   , _UnloadProtocol(nullptr)
+  , _OnPhysicsEvents(nullptr)
+  , _UpdateBatchProtocol(nullptr)
+  , _updateBatchThreadSafe(false)
+  , _SerializeProtocol(nullptr)
+  , _DeserializeProtocol(nullptr)
   , _needsUpload(false)
   , _timestamp(0)
+  , _timings({})
+  , _overrunStreak(0)
+  , _frameIndex(0)
 {
     std::filesystem::path p(_filepath);
     _name = p.filename().string();
+
+    for (size_t i = 0; i < PrototypePluginProtocol_Count; ++i) {
+        _frameNs[i].store(0, std::memory_order_relaxed);
+        _frameCalls[i].store(0, std::memory_order_relaxed);
+    }
+    auto budgetIt = gBudgetsByName.find(_name);
+    _budgetMs     = budgetIt != gBudgetsByName.end() ? budgetIt->second : gBudgetMs;
 }
 
 PrototypePluginInstance::~PrototypePluginInstance() {}
@@ -148,6 +208,7 @@ PrototypePluginInstance::commitChange()
 bool
 PrototypePluginInstance::load()
 {
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scripts)
     _timestamp = PrototypeIo::filestamp(_filepath);
     PrototypeIo::copyFile(_filepath.c_str(), _name.c_str());
     _handle = PROTOTYPE_DLL_OPEN(_name.c_str(), RTLD_LAZY);
@@ -242,14 +303,36 @@ PrototypePluginInstance::load()
         PrototypeLogger::warn("%s: Failed to link with PluginOnWindowMaximizeRestore", _name.c_str());
         _OnWindowMaximizeRestore = defaultPluginOnWindowMaximizeRestore;
     }
+    _OnPhysicsEvents = (PluginOnPhysicsEventsFn)PROTOTYPE_DLL_GET_PROC_ADDRESS(_handle, "PluginOnPhysicsEvents");
+    if (_OnPhysicsEvents == NULL) {
+        PrototypeLogger::warn("%s: Failed to link with PluginOnPhysicsEvents", _name.c_str());
+        _OnPhysicsEvents = defaultPluginOnPhysicsEvents;
+    }
+    // optional, plugins without it keep getting one PluginUpdateProtocol call per object
+    _UpdateBatchProtocol = (PluginUpdateBatchProtocolFn)PROTOTYPE_DLL_GET_PROC_ADDRESS(_handle, "PluginUpdateBatchProtocol");
+    PluginIsUpdateBatchThreadSafeFn isUpdateBatchThreadSafe =
+      (PluginIsUpdateBatchThreadSafeFn)PROTOTYPE_DLL_GET_PROC_ADDRESS(_handle, "PluginIsUpdateBatchThreadSafe");
+    _updateBatchThreadSafe = _UpdateBatchProtocol != NULL && isUpdateBatchThreadSafe != NULL && isUpdateBatchThreadSafe();
+    // optional, plugins without them get their objects ended and started again on every reload
+    _SerializeProtocol   = (PluginSerializeProtocolFn)PROTOTYPE_DLL_GET_PROC_ADDRESS(_handle, "PluginSerializeProtocol");
+    _DeserializeProtocol = (PluginDeserializeProtocolFn)PROTOTYPE_DLL_GET_PROC_ADDRESS(_handle, "PluginDeserializeProtocol");
     PrototypeEngineContext context = {};
     context.application            = PrototypeEngineInternalApplication::application;
     context.shouldQuit             = PrototypeEngineInternalApplication::shouldQuit;
+    context.headless               = PrototypeEngineInternalApplication::headless;
     context.database               = PrototypeEngineInternalApplication::database;
     context.window                 = PrototypeEngineInternalApplication::window;
     context.renderer               = PrototypeEngineInternalApplication::renderer;
     context.physics                = PrototypeEngineInternalApplication::physics;
     context.scene                  = PrototypeEngineInternalApplication::scene;
+    context.frameArena             = PrototypeEngineInternalApplication::frameArena;
+    context.recorder               = PrototypeEngineInternalApplication::recorder;
+    context.threadpool             = PrototypeEngineInternalApplication::threadpool;
+    context.objectPool             = PrototypeEngineInternalApplication::objectPool;
+    context.transformHierarchy     = PrototypeEngineInternalApplication::transformHierarchy;
+    context.sceneStreamer          = PrototypeEngineInternalApplication::sceneStreamer;
+    context.sceneJournal           = PrototypeEngineInternalApplication::sceneJournal;
+    context.tracerData             = PrototypeTracer::data();
 #if defined(PROTOTYPE_ENABLE_PROFILER)
     context.profiler = PrototypeEngineInternalApplication::profiler;
 #endif
@@ -261,17 +344,26 @@ PrototypePluginInstance::load()
 bool
 PrototypePluginInstance::reload()
 {
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scripts)
+    PROTOTYPE_TRACE_FUNCTION()
+    const u64 reloadStartNs = PrototypePluginWatchdog::now();
+    // objects of a plugin that carries its state over are neither ended nor started again, the old library decides it
+    // on its own exports, a new build that can't take the state back starts the objects again
+    const bool snapshotted = snapshotState();
+
     std::vector<std::pair<PrototypeObject*, Script*>> scripts;
     auto scriptableObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(PrototypeTraitTypeMaskScript);
     for (const auto& scriptableObject : scriptableObjects) {
         Script* script = scriptableObject->getScriptTrait();
         auto    it     = script->codeLinks.find(_filepath);
         if (it != script->codeLinks.end()) {
-            PrototypePluginInstance::safeCallEndProtocol(&it->second, scriptableObject);
+            if (!snapshotted) { PrototypePluginInstance::safeCallEndProtocol(&it->second, scriptableObject); }
             scripts.push_back({ scriptableObject, script });
             script->codeLinks.erase(_filepath);
         }
     }
+    // pending records may still point at format strings that live inside the library
+    PrototypeLogger::flush();
     PROTOTYPE_DLL_CLOSE(_handle);
     _timestamp = PrototypeIo::filestamp(_filepath);
     PrototypeIo::copyFile(_filepath.c_str(), _name.c_str());
@@ -367,6 +459,19 @@ PrototypePluginInstance::reload()
         PrototypeLogger::warn("%s: Failed to link with PluginOnWindowMaximizeRestore", _name.c_str());
         _OnWindowMaximizeRestore = defaultPluginOnWindowMaximizeRestore;
     }
+    _OnPhysicsEvents = (PluginOnPhysicsEventsFn)PROTOTYPE_DLL_GET_PROC_ADDRESS(_handle, "PluginOnPhysicsEvents");
+    if (_OnPhysicsEvents == NULL) {
+        PrototypeLogger::warn("%s: Failed to link with PluginOnPhysicsEvents", _name.c_str());
+        _OnPhysicsEvents = defaultPluginOnPhysicsEvents;
+    }
+    // optional, plugins without it keep getting one PluginUpdateProtocol call per object
+    _UpdateBatchProtocol = (PluginUpdateBatchProtocolFn)PROTOTYPE_DLL_GET_PROC_ADDRESS(_handle, "PluginUpdateBatchProtocol");
+    PluginIsUpdateBatchThreadSafeFn isUpdateBatchThreadSafe =
+      (PluginIsUpdateBatchThreadSafeFn)PROTOTYPE_DLL_GET_PROC_ADDRESS(_handle, "PluginIsUpdateBatchThreadSafe");
+    _updateBatchThreadSafe = _UpdateBatchProtocol != NULL && isUpdateBatchThreadSafe != NULL && isUpdateBatchThreadSafe();
+    // optional, plugins without them get their objects ended and started again on every reload
+    _SerializeProtocol   = (PluginSerializeProtocolFn)PROTOTYPE_DLL_GET_PROC_ADDRESS(_handle, "PluginSerializeProtocol");
+    _DeserializeProtocol = (PluginDeserializeProtocolFn)PROTOTYPE_DLL_GET_PROC_ADDRESS(_handle, "PluginDeserializeProtocol");
     for (auto& pair : scripts) {
         Script*        script = pair.second;
         ScriptCodeLink link   = {};
@@ -377,23 +482,89 @@ PrototypePluginInstance::reload()
     PrototypeEngineContext context = {};
     context.application            = PrototypeEngineInternalApplication::application;
     context.shouldQuit             = PrototypeEngineInternalApplication::shouldQuit;
+    context.headless               = PrototypeEngineInternalApplication::headless;
     context.database               = PrototypeEngineInternalApplication::database;
     context.window                 = PrototypeEngineInternalApplication::window;
     context.renderer               = PrototypeEngineInternalApplication::renderer;
     context.physics                = PrototypeEngineInternalApplication::physics;
     context.scene                  = PrototypeEngineInternalApplication::scene;
+    context.frameArena             = PrototypeEngineInternalApplication::frameArena;
+    context.recorder               = PrototypeEngineInternalApplication::recorder;
+    context.threadpool             = PrototypeEngineInternalApplication::threadpool;
+    context.objectPool             = PrototypeEngineInternalApplication::objectPool;
+    context.transformHierarchy     = PrototypeEngineInternalApplication::transformHierarchy;
+    context.sceneStreamer          = PrototypeEngineInternalApplication::sceneStreamer;
+    context.sceneJournal           = PrototypeEngineInternalApplication::sceneJournal;
+    context.tracerData             = PrototypeTracer::data();
 #if defined(PROTOTYPE_ENABLE_PROFILER)
     context.profiler = PrototypeEngineInternalApplication::profiler;
 #endif
     context.traitSystemData = PrototypeEngineInternalApplication::traitSystemData;
     _ReloadProtocol(&context, PrototypeLogger::data());
-    for (auto& pair : scripts) {
-        PrototypeObject* object = pair.first;
-        Script*          script = pair.second;
-        auto             it     = script->codeLinks.find(_filepath);
-        if (it != script->codeLinks.end()) { PrototypePluginInstance::safeCallStartProtocol(&it->second, object); }
+    const bool restored = snapshotted && restoreState();
+    if (snapshotted && !restored) {
+        // the objects were never ended, whatever their start made with the old library is leaked and made once more
+        PrototypeLogger::error("%s: The state couldn't be restored after the reload, its objects are started again without "
+                               "having been ended",
+                               _name.c_str());
+    }
+    if (!restored) {
+        for (auto& pair : scripts) {
+            PrototypeObject* object = pair.first;
+            Script*          script = pair.second;
+            auto             it     = script->codeLinks.find(_filepath);
+            if (it != script->codeLinks.end()) { PrototypePluginInstance::safeCallStartProtocol(&it->second, object); }
+        }
+    }
+    PrototypeLogger::trace("%s: Reloaded in %.2f ms, %s",
+                           _name.c_str(),
+                           (f64)(PrototypePluginWatchdog::now() - reloadStartNs) / 1000000.0,
+                           restored ? "state restored" : "objects restarted");
+
+    return true;
+}
+
+bool
+PrototypePluginInstance::snapshotState()
+{
+    if (_SerializeProtocol == NULL || _DeserializeProtocol == NULL) { return false; }
+    TRY
+    {
+        const u64 size = _SerializeProtocol(nullptr, 0);
+        if (size > _snapshot.capacity()) { _snapshot.reserve(size); }
+        _snapshot.resize(size);
+        if (size > 0 && _SerializeProtocol(_snapshot.data(), size) != size) {
+            PrototypeLogger::warn("%s: PluginSerializeProtocol changed its state size between two calls", _name.c_str());
+            return false;
+        }
+    }
+    CATCH
+    {
+        PrototypeLogger::error("%s: Exception raised while calling SerializeProtocol function", _name.c_str());
+        return false;
     }
+    return true;
+}
 
+bool
+PrototypePluginInstance::restoreState()
+{
+    if (_DeserializeProtocol == NULL) {
+        PrototypeLogger::warn("%s: Failed to link with PluginDeserializeProtocol, restarting its objects", _name.c_str());
+        return false;
+    }
+    TRY
+    {
+        if (!_DeserializeProtocol(_snapshot.data(), (u64)_snapshot.size())) {
+            PrototypeLogger::warn("%s: PluginDeserializeProtocol rejected the state, restarting its objects", _name.c_str());
+            return false;
+        }
+    }
+    CATCH
+    {
+        PrototypeLogger::error("%s: Exception raised while calling DeserializeProtocol function", _name.c_str());
+        return false;
+    }
     return true;
 }
 
@@ -408,6 +579,7 @@ PrototypePluginInstance::unload()
 {
     if (_handle != NULL) {
         _UnloadProtocol();
+        PrototypeLogger::flush();
         PROTOTYPE_DLL_CLOSE(_handle);
     }
     return true;
@@ -479,6 +651,84 @@ PrototypePluginInstance::onWindowMaximizeRestore(PrototypeObject* object)
     _OnWindowMaximizeRestore(object);
 }
 
+void
+PrototypePluginInstance::onPhysicsEvents(const PrototypePhysicsEvent* events, u32 count)
+{
+    PrototypePluginCallScope scope(this, PrototypePluginProtocol_PhysicsEvents);
+    TRY { _OnPhysicsEvents(events, count); }
+    CATCH { PrototypeLogger::error("%s: Exception raised while calling OnPhysicsEvents function", _name.c_str()); }
+}
+
+void
+PrototypePluginInstance::endFrame()
+{
+    f32 totalMs = 0.0f;
+    for (size_t i = 0; i < PrototypePluginProtocol_Count; ++i) {
+        _timings.frameMs[i]    = (f32)((f64)_frameNs[i].exchange(0, std::memory_order_relaxed) / 1000000.0);
+        _timings.frameCalls[i] = _frameCalls[i].exchange(0, std::memory_order_relaxed);
+        totalMs += _timings.frameMs[i];
+    }
+    _timings.totalMs   = totalMs;
+    _timings.averageMs = _frameIndex == 0 ? totalMs
+                                          : _timings.averageMs + (totalMs - _timings.averageMs) * PROTOTYPE_PLUGIN_TIMINGS_SMOOTHING;
+    _timings.peakMs    = std::max(_timings.peakMs, totalMs);
+
+    // the frames a throttled plugin skips say nothing about its cost
+    if (_budgetMs > 0.0f && updatesThisFrame()) {
+        if (totalMs > _budgetMs) {
+            ++_timings.overruns;
+            if (_overrunStreak++ == 0) {
+                PrototypeLogger::warn("%s: Took %.2f ms, over its %.2f ms frame budget", _name.c_str(), totalMs, _budgetMs);
+            }
+            if (!_timings.throttled && gThrottleInterval > 1 && _overrunStreak >= PROTOTYPE_PLUGIN_THROTTLE_OVERRUNS) {
+                _timings.throttled = true;
+                PrototypeLogger::warn("%s: Over budget for %u frames in a row, updating it every %u frames",
+                                      _name.c_str(),
+                                      _overrunStreak,
+                                      gThrottleInterval);
+            }
+        } else {
+            _overrunStreak = 0;
+            if (_timings.throttled) {
+                _timings.throttled = false;
+                PrototypeLogger::trace("%s: Back within budget, updating it every frame", _name.c_str());
+            }
+        }
+    }
+    ++_frameIndex;
+}
+
+void
+PrototypePluginInstance::recordCall(PrototypePluginProtocol_ protocol, u64 elapsedNs)
+{
+    _frameNs[protocol].fetch_add(elapsedNs, std::memory_order_relaxed);
+    _frameCalls[protocol].fetch_add(1, std::memory_order_relaxed);
+}
+
+const PrototypePluginTimings&
+PrototypePluginInstance::timings() const
+{
+    return _timings;
+}
+
+f32
+PrototypePluginInstance::budgetMs() const
+{
+    return _budgetMs;
+}
+
+void
+PrototypePluginInstance::setBudgetMs(f32 budgetMs)
+{
+    _budgetMs = budgetMs;
+}
+
+bool
+PrototypePluginInstance::updatesThisFrame() const
+{
+    return !_timings.throttled || gThrottleInterval < 2 || _frameIndex % gThrottleInterval == 0;
+}
+
 const std::string&
 PrototypePluginInstance::name() const
 {
@@ -525,6 +775,9 @@ PrototypePluginInstance::linkScript(ScriptCodeLink* script)
     script->_OnWindowIconifyRestore  = _OnWindowIconifyRestore;
     script->_OnWindowMaximize        = _OnWindowMaximize;
     script->_OnWindowMaximizeRestore = _OnWindowMaximizeRestore;
+    script->_UpdateBatchProtocol     = _UpdateBatchProtocol;
+    script->_updateBatchThreadSafe   = _updateBatchThreadSafe;
+    script->_instance                = this;
 }
 
 // void
@@ -554,6 +807,7 @@ PrototypePluginInstance::linkScript(ScriptCodeLink* script)
 void
 PrototypePluginInstance::safeCallStartProtocol(const ScriptCodeLink* script, PrototypeObject* object)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Start);
     TRY { script->_StartProtocol(object); }
     CATCH
     {
@@ -569,25 +823,69 @@ PrototypePluginInstance::safeCallStartProtocol(const ScriptCodeLink* script, Pro
 }
 
 void
-PrototypePluginInstance::safeCallUpdateProtocol(const ScriptCodeLink* script, PrototypeObject* object)
+PrototypePluginInstance::safeCallUpdateProtocol(const ScriptCodeLink* script, PrototypeObject* const* objects, size_t count)
 {
-    TRY { script->_UpdateProtocol(object); }
-    CATCH
-    {
-        char buf[512];
-        snprintf(buf,
-                 sizeof(buf),
-                 "%s:%s:%i\nException raised while calling UpdateProtocol function",
-                 ((PrototypeSceneNode*)object->parentNode())->name().c_str(),
-                 script->filepath.c_str(),
-                 1);
-        PrototypeLogger::log(script->filepath.c_str(), 1, buf);
+    if (script->_instance && !script->_instance->updatesThisFrame()) { return; }
+    // one timed call per plugin and frame, the clock and the watchdog cost too much per object
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Update);
+    for (size_t i = 0; i < count; ++i) {
+        PrototypeObject* object = objects[i];
+        TRY { script->_UpdateProtocol(object); }
+        CATCH
+        {
+            char buf[512];
+            snprintf(buf,
+                     sizeof(buf),
+                     "%s:%s:%i\nException raised while calling UpdateProtocol function",
+                     ((PrototypeSceneNode*)object->parentNode())->name().c_str(),
+                     script->filepath.c_str(),
+                     1);
+            PrototypeLogger::log(script->filepath.c_str(), 1, buf);
+        }
+    }
+}
+
+bool
+PrototypePluginInstance::hasUpdateBatchProtocol(const ScriptCodeLink* script)
+{
+    return script->_UpdateBatchProtocol != nullptr;
+}
+
+void
+PrototypePluginInstance::safeCallUpdateBatchProtocol(const ScriptCodeLink* script, PrototypeObject* const* objects, size_t count)
+{
+    if (script->_instance && !script->_instance->updatesThisFrame()) { return; }
+    auto updateRange = [script, objects](size_t begin, size_t end) {
+        PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Update);
+        TRY { script->_UpdateBatchProtocol(objects + begin, (u32)(end - begin)); }
+        CATCH
+        {
+            char buf[512];
+            snprintf(buf,
+                     sizeof(buf),
+                     "%s:%i\nException raised while calling UpdateBatchProtocol function",
+                     script->filepath.c_str(),
+                     1);
+            PrototypeLogger::log(script->filepath.c_str(), 1, buf);
+        }
+    };
+    // recorded, replayed and lockstep sessions fold the plugin calls into an order dependent digest, keep the batch in
+    // order there
+    const bool ordered = PrototypeEngineInternalApplication::recorder->mode() != PrototypeRecorderMode_Off ||
+                         (PrototypeEngineInternalApplication::physics &&
+                          PrototypeEngineInternalApplication::physics->lockstep().enabled);
+    if (script->_updateBatchThreadSafe && !ordered) {
+        PrototypeEngineInternalApplication::threadpool->parallelFor(
+          count, PROTOTYPE_PLUGIN_UPDATE_BATCH_GRAIN_SIZE, updateRange);
+    } else {
+        updateRange(0, count);
     }
 }
 
 void
 PrototypePluginInstance::safeCallEndProtocol(const ScriptCodeLink* script, PrototypeObject* object)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_End);
     TRY { script->_EndProtocol(object); }
     CATCH
     {
@@ -605,6 +903,7 @@ PrototypePluginInstance::safeCallEndProtocol(const ScriptCodeLink* script, Proto
 void
 PrototypePluginInstance::safeCallOnMouse(const ScriptCodeLink* script, PrototypeObject* object, i32 button, i32 action, i32 mods)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Input);
     TRY { script->_OnMouse(object, button, action, mods); }
     CATCH
     {
@@ -622,6 +921,7 @@ PrototypePluginInstance::safeCallOnMouse(const ScriptCodeLink* script, Prototype
 void
 PrototypePluginInstance::safeCallOnMouseMove(const ScriptCodeLink* script, PrototypeObject* object, f64 x, f64 y)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Input);
     TRY { script->_OnMouseMove(object, x, y); }
     CATCH
     {
@@ -639,6 +939,7 @@ PrototypePluginInstance::safeCallOnMouseMove(const ScriptCodeLink* script, Proto
 void
 PrototypePluginInstance::safeCallOnMouseDrag(const ScriptCodeLink* script, PrototypeObject* object, i32 button, f64 x, f64 y)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Input);
     TRY { script->_OnMouseDrag(object, button, x, y); }
     CATCH
     {
@@ -656,6 +957,7 @@ PrototypePluginInstance::safeCallOnMouseDrag(const ScriptCodeLink* script, Proto
 void
 PrototypePluginInstance::safeCallOnMouseScroll(const ScriptCodeLink* script, PrototypeObject* object, f64 x, f64 y)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Input);
     TRY { script->_OnMouseScroll(object, x, y); }
     CATCH
     {
@@ -678,6 +980,7 @@ PrototypePluginInstance::safeCallOnKeyboard(const ScriptCodeLink* script,
                                             i32                   action,
                                             i32                   mods)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Input);
     TRY { script->_OnKeyboard(object, key, scancode, action, mods); }
     CATCH
     {
@@ -695,6 +998,7 @@ PrototypePluginInstance::safeCallOnKeyboard(const ScriptCodeLink* script,
 void
 PrototypePluginInstance::safeCallOnWindowResize(const ScriptCodeLink* script, PrototypeObject* object, i32 width, i32 height)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Input);
     TRY { script->_OnWindowResize(object, width, height); }
     CATCH
     {
@@ -715,6 +1019,7 @@ PrototypePluginInstance::safeCallOnWindowDragDrop(const ScriptCodeLink* script,
                                                   i32                   numFiles,
                                                   const char**          names)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Input);
     TRY { script->_OnWindowDragDrop(object, numFiles, names); }
     CATCH
     {
@@ -732,6 +1037,7 @@ PrototypePluginInstance::safeCallOnWindowDragDrop(const ScriptCodeLink* script,
 void
 PrototypePluginInstance::safeCallOnWindowIconify(const ScriptCodeLink* script, PrototypeObject* object)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Input);
     TRY { script->_OnWindowIconify(object); }
     CATCH
     {
@@ -749,6 +1055,7 @@ PrototypePluginInstance::safeCallOnWindowIconify(const ScriptCodeLink* script, P
 void
 PrototypePluginInstance::safeCallOnWindowIconifyRestore(const ScriptCodeLink* script, PrototypeObject* object)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Input);
     TRY { script->_OnWindowIconifyRestore(object); }
     CATCH
     {
@@ -766,6 +1073,7 @@ PrototypePluginInstance::safeCallOnWindowIconifyRestore(const ScriptCodeLink* sc
 void
 PrototypePluginInstance::safeCallOnWindowMaximize(const ScriptCodeLink* script, PrototypeObject* object)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Input);
     TRY { script->_OnWindowMaximize(object); }
     CATCH
     {
@@ -783,6 +1091,7 @@ PrototypePluginInstance::safeCallOnWindowMaximize(const ScriptCodeLink* script,
 void
 PrototypePluginInstance::safeCallOnWindowMaximizeRestore(const ScriptCodeLink* script, PrototypeObject* object)
 {
+    PrototypePluginCallScope scope(script->_instance, PrototypePluginProtocol_Input);
     TRY { script->_OnWindowMaximizeRestore(object); }
     CATCH
     {
@@ -796,3 +1105,31 @@ PrototypePluginInstance::safeCallOnWindowMaximizeRestore(const ScriptCodeLink* s
         PrototypeLogger::log(script->filepath.c_str(), 1, buf);
     }
 }
+
+void
+PrototypePluginInstance::setBudgets(f32 budgetMs, u32 throttleInterval, const std::unordered_map<std::string, f32>& budgetsByName)
+{
+    gBudgetMs         = budgetMs;
+    gThrottleInterval = throttleInterval;
+    gBudgetsByName    = budgetsByName;
+}
+
+void
+PrototypePluginInstance::setWatchdog(PrototypePluginWatchdog* watchdog)
+{
+    gWatchdog = watchdog;
+}
+
+const char*
+PrototypePluginInstance::protocolName(PrototypePluginProtocol_ protocol)
+{
+    switch (protocol) {
+        case PrototypePluginProtocol_Start: return "StartProtocol";
+        case PrototypePluginProtocol_Update: return "UpdateProtocol";
+        case PrototypePluginProtocol_End: return "EndProtocol";
+        case PrototypePluginProtocol_Input: return "input callbacks";
+        case PrototypePluginProtocol_PhysicsEvents: return "OnPhysicsEvents";
+        default: break;
+    }
+    return "unknown protocol";
+}
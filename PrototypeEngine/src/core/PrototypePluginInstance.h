@@ -20,13 +20,41 @@
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
 
+#include <array>
+#include <atomic>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 struct PrototypeEngineContext;
 struct PrototypeLoggerData;
 struct PrototypeObject;
+struct PrototypePhysicsEvent;
+struct PrototypePluginWatchdog;
 struct ScriptCodeLink;
 
+enum PrototypePluginProtocol_
+{
+    PrototypePluginProtocol_Start = 0,
+    PrototypePluginProtocol_Update, // per object and batched updates
+    PrototypePluginProtocol_End,
+    PrototypePluginProtocol_Input, // mouse, keyboard and window callbacks
+    PrototypePluginProtocol_PhysicsEvents,
+
+    PrototypePluginProtocol_Count
+};
+
+struct PrototypePluginTimings
+{
+    f32  frameMs[PrototypePluginProtocol_Count];    // last frame, summed over every thread that called into the plugin
+    u32  frameCalls[PrototypePluginProtocol_Count]; // last frame
+    f32  totalMs;                                   // last frame, every protocol
+    f32  averageMs;                                 // moving average of totalMs
+    f32  peakMs;                                    // highest totalMs since load
+    u32  overruns;                                  // frames over budget since load
+    bool throttled;                                 // updated every Nth frame only until it gets back within budget
+};
+
 struct PrototypePluginInstance
 {
     typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginLoadProtocolFn)(PrototypeEngineContext*, PrototypeLoggerData*);
@@ -35,6 +63,15 @@ struct PrototypePluginInstance
     typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginUpdateProtocolFn)(PrototypeObject*);
     typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginEndProtocolFn)(PrototypeObject*);
     typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginUnloadProtocolFn)();
+    // optional, replaces the per object PluginUpdateProtocol calls with one call per frame over every object bound to the plugin
+    typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginUpdateBatchProtocolFn)(PrototypeObject* const* objects, u32 count);
+    // optional, returning true lets the engine split the batch in ranges updated concurrently on the threadpool
+    typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginIsUpdateBatchThreadSafeFn)();
+    // optional, writes the plugin state to buffer and returns its size, called with a null buffer first to query the size,
+    // a hot reload then hands the state to the newer library instead of ending and restarting every object
+    typedef u64(PROTOTYPE_DYNAMIC_FN_CALL* PluginSerializeProtocolFn)(void* buffer, u64 capacity);
+    // optional, returning false falls back to calling PluginStartProtocol on every object
+    typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginDeserializeProtocolFn)(const void* buffer, u64 size);
 
     typedef void(PROTOTYPE_DYNAMIC_FN_CALL* PluginOnMouseFn)(PrototypeObject*, i32 button, i32 action, i32 mods);
     typedef void(PROTOTYPE_DYNAMIC_FN_CALL* PluginOnMouseMoveFn)(PrototypeObject*, f64 x, f64 y);
@@ -47,6 +84,8 @@ struct PrototypePluginInstance
     typedef void(PROTOTYPE_DYNAMIC_FN_CALL* PluginOnWindowIconifyRestoreFn)(PrototypeObject*);
     typedef void(PROTOTYPE_DYNAMIC_FN_CALL* PluginOnWindowMaximizeFn)(PrototypeObject*);
     typedef void(PROTOTYPE_DYNAMIC_FN_CALL* PluginOnWindowMaximizeRestoreFn)(PrototypeObject*);
+    // called once per frame with every physics event of the previous physics step, not per script
+    typedef void(PROTOTYPE_DYNAMIC_FN_CALL* PluginOnPhysicsEventsFn)(const PrototypePhysicsEvent* events, u32 count);
 
     PrototypePluginInstance(const std::string& filepath);
     ~PrototypePluginInstance();
@@ -70,6 +109,16 @@ struct PrototypePluginInstance
     void onWindowIconifyRestore(PrototypeObject* object);
     void onWindowMaximize(PrototypeObject* object);
     void onWindowMaximizeRestore(PrototypeObject* object);
+    void onPhysicsEvents(const PrototypePhysicsEvent* events, u32 count);
+
+    // folds the calls of the frame into the timings, warns on budget overruns and throttles the plugin if it keeps overrunning
+    void                          endFrame();
+    void                          recordCall(PrototypePluginProtocol_ protocol, u64 elapsedNs);
+    const PrototypePluginTimings& timings() const;
+    f32                           budgetMs() const;
+    void                          setBudgetMs(f32 budgetMs);
+    // false on the frames a throttled plugin skips
+    bool                          updatesThisFrame() const;
 
     const std::string& name() const;
     const std::string& filepath() const;
@@ -79,7 +128,9 @@ struct PrototypePluginInstance
     void linkScript(ScriptCodeLink* script);
 
     static void safeCallStartProtocol(const ScriptCodeLink* script, PrototypeObject* object);
-    static void safeCallUpdateProtocol(const ScriptCodeLink* script, PrototypeObject* object);
+    static void safeCallUpdateProtocol(const ScriptCodeLink* script, PrototypeObject* const* objects, size_t count);
+    static bool hasUpdateBatchProtocol(const ScriptCodeLink* script);
+    static void safeCallUpdateBatchProtocol(const ScriptCodeLink* script, PrototypeObject* const* objects, size_t count);
     static void safeCallEndProtocol(const ScriptCodeLink* script, PrototypeObject* object);
     static void safeCallOnMouse(const ScriptCodeLink* script, PrototypeObject* object, i32 button, i32 action, i32 mods);
     static void safeCallOnMouseMove(const ScriptCodeLink* script, PrototypeObject* object, f64 x, f64 y);
@@ -98,7 +149,18 @@ struct PrototypePluginInstance
     static void safeCallOnWindowMaximize(const ScriptCodeLink* script, PrototypeObject* object);
     static void safeCallOnWindowMaximizeRestore(const ScriptCodeLink* script, PrototypeObject* object);
 
+    // budgetMs applies to every plugin missing from budgetsByName, 0 never checks, a throttleInterval below 2 never throttles
+    static void        setBudgets(f32 budgetMs, u32 throttleInterval, const std::unordered_map<std::string, f32>& budgetsByName);
+    static void        setWatchdog(PrototypePluginWatchdog* watchdog);
+    static const char* protocolName(PrototypePluginProtocol_ protocol);
+
   private:
+    // state of the library about to be unloaded, false if it can't round trip it or serializing failed,
+    // the objects are ended before the unload in that case
+    bool snapshotState();
+    // hands the snapshot to the newly loaded library, false if the objects need to be started again
+    bool restoreState();
+
     PROTOTYPE_DLL_HANDLE_TYPE       _handle;
     PluginLoadProtocolFn            _LoadProtocol;
     PluginReloadProtocolFn          _ReloadProtocol;
@@ -117,8 +179,21 @@ struct PrototypePluginInstance
     PluginOnWindowIconifyRestoreFn  _OnWindowIconifyRestore;
     PluginOnWindowMaximizeFn        _OnWindowMaximize;
     PluginOnWindowMaximizeRestoreFn _OnWindowMaximizeRestore;
+    PluginOnPhysicsEventsFn         _OnPhysicsEvents;
+    PluginUpdateBatchProtocolFn     _UpdateBatchProtocol;
+    bool                            _updateBatchThreadSafe;
+    PluginSerializeProtocolFn       _SerializeProtocol;
+    PluginDeserializeProtocolFn     _DeserializeProtocol;
+    std::vector<u8>                 _snapshot; // kept between reloads so it only grows
     std::string                     _name;
     std::string                     _filepath;
     time_t                          _timestamp;
     bool                            _needsUpload;
+
+    std::array<std::atomic<u64>, PrototypePluginProtocol_Count> _frameNs;
+    std::array<std::atomic<u32>, PrototypePluginProtocol_Count> _frameCalls;
+    PrototypePluginTimings                                      _timings;
+    f32                                                         _budgetMs;
+    u32                                                         _overrunStreak;
+    u64                                                         _frameIndex;
 };
\ No newline at end of file
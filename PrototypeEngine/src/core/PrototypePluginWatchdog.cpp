@@ -0,0 +1,343 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#include "PrototypePluginWatchdog.h"
+
+#include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/StackTrace.h>
+#include <PrototypeCommon/Tracer.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+#include <windows.h>
+#elif defined(PROTOTYPE_PLATFORM_LINUX) || defined(PROTOTYPE_PLATFORM_DARWIN)
+#include <pthread.h>
+#include <signal.h>
+#include <sys/ucontext.h>
+#endif
+
+#define PROTOTYPE_PLUGIN_WATCHDOG_MIN_POLL_NS    10000000ull // 10 ms
+#define PROTOTYPE_PLUGIN_WATCHDOG_STACK_WAIT_MS  100         // how long a hung thread gets to answer the stack signal
+
+static thread_local PrototypePluginWatchdog* tOwner = nullptr;
+static thread_local void*                    tSlot  = nullptr;
+
+// registers and stack of the hung thread, only one dump is in flight at a time
+// the copy is followed by zeroes so an unwind running off its end reads a null return address instead of other memory
+static uintptr_t gStackPc     = 0;
+static uintptr_t gStackFp     = 0;
+static uintptr_t gStackSp     = 0;
+static size_t    gStackCopied = 0;
+static u8        gStackCopy[PROTOTYPE_PLUGIN_WATCHDOG_STACK_COPY + 4096];
+
+#if defined(PROTOTYPE_PLATFORM_LINUX) || defined(PROTOTYPE_PLATFORM_DARWIN)
+static std::atomic<bool> gStackRequested(false);
+static std::atomic<bool> gStackCaptured(false);
+static pthread_t         gStackThread;
+static uintptr_t         gStackHigh = 0;
+static struct sigaction  gPreviousAction;
+
+static void
+forwardStackSignal(int signal, siginfo_t* info, void* ucontext)
+{
+    if (gPreviousAction.sa_flags & SA_SIGINFO) {
+        if (gPreviousAction.sa_sigaction) { gPreviousAction.sa_sigaction(signal, info, ucontext); }
+    } else if (gPreviousAction.sa_handler == SIG_DFL) {
+        // the default action goes ahead once this handler returns and unblocks the signal
+        sigaction(signal, &gPreviousAction, nullptr);
+        raise(signal);
+    } else if (gPreviousAction.sa_handler != SIG_IGN) {
+        gPreviousAction.sa_handler(signal);
+    }
+}
+
+// only async signal safe work in here, the registers and a plain copy of the stack
+static void
+onStackSignal(int signal, siginfo_t* info, void* ucontext)
+{
+    if (!gStackRequested.load(std::memory_order_acquire) || !pthread_equal(pthread_self(), gStackThread)) {
+        forwardStackSignal(signal, info, ucontext);
+        return;
+    }
+    gStackRequested.store(false, std::memory_order_relaxed);
+
+    const ucontext_t* context = (const ucontext_t*)ucontext;
+    uintptr_t         pc      = 0;
+    uintptr_t         fp      = 0;
+    uintptr_t         sp      = 0;
+#if defined(PROTOTYPE_PLATFORM_LINUX) && defined(__x86_64__)
+    pc = (uintptr_t)context->uc_mcontext.gregs[REG_RIP];
+    fp = (uintptr_t)context->uc_mcontext.gregs[REG_RBP];
+    sp = (uintptr_t)context->uc_mcontext.gregs[REG_RSP];
+#elif defined(PROTOTYPE_PLATFORM_LINUX) && defined(__aarch64__)
+    pc = (uintptr_t)context->uc_mcontext.pc;
+    fp = (uintptr_t)context->uc_mcontext.regs[29];
+    sp = (uintptr_t)context->uc_mcontext.sp;
+#elif defined(PROTOTYPE_PLATFORM_DARWIN) && defined(__x86_64__)
+    pc = (uintptr_t)context->uc_mcontext->__ss.__rip;
+    fp = (uintptr_t)context->uc_mcontext->__ss.__rbp;
+    sp = (uintptr_t)context->uc_mcontext->__ss.__rsp;
+#elif defined(PROTOTYPE_PLATFORM_DARWIN) && defined(__arm64__)
+    pc = (uintptr_t)__darwin_arm_thread_state64_get_pc(context->uc_mcontext->__ss);
+    fp = (uintptr_t)__darwin_arm_thread_state64_get_fp(context->uc_mcontext->__ss);
+    sp = (uintptr_t)__darwin_arm_thread_state64_get_sp(context->uc_mcontext->__ss);
+#else
+    (void)context;
+#endif
+    size_t copied = 0;
+    if (sp != 0 && sp < gStackHigh) {
+        copied = std::min((size_t)(gStackHigh - sp), (size_t)PROTOTYPE_PLUGIN_WATCHDOG_STACK_COPY);
+        memcpy(gStackCopy, (const void*)sp, copied);
+    }
+    gStackPc     = pc;
+    gStackFp     = fp;
+    gStackSp     = sp;
+    gStackCopied = copied;
+    gStackCaptured.store(true, std::memory_order_release);
+}
+
+// follows the frame records (saved frame pointer, return address) through the stack copy
+static u32
+walkFramePointers(void** frames)
+{
+    u32       numFrames = 0;
+    uintptr_t fp        = gStackFp;
+    if (gStackPc != 0) { frames[numFrames++] = (void*)gStackPc; }
+    while (numFrames < PROTOTYPE_PLUGIN_WATCHDOG_MAX_FRAMES && fp >= gStackSp && fp % sizeof(uintptr_t) == 0 &&
+           fp + 2 * sizeof(uintptr_t) <= gStackSp + gStackCopied) {
+        uintptr_t record[2];
+        memcpy(record, gStackCopy + (fp - gStackSp), sizeof(record));
+        if (record[1] == 0) { break; }
+        frames[numFrames++] = (void*)record[1];
+        // frames only ever go up the stack, anything else isn't a frame record
+        if (record[0] <= fp) { break; }
+        fp = record[0];
+    }
+    return numFrames;
+}
+#endif
+
+static uintptr_t
+currentStackHigh()
+{
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+    ULONG_PTR low  = 0;
+    ULONG_PTR high = 0;
+    GetCurrentThreadStackLimits(&low, &high);
+    return (uintptr_t)high;
+#elif defined(PROTOTYPE_PLATFORM_LINUX)
+    pthread_attr_t attributes;
+    void*          address = nullptr;
+    size_t         size    = 0;
+    if (pthread_getattr_np(pthread_self(), &attributes) != 0) { return 0; }
+    pthread_attr_getstack(&attributes, &address, &size);
+    pthread_attr_destroy(&attributes);
+    return (uintptr_t)address + size;
+#elif defined(PROTOTYPE_PLATFORM_DARWIN)
+    return (uintptr_t)pthread_get_stackaddr_np(pthread_self());
+#else
+    return 0;
+#endif
+}
+
+static void
+logFrame(u32 index, void* frame)
+{
+    char text[256];
+    PrototypeStackTrace::describeFrame(frame, text, sizeof(text));
+    PrototypeLogger::error("    #%u %s", index, text);
+}
+
+PrototypePluginWatchdog::PrototypePluginWatchdog(f64 hangMs)
+  : _quit(false)
+  , _hangNs((u64)(hangMs * 1000000.0))
+{
+    for (Slot& slot : _slots) {
+        slot.used.store(false, std::memory_order_relaxed);
+        slot.startNs.store(0, std::memory_order_relaxed);
+        slot.plugin     = nullptr;
+        slot.protocol   = nullptr;
+        slot.depth      = 0;
+        slot.reportedNs = 0;
+        slot.thread     = {};
+        slot.stackHigh  = 0;
+    }
+#if defined(PROTOTYPE_PLATFORM_LINUX) || defined(PROTOTYPE_PLATFORM_DARWIN)
+    struct sigaction action = {};
+    action.sa_sigaction     = onStackSignal;
+    action.sa_flags         = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGUSR2, &action, &gPreviousAction);
+#endif
+    _thread = std::thread(&PrototypePluginWatchdog::run, this);
+}
+
+PrototypePluginWatchdog::~PrototypePluginWatchdog()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    _condition.notify_all();
+    _thread.join();
+#if defined(PROTOTYPE_PLATFORM_LINUX) || defined(PROTOTYPE_PLATFORM_DARWIN)
+    sigaction(SIGUSR2, &gPreviousAction, nullptr);
+#endif
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+    for (Slot& slot : _slots) {
+        if (slot.used.load(std::memory_order_acquire)) { CloseHandle((HANDLE)slot.thread); }
+    }
+#endif
+}
+
+void
+PrototypePluginWatchdog::enter(const char* plugin, const char* protocol, u64 startNs)
+{
+    if (tOwner != this) {
+        tOwner = this;
+        tSlot  = nullptr;
+        for (Slot& slot : _slots) {
+            bool expected = false;
+            if (slot.used.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+                slot.thread = OpenThread(
+                  THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT | THREAD_QUERY_INFORMATION, FALSE, GetCurrentThreadId());
+#elif defined(PROTOTYPE_PLATFORM_LINUX) || defined(PROTOTYPE_PLATFORM_DARWIN)
+                slot.thread = pthread_self();
+#endif
+                slot.stackHigh = currentStackHigh();
+                tSlot          = &slot;
+                break;
+            }
+        }
+        if (!tSlot) { PrototypeLogger::warn("Plugin watchdog is out of slots, calls from this thread aren't watched"); }
+    }
+    Slot* slot = (Slot*)tSlot;
+    if (!slot || slot->depth++ > 0) { return; }
+    slot->plugin   = plugin;
+    slot->protocol = protocol;
+    slot->startNs.store(startNs, std::memory_order_release);
+}
+
+void
+PrototypePluginWatchdog::leave()
+{
+    Slot* slot = tOwner == this ? (Slot*)tSlot : nullptr;
+    if (!slot || --slot->depth > 0) { return; }
+    slot->startNs.store(0, std::memory_order_release);
+}
+
+u64
+PrototypePluginWatchdog::now()
+{
+    return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void
+PrototypePluginWatchdog::run()
+{
+    PrototypeTracer::setThreadName("PrototypePluginWatchdog");
+    const std::chrono::nanoseconds interval(std::max(_hangNs / 4, PROTOTYPE_PLUGIN_WATCHDOG_MIN_POLL_NS));
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (!_condition.wait_for(lock, interval, [this]() { return _quit; })) {
+        const u64 nowNs = now();
+        for (Slot& slot : _slots) {
+            if (!slot.used.load(std::memory_order_acquire)) { continue; }
+            const u64 startNs = slot.startNs.load(std::memory_order_acquire);
+            if (startNs == 0 || startNs == slot.reportedNs || nowNs - startNs < _hangNs) { continue; }
+            slot.reportedNs = startNs;
+            PrototypeLogger::error(
+              "Plugin %s hung in %s for %.0f ms", slot.plugin, slot.protocol, (f64)(nowNs - startNs) / 1000000.0);
+            dumpStack(slot);
+        }
+    }
+}
+
+void
+PrototypePluginWatchdog::dumpStack(Slot& slot)
+{
+    void* frames[PROTOTYPE_PLUGIN_WATCHDOG_MAX_FRAMES];
+    u32   numFrames = 0;
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+    HANDLE thread = (HANDLE)slot.thread;
+#if defined(_M_X64)
+    // nothing that takes a lock runs while the thread is suspended, the unwind works on the copy after it resumed
+    CONTEXT context      = {};
+    context.ContextFlags = CONTEXT_FULL;
+    if (!thread || SuspendThread(thread) == (DWORD)-1) { return; }
+    const bool captured = GetThreadContext(thread, &context) && context.Rsp < slot.stackHigh;
+    if (captured) {
+        gStackCopied = std::min((size_t)(slot.stackHigh - context.Rsp), (size_t)PROTOTYPE_PLUGIN_WATCHDOG_STACK_COPY);
+        memcpy(gStackCopy, (const void*)context.Rsp, gStackCopied);
+    }
+    ResumeThread(thread);
+    if (!captured) { return; }
+
+    // the unwind reads the stack through rsp and rbp, move both into the copy
+    gStackSp            = context.Rsp;
+    const DWORD64 delta = (DWORD64)(uintptr_t)gStackCopy - gStackSp;
+    const DWORD64 low   = (DWORD64)(uintptr_t)gStackCopy;
+    const DWORD64 high  = low + gStackCopied;
+    context.Rsp += delta;
+    if (context.Rbp >= gStackSp && context.Rbp < gStackSp + gStackCopied) { context.Rbp += delta; }
+    while (context.Rip != 0 && context.Rsp >= low && context.Rsp + 8 <= high &&
+           numFrames < PROTOTYPE_PLUGIN_WATCHDOG_MAX_FRAMES) {
+        frames[numFrames++]         = (void*)context.Rip;
+        DWORD64           imageBase = 0;
+        PRUNTIME_FUNCTION function  = RtlLookupFunctionEntry(context.Rip, &imageBase, nullptr);
+        if (!function) {
+            // leaf function, the return address sits on top of the stack
+            context.Rip = *(DWORD64*)context.Rsp;
+            context.Rsp += 8;
+            continue;
+        }
+        void*   handlerData      = nullptr;
+        DWORD64 establisherFrame = 0;
+        RtlVirtualUnwind(
+          UNW_FLAG_NHANDLER, imageBase, context.Rip, function, &context, &handlerData, &establisherFrame, nullptr);
+        if (context.Rbp >= gStackSp && context.Rbp < gStackSp + gStackCopied) { context.Rbp += delta; }
+    }
+#else
+    (void)thread;
+#endif
+#elif defined(PROTOTYPE_PLATFORM_LINUX) || defined(PROTOTYPE_PLATFORM_DARWIN)
+    if (slot.stackHigh == 0) { return; }
+    gStackHigh   = slot.stackHigh;
+    gStackThread = slot.thread;
+    gStackCaptured.store(false, std::memory_order_relaxed);
+    gStackRequested.store(true, std::memory_order_release);
+    if (pthread_kill(slot.thread, SIGUSR2) != 0) {
+        gStackRequested.store(false, std::memory_order_relaxed);
+        return;
+    }
+    for (u32 waited = 0; waited < PROTOTYPE_PLUGIN_WATCHDOG_STACK_WAIT_MS; ++waited) {
+        if (gStackCaptured.load(std::memory_order_acquire)) { break; }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (!gStackCaptured.load(std::memory_order_acquire)) {
+        // a late answer only writes the copy, which isn't read before the next request
+        gStackRequested.store(false, std::memory_order_relaxed);
+        PrototypeLogger::error("    the hung thread didn't answer the stack signal");
+        return;
+    }
+    numFrames = walkFramePointers(frames);
+#endif
+    for (u32 i = 0; i < numFrames; ++i) { logFrame(i, frames[i]); }
+}
@@ -0,0 +1,73 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#pragma once
+
+#include <PrototypeCommon/Definitions.h>
+#include <PrototypeCommon/Types.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+
+#define PROTOTYPE_PLUGIN_WATCHDOG_MAX_SLOTS  64          // threads that ever called into a plugin
+#define PROTOTYPE_PLUGIN_WATCHDOG_MAX_FRAMES 32          // frames dumped per hung call
+#define PROTOTYPE_PLUGIN_WATCHDOG_STACK_COPY (64 * 1024) // bytes of the hung thread stack copied for the unwind
+
+// Watches the plugin calls from a thread of its own and reports every call that didn't return within the hang timeout,
+// the stack of the hung thread is dumped to the log once per call.
+// The hung thread only hands over its registers and a copy of its stack, the unwind and the symbol lookups happen on the
+// watchdog thread afterwards since the hung thread may hold the loader or heap locks they need. Without frame pointers
+// the posix dumps stop after the first frames. On posix the watchdog takes SIGUSR2 over, signals it didn't send go
+// to the previous handler.
+// Threads get a slot on their first plugin call and keep it, the engine threads live as long as the watchdog.
+struct PrototypePluginWatchdog
+{
+    explicit PrototypePluginWatchdog(f64 hangMs);
+    ~PrototypePluginWatchdog();
+
+    // marks the calling thread as inside a plugin call that started at startNs,
+    // both strings must outlive the call, nested calls are reported as the outermost one
+    void enter(const char* plugin, const char* protocol, u64 startNs);
+    void leave();
+
+    // steady clock nanoseconds
+    static u64 now();
+
+  private:
+    struct Slot
+    {
+        std::atomic<bool>               used;
+        std::atomic<u64>                startNs; // 0 while outside of any plugin call
+        const char*                     plugin;
+        const char*                     protocol;
+        u32                             depth;
+        u64                             reportedNs; // startNs of the last reported call, only touched by the watchdog
+        std::thread::native_handle_type thread;
+        uintptr_t                       stackHigh; // end of the thread stack, the copy never reads past it
+    };
+
+    void run();
+    void dumpStack(Slot& slot);
+
+    std::array<Slot, PROTOTYPE_PLUGIN_WATCHDOG_MAX_SLOTS> _slots;
+    std::thread                                           _thread;
+    std::mutex                                            _mutex;
+    std::condition_variable                               _condition;
+    bool                                                  _quit;
+    u64                                                   _hangNs;
+};
@@ -0,0 +1,556 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#include "PrototypeRecorder.h"
+#include "PrototypeScene.h"
+#include "PrototypeWindow.h"
+
+#include <PrototypeCommon/Logger.h>
+
+#include <PrototypeTraitSystem/PrototypeTraitSystem.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string.h>
+
+#define PROTOTYPE_RECORDER_FNV_OFFSET 0xcbf29ce484222325ull
+#define PROTOTYPE_RECORDER_FNV_PRIME  0x100000001b3ull
+#define PROTOTYPE_RECORDER_NO_FRAME   0xffffffffffffffffull
+
+static u64
+prototypeRecorderHash(u64 hash, const void* data, size_t size)
+{
+    const u8* bytes = static_cast<const u8*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= PROTOTYPE_RECORDER_FNV_PRIME;
+    }
+    return hash;
+}
+
+PrototypeRecorder::PrototypeRecorder()
+  : _mode(PrototypeRecorderMode_Off)
+  , _file(nullptr)
+  , _cursor(0)
+  , _frames(0)
+  , _pluginCalls(0)
+  , _pluginDigest(PROTOTYPE_RECORDER_FNV_OFFSET)
+  , _firstDivergentFrame(PROTOTYPE_RECORDER_NO_FRAME)
+  , _recordedHash(0)
+  , _reachedEnd(false)
+  , _measuring(false)
+  , _deltaTime(0.0)
+{
+    _stageMs.fill(0.0);
+}
+
+PrototypeRecorder::~PrototypeRecorder()
+{
+    if (_file) { fclose(_file); }
+}
+
+bool
+PrototypeRecorder::startRecording(const std::string& filepath, const PrototypeScene* scene)
+{
+    _file = fopen(filepath.c_str(), "wb");
+    if (!_file) {
+        PrototypeLogger::warn("Couldn't open <%s> to record the session", filepath.c_str());
+        return false;
+    }
+    _mode      = PrototypeRecorderMode_Record;
+    _filepath  = filepath;
+    _measuring = true;
+
+    const u32          magic   = PROTOTYPE_RECORDER_MAGIC;
+    const u32          version = PROTOTYPE_RECORDER_VERSION;
+    const std::string& name    = scene->name();
+    const u16          length  = (u16)name.size();
+    write(&magic, sizeof(magic));
+    write(&version, sizeof(version));
+    write(&length, sizeof(length));
+    write(name.data(), length);
+    PrototypeLogger::log(__FILE__, __LINE__, ("Recording session to " + filepath).c_str());
+    return true;
+}
+
+bool
+PrototypeRecorder::startReplaying(const std::string& filepath, const PrototypeScene* scene)
+{
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        PrototypeLogger::warn("Couldn't open <%s> to replay the session", filepath.c_str());
+        return false;
+    }
+    _replay.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    _cursor = 0;
+
+    u32 magic   = 0;
+    u32 version = 0;
+    u16 length  = 0;
+    if (!read(&magic, sizeof(magic)) || !read(&version, sizeof(version)) || !read(&length, sizeof(length)) ||
+        magic != PROTOTYPE_RECORDER_MAGIC || version != PROTOTYPE_RECORDER_VERSION) {
+        PrototypeLogger::warn("<%s> is not a session recorded by this version", filepath.c_str());
+        _replay.clear();
+        return false;
+    }
+    std::string name(length, '\0');
+    if (!read(name.data(), length)) {
+        _replay.clear();
+        return false;
+    }
+    if (name != scene->name()) {
+        PrototypeLogger::warn("Session was recorded on scene <%s> but <%s> is loaded", name.c_str(), scene->name().c_str());
+    }
+    _mode      = PrototypeRecorderMode_Replay;
+    _filepath  = filepath;
+    _measuring = true;
+    PrototypeLogger::log(__FILE__, __LINE__, ("Replaying session from " + filepath).c_str());
+    return true;
+}
+
+PrototypeRecorderMode_
+PrototypeRecorder::mode() const
+{
+    return _mode;
+}
+
+bool
+PrototypeRecorder::isRecording() const
+{
+    return _mode == PrototypeRecorderMode_Record;
+}
+
+bool
+PrototypeRecorder::isReplaying() const
+{
+    return _mode == PrototypeRecorderMode_Replay;
+}
+
+bool
+PrototypeRecorder::replayFrame(PrototypeWindow* window, f64& time, f64& deltaTime)
+{
+    if (_reachedEnd) { return false; }
+
+    u8 type = PrototypeRecorderRecord_Count;
+    if (!read(&type, sizeof(type))) {
+        PrototypeLogger::warn(
+          "Session log <%s> is truncated after %llu frames", _filepath.c_str(), (unsigned long long)_frames);
+        _reachedEnd = true;
+        return false;
+    }
+    if (type == PrototypeRecorderRecord_End) {
+        u64 frames = 0;
+        read(&frames, sizeof(frames));
+        read(&_recordedHash, sizeof(_recordedHash));
+        _reachedEnd = true;
+        return false;
+    }
+    if (type != PrototypeRecorderRecord_Frame) {
+        PrototypeLogger::warn("Session log <%s> is corrupted at byte %zu", _filepath.c_str(), _cursor);
+        _reachedEnd = true;
+        return false;
+    }
+
+    u32 pluginCalls  = 0;
+    u64 pluginDigest = 0;
+    read(&time, sizeof(time));
+    read(&deltaTime, sizeof(deltaTime));
+    read(&pluginCalls, sizeof(pluginCalls));
+    read(&pluginDigest, sizeof(pluginDigest));
+    if ((pluginCalls != _pluginCalls || pluginDigest != _pluginDigest) && _firstDivergentFrame == PROTOTYPE_RECORDER_NO_FRAME) {
+        _firstDivergentFrame = _frames;
+        PrototypeLogger::warn("Replay diverged at frame %llu, plugins made %u api calls, %u were recorded",
+                              (unsigned long long)_frames,
+                              _pluginCalls,
+                              pluginCalls);
+    }
+    _pluginCalls  = 0;
+    _pluginDigest = PROTOTYPE_RECORDER_FNV_OFFSET;
+    _deltaTime    = deltaTime;
+    ++_frames;
+
+    // dispatch everything glfw delivered during this frame, up to the next frame record
+    while (_cursor < _replay.size()) {
+        type = _replay[_cursor];
+        if (type == PrototypeRecorderRecord_Frame || type == PrototypeRecorderRecord_End) { break; }
+        ++_cursor;
+        switch (type) {
+            case PrototypeRecorderRecord_Mouse: {
+                u8 data[3] = {};
+                read(data, sizeof(data));
+                window->onMouseFn(data[0], data[1], data[2]);
+            } break;
+            case PrototypeRecorderRecord_MouseMove: {
+                f64 data[2] = {};
+                read(data, sizeof(data));
+                window->onMouseMoveFn(data[0], data[1]);
+            } break;
+            case PrototypeRecorderRecord_MouseScroll: {
+                f64 data[2] = {};
+                read(data, sizeof(data));
+                window->onMouseScrollFn(data[0], data[1]);
+            } break;
+            case PrototypeRecorderRecord_Keyboard: {
+                i32 keys[2] = {};
+                u8  data[2] = {};
+                read(keys, sizeof(keys));
+                read(data, sizeof(data));
+                window->onKeyboardFn(keys[0], keys[1], data[0], data[1]);
+            } break;
+            case PrototypeRecorderRecord_WindowResize: {
+                i32 data[2] = {};
+                read(data, sizeof(data));
+                window->onWindowResizeFn(data[0], data[1]);
+            } break;
+            case PrototypeRecorderRecord_WindowDragDrop: {
+                u16 count = 0;
+                read(&count, sizeof(count));
+                std::vector<std::string> files(count);
+                std::vector<const char*> names(count);
+                for (u16 i = 0; i < count; ++i) {
+                    u16 length = 0;
+                    read(&length, sizeof(length));
+                    files[i].resize(length);
+                    read(files[i].data(), length);
+                    names[i] = files[i].c_str();
+                }
+                window->onWindowDragDropFn((i32)count, names.data());
+            } break;
+            case PrototypeRecorderRecord_WindowIconify: window->onWindowIconifyFn(); break;
+            case PrototypeRecorderRecord_WindowIconifyRestore: window->onWindowIconifyRestoreFn(); break;
+            case PrototypeRecorderRecord_WindowMaximize: window->onWindowMaximizeFn(); break;
+            case PrototypeRecorderRecord_WindowMaximizeRestore: window->onWindowMaximizeRestoreFn(); break;
+            default: {
+                PrototypeLogger::warn("Session log <%s> is corrupted at byte %zu", _filepath.c_str(), _cursor);
+                _cursor = _replay.size();
+            } break;
+        }
+    }
+    return true;
+}
+
+void
+PrototypeRecorder::recordFrame(f64 time, f64 deltaTime)
+{
+    _deltaTime = deltaTime;
+    if (_mode != PrototypeRecorderMode_Record) { return; }
+    const u8 type = PrototypeRecorderRecord_Frame;
+    write(&type, sizeof(type));
+    write(&time, sizeof(time));
+    write(&deltaTime, sizeof(deltaTime));
+    write(&_pluginCalls, sizeof(_pluginCalls));
+    write(&_pluginDigest, sizeof(_pluginDigest));
+    _pluginCalls  = 0;
+    _pluginDigest = PROTOTYPE_RECORDER_FNV_OFFSET;
+    ++_frames;
+}
+
+bool
+PrototypeRecorder::captureMouse(i32 button, i32 action, i32 mods)
+{
+    if (_mode == PrototypeRecorderMode_Replay) { return false; }
+    if (_mode == PrototypeRecorderMode_Record) {
+        const u8 data[4] = { PrototypeRecorderRecord_Mouse, (u8)button, (u8)action, (u8)mods };
+        write(data, sizeof(data));
+    }
+    return true;
+}
+
+bool
+PrototypeRecorder::captureMouseMove(f64 x, f64 y)
+{
+    if (_mode == PrototypeRecorderMode_Replay) { return false; }
+    if (_mode == PrototypeRecorderMode_Record) {
+        const u8  type    = PrototypeRecorderRecord_MouseMove;
+        const f64 data[2] = { x, y };
+        write(&type, sizeof(type));
+        write(data, sizeof(data));
+    }
+    return true;
+}
+
+bool
+PrototypeRecorder::captureMouseScroll(f64 x, f64 y)
+{
+    if (_mode == PrototypeRecorderMode_Replay) { return false; }
+    if (_mode == PrototypeRecorderMode_Record) {
+        const u8  type    = PrototypeRecorderRecord_MouseScroll;
+        const f64 data[2] = { x, y };
+        write(&type, sizeof(type));
+        write(data, sizeof(data));
+    }
+    return true;
+}
+
+bool
+PrototypeRecorder::captureKeyboard(i32 key, i32 scancode, i32 action, i32 mods)
+{
+    if (_mode == PrototypeRecorderMode_Replay) { return false; }
+    if (_mode == PrototypeRecorderMode_Record) {
+        const u8  type    = PrototypeRecorderRecord_Keyboard;
+        const i32 keys[2] = { key, scancode };
+        const u8  data[2] = { (u8)action, (u8)mods };
+        write(&type, sizeof(type));
+        write(keys, sizeof(keys));
+        write(data, sizeof(data));
+    }
+    return true;
+}
+
+bool
+PrototypeRecorder::captureWindowResize(i32 width, i32 height)
+{
+    if (_mode == PrototypeRecorderMode_Replay) { return false; }
+    if (_mode == PrototypeRecorderMode_Record) {
+        const u8  type    = PrototypeRecorderRecord_WindowResize;
+        const i32 data[2] = { width, height };
+        write(&type, sizeof(type));
+        write(data, sizeof(data));
+    }
+    return true;
+}
+
+bool
+PrototypeRecorder::captureWindowDragDrop(i32 numFiles, const char** names)
+{
+    if (_mode == PrototypeRecorderMode_Replay) { return false; }
+    if (_mode == PrototypeRecorderMode_Record) {
+        const u8  type  = PrototypeRecorderRecord_WindowDragDrop;
+        const u16 count = (u16)numFiles;
+        write(&type, sizeof(type));
+        write(&count, sizeof(count));
+        for (u16 i = 0; i < count; ++i) {
+            const u16 length = (u16)strlen(names[i]);
+            write(&length, sizeof(length));
+            write(names[i], length);
+        }
+    }
+    return true;
+}
+
+bool
+PrototypeRecorder::captureWindowIconify(bool status)
+{
+    if (_mode == PrototypeRecorderMode_Replay) { return false; }
+    if (_mode == PrototypeRecorderMode_Record) {
+        const u8 type = status ? PrototypeRecorderRecord_WindowIconify : PrototypeRecorderRecord_WindowIconifyRestore;
+        write(&type, sizeof(type));
+    }
+    return true;
+}
+
+bool
+PrototypeRecorder::captureWindowMaximize(bool status)
+{
+    if (_mode == PrototypeRecorderMode_Replay) { return false; }
+    if (_mode == PrototypeRecorderMode_Record) {
+        const u8 type = status ? PrototypeRecorderRecord_WindowMaximize : PrototypeRecorderRecord_WindowMaximizeRestore;
+        write(&type, sizeof(type));
+    }
+    return true;
+}
+
+void
+PrototypeRecorder::pluginCall(PrototypeRecorderPluginCall_ call, const void* data, size_t size)
+{
+    if (_mode == PrototypeRecorderMode_Off) { return; }
+    const u8 id   = (u8)call;
+    _pluginDigest = prototypeRecorderHash(_pluginDigest, &id, sizeof(id));
+    _pluginDigest = prototypeRecorderHash(_pluginDigest, data, size);
+    ++_pluginCalls;
+}
+
+void
+PrototypeRecorder::setMeasuring(bool status)
+{
+    _measuring = status;
+}
+
+void
+PrototypeRecorder::beginFrame()
+{
+    if (!_measuring) { return; }
+    _stageMs.fill(0.0);
+    beginStage(PrototypeRecorderStage_Frame);
+}
+
+void
+PrototypeRecorder::endFrame()
+{
+    if (!_measuring) { return; }
+    endStage(PrototypeRecorderStage_Frame);
+    std::array<f32, PrototypeRecorderStage_Count + 1> row;
+    row[0] = (f32)(_deltaTime * 1000.0);
+    for (u32 stage = 0; stage < PrototypeRecorderStage_Count; ++stage) { row[stage + 1] = (f32)_stageMs[stage]; }
+    _timings.push_back(row);
+}
+
+void
+PrototypeRecorder::beginStage(PrototypeRecorderStage_ stage)
+{
+    if (!_measuring) { return; }
+    _stageStart[stage] = std::chrono::steady_clock::now();
+}
+
+void
+PrototypeRecorder::endStage(PrototypeRecorderStage_ stage)
+{
+    if (!_measuring) { return; }
+    _stageMs[stage] += std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - _stageStart[stage]).count();
+}
+
+const std::vector<std::array<f32, PrototypeRecorderStage_Count + 1>>&
+PrototypeRecorder::timings() const
+{
+    return _timings;
+}
+
+void
+PrototypeRecorder::finish(const PrototypeScene* scene)
+{
+    if (_mode == PrototypeRecorderMode_Off) { return; }
+
+    const u64 hash = hashScene(scene);
+    if (_mode == PrototypeRecorderMode_Record) {
+        const u8 type = PrototypeRecorderRecord_End;
+        write(&type, sizeof(type));
+        write(&_frames, sizeof(_frames));
+        write(&hash, sizeof(hash));
+        fclose(_file);
+        _file = nullptr;
+        char text[256];
+        snprintf(text,
+                 sizeof(text),
+                 "Recorded %llu frames, state hash %016llx",
+                 (unsigned long long)_frames,
+                 (unsigned long long)hash);
+        PrototypeLogger::log(__FILE__, __LINE__, text);
+    } else {
+        if (!_reachedEnd) { PrototypeLogger::warn("Replay stopped before the end of the session log"); }
+        if (_firstDivergentFrame != PROTOTYPE_RECORDER_NO_FRAME) {
+            PrototypeLogger::error("Replay diverged from the recording at frame %llu", (unsigned long long)_firstDivergentFrame);
+        }
+        if (hash == _recordedHash) {
+            char text[256];
+            snprintf(text,
+                     sizeof(text),
+                     "Replayed %llu frames, state hash %016llx matches",
+                     (unsigned long long)_frames,
+                     (unsigned long long)hash);
+            PrototypeLogger::log(__FILE__, __LINE__, text);
+        } else {
+            PrototypeLogger::error("Replayed %llu frames, state hash %016llx, recorded %016llx",
+                                   (unsigned long long)_frames,
+                                   (unsigned long long)hash,
+                                   (unsigned long long)_recordedHash);
+        }
+    }
+    writeTimings();
+    _mode = PrototypeRecorderMode_Off;
+}
+
+u64
+PrototypeRecorder::hashScene(const PrototypeScene* scene)
+{
+    const auto&                   objectsSet = scene->fetchObjectsByTraits(PrototypeTraitTypeMaskTransform);
+    std::vector<PrototypeObject*> objects(objectsSet.begin(), objectsSet.end());
+    std::sort(objects.begin(), objects.end(), [](PrototypeObject* a, PrototypeObject* b) { return a->id() < b->id(); });
+
+    u64 hash = PROTOTYPE_RECORDER_FNV_OFFSET;
+    for (PrototypeObject* object : objects) {
+        const u32        id    = object->id();
+        const glm::mat4& model = object->getTransformTrait()->model();
+        hash                   = prototypeRecorderHash(hash, &id, sizeof(id));
+        hash                   = prototypeRecorderHash(hash, &model[0][0], sizeof(glm::mat4));
+    }
+    return hash;
+}
+
+const char*
+PrototypeRecorder::stageName(PrototypeRecorderStage_ stage)
+{
+    switch (stage) {
+        case PrototypeRecorderStage_Frame: return "Frame";
+        case PrototypeRecorderStage_Scripts: return "Scripts";
+        case PrototypeRecorderStage_Physics: return "Physics";
+        case PrototypeRecorderStage_Transforms: return "Transforms";
+        case PrototypeRecorderStage_Streaming: return "Streaming";
+        case PrototypeRecorderStage_Record: return "Record";
+        case PrototypeRecorderStage_Submit: return "Submit";
+        case PrototypeRecorderStage_Window: return "Window";
+        default: break;
+    }
+    return "Unknown";
+}
+
+void
+PrototypeRecorder::write(const void* data, size_t size)
+{
+    fwrite(data, 1, size, _file);
+}
+
+bool
+PrototypeRecorder::read(void* data, size_t size)
+{
+    if (_cursor + size > _replay.size()) { return false; }
+    memcpy(data, _replay.data() + _cursor, size);
+    _cursor += size;
+    return true;
+}
+
+void
+PrototypeRecorder::writeTimings()
+{
+    if (_timings.empty()) { return; }
+
+    const std::string csvFilepath = _filepath + (_mode == PrototypeRecorderMode_Record ? ".record.csv" : ".replay.csv");
+    FILE*             csv         = fopen(csvFilepath.c_str(), "w");
+    if (!csv) {
+        PrototypeLogger::warn("Couldn't write stage timings to <%s>", csvFilepath.c_str());
+        return;
+    }
+    fprintf(csv, "frame,deltaTime");
+    for (u32 stage = 0; stage < PrototypeRecorderStage_Count; ++stage) {
+        fprintf(csv, ",%s", stageName((PrototypeRecorderStage_)stage));
+    }
+    fprintf(csv, "\n");
+    for (size_t frame = 0; frame < _timings.size(); ++frame) {
+        fprintf(csv, "%zu", frame);
+        for (f32 ms : _timings[frame]) { fprintf(csv, ",%.4f", ms); }
+        fprintf(csv, "\n");
+    }
+    fclose(csv);
+
+    // per stage mean / p50 / p95 / max over the whole session
+    std::vector<f32> samples(_timings.size());
+    for (u32 stage = 0; stage < PrototypeRecorderStage_Count; ++stage) {
+        f64 sum = 0.0;
+        for (size_t frame = 0; frame < _timings.size(); ++frame) {
+            samples[frame] = _timings[frame][stage + 1];
+            sum += samples[frame];
+        }
+        std::sort(samples.begin(), samples.end());
+        char text[256];
+        snprintf(text,
+                 sizeof(text),
+                 "%-8s mean %.3f ms, p50 %.3f ms, p95 %.3f ms, max %.3f ms",
+                 stageName((PrototypeRecorderStage_)stage),
+                 sum / samples.size(),
+                 samples[samples.size() / 2],
+                 samples[(samples.size() * 95) / 100],
+                 samples.back());
+        PrototypeLogger::log(__FILE__, __LINE__, text);
+    }
+    PrototypeLogger::log(__FILE__, __LINE__, ("Stage timings saved to " + csvFilepath).c_str());
+}
@@ -0,0 +1,198 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+#pragma once
+
+#include "../../include/PrototypeEngine/PrototypeEngineApi.h"
+
+#include <PrototypeCommon/Types.h>
+
+#include <array>
+#include <chrono>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+struct PrototypeWindow;
+struct PrototypeScene;
+
+// bump the version whenever the records, the plugin calls or anything folded into the digests and hashes change meaning,
+// logs of another version are rejected instead of reporting a false divergence
+//   2: object events calls
+//   3: lockstep physics state hash folded into the digest
+//   4: spawn cubes calls
+//   5: spawn batch and release objects calls
+//   6: transform hierarchy world matrices in the scene hash
+//   7: streaming calls
+#define PROTOTYPE_RECORDER_MAGIC   0x43525250 // "PRRC"
+#define PROTOTYPE_RECORDER_VERSION 7
+
+enum PrototypeRecorderMode_
+{
+    PrototypeRecorderMode_Off = 0,
+    PrototypeRecorderMode_Record,
+    PrototypeRecorderMode_Replay,
+
+    PrototypeRecorderMode_Count
+};
+
+// one byte tag in front of every record of the log
+enum PrototypeRecorderRecord_
+{
+    PrototypeRecorderRecord_Frame = 0,      // f64 time, f64 deltaTime, u32 plugin calls, u64 plugin calls digest
+    PrototypeRecorderRecord_Mouse,          // u8 button, u8 action, u8 mods
+    PrototypeRecorderRecord_MouseMove,      // f64 x, f64 y
+    PrototypeRecorderRecord_MouseScroll,    // f64 x, f64 y
+    PrototypeRecorderRecord_Keyboard,       // i32 key, i32 scancode, u8 action, u8 mods
+    PrototypeRecorderRecord_WindowResize,   // i32 width, i32 height
+    PrototypeRecorderRecord_WindowDragDrop, // u16 count, then u16 length + bytes per file
+    PrototypeRecorderRecord_WindowIconify,
+    PrototypeRecorderRecord_WindowIconifyRestore,
+    PrototypeRecorderRecord_WindowMaximize,
+    PrototypeRecorderRecord_WindowMaximizeRestore,
+    PrototypeRecorderRecord_End,            // u64 frames, u64 state hash
+
+    PrototypeRecorderRecord_Count
+};
+
+// plugin api calls folded into the per frame digest
+enum PrototypeRecorderPluginCall_
+{
+    PrototypeRecorderPluginCall_Time = 0,
+    PrototypeRecorderPluginCall_DeltaTime,
+    PrototypeRecorderPluginCall_SpawnCube,
+    PrototypeRecorderPluginCall_SpawnSphere,
+    PrototypeRecorderPluginCall_SpawnConvexMesh,
+    PrototypeRecorderPluginCall_SpawnTriMesh,
+    PrototypeRecorderPluginCall_Raycast,
+    PrototypeRecorderPluginCall_QueryBatch,        // the hit object ids
+    PrototypeRecorderPluginCall_SubmitQueryBatch,  // the queries count, the hits land after the next physics update
+    PrototypeRecorderPluginCall_SceneActivity,     // the activity and rate, the scene name is left out
+    PrototypeRecorderPluginCall_ObjectEvents,      // the object id and its RigidbodyEvents_ bits
+    PrototypeRecorderPluginCall_PhysicsStateHash,  // not a plugin call, the lockstep physics state hash after every update
+    PrototypeRecorderPluginCall_SpawnCubes,        // the cubes count
+    PrototypeRecorderPluginCall_SpawnBatch,        // the objects count
+    PrototypeRecorderPluginCall_ReleaseObjects,    // the objects count
+    PrototypeRecorderPluginCall_StreamingMode,     // the streaming mode, the layer name is left out
+    PrototypeRecorderPluginCall_StreamingResident, // whether the layer was resident
+
+    PrototypeRecorderPluginCall_Count
+};
+
+enum PrototypeRecorderStage_
+{
+    PrototypeRecorderStage_Frame = 0,
+    PrototypeRecorderStage_Scripts,
+    PrototypeRecorderStage_Physics,
+    PrototypeRecorderStage_Transforms, // world matrices of the transform hierarchy
+    PrototypeRecorderStage_Streaming,  // background loaded layers merged into and unloaded from the scene
+    PrototypeRecorderStage_Record,     // renderer, editor and physics record passes
+    PrototypeRecorderStage_Submit,     // renderer update and draw submission
+    PrototypeRecorderStage_Window,
+
+    PrototypeRecorderStage_Count
+};
+
+// Captures everything that feeds a frame from the outside (window/input events, the delta time handed to the
+// systems and the plugin api calls) into a compact binary log, and feeds a log back instead of glfw so a session
+// can be re-run headless and frame for frame. In both modes it keeps per frame stage timings and hashes the scene
+// transforms once the loop ends, replays compare the hash and the plugin calls digests with the recorded ones.
+struct PrototypeRecorder
+{
+    PrototypeRecorder();
+    ~PrototypeRecorder();
+
+    bool startRecording(const std::string& filepath, const PrototypeScene* scene);
+    bool startReplaying(const std::string& filepath, const PrototypeScene* scene);
+
+    PrototypeRecorderMode_ mode() const;
+    bool                   isRecording() const;
+    bool                   isReplaying() const;
+
+    // called by the windows instead of computing the delta time and polling glfw while replaying,
+    // returns false once the log is exhausted
+    bool replayFrame(PrototypeWindow* window, f64& time, f64& deltaTime);
+    // called by the windows right before polling glfw while recording
+    void recordFrame(f64 time, f64 deltaTime);
+
+    // live glfw events go through these before reaching the window, they return false when the event
+    // has to be dropped because a replay is driving the window
+    bool captureMouse(i32 button, i32 action, i32 mods);
+    bool captureMouseMove(f64 x, f64 y);
+    bool captureMouseScroll(f64 x, f64 y);
+    bool captureKeyboard(i32 key, i32 scancode, i32 action, i32 mods);
+    bool captureWindowResize(i32 width, i32 height);
+    bool captureWindowDragDrop(i32 numFiles, const char** names);
+    bool captureWindowIconify(bool status);
+    bool captureWindowMaximize(bool status);
+
+    // folds a plugin api call and its result into the digest of the current frame
+    void pluginCall(PrototypeRecorderPluginCall_ call, const void* data, size_t size);
+
+    // stage timings are kept while recording, replaying or after setMeasuring(true)
+    void setMeasuring(bool status);
+    void beginFrame();
+    void endFrame();
+    void beginStage(PrototypeRecorderStage_ stage);
+    void endStage(PrototypeRecorderStage_ stage);
+
+    // one row per frame, the delta time then every stage, all in milliseconds
+    const std::vector<std::array<f32, PrototypeRecorderStage_Count + 1>>& timings() const;
+
+    // hashes the scene, closes the log and writes the timings next to it
+    void finish(const PrototypeScene* scene);
+
+    static u64         hashScene(const PrototypeScene* scene);
+    static const char* stageName(PrototypeRecorderStage_ stage);
+
+  private:
+    void write(const void* data, size_t size);
+    bool read(void* data, size_t size);
+    void writeTimings();
+
+    PrototypeRecorderMode_                                                          _mode;
+    std::string                                                                     _filepath;
+    FILE*                                                                           _file;
+    std::vector<u8>                                                                 _replay;
+    size_t                                                                          _cursor;
+    u64                                                                             _frames;
+    u32                                                                             _pluginCalls;
+    u64                                                                             _pluginDigest;
+    u64                                                                             _firstDivergentFrame;
+    u64                                                                             _recordedHash;
+    bool                                                                            _reachedEnd;
+    bool                                                                            _measuring;
+    f64                                                                             _deltaTime;
+    std::array<f64, PrototypeRecorderStage_Count>                                   _stageMs;
+    std::array<std::chrono::steady_clock::time_point, PrototypeRecorderStage_Count> _stageStart;
+    std::vector<std::array<f32, PrototypeRecorderStage_Count + 1>>                  _timings; // delta time then stages, in ms
+};
+
+struct PrototypeRecorderStageScope
+{
+    PrototypeRecorderStageScope(PrototypeRecorder* recorder, PrototypeRecorderStage_ stage)
+      : _recorder(recorder)
+      , _stage(stage)
+    {
+        _recorder->beginStage(_stage);
+    }
+    ~PrototypeRecorderStageScope() { _recorder->endStage(_stage); }
+
+    PrototypeRecorderStageScope(const PrototypeRecorderStageScope&) = delete;
+    PrototypeRecorderStageScope& operator=(const PrototypeRecorderStageScope&) = delete;
+
+  private:
+    PrototypeRecorder*      _recorder;
+    PrototypeRecorderStage_ _stage;
+};
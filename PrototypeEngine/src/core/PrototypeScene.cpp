@@ -18,12 +18,16 @@
 #include "PrototypeFrameBuffer.h"
 #include "PrototypeMaterial.h"
 #include "PrototypeMeshBuffer.h"
+#include "PrototypeSceneJournal.h"
 #include "PrototypeSceneLayer.h"
 #include "PrototypeSceneLoader.h"
 #include "PrototypeSceneNode.h"
+#include "PrototypeSceneParser.h"
+#include "PrototypeSceneStreamer.h"
 #include "PrototypeShaderBuffer.h"
 #include "PrototypeStaticInitializer.h"
 #include "PrototypeTextureBuffer.h"
+#include "PrototypeTransformHierarchy.h"
 #include "PrototypeUI.h"
 
 #include "PrototypeEngine.h"
@@ -43,7 +47,12 @@
 PrototypeScene::PrototypeScene(const std::string name)
   : _id(++PrototypeStaticInitializer::_sceneUUID)
   , _name(name)
-{}
+{
+    // scenes start from the layers of the settings and can only stop more of them from interacting
+    if (PrototypeEngineInternalApplication::collisionLayers) {
+        _collisionLayers = *PrototypeEngineInternalApplication::collisionLayers;
+    }
+}
 
 PrototypeScene::~PrototypeScene()
 {
@@ -180,6 +189,9 @@ PrototypeScene::clearSelectedNodes()
 void
 PrototypeScene::addNodeToTraitFilters(PrototypeSceneNode* node, u64 traitMask)
 {
+    if (PrototypeEngineInternalApplication::sceneJournal) {
+        PrototypeEngineInternalApplication::sceneJournal->markDirty(node, traitMask);
+    }
     if (!PrototypeEngineInternalApplication::scene) return;
     for (auto& pair : _nodeFilters) { pair.second->onAddSceneNodeTraits(node, traitMask); }
 }
@@ -187,6 +199,9 @@ PrototypeScene::addNodeToTraitFilters(PrototypeSceneNode* node, u64 traitMask)
 void
 PrototypeScene::removeNodeFromTraitFilters(PrototypeSceneNode* node, u64 traitMask)
 {
+    if (PrototypeEngineInternalApplication::sceneJournal) {
+        PrototypeEngineInternalApplication::sceneJournal->markDirty(node, traitMask);
+    }
     if (!PrototypeEngineInternalApplication::scene) return;
     for (auto& pair : _nodeFilters) { pair.second->onRemoveSceneNodeTraits(node, traitMask); }
 }
@@ -194,6 +209,9 @@ PrototypeScene::removeNodeFromTraitFilters(PrototypeSceneNode* node, u64 traitMa
 void
 PrototypeScene::onAddLayer(PrototypeSceneLayer* layer)
 {
+    if (PrototypeEngineInternalApplication::sceneJournal) {
+        PrototypeEngineInternalApplication::sceneJournal->onAddLayer(this, layer);
+    }
     for (auto pair2 : layer->nodes()) {
         auto node = pair2.second;
         onAddNode(node);
@@ -207,11 +225,20 @@ PrototypeScene::onRemoveLayer(PrototypeSceneLayer* layer)
         auto node = pair2.second;
         onRemoveNode(node);
     }
+    if (PrototypeEngineInternalApplication::sceneJournal) {
+        PrototypeEngineInternalApplication::sceneJournal->onRemoveLayer(this, layer);
+    }
 }
 
 void
 PrototypeScene::onAddNode(PrototypeSceneNode* node)
 {
+    if (PrototypeEngineInternalApplication::transformHierarchy) {
+        PrototypeEngineInternalApplication::transformHierarchy->addNode(this, node);
+    }
+    if (PrototypeEngineInternalApplication::sceneJournal) {
+        PrototypeEngineInternalApplication::sceneJournal->onAddNode(node);
+    }
     auto optObject = node->object();
     if (optObject.has_value()) {
         auto obj = optObject.value();
@@ -222,6 +249,12 @@ PrototypeScene::onAddNode(PrototypeSceneNode* node)
 void
 PrototypeScene::onRemoveNode(PrototypeSceneNode* node, bool dispatchRecordingPass)
 {
+    if (PrototypeEngineInternalApplication::transformHierarchy) {
+        PrototypeEngineInternalApplication::transformHierarchy->removeNode(this, node);
+    }
+    if (PrototypeEngineInternalApplication::sceneJournal) {
+        PrototypeEngineInternalApplication::sceneJournal->onRemoveNode(this, node);
+    }
     for (const auto& childNodePair : node->nodes()) {
         for (auto& pair : _nodeFilters) { pair.second->onRemoveSceneNode(childNodePair.second); }
         onRemoveNode(childNodePair.second, false);
@@ -295,6 +328,12 @@ PrototypeScene::selectedNodes() const
     return _selectedNodes;
 }
 
+const PrototypeCollisionLayers&
+PrototypeScene::collisionLayers() const
+{
+    return _collisionLayers;
+}
+
 void
 PrototypeScene::to_json(nlohmann::json& j, const PrototypeScene& scene)
 {
@@ -303,7 +342,11 @@ PrototypeScene::to_json(nlohmann::json& j, const PrototypeScene& scene)
     std::vector<nlohmann::json> jlayers;
     for (auto pair : scene._layers) {
         nlohmann::json jlayer;
-        PrototypeSceneLayer::to_json(jlayer, *pair.second);
+        // streamed nodes stay in their own file, the layer only keeps where to stream them from
+        if (!PrototypeEngineInternalApplication::sceneStreamer ||
+            !PrototypeEngineInternalApplication::sceneStreamer->layerToJson(pair.second, jlayer)) {
+            PrototypeSceneLayer::to_json(jlayer, *pair.second);
+        }
         jlayers.push_back(jlayer);
     }
     j["layers"] = jlayers;
@@ -314,10 +357,35 @@ PrototypeScene::from_json(const nlohmann::json& j)
 {
     if (j.is_null()) { return {}; }
 
+    const char* field_layers = "layers";
+
+    // staged the way the parser stages them so both paths build the layers the same way
+    std::vector<PrototypeSceneParsedLayer> layers;
+    if (j.contains(field_layers)) {
+        for (const auto& jlayer : j.at(field_layers)) {
+            if (jlayer.is_null()) continue;
+            layers.emplace_back();
+            PrototypeSceneParser::stageLayer(jlayer, layers.back());
+        }
+    }
+    return from_json(j, layers);
+}
+
+std::optional<PrototypeScene*>
+PrototypeScene::from_json(const nlohmann::json& j, const std::vector<PrototypeSceneParsedLayer>& layers)
+{
+    if (j.is_null()) { return {}; }
+
     const char* field_name    = "name";
     const char* field_layers  = "layers";
     const char* field_filters = "filters";
     const char* field_bundles = "bundles";
+    const char* field_ignored = "ignoredCollisionLayers";
+
+    const char* field_streaming_path   = "path";
+    const char* field_streaming_center = "center";
+    const char* field_streaming_radius = "radius";
+    const char* field_streaming_bytes  = "bytes";
 
     if (!j.contains(field_name)) {
         PrototypeLogger::warn("Scene doesn't have a \"%s\"", field_name);
@@ -340,7 +408,10 @@ PrototypeScene::from_json(const nlohmann::json& j)
 
     auto scene = PrototypeEngineInternalApplication::database->allocateScene(sceneName);
 
-    for (auto jfilter : j.at(field_filters)) {
+    // the physics scene picks the matrix up when it gets created on the first record pass of this scene
+    if (j.contains(field_ignored)) { scene->_collisionLayers.ignorePairs(j.at(field_ignored)); }
+
+    for (const auto& jfilter : j.at(field_filters)) {
         MASK_TYPE traitMask = 0;
         auto      traits    = jfilter.at("traits").get<std::vector<std::string>>();
         for (const auto& traitName : traits) {
@@ -358,21 +429,32 @@ PrototypeScene::from_json(const nlohmann::json& j)
     //     PrototypeEngineInternalApplication::database->deallocateSceneLayer(blueprintsLayer);
     // }
 
-    for (auto jlayer : j.at(field_layers)) {
-        if (jlayer.is_null()) continue;
-        auto optLayer = PrototypeSceneLayer::from_json(jlayer, scene);
+    for (const auto& parsed : layers) {
+        auto optLayer = PrototypeSceneLayer::from_json(parsed, scene);
         if (optLayer.has_value()) {
             auto layer = optLayer.value();
             layer->setParentScene(scene);
             if (scene->addLayer(layer)) {
                 PrototypeEngineInternalApplication::database->sceneLayers[scene].insert({ layer->name(), layer });
+                // the nodes of a streamed layer get loaded in the background once the camera comes close enough
+                if (!parsed.streaming.is_null() && PrototypeEngineInternalApplication::sceneStreamer) {
+                    const auto&     jstreaming = parsed.streaming;
+                    const glm::vec3 center     = jstreaming.value(field_streaming_center, glm::vec3(0.0f, 0.0f, 0.0f));
+                    PrototypeEngineInternalApplication::sceneStreamer->declare(
+                      scene,
+                      layer,
+                      PROTOTYPE_SCENE_PATH("") + jstreaming.at(field_streaming_path).get<std::string>(),
+                      center,
+                      jstreaming.at(field_streaming_radius).get<f32>(),
+                      jstreaming.value(field_streaming_bytes, (u64)0));
+                }
             } else {
                 PrototypeEngineInternalApplication::database->deallocateSceneLayer(layer);
             }
         }
     }
 
-    for (auto jbundle : j.at(field_bundles)) {
+    for (const auto& jbundle : j.at(field_bundles)) {
         if (jbundle.is_null()) continue;
         std::string  filename = jbundle["path"].get<std::string>();
         BundleConfig config   = BundleConfig();
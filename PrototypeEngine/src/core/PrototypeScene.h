@@ -18,6 +18,7 @@
 
 #include <PrototypeTraitSystem/PrototypeTraitSystemTypes.h>
 
+#include "PrototypeCollisionLayers.h"
 #include "PrototypeSceneFilter.h"
 
 #include <memory>
@@ -25,11 +26,13 @@
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <nlohmann/json.hpp>
 
 struct PrototypeSceneNode;
 struct PrototypeSceneLayer;
+struct PrototypeSceneParsedLayer;
 struct PrototypeObject;
 
 struct PrototypeScene
@@ -57,9 +60,13 @@ struct PrototypeScene
     const std::optional<PrototypeSceneLayer*>            layerByName(const std::string name) const;
     const std::unordered_map<u32, PrototypeSceneLayer*>& layers() const;
     const std::unordered_set<PrototypeSceneNode*>&       selectedNodes() const;
+    const PrototypeCollisionLayers&                      collisionLayers() const;
 
     static void                           to_json(nlohmann::json& j, const PrototypeScene& scene);
     static std::optional<PrototypeScene*> from_json(const nlohmann::json& j);
+    // j holds everything but the layers, which come staged by PrototypeSceneParser
+    static std::optional<PrototypeScene*> from_json(const nlohmann::json&                         j,
+                                                    const std::vector<PrototypeSceneParsedLayer>& layers);
 
   private:
     friend struct PrototypeSceneLayer;
@@ -81,4 +88,5 @@ struct PrototypeScene
     std::unordered_map<std::string, u32>                 _remap_layers;
     std::unordered_map<MASK_TYPE, PrototypeSceneFilter*> _nodeFilters;
     std::unordered_set<PrototypeSceneNode*>              _selectedNodes;
+    PrototypeCollisionLayers                             _collisionLayers;
 };
@@ -0,0 +1,457 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#include "PrototypeSceneJournal.h"
+
+#include "PrototypeEngine.h"
+#include "PrototypeScene.h"
+#include "PrototypeSceneLayer.h"
+#include "PrototypeSceneNode.h"
+#include "PrototypeSceneStreamer.h"
+#include "PrototypeThreadpool.h"
+
+#include <PrototypeCommon/IO.h>
+#include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/MemoryTracker.h>
+#include <PrototypeCommon/Tracer.h>
+
+#include <PrototypeTraitSystem/PrototypeTraitSystem.h>
+
+#include <algorithm>
+#include <chrono>
+
+static const u64 PrototypeSceneJournalCompactionRecords = 4096;
+
+PrototypeSceneJournal::PrototypeSceneJournal()
+  : _compactionThreshold(PrototypeSceneJournalCompactionRecords)
+  , _stats({})
+  , _writes(0)
+{}
+
+PrototypeSceneJournal::~PrototypeSceneJournal()
+{
+    flush();
+    // the scene files are read on their own by the next session
+    for (const auto& pair : _scenes) {
+        if (pair.second.records == 0) { continue; }
+        compact(pair.second.scenePath, pair.second.journalPath);
+        ++_stats.compactions;
+    }
+}
+
+void
+PrototypeSceneJournal::markDirty(PrototypeSceneNode* node, MASK_TYPE traitMask)
+{
+    // physics workers mark every node they move each step, only the first change of a node since its last save locks
+    if ((node->_changes.load(std::memory_order_relaxed) & traitMask) == traitMask) { return; }
+    if (node->_changes.fetch_or(traitMask, std::memory_order_relaxed) != 0) { return; }
+    std::lock_guard<std::mutex> lock(_dirtyMutex);
+    _dirty[node->id()] = node;
+}
+
+void
+PrototypeSceneJournal::onAddNode(PrototypeSceneNode* node)
+{
+    std::vector<PrototypeSceneNode*> stack = { node };
+    while (!stack.empty()) {
+        PrototypeSceneNode* next = stack.back();
+        stack.pop_back();
+        markDirty(next, PrototypeSceneJournalMaskAll);
+        for (const auto& pair : next->_nodes) { stack.push_back(pair.second); }
+    }
+}
+
+void
+PrototypeSceneJournal::onRemoveNode(PrototypeScene* scene, PrototypeSceneNode* node)
+{
+    forget(node);
+    SceneState& state = _scenes[scene];
+    // before the first save there is no scene file to remove it from, the first save writes the scene as it is then
+    if (!state.hasBase || streams(node)) { return; }
+    nlohmann::json j;
+    j["op"] = "remove";
+    j["id"] = node->id();
+    state.pending.push_back(std::move(j));
+}
+
+void
+PrototypeSceneJournal::onAddLayer(PrototypeScene* scene, PrototypeSceneLayer* layer)
+{
+    SceneState& state = _scenes[scene];
+    if (!state.hasBase) { return; }
+    nlohmann::json j;
+    j["op"]   = "layer";
+    j["id"]   = layer->id();
+    j["name"] = layer->name();
+    state.pending.push_back(std::move(j));
+}
+
+void
+PrototypeSceneJournal::onRemoveLayer(PrototypeScene* scene, PrototypeSceneLayer* layer)
+{
+    SceneState& state = _scenes[scene];
+    if (!state.hasBase) { return; }
+    nlohmann::json j;
+    j["op"] = "removeLayer";
+    j["id"] = layer->id();
+    state.pending.push_back(std::move(j));
+}
+
+void
+PrototypeSceneJournal::forget(PrototypeSceneNode* node)
+{
+    if (node->_changes.load(std::memory_order_relaxed) == 0) { return; }
+    std::lock_guard<std::mutex> lock(_dirtyMutex);
+    node->_changes.store(0, std::memory_order_relaxed);
+    _dirty.erase(node->id());
+}
+
+void
+PrototypeSceneJournal::save(PrototypeScene* scene)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    const auto start = std::chrono::steady_clock::now();
+
+    SceneState& state  = _scenes[scene];
+    auto        write  = std::make_shared<Write>();
+    write->scenePath   = scenePath(scene->name());
+    write->journalPath = journalPath(scene->name());
+    write->compact     = false;
+    write->records     = std::move(state.pending);
+    state.scenePath    = write->scenePath;
+    state.journalPath  = write->journalPath;
+    state.pending.clear();
+    {
+        // nodes of other scenes stay dirty until their own scene gets saved
+        std::lock_guard<std::mutex> lock(_dirtyMutex);
+        for (auto it = _dirty.begin(); it != _dirty.end();) {
+            PrototypeSceneNode*  node  = it->second;
+            PrototypeSceneLayer* layer = node->absoluteLayer();
+            if (!layer || layer->parentScene() != scene) {
+                ++it;
+                continue;
+            }
+            const MASK_TYPE mask = node->_changes.exchange(0, std::memory_order_relaxed);
+            it                   = _dirty.erase(it);
+            // streamed nodes stay in their own files
+            if (!state.hasBase || streams(node)) { continue; }
+            write->records.emplace_back();
+            nodeRecord(node, mask, write->records.back());
+        }
+    }
+
+    if (!state.hasBase) {
+        // the only save that costs the main thread the whole scene, every later one refers to its node ids
+        write->records.clear();
+        PrototypeScene::to_json(write->full, *scene);
+        state.hasBase = true;
+        state.records = 0;
+        ++_stats.fullSaves;
+    } else {
+        state.records += write->records.size();
+        if (state.records >= _compactionThreshold) {
+            write->compact = true;
+            state.records  = 0;
+            ++_stats.compactions;
+        }
+    }
+    ++_stats.saves;
+    _stats.lastRecords = write->records.size();
+    _stats.records += write->records.size();
+    _stats.snapshotMs = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (write->full.is_null() && write->records.empty()) { return; }
+
+    {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _queue.push_back(std::move(write));
+    }
+    _writes.fetch_add(1, std::memory_order_relaxed);
+    PrototypeEngineInternalApplication::threadpool->submit(
+      [this]() {
+          PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scene)
+          // every task writes the oldest queued save, so saves reach the disk in order even when tasks overtake
+          std::lock_guard<std::mutex> writeLock(_writeMutex);
+          std::shared_ptr<Write>      next;
+          {
+              std::lock_guard<std::mutex> lock(_queueMutex);
+              next = std::move(_queue.front());
+              _queue.pop_front();
+          }
+          store(*next);
+          _writes.fetch_sub(1, std::memory_order_release);
+      },
+      PrototypeThreadpoolPriority_Low);
+}
+
+void
+PrototypeSceneJournal::flush()
+{
+    if (_writes.load(std::memory_order_acquire) == 0 || !PrototypeEngineInternalApplication::threadpool) { return; }
+    PrototypeEngineInternalApplication::threadpool->helpUntil(_writes, PrototypeThreadpoolPriority_Low);
+}
+
+void
+PrototypeSceneJournal::setCompactionThreshold(u64 records)
+{
+    _compactionThreshold = records;
+}
+
+const PrototypeSceneJournalStats&
+PrototypeSceneJournal::stats() const
+{
+    return _stats;
+}
+
+void PROTOTYPE_DYNAMIC_FN_CALL
+PrototypeSceneJournal::onTraitChange(PrototypeObject* object, MASK_TYPE traitMask)
+{
+    if (!PrototypeEngineInternalApplication::sceneJournal) { return; }
+    auto* node = static_cast<PrototypeSceneNode*>(object->parentNode());
+    if (node) { PrototypeEngineInternalApplication::sceneJournal->markDirty(node, traitMask); }
+}
+
+void
+PrototypeSceneJournal::nodeRecord(PrototypeSceneNode* node, MASK_TYPE mask, nlohmann::json& j)
+{
+    PrototypeSceneLayer* layer = node->absoluteLayer();
+    j["op"]                    = "node";
+    j["id"]                    = node->id();
+    j["name"]                  = node->name();
+    j["layer"]                 = layer->id();
+    j["layerName"]             = layer->name();
+    j["parent"]                = node->parentNode() ? nlohmann::json(node->parentNode()->id()) : nlohmann::json(nullptr);
+
+    const auto optObject = node->object();
+    if (!optObject.has_value()) { return; }
+    PrototypeObject* object = optObject.value();
+
+    // only the traits that changed, a trait that got removed is written as null
+    nlohmann::json jcomponents = nlohmann::json::object();
+    for (MASK_TYPE index = 0; index < PrototypeTraitTypeCount; ++index) {
+        const MASK_TYPE traitMask = (MASK_TYPE)1 << index;
+        if ((mask & traitMask) == 0) { continue; }
+        nlohmann::json& jcomponent = jcomponents[PrototypeTraitTypeAbsoluteStringArray[index]];
+        if (!object->has(traitMask)) { continue; }
+        switch (index) {
+            case PrototypeTraitTypeIndexCamera: Camera::to_json(jcomponent, *object->getCameraTrait()); break;
+            case PrototypeTraitTypeIndexCollider: Collider::to_json(jcomponent, *object->getColliderTrait()); break;
+            case PrototypeTraitTypeIndexMeshRenderer: MeshRenderer::to_json(jcomponent, *object->getMeshRendererTrait()); break;
+            case PrototypeTraitTypeIndexRigidbody: Rigidbody::to_json(jcomponent, *object->getRigidbodyTrait()); break;
+            case PrototypeTraitTypeIndexScript: Script::to_json(jcomponent, *object->getScriptTrait()); break;
+            case PrototypeTraitTypeIndexTransform: Transform::to_json(jcomponent, *object->getTransformTrait()); break;
+            case PrototypeTraitTypeIndexVehicleChasis:
+                VehicleChasis::to_json(jcomponent, *object->getVehicleChasisTrait());
+                break;
+            default: break;
+        }
+    }
+    if (!jcomponents.empty()) { j["components"] = std::move(jcomponents); }
+}
+
+void
+PrototypeSceneJournal::store(const Write& write)
+{
+    if (!write.full.is_null()) {
+        // records of an older scene file refer to node ids of another session
+        std::string text = write.full.dump();
+        std::string none;
+        PrototypeIo::createDirectory(PROTOTYPE_LOG_PATH(""));
+        PrototypeIo::writeFileBlock(write.scenePath.c_str(), text);
+        PrototypeIo::writeFileBlock(write.journalPath.c_str(), none);
+        return;
+    }
+    std::string text;
+    for (const nlohmann::json& record : write.records) {
+        text += record.dump();
+        text += '\n';
+    }
+    PrototypeIo::appendFileBlock(write.journalPath.c_str(), text);
+    if (write.compact) { compact(write.scenePath, write.journalPath); }
+}
+
+void
+PrototypeSceneJournal::compact(const std::string& scenePath, const std::string& journalPath)
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    std::string text;
+    if (!PrototypeIo::readFileBlock(scenePath.c_str(), text)) { return; }
+    nlohmann::json jscene = nlohmann::json::parse(text, nullptr, false);
+    if (jscene.is_discarded() || !jscene.contains("layers")) {
+        PrototypeLogger::warn("Can't compact the journal of %s, the scene file doesn't parse", scenePath.c_str());
+        return;
+    }
+
+    // the scene file gets flattened into nodes that know their layer and parent, records then apply to them by id
+    struct Node
+    {
+        u32            layer;
+        i64            parent; // -1 for the nodes right under their layer
+        nlohmann::json value;  // the node without its children
+    };
+    std::vector<u32>                             layerOrder;
+    std::unordered_map<u32, nlohmann::json>      layers;
+    std::vector<u32>                             nodeOrder;
+    std::unordered_map<u32, Node>                nodes;
+    std::vector<std::pair<nlohmann::json*, i64>> stack;
+    for (nlohmann::json& jlayer : jscene.at("layers")) {
+        const u32 layerId = jlayer.at("id").get<u32>();
+        if (jlayer.contains("nodes")) {
+            for (nlohmann::json& jnode : jlayer.at("nodes")) { stack.push_back({ &jnode, -1 }); }
+        }
+        while (!stack.empty()) {
+            auto [jnode, parent] = stack.back();
+            stack.pop_back();
+            const u32 id = jnode->at("id").get<u32>();
+            Node      node{ layerId, parent, nlohmann::json::object() };
+            for (auto& item : jnode->items()) {
+                if (item.key() == "nodes") {
+                    for (nlohmann::json& jchild : item.value()) { stack.push_back({ &jchild, id }); }
+                } else {
+                    node.value[item.key()] = item.value();
+                }
+            }
+            nodeOrder.push_back(id);
+            nodes.insert({ id, std::move(node) });
+        }
+        jlayer.erase("nodes");
+        layerOrder.push_back(layerId);
+        layers.insert({ layerId, std::move(jlayer) });
+    }
+
+    std::vector<std::string> lines;
+    PrototypeIo::readFileLines(journalPath.c_str(), lines);
+    for (const std::string& line : lines) {
+        // a torn last line of a write that got interrupted doesn't parse and gets dropped
+        nlohmann::json record = nlohmann::json::parse(line, nullptr, false);
+        if (record.is_discarded() || !record.contains("op") || !record.contains("id")) { continue; }
+        const std::string op = record.at("op").get<std::string>();
+        const u32         id = record.at("id").get<u32>();
+        if (op == "remove") {
+            nodes.erase(id);
+        } else if (op == "removeLayer") {
+            layers.erase(id);
+        } else if (op == "layer") {
+            if (layers.find(id) == layers.end()) {
+                layerOrder.push_back(id);
+                layers.insert({ id, { { "id", id }, { "name", record.at("name") } } });
+            }
+        } else if (op == "node") {
+            const u32 layerId = record.at("layer").get<u32>();
+            if (layers.find(layerId) == layers.end()) {
+                layerOrder.push_back(layerId);
+                layers.insert({ layerId, { { "id", layerId }, { "name", record.at("layerName") } } });
+            }
+            auto it = nodes.find(id);
+            if (it == nodes.end()) {
+                nodeOrder.push_back(id);
+                it = nodes.insert({ id, { layerId, -1, { { "id", id }, { "components", nlohmann::json::array() } } } }).first;
+            }
+            Node& node         = it->second;
+            node.layer         = layerId;
+            node.parent        = record.at("parent").is_null() ? -1 : (i64)record.at("parent").get<u32>();
+            node.value["name"] = record.at("name");
+            if (!record.contains("components")) { continue; }
+            nlohmann::json& jcomponents = node.value["components"];
+            for (auto& item : record.at("components").items()) {
+                auto found = std::find_if(jcomponents.begin(), jcomponents.end(), [&item](const nlohmann::json& jcomponent) {
+                    return jcomponent.value("name", "") == item.key();
+                });
+                if (item.value().is_null()) {
+                    if (found != jcomponents.end()) { jcomponents.erase(found); }
+                } else if (found != jcomponents.end()) {
+                    *found = item.value();
+                } else {
+                    jcomponents.push_back(item.value());
+                }
+            }
+        }
+    }
+
+    // nested back children first, nodes whose layer or parent went away go with them
+    std::unordered_map<i64, std::vector<u32>> children;
+    std::unordered_map<u32, std::vector<u32>> roots;
+    for (u32 id : nodeOrder) {
+        auto it = nodes.find(id);
+        if (it == nodes.end()) { continue; }
+        if (it->second.parent < 0) {
+            roots[it->second.layer].push_back(id);
+        } else {
+            children[it->second.parent].push_back(id);
+        }
+    }
+    std::vector<u32> preorder;
+    std::vector<u32> pending;
+    for (const auto& pair : roots) {
+        if (layers.find(pair.first) != layers.end()) { pending.insert(pending.end(), pair.second.begin(), pair.second.end()); }
+    }
+    while (!pending.empty()) {
+        const u32 id = pending.back();
+        pending.pop_back();
+        preorder.push_back(id);
+        auto it = children.find(id);
+        if (it != children.end()) { pending.insert(pending.end(), it->second.begin(), it->second.end()); }
+    }
+    for (auto it = preorder.rbegin(); it != preorder.rend(); ++it) {
+        nlohmann::json jnodes = nlohmann::json::array();
+        auto           found  = children.find(*it);
+        if (found != children.end()) {
+            for (u32 child : found->second) { jnodes.push_back(std::move(nodes.at(child).value)); }
+        }
+        nodes.at(*it).value["nodes"] = std::move(jnodes);
+    }
+    nlohmann::json jlayers = nlohmann::json::array();
+    for (u32 layerId : layerOrder) {
+        auto it = layers.find(layerId);
+        if (it == layers.end()) { continue; }
+        nlohmann::json& jlayer = it->second;
+        // streamed layers keep where their nodes stream from instead of nodes
+        if (!jlayer.contains("streaming")) {
+            nlohmann::json jnodes = nlohmann::json::array();
+            auto           found  = roots.find(layerId);
+            if (found != roots.end()) {
+                for (u32 id : found->second) { jnodes.push_back(std::move(nodes.at(id).value)); }
+            }
+            jlayer["nodes"] = std::move(jnodes);
+        }
+        jlayers.push_back(std::move(jlayer));
+        layers.erase(it);
+    }
+    jscene["layers"] = std::move(jlayers);
+
+    text = jscene.dump();
+    std::string none;
+    PrototypeIo::writeFileBlock(scenePath.c_str(), text);
+    PrototypeIo::writeFileBlock(journalPath.c_str(), none);
+}
+
+std::string
+PrototypeSceneJournal::scenePath(const std::string& sceneName)
+{
+    return PROTOTYPE_LOG_PATH("scenes.") + sceneName + ".json";
+}
+
+std::string
+PrototypeSceneJournal::journalPath(const std::string& sceneName)
+{
+    return PROTOTYPE_LOG_PATH("scenes.") + sceneName + ".journal";
+}
+
+bool
+PrototypeSceneJournal::streams(PrototypeSceneNode* node) const
+{
+    PrototypeSceneLayer* layer = node->absoluteLayer();
+    return layer && PrototypeEngineInternalApplication::sceneStreamer &&
+           PrototypeEngineInternalApplication::sceneStreamer->streams(layer);
+}
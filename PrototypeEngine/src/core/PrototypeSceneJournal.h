@@ -0,0 +1,129 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#pragma once
+
+#include <PrototypeCommon/Definitions.h>
+#include <PrototypeCommon/Types.h>
+
+#include <PrototypeTraitSystem/PrototypeTraitSystemTypes.h>
+
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct PrototypeObject;
+struct PrototypeScene;
+struct PrototypeSceneLayer;
+struct PrototypeSceneNode;
+
+// changes of the node itself (name, parent), the trait masks take the low bits
+static const MASK_TYPE PrototypeSceneJournalMaskNode = (MASK_TYPE)1 << 63;
+static const MASK_TYPE PrototypeSceneJournalMaskAll  = ~(MASK_TYPE)0;
+
+struct PrototypeSceneJournalStats
+{
+    u64 saves;       // saves since startup, the full ones included
+    u64 fullSaves;   // saves that wrote the whole scene, the first save of every scene is one
+    u64 records;     // records appended to the journals since startup
+    u64 compactions; // journals folded back into their scene file
+    u64 lastRecords; // records of the last save
+    f64 snapshotMs;  // time the last save spent on the main thread
+};
+
+// Saves scenes incrementally. Nodes get marked dirty per trait whenever a saved field changes, a save then only turns
+// the dirty nodes of the scene into records on the main thread and a worker appends them to the journal next to the
+// scene file, so what a save costs the main thread follows the size of the edit rather than the size of the scene.
+// Records refer to nodes by id, so the first save of a scene in a session writes the whole scene, and a worker folds
+// the journal back into the scene file once it holds enough records. What is left in the journals gets folded back when
+// the journal goes away, and the scene loader folds a journal a crashed session left behind back into its saved scene
+// file before the first save of the new session writes over it.
+// Turning the dirty traits into json still happens on the main thread, the traits may change again right after the save.
+struct PrototypeSceneJournal
+{
+    PrototypeSceneJournal();
+    // waits for the writes in flight and folds every journal back into its scene file
+    ~PrototypeSceneJournal();
+
+    // any thread, traitMask holds the traits that changed and PrototypeSceneJournalMaskNode for the node itself
+    void markDirty(PrototypeSceneNode* node, MASK_TYPE traitMask);
+    // nodes added or moved get written whole, their children with them
+    void onAddNode(PrototypeSceneNode* node);
+    void onRemoveNode(PrototypeScene* scene, PrototypeSceneNode* node);
+    void onAddLayer(PrototypeScene* scene, PrototypeSceneLayer* layer);
+    void onRemoveLayer(PrototypeScene* scene, PrototypeSceneLayer* layer);
+    // drops the changes of a node that goes away
+    void forget(PrototypeSceneNode* node);
+
+    // snapshots the changes of the scene and hands them to a worker to write
+    void save(PrototypeScene* scene);
+    // returns once every save handed to the workers is on disk
+    void flush();
+    // records a journal may hold before it gets folded back into its scene file
+    void setCompactionThreshold(u64 records);
+
+    const PrototypeSceneJournalStats& stats() const;
+
+    // set as the trait system change callback
+    static void PROTOTYPE_DYNAMIC_FN_CALL onTraitChange(PrototypeObject* object, MASK_TYPE traitMask);
+    // folds the records of the journal into the scene file and empties the journal
+    static void compact(const std::string& scenePath, const std::string& journalPath);
+    // where the saves of a scene go, the journal sits next to the scene file
+    static std::string scenePath(const std::string& sceneName);
+    static std::string journalPath(const std::string& sceneName);
+
+  private:
+    // filled on the main thread, written by a worker
+    struct Write
+    {
+        std::string                 scenePath;
+        std::string                 journalPath;
+        nlohmann::json              full; // the whole scene, null for a delta
+        std::vector<nlohmann::json> records;
+        bool                        compact;
+    };
+
+    struct SceneState
+    {
+        bool                        hasBase;     // the scene file got written this session, node ids in records match it
+        u64                         records;     // records appended since the scene file got written
+        std::vector<nlohmann::json> pending;     // layer and removal records waiting for the next save
+        std::string                 scenePath;   // set by the first save
+        std::string                 journalPath; // set by the first save
+    };
+
+    static void nodeRecord(PrototypeSceneNode* node, MASK_TYPE mask, nlohmann::json& j);
+    static void store(const Write& write);
+
+    bool streams(PrototypeSceneNode* node) const;
+
+    std::mutex                                            _dirtyMutex;
+    std::unordered_map<u32, PrototypeSceneNode*>          _dirty; // nodes with changes not saved yet
+    std::unordered_map<const PrototypeScene*, SceneState> _scenes;
+    u64                                                   _compactionThreshold;
+    PrototypeSceneJournalStats                            _stats;
+
+    // saves get written in the order they were taken, whichever worker picks them up
+    std::mutex                         _queueMutex;
+    std::mutex                         _writeMutex;
+    std::deque<std::shared_ptr<Write>> _queue;
+    std::atomic<size_t>                _writes;
+};
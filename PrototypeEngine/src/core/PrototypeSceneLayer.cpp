@@ -19,12 +19,16 @@
 #include "PrototypeScene.h"
 #include "PrototypeSceneLayer.h"
 #include "PrototypeSceneNode.h"
+#include "PrototypeSceneParser.h"
 #include "PrototypeStaticInitializer.h"
+#include "PrototypeTransformHierarchy.h"
 #include "PrototypeUI.h"
 
 #include <PrototypeCommon/Definitions.h>
 #include <PrototypeCommon/Logger.h>
 
+#include <PrototypeTraitSystem/PrototypeTraitSystem.h>
+
 PrototypeSceneLayer::PrototypeSceneLayer(const std::string name)
   : _id(++PrototypeStaticInitializer::_sceneLayerUUID)
   , _mask(PrototypeSceneMaskVisible | PrototypeSceneMaskMatching | PrototypeSceneMaskPartialMatching)
@@ -217,6 +221,9 @@ bool
 PrototypeSceneLayer::onMoveNode(PrototypeSceneNode* node, PrototypeSceneNode* newParent, PrototypeSceneLayer* oldParent)
 {
     if (newParent->nodesByName(node->name()).has_value()) return false;
+    if (PrototypeEngineInternalApplication::transformHierarchy) {
+        PrototypeEngineInternalApplication::transformHierarchy->moveNode(_parentScene, node);
+    }
     node->setParentLayer(nullptr);
     node->setParentNode(newParent);
     newParent->addNode(node);
@@ -227,6 +234,9 @@ bool
 PrototypeSceneLayer::onMoveNode(PrototypeSceneNode* node, PrototypeSceneLayer* newParent, PrototypeSceneNode* oldParent)
 {
     if (newParent->nodesByName(node->name()).has_value()) return false;
+    if (PrototypeEngineInternalApplication::transformHierarchy) {
+        PrototypeEngineInternalApplication::transformHierarchy->moveNode(_parentScene, node);
+    }
     node->setParentLayer(newParent);
     node->setParentNode(nullptr);
     newParent->addNode(node);
@@ -243,6 +253,9 @@ bool
 PrototypeSceneLayer::onMoveNode(PrototypeSceneNode* node, PrototypeSceneLayer* newParent, PrototypeSceneLayer* oldParent)
 {
     if (newParent->nodesByName(node->name()).has_value()) return false;
+    if (PrototypeEngineInternalApplication::transformHierarchy) {
+        PrototypeEngineInternalApplication::transformHierarchy->moveNode(_parentScene, node);
+    }
     node->setParentLayer(newParent);
     node->setParentNode(nullptr);
     newParent->addNode(node);
@@ -370,32 +383,62 @@ PrototypeSceneLayer::from_json(const nlohmann::json& j, PrototypeScene* scene)
 {
     if (j.is_null()) { return {}; }
 
-    const char* field_name  = "name";
-    const char* field_nodes = "nodes";
-
-    if (!j.contains(field_name)) { return {}; }
-
-    const std::string layerName = j.at(field_name).get<std::string>();
-
-    auto layer = PrototypeEngineInternalApplication::database->allocateSceneLayer(layerName);
-
-    // nodes
-    if (j.contains(field_nodes)) {
-        for (auto jnode : j.at(field_nodes)) {
-            if (jnode.is_null()) continue;
-            auto optNode = PrototypeSceneNode::from_json(jnode, scene);
-            if (optNode.has_value()) {
-                auto node = optNode.value();
-                node->setParentLayer(layer);
-                node->setParentNode(nullptr);
-                if (layer->addNode(node)) {
-                    PrototypeEngineInternalApplication::database->sceneNodes[scene].insert({ node->name(), node });
-                } else {
-                    PrototypeEngineInternalApplication::database->deallocateSceneNode(node);
-                }
-            }
-        }
+    PrototypeSceneParsedLayer parsed;
+    PrototypeSceneParser::stageLayer(j, parsed);
+    return from_json(parsed, scene);
+}
+
+std::optional<PrototypeSceneLayer*>
+PrototypeSceneLayer::from_json(const PrototypeSceneParsedLayer& parsed, PrototypeScene* scene)
+{
+    if (!parsed.named) { return {}; }
+
+    auto layer = PrototypeEngineInternalApplication::database->allocateSceneLayer(parsed.name);
+
+    // parents come before their children, a node whose parent didn't make it is dropped along with it
+    std::vector<PrototypeSceneNode*> nodes(parsed.nodes.size(), nullptr);
+    for (size_t n = 0; n < parsed.nodes.size(); ++n) {
+        const PrototypeSceneParsedNode& parsedNode = parsed.nodes[n];
+        PrototypeSceneNode*             parentNode = parsedNode.parent < 0 ? nullptr : nodes[parsedNode.parent];
+        if (parsedNode.parent >= 0 && !parentNode) continue;
+        nodes[n] = layer->addParsedNode(parsedNode, parentNode, scene);
     }
 
     return { layer };
+}
+
+PrototypeSceneNode*
+PrototypeSceneLayer::addParsedNode(const PrototypeSceneParsedNode& parsedNode,
+                                   PrototypeSceneNode*             parentNode,
+                                   PrototypeScene*                 scene)
+{
+    if (!parsedNode.named) {
+        PrototypeLogger::warn("Scene node doesn't have name");
+        return nullptr;
+    }
+
+    auto       node      = PrototypeEngineInternalApplication::database->allocateSceneNode(parsedNode.name);
+    const auto optObject = node->object();
+    if (optObject.has_value()) {
+        PrototypeObject* object = optObject.value();
+        object->setParentNode(static_cast<void*>(node));
+        for (const auto& jcomponent : parsedNode.components) { PrototypeObject::from_json(jcomponent, *object); }
+    }
+
+    bool added = false;
+    if (parentNode) {
+        node->setParentLayer(nullptr);
+        node->setParentNode(parentNode);
+        added = parentNode->addNode(node);
+    } else {
+        node->setParentLayer(this);
+        node->setParentNode(nullptr);
+        added = addNode(node);
+    }
+    if (!added) {
+        PrototypeEngineInternalApplication::database->deallocateSceneNode(node);
+        return nullptr;
+    }
+    PrototypeEngineInternalApplication::database->sceneNodes[scene].insert({ node->name(), node });
+    return node;
 }
\ No newline at end of file
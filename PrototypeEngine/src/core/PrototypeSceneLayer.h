@@ -27,6 +27,8 @@
 
 struct PrototypeScene;
 struct PrototypeSceneNode;
+struct PrototypeSceneParsedLayer;
+struct PrototypeSceneParsedNode;
 
 struct PrototypeSceneLayer
 {
@@ -66,6 +68,12 @@ struct PrototypeSceneLayer
 
     static void                                to_json(nlohmann::json& j, const PrototypeSceneLayer& layer);
     static std::optional<PrototypeSceneLayer*> from_json(const nlohmann::json& j, PrototypeScene* scene);
+    static std::optional<PrototypeSceneLayer*> from_json(const PrototypeSceneParsedLayer& parsed, PrototypeScene* scene);
+
+    // instantiates a staged node under parentNode, or the layer when null, returns null if the node got dropped
+    PrototypeSceneNode* addParsedNode(const PrototypeSceneParsedNode& parsedNode,
+                                      PrototypeSceneNode*             parentNode,
+                                      PrototypeScene*                 scene);
 
   private:
     friend struct PrototypeScene;
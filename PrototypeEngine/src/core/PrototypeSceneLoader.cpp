@@ -21,6 +21,7 @@
 
 #include <PrototypeCommon/IO.h>
 #include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/MemoryTracker.h>
 
 #include <PrototypeTraitSystem/PrototypeTraitSystem.h>
 
@@ -31,12 +32,16 @@
 #include "PrototypeScene.h"
 #include "PrototypeSceneLayer.h"
 #include "PrototypeSceneNode.h"
+#include "PrototypeSceneJournal.h"
+#include "PrototypeSceneParser.h"
+#include "PrototypeThreadpool.h"
 
 #include "PrototypePreloadedAssets.h"
 
+#include <atomic>
 #include <filesystem>
 #include <fstream>
-#include <thread>
+#include <unordered_map>
 
 #include <assimp/Importer.hpp>
 #include <assimp/cimport.h>
@@ -76,19 +81,30 @@ struct hash<PrototypeMeshVertex>
 };
 }
 
+// parses the entries of a resources array one at a time on the thread that loads them
+static void
+loadResources(PrototypeJsonSlice array, void (*loadFn)(const nlohmann::json& j))
+{
+    if (PrototypeSceneParser::isNull(array)) { return; }
+    const bool ok = PrototypeSceneParser::elements(array, [loadFn](PrototypeJsonSlice element) {
+        nlohmann::json j;
+        if (!PrototypeSceneParser::parseValue(element, j)) { return false; }
+        loadFn(j);
+        return true;
+    });
+    if (!ok) { PrototypeLogger::warn("Resources hold a malformed entry, the ones after it are skipped"); }
+}
+
 void
 PrototypeSceneLoader::loadResourcesFromFile(const char* filepath)
 {
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scene)
+    std::string text;
+    if (!PrototypeIo::readFileBlock(filepath, text)) {
         PrototypeLogger::warn("Couldn't load resources from <%s>", filepath);
         return;
     }
-    nlohmann::json j;
-    file >> j;
-    file.close();
-
-    if (j.is_null()) { return; }
+    if (PrototypeSceneParser::isNull(PrototypeSceneParser::slice(text))) { return; }
 
     const char* field_meshes       = "meshes";
     const char* field_shaders      = "shaders";
@@ -96,70 +112,104 @@ PrototypeSceneLoader::loadResourcesFromFile(const char* filepath)
     const char* field_materials    = "materials";
     const char* field_framebuffers = "framebuffers";
 
-    if (!j.contains(field_meshes)) {
+    // the arrays stay unparsed until the thread loading them gets to their entries, so the loaders parse in parallel
+    std::unordered_map<std::string, PrototypeJsonSlice> fields;
+    auto                                                collect = [&fields](const std::string& key, PrototypeJsonSlice value) {
+        fields[key] = value;
+        return true;
+    };
+    if (!PrototypeSceneParser::members(PrototypeSceneParser::slice(text), collect)) {
+        PrototypeLogger::warn("Couldn't parse resources from <%s>", filepath);
+        return;
+    }
+
+    if (!fields.count(field_meshes)) {
         PrototypeLogger::warn("Resources don't have \"%s\"", field_meshes);
         return;
     }
-    if (!j.contains(field_shaders)) {
+    if (!fields.count(field_shaders)) {
         PrototypeLogger::warn("Resources don't have \"%s\"", field_shaders);
         return;
     }
-    if (!j.contains(field_textures)) {
+    if (!fields.count(field_textures)) {
         PrototypeLogger::warn("Resources don't have \"%s\"", field_textures);
         return;
     }
-    if (!j.contains(field_materials)) {
+    if (!fields.count(field_materials)) {
         PrototypeLogger::warn("Resources don't have \"%s\"", field_materials);
         return;
     }
-    if (!j.contains(field_framebuffers)) {
+    if (!fields.count(field_framebuffers)) {
         PrototypeLogger::warn("Resources don't have \"%s\"", field_framebuffers);
         return;
     }
 
-    std::thread texturesThread([&]() {
-        for (auto jtexture : j.at(field_textures)) { PrototypeTextureBuffer::from_json(jtexture); }
-    });
-
-    std::thread shadersThread([&]() {
-        for (auto jshader : j.at(field_shaders)) { PrototypeShaderBuffer::from_json(jshader); }
-    });
-
-    std::thread meshesThread([&]() {
-        PrototypeMeshBuffer::from_json(colored_triangle_2d);
-        PrototypeMeshBuffer::from_json(colored_plane_2d);
-        PrototypeMeshBuffer::from_json(colored_textured_plane_2d);
-        PrototypeMeshBuffer::from_json(plane);
-        PrototypeMeshBuffer::from_json(cube);
-        for (auto jmesh : j.at(field_meshes)) { PrototypeMeshBuffer::from_json(jmesh); }
-    });
-
-    meshesThread.join();
-    shadersThread.join();
-    texturesThread.join();
-
-    for (auto jmaterial : j.at(field_materials)) { PrototypeMaterial::from_json(jmaterial); }
-
-    for (auto jframebuffer : j.at(field_framebuffers)) { PrototypeFrameBuffer::from_json(jframebuffer); }
+    // background work on the engine threadpool, the calling thread takes one of the three loaders while it waits
+    PrototypeThreadpool* threadpool = PrototypeEngineInternalApplication::threadpool;
+    std::atomic<size_t>  pending(3);
+
+    threadpool->submit(
+      [&]() {
+          loadResources(fields.at(field_textures), PrototypeTextureBuffer::from_json);
+          pending.fetch_sub(1, std::memory_order_release);
+      },
+      PrototypeThreadpoolPriority_Low);
+
+    threadpool->submit(
+      [&]() {
+          loadResources(fields.at(field_shaders), PrototypeShaderBuffer::from_json);
+          pending.fetch_sub(1, std::memory_order_release);
+      },
+      PrototypeThreadpoolPriority_Low);
+
+    threadpool->submit(
+      [&]() {
+          PrototypeMeshBuffer::from_json(colored_triangle_2d);
+          PrototypeMeshBuffer::from_json(colored_plane_2d);
+          PrototypeMeshBuffer::from_json(colored_textured_plane_2d);
+          PrototypeMeshBuffer::from_json(plane);
+          PrototypeMeshBuffer::from_json(cube);
+          loadResources(fields.at(field_meshes), PrototypeMeshBuffer::from_json);
+          pending.fetch_sub(1, std::memory_order_release);
+      },
+      PrototypeThreadpoolPriority_Low);
+
+    threadpool->helpUntil(pending, PrototypeThreadpoolPriority_Low);
+
+    loadResources(fields.at(field_materials), PrototypeMaterial::from_json);
+
+    loadResources(fields.at(field_framebuffers), PrototypeFrameBuffer::from_json);
 }
 
 void
 PrototypeSceneLoader::loadPrototypeSceneFromFile(const char* filepath)
 {
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scene)
+    std::string text;
+    if (!PrototypeIo::readFileBlock(filepath, text)) {
         PrototypeLogger::warn("Couldn't load scene from <%s>", filepath);
         return;
     }
-    nlohmann::json j;
-    file >> j;
-    file.close();
+    if (PrototypeSceneParser::isNull(PrototypeSceneParser::slice(text))) { return; }
 
-    if (j.is_null()) { return; }
+    // the layers get parsed on the workers straight into staged nodes, the scene never exists as one json value
+    nlohmann::json                         j;
+    std::vector<PrototypeSceneParsedLayer> layers;
+    if (!PrototypeSceneParser::parseScene(text, j, layers)) {
+        PrototypeLogger::warn("Couldn't parse scene from <%s>", filepath);
+        return;
+    }
 
-    auto optScene = PrototypeScene::from_json(j);
+    auto optScene = PrototypeScene::from_json(j, layers);
     if (optScene.has_value()) {
         auto scene = optScene.value();
+        // saves a crashed session didn't get to fold back are still in the journal, the first save of this session
+        // would write over it
+        const std::string journalPath = PrototypeSceneJournal::journalPath(scene->name());
+        std::error_code   error;
+        if (std::filesystem::file_size(journalPath, error) > 0 && !error) {
+            PrototypeSceneJournal::compact(PrototypeSceneJournal::scenePath(scene->name()), journalPath);
+        }
         PrototypeEngineInternalApplication::database->scenes.insert({ scene->name(), scene });
     }
 }
@@ -903,6 +953,7 @@ assimpProcessNode(const BundleConfig      config,
 void
 PrototypeSceneLoader::assimpImportScene(BundleConfig config, PrototypeScene* scene)
 {
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scene)
     std::string filenameFullpath = std::string(PROTOTYPE_BUNDLE_PATH("")).append(config.filepath);
 
     i32              defaultFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs;
@@ -16,8 +16,10 @@
 #include "PrototypeDatabase.h"
 #include "PrototypeEngine.h"
 #include "PrototypeScene.h"
+#include "PrototypeSceneJournal.h"
 #include "PrototypeSceneLayer.h"
 #include "PrototypeStaticInitializer.h"
+#include "PrototypeTransformHierarchy.h"
 #include <PrototypeCommon/Definitions.h>
 #include <PrototypeCommon/Logger.h>
 #include <PrototypeTraitSystem/PrototypeTraitSystem.h>
@@ -29,6 +31,7 @@ PrototypeSceneNode::PrototypeSceneNode(std::string name)
   , _object(nullptr)
   , _parentLayer(nullptr)
   , _parentNode(nullptr)
+  , _changes(0)
 {
     allocateObject();
 }
@@ -182,7 +185,12 @@ PrototypeSceneNode::removeNodeByName(const std::string name)
 void
 PrototypeSceneNode::renameNode(const std::string name)
 {
-    if (onRenameNode(this, name)) { _name = name; }
+    if (onRenameNode(this, name)) {
+        _name = name;
+        if (PrototypeEngineInternalApplication::sceneJournal) {
+            PrototypeEngineInternalApplication::sceneJournal->markDirty(this, PrototypeSceneJournalMaskNode);
+        }
+    }
 }
 
 void
@@ -261,6 +269,10 @@ bool
 PrototypeSceneNode::onMoveNode(PrototypeSceneNode* node, PrototypeSceneNode* newParent, PrototypeSceneNode* oldParent)
 {
     if (newParent->nodesByName(node->name()).has_value()) return false;
+    PrototypeSceneLayer* layer = absoluteLayer();
+    if (layer && PrototypeEngineInternalApplication::transformHierarchy) {
+        PrototypeEngineInternalApplication::transformHierarchy->moveNode(layer->parentScene(), node);
+    }
     node->setParentLayer(nullptr);
     node->setParentNode(newParent);
     newParent->addNode(node);
@@ -271,6 +283,10 @@ bool
 PrototypeSceneNode::onMoveNode(PrototypeSceneNode* node, PrototypeSceneLayer* newParent, PrototypeSceneNode* oldParent)
 {
     if (newParent->nodesByName(node->name()).has_value()) return false;
+    PrototypeSceneLayer* layer = absoluteLayer();
+    if (layer && PrototypeEngineInternalApplication::transformHierarchy) {
+        PrototypeEngineInternalApplication::transformHierarchy->moveNode(layer->parentScene(), node);
+    }
     node->setParentLayer(newParent);
     node->setParentNode(nullptr);
     newParent->addNode(node);
@@ -466,7 +482,7 @@ PrototypeSceneNode::from_json(const nlohmann::json& j, PrototypeScene* scene)
         if (optObject.has_value()) {
             PrototypeObject* object = optObject.value();
             object->setParentNode(static_cast<void*>(node));
-            for (auto jcomponent : j.at(field_components)) {
+            for (const auto& jcomponent : j.at(field_components)) {
                 if (jcomponent.is_null()) continue;
                 if (jcomponent.contains(field_name)) { PrototypeObject::from_json(jcomponent, *object); }
             }
@@ -474,7 +490,7 @@ PrototypeSceneNode::from_json(const nlohmann::json& j, PrototypeScene* scene)
     }
     // load child nodes
     if (j.contains(field_nodes)) {
-        for (auto jnode : j.at(field_nodes)) {
+        for (const auto& jnode : j.at(field_nodes)) {
             if (jnode.is_null()) continue;
             auto optChildNode = PrototypeSceneNode::from_json(jnode, scene);
             if (optChildNode.has_value()) {
@@ -20,6 +20,7 @@
 
 #include <PrototypeTraitSystem/PrototypeTraitSystemTypes.h>
 
+#include <atomic>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -88,6 +89,7 @@ struct PrototypeSceneNode
     void onDeselectNode(PrototypeSceneNode* node);
 
     friend struct PrototypeSceneLayer;
+    friend struct PrototypeSceneJournal;
     friend PrototypeObject* shotcutCreateCloneObjectToLayer(const std::string&   nodeName,
                                                             MASK_TYPE            traitMask,
                                                             PrototypeSceneLayer* parentLayer);
@@ -107,4 +109,5 @@ struct PrototypeSceneNode
     std::unordered_map<std::string, u32>         _remap_nodes;
     PrototypeSceneLayer*                         _parentLayer;
     PrototypeSceneNode*                          _parentNode;
+    std::atomic<MASK_TYPE>                       _changes; // what changed since the last save, see PrototypeSceneJournal
 };
@@ -0,0 +1,541 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#include "PrototypeSceneParser.h"
+
+#include "PrototypeEngine.h"
+#include "PrototypeThreadpool.h"
+
+#include <PrototypeCommon/MemoryTracker.h>
+
+#include <atomic>
+#include <charconv>
+#include <cstring>
+
+#define PROTOTYPE_SCENE_PARSER_CHUNK 256 // root nodes a worker stages at once, big layers get spread over every worker
+
+// root nodes of a layer staged by one worker, the parent indices are relative to the chunk until they get merged
+struct PrototypeSceneParserChunk
+{
+    size_t                                layer;
+    std::vector<PrototypeJsonSlice>       roots;
+    std::vector<PrototypeSceneParsedNode> nodes;
+};
+
+// Everything below walks the text with a cursor: a function gets where a value starts and returns what follows it, or
+// nullptr if the value isn't well formed, so every byte of a node gets read once.
+
+static const char*
+skipWhitespace(const char* p, const char* end)
+{
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) { ++p; }
+    return p;
+}
+
+static const char*
+skipString(const char* p, const char* end)
+{
+    for (++p; p < end; ++p) {
+        if (*p == '\\') {
+            ++p;
+        } else if (*p == '"') {
+            return p + 1;
+        }
+    }
+    return nullptr;
+}
+
+// only brackets and quotes get looked at, what gets skipped that way is never checked
+static const char*
+skipValue(const char* p, const char* end)
+{
+    if (p >= end) return nullptr;
+    if (*p == '"') return skipString(p, end);
+    if (*p == '{' || *p == '[') {
+        size_t depth = 0;
+        while (p < end) {
+            const char c = *p;
+            if (c == '"') {
+                p = skipString(p, end);
+                if (!p) return nullptr;
+                continue;
+            }
+            if (c == '{' || c == '[') {
+                ++depth;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) return p + 1;
+            }
+            ++p;
+        }
+        return nullptr;
+    }
+    const char* start = p;
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t') { ++p; }
+    return p > start ? p : nullptr;
+}
+
+static bool
+isNullAt(const char* p, const char* end)
+{
+    return end - p >= 4 && std::memcmp(p, "null", 4) == 0;
+}
+
+static const char*
+matchLiteral(const char* p, const char* end, const char* literal)
+{
+    const size_t length = std::strlen(literal);
+    return (size_t)(end - p) >= length && std::memcmp(p, literal, length) == 0 ? p + length : nullptr;
+}
+
+static const char*
+parseStringAt(const char* p, const char* end, std::string& text)
+{
+    if (p >= end || *p != '"') return nullptr;
+    const char* begin = p + 1;
+    for (const char* q = begin; q < end; ++q) {
+        const char c = *q;
+        if (c == '"') {
+            text.assign(begin, (size_t)(q - begin));
+            return q + 1;
+        }
+        if ((unsigned char)c < 0x20) return nullptr;
+        if (c == '\\') {
+            // names hardly ever hold escapes, the strings that do get decoded by nlohmann
+            const char* stringEnd = skipString(p, end);
+            if (!stringEnd) return nullptr;
+            const nlohmann::json j = nlohmann::json::parse(p, stringEnd, nullptr, false);
+            if (!j.is_string()) return nullptr;
+            text = j.get<std::string>();
+            return stringEnd;
+        }
+    }
+    return nullptr;
+}
+
+// integers keep the signedness nlohmann gives them so the from_json functions read the same types,
+// from_chars ignores the locale so a decimal comma setting can't break the scene files
+static const char*
+parseNumberAt(const char* p, const char* end, nlohmann::json& j)
+{
+    const char* literalEnd = p;
+    bool        floating   = false;
+    for (; literalEnd < end; ++literalEnd) {
+        const char c = *literalEnd;
+        if (c == '.' || c == 'e' || c == 'E' || c == '+') {
+            floating = true;
+        } else if ((c < '0' || c > '9') && c != '-') {
+            break;
+        }
+    }
+    if (literalEnd == p) return nullptr;
+
+    if (!floating) {
+        if (*p == '-') {
+            i64        value  = 0;
+            const auto result = std::from_chars(p, literalEnd, value);
+            if (result.ec == std::errc() && result.ptr == literalEnd) {
+                j = value;
+                return literalEnd;
+            }
+        } else {
+            u64        value  = 0;
+            const auto result = std::from_chars(p, literalEnd, value);
+            if (result.ec == std::errc() && result.ptr == literalEnd) {
+                j = value;
+                return literalEnd;
+            }
+        }
+    }
+    // integers out of range end up as floating point numbers too
+    f64        value  = 0.0;
+    const auto result = std::from_chars(p, literalEnd, value);
+    if (result.ec != std::errc() || result.ptr != literalEnd) return nullptr;
+    j = value;
+    return literalEnd;
+}
+
+template<typename Fn>
+static const char*
+walkMembers(const char* p, const char* end, const Fn& fn)
+{
+    if (p >= end || *p != '{') return nullptr;
+    p = skipWhitespace(p + 1, end);
+    if (p < end && *p == '}') return p + 1;
+    std::string key;
+    for (;;) {
+        p = parseStringAt(p, end, key);
+        if (!p) return nullptr;
+        p = skipWhitespace(p, end);
+        if (p >= end || *p != ':') return nullptr;
+        p = fn(key, skipWhitespace(p + 1, end));
+        if (!p) return nullptr;
+        p = skipWhitespace(p, end);
+        if (p < end && *p == '}') return p + 1;
+        if (p >= end || *p != ',') return nullptr;
+        p = skipWhitespace(p + 1, end);
+    }
+}
+
+template<typename Fn>
+static const char*
+walkElements(const char* p, const char* end, const Fn& fn)
+{
+    if (p >= end || *p != '[') return nullptr;
+    p = skipWhitespace(p + 1, end);
+    if (p < end && *p == ']') return p + 1;
+    for (;;) {
+        p = fn(p);
+        if (!p) return nullptr;
+        p = skipWhitespace(p, end);
+        if (p < end && *p == ']') return p + 1;
+        if (p >= end || *p != ',') return nullptr;
+        p = skipWhitespace(p + 1, end);
+    }
+}
+
+// builds the value straight from the text, without the intermediate tokens a full parse goes through
+static const char*
+parseValueAt(const char* p, const char* end, nlohmann::json& j)
+{
+    if (p >= end) return nullptr;
+    switch (*p) {
+        case '{': {
+            j = nlohmann::json::object();
+            return walkMembers(
+              p, end, [&j, end](const std::string& key, const char* value) { return parseValueAt(value, end, j[key]); });
+        }
+        case '[': {
+            j = nlohmann::json::array();
+            return walkElements(p, end, [&j, end](const char* value) {
+                j.emplace_back();
+                return parseValueAt(value, end, j.back());
+            });
+        }
+        case '"': {
+            std::string text;
+            p = parseStringAt(p, end, text);
+            j = std::move(text);
+            return p;
+        }
+        case 't': j = true; return matchLiteral(p, end, "true");
+        case 'f': j = false; return matchLiteral(p, end, "false");
+        case 'n': j = nullptr; return matchLiteral(p, end, "null");
+        default: return parseNumberAt(p, end, j);
+    }
+}
+
+// stages the node and then its children depth first, so parents always come before their children,
+// the nesting is followed with an explicit stack since hierarchies can get deeper than the call stack
+static const char*
+parseNodeAt(const char* p, const char* end, i32 parent, std::vector<PrototypeSceneParsedNode>& nodes)
+{
+    enum Step
+    {
+        Step_Node,        // p is at the opening brace of a node
+        Step_Member,      // p is at the key of a member of the current node
+        Step_NextMember,  // p follows a member of the current node
+        Step_Element,     // p is at an element of the children of the innermost open node
+        Step_NextElement, // p follows an element of the children of the innermost open node
+    };
+    std::vector<i32> open; // nodes whose children are being staged, innermost last
+    std::string      key;
+    i32              index = -1;
+    Step             step  = Step_Node;
+    // nodes may reallocate while the children get staged, so a node is only ever reached through its index
+    for (;;) {
+        switch (step) {
+            case Step_Node: {
+                if (p >= end || *p != '{') return nullptr;
+                index = (i32)nodes.size();
+                nodes.emplace_back();
+                nodes[index].parent = open.empty() ? parent : open.back();
+                nodes[index].named  = false;
+                p                   = skipWhitespace(p + 1, end);
+                step                = p < end && *p == '}' ? Step_NextMember : Step_Member;
+            } break;
+
+            case Step_Member: {
+                p = parseStringAt(p, end, key);
+                if (!p) return nullptr;
+                p = skipWhitespace(p, end);
+                if (p >= end || *p != ':') return nullptr;
+                p    = skipWhitespace(p + 1, end);
+                step = Step_NextMember;
+                if (key == "name") {
+                    nodes[index].named = true;
+                    p                  = parseStringAt(p, end, nodes[index].name);
+                } else if (p < end && *p == '[' && key == "components") {
+                    p = walkElements(p, end, [&nodes, index, end](const char* element) {
+                        nlohmann::json jcomponent;
+                        const char*    next = parseValueAt(element, end, jcomponent);
+                        if (next && jcomponent.contains("name")) { nodes[index].components.push_back(std::move(jcomponent)); }
+                        return next;
+                    });
+                } else if (p < end && *p == '[' && key == "nodes") {
+                    p = skipWhitespace(p + 1, end);
+                    if (p < end && *p == ']') {
+                        ++p;
+                    } else {
+                        open.push_back(index);
+                        step = Step_Element;
+                    }
+                } else {
+                    p = skipValue(p, end);
+                }
+                if (!p) return nullptr;
+            } break;
+
+            case Step_NextMember: {
+                p = skipWhitespace(p, end);
+                if (p < end && *p == ',') {
+                    p    = skipWhitespace(p + 1, end);
+                    step = Step_Member;
+                    break;
+                }
+                if (p >= end || *p != '}') return nullptr;
+                ++p;
+                if (open.empty()) return p;
+                step = Step_NextElement;
+            } break;
+
+            case Step_Element: {
+                if (isNullAt(p, end)) {
+                    p += 4;
+                    step = Step_NextElement;
+                } else {
+                    step = Step_Node;
+                }
+            } break;
+
+            case Step_NextElement: {
+                p = skipWhitespace(p, end);
+                if (p < end && *p == ',') {
+                    p    = skipWhitespace(p + 1, end);
+                    step = Step_Element;
+                    break;
+                }
+                if (p >= end || *p != ']') return nullptr;
+                // the children are done, the members of their parent go on
+                ++p;
+                index = open.back();
+                open.pop_back();
+                step = Step_NextMember;
+            } break;
+        }
+    }
+}
+
+// stages the small fields of the layer and hands its root nodes out to chunks without parsing them
+static const char*
+walkLayerAt(const char*                             p,
+            const char*                             end,
+            size_t                                  l,
+            PrototypeSceneParsedLayer&              layer,
+            std::vector<PrototypeSceneParserChunk>& chunks)
+{
+    layer.named = false;
+    return walkMembers(p, end, [&, end](const std::string& key, const char* value) -> const char* {
+        if (key == "name") {
+            layer.named = true;
+            return parseStringAt(value, end, layer.name);
+        }
+        if (key == "streaming") return parseValueAt(value, end, layer.streaming);
+        if (key != "nodes" || value >= end || *value != '[') return skipValue(value, end);
+        return walkElements(value, end, [&, end](const char* element) -> const char* {
+            const char* next = skipValue(element, end);
+            if (!next || isNullAt(element, end)) return next;
+            if (chunks.empty() || chunks.back().layer != l || chunks.back().roots.size() == PROTOTYPE_SCENE_PARSER_CHUNK) {
+                chunks.emplace_back();
+                chunks.back().layer = l;
+            }
+            chunks.back().roots.push_back({ element, next });
+            return next;
+        });
+    });
+}
+
+static void
+stageNode(const nlohmann::json& j, i32 parent, std::vector<PrototypeSceneParsedNode>& nodes)
+{
+    // depth first with an explicit stack, the children get pushed back to front so they are staged in file order
+    std::vector<std::pair<const nlohmann::json*, i32>> stack = { { &j, parent } };
+    while (!stack.empty()) {
+        const nlohmann::json& jnode      = *stack.back().first;
+        const i32             nodeParent = stack.back().second;
+        stack.pop_back();
+        const i32 index = (i32)nodes.size();
+        nodes.emplace_back();
+        nodes[index].parent = nodeParent;
+        nodes[index].named  = jnode.contains("name");
+        if (nodes[index].named) { nodes[index].name = jnode.at("name").get<std::string>(); }
+        if (jnode.contains("components")) {
+            for (const auto& jcomponent : jnode.at("components")) {
+                if (jcomponent.is_null()) continue;
+                if (jcomponent.contains("name")) { nodes[index].components.push_back(jcomponent); }
+            }
+        }
+        if (jnode.contains("nodes")) {
+            const nlohmann::json& jchildren = jnode.at("nodes");
+            for (auto it = jchildren.rbegin(); it != jchildren.rend(); ++it) {
+                if (!it->is_null()) { stack.push_back({ &*it, index }); }
+            }
+        }
+    }
+}
+
+bool
+PrototypeSceneParser::parseScene(const std::string& text, nlohmann::json& j, std::vector<PrototypeSceneParsedLayer>& layers)
+{
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scene)
+    j = nlohmann::json::object();
+    layers.clear();
+
+    // the main thread only finds where the root nodes of every layer start and end, they get parsed on the workers
+    const PrototypeJsonSlice               whole = slice(text);
+    const char*                            end   = whole.end;
+    std::vector<PrototypeSceneParserChunk> chunks;
+    const char* next = walkMembers(whole.begin, end, [&](const std::string& key, const char* value) -> const char* {
+        if (key != "layers") return parseValueAt(value, end, j[key]);
+        j[key] = nlohmann::json::array();
+        if (isNullAt(value, end)) return value + 4;
+        return walkElements(value, end, [&](const char* element) -> const char* {
+            if (isNullAt(element, end)) return element + 4;
+            layers.emplace_back();
+            return walkLayerAt(element, end, layers.size() - 1, layers.back(), chunks);
+        });
+    });
+    if (next != end) return false;
+
+    // chunks don't share anything until they get merged, the calling thread stages chunks too while it waits
+    PrototypeThreadpool* threadpool = PrototypeEngineInternalApplication::threadpool;
+    std::atomic<size_t>  pending(chunks.size());
+    std::atomic<bool>    failed(false);
+    for (auto& chunk : chunks) {
+        PrototypeSceneParserChunk* staged = &chunk;
+        threadpool->submit(
+          [staged, &pending, &failed]() {
+              PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scene)
+              for (const PrototypeJsonSlice& root : staged->roots) {
+                  if (parseNodeAt(root.begin, root.end, -1, staged->nodes) != root.end) {
+                      failed.store(true, std::memory_order_relaxed);
+                      break;
+                  }
+              }
+              pending.fetch_sub(1, std::memory_order_release);
+          },
+          PrototypeThreadpoolPriority_Low);
+    }
+    threadpool->helpUntil(pending, PrototypeThreadpoolPriority_Low);
+    if (failed.load(std::memory_order_relaxed)) return false;
+
+    // chunks of a layer are in file order, their parent indices only need to be shifted by what came before them
+    for (auto& chunk : chunks) {
+        std::vector<PrototypeSceneParsedNode>& nodes  = layers[chunk.layer].nodes;
+        const i32                              offset = (i32)nodes.size();
+        if (nodes.empty()) {
+            nodes = std::move(chunk.nodes);
+            continue;
+        }
+        nodes.reserve(nodes.size() + chunk.nodes.size());
+        for (auto& node : chunk.nodes) {
+            if (node.parent >= 0) { node.parent += offset; }
+            nodes.push_back(std::move(node));
+        }
+    }
+    return true;
+}
+
+void
+PrototypeSceneParser::stageLayer(const nlohmann::json& j, PrototypeSceneParsedLayer& layer)
+{
+    layer.named = j.contains("name");
+    if (layer.named) { layer.name = j.at("name").get<std::string>(); }
+    if (j.contains("streaming")) { layer.streaming = j.at("streaming"); }
+    if (j.contains("nodes")) {
+        for (const auto& jnode : j.at("nodes")) {
+            if (jnode.is_null()) continue;
+            stageNode(jnode, -1, layer.nodes);
+        }
+    }
+}
+
+bool
+PrototypeSceneParser::parseNodes(const std::string& text, std::vector<PrototypeSceneParsedNode>& nodes)
+{
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scene)
+    nodes.clear();
+    const PrototypeJsonSlice whole    = slice(text);
+    const char*              end      = whole.end;
+    bool                     hasNodes = false;
+    const char* next = walkMembers(whole.begin, end, [&](const std::string& key, const char* value) -> const char* {
+        if (key != "nodes" || value >= end || *value != '[') return skipValue(value, end);
+        hasNodes = true;
+        return walkElements(value, end, [&nodes, end](const char* element) -> const char* {
+            return isNullAt(element, end) ? element + 4 : parseNodeAt(element, end, -1, nodes);
+        });
+    });
+    return next == end && hasNodes;
+}
+
+PrototypeJsonSlice
+PrototypeSceneParser::slice(const std::string& text)
+{
+    const char* begin = skipWhitespace(text.data(), text.data() + text.size());
+    const char* end   = text.data() + text.size();
+    while (end > begin && (end[-1] == ' ' || end[-1] == '\n' || end[-1] == '\r' || end[-1] == '\t')) { --end; }
+    return { begin, end };
+}
+
+bool
+PrototypeSceneParser::members(PrototypeJsonSlice object, const std::function<bool(const std::string&, PrototypeJsonSlice)>& fn)
+{
+    const char* end  = object.end;
+    const char* next = walkMembers(
+      skipWhitespace(object.begin, end), end, [&fn, end](const std::string& key, const char* value) -> const char* {
+          const char* valueEnd = skipValue(value, end);
+          return valueEnd && fn(key, { value, valueEnd }) ? valueEnd : nullptr;
+      });
+    return next && skipWhitespace(next, end) == end;
+}
+
+bool
+PrototypeSceneParser::elements(PrototypeJsonSlice array, const std::function<bool(PrototypeJsonSlice)>& fn)
+{
+    const char* end  = array.end;
+    const char* next = walkElements(skipWhitespace(array.begin, end), end, [&fn, end](const char* value) -> const char* {
+        const char* valueEnd = skipValue(value, end);
+        return valueEnd && fn({ value, valueEnd }) ? valueEnd : nullptr;
+    });
+    return next && skipWhitespace(next, end) == end;
+}
+
+bool
+PrototypeSceneParser::isNull(PrototypeJsonSlice value)
+{
+    return isNullAt(value.begin, value.end) && value.end - value.begin == 4;
+}
+
+bool
+PrototypeSceneParser::parseString(PrototypeJsonSlice value, std::string& text)
+{
+    return parseStringAt(value.begin, value.end, text) == value.end;
+}
+
+bool
+PrototypeSceneParser::parseValue(PrototypeJsonSlice value, nlohmann::json& j)
+{
+    const char* next = parseValueAt(skipWhitespace(value.begin, value.end), value.end, j);
+    return next && skipWhitespace(next, value.end) == value.end;
+}
@@ -0,0 +1,75 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#pragma once
+
+#include <PrototypeCommon/Definitions.h>
+#include <PrototypeCommon/Types.h>
+
+#include <nlohmann/json.hpp>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// a value inside a json text that hasn't been parsed yet, it points into the text it came from
+struct PrototypeJsonSlice
+{
+    const char* begin;
+    const char* end;
+};
+
+// a node staged by the parser, nodes come parents first so a node's parent is always staged before it
+struct PrototypeSceneParsedNode
+{
+    std::string                 name;
+    std::vector<nlohmann::json> components; // the null ones and the ones without a name are dropped
+    i32                         parent;     // index of the parent node in the layer, -1 for the layer roots
+    bool                        named;      // nodes without a name are skipped together with their children
+};
+
+struct PrototypeSceneParsedLayer
+{
+    std::string                           name;
+    bool                                  named; // layers without a name are skipped
+    nlohmann::json                        streaming;
+    std::vector<PrototypeSceneParsedNode> nodes;
+};
+
+// Parses scene and resource files on demand. The text is only walked for structure, the layers get parsed in parallel on
+// the workers and only the components and the small scene fields ever become json values, the rest of the scene goes
+// straight into flat lists of staged nodes the main thread turns into scene nodes. Reads the same schema from_json reads.
+struct PrototypeSceneParser
+{
+    PrototypeSceneParser()  = delete;
+    ~PrototypeSceneParser() = delete;
+
+    // every member but the layers lands in j, layers holds an empty array in their place so the scene checks still see it
+    static bool parseScene(const std::string& text, nlohmann::json& j, std::vector<PrototypeSceneParsedLayer>& layers);
+    // stages a layer that is already a json value, for scenes that didn't come from a file
+    static void stageLayer(const nlohmann::json& j, PrototypeSceneParsedLayer& layer);
+    // stages the nodes of a streamed layer file on the calling thread, the rest of the file is skipped
+    static bool parseNodes(const std::string& text, std::vector<PrototypeSceneParsedNode>& nodes);
+
+    // the whole text, surrounding whitespace excluded
+    static PrototypeJsonSlice slice(const std::string& text);
+    // calls fn for every member of an object, returns false as soon as fn does or if the slice isn't an object
+    static bool members(PrototypeJsonSlice object, const std::function<bool(const std::string&, PrototypeJsonSlice)>& fn);
+    // calls fn for every element of an array, returns false as soon as fn does or if the slice isn't an array
+    static bool elements(PrototypeJsonSlice array, const std::function<bool(PrototypeJsonSlice)>& fn);
+    static bool isNull(PrototypeJsonSlice value);
+    static bool parseString(PrototypeJsonSlice value, std::string& text);
+    static bool parseValue(PrototypeJsonSlice value, nlohmann::json& j);
+};
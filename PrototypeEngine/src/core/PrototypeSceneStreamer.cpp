@@ -0,0 +1,429 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#include "PrototypeSceneStreamer.h"
+
+#include "PrototypeDatabase.h"
+#include "PrototypeEngine.h"
+#include "PrototypePhysics.h"
+#include "PrototypeRenderer.h"
+#include "PrototypeScene.h"
+#include "PrototypeSceneLayer.h"
+#include "PrototypeSceneNode.h"
+#include "PrototypeThreadpool.h"
+#include "PrototypeUI.h"
+
+#include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/Maths.h>
+#include <PrototypeCommon/MemoryTracker.h>
+#include <PrototypeCommon/Tracer.h>
+
+#include <PrototypeTraitSystem/PrototypeTraitSystem.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+// a loaded layer stays until the focus gets this much farther than the radius it got loaded at, so a focus moving
+// along the border doesn't load and unload it every other frame
+static const f32    PrototypeSceneStreamerUnloadFactor = 1.25f;
+static const size_t PrototypeSceneStreamerMaxLoads     = 2;
+static const f32    PrototypeSceneStreamerTimeSliceMs  = 2.0f;
+
+PrototypeSceneStreamer::PrototypeSceneStreamer()
+  : _focus(0.0f, 0.0f, 0.0f)
+  , _followCamera(true)
+  , _budget(0)
+  , _timeSliceMs(PrototypeSceneStreamerTimeSliceMs)
+  , _stats({})
+{}
+
+// workers still parsing hold on to their jobs, nothing they write to goes away with the streamer
+PrototypeSceneStreamer::~PrototypeSceneStreamer() {}
+
+void
+PrototypeSceneStreamer::declare(PrototypeScene*      scene,
+                                PrototypeSceneLayer* layer,
+                                const std::string&   filepath,
+                                const glm::vec3&     center,
+                                f32                  radius,
+                                u64                  bytes)
+{
+    Entry entry         = {};
+    entry.scene         = scene;
+    entry.layer         = layer;
+    entry.filepath      = filepath;
+    entry.center        = center;
+    entry.radius        = radius;
+    entry.bytes         = bytes;
+    entry.declaredBytes = bytes > 0;
+    entry.state         = PrototypeSceneStreamingState_Unloaded;
+    entry.mode          = PrototypeSceneStreamingMode_Distance;
+    entry.failed        = false;
+    entry.distance      = 0.0f;
+    entry.cursor        = 0;
+    if (!entry.declaredBytes) {
+        // parsed nodes take a few times the size of their text, only the relative sizes matter to the budget
+        std::error_code error;
+        const auto      size = std::filesystem::file_size(filepath, error);
+        entry.bytes          = error ? 0 : (u64)size;
+    }
+    _entries.push_back(std::move(entry));
+}
+
+void
+PrototypeSceneStreamer::forget(PrototypeSceneLayer* layer)
+{
+    // a load in flight stays in _jobs until its worker is done, the entry just stops waiting for it
+    _entries.erase(
+      std::remove_if(_entries.begin(), _entries.end(), [layer](const Entry& entry) { return entry.layer == layer; }),
+      _entries.end());
+    // the order points into the entries, the next update sorts them again
+    _order.clear();
+}
+
+bool
+PrototypeSceneStreamer::setMode(const std::string& layerName, PrototypeSceneStreamingMode_ mode)
+{
+    Entry* entry = find(layerName);
+    if (!entry) return false;
+    entry->mode   = mode;
+    entry->failed = false;
+    return true;
+}
+
+void
+PrototypeSceneStreamer::setFocus(const glm::vec3& focus)
+{
+    _focus        = focus;
+    _followCamera = false;
+}
+
+void
+PrototypeSceneStreamer::followCamera()
+{
+    _followCamera = true;
+}
+
+void
+PrototypeSceneStreamer::setBudget(u64 bytes)
+{
+    _budget = bytes;
+}
+
+void
+PrototypeSceneStreamer::setTimeSlice(f32 ms)
+{
+    _timeSliceMs = std::max(ms, 0.0f);
+}
+
+void
+PrototypeSceneStreamer::update()
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    _stats.skipped = 0;
+    _stats.sliceMs = 0.0;
+
+    // jobs of dropped layers keep their worker busy until they are done, they still count against the loads in flight
+    _jobs.erase(std::remove_if(_jobs.begin(),
+                               _jobs.end(),
+                               [](const std::shared_ptr<Job>& job) { return job->done.load(std::memory_order_acquire); }),
+                _jobs.end());
+
+    PrototypeScene* scene = PrototypeEngineInternalApplication::scene;
+    _order.clear();
+    if (!scene || _entries.empty()) {
+        refreshStats();
+        return;
+    }
+
+    if (_followCamera && PrototypeEngineInternalApplication::renderer) {
+#if defined(PROTOTYPE_ENGINE_DEVELOPMENT_MODE)
+        Camera* camera = PrototypeEngineInternalApplication::renderer->editorSceneCamera();
+#else
+        Camera* camera = PrototypeEngineInternalApplication::renderer->mainCamera();
+#endif
+        // the camera keeps its position negated
+        if (camera) { _focus = -camera->position(); }
+    }
+    for (Entry& entry : _entries) {
+        if (entry.scene != scene) continue;
+        entry.distance = glm::length(entry.center - _focus);
+        _order.push_back(&entry);
+    }
+    std::sort(_order.begin(), _order.end(), [](const Entry* a, const Entry* b) { return a->distance < b->distance; });
+
+    for (Entry* entry : _order) {
+        if (entry->state != PrototypeSceneStreamingState_Loading || !entry->job->done.load(std::memory_order_acquire)) {
+            continue;
+        }
+        if (entry->job->ok) {
+            entry->state = PrototypeSceneStreamingState_Staged;
+        } else {
+            PrototypeLogger::warn("Couldn't stream layer <%s> from <%s>", entry->layer->name().c_str(), entry->filepath.c_str());
+            entry->job.reset();
+            entry->state  = PrototypeSceneStreamingState_Unloaded;
+            entry->failed = true;
+        }
+    }
+
+    // unloads go first, the budget sees the memory they give back
+    for (Entry* entry : _order) {
+        if (!wanted(*entry)) { unload(*entry); }
+    }
+
+    // nearest first, a load that doesn't fit evicts the loaded layers farther than itself or waits,
+    // nothing gets evicted unless evicting makes the load fit, or the layers would only trade places every frame
+    auto evictable = [](const Entry* farther, const Entry* entry) {
+        return farther->distance > entry->distance && farther->mode == PrototypeSceneStreamingMode_Distance &&
+               farther->state != PrototypeSceneStreamingState_Unloaded &&
+               farther->state != PrototypeSceneStreamingState_Unloading;
+    };
+    u64 bytes = loadedBytes();
+    for (Entry* entry : _order) {
+        if (entry->state != PrototypeSceneStreamingState_Unloaded || !wanted(*entry)) continue;
+        if (_jobs.size() >= PrototypeSceneStreamerMaxLoads) break;
+        if (_budget > 0 && entry->mode == PrototypeSceneStreamingMode_Distance && bytes + entry->bytes > _budget) {
+            u64 evictableBytes = 0;
+            for (const Entry* farther : _order) {
+                if (evictable(farther, entry)) { evictableBytes += farther->bytes; }
+            }
+            if (bytes - std::min(bytes, evictableBytes) + entry->bytes > _budget) {
+                ++_stats.skipped;
+                continue;
+            }
+            for (auto it = _order.rbegin(); it != _order.rend() && bytes + entry->bytes > _budget; ++it) {
+                Entry* farther = *it;
+                if (!evictable(farther, entry)) continue;
+                bytes -= std::min(bytes, farther->bytes);
+                unload(*farther);
+                ++_stats.evictions;
+            }
+        }
+        load(*entry);
+        bytes += entry->bytes;
+    }
+
+    // removals first as well, then merges nearest first, one node at least whatever the slice
+    const auto start   = std::chrono::steady_clock::now();
+    auto       elapsed = [start]() {
+        return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::vector<PrototypeObject*> objects;
+    bool                          changed = false;
+    bool                          spent   = false;
+    {
+        PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scene)
+        for (Entry* entry : _order) {
+            while (!spent && entry->state == PrototypeSceneStreamingState_Unloading) {
+                remove(*entry);
+                changed = true;
+                spent   = elapsed() >= _timeSliceMs;
+            }
+        }
+        for (Entry* entry : _order) {
+            if (!spent && entry->state == PrototypeSceneStreamingState_Staged) {
+                entry->cursor = 0;
+                entry->state  = PrototypeSceneStreamingState_Merging;
+            }
+            while (!spent && entry->state == PrototypeSceneStreamingState_Merging) {
+                merge(*entry, objects);
+                changed = true;
+                spent   = elapsed() >= _timeSliceMs;
+            }
+        }
+    }
+    if (!objects.empty()) { PrototypeEngineInternalApplication::physics->createActors(objects.data(), objects.size()); }
+    if (changed) {
+        PrototypeEngineInternalApplication::renderer->scheduleRecordPass();
+#if defined(PROTOTYPE_ENGINE_DEVELOPMENT_MODE)
+        PrototypeEngineInternalApplication::renderer->ui()->scheduleRecordPass(PrototypeUiViewMaskHierarchy);
+#endif
+    }
+    _stats.sliceMs = elapsed();
+    refreshStats();
+}
+
+PrototypeSceneStreamingState_
+PrototypeSceneStreamer::state(const std::string& layerName) const
+{
+    for (const Entry& entry : _entries) {
+        if (entry.scene == PrototypeEngineInternalApplication::scene && entry.layer->name() == layerName) { return entry.state; }
+    }
+    return PrototypeSceneStreamingState_Unloaded;
+}
+
+const PrototypeSceneStreamerStats&
+PrototypeSceneStreamer::stats() const
+{
+    return _stats;
+}
+
+bool
+PrototypeSceneStreamer::streams(const PrototypeSceneLayer* layer) const
+{
+    return std::find_if(_entries.begin(), _entries.end(), [layer](const Entry& entry) { return entry.layer == layer; }) !=
+           _entries.end();
+}
+
+bool
+PrototypeSceneStreamer::layerToJson(const PrototypeSceneLayer* layer, nlohmann::json& j) const
+{
+    auto it = std::find_if(_entries.begin(), _entries.end(), [layer](const Entry& entry) { return entry.layer == layer; });
+    if (it == _entries.end()) return false;
+    nlohmann::json jstreaming;
+    jstreaming["path"]   = it->filepath;
+    jstreaming["center"] = it->center;
+    jstreaming["radius"] = it->radius;
+    if (it->declaredBytes) { jstreaming["bytes"] = it->bytes; }
+    j["id"]        = layer->id();
+    j["name"]      = layer->name();
+    j["streaming"] = jstreaming;
+    return true;
+}
+
+PrototypeSceneStreamer::Entry*
+PrototypeSceneStreamer::find(const std::string& layerName)
+{
+    for (Entry& entry : _entries) {
+        if (entry.scene == PrototypeEngineInternalApplication::scene && entry.layer->name() == layerName) { return &entry; }
+    }
+    return nullptr;
+}
+
+bool
+PrototypeSceneStreamer::wanted(const Entry& entry) const
+{
+    if (entry.mode == PrototypeSceneStreamingMode_Loaded) return !entry.failed;
+    if (entry.mode == PrototypeSceneStreamingMode_Unloaded || entry.failed) return false;
+    const bool loaded = entry.state != PrototypeSceneStreamingState_Unloaded &&
+                        entry.state != PrototypeSceneStreamingState_Unloading;
+    return entry.distance <= (loaded ? entry.radius * PrototypeSceneStreamerUnloadFactor : entry.radius);
+}
+
+void
+PrototypeSceneStreamer::load(Entry& entry)
+{
+    auto job  = std::make_shared<Job>();
+    job->done = false;
+    job->ok   = false;
+    _jobs.push_back(job);
+    entry.job   = job;
+    entry.state = PrototypeSceneStreamingState_Loading;
+
+    const std::string filepath = entry.filepath;
+    PrototypeEngineInternalApplication::threadpool->submit(
+      [job, filepath]() {
+          PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Scene)
+          std::ifstream file(filepath, std::ios::binary);
+          if (file.is_open()) {
+              const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+              job->ok = PrototypeSceneParser::parseNodes(text, job->nodes);
+          }
+          job->done.store(true, std::memory_order_release);
+      },
+      PrototypeThreadpoolPriority_Low);
+}
+
+void
+PrototypeSceneStreamer::unload(Entry& entry)
+{
+    switch (entry.state) {
+        case PrototypeSceneStreamingState_Loading:
+        case PrototypeSceneStreamingState_Staged: {
+            // nothing reached the scene yet, a worker still parsing finishes into a job nobody reads
+            entry.job.reset();
+            entry.state = PrototypeSceneStreamingState_Unloaded;
+        } break;
+
+        case PrototypeSceneStreamingState_Merging:
+        case PrototypeSceneStreamingState_Resident: {
+            entry.job.reset();
+            entry.merged.clear();
+            entry.state = PrototypeSceneStreamingState_Unloading;
+        } break;
+
+        default: break;
+    }
+}
+
+void
+PrototypeSceneStreamer::merge(Entry& entry, std::vector<PrototypeObject*>& objects)
+{
+    // parents come before their children, a node whose parent didn't make it is dropped along with it
+    const std::vector<PrototypeSceneParsedNode>& nodes = entry.job->nodes;
+    if (entry.cursor < nodes.size()) {
+        const PrototypeSceneParsedNode& parsedNode = nodes[entry.cursor++];
+        PrototypeSceneNode*             parentNode = parsedNode.parent < 0 ? nullptr : entry.merged[parsedNode.parent];
+        PrototypeSceneNode*             node       = nullptr;
+        if (parsedNode.parent < 0 || parentNode) { node = entry.layer->addParsedNode(parsedNode, parentNode, entry.scene); }
+        entry.merged.push_back(node);
+        if (node) {
+            if (!parentNode) { entry.nodeIds.push_back(node->id()); }
+            const auto optObject = node->object();
+            if (optObject.has_value()) { objects.push_back(optObject.value()); }
+        }
+    }
+    if (entry.cursor < nodes.size()) return;
+    // the staging copy isn't needed anymore, saving writes the streaming block back instead of the nodes
+    entry.job.reset();
+    entry.merged.clear();
+    entry.state = PrototypeSceneStreamingState_Resident;
+    ++_stats.loads;
+}
+
+void
+PrototypeSceneStreamer::remove(Entry& entry)
+{
+    if (!entry.nodeIds.empty()) {
+        entry.layer->removeNodeById(entry.nodeIds.back());
+        entry.nodeIds.pop_back();
+    }
+    if (!entry.nodeIds.empty()) return;
+    entry.state = PrototypeSceneStreamingState_Unloaded;
+    ++_stats.unloads;
+}
+
+u64
+PrototypeSceneStreamer::loadedBytes() const
+{
+    // layers on their way out don't count, their nodes are gone within a few frames
+    u64 bytes = 0;
+    for (const Entry* entry : _order) {
+        if (entry->state != PrototypeSceneStreamingState_Unloaded && entry->state != PrototypeSceneStreamingState_Unloading) {
+            bytes += entry->bytes;
+        }
+    }
+    return bytes;
+}
+
+void
+PrototypeSceneStreamer::refreshStats()
+{
+    _stats.layers   = _order.size();
+    _stats.resident = 0;
+    _stats.pending  = 0;
+    _stats.bytes    = loadedBytes();
+    _stats.budget   = _budget;
+    for (const Entry* entry : _order) {
+        if (entry->state == PrototypeSceneStreamingState_Resident) {
+            ++_stats.resident;
+        } else if (entry->state != PrototypeSceneStreamingState_Unloaded) {
+            ++_stats.pending;
+        }
+    }
+}
@@ -0,0 +1,162 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#pragma once
+
+#include "PrototypeSceneParser.h"
+
+#include <PrototypeCommon/Definitions.h>
+#include <PrototypeCommon/Types.h>
+
+#include <glm/glm.hpp>
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct PrototypeObject;
+struct PrototypeScene;
+struct PrototypeSceneLayer;
+struct PrototypeSceneNode;
+
+enum PrototypeSceneStreamingState_
+{
+    PrototypeSceneStreamingState_Unloaded = 0,
+    PrototypeSceneStreamingState_Loading,   // a worker reads and parses the layer file
+    PrototypeSceneStreamingState_Staged,    // parsed, waits for its turn to get merged into the scene
+    PrototypeSceneStreamingState_Merging,   // nodes get instantiated a time slice per frame
+    PrototypeSceneStreamingState_Resident,  // every node is in the scene
+    PrototypeSceneStreamingState_Unloading, // nodes get removed a time slice per frame
+
+    PrototypeSceneStreamingState_Count
+};
+
+enum PrototypeSceneStreamingMode_
+{
+    PrototypeSceneStreamingMode_Distance = 0, // loaded while the focus is within its radius and the budget allows it
+    PrototypeSceneStreamingMode_Loaded,       // kept loaded whatever the distance, never evicted by the budget
+    PrototypeSceneStreamingMode_Unloaded,     // kept unloaded whatever the distance
+
+    PrototypeSceneStreamingMode_Count
+};
+
+struct PrototypeSceneStreamerStats
+{
+    u64 layers;    // streamable layers of the current scene
+    u64 resident;  // layers of the current scene with every node merged
+    u64 pending;   // layers loading, staged, merging or unloading
+    u64 bytes;     // estimated memory of the layers loading, staged or in the scene
+    u64 budget;    // 0 when unlimited
+    u64 loads;     // layers merged since startup
+    u64 unloads;   // layers unloaded since startup
+    u64 evictions; // unloads forced by the budget
+    u64 skipped;   // loads the budget held back during the last update
+    f64 sliceMs;   // time the last update spent merging and removing nodes
+};
+
+// Loads the nodes of streamable layers from their own files in the background and unloads them again.
+// Workers read and parse a layer file into a staging copy off the main thread, update() then instantiates the staged
+// nodes into the live scene a few at a time so a frame never spends more than the time slice on it, and removes the
+// nodes of the layers the focus moved away from the same way. Layers load nearest first and the farthest unpinned
+// ones get evicted when the estimated memory of the loaded layers would go past the budget.
+struct PrototypeSceneStreamer
+{
+    PrototypeSceneStreamer();
+    ~PrototypeSceneStreamer();
+
+    // makes an empty layer of the scene streamable, its nodes come from filepath which holds a "nodes" array like
+    // the layers of a scene file do, bytes is the memory the layer gets accounted for, 0 estimates it from the file
+    void declare(PrototypeScene*      scene,
+                 PrototypeSceneLayer* layer,
+                 const std::string&   filepath,
+                 const glm::vec3&     center,
+                 f32                  radius,
+                 u64                  bytes);
+    // drops the layer along with its load in flight, called when the layer gets deallocated
+    void forget(PrototypeSceneLayer* layer);
+
+    // overrides the distance rule for a layer of the current scene, returns false if no such layer is streamable
+    bool setMode(const std::string& layerName, PrototypeSceneStreamingMode_ mode);
+    // distances get measured from this point instead of the main camera
+    void setFocus(const glm::vec3& focus);
+    // distances get measured from the main camera again
+    void followCamera();
+    // estimated bytes the loaded layers may take, 0 is unlimited
+    void setBudget(u64 bytes);
+    // milliseconds a frame may spend merging and removing nodes, at least one node gets through every frame
+    void setTimeSlice(f32 ms);
+
+    // starts the loads and unloads the focus, the modes and the budget call for, then merges and removes nodes of the
+    // current scene until the time slice is spent
+    void update();
+
+    PrototypeSceneStreamingState_      state(const std::string& layerName) const;
+    const PrototypeSceneStreamerStats& stats() const;
+
+    // writes the streaming block of the layer instead of its streamed nodes, returns false if it isn't streamable
+    bool layerToJson(const PrototypeSceneLayer* layer, nlohmann::json& j) const;
+    // whether the nodes of the layer come from its streamed file rather than the scene file
+    bool streams(const PrototypeSceneLayer* layer) const;
+
+  private:
+    // filled by a worker, only read by the main thread once done is set
+    struct Job
+    {
+        std::atomic<bool>                     done;
+        bool                                  ok;
+        std::vector<PrototypeSceneParsedNode> nodes; // parents first
+    };
+
+    struct Entry
+    {
+        PrototypeScene*                  scene;
+        PrototypeSceneLayer*             layer;
+        std::string                      filepath;
+        glm::vec3                        center;
+        f32                              radius;
+        u64                              bytes;
+        bool                             declaredBytes; // bytes came with the declaration and get saved back
+        PrototypeSceneStreamingState_    state;
+        PrototypeSceneStreamingMode_     mode;
+        bool                             failed; // the file couldn't be loaded, the distance rule stops retrying it
+        f32                              distance;
+        std::shared_ptr<Job>             job;
+        size_t                           cursor;  // next staged node to merge
+        std::vector<PrototypeSceneNode*> merged;  // scene node of every staged node merged so far, null for dropped ones
+        std::vector<u32>                 nodeIds; // merged root nodes, removed back to front when unloading
+    };
+
+    Entry* find(const std::string& layerName);
+    bool   wanted(const Entry& entry) const;
+    void   load(Entry& entry);
+    void   unload(Entry& entry);
+    // instantiates the next staged node, the layer becomes resident after the last one
+    void merge(Entry& entry, std::vector<PrototypeObject*>& objects);
+    // removes the last merged node, the layer becomes unloaded after the first one
+    void remove(Entry& entry);
+    u64  loadedBytes() const;
+    void refreshStats();
+
+    std::vector<Entry>                _entries;
+    std::vector<Entry*>               _order; // entries of the current scene, nearest first
+    std::vector<std::shared_ptr<Job>> _jobs;  // loads in flight, the ones of dropped layers included
+    glm::vec3                         _focus;
+    bool                              _followCamera;
+    u64                               _budget;
+    f32                               _timeSliceMs;
+    PrototypeSceneStreamerStats       _stats;
+};
@@ -21,6 +21,7 @@
 
 #include <PrototypeCommon/IO.h>
 #include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/MemoryTracker.h>
 
 #include <algorithm>
 #include <regex>
@@ -209,6 +210,7 @@ parseBindingSource(std::vector<std::shared_ptr<PrototypeShaderBufferSource>>& so
 void
 loadSourceFromFile(std::vector<std::shared_ptr<PrototypeShaderBufferSource>>& sources)
 {
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Shaders)
     sources[0]->code = "";
     sources[1]->code = "";
     if (PrototypeIo::readFileBlock(sources[0]->fullpath.c_str(), sources[0]->code)) {
@@ -317,7 +317,7 @@ shortcutSpawnSphere(const glm::vec3& position, const glm::vec3& rotation, const
     }
 }
 
-extern void
+extern PrototypeObject*
 shortcutSpawnCube(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& dir)
 {
     auto              defaultLayer        = PrototypeEngineInternalApplication::scene->layers().begin()->second;
@@ -337,6 +337,7 @@ shortcutSpawnCube(const glm::vec3& position, const glm::vec3& rotation, const gl
         PrototypeEngineInternalApplication::renderer->scheduleRecordPass();
         PrototypeEngineInternalApplication::physics->scheduleRecordPass();
     }
+    return object;
 }
 
 extern void
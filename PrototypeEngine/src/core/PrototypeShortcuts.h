@@ -67,7 +67,8 @@ shortcutSetupObjectVehicleChasisWheelsTrait(PrototypeObject* chasisObject,
 // Spawning
 extern void
 shortcutSpawnSphere(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& dir);
-extern void
+// returns the spawned cube, or null when it couldn't be created
+extern PrototypeObject*
 shortcutSpawnCube(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& dir);
 extern void
 shortcutSpawnConvexMesh(const glm::vec3&   position,
@@ -21,6 +21,7 @@
 
 #include <PrototypeCommon/IO.h>
 #include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/MemoryTracker.h>
 
 #define STB_IMAGE_STATIC
 #define STB_IMAGE_IMPLEMENTATION
@@ -29,6 +30,7 @@
 void
 loadSourceFromFile(PrototypeTextureBufferSource* textureBufferSource)
 {
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Textures)
     u8* textureData = stbi_load(textureBufferSource->fullpath.c_str(),
                                 &textureBufferSource->width,
                                 &textureBufferSource->height,
@@ -14,6 +14,10 @@
 
 #include "PrototypeThreadpool.h"
 
+#include <PrototypeCommon/Tracer.h>
+
+#include <algorithm>
+
 PrototypeThreadpool::PrototypeThreadpool(u8 numThreads)
 {
     _numThreads = numThreads;
@@ -25,27 +29,37 @@ PrototypeThreadpool::PrototypeThreadpool(u8 numThreads)
 PrototypeThreadpool::~PrototypeThreadpool() { stopAll(); }
 
 void
-PrototypeThreadpool::submit(ThreadPoolTask task) noexcept
+PrototypeThreadpool::submit(ThreadPoolTask task, PrototypeThreadpoolPriority_ priority) noexcept
 {
     {
         std::unique_lock<std::mutex> lock(_eventMutex);
-        _tasks.emplace(std::move(task));
+        _tasks[priority].push(std::move(task));
+    }
+    // the reserved worker could be the one woken up and leave the task to workers that keep sleeping
+    if (_numThreads > 1 && priority != PrototypeThreadpoolPriority_High) {
+        _eventVar.notify_all();
+    } else {
+        _eventVar.notify_one();
     }
-    _eventVar.notify_one();
 }
 
 bool
 PrototypeThreadpool::hasWork() noexcept
 {
     std::unique_lock<std::mutex> lock(_eventMutex);
-    return !_tasks.empty() || _numBusyThreads > 0;
+    for (const auto& tasks : _tasks) {
+        if (tasks.size > 0) { return true; }
+    }
+    return _numBusyThreads > 0;
 }
 
 u8
 PrototypeThreadpool::remainingTasks() noexcept
 {
     std::unique_lock<std::mutex> lock(_eventMutex);
-    return static_cast<u8>(_tasks.size());
+    size_t                       numTasks = 0;
+    for (const auto& tasks : _tasks) { numTasks += tasks.size; }
+    return static_cast<u8>(numTasks);
 }
 
 void
@@ -54,26 +68,127 @@ PrototypeThreadpool::waitForWork() noexcept
     while (hasWork()) {}
 }
 
+void
+PrototypeThreadpool::helpUntil(const std::atomic<size_t>& pending, PrototypeThreadpoolPriority_ priority) noexcept
+{
+    while (pending.load(std::memory_order_acquire) > 0) {
+        if (!help(priority)) { std::this_thread::yield(); }
+    }
+}
+
+bool
+PrototypeThreadpool::help(PrototypeThreadpoolPriority_ priority) noexcept
+{
+    ThreadPoolTask task;
+    {
+        std::unique_lock<std::mutex> lock(_eventMutex);
+        if (!popTask(task, priority)) { return false; }
+    }
+    PROTOTYPE_TRACE_ZONE("PrototypeThreadpool::help")
+    task();
+    return true;
+}
+
+u8
+PrototypeThreadpool::numThreads() const noexcept
+{
+    return _numThreads;
+}
+
+void
+PrototypeThreadpool::TaskQueue::push(ThreadPoolTask&& task)
+{
+    if (size == slots.size()) {
+        // unroll the ring in the grown storage, only happens until the queue reached its steady-state depth
+        std::vector<ThreadPoolTask> grown(std::max((size_t)64, slots.size() * 2));
+        for (size_t i = 0; i < size; ++i) { grown[i] = std::move(slots[(head + i) % slots.size()]); }
+        slots.swap(grown);
+        head = 0;
+    }
+    slots[(head + size) % slots.size()] = std::move(task);
+    ++size;
+}
+
+void
+PrototypeThreadpool::TaskQueue::pop(ThreadPoolTask& task)
+{
+    task = std::move(slots[head]);
+    slots[head] = nullptr;
+    head        = (head + 1) % slots.size();
+    --size;
+}
+
+bool
+PrototypeThreadpool::popTask(ThreadPoolTask& task, PrototypeThreadpoolPriority_ priority) noexcept
+{
+    for (size_t p = 0; p <= (size_t)priority; ++p) {
+        if (_tasks[p].size == 0) { continue; }
+        _tasks[p].pop(task);
+        return true;
+    }
+    return false;
+}
+
+void
+PrototypeThreadpool::parallelForRanges(size_t                       count,
+                                       size_t                       grainSize,
+                                       const void*                  task,
+                                       RangeInvoke                  invoke,
+                                       PrototypeThreadpoolPriority_ priority) noexcept
+{
+    if (count == 0) { return; }
+    const size_t maxRanges = (size_t)_numThreads + 1;
+    const size_t numRanges = std::max((size_t)1, std::min(maxRanges, count / std::max(grainSize, (size_t)1)));
+
+    // the submitted tasks only capture the shared range state and their begin so they fit std::function inline
+    struct Ranges
+    {
+        const void*         task;
+        RangeInvoke         invoke;
+        size_t              count;
+        size_t              rangeSize;
+        std::atomic<size_t> pending;
+    } ranges = { task, invoke, count, (count + numRanges - 1) / numRanges, { 0 } };
+
+    for (size_t begin = ranges.rangeSize; begin < count; begin += ranges.rangeSize) {
+        ranges.pending.fetch_add(1, std::memory_order_relaxed);
+        submit(
+          [&ranges, begin]() {
+              ranges.invoke(ranges.task, begin, std::min(begin + ranges.rangeSize, ranges.count));
+              ranges.pending.fetch_sub(1, std::memory_order_release);
+          },
+          priority);
+    }
+    invoke(task, 0, std::min(ranges.rangeSize, count));
+    helpUntil(ranges.pending, priority);
+}
+
 void
 PrototypeThreadpool::startAll()
 {
     for (size_t i = 0; i < _numThreads; ++i) {
+        const PrototypeThreadpoolPriority_ lowest =
+          i == 0 && _numThreads > 1 ? PrototypeThreadpoolPriority_High : PrototypeThreadpoolPriority_Low;
         _threads.emplace_back([=]() {
+            PrototypeTracer::setThreadName("PrototypeThreadpool");
             while (true) {
                 ThreadPoolTask task;
 
                 {
                     std::unique_lock<std::mutex> lock(_eventMutex);
-                    _eventVar.wait(lock, [=]() { return _stopped.load() || !_tasks.empty(); });
+                    _eventVar.wait(lock, [&]() {
+                        return _stopped.load() || popTask(task, lowest);
+                    });
 
                     if (_stopped.load()) { break; }
 
-                    task = std::move(_tasks.front());
-                    _tasks.pop();
                     _numBusyThreads.store(_numBusyThreads.load() + 1);
                 }
 
-                task();
+                {
+                    PROTOTYPE_TRACE_ZONE("PrototypeThreadpool::task")
+                    task();
+                }
 
                 {
                     std::unique_lock<std::mutex> lock(_eventMutex);
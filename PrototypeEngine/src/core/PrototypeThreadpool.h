@@ -16,34 +16,91 @@
 
 #include "../../include/PrototypeEngine/PrototypeEngineApi.h"
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
 #include <functional>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <vector>
 
-typedef std::function<void()> ThreadPoolTask;
+// tasks submitted every frame keep their captures within two pointers so std::function stores them inline,
+// the queues reuse their slots so a steady-state frame doesn't touch the heap
+typedef std::function<void()>                     ThreadPoolTask;
+typedef std::function<void(size_t begin, size_t end)> ThreadPoolRangeTask;
+
+// workers always pick the oldest task of the highest priority queue that has any, a running task is never preempted
+// so the first worker of a pool with more than one only ever takes High tasks, long background jobs can't hold up
+// every worker while frame critical work waits
+enum PrototypeThreadpoolPriority_
+{
+    PrototypeThreadpoolPriority_High,   // frame critical work (physics), waited on by the main thread
+    PrototypeThreadpoolPriority_Normal, //
+    PrototypeThreadpoolPriority_Low,    // background work (asset loading)
+
+    PrototypeThreadpoolPriority_Count
+};
 
 struct PrototypeThreadpool
 {
     explicit PrototypeThreadpool(u8 numThreads);
     ~PrototypeThreadpool();
-    void submit(ThreadPoolTask task) noexcept;
+    void submit(ThreadPoolTask task, PrototypeThreadpoolPriority_ priority = PrototypeThreadpoolPriority_Normal) noexcept;
     bool hasWork() noexcept;
     u8   remainingTasks() noexcept;
     void waitForWork() noexcept;
+    // runs queued tasks of at least the given priority on the calling thread until pending drops to zero,
+    // a pool with no threads still makes progress and the waiting thread never idles a core
+    void helpUntil(const std::atomic<size_t>& pending, PrototypeThreadpoolPriority_ priority) noexcept;
+    // runs one queued task of at least the given priority on the calling thread, returns false if there was none
+    bool help(PrototypeThreadpoolPriority_ priority) noexcept;
+    // splits [0, count) in up to one range per worker plus the calling thread, ranges are at least grainSize long,
+    // runs the first range on the calling thread and returns once every range ran
+    // the task is called as task(begin, end) and is never copied, lambdas don't go through a std::function
+    template<typename Task>
+    void parallelFor(size_t                       count,
+                     size_t                       grainSize,
+                     const Task&                  task,
+                     PrototypeThreadpoolPriority_ priority = PrototypeThreadpoolPriority_High) noexcept
+    {
+        parallelForRanges(
+          count,
+          grainSize,
+          &task,
+          [](const void* t, size_t begin, size_t end) { (*static_cast<const Task*>(t))(begin, end); },
+          priority);
+    }
+    u8 numThreads() const noexcept;
 
   private:
+    typedef void (*RangeInvoke)(const void* task, size_t begin, size_t end);
+
+    // fifo of tasks that keeps its slots once grown
+    struct TaskQueue
+    {
+        std::vector<ThreadPoolTask> slots;
+        size_t                      head = 0;
+        size_t                      size = 0;
+
+        void push(ThreadPoolTask&& task);
+        void pop(ThreadPoolTask& task);
+    };
+
     void startAll();
     void stopAll() noexcept;
+    // pops the next task of at least the given priority, expects _eventMutex to be held
+    bool popTask(ThreadPoolTask& task, PrototypeThreadpoolPriority_ priority) noexcept;
+    void parallelForRanges(size_t                       count,
+                           size_t                       grainSize,
+                           const void*                  task,
+                           RangeInvoke                  invoke,
+                           PrototypeThreadpoolPriority_ priority) noexcept;
 
-    u8                         _numThreads;
-    std::atomic_uint8_t        _numBusyThreads;
-    std::atomic_bool           _stopped;
-    std::condition_variable    _eventVar;
-    std::mutex                 _eventMutex;
-    std::vector<std::thread>   _threads;
-    std::queue<ThreadPoolTask> _tasks;
+    u8                                                       _numThreads;
+    std::atomic_uint8_t                                      _numBusyThreads;
+    std::atomic_bool                                         _stopped;
+    std::condition_variable                                  _eventVar;
+    std::mutex                                               _eventMutex;
+    std::vector<std::thread>                                 _threads;
+    std::array<TaskQueue, PrototypeThreadpoolPriority_Count> _tasks;
 };
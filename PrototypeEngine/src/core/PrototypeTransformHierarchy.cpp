@@ -0,0 +1,370 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#include "PrototypeTransformHierarchy.h"
+
+#include "PrototypeEngine.h"
+#include "PrototypeScene.h"
+#include "PrototypeSceneLayer.h"
+#include "PrototypeSceneNode.h"
+#include "PrototypeThreadpool.h"
+
+#include <PrototypeCommon/Tracer.h>
+
+#include <PrototypeTraitSystem/PrototypeTraitSystem.h>
+
+#include <algorithm>
+#include <unordered_set>
+
+#define PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT     0xffffffffu
+#define PROTOTYPE_TRANSFORM_HIERARCHY_PARALLEL_SIZE 4096 // fewer transforms to compose than that stay on the calling thread
+#define PROTOTYPE_TRANSFORM_HIERARCHY_SPLIT_SIZE    1024 // bigger subtrees get handed to the workers as their child subtrees
+#define PROTOTYPE_TRANSFORM_HIERARCHY_GRAIN_SIZE    16   // subtrees per worker range
+#define PROTOTYPE_TRANSFORM_HIERARCHY_COMPACT_MIN   256  // holes and grafts below that never flatten the scene again
+
+static const glm::mat4 Identity = glm::mat4(1.0f);
+
+// the transform moved along with its parent, a rigidbody on it has to follow
+static inline void
+syncPhysics(Transform* transform)
+{
+    if (!transform) { return; }
+    PrototypeObject* object = transform->object();
+    if (object && object->hasRigidbodyTrait()) { transform->setNeedsPhysicsSync(true); }
+}
+
+PrototypeTransformHierarchy::PrototypeTransformHierarchy()
+  : _scene(nullptr)
+  , _needsRebuild(true)
+  , _holes(0)
+  , _stats({})
+{}
+
+PrototypeTransformHierarchy::~PrototypeTransformHierarchy() {}
+
+void
+PrototypeTransformHierarchy::scheduleRebuild()
+{
+    _needsRebuild = true;
+}
+
+void
+PrototypeTransformHierarchy::addNode(PrototypeScene* scene, PrototypeSceneNode* node)
+{
+    if (_needsRebuild || scene != _scene) { return; }
+    _added.push_back(node);
+}
+
+void
+PrototypeTransformHierarchy::removeNode(PrototypeScene* scene, PrototypeSceneNode* node)
+{
+    if (_needsRebuild || scene != _scene) { return; }
+    auto addedIt = std::find(_added.begin(), _added.end(), node);
+    if (addedIt != _added.end()) { _added.erase(addedIt); }
+    const auto optObject = node->object();
+    if (!optObject.has_value() || !optObject.value()->hasTransformTrait()) { return; }
+    auto it = _indices.find(optObject.value()->getTransformTrait());
+    if (it == _indices.end()) { return; }
+    if (_parents[it->second] == PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT) { --_stats.roots; }
+    _transforms[it->second] = nullptr;
+    _indices.erase(it);
+    ++_holes;
+    _stats.transforms = _indices.size();
+}
+
+void
+PrototypeTransformHierarchy::moveNode(PrototypeScene* scene, PrototypeSceneNode* node)
+{
+    if (_needsRebuild || scene != _scene) { return; }
+    // parents and subtree ends are stale once the node moves, removing every node below it leaves their slots as holes
+    std::vector<PrototypeSceneNode*> stack = { node };
+    while (!stack.empty()) {
+        PrototypeSceneNode* current = stack.back();
+        stack.pop_back();
+        removeNode(scene, current);
+        for (const auto& childPair : current->nodes()) { stack.push_back(childPair.second); }
+    }
+}
+
+void
+PrototypeTransformHierarchy::markDirty(Transform* transform)
+{
+    std::lock_guard<std::mutex> lock(_dirtyMutex);
+    _dirty.push_back(transform);
+}
+
+void
+PrototypeTransformHierarchy::update()
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    if (!PrototypeEngineInternalApplication::scene) { return; }
+    if (_needsRebuild || _scene != PrototypeEngineInternalApplication::scene) {
+        rebuild();
+        return;
+    }
+    _stats.updated  = 0;
+    _stats.subtrees = 0;
+    if (!_added.empty()) { append(); }
+    if (_holes + (u32)_grafts.size() >
+        std::max((u32)_transforms.size() / 4, (u32)PROTOTYPE_TRANSFORM_HIERARCHY_COMPACT_MIN)) {
+        rebuild();
+        return;
+    }
+    if (_dirty.empty()) { return; }
+
+    _dirtyIndices.clear();
+    for (Transform* transform : _dirty) {
+        auto it = _indices.find(transform);
+        if (it != _indices.end()) { _dirtyIndices.push_back(it->second); }
+    }
+    _dirty.clear();
+    std::sort(_dirtyIndices.begin(), _dirtyIndices.end());
+
+    // subtrees are contiguous in parent before child order, a dirty transform under a dirty one adds nothing
+    _ranges.clear();
+    u32 coveredEnd = 0;
+    for (u32 index : _dirtyIndices) {
+        if (index < coveredEnd) { continue; }
+        coveredEnd = _subtreeEnds[index];
+        _ranges.push_back({ index, coveredEnd, true });
+        _stats.updated += coveredEnd - index;
+    }
+    _coveredRanges = _ranges;
+
+    PrototypeThreadpool* threadpool = PrototypeEngineInternalApplication::threadpool;
+    if (threadpool && threadpool->numThreads() > 0 && _stats.updated >= PROTOTYPE_TRANSFORM_HIERARCHY_PARALLEL_SIZE) {
+        // big subtrees get replaced by their child subtrees until the workers get ranges of similar sizes,
+        // their roots get composed right away since every child subtree reads them
+        for (size_t r = 0; r < _ranges.size();) {
+            const Range range = _ranges[r];
+            if (range.end - range.first <= PROTOTYPE_TRANSFORM_HIERARCHY_SPLIT_SIZE) {
+                ++r;
+                continue;
+            }
+            compose(range.first);
+            if (!range.dirtyRoot) { syncPhysics(_transforms[range.first]); }
+            u32 child  = range.first + 1;
+            _ranges[r] = { child, _subtreeEnds[child], false };
+            for (child = _subtreeEnds[child]; child < range.end; child = _subtreeEnds[child]) {
+                _ranges.push_back({ child, _subtreeEnds[child], false });
+            }
+        }
+        threadpool->parallelFor(_ranges.size(), PROTOTYPE_TRANSFORM_HIERARCHY_GRAIN_SIZE, [this](size_t begin, size_t end) {
+            for (size_t r = begin; r < end; ++r) {
+                for (u32 i = _ranges[r].first; i < _ranges[r].end; ++i) { compose(i); }
+            }
+        });
+    } else {
+        for (const Range& range : _ranges) {
+            for (u32 i = range.first; i < range.end; ++i) { compose(i); }
+        }
+    }
+    // grafted subtrees come after their parent in the array but outside of its range, they follow once it is done
+    _graftRanges.clear();
+    for (const Graft& graft : _grafts) {
+        if (covered(graft.first) || !covered(graft.parent)) { continue; }
+        const Range range = { graft.first, _subtreeEnds[graft.first], false };
+        for (u32 i = range.first; i < range.end; ++i) { compose(i); }
+        _graftRanges.push_back(range);
+        _stats.updated += range.end - range.first;
+    }
+    _stats.subtrees = _ranges.size() + _graftRanges.size();
+
+    // the physics sync list isn't thread safe, the moved descendants get flagged once every subtree is done
+    for (const Range& range : _ranges) {
+        for (u32 i = range.dirtyRoot ? range.first + 1 : range.first; i < range.end; ++i) { syncPhysics(_transforms[i]); }
+    }
+    for (const Range& range : _graftRanges) {
+        for (u32 i = range.first; i < range.end; ++i) { syncPhysics(_transforms[i]); }
+    }
+}
+
+const PrototypeTransformHierarchyStats&
+PrototypeTransformHierarchy::stats() const
+{
+    return _stats;
+}
+
+void PROTOTYPE_DYNAMIC_FN_CALL
+PrototypeTransformHierarchy::onTransformWorldSync(PrototypeObject* object)
+{
+    if (object && PrototypeEngineInternalApplication::transformHierarchy) {
+        PrototypeEngineInternalApplication::transformHierarchy->markDirty(object->getTransformTrait());
+    }
+}
+
+void
+PrototypeTransformHierarchy::rebuild()
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    _scene        = PrototypeEngineInternalApplication::scene;
+    _needsRebuild = false;
+    _transforms.clear();
+    _parents.clear();
+    _subtreeEnds.clear();
+    _indices.clear();
+    _dirty.clear();
+    _added.clear();
+    _grafts.clear();
+    _holes = 0;
+
+    // depth first with an explicit stack, hierarchies can get deeper than the call stack,
+    // nodes without a transform pass their closest parent transform down to their children
+    std::vector<std::pair<PrototypeSceneNode*, u32>> stack;
+    for (const auto& layerPair : _scene->layers()) {
+        for (const auto& nodePair : layerPair.second->nodes()) {
+            stack.push_back({ nodePair.second, PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT });
+        }
+        while (!stack.empty()) {
+            PrototypeSceneNode* node   = stack.back().first;
+            u32                 parent = stack.back().second;
+            stack.pop_back();
+            const auto optObject = node->object();
+            if (optObject.has_value() && optObject.value()->hasTransformTrait()) {
+                Transform* transform  = optObject.value()->getTransformTrait();
+                _indices[transform]   = (u32)_transforms.size();
+                _transforms.push_back(transform);
+                _parents.push_back(parent);
+                parent = (u32)_transforms.size() - 1;
+            }
+            for (const auto& childPair : node->nodes()) { stack.push_back({ childPair.second, parent }); }
+        }
+    }
+
+    const u32         count = (u32)_transforms.size();
+    std::vector<bool> hasChildren(count, false);
+    _subtreeEnds.resize(count);
+    for (u32 i = 0; i < count; ++i) { _subtreeEnds[i] = i + 1; }
+    _stats.roots = 0;
+    for (u32 i = count; i-- > 0;) {
+        const u32 parent = _parents[i];
+        if (parent == PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT) {
+            ++_stats.roots;
+            continue;
+        }
+        _subtreeEnds[parent] = std::max(_subtreeEnds[parent], _subtreeEnds[i]);
+        hasChildren[parent]  = true;
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        Transform*      transform = _transforms[i];
+        const bool      hasParent = _parents[i] != PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT;
+        const glm::mat4 before    = transform->worldModel();
+        transform->setHierarchyLinks(hasParent, hasChildren[i]);
+        compose(i);
+        if (hasParent && before != transform->worldModel()) { syncPhysics(transform); }
+    }
+
+    _stats.transforms = count;
+    _stats.updated    = count;
+    _stats.subtrees   = _stats.roots;
+}
+
+void
+PrototypeTransformHierarchy::append()
+{
+    PROTOTYPE_TRACE_FUNCTION()
+    // a node added along with one of its ancestors comes with the subtree of that ancestor
+    const std::unordered_set<PrototypeSceneNode*>    added(_added.begin(), _added.end());
+    std::vector<std::pair<PrototypeSceneNode*, u32>> stack;
+    const u32                                        begin = (u32)_transforms.size();
+    for (PrototypeSceneNode* node : _added) {
+        bool underAdded  = false;
+        bool parentFound = false;
+        u32  parent      = PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT;
+        for (PrototypeSceneNode* ancestor = node->parentNode(); ancestor && !underAdded; ancestor = ancestor->parentNode()) {
+            underAdded = added.count(ancestor) > 0;
+            if (parentFound) { continue; }
+            const auto optObject = ancestor->object();
+            if (optObject.has_value() && optObject.value()->hasTransformTrait()) {
+                auto it     = _indices.find(optObject.value()->getTransformTrait());
+                parent      = it != _indices.end() ? it->second : PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT;
+                parentFound = true;
+            }
+        }
+        if (underAdded) { continue; }
+
+        stack.push_back({ node, parent });
+        while (!stack.empty()) {
+            PrototypeSceneNode* current = stack.back().first;
+            u32                 index   = stack.back().second;
+            stack.pop_back();
+            const auto optObject = current->object();
+            if (optObject.has_value() && optObject.value()->hasTransformTrait()) {
+                Transform* transform = optObject.value()->getTransformTrait();
+                // already in the array, so is the rest of its subtree
+                if (_indices.find(transform) != _indices.end()) { continue; }
+                _indices[transform] = (u32)_transforms.size();
+                _transforms.push_back(transform);
+                _parents.push_back(index);
+                _subtreeEnds.push_back((u32)_transforms.size());
+                index = (u32)_transforms.size() - 1;
+            }
+            for (const auto& childPair : current->nodes()) { stack.push_back({ childPair.second, index }); }
+        }
+    }
+    _added.clear();
+
+    const u32         end = (u32)_transforms.size();
+    std::vector<bool> hasChildren(end - begin, false);
+    for (u32 i = end; i-- > begin;) {
+        const u32 parent = _parents[i];
+        if (parent == PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT) {
+            ++_stats.roots;
+        } else if (parent >= begin) {
+            _subtreeEnds[parent]        = std::max(_subtreeEnds[parent], _subtreeEnds[i]);
+            hasChildren[parent - begin] = true;
+        } else {
+            _transforms[parent]->setHierarchyLinks(_parents[parent] != PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT, true);
+        }
+    }
+    for (u32 i = begin; i < end; ++i) {
+        const u32 parent = _parents[i];
+        if (parent != PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT && parent < begin) { _grafts.push_back({ parent, i }); }
+        Transform*      transform = _transforms[i];
+        const bool      hasParent = parent != PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT;
+        const glm::mat4 before    = transform->worldModel();
+        transform->setHierarchyLinks(hasParent, hasChildren[i - begin]);
+        compose(i);
+        if (hasParent && before != transform->worldModel()) { syncPhysics(transform); }
+    }
+    _stats.transforms = _indices.size();
+    _stats.updated += end - begin;
+}
+
+bool
+PrototypeTransformHierarchy::covered(u32 index) const
+{
+    // both are sorted and don't overlap within themselves
+    for (const std::vector<Range>* ranges : { &_coveredRanges, &_graftRanges }) {
+        auto it = std::upper_bound(
+          ranges->begin(), ranges->end(), index, [](u32 value, const Range& range) { return value < range.first; });
+        if (it != ranges->begin() && index < std::prev(it)->end) { return true; }
+    }
+    return false;
+}
+
+void
+PrototypeTransformHierarchy::compose(u32 index)
+{
+    Transform* transform = _transforms[index];
+    if (!transform) { return; }
+    const u32 parent = _parents[index];
+    if (parent == PROTOTYPE_TRANSFORM_HIERARCHY_NO_PARENT || !_transforms[parent]) {
+        transform->updateWorldModel(Identity);
+    } else {
+        transform->updateWorldModel(_transforms[parent]->worldModelScaled());
+    }
+}
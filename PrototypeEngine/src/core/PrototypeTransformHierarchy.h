@@ -0,0 +1,103 @@
+/// Copyright 2021 Omar Sherif Fathy
+///
+/// Licensed under the Apache License, Version 2.0 (the "License");
+/// you may not use this file except in compliance with the License.
+/// You may obtain a copy of the License at
+///
+///     http://www.apache.org/licenses/LICENSE-2.0
+///
+/// Unless required by applicable law or agreed to in writing, software
+/// distributed under the License is distributed on an "AS IS" BASIS,
+/// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+/// See the License for the specific language governing permissions and
+/// limitations under the License.
+
+
+#pragma once
+
+#include <PrototypeCommon/Definitions.h>
+#include <PrototypeCommon/Types.h>
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct PrototypeObject;
+struct PrototypeScene;
+struct PrototypeSceneNode;
+struct Transform;
+
+struct PrototypeTransformHierarchyStats
+{
+    u64 transforms; // transforms of the current scene, in parent before child order
+    u64 roots;      // transforms without a parent transform
+    u64 updated;    // world matrices composed by the last update
+    u64 subtrees;   // independent subtrees the last update worked on
+};
+
+// Composes the local transforms of the current scene into world ones, parents first.
+// The transforms get flattened in a parent before child array once per scene, after that an update only visits the
+// subtrees under the transforms that changed since the last one, spread over the threadpool when there are enough of them.
+// Added nodes get their subtree appended at the end of the array and grafted onto their parent transform, removed ones
+// leave a hole behind, the array is only flattened again once the holes and grafts make up a good part of it.
+struct PrototypeTransformHierarchy
+{
+    PrototypeTransformHierarchy();
+    ~PrototypeTransformHierarchy();
+
+    // the next update flattens the whole scene again
+    void scheduleRebuild();
+    // the node and its subtree got added to the scene, the next update appends their transforms
+    void addNode(PrototypeScene* scene, PrototypeSceneNode* node);
+    // the node is about to leave the scene, its transform stops being composed right away,
+    // the scene reports every node of a removed subtree on its own
+    void removeNode(PrototypeScene* scene, PrototypeSceneNode* node);
+    // the node is about to change parent, its subtree leaves the array so that the add reported by the new parent
+    // appends it again under the new parent transform
+    void moveNode(PrototypeScene* scene, PrototypeSceneNode* node);
+    // the local matrices of the transform changed, its subtree gets composed again by the next update,
+    // safe to call from the bulk calls workers
+    void markDirty(Transform* transform);
+    // brings every world matrix of the current scene up to date
+    void update();
+
+    const PrototypeTransformHierarchyStats& stats() const;
+
+    static void PROTOTYPE_DYNAMIC_FN_CALL onTransformWorldSync(PrototypeObject* object);
+
+  private:
+    struct Range
+    {
+        u32  first;     // the subtree root
+        u32  end;       // one past the last descendant
+        bool dirtyRoot; // the root itself changed, its physics sync is left to whoever changed it
+    };
+
+    struct Graft
+    {
+        u32 parent; // index of the parent transform, before the subtree in the array
+        u32 first;  // the appended subtree root
+    };
+
+    void rebuild();
+    void append();
+    void compose(u32 index);
+    bool covered(u32 index) const;
+
+    PrototypeScene*                     _scene;
+    bool                                _needsRebuild;
+    std::vector<Transform*>             _transforms;
+    std::vector<u32>                    _parents;     // index of the parent transform or NoParent
+    std::vector<u32>                    _subtreeEnds; // one past the last descendant
+    std::unordered_map<Transform*, u32> _indices;
+    std::vector<Transform*>             _dirty;
+    std::mutex                          _dirtyMutex;
+    std::vector<u32>                    _dirtyIndices;
+    std::vector<Range>                  _ranges;
+    std::vector<Range>                  _coveredRanges; // what the dirty ranges covered before splitting them
+    std::vector<PrototypeSceneNode*>    _added;         // subtrees waiting to be appended
+    std::vector<Graft>                  _grafts;        // in array order
+    std::vector<Range>                  _graftRanges;   // grafted subtrees under the dirty ranges
+    u32                                 _holes;         // slots of removed transforms
+    PrototypeTransformHierarchyStats    _stats;
+};
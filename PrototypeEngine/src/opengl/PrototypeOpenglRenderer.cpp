@@ -31,6 +31,7 @@
 #include <PrototypeCommon/Algo.h>
 
 #include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/Tracer.h>
 
 #include "../core/PrototypeEngine.h"
 #include "../core/PrototypeScene.h"
@@ -75,6 +76,7 @@
                                                                        { 0.976f, 0.482f, 0.447f, 1.0f });
 
 #define PROTOTYPE_REGISTER_PROFILER_FUNCTION_BEGIN()                                                                             \
+    PROTOTYPE_TRACE_FUNCTION()                                                                                                   \
     static auto profilerT1 = std::chrono::high_resolution_clock::now();                                                          \
     profilerT1             = std::chrono::high_resolution_clock::now();
 
@@ -109,6 +111,7 @@ PrototypeOpenglRenderer::PrototypeOpenglRenderer(PrototypeOpenglWindow* window)
 #endif
   , _uiState(PrototypeUIState_None)
   , _needsRecord(true)
+  , _recordPass(0)
 {}
 
 bool
@@ -672,36 +675,11 @@ PrototypeOpenglRenderer::beginRecordPass()
     //                  <matrices (Model)>
     //                  <mesh>
 
-    struct MeshDrawCommand
-    {
-        GLenum  mode;
-        GLenum  type;
-        GLsizei count;
-    };
+    ++_recordPass;
 
-    struct OrderedDrawSubCommand
-    {
-        PrototypeOpenglCommand*                                  modelMatrixCommand = {};
-        PrototypeOpenglCommand*                                  objectIdCommand    = {};
-        std::unordered_map<GLuint, std::vector<MeshDrawCommand>> meshCommands;
-    };
-    struct OrderedDrawCommand
-    {
-        PrototypeOpenglCommand*              shaderCommand = nullptr;
-        std::vector<PrototypeOpenglCommand*> texturesCommand;
-        std::vector<PrototypeOpenglCommand*> vec4sCommand;
-        std::vector<PrototypeOpenglCommand*> vec3sCommand;
-        std::vector<PrototypeOpenglCommand*> vec2sCommand;
-        std::vector<PrototypeOpenglCommand*> floatsCommand;
-        std::vector<OrderedDrawSubCommand*>  subCommands;
-    };
-    MemoryPool<OrderedDrawCommand, 100>                                              _orderedCommandsPool;
-    MemoryPool<OrderedDrawSubCommand, 100>                                           _orderedSubCommandsPool;
-    std::unordered_map<GLuint, std::unordered_map<std::string, OrderedDrawCommand*>> orderedCommands;
-
-    std::vector<PrototypeSceneNode*> selectedNodes;
+    _selectedNodes.clear();
     for (const auto& selectedNode : PrototypeEngineInternalApplication::scene->selectedNodes()) {
-        selectedNodes.push_back(selectedNode);
+        _selectedNodes.push_back(selectedNode);
     }
     PrototypeEngineInternalApplication::scene->clearSelectedNodes();
     auto meshRendererObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(
@@ -718,244 +696,213 @@ PrototypeOpenglRenderer::beginRecordPass()
             auto geometryPair = _geometries.find(meshMaterialPair.mesh);
             auto materialPair = _materials.find(meshRendererMaterialIt->second->name());
             if (geometryPair != _geometries.end() && materialPair != _materials.end()) {
-                const PglGeometry*              geometry           = geometryPair->second;
-                const PglMaterial*              material           = materialPair->second;
-                const PglShader*                shader             = material->shader;
-                const std::vector<PglTexture*>& textures           = material->textures;
-                OrderedDrawCommand              orderedDrawCommand = {};
+                const PglGeometry*              geometry = geometryPair->second;
+                const PglMaterial*              material = materialPair->second;
+                const PglShader*                shader   = material->shader;
+                const std::vector<PglTexture*>& textures = material->textures;
                 glUniformBlockBinding(shader->program, glGetUniformBlockIndex(shader->program, "Common"), 0);
-                auto commandIt = orderedCommands[material->shader->program].find(material->name);
-                if (commandIt != orderedCommands[material->shader->program].end()) {
-                    OrderedDrawSubCommand* subCommand = _orderedSubCommandsPool.newElement();
+                // the command of a material is kept across record passes, only its first use in a pass rebuilds it
+                OrderedDrawCommand& command = _orderedCommands[material->shader->program][material->name];
+                if (command.recordPass != _recordPass) {
+                    command.recordPass = _recordPass;
+                    command.texturesCommand.clear();
+                    command.vec4sCommand.clear();
+                    command.vec3sCommand.clear();
+                    command.vec2sCommand.clear();
+                    command.floatsCommand.clear();
+                    command.subCommands.clear();
                     {
-                        {
-                            auto a                         = PglCall_glUniformMatrix4fv::_allocator.newElement();
-                            a->location                    = glGetUniformLocation(shader->program, "Model");
-                            a->count                       = 1;
-                            a->transpose                   = 0;
-                            a->value                       = (GLfloat*)&transform->modelScaled()[0][0];
-                            subCommand->modelMatrixCommand = _commandsPool.newElement();
-                            subCommand->modelMatrixCommand->record(a);
-                        }
-                        {
-                            auto a                      = PglCall_glUniform1ui::_allocator.newElement();
-                            a->location                 = glGetUniformLocation(shader->program, "ObjectId");
-                            a->v0                       = object->id();
-                            subCommand->objectIdCommand = _commandsPool.newElement();
-                            subCommand->objectIdCommand->record(a);
-                        }
-                        {
-                            MeshDrawCommand meshDrawCommand = {};
-                            switch (meshMaterialPair.polygonMode) {
-                                case MeshRendererPolygonMode_POINT: meshDrawCommand.mode = GL_POINTS; break;
-                                case MeshRendererPolygonMode_LINE: meshDrawCommand.mode = GL_LINES; break;
-                                case MeshRendererPolygonMode_FILL: meshDrawCommand.mode = GL_TRIANGLES; break;
-                                default: break;
+                        auto a                = PglCall_glUseProgram::_allocator.newElement();
+                        a->program            = shader->program;
+                        command.shaderCommand = _commandsPool.newElement();
+                        command.shaderCommand->record(a);
+                    }
+                    {
+                        size_t t = 0;
+                        for (const auto& texture : material->textureData) {
+                            {
+                                PrototypeOpenglCommand* cmd = _commandsPool.newElement();
+                                auto                    a   = PglCall_glUniform1i::_allocator.newElement();
+                                a->location                 = glGetUniformLocation(shader->program, texture.c_str());
+                                a->v0                       = t;
+                                cmd->record(a);
+                                command.texturesCommand.push_back(cmd);
+                            }
+                            {
+                                PrototypeOpenglCommand* cmd = _commandsPool.newElement();
+                                auto                    a   = PglCall_glActiveTexture::_allocator.newElement();
+                                a->texture                  = GL_TEXTURE0 + t;
+                                cmd->record(a);
+                                command.texturesCommand.push_back(cmd);
+                            }
+                            {
+                                PrototypeOpenglCommand* cmd = _commandsPool.newElement();
+                                auto                    a   = PglCall_glBindTexture::_allocator.newElement();
+                                a->target                   = material->textures[t]->target;
+                                a->id                       = material->textures[t]->id;
+                                cmd->record(a);
+                                command.texturesCommand.push_back(cmd);
                             }
-                            meshDrawCommand.type  = geometry->type;
-                            meshDrawCommand.count = geometry->indexCount;
-                            subCommand->meshCommands[geometry->vao].push_back(std::move(meshDrawCommand));
+                            ++t;
                         }
                     }
-                    commandIt->second->subCommands.push_back(subCommand);
-                } else {
-                    OrderedDrawCommand* mainCommand = _orderedCommandsPool.newElement();
                     {
+                        // base color
                         {
-                            auto a                     = PglCall_glUseProgram::_allocator.newElement();
-                            a->program                 = shader->program;
-                            mainCommand->shaderCommand = _commandsPool.newElement();
-                            mainCommand->shaderCommand->record(a);
-                        }
+                            PrototypeOpenglCommand* cmd = _commandsPool.newElement();
+                            auto                    a   = PglCall_glUniform3fv::_allocator.newElement();
+                            a->location                 = glGetUniformLocation(shader->program, "BaseColor");
+                            a->count                    = 1;
+                            a->value                    = (GLfloat*)&material->baseColor[0];
+                            cmd->record(a);
+                            command.vec3sCommand.push_back(cmd);
+                        };
+                        // metallic
                         {
-                            size_t t = 0;
-                            for (const auto& texture : material->textureData) {
-                                {
-                                    PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                                    auto                    a   = PglCall_glUniform1i::_allocator.newElement();
-                                    a->location                 = glGetUniformLocation(shader->program, texture.c_str());
-                                    a->v0                       = t;
-                                    cmd->record(a);
-                                    mainCommand->texturesCommand.push_back(cmd);
-                                }
-                                {
-                                    PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                                    auto                    a   = PglCall_glActiveTexture::_allocator.newElement();
-                                    a->texture                  = GL_TEXTURE0 + t;
-                                    cmd->record(a);
-                                    mainCommand->texturesCommand.push_back(cmd);
-                                }
-                                {
-                                    PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                                    auto                    a   = PglCall_glBindTexture::_allocator.newElement();
-                                    a->target                   = material->textures[t]->target;
-                                    a->id                       = material->textures[t]->id;
-                                    cmd->record(a);
-                                    mainCommand->texturesCommand.push_back(cmd);
-                                }
-                                ++t;
-                            }
-                        }
+                            PrototypeOpenglCommand* cmd = _commandsPool.newElement();
+                            auto                    a   = PglCall_glUniform1fv::_allocator.newElement();
+                            a->location                 = glGetUniformLocation(shader->program, "Metallic");
+                            a->count                    = 1;
+                            a->value                    = (GLfloat*)&material->metallic;
+                            cmd->record(a);
+                            command.floatsCommand.push_back(cmd);
+                        };
+                        // roughness
                         {
-                            // base color
+                            PrototypeOpenglCommand* cmd = _commandsPool.newElement();
+                            auto                    a   = PglCall_glUniform1fv::_allocator.newElement();
+                            a->location                 = glGetUniformLocation(shader->program, "Roughness");
+                            a->count                    = 1;
+                            a->value                    = (GLfloat*)&material->roughness;
+                            cmd->record(a);
+                            command.floatsCommand.push_back(cmd);
+                        };
+                    }
+                    {
+                        for (const auto& pair : material->vec4Data) {
                             {
                                 PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                                auto                    a   = PglCall_glUniform3fv::_allocator.newElement();
-                                a->location                 = glGetUniformLocation(shader->program, "BaseColor");
+                                auto                    a   = PglCall_glUniform4fv::_allocator.newElement();
+                                a->location                 = glGetUniformLocation(shader->program, pair.first.c_str());
                                 a->count                    = 1;
-                                a->value                    = (GLfloat*)&material->baseColor[0];
+                                a->value                    = (GLfloat*)&pair.second;
                                 cmd->record(a);
-                                mainCommand->vec3sCommand.push_back(cmd);
-                            };
-                            // metallic
+                                command.vec4sCommand.push_back(cmd);
+                            }
+                        }
+                    }
+                    {
+                        for (const auto& pair : material->vec3Data) {
                             {
                                 PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                                auto                    a   = PglCall_glUniform1fv::_allocator.newElement();
-                                a->location                 = glGetUniformLocation(shader->program, "Metallic");
+                                auto                    a   = PglCall_glUniform3fv::_allocator.newElement();
+                                a->location                 = glGetUniformLocation(shader->program, pair.first.c_str());
                                 a->count                    = 1;
-                                a->value                    = (GLfloat*)&material->metallic;
+                                a->value                    = (GLfloat*)&pair.second;
                                 cmd->record(a);
-                                mainCommand->floatsCommand.push_back(cmd);
-                            };
-                            // roughness
+                                command.vec3sCommand.push_back(cmd);
+                            }
+                        }
+                    }
+                    {
+                        for (const auto& pair : material->vec2Data) {
                             {
                                 PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                                auto                    a   = PglCall_glUniform1fv::_allocator.newElement();
-                                a->location                 = glGetUniformLocation(shader->program, "Roughness");
+                                auto                    a   = PglCall_glUniform2fv::_allocator.newElement();
+                                a->location                 = glGetUniformLocation(shader->program, pair.first.c_str());
                                 a->count                    = 1;
-                                a->value                    = (GLfloat*)&material->roughness;
+                                a->value                    = (GLfloat*)&pair.second;
                                 cmd->record(a);
-                                mainCommand->floatsCommand.push_back(cmd);
-                            };
-                        }
-                        {
-                            for (const auto& pair : material->vec4Data) {
-                                {
-                                    PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                                    auto                    a   = PglCall_glUniform4fv::_allocator.newElement();
-                                    a->location                 = glGetUniformLocation(shader->program, pair.first.c_str());
-                                    a->count                    = 1;
-                                    a->value                    = (GLfloat*)&pair.second;
-                                    cmd->record(a);
-                                    mainCommand->vec4sCommand.push_back(cmd);
-                                }
-                            }
-                        }
-                        {
-                            for (const auto& pair : material->vec3Data) {
-                                {
-                                    PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                                    auto                    a   = PglCall_glUniform3fv::_allocator.newElement();
-                                    a->location                 = glGetUniformLocation(shader->program, pair.first.c_str());
-                                    a->count                    = 1;
-                                    a->value                    = (GLfloat*)&pair.second;
-                                    cmd->record(a);
-                                    mainCommand->vec3sCommand.push_back(cmd);
-                                }
-                            }
-                        }
-                        {
-                            for (const auto& pair : material->vec2Data) {
-                                {
-                                    PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                                    auto                    a   = PglCall_glUniform2fv::_allocator.newElement();
-                                    a->location                 = glGetUniformLocation(shader->program, pair.first.c_str());
-                                    a->count                    = 1;
-                                    a->value                    = (GLfloat*)&pair.second;
-                                    cmd->record(a);
-                                    mainCommand->vec2sCommand.push_back(cmd);
-                                }
+                                command.vec2sCommand.push_back(cmd);
                             }
                         }
-                        {
-                            for (const auto& pair : material->floatData) {
-                                {
-                                    PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                                    auto                    a   = PglCall_glUniform1fv::_allocator.newElement();
-                                    a->location                 = glGetUniformLocation(shader->program, pair.first.c_str());
-                                    a->count                    = 1;
-                                    a->value                    = (GLfloat*)&pair.second;
-                                    cmd->record(a);
-                                    mainCommand->floatsCommand.push_back(cmd);
-                                }
-                            }
-                        }
-                        {
-                            OrderedDrawSubCommand* subCommand = _orderedSubCommandsPool.newElement();
+                    }
+                    {
+                        for (const auto& pair : material->floatData) {
                             {
-                                {
-                                    auto a                         = PglCall_glUniformMatrix4fv::_allocator.newElement();
-                                    a->location                    = glGetUniformLocation(shader->program, "Model");
-                                    a->count                       = 1;
-                                    a->transpose                   = 0;
-                                    a->value                       = (GLfloat*)&transform->modelScaled()[0][0];
-                                    subCommand->modelMatrixCommand = _commandsPool.newElement();
-                                    subCommand->modelMatrixCommand->record(a);
-                                }
-                                {
-                                    auto a                      = PglCall_glUniform1ui::_allocator.newElement();
-                                    a->location                 = glGetUniformLocation(shader->program, "ObjectId");
-                                    a->v0                       = object->id();
-                                    subCommand->objectIdCommand = _commandsPool.newElement();
-                                    subCommand->objectIdCommand->record(a);
-                                }
-                                {
-                                    MeshDrawCommand meshDrawCommand = {};
-                                    switch (meshMaterialPair.polygonMode) {
-                                        case MeshRendererPolygonMode_POINT: meshDrawCommand.mode = GL_POINTS; break;
-                                        case MeshRendererPolygonMode_LINE: meshDrawCommand.mode = GL_LINES; break;
-                                        case MeshRendererPolygonMode_FILL: meshDrawCommand.mode = GL_TRIANGLES; break;
-                                        default: break;
-                                    }
-                                    meshDrawCommand.type  = geometry->type;
-                                    meshDrawCommand.count = geometry->indexCount;
-                                    subCommand->meshCommands[geometry->vao].push_back(std::move(meshDrawCommand));
-                                }
+                                PrototypeOpenglCommand* cmd = _commandsPool.newElement();
+                                auto                    a   = PglCall_glUniform1fv::_allocator.newElement();
+                                a->location                 = glGetUniformLocation(shader->program, pair.first.c_str());
+                                a->count                    = 1;
+                                a->value                    = (GLfloat*)&pair.second;
+                                cmd->record(a);
+                                command.floatsCommand.push_back(cmd);
                             }
-                            mainCommand->subCommands.push_back(subCommand);
                         }
                     }
-                    orderedCommands[material->shader->program].insert({ material->name, mainCommand });
+                }
+                {
+                    OrderedDrawSubCommand subCommand = {};
+                    {
+                        auto a                        = PglCall_glUniformMatrix4fv::_allocator.newElement();
+                        a->location                   = glGetUniformLocation(shader->program, "Model");
+                        a->count                      = 1;
+                        a->transpose                  = 0;
+                        a->value                      = (GLfloat*)&transform->worldModelScaled()[0][0];
+                        subCommand.modelMatrixCommand = _commandsPool.newElement();
+                        subCommand.modelMatrixCommand->record(a);
+                    }
+                    {
+                        auto a                     = PglCall_glUniform1ui::_allocator.newElement();
+                        a->location                = glGetUniformLocation(shader->program, "ObjectId");
+                        a->v0                      = object->id();
+                        subCommand.objectIdCommand = _commandsPool.newElement();
+                        subCommand.objectIdCommand->record(a);
+                    }
+                    switch (meshMaterialPair.polygonMode) {
+                        case MeshRendererPolygonMode_POINT: subCommand.mode = GL_POINTS; break;
+                        case MeshRendererPolygonMode_LINE: subCommand.mode = GL_LINES; break;
+                        case MeshRendererPolygonMode_FILL: subCommand.mode = GL_TRIANGLES; break;
+                        default: break;
+                    }
+                    subCommand.vao   = geometry->vao;
+                    subCommand.type  = geometry->type;
+                    subCommand.count = geometry->indexCount;
+                    command.subCommands.push_back(subCommand);
                 }
             }
         }
     }
 
-    for (auto& shaderMatPair : orderedCommands) {
-        _commands.push_back(shaderMatPair.second.begin()->second->shaderCommand);
+    for (const auto& shaderMatPair : _orderedCommands) {
+        bool shaderRecorded = false;
         for (const auto& matPair : shaderMatPair.second) {
-            _commands.insert(_commands.end(), matPair.second->texturesCommand.begin(), matPair.second->texturesCommand.end());
-            _commands.insert(_commands.end(), matPair.second->vec4sCommand.begin(), matPair.second->vec4sCommand.end());
-            _commands.insert(_commands.end(), matPair.second->vec3sCommand.begin(), matPair.second->vec3sCommand.end());
-            _commands.insert(_commands.end(), matPair.second->vec2sCommand.begin(), matPair.second->vec2sCommand.end());
-            _commands.insert(_commands.end(), matPair.second->floatsCommand.begin(), matPair.second->floatsCommand.end());
-            for (auto& subCommand : matPair.second->subCommands) {
-                _commands.push_back(subCommand->modelMatrixCommand);
-                _commands.push_back(subCommand->objectIdCommand);
-                for (auto& meshPair : subCommand->meshCommands) {
-                    {
-                        PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                        auto                    a   = PglCall_glBindVertexArray::_allocator.newElement();
-                        a->index                    = meshPair.first;
-                        cmd->record(a);
-                        _commands.push_back(cmd);
-                    }
-                    {
-                        PrototypeOpenglCommand* cmd = _commandsPool.newElement();
-                        auto                    a   = PglCall_glDrawElements::_allocator.newElement();
-                        a->mode                     = meshPair.second[0].mode;  // GL_POINTS | GL_LINES | GL_TRIANGLES
-                        a->type                     = meshPair.second[0].type;  // geometry->type;
-                        a->count                    = meshPair.second[0].count; // geometry->indexCount;
-                        a->indices                  = nullptr;
-                        // a->instanceCount            = meshPair.second.size();
-                        cmd->record(a);
-                        _commands.push_back(cmd);
-                    }
+            const OrderedDrawCommand& command = matPair.second;
+            // materials that weren't drawn in this pass keep their storage for the next one
+            if (command.recordPass != _recordPass) { continue; }
+            if (!shaderRecorded) {
+                _commands.push_back(command.shaderCommand);
+                shaderRecorded = true;
+            }
+            _commands.insert(_commands.end(), command.texturesCommand.begin(), command.texturesCommand.end());
+            _commands.insert(_commands.end(), command.vec4sCommand.begin(), command.vec4sCommand.end());
+            _commands.insert(_commands.end(), command.vec3sCommand.begin(), command.vec3sCommand.end());
+            _commands.insert(_commands.end(), command.vec2sCommand.begin(), command.vec2sCommand.end());
+            _commands.insert(_commands.end(), command.floatsCommand.begin(), command.floatsCommand.end());
+            for (const auto& subCommand : command.subCommands) {
+                _commands.push_back(subCommand.modelMatrixCommand);
+                _commands.push_back(subCommand.objectIdCommand);
+                {
+                    PrototypeOpenglCommand* cmd = _commandsPool.newElement();
+                    auto                    a   = PglCall_glBindVertexArray::_allocator.newElement();
+                    a->index                    = subCommand.vao;
+                    cmd->record(a);
+                    _commands.push_back(cmd);
+                }
+                {
+                    PrototypeOpenglCommand* cmd = _commandsPool.newElement();
+                    auto                    a   = PglCall_glDrawElements::_allocator.newElement();
+                    a->mode                     = subCommand.mode;  // GL_POINTS | GL_LINES | GL_TRIANGLES
+                    a->type                     = subCommand.type;  // geometry->type;
+                    a->count                    = subCommand.count; // geometry->indexCount;
+                    a->indices                  = nullptr;
+                    cmd->record(a);
+                    _commands.push_back(cmd);
                 }
             }
         }
     }
-    for (auto selectedNode : selectedNodes) { PrototypeEngineInternalApplication::scene->addSelectedNode(selectedNode); }
+    for (auto selectedNode : _selectedNodes) { PrototypeEngineInternalApplication::scene->addSelectedNode(selectedNode); }
     _window->resetDeltaTime();
 
 #if defined(PROTOTYPE_ENABLE_PROFILER)
@@ -1061,6 +1008,7 @@ PrototypeOpenglRenderer::mapPrototypeMaterial(PrototypeMaterial* material)
 void
 PrototypeOpenglRenderer::onMeshBufferGpuUpload(PrototypeMeshBuffer* meshBuffer)
 {
+    PROTOTYPE_TRACE_FUNCTION()
 #if defined(PROTOTYPE_ENABLE_PROFILER)
     static auto profilerT1 = std::chrono::high_resolution_clock::now();
 #endif
@@ -1083,6 +1031,7 @@ PrototypeOpenglRenderer::onMeshBufferGpuUpload(PrototypeMeshBuffer* meshBuffer)
 void
 PrototypeOpenglRenderer::onShaderBufferGpuUpload(PrototypeShaderBuffer* shaderBuffer)
 {
+    PROTOTYPE_TRACE_FUNCTION()
 #if defined(PROTOTYPE_ENABLE_PROFILER)
     static auto profilerT1 = std::chrono::high_resolution_clock::now();
 #endif
@@ -1123,6 +1072,7 @@ PrototypeOpenglRenderer::onShaderBufferGpuUpload(PrototypeShaderBuffer* shaderBu
 void
 PrototypeOpenglRenderer::onTextureBufferGpuUpload(PrototypeTextureBuffer* textureBuffer)
 {
+    PROTOTYPE_TRACE_FUNCTION()
 #if defined(PROTOTYPE_ENABLE_PROFILER)
     static auto profilerT1 = std::chrono::high_resolution_clock::now();
 #endif
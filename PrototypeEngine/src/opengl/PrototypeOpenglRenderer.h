@@ -188,6 +188,31 @@ struct PrototypeOpenglRenderer final : PrototypeRenderer
     void onMaterialShaderUpdate(PglMaterial* material, PglShader* shader);
 
   private:
+    // draw of one mesh renderer entry
+    struct OrderedDrawSubCommand
+    {
+        PrototypeOpenglCommand* modelMatrixCommand;
+        PrototypeOpenglCommand* objectIdCommand;
+        GLuint                  vao;
+        GLenum                  mode;
+        GLenum                  type;
+        GLsizei                 count;
+    };
+
+    // shader and uniforms of one material followed by its draws, kept across record passes so the vectors keep their
+    // capacity, recordPass tells which pass filled them
+    struct OrderedDrawCommand
+    {
+        u64                                  recordPass    = 0;
+        PrototypeOpenglCommand*              shaderCommand = nullptr;
+        std::vector<PrototypeOpenglCommand*> texturesCommand;
+        std::vector<PrototypeOpenglCommand*> vec4sCommand;
+        std::vector<PrototypeOpenglCommand*> vec3sCommand;
+        std::vector<PrototypeOpenglCommand*> vec2sCommand;
+        std::vector<PrototypeOpenglCommand*> floatsCommand;
+        std::vector<OrderedDrawSubCommand>   subCommands;
+    };
+
 #ifdef PROTOTYPE_ENGINE_DEVELOPMENT_MODE
     PglCamera _editorGameCamera;  // => 64 bytes <=
     PglCamera _editorSceneCamera; // => 64 bytes <=
@@ -219,5 +244,9 @@ struct PrototypeOpenglRenderer final : PrototypeRenderer
     MemoryPool<PglUniformBufferObject, 10>                   _uniformBufferObjectsPool; // => 32 bytes <=
     std::vector<PrototypeOpenglCommand*>                     _commands;                 // 24 bytes
     bool                                                     _needsRecord;              // 1 byte
+
+    std::unordered_map<GLuint, std::unordered_map<std::string, OrderedDrawCommand>> _orderedCommands; // 56 bytes
+    std::vector<PrototypeSceneNode*>                                                _selectedNodes;   // 24 bytes
+    u64                                                                             _recordPass;      // 8 bytes
     //  PrototypeVideoRecorder                                   _videoRecorder;        //
 };
\ No newline at end of file
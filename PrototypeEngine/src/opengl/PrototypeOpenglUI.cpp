@@ -41,6 +41,8 @@
 
 #include <PrototypeCommon/IO.h>
 #include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/MemoryTracker.h>
+#include <PrototypeCommon/Tracer.h>
 #include <PrototypeTraitSystem/PrototypeTraitSystem.h>
 
 #define FMT_HEADER_ONLY
@@ -359,6 +361,23 @@ onColliderEditDispatch(PrototypeObject* o)
             }
             ImGui::EndDragDropTarget();
         }
+
+        const std::vector<std::string>& layerNames = Collider::layerNames();
+        ImGui::TableNextRow();
+        ImGui::TableSetColumnIndex(0);
+        ImGui::TextUnformatted("Layer");
+        ImGui::TableSetColumnIndex(1);
+        ImGui::SetNextItemWidth(ImGui::GetContentRegionAvailWidth());
+        const char* layerName = collider->layer() < layerNames.size() ? layerNames[collider->layer()].c_str() : "Default";
+        if (ImGui::BeginCombo("##collider layer", layerName, ImGuiComboFlags_None)) {
+            for (u32 layer = 0; layer < layerNames.size(); ++layer) {
+                if (ImGui::Selectable(layerNames[layer].c_str(), layer == collider->layer()) && layer != collider->layer()) {
+                    collider->setLayer(layer);
+                    PrototypeEngineInternalApplication::physics->updateColliderLayer(o);
+                }
+            }
+            ImGui::EndCombo();
+        }
         ImGui::EndTable();
     }
 
@@ -513,6 +532,24 @@ onRigidbodyEditDispatch(PrototypeObject* o)
             PrototypeEngineInternalApplication::physics->updateRigidbodyTrigger(o);
         }
 
+        ImGui::TableNextRow();
+        ImGui::TableSetColumnIndex(0);
+        ImGui::TextUnformatted("events");
+        ImGui::TableSetColumnIndex(1);
+        {
+            u32  events  = rb->events();
+            bool changed = false;
+            changed |= ImGui::CheckboxFlags("contact##events", &events, RigidbodyEvents_Contact);
+            ImGui::SameLine();
+            changed |= ImGui::CheckboxFlags("trigger##events", &events, RigidbodyEvents_Trigger);
+            ImGui::SameLine();
+            changed |= ImGui::CheckboxFlags("sleep##events", &events, RigidbodyEvents_Sleep);
+            if (changed) {
+                rb->setEvents(events);
+                PrototypeEngineInternalApplication::physics->updateRigidbodyEvents(o);
+            }
+        }
+
         ImGui::TableNextRow();
         ImGui::TableSetColumnIndex(0);
         ImGui::TextUnformatted("static");
@@ -729,10 +766,9 @@ onScriptEditDispatch(PrototypeObject* o)
                     if (ImGui::Button(fmt::format("X##script remove button {}", i).c_str(),
                                       ImVec2(ImGui::GetContentRegionAvailWidth(), 30.0f))) {
                         PrototypePipelineQueue queue = {};
-                        auto cmd      = std::make_unique<PrototypePipelineCommand_shortcutEditorRemoveScriptFromObject>();
+                        auto cmd      = queue.record<PrototypePipelineCommand_shortcutEditorRemoveScriptFromObject>();
                         cmd->object   = o;
                         cmd->codeLink = codeLinkPair.second.filepath;
-                        queue.record(std::move(cmd));
                         PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                     }
                     ImGui::PopStyleColor(4);
@@ -1593,9 +1629,8 @@ PrototypeOpenglUI::drawFrame(u32 fbid, i32 width, i32 height)
                                 }
                                 PrototypePipelineQueue queue = {};
                                 for (const auto& pair : PrototypeEngineInternalApplication::database->pluginInstances) {
-                                    auto cmd = std::make_unique<PrototypePipelineCommand_shortcutEditorCommitReloadPlugin>();
+                                    auto cmd = queue.record<PrototypePipelineCommand_shortcutEditorCommitReloadPlugin>();
                                     cmd->pluginInstance = pair.second;
-                                    queue.record(std::move(cmd));
                                 }
                                 PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                             }
@@ -1946,19 +1981,17 @@ PrototypeOpenglUI::drawFrame(u32 fbid, i32 width, i32 height)
                             if (ImGui::BeginPopupContextItem(node->name().c_str())) {
                                 if (ImGui::Selectable("Add child node")) {
                                     PrototypePipelineQueue queue = {};
-                                    auto cmd = std::make_unique<PrototypePipelineCommand_shortcutEditorAddSceneNodeToNode>();
+                                    auto cmd = queue.record<PrototypePipelineCommand_shortcutEditorAddSceneNodeToNode>();
                                     cmd->parentNode = node;
                                     cmd->position   = glm::vec3(0.0f, 2.0f, 0.0f);
                                     cmd->rotation   = glm::vec3(0.0f, 0.0f, 0.0f);
                                     cmd->dir        = glm::vec3(0.0f, 0.0f, 0.0f);
-                                    queue.record(std::move(cmd));
                                     PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                                 }
                                 if (ImGui::Selectable("Delete")) {
                                     PrototypePipelineQueue queue = {};
-                                    auto cmd  = std::make_unique<PrototypePipelineCommand_shortcutEditorRemoveSceneNode>();
+                                    auto cmd  = queue.record<PrototypePipelineCommand_shortcutEditorRemoveSceneNode>();
                                     cmd->node = node;
-                                    queue.record(std::move(cmd));
                                     PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                                 }
                                 ImGui::Separator();
@@ -1968,19 +2001,17 @@ PrototypeOpenglUI::drawFrame(u32 fbid, i32 width, i32 height)
                                                             .c_str())) {
                                         if (object->has(1ULL << itrait)) {
                                             PrototypePipelineQueue queue = {};
-                                            auto                   cmd   = std::make_unique<
+                                            auto                   cmd   = queue.record<
                                               PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
                                             cmd->object    = object;
                                             cmd->traitMask = (1ULL << itrait);
-                                            queue.record(std::move(cmd));
                                             PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                                         } else {
                                             PrototypePipelineQueue queue = {};
-                                            auto                   cmd   = std::make_unique<
+                                            auto                   cmd   = queue.record<
                                               PrototypePipelineCommand_shortcutEditorSelectedSceneNodeAddTraits>();
                                             cmd->object    = object;
                                             cmd->traitMask = (1ULL << itrait);
-                                            queue.record(std::move(cmd));
                                             PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                                         }
                                     }
@@ -2058,12 +2089,11 @@ PrototypeOpenglUI::drawFrame(u32 fbid, i32 width, i32 height)
                             if (ImGui::BeginPopupContextItem(layer->name().c_str())) {
                                 if (ImGui::Selectable("Add child node")) {
                                     PrototypePipelineQueue queue = {};
-                                    auto cmd = std::make_unique<PrototypePipelineCommand_shortcutEditorAddSceneNodeToLayer>();
+                                    auto cmd = queue.record<PrototypePipelineCommand_shortcutEditorAddSceneNodeToLayer>();
                                     cmd->parentLayer = layer;
                                     cmd->position    = glm::vec3(0.0f, 2.0f, 0.0f);
                                     cmd->rotation    = glm::vec3(0.0f, 0.0f, 0.0f);
                                     cmd->dir         = glm::vec3(0.0f, 0.0f, 0.0f);
-                                    queue.record(std::move(cmd));
                                     PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                                 }
                                 ImGui::EndPopup();
@@ -2180,6 +2210,19 @@ PrototypeOpenglUI::drawFrame(u32 fbid, i32 width, i32 height)
                 ImGuiDockNode* dockNode = ImGui::GetWindowDockNode();
                 if (dockNode) dockNode->LocalFlags |= ImGuiDockNodeFlags_NoWindowMenuButton | ImGuiDockNodeFlags_NoCloseButton;
             }
+            if (ImGui::Button(ICON_FA_SAVE " Save trace")) {
+                if (PrototypeTracer::exportChromeTrace(PROTOTYPE_LOG_PATH("trace.json"))) {
+                    PrototypeLogger::log(__FILE__, __LINE__, "Trace saved to " PROTOTYPE_LOG_PATH("trace.json"));
+                }
+            }
+            if (PrototypeMemoryTracker::enabled()) {
+                ImGui::SameLine();
+                if (ImGui::Button(ICON_FA_SAVE " Save memory snapshot")) {
+                    if (PrototypeMemoryTracker::writeSnapshot(PROTOTYPE_LOG_PATH("memory.json"))) {
+                        PrototypeLogger::log(__FILE__, __LINE__, "Memory snapshot saved to " PROTOTYPE_LOG_PATH("memory.json"));
+                    }
+                }
+            }
             auto&  timelineItems = PrototypeEngineInternalApplication::profiler->getTimelineItems();
             ImVec2 available     = ImGui::GetContentRegionAvail();
             ImVec2 graphSize(available.x, (available.y / timelineItems.size()) - (timelineItems.size() - 1));
@@ -2405,19 +2448,17 @@ PrototypeOpenglUI::drawFrame(u32 fbid, i32 width, i32 height)
                 if (ImGui::BeginPopupContextWindow(first->name().c_str())) {
                     if (ImGui::Selectable("Add child node")) {
                         PrototypePipelineQueue queue = {};
-                        auto cmd        = std::make_unique<PrototypePipelineCommand_shortcutEditorAddSceneNodeToNode>();
+                        auto cmd        = queue.record<PrototypePipelineCommand_shortcutEditorAddSceneNodeToNode>();
                         cmd->parentNode = first;
                         cmd->position   = glm::vec3(0.0f, 2.0f, 0.0f);
                         cmd->rotation   = glm::vec3(0.0f, 0.0f, 0.0f);
                         cmd->dir        = glm::vec3(0.0f, 0.0f, 0.0f);
-                        queue.record(std::move(cmd));
                         PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                     }
                     if (ImGui::Selectable("Delete")) {
                         PrototypePipelineQueue queue = {};
-                        auto                   cmd   = std::make_unique<PrototypePipelineCommand_shortcutEditorRemoveSceneNode>();
+                        auto                   cmd   = queue.record<PrototypePipelineCommand_shortcutEditorRemoveSceneNode>();
                         cmd->node                    = first;
-                        queue.record(std::move(cmd));
                         PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                     }
                     ImGui::Separator();
@@ -2428,17 +2469,15 @@ PrototypeOpenglUI::drawFrame(u32 fbid, i32 width, i32 height)
                             if (object->has(1ULL << itrait)) {
                                 PrototypePipelineQueue queue = {};
                                 auto                   cmd =
-                                  std::make_unique<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
+                                  queue.record<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
                                 cmd->object    = object;
                                 cmd->traitMask = (1ULL << itrait);
-                                queue.record(std::move(cmd));
                                 PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                             } else {
                                 PrototypePipelineQueue queue = {};
-                                auto cmd = std::make_unique<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeAddTraits>();
+                                auto cmd = queue.record<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeAddTraits>();
                                 cmd->object    = object;
                                 cmd->traitMask = (1ULL << itrait);
-                                queue.record(std::move(cmd));
                                 PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                             }
                         }
@@ -3381,7 +3420,10 @@ PrototypeOpenglUI::drawFrame(u32 fbid, i32 width, i32 height)
                                          sizeof(consoleSearchBuff))) {}
             ImGui::SameLine();
             ImGui::SetCursorPosX(posx - 55.0f);
-            if (ImGui::Button("Clear##console logs")) { PrototypeLogger::data()->logs.clear(); }
+            if (ImGui::Button("Clear##console logs")) {
+                std::lock_guard<std::mutex> lock(PrototypeLogger::data()->logsMutex);
+                PrototypeLogger::data()->logs.clear();
+            }
 
             {
                 static const float TEXT_BASE_WIDTH  = ImGui::CalcTextSize("A").x;
@@ -3390,6 +3432,7 @@ PrototypeOpenglUI::drawFrame(u32 fbid, i32 width, i32 height)
                 static ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_NoBordersInBody;
 
                 if (ImGui::BeginTable("##console table", 1, flags)) {
+                    std::lock_guard<std::mutex> lock(PrototypeLogger::data()->logsMutex);
                     for (const auto& refLog : PrototypeLogger::data()->logs) {
                         size_t matchIndex = refLog.text.find(consoleSearchBuff);
                         if (matchIndex != std::string::npos) {
@@ -3526,7 +3569,7 @@ PrototypeOpenglUI::drawFrame(u32 fbid, i32 width, i32 height)
 
             static ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_NoBordersInBody;
 
-            if (ImGui::BeginTable("##scripts table", 1, flags)) {
+            if (ImGui::BeginTable("##scripts table", 2, flags)) {
                 for (const auto& pair : PrototypeEngineInternalApplication::database->pluginInstances) {
                     size_t matchIndex = pair.second->name().find(scriptsSearchBuff);
                     if (matchIndex != std::string::npos) {
@@ -3555,6 +3598,30 @@ PrototypeOpenglUI::drawFrame(u32 fbid, i32 width, i32 height)
                             ImGui::Text("%s", pair.second->name().c_str());
                             ImGui::EndDragDropSource();
                         }
+
+                        // moving average of the time spent inside the plugin per frame, red while throttled or over budget
+                        ImGui::TableNextColumn();
+                        const PrototypePluginTimings& timings    = pair.second->timings();
+                        const f32                     budgetMs   = pair.second->budgetMs();
+                        const bool                    overBudget = budgetMs > 0.0f && timings.averageMs > budgetMs;
+                        ImGui::TextColored(ImVec4(timings.throttled || overBudget ? PROTOTYPE_RED : PROTOTYPE_LIGHTERGRAY, 1.0f),
+                                           "%.2f ms",
+                                           timings.averageMs);
+                        if (ImGui::IsItemHovered()) {
+                            ImGui::BeginTooltip();
+                            for (u32 protocol = 0; protocol < PrototypePluginProtocol_Count; ++protocol) {
+                                ImGui::Text("%s: %.3f ms in %u calls",
+                                            PrototypePluginInstance::protocolName((PrototypePluginProtocol_)protocol),
+                                            timings.frameMs[protocol],
+                                            timings.frameCalls[protocol]);
+                            }
+                            ImGui::Text("peak %.2f ms, budget %.2f ms, %u overruns%s",
+                                        timings.peakMs,
+                                        budgetMs,
+                                        timings.overruns,
+                                        timings.throttled ? ", throttled" : "");
+                            ImGui::EndTooltip();
+                        }
                     }
                 }
                 ImGui::EndTable();
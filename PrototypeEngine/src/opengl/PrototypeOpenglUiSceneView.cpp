@@ -217,7 +217,7 @@ PrototypeOpenglUiSceneView::onDrawFrame(PrototypeUIState_ state, void* awesomeFo
                     ImGuizmo::SetRect(pos.x, pos.y, siz.x, siz.y);
 
                     static glm::mat4 SelectedModelMatrix;
-                    SelectedModelMatrix = tr->modelScaled();
+                    SelectedModelMatrix = tr->worldModelScaled();
                     ImGuizmo::Manipulate(&_camera->object->getCameraTrait()->viewMatrix()[0][0],
                                          &_camera->object->getCameraTrait()->projectionMatrix()[0][0],
                                          _guizmoOperation,
@@ -227,7 +227,7 @@ PrototypeOpenglUiSceneView::onDrawFrame(PrototypeUIState_ state, void* awesomeFo
                     if (ImGuizmo::IsUsing()) {
                         state |= PrototypeUIState_GuizmoUsed;
                         _isUsingGuizmo = true;
-                        tr->setModelScaled(&SelectedModelMatrix[0][0]);
+                        tr->setWorldModelScaled(&SelectedModelMatrix[0][0]);
                         tr->updateComponentsFromMatrix();
                         if (_guizmoOperation == ImGuizmo::OPERATION::SCALE) {
                             PrototypeEngineInternalApplication::physics->scaleCollider(selectedObject, tr->scale());
@@ -19,6 +19,7 @@
 #include "../core/PrototypeEngine.h"
 #include "PrototypeOpenglWindow.h"
 #include "../core/PrototypePluginInstance.h"
+#include "../core/PrototypeRecorder.h"
 #include "../core/PrototypeDatabase.h"
 #include "../core/PrototypeScene.h"
 
@@ -95,6 +96,8 @@ PrototypeOpenglWindow::init(i32 width, i32 height)
     glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
     glfwWindowHint(GLFW_DOUBLEBUFFER, GLFW_TRUE);
     glfwWindowHint(GLFW_SAMPLES, 0);
+    // headless runs (benchmarks, replays) go as fast as they can
+    if (PrototypeEngineInternalApplication::headless) { glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); }
 
     _handle = glfwCreateWindow(
       (i32)_resolution.x, (i32)_resolution.y, "Prototype [" PROTOTYPE_TARGET_NAME "] [OPENGL]", nullptr, nullptr);
@@ -113,7 +116,7 @@ PrototypeOpenglWindow::init(i32 width, i32 height)
     glfwSetWindowMaximizeCallback(_handle, prototypeWindowGlfwMaximizedCallback);
     glfwSetWindowUserPointer(_handle, this);
     glfwMakeContextCurrent(_handle);
-    glfwSwapInterval(1);
+    glfwSwapInterval(PrototypeEngineInternalApplication::headless ? 0 : 1);
     PrototypeEngineInternalApplication::renderer = PROTOTYPE_NEW PrototypeOpenglRenderer(this);
 
     _deltaTime = 1.0f / 60.0f;
@@ -133,16 +136,24 @@ PrototypeOpenglWindow::deInit()
 void
 PrototypeOpenglWindow::setSize(i32 width, i32 height)
 {
-    prototypeWindowGlfwWindowSizeCallback(_handle, width, height);
+    if (width < 1 || height < 1) { return; }
+    onWindowResizeFn(width, height);
 }
 
 bool
 PrototypeOpenglWindow::update()
 {
-    _deltaTime = glfwGetTime() - _time;
-    _time      = glfwGetTime();
-
-    glfwPollEvents();
+    PrototypeRecorder* recorder = PrototypeEngineInternalApplication::recorder;
+    if (recorder->isReplaying()) {
+        // live events are dropped by the callbacks, the recorded ones get dispatched instead
+        glfwPollEvents();
+        if (!recorder->replayFrame(this, _time, _deltaTime)) { PrototypeEngineInternalApplication::shouldQuit = true; }
+    } else {
+        _deltaTime = glfwGetTime() - _time;
+        _time      = glfwGetTime();
+        recorder->recordFrame(_time, _deltaTime);
+        glfwPollEvents();
+    }
     glfwSwapBuffers(_handle);
     return glfwWindowShouldClose(_handle) || PrototypeEngineInternalApplication::shouldQuit;
 }
@@ -537,6 +548,7 @@ static void
 prototypeWindowGlfwWindowSizeCallback(GLFWwindow* handle, i32 width, i32 height)
 {
     if (width < 1 || height < 1) { return; }
+    if (!PrototypeEngineInternalApplication::recorder->captureWindowResize(width, height)) { return; }
     PrototypeOpenglWindow* window = static_cast<PrototypeOpenglWindow*>(glfwGetWindowUserPointer(handle));
     window->onWindowResizeFn(width, height);
 }
@@ -544,6 +556,7 @@ prototypeWindowGlfwWindowSizeCallback(GLFWwindow* handle, i32 width, i32 height)
 static void
 prototypeWindowGlfwMouseBtnCallback(GLFWwindow* handle, i32 button, i32 action, i32 mods)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureMouse(button, action, mods)) { return; }
     PrototypeOpenglWindow* window = static_cast<PrototypeOpenglWindow*>(glfwGetWindowUserPointer(handle));
     window->onMouseFn(button, action, mods);
 }
@@ -551,6 +564,7 @@ prototypeWindowGlfwMouseBtnCallback(GLFWwindow* handle, i32 button, i32 action,
 static void
 prototypeWindowGlfwCursorPosCallback(GLFWwindow* handle, f64 x, f64 y)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureMouseMove(x, y)) { return; }
     PrototypeOpenglWindow* window = static_cast<PrototypeOpenglWindow*>(glfwGetWindowUserPointer(handle));
     window->onMouseMoveFn(x, y);
 }
@@ -558,6 +572,7 @@ prototypeWindowGlfwCursorPosCallback(GLFWwindow* handle, f64 x, f64 y)
 static void
 prototypeWindowGlfwScrollCallback(GLFWwindow* handle, f64 x, f64 y)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureMouseScroll(x, y)) { return; }
     PrototypeOpenglWindow* window = static_cast<PrototypeOpenglWindow*>(glfwGetWindowUserPointer(handle));
     window->onMouseScrollFn(x, y);
 }
@@ -565,6 +580,7 @@ prototypeWindowGlfwScrollCallback(GLFWwindow* handle, f64 x, f64 y)
 static void
 prototypeWindowGlfwKeyCallback(GLFWwindow* handle, i32 key, i32 scancode, i32 action, i32 mods)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureKeyboard(key, scancode, action, mods)) { return; }
     PrototypeOpenglWindow* window = static_cast<PrototypeOpenglWindow*>(glfwGetWindowUserPointer(handle));
     window->onKeyboardFn(key, scancode, action, mods);
 }
@@ -576,6 +592,7 @@ prototypeWindowGlfwCharCallback(GLFWwindow* handle, unsigned char c)
 static void
 prototypeWindowGlfwDropCallback(GLFWwindow* handle, i32 numFiles, const char** names)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureWindowDragDrop(numFiles, names)) { return; }
     PrototypeOpenglWindow* window = static_cast<PrototypeOpenglWindow*>(glfwGetWindowUserPointer(handle));
     window->onWindowDragDropFn(numFiles, names);
 }
@@ -583,6 +600,7 @@ prototypeWindowGlfwDropCallback(GLFWwindow* handle, i32 numFiles, const char** n
 static void
 prototypeWindowGlfwIconifyCallback(GLFWwindow* handle, int status)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureWindowIconify(status == GLFW_TRUE)) { return; }
     PrototypeOpenglWindow* window = static_cast<PrototypeOpenglWindow*>(glfwGetWindowUserPointer(handle));
     if (status == GLFW_TRUE) {
         window->onWindowIconifyFn();
@@ -594,6 +612,7 @@ prototypeWindowGlfwIconifyCallback(GLFWwindow* handle, int status)
 static void
 prototypeWindowGlfwMaximizedCallback(GLFWwindow* handle, int status)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureWindowMaximize(status == GLFW_TRUE)) { return; }
     PrototypeOpenglWindow* window = static_cast<PrototypeOpenglWindow*>(glfwGetWindowUserPointer(handle));
     if (status == GLFW_TRUE) {
         window->onWindowMaximizeFn();
@@ -23,13 +23,16 @@
 #include "../core/PrototypeRenderer.h"
 #include "../core/PrototypeScene.h"
 #include "../core/PrototypeShortcuts.h"
+#include "../core/PrototypeThreadpool.h"
 #include "../core/PrototypeWindow.h"
 
 #include "../core/PrototypeUI.h"
 
 #include <PrototypeTraitSystem/PrototypeTraitSystem.h>
 
+#include <PrototypeCommon/FrameArena.h>
 #include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/MemoryTracker.h>
 
 #include <GLFW/glfw3.h>
 
@@ -43,31 +46,170 @@
 #include <snippetcommon/SnippetPrint.h>
 #include <snippetutils/SnippetUtils.h>
 
+#include <algorithm>
+#include <thread>
+
+#define PROTOTYPE_PHYSX_LAYER_BITS   0xffu // low byte of the simulation filter data word3, the collision layer
+#define PROTOTYPE_PHYSX_EVENTS_SHIFT 8     // RigidbodyEvents_ bits above it
+// contact points read back per found pair, the first one is reported and the impulses of all of them summed
+#define PROTOTYPE_PHYSX_EVENT_CONTACT_POINTS 8
+
 #define PVD_HOST "127.0.0.1" // the IP address of the system running the PhysX Visual Debugger that you want to connect to.
 
-PxDefaultAllocator                                                PrototypePhysxPhysics::gAllocator;
-PrototypePhysxEventsCallback*                                     PrototypePhysxPhysics::gEventsCallback         = nullptr;
-PxFoundation*                                                     PrototypePhysxPhysics::gFoundation             = nullptr;
-PxPhysics*                                                        PrototypePhysxPhysics::gPhysics                = nullptr;
-PxDefaultCpuDispatcher*                                           PrototypePhysxPhysics::gDispatcher             = nullptr;
-PxCooking*                                                        PrototypePhysxPhysics::gCooking                = nullptr;
-PxScene*                                                          PrototypePhysxPhysics::gScene                  = nullptr;
-PxMaterial*                                                       PrototypePhysxPhysics::gMaterial               = nullptr;
-PxPvd*                                                            PrototypePhysxPhysics::gPvd                    = nullptr;
-snippetvehicle::VehicleSceneQueryData*                            PrototypePhysxPhysics::gVehicleSceneQueryData  = nullptr;
-physx::PxBatchQuery*                                              PrototypePhysxPhysics::gBatchQuery             = nullptr;
-physx::PxVehicleDrivableSurfaceToTireFrictionPairs*               PrototypePhysxPhysics::gFrictionPairs          = nullptr;
-physx::PxVehicleDrive4W**                                         PrototypePhysxPhysics::gVehicles               = nullptr;
-physx::PxVehicleDrive4WRawInputData*                              PrototypePhysxPhysics::gVehicleInputData       = nullptr;
-size_t*                                                           PrototypePhysxPhysics::gNumVehicles            = nullptr;
-size_t*                                                           PrototypePhysxPhysics::gControlledVehicleIndex = nullptr;
-std::array<PxWheelQueryResult, PROTOTYPE_MAX_NUM_VEHICLES * 4>    PrototypePhysxPhysics::gWheelQueryResults;
-std::array<PxVehicleWheelQueryResult, PROTOTYPE_MAX_NUM_VEHICLES> PrototypePhysxPhysics::gVehiclesQueryResults;
-bool                                                              PrototypePhysxPhysics::_isPlaying = true;
-std::unordered_map<std::string, PhysxSceneData>                   PrototypePhysxPhysics::_scenes;
+PrototypePhysxAllocator                             PrototypePhysxPhysics::gAllocator;
+PrototypePhysxEventsCallback*                       PrototypePhysxPhysics::gEventsCallback         = nullptr;
+PxFoundation*                                       PrototypePhysxPhysics::gFoundation             = nullptr;
+PxPhysics*                                          PrototypePhysxPhysics::gPhysics                = nullptr;
+PrototypePhysxCpuDispatcher*                        PrototypePhysxPhysics::gDispatcher             = nullptr;
+PxCooking*                                          PrototypePhysxPhysics::gCooking                = nullptr;
+PxScene*                                            PrototypePhysxPhysics::gScene                  = nullptr;
+PxMaterial*                                         PrototypePhysxPhysics::gMaterial               = nullptr;
+PxPvd*                                              PrototypePhysxPhysics::gPvd                    = nullptr;
+physx::PxVehicleDrivableSurfaceToTireFrictionPairs* PrototypePhysxPhysics::gFrictionPairs          = nullptr;
+PhysxSceneData*                                     PrototypePhysxPhysics::gSceneData              = nullptr;
+std::vector<physx::PxVehicleDrive4W*>*              PrototypePhysxPhysics::gVehicles               = nullptr;
+std::vector<PrototypeObject*>*                      PrototypePhysxPhysics::gVehicleObjects         = nullptr;
+std::vector<physx::PxVehicleDrive4WRawInputData>*   PrototypePhysxPhysics::gVehicleInputData       = nullptr;
+size_t*                                             PrototypePhysxPhysics::gControlledVehicleIndex = nullptr;
+std::mutex                                          PrototypePhysxPhysics::gVehicleInputsLock;
+std::vector<PrototypeObject*>                       PrototypePhysxPhysics::gPhysicsSyncObjects;
+std::vector<PxActor*>                               PrototypePhysxPhysics::gPendingActors;
+bool                                                PrototypePhysxPhysics::gActorBatch = false;
+bool                                                PrototypePhysxPhysics::_isPlaying = true;
+std::unordered_map<std::string, PhysxSceneData>     PrototypePhysxPhysics::_scenes;
+
+std::unordered_map<std::string, PrototypePhysicsSceneActivity> PrototypePhysxPhysics::_sceneActivities;
+std::vector<PhysxSceneStep>                                    PrototypePhysxPhysics::gSceneSteps;
 
 PxDefaultErrorCallback defaultErrorCallback;
 
+// below this many queries per slice the dispatch overhead outweighs running them on the calling thread
+static const size_t PrototypePhysxQuerySliceMinSize = 64;
+
+static void
+PrototypePhysxFillQueryHit(const PxLocationHit& block, PrototypePhysicsQueryHit& hit)
+{
+    hit.object   = block.actor ? (PrototypeObject*)block.actor->userData : nullptr;
+    hit.position = { block.position.x, block.position.y, block.position.z };
+    hit.normal   = { block.normal.x, block.normal.y, block.normal.z };
+    hit.distance = block.distance;
+}
+
+// scene queries only read the scene so the slices of a batch can run concurrently outside of simulate/fetchResults
+static void
+PrototypePhysxRunQueries(PxScene* scene, const PrototypePhysicsQuery* queries, size_t count, PrototypePhysicsQueryHit* hits)
+{
+    for (size_t i = 0; i < count; ++i) {
+        const PrototypePhysicsQuery& query = queries[i];
+        PrototypePhysicsQueryHit&    hit   = hits[i];
+        hit.object                         = nullptr;
+        hit.position                       = glm::vec3(0.0f);
+        hit.normal                         = glm::vec3(0.0f);
+        hit.distance                       = 0.0f;
+
+        PxQueryFlags flags;
+        if (query.filterMask & PrototypePhysicsQueryFilter_Static) { flags |= PxQueryFlag::eSTATIC; }
+        if (query.filterMask & PrototypePhysicsQueryFilter_Dynamic) { flags |= PxQueryFlag::eDYNAMIC; }
+        if (!flags) { continue; }
+        // word0 of the shapes query filter data is their layer bit, a zero mask leaves the query unfiltered
+        const PxFilterData layerFilterData(query.layerMask, 0, 0, 0);
+
+        const PxVec3 origin(query.origin.x, query.origin.y, query.origin.z);
+        const PxVec3 direction = PxVec3(query.direction.x, query.direction.y, query.direction.z).getNormalized();
+        switch (query.type) {
+            case PrototypePhysicsQueryType_Ray: {
+                if (direction.isZero()) { break; }
+                PxRaycastBuffer buffer;
+                if (scene->raycast(origin,
+                                   direction,
+                                   query.length,
+                                   buffer,
+                                   PxHitFlag::eDEFAULT,
+                                   PxQueryFilterData(layerFilterData, flags))) {
+                    PrototypePhysxFillQueryHit(buffer.block, hit);
+                }
+            } break;
+            case PrototypePhysicsQueryType_Sweep: {
+                if (direction.isZero()) { break; }
+                PxSweepBuffer buffer;
+                if (scene->sweep(PxSphereGeometry(query.radius),
+                                 PxTransform(origin),
+                                 direction,
+                                 query.length,
+                                 buffer,
+                                 PxHitFlag::eDEFAULT,
+                                 PxQueryFilterData(layerFilterData, flags))) {
+                    PrototypePhysxFillQueryHit(buffer.block, hit);
+                }
+            } break;
+            case PrototypePhysicsQueryType_Overlap: {
+                PxOverlapBuffer buffer;
+                if (scene->overlap(PxSphereGeometry(query.radius),
+                                   PxTransform(origin),
+                                   buffer,
+                                   PxQueryFilterData(layerFilterData, flags | PxQueryFlag::eANY_HIT))) {
+                    hit.object   = buffer.block.actor ? (PrototypeObject*)buffer.block.actor->userData : nullptr;
+                    hit.position = query.origin;
+                }
+            } break;
+            default: PrototypeLogger::warn("Unknown physics query type %u", query.type); break;
+        }
+    }
+}
+
+void
+PrototypePhysxQueryTask::run()
+{
+    PrototypePhysxRunQueries(scene, queries, count, hits);
+}
+
+const char*
+PrototypePhysxQueryTask::getName() const
+{
+    return "PrototypePhysxQueryTask";
+}
+
+PrototypePhysxCpuDispatcher::PrototypePhysxCpuDispatcher(PrototypeThreadpool* threadpool)
+  : _threadpool(threadpool)
+{}
+
+void
+PrototypePhysxCpuDispatcher::submitTask(PxBaseTask& task)
+{
+    _threadpool->submit(
+      [&task]() {
+          task.run();
+          task.release();
+      },
+      PrototypeThreadpoolPriority_High);
+}
+
+PxU32
+PrototypePhysxCpuDispatcher::getWorkerCount() const
+{
+    return (PxU32)_threadpool->numThreads();
+}
+
+void
+PrototypePhysxTask::addReference()
+{}
+
+void
+PrototypePhysxTask::removeReference()
+{}
+
+int32_t
+PrototypePhysxTask::getReference() const
+{
+    return 1;
+}
+
+void
+PrototypePhysxTask::release()
+{
+    pending->fetch_sub(1, std::memory_order_release);
+}
+
 PxFilterFlags
 PrototypeFilterShader(PxFilterObjectAttributes attributes0,
                       PxFilterData             filterData0,
@@ -77,11 +219,21 @@ PrototypeFilterShader(PxFilterObjectAttributes attributes0,
                       const void*              constantBlock,
                       PxU32                    constantBlockSize)
 {
-    PX_UNUSED(constantBlock);
-    PX_UNUSED(constantBlockSize);
+    // the constant block is the collision layers matrix of the scene, word3 of the simulation filter data is the shape layer,
+    // pairs of layers that never interact are killed so the broadphase stops reporting them until they separate
+    if (constantBlockSize == sizeof(u32) * PROTOTYPE_MAX_COLLISION_LAYERS) {
+        const u32* matrix = static_cast<const u32*>(constantBlock);
+        const u32  layer0 = (filterData0.word3 & PROTOTYPE_PHYSX_LAYER_BITS) % PROTOTYPE_MAX_COLLISION_LAYERS;
+        const u32  layer1 = (filterData1.word3 & PROTOTYPE_PHYSX_LAYER_BITS) % PROTOTYPE_MAX_COLLISION_LAYERS;
+        if (0 == (matrix[layer0] & (1u << layer1))) return PxFilterFlag::eKILL;
+    }
+
+    // the rest of word3 holds the RigidbodyEvents_ the shapes opted in to, a pair reports if either side asked for it
+    const u32 events = (filterData0.word3 | filterData1.word3) >> PROTOTYPE_PHYSX_EVENTS_SHIFT;
 
-    // let triggers through
+    // triggers only exist to report, nobody listens to this one
     if (PxFilterObjectIsTrigger(attributes0) || PxFilterObjectIsTrigger(attributes1)) {
+        if (0 == (events & RigidbodyEvents_Trigger)) return PxFilterFlag::eSUPPRESS;
         pairFlags = PxPairFlag::eTRIGGER_DEFAULT;
         return PxFilterFlag::eDEFAULT;
     }
@@ -91,6 +243,9 @@ PrototypeFilterShader(PxFilterObjectAttributes attributes0,
 
     pairFlags = PxPairFlag::eCONTACT_DEFAULT;
     pairFlags |= PxPairFlags(PxU16(filterData0.word2 | filterData1.word2));
+    if (events & RigidbodyEvents_Contact) {
+        pairFlags |= PxPairFlag::eNOTIFY_TOUCH_FOUND | PxPairFlag::eNOTIFY_TOUCH_LOST | PxPairFlag::eNOTIFY_CONTACT_POINTS;
+    }
 
     return PxFilterFlags();
 }
@@ -138,6 +293,37 @@ PxVehiclePadSmoothingData gPadSmoothingData = { {
                                                   5.0f   // fall rate eANALOG_INPUT_STEER_RIGHT
                                                 } };
 
+void
+PrototypePhysxVehicleBatch::run()
+{
+    PhysxSceneData&   data     = *sceneData;
+    PxVehicleWheels** vehicles = (PxVehicleWheels**)&data.vehicles[begin];
+    const PxU32       count    = (PxU32)(end - begin);
+    for (size_t i = begin; i < end; ++i) {
+        PxVehicleDrive4WSmoothAnalogRawInputsAndSetAnalogInputs(gPadSmoothingData,
+                                                                gSteerVsForwardSpeedTable,
+                                                                data.vehicleInputData[i],
+                                                                timestep,
+                                                                PxVehicleIsInAir(data.vehicleQueryResults[i]),
+                                                                *data.vehicles[i]);
+    }
+    PxVehicleSuspensionRaycasts(
+      batchQuery, count, vehicles, sceneQueryData->getQueryResultBufferSize(), sceneQueryData->getRaycastQueryResultBuffer(0));
+    PxVehicleUpdates(timestep,
+                     data.scene->getGravity(),
+                     *data.frictionPairs,
+                     count,
+                     vehicles,
+                     &data.vehicleQueryResults[begin],
+                     &data.vehicleConcurrentUpdates[begin]);
+}
+
+const char*
+PrototypePhysxVehicleBatch::getName() const
+{
+    return "PrototypePhysxVehicleBatch";
+}
+
 enum DriveMode
 {
     eDRIVE_MODE_ACCEL_FORWARDS = 0,
@@ -210,19 +396,178 @@ PrototypePhysxPhysics::vehicleInitDesc()
 void
 PrototypePhysxPhysics::vehicleReleaseAllControls(size_t vehicleIndex)
 {
-    gVehicleInputData[vehicleIndex].setAnalogAccel(0.0f);
-    gVehicleInputData[vehicleIndex].setAnalogSteer(0.0f);
-    gVehicleInputData[vehicleIndex].setAnalogBrake(0.0f);
-    gVehicleInputData[vehicleIndex].setAnalogHandbrake(0.0f);
+    (*gVehicleInputData)[vehicleIndex].setAnalogAccel(0.0f);
+    (*gVehicleInputData)[vehicleIndex].setAnalogSteer(0.0f);
+    (*gVehicleInputData)[vehicleIndex].setAnalogBrake(0.0f);
+    (*gVehicleInputData)[vehicleIndex].setAnalogHandbrake(0.0f);
+}
+
+void
+PrototypePhysxPhysics::vehicleApplyInputs(PhysxSceneData& sceneData)
+{
+    size_t readIndex;
+    {
+        std::lock_guard<std::mutex> lock(gVehicleInputsLock);
+        readIndex                         = sceneData.vehicleInputsWriteIndex;
+        sceneData.vehicleInputsWriteIndex = 1 - readIndex;
+    }
+    std::vector<PhysxVehicleInput>& inputs = sceneData.vehicleInputs[readIndex];
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        if (!inputs[i].dirty) { continue; }
+        sceneData.vehicleInputData[i].setAnalogAccel(inputs[i].acceleration);
+        sceneData.vehicleInputData[i].setAnalogBrake(inputs[i].brake);
+        sceneData.vehicleInputData[i].setAnalogSteer(inputs[i].steer);
+        inputs[i].dirty = false;
+    }
+}
+
+void
+PrototypePhysxPhysics::vehicleSubmitBatches(PhysxSceneData& sceneData, f32 timestep, std::atomic<size_t>& pending)
+{
+    const size_t numVehicles = sceneData.vehicles.size();
+    const size_t numBatches  = sceneData.vehicleBatches.size();
+    pending.fetch_add(numBatches, std::memory_order_relaxed);
+    for (size_t b = 0; b < numBatches; ++b) {
+        const size_t                begin = b * PROTOTYPE_PHYSX_VEHICLE_BATCH_SIZE;
+        PrototypePhysxVehicleBatch* batch = sceneData.vehicleBatches[b];
+        batch->begin                      = begin;
+        batch->end                        = std::min(begin + PROTOTYPE_PHYSX_VEHICLE_BATCH_SIZE, numVehicles);
+        batch->timestep                   = timestep;
+        batch->pending                    = &pending;
+        gDispatcher->submitTask(*batch);
+    }
+}
+
+void
+PrototypePhysxPhysics::vehiclePostUpdates(PhysxSceneData& sceneData)
+{
+    const size_t numVehicles = sceneData.vehicles.size();
+    // the batches only wrote the concurrent update data, apply it to the actors now that no task touches them
+    PxVehiclePostUpdates(
+      sceneData.vehicleConcurrentUpdates.data(), (PxU32)numVehicles, (PxVehicleWheels**)sceneData.vehicles.data());
+    for (size_t i = 0; i < numVehicles; ++i) { vehicleSyncTransforms(sceneData, i); }
+}
+
+void
+PrototypePhysxPhysics::pullActiveActors(PxScene* scene)
+{
+    // only the actors that moved during this step are reported, sleeping bodies cost nothing
+    PxU32     numActiveActors = 0;
+    PxActor** activeActors    = scene->getActiveActors(numActiveActors);
+    for (PxU32 i = 0; i < numActiveActors; ++i) {
+        PrototypeObject* object = static_cast<PrototypeObject*>(activeActors[i]->userData);
+        if (!object || object->hasVehicleChasisTrait() || !object->hasRigidbodyTrait()) { continue; }
+        PxRigidDynamic* rigidDynamicActor = activeActors[i]->is<PxRigidDynamic>();
+        if (!rigidDynamicActor || object->getTransformTrait()->needsPhysicsSync()) { continue; }
+        bool isSelected = static_cast<PrototypeSceneNode*>(object->parentNode())->isSelected();
+        pullRigidbody(object, rigidDynamicActor, isSelected);
+    }
+}
+
+f32
+PrototypePhysxPhysics::sceneTimestep(const std::string& sceneName, f32 deltaTime)
+{
+    auto it = _sceneActivities.find(sceneName);
+    if (it == _sceneActivities.end()) { return deltaTime; }
+    PrototypePhysicsSceneActivity& activity = it->second;
+    switch (activity.activity) {
+        case PrototypePhysicsSceneActivity_Paused: return 0.0f;
+        case PrototypePhysicsSceneActivity_Throttled: {
+            activity.accumulator += deltaTime;
+            if (activity.rate <= 0.0f || activity.accumulator < 1.0f / activity.rate) { return 0.0f; }
+            const f32 timestep   = activity.accumulator;
+            activity.accumulator = 0.0f;
+            return timestep;
+        }
+        default: return deltaTime;
+    }
+}
+
+void
+PrototypePhysxPhysics::vehicleSyncTransforms(PhysxSceneData& sceneData, size_t vehicleIndex)
+{
+    PrototypeObject* vehicleObject = sceneData.vehicleObjects[vehicleIndex];
+    VehicleChasis*   vehicleChasis = vehicleObject->getVehicleChasisTrait();
+    if (!vehicleChasis->wheelBLObject() || !vehicleChasis->wheelBRObject() || !vehicleChasis->wheelFLObject() ||
+        !vehicleChasis->wheelFRObject()) {
+        return;
+    }
+    physx::PxRigidDynamic* chasisActor = sceneData.vehicles[vehicleIndex]->getRigidDynamicActor();
+    if (chasisActor->isSleeping()) { return; }
+
+    Transform* chasisTr = vehicleObject->getTransformTrait();
+    PxMat44    chasisMat(chasisActor->getGlobalPose());
+    chasisTr->setModel(chasisMat.front());
+
+    // wheels order in the query results is FR, FL, BR, BL
+    PrototypeObject* wheelObjects[4] = { vehicleChasis->wheelFRObject(),
+                                         vehicleChasis->wheelFLObject(),
+                                         vehicleChasis->wheelBRObject(),
+                                         vehicleChasis->wheelBLObject() };
+    for (size_t w = 0; w < 4; ++w) {
+        Transform* wheelTr = wheelObjects[w]->getTransformTrait();
+        PxMat44    wheelMat(sceneData.wheelQueryResults[vehicleIndex * 4 + w].localPose);
+        wheelTr->setModel(wheelMat.front());
+        wheelMat = chasisMat * wheelMat;
+        wheelTr->setModelScaled(wheelMat.front());
+    }
+    chasisTr->setModelScaled(chasisMat.front());
+}
+
+void
+PrototypePhysxPhysics::pullRigidbody(PrototypeObject* object, PxRigidDynamic* rigidDynamicActor, bool syncVelocities)
+{
+    Transform*        tr   = object->getTransformTrait();
+    const PxTransform pose = rigidDynamicActor->getGlobalPose();
+    tr->setWorldPose({ pose.p.x, pose.p.y, pose.p.z }, glm::quat(pose.q.w, pose.q.x, pose.q.y, pose.q.z));
+    if (syncVelocities) {
+        Rigidbody* rb                  = object->getRigidbodyTrait();
+        PxVec3     tempLinearVelocity  = rigidDynamicActor->getLinearVelocity();
+        PxVec3     tempAngularVelocity = rigidDynamicActor->getAngularVelocity();
+        rb->setLinearVelocity(*((glm::vec3*)&tempLinearVelocity));
+        rb->setLinearDamping(rigidDynamicActor->getLinearDamping());
+        rb->setAngularVelocity(*((glm::vec3*)&tempAngularVelocity));
+        rb->setAngularDamping(rigidDynamicActor->getAngularDamping());
+    }
+}
+
+void
+PrototypePhysxPhysics::pushRigidbody(Transform* tr, PxRigidActor* actor)
+{
+    auto m = (PxMat44*)(&tr->worldModel()[0][0]);
+    actor->setGlobalPose(PxTransform(*m));
+    tr->setNeedsPhysicsSync(false);
+}
+
+void PROTOTYPE_DYNAMIC_FN_CALL
+PrototypePhysxPhysics::onTransformPhysicsSync(PrototypeObject* object)
+{
+    if (object && object->hasRigidbodyTrait()) { gPhysicsSyncObjects.push_back(object); }
+}
+
+void
+PrototypePhysxPhysics::shapeSetFilterData(PxShape* shape, u32 layer, u32 events)
+{
+    PxFilterData simFilterData = shape->getSimulationFilterData();
+    simFilterData.word3        = layer | (events << PROTOTYPE_PHYSX_EVENTS_SHIFT);
+    shape->setSimulationFilterData(simFilterData);
+    PxFilterData qryFilterData = shape->getQueryFilterData();
+    qryFilterData.word0        = 1u << layer;
+    shape->setQueryFilterData(qryFilterData);
+    // sleep notifications are per actor, the shapes are exclusive so the actor is always there
+    PxRigidActor* actor = shape->getActor();
+    if (actor) { actor->setActorFlag(PxActorFlag::eSEND_SLEEP_NOTIFIES, (events & RigidbodyEvents_Sleep) != 0); }
 }
 
 PrototypePhysxPhysics::PrototypePhysxPhysics()
   : _needsRecord(true)
+  , _lockstep({ false, 1.0f / 60.0f })
 {}
 
 bool
 PrototypePhysxPhysics::init()
 {
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Physics)
     gFoundation = PxCreateFoundation(PX_PHYSICS_VERSION, gAllocator, defaultErrorCallback);
     if (!gFoundation) PrototypeLogger::fatal("PxCreateFoundation failed!");
 
@@ -240,9 +585,7 @@ PrototypePhysxPhysics::init()
     gCooking = PxCreateCooking(PX_PHYSICS_VERSION, *gFoundation, PxCookingParams(gCookingParams));
     if (!gCooking) PrototypeLogger::fatal("PxCreateCooking failed!");
 
-    PxU32 numWorkers = std::thread::hardware_concurrency();
-    numWorkers       = numWorkers == 0 ? 0 : numWorkers - 1;
-    gDispatcher      = PxDefaultCpuDispatcherCreate(numWorkers);
+    gDispatcher = PROTOTYPE_NEW PrototypePhysxCpuDispatcher(PrototypeEngineInternalApplication::threadpool);
 
     gMaterial = gPhysics->createMaterial(0.5f, 0.5f, 0.6f); // , , jumping reaction
 
@@ -251,12 +594,8 @@ PrototypePhysxPhysics::init()
     PxVehicleSetBasisVectors(PxVec3(0, 1, 0), PxVec3(0, 0, -1));
     PxVehicleSetUpdateMode(PxVehicleUpdateMode::eVELOCITY_CHANGE);
 
-    for (size_t i = 0; i < PROTOTYPE_MAX_NUM_VEHICLES; ++i) {
-        gVehiclesQueryResults[i].nbWheelQueryResults = 4;
-        gVehiclesQueryResults[i].wheelQueryResults   = &gWheelQueryResults[i * 4];
-    }
-
     PrototypePhysxPhysics::gEventsCallback = PROTOTYPE_NEW PrototypePhysxEventsCallback();
+    Transform::setOnPhysicsSyncHandler(onTransformPhysicsSync);
 
     return true;
 }
@@ -264,13 +603,16 @@ PrototypePhysxPhysics::init()
 void
 PrototypePhysxPhysics::deInit()
 {
-    for (auto pair : _scenes) {
-        for (size_t i = 0; i < pair.second.numVehicles; ++i) {
-            pair.second.vehicles[i]->getRigidDynamicActor()->release();
-            pair.second.vehicles[i]->free();
+    for (auto& pair : _scenes) {
+        for (PxVehicleDrive4W* vehicle : pair.second.vehicles) {
+            vehicle->getRigidDynamicActor()->release();
+            vehicle->free();
+        }
+        for (PrototypePhysxVehicleBatch* batch : pair.second.vehicleBatches) {
+            PX_RELEASE(batch->batchQuery);
+            batch->sceneQueryData->free(gAllocator);
+            delete batch;
         }
-        PX_RELEASE(pair.second.batchQuery);
-        pair.second.vehicleSceneQueryData->free(gAllocator);
         PX_RELEASE(pair.second.frictionPairs);
     }
     PxCloseVehicleSDK();
@@ -284,7 +626,13 @@ PrototypePhysxPhysics::deInit()
     }
     _scenes.clear();
 
-    PX_RELEASE(gDispatcher)
+    Transform::setOnPhysicsSyncHandler(nullptr);
+    gPhysicsSyncObjects.clear();
+    gSceneSteps.clear();
+    _sceneActivities.clear();
+    _queryBatches.clear();
+    delete gDispatcher;
+    gDispatcher = nullptr;
     PX_RELEASE(gPhysics)
 #if defined(PROTOTYPE_DEBUG_PHYSX)
     if (gPvd) {
@@ -315,153 +663,60 @@ PrototypePhysxPhysics::pause()
 bool
 PrototypePhysxPhysics::update()
 {
+    // the scripts consumed the previous update's events before this update
+    gEventsCallback->events.clear();
     if (_isPlaying) {
-        f32 timestep = (f32)PrototypeEngineInternalApplication::window->deltaTime();
-        // TODO:
-        // Select the correct scene using the provided PrototypeScene
-        // static f32 rate = 1.0f / PrototypeEngineInternalApplication::window->refreshRate();
-        gScene->simulate(timestep);
-        auto colliderObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(
-          PrototypeTraitTypeMaskCollider | PrototypeTraitTypeMaskTransform | PrototypeTraitTypeMaskRigidbody);
-
-        auto vehicleObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(
-          PrototypeTraitTypeMaskTransform | PrototypeTraitTypeMaskVehicleChasis);
-        gScene->fetchResults(true);
-
-        if (*gNumVehicles > 0) {
-            // Raycasts.
-            PxRaycastQueryResult* raycastResults     = gVehicleSceneQueryData->getRaycastQueryResultBuffer(0);
-            const PxU32           raycastResultsSize = gVehicleSceneQueryData->getQueryResultBufferSize();
-            PxVehicleSuspensionRaycasts(
-              gBatchQuery, *gNumVehicles, (PxVehicleWheels**)gVehicles, raycastResultsSize, raycastResults);
-
-            // Vehicle update.
-            const PxVec3 grav = gScene->getGravity();
-            // PxWheelQueryResult        wheelQueryResults[4];
-            // PxVehicleWheelQueryResult vehicleQueryResults[1] = { { wheelQueryResults,
-            //                                                        gVehicles[voi]->mWheelsSimData.getNbWheels() } };
-            PxVehicleUpdates(
-              timestep, grav, *gFrictionPairs, *gNumVehicles, (PxVehicleWheels**)gVehicles, gVehiclesQueryResults.data());
-
-            {
-                auto vehicleObjectIt = vehicleObjects.begin();
-                std::advance(vehicleObjectIt, *gControlledVehicleIndex);
-                PrototypeObject* vehicleObject = *vehicleObjectIt;
-                VehicleChasis*   vehicleChasis = vehicleObject->getVehicleChasisTrait();
-                if (vehicleChasis->wheelBLObject() && vehicleChasis->wheelBRObject() && vehicleChasis->wheelFLObject() &&
-                    vehicleChasis->wheelFRObject()) {
-                    size_t vehicleIndex   = vehicleChasis->vehicleIndex();
-                    bool   vehicleIsInAir = false;
-                    // Update the control inputs for the vehicle.
-                    PxVehicleDrive4WSmoothAnalogRawInputsAndSetAnalogInputs(gPadSmoothingData,
-                                                                            gSteerVsForwardSpeedTable,
-                                                                            gVehicleInputData[vehicleIndex],
-                                                                            timestep,
-                                                                            vehicleIsInAir,
-                                                                            *gVehicles[vehicleIndex]);
-                    // Work out if the vehicle is in the air.
-                    // vehicleIsInAir = gVehicles[*gControlledVehicleIndex]->getRigidDynamicActor()->isSleeping()
-                    //                    ? false
-                    //                    : PxVehicleIsInAir(gVehiclesQueryResults[*gControlledVehicleIndex]);
+        f32 deltaTime = _lockstep.enabled ? _lockstep.timestep : (f32)PrototypeEngineInternalApplication::window->deltaTime();
+        PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Physics)
+
+        // simulate() only kicks the step off on the dispatcher, so every due scene gets going before any of them is
+        // waited on and their tasks interleave on the threadpool, fetching the results is what blocks
+        gSceneSteps.clear();
+        for (auto& pair : _scenes) {
+            const f32 timestep = sceneTimestep(pair.first, deltaTime);
+            if (timestep <= 0.0f) { continue; }
+            pair.second.scene->simulate(timestep);
+            gSceneSteps.push_back({ &pair.second, timestep });
+        }
+        // running tasks are never preempted, so rather than blocking in fetchResults while every worker may still be busy
+        // with a background job the main thread runs the step tasks itself until the step completes
+        for (const PhysxSceneStep& step : gSceneSteps) {
+            while (!step.sceneData->scene->checkResults(false)) {
+                if (!PrototypeEngineInternalApplication::threadpool->help(PrototypeThreadpoolPriority_High)) {
+                    std::this_thread::yield();
                 }
             }
+            step.sceneData->scene->fetchResults(true);
+        }
 
-            for (size_t i = 0; i < *gNumVehicles; ++i) {
-                auto vehicleObjectIt = vehicleObjects.begin();
-                std::advance(vehicleObjectIt, i);
-                PrototypeObject* vehicleObject = *vehicleObjectIt;
-                VehicleChasis*   vehicleChasis = vehicleObject->getVehicleChasisTrait();
-                if (vehicleChasis->wheelBLObject() && vehicleChasis->wheelBRObject() && vehicleChasis->wheelFLObject() &&
-                    vehicleChasis->wheelFRObject()) {
-                    physx::PxVehicleDrive4W* veh         = (physx::PxVehicleDrive4W*)vehicleChasis->vehicleRef();
-                    physx::PxRigidDynamic*   chasisActor = veh->getRigidDynamicActor();
-                    if (!chasisActor->isSleeping()) {
-                        Transform* chasisTr  = vehicleObject->getTransformTrait();
-                        Transform* wheelFRTr = vehicleChasis->wheelFRObject()->getTransformTrait();
-                        Transform* wheelFLTr = vehicleChasis->wheelFLObject()->getTransformTrait();
-                        Transform* wheelBRTr = vehicleChasis->wheelBRObject()->getTransformTrait();
-                        Transform* wheelBLTr = vehicleChasis->wheelBLObject()->getTransformTrait();
-
-                        PxMat44 chasisMat = PxMat44(chasisActor->getGlobalPose());
-
-                        chasisTr->setModel(chasisMat.front());
-
-                        PxMat44 wheelFRMat = PxMat44(gWheelQueryResults[(*gControlledVehicleIndex) * 4 + 0].localPose);
-                        PxMat44 wheelFLMat = PxMat44(gWheelQueryResults[(*gControlledVehicleIndex) * 4 + 1].localPose);
-                        PxMat44 wheelBRMat = PxMat44(gWheelQueryResults[(*gControlledVehicleIndex) * 4 + 2].localPose);
-                        PxMat44 wheelBLMat = PxMat44(gWheelQueryResults[(*gControlledVehicleIndex) * 4 + 3].localPose);
-
-                        wheelFRTr->setModel(wheelFRMat.front());
-                        wheelFRMat = chasisMat * wheelFRMat;
-                        // wheelFRMat *= PxMat44(PxVec4(0.5f, 0.5f, 0.5f, 1.0f));
-                        wheelFRTr->setModelScaled(wheelFRMat.front());
-
-                        wheelFLTr->setModel(wheelFLMat.front());
-                        wheelFLMat = chasisMat * wheelFLMat;
-                        // wheelFLMat *= PxMat44(PxVec4(0.5f, 0.5f, 0.5f, 1.0f));
-                        wheelFLTr->setModelScaled(wheelFLMat.front());
-
-                        wheelBRTr->setModel(wheelBRMat.front());
-                        wheelBRMat = chasisMat * wheelBRMat;
-                        // wheelBRMat *= PxMat44(PxVec4(0.5f, 0.5f, 0.5f, 1.0f));
-                        wheelBRTr->setModelScaled(wheelBRMat.front());
-
-                        wheelBLTr->setModel(wheelBLMat.front());
-                        wheelBLMat = chasisMat * wheelBLMat;
-                        // wheelBLMat *= PxMat44(PxVec4(0.5f, 0.5f, 0.5f, 1.0f));
-                        wheelBLTr->setModelScaled(wheelBLMat.front());
-
-                        // chasisMat *= PxMat44(PxVec4(1.75f, 1.0f, 2.5f, 1.0f));
-                        chasisTr->setModelScaled(chasisMat.front());
-                    }
-                }
-            }
+        // the vehicle batches of all the stepped scenes run together as well
+        std::atomic<size_t> pending(0);
+        for (const PhysxSceneStep& step : gSceneSteps) {
+            if (step.sceneData->vehicles.empty()) { continue; }
+            vehicleApplyInputs(*step.sceneData);
+            vehicleSubmitBatches(*step.sceneData, step.timestep, pending);
         }
+        PrototypeEngineInternalApplication::threadpool->helpUntil(pending, PrototypeThreadpoolPriority_High);
 
-        for (const auto& colliderObject : colliderObjects) {
-            Rigidbody* rb = colliderObject->getRigidbodyTrait();
-            if (!rb) { continue; }
-            auto actor = static_cast<PxRigidActor*>(rb->rigidbodyRef());
-            if (!actor) { continue; }
-            Transform* tr = colliderObject->getTransformTrait();
-            if (!tr->needsPhysicsSync()) {
-                if (rb->isStatic()) { continue; }
-                if (!actor->is<PxRigidDynamic>()->isSleeping()) {
-                    auto    rigidDynamicActor = actor->is<PxRigidDynamic>();
-                    PxMat44 m                 = PxMat44(actor->getGlobalPose());
-                    tr->setModel(m.front());
-                    tr->updateComponentsFromMatrix();
-                    if (static_cast<PrototypeSceneNode*>(colliderObject->parentNode())->isSelected()) {
-                        PxVec3 tempLinearVelocity  = rigidDynamicActor->getLinearVelocity();
-                        PxVec3 tempAngularVelocity = rigidDynamicActor->getAngularVelocity();
-                        rb->setLinearVelocity(*((glm::vec3*)&tempLinearVelocity));
-                        rb->setLinearDamping(rigidDynamicActor->getLinearDamping());
-                        rb->setAngularVelocity(*((glm::vec3*)&tempAngularVelocity));
-                        rb->setAngularDamping(rigidDynamicActor->getAngularDamping());
-                    }
-                }
-            } else {
-                auto m = (PxMat44*)(&tr->model()[0][0]);
-                actor->setGlobalPose(PxTransform(*m));
-                tr->setNeedsPhysicsSync(false);
-            }
+        for (const PhysxSceneStep& step : gSceneSteps) {
+            if (!step.sceneData->vehicles.empty()) { vehiclePostUpdates(*step.sceneData); }
+            pullActiveActors(step.sceneData->scene);
         }
-    } else {
-        auto colliderObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(
-          PrototypeTraitTypeMaskCollider | PrototypeTraitTypeMaskTransform | PrototypeTraitTypeMaskRigidbody);
+    }
 
-        for (const auto& colliderObject : colliderObjects) {
-            Rigidbody* rb    = colliderObject->getRigidbodyTrait();
-            auto       actor = static_cast<PxRigidActor*>(rb->rigidbodyRef());
-            if (!actor) { continue; }
-            Transform* tr = colliderObject->getTransformTrait();
-            if (tr->needsPhysicsSync()) {
-                auto m = (PxMat44*)(&tr->model()[0][0]);
-                actor->setGlobalPose(PxTransform(*m));
-                tr->setNeedsPhysicsSync(false);
-            }
+    // push the transforms that got edited outside the simulation, playing or not
+    for (PrototypeObject* object : gPhysicsSyncObjects) {
+        Transform* tr = object->getTransformTrait();
+        if (!tr || !tr->needsPhysicsSync()) { continue; }
+        Rigidbody* rb    = object->getRigidbodyTrait();
+        auto       actor = rb ? static_cast<PxRigidActor*>(rb->rigidbodyRef()) : nullptr;
+        if (actor) {
+            pushRigidbody(tr, actor);
+        } else {
+            tr->setNeedsPhysicsSync(false);
         }
     }
+    gPhysicsSyncObjects.clear();
 
     auto selectedObjects = PrototypeEngineInternalApplication::scene->selectedNodes();
     for (const auto& node : selectedObjects) {
@@ -475,27 +730,19 @@ PrototypePhysxPhysics::update()
                 if (!actor) { continue; }
                 auto tr = obj->getTransformTrait();
                 if (tr->needsPhysicsSync()) {
-                    auto m = (PxMat44*)(&tr->model()[0][0]);
-                    actor->setGlobalPose(PxTransform(*m));
-                    tr->setNeedsPhysicsSync(false);
+                    pushRigidbody(tr, actor);
                 } else {
                     if (rb->isStatic()) { continue; }
-                    if (!actor->is<PxRigidDynamic>()->isSleeping()) {
-                        auto    rigidDynamicActor = actor->is<PxRigidDynamic>();
-                        PxMat44 m                 = PxMat44(actor->getGlobalPose());
-                        tr->setModel(m.front());
-                        tr->updateComponentsFromMatrix();
-                        PxVec3 tempLinearVelocity  = rigidDynamicActor->getLinearVelocity();
-                        PxVec3 tempAngularVelocity = rigidDynamicActor->getAngularVelocity();
-                        rb->setLinearVelocity(*((glm::vec3*)&tempLinearVelocity));
-                        rb->setLinearDamping(rigidDynamicActor->getLinearDamping());
-                        rb->setAngularVelocity(*((glm::vec3*)&tempAngularVelocity));
-                        rb->setAngularDamping(rigidDynamicActor->getAngularDamping());
-                    }
+                    auto rigidDynamicActor = actor->is<PxRigidDynamic>();
+                    if (rigidDynamicActor && !rigidDynamicActor->isSleeping()) { pullRigidbody(obj, rigidDynamicActor, true); }
                 }
             }
         }
     }
+
+    // queued batches see this frame's simulation results, they run whether the simulation is playing or not
+    for (const PrototypePhysicsQueryBatch& batch : _queryBatches) { queryBatch(batch.queries, batch.count, batch.hits); }
+    _queryBatches.clear();
     return true;
 }
 
@@ -519,105 +766,52 @@ PrototypePhysxPhysics::beginRecordPass()
         sceneDesc.gravity       = PxVec3(0.0f, -9.81f, 0.0f);
         sceneDesc.cpuDispatcher = gDispatcher;
         sceneDesc.filterShader  = PrototypeFilterShader;
+        sceneDesc.flags |= PxSceneFlag::eENABLE_ACTIVE_ACTORS;
+        // makes the results independent of the other actors and pairs the scene went through, not only of the order
+        if (_lockstep.enabled) { sceneDesc.flags |= PxSceneFlag::eENABLE_ENHANCED_DETERMINISM; }
+        // copied by PhysX, later changes to the scene layers only apply to scenes created afterwards
+        const auto& collisionLayersMatrix = PrototypeEngineInternalApplication::scene->collisionLayers().matrix();
+        sceneDesc.filterShaderData        = collisionLayersMatrix.data();
+        sceneDesc.filterShaderDataSize    = (PxU32)(collisionLayersMatrix.size() * sizeof(u32));
 
         PhysxSceneData sceneData = {};
         sceneData.scene          = gPhysics->createScene(sceneDesc);
-        // Create the batched scene queries for the suspension raycasts.
-
-        sceneData.vehicleSceneQueryData =
-          snippetvehicle::VehicleSceneQueryData::allocate(PROTOTYPE_MAX_NUM_VEHICLES,
-                                                          PX_MAX_NB_WHEELS,
-                                                          1,
-                                                          PROTOTYPE_MAX_NUM_VEHICLES,
-                                                          snippetvehicle::WheelSceneQueryPreFilterBlocking,
-                                                          NULL,
-                                                          gAllocator);
-        sceneData.batchQuery =
-          snippetvehicle::VehicleSceneQueryData::setUpBatchedSceneQuery(0, *sceneData.vehicleSceneQueryData, sceneData.scene);
+        // the batched scene queries for the suspension raycasts are created along with the vehicle batches
 
         // Create the friction table for each combination of tire and surface type.
-        sceneData.frictionPairs          = snippetvehicle::createFrictionPairs(gMaterial);
-        sceneData.numVehicles            = 0;
-        sceneData.controlledVehicleIndex = -1;
+        sceneData.frictionPairs           = snippetvehicle::createFrictionPairs(gMaterial);
+        sceneData.vehicleInputsWriteIndex = 0;
+        sceneData.controlledVehicleIndex  = -1;
         sceneData.scene->setSimulationEventCallback(PrototypePhysxPhysics::gEventsCallback);
 
         // insert scene data
         _scenes.insert({ currentSceneName, sceneData });
+        // lets the vehicles find the data of the scene they live in whichever scene is current
+        _scenes[currentSceneName].scene->userData = &_scenes[currentSceneName];
         gScene                  = _scenes[currentSceneName].scene;
-        gVehicleSceneQueryData  = _scenes[currentSceneName].vehicleSceneQueryData;
-        gBatchQuery             = _scenes[currentSceneName].batchQuery;
         gFrictionPairs          = _scenes[currentSceneName].frictionPairs;
-        gVehicles               = _scenes[currentSceneName].vehicles;
-        gVehicleInputData       = _scenes[currentSceneName].vehicleInputData;
-        gNumVehicles            = &_scenes[currentSceneName].numVehicles;
+        gSceneData              = &_scenes[currentSceneName];
+        gVehicles               = &_scenes[currentSceneName].vehicles;
+        gVehicleObjects         = &_scenes[currentSceneName].vehicleObjects;
+        gVehicleInputData       = &_scenes[currentSceneName].vehicleInputData;
         gControlledVehicleIndex = &_scenes[currentSceneName].controlledVehicleIndex;
 
-        auto colliderObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(
+        // the objects come out of an unordered set, creating the bodies in id order keeps the order the simulation
+        // visits them in the same from one run to the next
+        const auto& colliderObjectsSet = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(
           PrototypeTraitTypeMaskCollider | PrototypeTraitTypeMaskTransform | PrototypeTraitTypeMaskRigidbody);
-        for (auto& colliderObject : colliderObjects) {
-            // const auto& position = colliderObject.second->getTransformTrait()->position();
-            // const auto& rotation = colliderObject.second->getTransformTrait()->rotation();
-            // const auto& scale    = colliderObject.second->getTransformTrait()->scale();
-            Collider* collider = colliderObject->getColliderTrait();
-            switch (collider->shapeType()) {
-                case ColliderShape_Plane: {
-                    createPlaneCollider(&(*colliderObject));
-                    collider->setNameRef("PLANE");
-                } break;
-
-                case ColliderShape_Box: {
-                    createBoxCollider(&(*colliderObject));
-                    collider->setNameRef("CUBE");
-                } break;
-
-                case ColliderShape_Sphere: {
-                    createSphereCollider(&(*colliderObject));
-                } break;
-
-                case ColliderShape_Capsule: {
-                    createCapsuleCollider(collider->radius(), collider->height(), collider->density(), &(*colliderObject));
-                    collider->setNameRef("CAPSULE");
-                } break;
-
-                case ColliderShape_ConvexMesh: {
-                    const std::string      meshName = colliderObject->getMeshRendererTrait()->data()[0].mesh;
-                    auto                   source = PrototypeEngineInternalApplication::database->meshBuffers[meshName]->source();
-                    std::vector<glm::vec3> vertices(source.vertices.size());
-                    for (size_t v = 0; v < source.vertices.size(); ++v) {
-                        vertices[v].x = source.vertices[v].positionU.x;
-                        vertices[v].y = source.vertices[v].positionU.y;
-                        vertices[v].z = source.vertices[v].positionU.z;
-                    }
-                    createConvexMeshCollider(vertices, source.indices, &(*colliderObject));
-                    collider->setNameRef(std::string("(CONVEX) ").append(meshName));
-                } break;
-
-                case ColliderShape_TriangleMesh: {
-                    const std::string      meshName = colliderObject->getMeshRendererTrait()->data()[0].mesh;
-                    auto                   source = PrototypeEngineInternalApplication::database->meshBuffers[meshName]->source();
-                    std::vector<glm::vec3> vertices(source.vertices.size());
-                    for (size_t v = 0; v < source.vertices.size(); ++v) {
-                        vertices[v].x = source.vertices[v].positionU.x;
-                        vertices[v].y = source.vertices[v].positionU.y;
-                        vertices[v].z = source.vertices[v].positionU.z;
-                    }
-                    createTriMeshCollider(vertices, source.indices, &(*colliderObject));
-                    collider->setNameRef(std::string("(TRIMESH) ").append(meshName));
-                } break;
-
-                default: {
-                    PrototypeLogger::fatal("Unhandled collider type");
-                } break;
-            }
-        }
+        std::vector<PrototypeObject*> colliderObjects(colliderObjectsSet.begin(), colliderObjectsSet.end());
+        std::sort(colliderObjects.begin(), colliderObjects.end(), [](PrototypeObject* a, PrototypeObject* b) {
+            return a->id() < b->id();
+        });
+        for (auto& colliderObject : colliderObjects) { createColliderActor(colliderObject); }
     } else {
         gScene                  = _scenes[currentSceneName].scene;
-        gVehicleSceneQueryData  = _scenes[currentSceneName].vehicleSceneQueryData;
-        gBatchQuery             = _scenes[currentSceneName].batchQuery;
         gFrictionPairs          = _scenes[currentSceneName].frictionPairs;
-        gVehicles               = _scenes[currentSceneName].vehicles;
-        gVehicleInputData       = _scenes[currentSceneName].vehicleInputData;
-        gNumVehicles            = &_scenes[currentSceneName].numVehicles;
+        gSceneData              = &_scenes[currentSceneName];
+        gVehicles               = &_scenes[currentSceneName].vehicles;
+        gVehicleObjects         = &_scenes[currentSceneName].vehicleObjects;
+        gVehicleInputData       = &_scenes[currentSceneName].vehicleInputData;
         gControlledVehicleIndex = &_scenes[currentSceneName].controlledVehicleIndex;
     }
 #if defined(PROTOTYPE_DEBUG_PHYSX)
@@ -643,22 +837,125 @@ PrototypePhysxPhysics::isPlaying()
     return _isPlaying;
 }
 
+void
+PrototypePhysxPhysics::setLockstep(const PrototypePhysicsLockstep& lockstep)
+{
+    _lockstep = lockstep;
+}
+
+const PrototypePhysicsLockstep&
+PrototypePhysxPhysics::lockstep()
+{
+    return _lockstep;
+}
+
+u64
+PrototypePhysxPhysics::stateHash()
+{
+    u64 hash = PROTOTYPE_PHYSICS_HASH_OFFSET;
+    if (!gScene) { return hash; }
+    // the actors come in insertion order, the same between two runs that created and removed the same bodies
+    std::vector<PxActor*> actors(gScene->getNbActors(PxActorTypeFlag::eRIGID_DYNAMIC));
+    gScene->getActors(PxActorTypeFlag::eRIGID_DYNAMIC, actors.data(), (PxU32)actors.size());
+    for (PxActor* actor : actors) {
+        PxRigidDynamic*   body    = actor->is<PxRigidDynamic>();
+        PrototypeObject*  object  = static_cast<PrototypeObject*>(body->userData);
+        const u32         id      = object ? object->id() : 0;
+        const PxTransform pose    = body->getGlobalPose();
+        const PxVec3      linear  = body->getLinearVelocity();
+        const PxVec3      angular = body->getAngularVelocity();
+        hash                      = PrototypePhysicsHash(hash, &id, sizeof(id));
+        hash                      = PrototypePhysicsHash(hash, &pose.q, sizeof(pose.q));
+        hash                      = PrototypePhysicsHash(hash, &pose.p, sizeof(pose.p));
+        hash                      = PrototypePhysicsHash(hash, &linear, sizeof(linear));
+        hash                      = PrototypePhysicsHash(hash, &angular, sizeof(angular));
+    }
+    return hash;
+}
+
 void
 PrototypePhysxPhysics::overrideRigidbodyGlobalPos(PrototypeObject* object)
 {}
 
 std::optional<PrototypeObject*>
-PrototypePhysxPhysics::raycast(const glm::vec3& origin, const glm::vec3& dir, const f32 length)
+PrototypePhysxPhysics::raycast(const glm::vec3& origin, const glm::vec3& dir, const f32 length, u32 layerMask)
 {
-    PxVec3          position(origin.x, origin.y, origin.z);
-    PxVec3          orientation(dir.x, dir.y, dir.z);
-    PxRaycastBuffer hit;
-    if (gScene->raycast(position, orientation, length, hit)) {
+    // a zero mask leaves the filter data empty which PhysX treats as no filtering
+    PxQueryFilterData filterData(PxFilterData(layerMask, 0, 0, 0), PxQueryFlag::eSTATIC | PxQueryFlag::eDYNAMIC);
+    PxVec3            position(origin.x, origin.y, origin.z);
+    PxVec3            orientation(dir.x, dir.y, dir.z);
+    PxRaycastBuffer   hit;
+    if (gScene->raycast(position, orientation, length, hit, PxHitFlag::eDEFAULT, filterData)) {
         if (hit.block.actor && hit.block.actor->userData) { return { (PrototypeObject*)hit.block.actor->userData }; }
     }
     return {};
 }
 
+void
+PrototypePhysxPhysics::queryBatch(const PrototypePhysicsQuery* queries, size_t count, PrototypePhysicsQueryHit* hits)
+{
+    if (count == 0) { return; }
+
+    // the calling thread takes the first slice, the rest go to the dispatcher workers
+    const size_t maxTasks  = (size_t)gDispatcher->getWorkerCount() + 1;
+    const size_t maxSlices = std::max<size_t>(1, std::min(maxTasks, count / PrototypePhysxQuerySliceMinSize));
+    const size_t sliceSize = (count + maxSlices - 1) / maxSlices;
+    const size_t numSlices = (count + sliceSize - 1) / sliceSize;
+
+    // the tasks belong to this call, thread-safe plugin batches may run several query batches at once
+    auto* tasks = static_cast<PrototypePhysxQueryTask*>(PrototypeEngineInternalApplication::frameArena->allocate(
+      sizeof(PrototypePhysxQueryTask) * numSlices, alignof(PrototypePhysxQueryTask)));
+
+    std::atomic<size_t> pending(numSlices - 1);
+    for (size_t s = 1; s < numSlices; ++s) {
+        const size_t             begin = s * sliceSize;
+        PrototypePhysxQueryTask* task  = new (&tasks[s]) PrototypePhysxQueryTask();
+        task->scene                    = gScene;
+        task->queries                  = queries + begin;
+        task->hits                     = hits + begin;
+        task->count                    = std::min(sliceSize, count - begin);
+        task->pending                  = &pending;
+        gDispatcher->submitTask(*task);
+    }
+    PrototypePhysxRunQueries(gScene, queries, std::min(sliceSize, count), hits);
+    PrototypeEngineInternalApplication::threadpool->helpUntil(pending, PrototypeThreadpoolPriority_High);
+    for (size_t s = 1; s < numSlices; ++s) { tasks[s].~PrototypePhysxQueryTask(); }
+}
+
+void
+PrototypePhysxPhysics::submitQueryBatch(const PrototypePhysicsQuery* queries, size_t count, PrototypePhysicsQueryHit* hits)
+{
+    if (count == 0) { return; }
+    _queryBatches.push_back({ queries, count, hits });
+}
+
+void
+PrototypePhysxPhysics::fetchStatistics(PrototypePhysicsStatistics& statistics)
+{
+    statistics = {};
+    if (!gScene) return;
+    PxSimulationStatistics simulationStatistics;
+    gScene->getSimulationStatistics(simulationStatistics);
+    statistics.activeBodies  = simulationStatistics.nbActiveDynamicBodies;
+    statistics.contactPairs  = simulationStatistics.nbDiscreteContactPairsTotal;
+    statistics.touchingPairs = simulationStatistics.nbDiscreteContactPairsWithContacts;
+}
+
+const std::vector<PrototypePhysicsEvent>&
+PrototypePhysxPhysics::events()
+{
+    return gEventsCallback->events;
+}
+
+void
+PrototypePhysxPhysics::setSceneActivity(const std::string& sceneName, PrototypePhysicsSceneActivity_ activity, f32 rate)
+{
+    PrototypePhysicsSceneActivity& sceneActivity = _sceneActivities[sceneName];
+    sceneActivity.activity                       = activity;
+    sceneActivity.rate                           = rate;
+    sceneActivity.accumulator                    = 0.0f;
+}
+
 void
 PrototypePhysxPhysics::fetchModelMatrix(void* rigidbody, void* shape, glm::mat4& model)
 {
@@ -668,6 +965,67 @@ PrototypePhysxPhysics::fetchModelMatrix(void* rigidbody, void* shape, glm::mat4&
     memcpy(&model[0][0], &m.column0.x, sizeof(f32) * 16);
 }
 
+void
+PrototypePhysxPhysics::createColliderActor(PrototypeObject* object)
+{
+    // const auto& position = colliderObject.second->getTransformTrait()->position();
+    // const auto& rotation = colliderObject.second->getTransformTrait()->rotation();
+    // const auto& scale    = colliderObject.second->getTransformTrait()->scale();
+    Collider* collider = object->getColliderTrait();
+    switch (collider->shapeType()) {
+        case ColliderShape_Plane: {
+            createPlaneCollider(object);
+            collider->setNameRef("PLANE");
+        } break;
+
+        case ColliderShape_Box: {
+            createBoxCollider(object);
+            collider->setNameRef("CUBE");
+        } break;
+
+        case ColliderShape_Sphere: {
+            createSphereCollider(object);
+        } break;
+
+        case ColliderShape_Capsule: {
+            createCapsuleCollider(collider->radius(), collider->height(), collider->density(), object);
+            collider->setNameRef("CAPSULE");
+        } break;
+
+        case ColliderShape_ConvexMesh: {
+            const std::string      meshName = object->getMeshRendererTrait()->data()[0].mesh;
+            auto                   source = PrototypeEngineInternalApplication::database->meshBuffers[meshName]->source();
+            std::vector<glm::vec3> vertices(source.vertices.size());
+            for (size_t v = 0; v < source.vertices.size(); ++v) {
+                vertices[v].x = source.vertices[v].positionU.x;
+                vertices[v].y = source.vertices[v].positionU.y;
+                vertices[v].z = source.vertices[v].positionU.z;
+            }
+            createConvexMeshCollider(vertices, source.indices, object);
+            collider->setNameRef(std::string("(CONVEX) ").append(meshName));
+        } break;
+
+        case ColliderShape_TriangleMesh: {
+            const std::string      meshName = object->getMeshRendererTrait()->data()[0].mesh;
+            auto                   source = PrototypeEngineInternalApplication::database->meshBuffers[meshName]->source();
+            std::vector<glm::vec3> vertices(source.vertices.size());
+            for (size_t v = 0; v < source.vertices.size(); ++v) {
+                vertices[v].x = source.vertices[v].positionU.x;
+                vertices[v].y = source.vertices[v].positionU.y;
+                vertices[v].z = source.vertices[v].positionU.z;
+            }
+            createTriMeshCollider(vertices, source.indices, object);
+            collider->setNameRef(std::string("(TRIMESH) ").append(meshName));
+        } break;
+
+        default: {
+            PrototypeLogger::fatal("Unhandled collider type");
+        } break;
+    }
+    // the actor was just created from the loaded transform, nothing left to push
+    object->getTransformTrait()->setNeedsPhysicsSync(false);
+}
+
 void
 PrototypePhysxPhysics::createPlaneCollider(PrototypeObject* object)
 {
@@ -724,12 +1082,13 @@ PrototypePhysxPhysics::createPlaneCollider(PrototypeObject* object)
         // wheels.
         shape->setSimulationFilterData(groundPlaneSimFilterData);
     }
+    shapeSetFilterData(shape, collider->layer(), rb->events());
 
     rigidbody->userData = (void*)object;
     rb->setRigidbodyRef(static_cast<void*>(rigidbody));
     shape->userData = (void*)object;
     collider->setShapeRef(static_cast<void*>(shape));
-    gScene->addActor(*rigidbody);
+    sceneAddActor(rigidbody);
 }
 
 void
@@ -790,12 +1149,13 @@ PrototypePhysxPhysics::createBoxCollider(PrototypeObject* object)
         // wheels.
         shape->setSimulationFilterData(groundPlaneSimFilterData);
     }
+    shapeSetFilterData(shape, collider->layer(), rb->events());
 
     rigidbody->userData = (void*)object;
     rb->setRigidbodyRef(static_cast<void*>(rigidbody));
     shape->userData = (void*)object;
     collider->setShapeRef(static_cast<void*>(shape));
-    gScene->addActor(*rigidbody);
+    sceneAddActor(rigidbody);
 }
 
 void
@@ -854,12 +1214,13 @@ PrototypePhysxPhysics::createSphereCollider(PrototypeObject* object)
         // wheels.
         shape->setSimulationFilterData(groundPlaneSimFilterData);
     }
+    shapeSetFilterData(shape, collider->layer(), rb->events());
 
     rigidbody->userData = (void*)object;
     rb->setRigidbodyRef(static_cast<void*>(rigidbody));
     shape->userData = (void*)object;
     collider->setShapeRef(static_cast<void*>(shape));
-    gScene->addActor(*rigidbody);
+    sceneAddActor(rigidbody);
 }
 
 void
@@ -924,12 +1285,13 @@ PrototypePhysxPhysics::createCapsuleCollider(const float&     radius,
         // wheels.
         shape->setSimulationFilterData(groundPlaneSimFilterData);
     }
+    shapeSetFilterData(shape, collider->layer(), rb->events());
 
     rigidbody->userData = (void*)object;
     rb->setRigidbodyRef(static_cast<void*>(rigidbody));
     shape->userData = (void*)object;
     collider->setShapeRef(static_cast<void*>(shape));
-    gScene->addActor(*rigidbody);
+    sceneAddActor(rigidbody);
 }
 
 void
@@ -988,12 +1350,13 @@ PrototypePhysxPhysics::internalCreateConvexMeshCollider(PrototypeObject* object,
         // wheels.
         shape->setSimulationFilterData(groundPlaneSimFilterData);
     }
+    shapeSetFilterData(shape, collider->layer(), rb->events());
 
     rigidbody->userData = (void*)object;
     rb->setRigidbodyRef(static_cast<void*>(rigidbody));
     shape->userData = (void*)object;
     collider->setShapeRef(static_cast<void*>(shape));
-    gScene->addActor(*rigidbody);
+    sceneAddActor(rigidbody);
 }
 
 void
@@ -1076,6 +1439,7 @@ PrototypePhysxPhysics::createTriMeshCollider(const std::vector<glm::vec3>& verti
             // wheels.
             shape->setSimulationFilterData(groundPlaneSimFilterData);
         }
+        shapeSetFilterData(shape, collider->layer(), rb->events());
 
         rigidbody->setMass(PxReal(mass));
         rigidbody->setRigidDynamicLockFlag(PxRigidDynamicLockFlag::eLOCK_LINEAR_X, lockLinearX);
@@ -1088,7 +1452,7 @@ PrototypePhysxPhysics::createTriMeshCollider(const std::vector<glm::vec3>& verti
         rb->setRigidbodyRef(static_cast<void*>(rigidbody));
         shape->userData = (void*)object;
         collider->setShapeRef(static_cast<void*>(shape));
-        gScene->addActor(*rigidbody);
+        sceneAddActor(rigidbody);
         rb->setStatic(true);
     }
 }
@@ -1110,45 +1474,87 @@ PrototypePhysxPhysics::createVehicle(const std::vector<glm::vec3>& chasisVertice
                                      PrototypeObject*              wheelBRObject,
                                      PrototypeObject*              wheelBLObject)
 {
-    if (*gNumVehicles == PROTOTYPE_MAX_NUM_VEHICLES) { return; }
-
     // Create a vehicle that will drive on the plane.
-    snippetvehicle::VehicleDesc vehicleDesc = vehicleInitDesc();
-    gVehicles[*gNumVehicles]                = createVehicle4W(vehicleDesc, gPhysics, gCooking, chasisObject);
+    snippetvehicle::VehicleDesc vehicleDesc  = vehicleInitDesc();
+    const size_t                vehicleIndex = gVehicles->size();
+    PxVehicleDrive4W*           vehicle      = createVehicle4W(vehicleDesc, gPhysics, gCooking, chasisObject);
+    gVehicles->push_back(vehicle);
+    gVehicleObjects->push_back(chasisObject);
+    gVehicleInputData->emplace_back();
+    {
+        std::lock_guard<std::mutex> lock(gVehicleInputsLock);
+        for (auto& inputs : gSceneData->vehicleInputs) { inputs.push_back({ 0.0f, 0.0f, 0.0f, false }); }
+    }
+
+    // the wheel results and updates are flat arrays of 4 per vehicle, point every vehicle back at its slice once they grew
+    gSceneData->wheelQueryResults.resize((vehicleIndex + 1) * 4);
+    gSceneData->wheelConcurrentUpdates.resize((vehicleIndex + 1) * 4);
+    gSceneData->vehicleQueryResults.resize(vehicleIndex + 1);
+    gSceneData->vehicleConcurrentUpdates.resize(vehicleIndex + 1);
+    for (size_t i = 0; i <= vehicleIndex; ++i) {
+        gSceneData->vehicleQueryResults[i].nbWheelQueryResults           = 4;
+        gSceneData->vehicleQueryResults[i].wheelQueryResults             = &gSceneData->wheelQueryResults[i * 4];
+        gSceneData->vehicleConcurrentUpdates[i].nbConcurrentWheelUpdates = 4;
+        gSceneData->vehicleConcurrentUpdates[i].concurrentWheelUpdates   = &gSceneData->wheelConcurrentUpdates[i * 4];
+    }
+
+    // Create the batched scene queries for the suspension raycasts of the batch this vehicle falls in.
+    if (gSceneData->vehicleBatches.size() * PROTOTYPE_PHYSX_VEHICLE_BATCH_SIZE <= vehicleIndex) {
+        PrototypePhysxVehicleBatch* batch = PROTOTYPE_NEW PrototypePhysxVehicleBatch();
+        batch->sceneQueryData =
+          snippetvehicle::VehicleSceneQueryData::allocate(PROTOTYPE_PHYSX_VEHICLE_BATCH_SIZE,
+                                                          PX_MAX_NB_WHEELS,
+                                                          1,
+                                                          PROTOTYPE_PHYSX_VEHICLE_BATCH_SIZE,
+                                                          snippetvehicle::WheelSceneQueryPreFilterBlocking,
+                                                          NULL,
+                                                          gAllocator);
+        batch->batchQuery = snippetvehicle::VehicleSceneQueryData::setUpBatchedSceneQuery(0, *batch->sceneQueryData, gScene);
+        batch->sceneData  = gSceneData;
+        gSceneData->vehicleBatches.push_back(batch);
+    }
 
     VehicleChasis* vch = chasisObject->getVehicleChasisTrait();
-    vch->setVehicleRef(gVehicles[*gNumVehicles]);
+    vch->setVehicleRef(vehicle);
     vch->setWheelFRObject(wheelFRObject);
     vch->setWheelFLObject(wheelFLObject);
     vch->setWheelBRObject(wheelBRObject);
     vch->setWheelBLObject(wheelBLObject);
-    vch->setVehicleIndex(*gNumVehicles);
+    vch->setVehicleIndex(vehicleIndex);
+    vehicle->getRigidDynamicActor()->userData = chasisObject;
+    // the chassis and wheels shapes live on the default layer so layer masked queries can still hit them, no events either
+    {
+        std::vector<PxShape*> shapes(vehicle->getRigidDynamicActor()->getNbShapes());
+        vehicle->getRigidDynamicActor()->getShapes(shapes.data(), (PxU32)shapes.size());
+        for (PxShape* shape : shapes) { shapeSetFilterData(shape, 0, 0); }
+    }
 
     PxTransform startTransform(PxVec3(0, (vehicleDesc.chassisDims.y * 0.5f + vehicleDesc.wheelRadius + 1.0f), 0),
                                PxQuat(PxIdentity));
-    gVehicles[*gNumVehicles]->getRigidDynamicActor()->setGlobalPose(startTransform);
-    gScene->addActor(*gVehicles[*gNumVehicles]->getRigidDynamicActor());
+    vehicle->getRigidDynamicActor()->setGlobalPose(startTransform);
+    gScene->addActor(*vehicle->getRigidDynamicActor());
 
     // Set the vehicle to rest in first gear.
     // Set the vehicle to use auto-gears.
     // Set the vehicle to use the standard control model
-    gVehicles[*gNumVehicles]->setToRestState();
-    gVehicles[*gNumVehicles]->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
-    gVehicles[*gNumVehicles]->mDriveDynData.setUseAutoGears(true);
-
-    gVehicleInputData[*gNumVehicles].setAnalogBrake(1.0f);
+    vehicle->setToRestState();
+    vehicle->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
+    vehicle->mDriveDynData.setUseAutoGears(true);
 
-    ++(*gNumVehicles);
+    (*gVehicleInputData)[vehicleIndex].setAnalogBrake(1.0f);
 }
 
 void
 PrototypePhysxPhysics::updateVehicleController(PrototypeObject* object, f32 acceleration, f32 brake, f32 steer)
 {
-    VehicleChasis* vch          = object->getVehicleChasisTrait();
-    size_t         vehicleIndex = vch->vehicleIndex();
-    gVehicleInputData[vehicleIndex].setAnalogAccel(acceleration);
-    gVehicleInputData[vehicleIndex].setAnalogBrake(brake);
-    gVehicleInputData[vehicleIndex].setAnalogSteer(steer);
+    VehicleChasis*    vch          = object->getVehicleChasisTrait();
+    size_t            vehicleIndex = vch->vehicleIndex();
+    PxVehicleDrive4W* vehicle      = static_cast<PxVehicleDrive4W*>(vch->vehicleRef());
+    if (!vehicle || !vehicle->getRigidDynamicActor()->getScene()) { return; }
+    PhysxSceneData& sceneData = *static_cast<PhysxSceneData*>(vehicle->getRigidDynamicActor()->getScene()->userData);
+    // double buffered, the next update applies whatever was written last
+    std::lock_guard<std::mutex> lock(gVehicleInputsLock);
+    sceneData.vehicleInputs[sceneData.vehicleInputsWriteIndex][vehicleIndex] = { acceleration, brake, steer, true };
 }
 
 void
@@ -1351,6 +1757,34 @@ PrototypePhysxPhysics::updateCollider(PrototypeObject* object, const std::string
     }
 }
 
+void
+PrototypePhysxPhysics::updateRigidbodyEvents(PrototypeObject* object)
+{
+    if (!object->hasColliderTrait() || !object->hasRigidbodyTrait()) return;
+    Collider*     collider = object->getColliderTrait();
+    Rigidbody*    rb       = object->getRigidbodyTrait();
+    auto          shape    = static_cast<PxShape*>(collider->shapeRef());
+    PxRigidActor* actor    = static_cast<PxRigidActor*>(rb->rigidbodyRef());
+    if (!shape || !actor) return;
+    shapeSetFilterData(shape, collider->layer(), rb->events());
+    // the pairs already found keep the flags of the previous filtering otherwise
+    if (actor->getScene()) { actor->getScene()->resetFiltering(*actor); }
+}
+
+void
+PrototypePhysxPhysics::updateColliderLayer(PrototypeObject* object)
+{
+    if (!object->hasColliderTrait() || !object->hasRigidbodyTrait()) return;
+    Collider*     collider = object->getColliderTrait();
+    Rigidbody*    rb       = object->getRigidbodyTrait();
+    auto          shape    = static_cast<PxShape*>(collider->shapeRef());
+    PxRigidActor* actor    = static_cast<PxRigidActor*>(rb->rigidbodyRef());
+    if (!shape || !actor) return;
+    shapeSetFilterData(shape, collider->layer(), rb->events());
+    // the pairs killed by the previous layer only come back once the actor goes through the filter shader again
+    if (actor->getScene()) { actor->getScene()->resetFiltering(*actor); }
+}
+
 void
 PrototypePhysxPhysics::scaleCollider(PrototypeObject* object, const glm::vec3& scale)
 {
@@ -1387,6 +1821,7 @@ PrototypePhysxPhysics::scaleCollider(PrototypeObject* object, const glm::vec3& s
                 // Set the simulation filter data of the ground plane so that it collides with the chassis of a vehicle but not
                 // the wheels.
                 myTriMeshShape->setSimulationFilterData(groundPlaneSimFilterData);
+                shapeSetFilterData(myTriMeshShape, collider->layer(), rb->events());
                 // --------------------------------------------------------------------------------------------------
 
                 collider->setShapeRef((void*)myTriMeshShape);
@@ -1419,6 +1854,7 @@ PrototypePhysxPhysics::scaleCollider(PrototypeObject* object, const glm::vec3& s
                 // Set the simulation filter data of the ground plane so that it collides with the chassis of a vehicle but not
                 // the wheels.
                 myConvexMeshShape->setSimulationFilterData(groundPlaneSimFilterData);
+                shapeSetFilterData(myConvexMeshShape, collider->layer(), rb->events());
                 // --------------------------------------------------------------------------------------------------
 
                 collider->setShapeRef((void*)myConvexMeshShape);
@@ -1450,6 +1886,7 @@ PrototypePhysxPhysics::scaleCollider(PrototypeObject* object, const glm::vec3& s
                 // Set the simulation filter data of the ground plane so that it collides with the chassis of a vehicle but not
                 // the wheels.
                 myBoxMeshShape->setSimulationFilterData(groundPlaneSimFilterData);
+                shapeSetFilterData(myBoxMeshShape, collider->layer(), rb->events());
                 // --------------------------------------------------------------------------------------------------
 
                 collider->setShapeRef((void*)myBoxMeshShape);
@@ -1481,6 +1918,7 @@ PrototypePhysxPhysics::scaleCollider(PrototypeObject* object, const glm::vec3& s
                 // Set the simulation filter data of the ground plane so that it collides with the chassis of a vehicle but not
                 // the wheels.
                 mySphereMeshShape->setSimulationFilterData(groundPlaneSimFilterData);
+                shapeSetFilterData(mySphereMeshShape, collider->layer(), rb->events());
                 // --------------------------------------------------------------------------------------------------
 
                 collider->setShapeRef((void*)mySphereMeshShape);
@@ -1584,6 +2022,8 @@ PrototypePhysxPhysics::destroyRigidbody(void* rigidbody)
     if (actor) {
         gScene->removeActor(*actor);
         auto object = static_cast<PrototypeObject*>(actor->userData);
+        gPhysicsSyncObjects.erase(std::remove(gPhysicsSyncObjects.begin(), gPhysicsSyncObjects.end(), object),
+                                  gPhysicsSyncObjects.end());
         if (object && object->hasColliderTrait()) {
             Collider* collider = object->getColliderTrait();
             auto      shape    = static_cast<PxShape*>(collider->shapeRef());
@@ -1593,24 +2033,98 @@ PrototypePhysxPhysics::destroyRigidbody(void* rigidbody)
     }
 }
 
+void
+PrototypePhysxPhysics::beginActorBatch()
+{
+    gActorBatch = true;
+}
+
+void
+PrototypePhysxPhysics::endActorBatch()
+{
+    gActorBatch = false;
+    if (gPendingActors.empty()) { return; }
+    // one broadphase insertion for the whole batch instead of one per actor
+    if (gScene) { gScene->addActors(gPendingActors.data(), (PxU32)gPendingActors.size()); }
+    gPendingActors.clear();
+}
+
+void
+PrototypePhysxPhysics::setRigidbodyActive(PrototypeObject* object, bool active)
+{
+    if (!object || !object->hasRigidbodyTrait()) return;
+    Rigidbody* rb    = object->getRigidbodyTrait();
+    auto       actor = static_cast<PxRigidActor*>(rb->rigidbodyRef());
+    if (!actor) return;
+    if (!active) {
+        if (actor->getScene()) { actor->getScene()->removeActor(*actor); }
+        gPendingActors.erase(std::remove(gPendingActors.begin(), gPendingActors.end(), actor), gPendingActors.end());
+        gPhysicsSyncObjects.erase(std::remove(gPhysicsSyncObjects.begin(), gPhysicsSyncObjects.end(), object),
+                                  gPhysicsSyncObjects.end());
+        return;
+    }
+    // callers only reactivate what they deactivated, an actor queued by an open batch isn't in a scene yet either
+    if (actor->getScene()) return;
+    pushRigidbody(object->getTransformTrait(), actor);
+    PxRigidDynamic* rigidbodyDynamic = actor->is<PxRigidDynamic>();
+    if (rigidbodyDynamic) {
+        const glm::vec3& linearVelocity  = rb->linearVelocity();
+        const glm::vec3& angularVelocity = rb->angularVelocity();
+        rigidbodyDynamic->setLinearVelocity(PxVec3(linearVelocity.x, linearVelocity.y, linearVelocity.z));
+        rigidbodyDynamic->setAngularVelocity(PxVec3(angularVelocity.x, angularVelocity.y, angularVelocity.z));
+    }
+    sceneAddActor(actor);
+}
+
+void
+PrototypePhysxPhysics::createActors(PrototypeObject* const* objects, size_t count)
+{
+    // the record pass creates the actors of every object of a scene it meets for the first time
+    if (_scenes.find(PrototypeEngineInternalApplication::scene->name()) == _scenes.end()) return;
+    std::vector<PrototypeObject*> colliderObjects;
+    colliderObjects.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        PrototypeObject* object = objects[i];
+        if (object && object->hasTransformTrait() && object->hasColliderTrait() && object->hasRigidbodyTrait()) {
+            colliderObjects.push_back(object);
+        }
+    }
+    std::sort(colliderObjects.begin(), colliderObjects.end(), [](PrototypeObject* a, PrototypeObject* b) {
+        return a->id() < b->id();
+    });
+    beginActorBatch();
+    for (auto& colliderObject : colliderObjects) { createColliderActor(colliderObject); }
+    endActorBatch();
+}
+
+void
+PrototypePhysxPhysics::sceneAddActor(PxRigidActor* actor)
+{
+    if (gActorBatch) {
+        gPendingActors.push_back(actor);
+    } else {
+        gScene->addActor(*actor);
+    }
+}
+
 void
 PrototypePhysxPhysics::spawnVehicle()
 {
-    if (*gNumVehicles > 0) {
-        if (*gControlledVehicleIndex >= 0 && *gControlledVehicleIndex < *gNumVehicles) {
-            gVehicles[*gControlledVehicleIndex]->setToRestState();
-            gVehicleInputData[*gControlledVehicleIndex].setAnalogBrake(1.0f);
+    if (!gVehicles->empty()) {
+        if (*gControlledVehicleIndex >= 0 && *gControlledVehicleIndex < gVehicles->size()) {
+            (*gVehicles)[*gControlledVehicleIndex]->setToRestState();
+            (*gVehicleInputData)[*gControlledVehicleIndex].setAnalogBrake(1.0f);
         }
     }
-    *gControlledVehicleIndex = *gNumVehicles - 1;
+    *gControlledVehicleIndex = gVehicles->size() - 1;
     vehicleReleaseAllControls(*gControlledVehicleIndex);
-    gVehicles[*gControlledVehicleIndex]->setToRestState();
-    gVehicles[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
-    gVehicles[*gControlledVehicleIndex]->mDriveDynData.setUseAutoGears(true);
-    gVehicleInputData[*gControlledVehicleIndex].setAnalogBrake(1.0f);
-    PxTransform t = gVehicles[*gControlledVehicleIndex]->getRigidDynamicActor()->getGlobalPose();
+    (*gVehicles)[*gControlledVehicleIndex]->setToRestState();
+    (*gVehicles)[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
+    (*gVehicles)[*gControlledVehicleIndex]->mDriveDynData.setUseAutoGears(true);
+    (*gVehicleInputData)[*gControlledVehicleIndex].setAnalogBrake(1.0f);
+    PxTransform t = (*gVehicles)[*gControlledVehicleIndex]->getRigidDynamicActor()->getGlobalPose();
     PxTransform startTransform(PxVec3(t.p.x, 5.0f, t.p.z), PxQuat(PxIdentity));
-    gVehicles[*gControlledVehicleIndex]->getRigidDynamicActor()->setGlobalPose(startTransform);
+    (*gVehicles)[*gControlledVehicleIndex]->getRigidDynamicActor()->setGlobalPose(startTransform);
 }
 
 void
@@ -1620,41 +2134,41 @@ PrototypePhysxPhysics::toggleVehicleAccessControl(PrototypeObject* object)
 void
 PrototypePhysxPhysics::requestNextVehicleAccessControl()
 {
-    if (*gNumVehicles <= 0) {
+    if (gVehicles->empty()) {
         *gControlledVehicleIndex = -1;
     } else {
-        gVehicles[*gControlledVehicleIndex]->setToRestState();
-        gVehicleInputData[*gControlledVehicleIndex].setAnalogBrake(1.0f);
+        (*gVehicles)[*gControlledVehicleIndex]->setToRestState();
+        (*gVehicleInputData)[*gControlledVehicleIndex].setAnalogBrake(1.0f);
         --(*gControlledVehicleIndex);
-        *gControlledVehicleIndex %= *gNumVehicles;
+        *gControlledVehicleIndex %= gVehicles->size();
         vehicleReleaseAllControls(*gControlledVehicleIndex);
-        gVehicles[*gControlledVehicleIndex]->setToRestState();
-        gVehicles[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
-        gVehicles[*gControlledVehicleIndex]->mDriveDynData.setUseAutoGears(true);
-        gVehicleInputData[*gControlledVehicleIndex].setAnalogBrake(1.0f);
+        (*gVehicles)[*gControlledVehicleIndex]->setToRestState();
+        (*gVehicles)[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
+        (*gVehicles)[*gControlledVehicleIndex]->mDriveDynData.setUseAutoGears(true);
+        (*gVehicleInputData)[*gControlledVehicleIndex].setAnalogBrake(1.0f);
         PxTransform startTransform(PxVec3(0, 5.0f, 0), PxQuat(PxIdentity));
-        gVehicles[*gControlledVehicleIndex]->getRigidDynamicActor()->setGlobalPose(startTransform);
+        (*gVehicles)[*gControlledVehicleIndex]->getRigidDynamicActor()->setGlobalPose(startTransform);
     }
 }
 
 void
 PrototypePhysxPhysics::requestPreviousVehicleAccessControl()
 {
-    if (*gNumVehicles <= 0) {
+    if (gVehicles->empty()) {
         *gControlledVehicleIndex = -1;
     } else {
-        gVehicles[*gControlledVehicleIndex]->setToRestState();
-        gVehicleInputData[*gControlledVehicleIndex].setAnalogBrake(1.0f);
+        (*gVehicles)[*gControlledVehicleIndex]->setToRestState();
+        (*gVehicleInputData)[*gControlledVehicleIndex].setAnalogBrake(1.0f);
         ++(*gControlledVehicleIndex);
-        *gControlledVehicleIndex %= *gNumVehicles;
+        *gControlledVehicleIndex %= gVehicles->size();
         vehicleReleaseAllControls(*gControlledVehicleIndex);
-        gVehicles[*gControlledVehicleIndex]->setToRestState();
-        gVehicles[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
-        gVehicles[*gControlledVehicleIndex]->mDriveDynData.setUseAutoGears(true);
-        gVehicleInputData[*gControlledVehicleIndex].setAnalogBrake(1.0f);
-        PxTransform t = gVehicles[*gControlledVehicleIndex]->getRigidDynamicActor()->getGlobalPose();
+        (*gVehicles)[*gControlledVehicleIndex]->setToRestState();
+        (*gVehicles)[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
+        (*gVehicles)[*gControlledVehicleIndex]->mDriveDynData.setUseAutoGears(true);
+        (*gVehicleInputData)[*gControlledVehicleIndex].setAnalogBrake(1.0f);
+        PxTransform t = (*gVehicles)[*gControlledVehicleIndex]->getRigidDynamicActor()->getGlobalPose();
         PxTransform startTransform(PxVec3(t.p.x, 5.0f, t.p.z), PxQuat(PxIdentity));
-        gVehicles[*gControlledVehicleIndex]->getRigidDynamicActor()->setGlobalPose(startTransform);
+        (*gVehicles)[*gControlledVehicleIndex]->getRigidDynamicActor()->setGlobalPose(startTransform);
     }
 }
 
@@ -1665,25 +2179,25 @@ PrototypePhysxPhysics::controlledVehiclesSetGear(PrototypePhysicsVehicleGear gea
 void
 PrototypePhysxPhysics::controlledVehiclesToggleGearDirection()
 {
-    if (gVehicles[*gControlledVehicleIndex]->mDriveDynData.getCurrentGear() == PxVehicleGearsData::eREVERSE) {
-        gVehicles[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
+    if ((*gVehicles)[*gControlledVehicleIndex]->mDriveDynData.getCurrentGear() == PxVehicleGearsData::eREVERSE) {
+        (*gVehicles)[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
     } else {
-        gVehicles[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eREVERSE);
+        (*gVehicles)[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eREVERSE);
     }
 }
 
 void
 PrototypePhysxPhysics::controlledVehiclesFlip()
 {
-    if (*gNumVehicles > 0 && *gControlledVehicleIndex < *gNumVehicles && *gControlledVehicleIndex >= 0) {
+    if (!gVehicles->empty() && *gControlledVehicleIndex < gVehicles->size() && *gControlledVehicleIndex >= 0) {
         vehicleReleaseAllControls(*gControlledVehicleIndex);
-        gVehicles[*gControlledVehicleIndex]->setToRestState();
-        gVehicles[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
-        gVehicles[*gControlledVehicleIndex]->mDriveDynData.setUseAutoGears(true);
-        gVehicleInputData[*gControlledVehicleIndex].setAnalogBrake(1.0f);
-        PxTransform t = gVehicles[*gControlledVehicleIndex]->getRigidDynamicActor()->getGlobalPose();
+        (*gVehicles)[*gControlledVehicleIndex]->setToRestState();
+        (*gVehicles)[*gControlledVehicleIndex]->mDriveDynData.forceGearChange(PxVehicleGearsData::eFIRST);
+        (*gVehicles)[*gControlledVehicleIndex]->mDriveDynData.setUseAutoGears(true);
+        (*gVehicleInputData)[*gControlledVehicleIndex].setAnalogBrake(1.0f);
+        PxTransform t = (*gVehicles)[*gControlledVehicleIndex]->getRigidDynamicActor()->getGlobalPose();
         PxTransform startTransform(PxVec3(t.p.x, t.p.y + 1.0f, t.p.z), PxQuat(PxIdentity));
-        gVehicles[*gControlledVehicleIndex]->getRigidDynamicActor()->setGlobalPose(startTransform);
+        (*gVehicles)[*gControlledVehicleIndex]->getRigidDynamicActor()->setGlobalPose(startTransform);
     }
 }
 
@@ -1715,6 +2229,31 @@ void
 PrototypePhysxPhysics::onWindowDragDrop(i32 numFiles, const char** names)
 {}
 
+void*
+PrototypePhysxAllocator::allocate(size_t size, const char* typeName, const char* filename, int line)
+{
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+    void* ptr = _aligned_malloc(size, 16);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, 16, size) != 0) { ptr = nullptr; }
+#endif
+    PROTOTYPE_MEMORY_TAG(PrototypeMemoryTag_Physics)
+    PrototypeMemoryTracker::recordAllocation(ptr, size);
+    return ptr;
+}
+
+void
+PrototypePhysxAllocator::deallocate(void* ptr)
+{
+    PrototypeMemoryTracker::recordFree(ptr);
+#if defined(PROTOTYPE_PLATFORM_WINDOWS)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
 PrototypePhysxEventsCallback::PrototypePhysxEventsCallback() {}
 
 PrototypePhysxEventsCallback::~PrototypePhysxEventsCallback() {}
@@ -1727,10 +2266,11 @@ void
 PrototypePhysxEventsCallback::onWake(PxActor** actors, PxU32 count)
 {
     for (PxU32 i = 0; i < count; ++i) {
-        const char* name = ((PrototypeSceneNode*)((PrototypeObject*)actors[i]->userData)->parentNode())->name().c_str();
-        char        buf[256];
-        snprintf(buf, sizeof(buf), "OnWake(%s)", name);
-        PrototypeLogger::log(__FILE__, __LINE__, buf);
+        if (!actors[i]->userData) continue;
+        PrototypePhysicsEvent event = {};
+        event.type                  = PrototypePhysicsEventType_Wake;
+        event.object                = (PrototypeObject*)actors[i]->userData;
+        events.push_back(event);
     }
 }
 
@@ -1738,16 +2278,46 @@ void
 PrototypePhysxEventsCallback::onSleep(PxActor** actors, PxU32 count)
 {
     for (PxU32 i = 0; i < count; ++i) {
-        const char* name = ((PrototypeSceneNode*)((PrototypeObject*)actors[i]->userData)->parentNode())->name().c_str();
-        char        buf[256];
-        snprintf(buf, sizeof(buf), "OnSleep(%s)", name);
-        PrototypeLogger::log(__FILE__, __LINE__, buf);
+        if (!actors[i]->userData) continue;
+        PrototypePhysicsEvent event = {};
+        event.type                  = PrototypePhysicsEventType_Sleep;
+        event.object                = (PrototypeObject*)actors[i]->userData;
+        events.push_back(event);
     }
 }
 
 void
 PrototypePhysxEventsCallback::onContact(const PxContactPairHeader& pairHeader, const PxContactPair* pairs, PxU32 nbPairs)
-{}
+{
+    // ignore pairs when actors have been deleted
+    if (pairHeader.flags & (PxContactPairHeaderFlag::eREMOVED_ACTOR_0 | PxContactPairHeaderFlag::eREMOVED_ACTOR_1)) return;
+    if (!pairHeader.actors[0]->userData || !pairHeader.actors[1]->userData) return;
+
+    PxContactPairPoint points[PROTOTYPE_PHYSX_EVENT_CONTACT_POINTS];
+    for (PxU32 i = 0; i < nbPairs; ++i) {
+        const PxContactPair& pair = pairs[i];
+        if (pair.flags & (PxContactPairFlag::eREMOVED_SHAPE_0 | PxContactPairFlag::eREMOVED_SHAPE_1)) continue;
+
+        PrototypePhysicsEvent event = {};
+        event.object                = (PrototypeObject*)pairHeader.actors[0]->userData;
+        event.other                 = (PrototypeObject*)pairHeader.actors[1]->userData;
+        if (pair.events & PxPairFlag::eNOTIFY_TOUCH_FOUND) {
+            event.type            = PrototypePhysicsEventType_ContactFound;
+            const PxU32 numPoints = pair.extractContacts(points, PROTOTYPE_PHYSX_EVENT_CONTACT_POINTS);
+            if (numPoints > 0) {
+                event.position = { points[0].position.x, points[0].position.y, points[0].position.z };
+                // physx normals point from the second shape to the first one
+                event.normal = { points[0].normal.x, points[0].normal.y, points[0].normal.z };
+            }
+            for (PxU32 p = 0; p < numPoints; ++p) { event.impulse += points[p].impulse.magnitude(); }
+        } else if (pair.events & PxPairFlag::eNOTIFY_TOUCH_LOST) {
+            event.type = PrototypePhysicsEventType_ContactLost;
+        } else {
+            continue;
+        }
+        events.push_back(event);
+    }
+}
 
 void
 PrototypePhysxEventsCallback::onTrigger(PxTriggerPair* pairs, PxU32 count)
@@ -1756,26 +2326,16 @@ PrototypePhysxEventsCallback::onTrigger(PxTriggerPair* pairs, PxU32 count)
         // ignore pairs when shapes have been deleted
         if (pairs[i].flags & (PxTriggerPairFlag::eREMOVED_SHAPE_TRIGGER | PxTriggerPairFlag::eREMOVED_SHAPE_OTHER)) continue;
 
-        pairs[i].status;
         PxRigidActor* otherActor   = pairs[i].otherShape->getActor();
         PxRigidActor* triggerActor = pairs[i].triggerShape->getActor();
-
-        if (otherActor->userData && triggerActor->userData) {
-            auto otherObject   = (PrototypeObject*)otherActor->userData;
-            auto triggerObject = (PrototypeObject*)triggerActor->userData;
-            {
-                // loop on each attached script and call on trigger
-                // oa->getScriptTrait()->codeLinks
-                char buf[512];
-                snprintf(buf,
-                         sizeof(buf),
-                         "%s is triggered (%s) by %s",
-                         ((PrototypeSceneNode*)triggerObject->parentNode())->name().c_str(),
-                         pairs[i].status == PxPairFlag::Enum::eNOTIFY_TOUCH_LOST ? "lost" : "found",
-                         ((PrototypeSceneNode*)otherObject->parentNode())->name().c_str());
-                PrototypeLogger::log(__FILE__, __LINE__, buf);
-            }
-        }
+        if (!otherActor->userData || !triggerActor->userData) continue;
+
+        PrototypePhysicsEvent event = {};
+        event.type                  = PrototypePhysicsEventType_TriggerEnter;
+        event.object                = (PrototypeObject*)triggerActor->userData;
+        event.other                 = (PrototypeObject*)otherActor->userData;
+        if (pairs[i].status == PxPairFlag::eNOTIFY_TOUCH_LOST) { event.type = PrototypePhysicsEventType_TriggerExit; }
+        events.push_back(event);
     }
 }
 
@@ -22,26 +22,56 @@ using namespace physx;
 
 #include "../core/PrototypePhysics.h"
 
+#include <array>
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
-#define PROTOTYPE_MAX_NUM_VEHICLES 30
+// vehicles are simulated in slices of this size, each slice owns its suspension raycasts batch query and runs on its own task
+#define PROTOTYPE_PHYSX_VEHICLE_BATCH_SIZE 64
 
 struct PrototypeObject;
+struct PrototypeThreadpool;
+struct Transform;
 
 namespace snippetvehicle {
 struct VehicleSceneQueryData;
 }
 
+struct PrototypePhysxVehicleBatch;
+
+// the controller inputs plugins write through updateVehicleController, applied to the raw input data on the next update
+struct PhysxVehicleInput
+{
+    f32  acceleration;
+    f32  brake;
+    f32  steer;
+    bool dirty;
+};
+
 struct PhysxSceneData
 {
-    physx::PxScene*                                     scene;
-    snippetvehicle::VehicleSceneQueryData*              vehicleSceneQueryData;
-    physx::PxBatchQuery*                                batchQuery;
-    physx::PxVehicleDrivableSurfaceToTireFrictionPairs* frictionPairs;
-    physx::PxVehicleDrive4W*                            vehicles[PROTOTYPE_MAX_NUM_VEHICLES];
-    physx::PxVehicleDrive4WRawInputData                 vehicleInputData[PROTOTYPE_MAX_NUM_VEHICLES];
-    size_t                                              numVehicles;
-    size_t                                              controlledVehicleIndex;
+    physx::PxScene*                                        scene;
+    physx::PxVehicleDrivableSurfaceToTireFrictionPairs*    frictionPairs;
+    std::vector<physx::PxVehicleDrive4W*>                  vehicles;
+    std::vector<PrototypeObject*>                          vehicleObjects;         // chasis, by vehicle index
+    std::vector<physx::PxVehicleDrive4WRawInputData>       vehicleInputData;
+    std::array<std::vector<PhysxVehicleInput>, 2>          vehicleInputs;          // written by plugins / applied by update
+    size_t                                                 vehicleInputsWriteIndex;
+    std::vector<physx::PxWheelQueryResult>                 wheelQueryResults;      // 4 per vehicle
+    std::vector<physx::PxVehicleWheelQueryResult>          vehicleQueryResults;
+    std::vector<physx::PxVehicleWheelConcurrentUpdateData> wheelConcurrentUpdates; // 4 per vehicle
+    std::vector<physx::PxVehicleConcurrentUpdateData>      vehicleConcurrentUpdates;
+    std::vector<PrototypePhysxVehicleBatch*>               vehicleBatches;
+    size_t                                                 controlledVehicleIndex;
+};
+
+// a scene stepped by the current update, every due scene starts simulating before any of them gets waited on
+struct PhysxSceneStep
+{
+    PhysxSceneData* sceneData;
+    f32             timestep;
 };
 
 struct PrototypePhysxEventsCallback : public PxSimulationEventCallback
@@ -54,6 +84,69 @@ struct PrototypePhysxEventsCallback : public PxSimulationEventCallback
     void onContact(const PxContactPairHeader& pairHeader, const PxContactPair* pairs, PxU32 nbPairs) final;
     void onTrigger(PxTriggerPair* pairs, PxU32 count) final;
     void onAdvance(const PxRigidBody* const* bodyBuffer, const PxTransform* poseBuffer, const PxU32 count) final;
+
+    // filled while fetching the simulation results, cleared at the start of every update
+    std::vector<PrototypePhysicsEvent> events;
+};
+
+// runs the PhysX tasks on the engine threadpool at high priority instead of letting PhysX spawn workers of its own,
+// so the simulation shares the cores with the rest of the engine rather than oversubscribing them
+struct PrototypePhysxCpuDispatcher final : public PxCpuDispatcher
+{
+    explicit PrototypePhysxCpuDispatcher(PrototypeThreadpool* threadpool);
+    ~PrototypePhysxCpuDispatcher() final = default;
+
+    void  submitTask(PxBaseTask& task) final;
+    PxU32 getWorkerCount() const final;
+
+  private:
+    PrototypeThreadpool* _threadpool;
+};
+
+// work handed to one of the dispatcher workers, release() only counts down the caller's pending tasks
+// since the tasks are owned and reused by PrototypePhysxPhysics
+struct PrototypePhysxTask : public PxBaseTask
+{
+    void    addReference() final;
+    void    removeReference() final;
+    int32_t getReference() const final;
+    void    release() final;
+
+    std::atomic<size_t>* pending;
+};
+
+// a slice of a query batch
+struct PrototypePhysxQueryTask final : public PrototypePhysxTask
+{
+    void        run() final;
+    const char* getName() const final;
+
+    PxScene*                     scene;
+    const PrototypePhysicsQuery* queries;
+    PrototypePhysicsQueryHit*    hits;
+    size_t                       count;
+};
+
+// a slice of the scene vehicles, smooths their inputs then runs their suspension raycasts and PxVehicleUpdates,
+// the results are written to the concurrent update data and applied by PxVehiclePostUpdates on the calling thread
+struct PrototypePhysxVehicleBatch final : public PrototypePhysxTask
+{
+    void        run() final;
+    const char* getName() const final;
+
+    snippetvehicle::VehicleSceneQueryData* sceneQueryData;
+    physx::PxBatchQuery*                   batchQuery;
+    PhysxSceneData*                        sceneData;
+    size_t                                 begin;
+    size_t                                 end;
+    f32                                    timestep;
+};
+
+// 16 bytes aligned like PxDefaultAllocator, reports every allocation to the memory tracker under the physics tag
+struct PrototypePhysxAllocator : public PxAllocatorCallback
+{
+    void* allocate(size_t size, const char* typeName, const char* filename, int line) final;
+    void  deallocate(void* ptr) final;
 };
 
 struct PrototypePhysxPhysics final : PrototypePhysics
@@ -89,11 +182,35 @@ struct PrototypePhysxPhysics final : PrototypePhysics
     // check if simulation is playing
     bool isPlaying() final;
 
+    // switch the lockstep mode on or off, call before the first record pass so the scenes get created accordingly
+    void setLockstep(const PrototypePhysicsLockstep& lockstep) final;
+
+    // current lockstep mode
+    const PrototypePhysicsLockstep& lockstep() final;
+
+    // hash of the object ids, poses and velocities of the dynamic bodies of the current scene as of the last step
+    u64 stateHash() final;
+
     // force move the rigidbody from a random transformation, overwrite the simulation constraints and forces etc ..
     void overrideRigidbodyGlobalPos(PrototypeObject* object) final;
 
-    // shoot a ray to the unknown from a point and a direction and length of the ray
-    std::optional<PrototypeObject*> raycast(const glm::vec3& origin, const glm::vec3& dir, const f32 length) final;
+    // shoot a ray to the unknown from a point and a direction and length of the ray, restricted to the layers of layerMask
+    std::optional<PrototypeObject*> raycast(const glm::vec3& origin, const glm::vec3& dir, const f32 length, u32 layerMask) final;
+
+    // run count queries split across the physics worker threads and wait for them, hits[i] is the result of queries[i]
+    void queryBatch(const PrototypePhysicsQuery* queries, size_t count, PrototypePhysicsQueryHit* hits) final;
+
+    // queue count queries to run as a batch at the end of the next update after the simulation step
+    void submitQueryBatch(const PrototypePhysicsQuery* queries, size_t count, PrototypePhysicsQueryHit* hits) final;
+
+    // how the physics scene of the named PrototypeScene gets stepped
+    void setSceneActivity(const std::string& sceneName, PrototypePhysicsSceneActivity_ activity, f32 rate) final;
+
+    // pair counts of the last step of the current scene, straight from the PhysX simulation statistics
+    void fetchStatistics(PrototypePhysicsStatistics& statistics) final;
+
+    // contact, trigger and sleep events reported by the scenes stepped during the last update
+    const std::vector<PrototypePhysicsEvent>& events() final;
 
     // get the model matrix for the given rigidbody
     void fetchModelMatrix(void* rigidbody, void* shape, glm::mat4& model) final;
@@ -145,6 +262,9 @@ struct PrototypePhysxPhysics final : PrototypePhysics
     // update the rigidbody for whther it's trigger or not
     void updateRigidbodyTrigger(PrototypeObject* object) final;
 
+    // update which physics events get generated for the rigidbody, they're packed next to the collision layer in word3
+    void updateRigidbodyEvents(PrototypeObject* object) final;
+
     // overwrite the simulation's linear velocity for the given object's rigidbody
     void updateRigidbodyLinearVelocity(PrototypeObject* object) final;
 
@@ -169,6 +289,9 @@ struct PrototypePhysxPhysics final : PrototypePhysics
     // changes collider for the given object
     void updateCollider(PrototypeObject* object, const std::string& shapeName) final;
 
+    // moves the collider of the given object to the collision layer of its collider trait
+    void updateColliderLayer(PrototypeObject* object) final;
+
     // scales collider for the given object
     void scaleCollider(PrototypeObject* object, const glm::vec3& scale) final;
 
@@ -178,6 +301,16 @@ struct PrototypePhysxPhysics final : PrototypePhysics
     // destroys a rigidbody
     void destroyRigidbody(void* rigidbody) final;
 
+    // queues the rigidbodies created or reactivated until endActorBatch and adds them to the scene at once
+    void beginActorBatch() final;
+    void endActorBatch() final;
+
+    // takes the rigidbody of the object out of the simulation without destroying it, or puts it back
+    void setRigidbodyActive(PrototypeObject* object, bool active) final;
+
+    // creates the actors of objects that joined the current scene after its physics scene got recorded
+    void createActors(PrototypeObject* const* objects, size_t count) final;
+
     // spawn a new vehicle
     void spawnVehicle() final;
 
@@ -221,30 +354,63 @@ struct PrototypePhysxPhysics final : PrototypePhysics
     void onWindowDragDrop(i32 numFiles, const char** names) final;
 
   private:
+    // creates the actor of the object out of its collider trait shape
+    void                               createColliderActor(PrototypeObject* object);
     static snippetvehicle::VehicleDesc vehicleInitDesc();
     static void                        vehicleReleaseAllControls(size_t vehicleIndex);
-    static void                        internalCreateConvexMeshCollider(PrototypeObject* object, PxConvexMesh* convexMesh);
+    // copies the chasis and wheels poses of the scene vehicle at the given dense index back to their transforms
+    static void vehicleSyncTransforms(PhysxSceneData& sceneData, size_t vehicleIndex);
+    // applies the controller inputs written since the last update, swaps the inputs buffers under gVehicleInputsLock
+    static void vehicleApplyInputs(PhysxSceneData& sceneData);
+    // hands the scene vehicle batches to the dispatcher, each batch counts pending down once it's done
+    static void vehicleSubmitBatches(PhysxSceneData& sceneData, f32 timestep, std::atomic<size_t>& pending);
+    // applies the batches results to the scene vehicles and syncs their transforms
+    static void vehiclePostUpdates(PhysxSceneData& sceneData);
+    // copies the actors that moved during the last step of the scene back to their objects
+    static void pullActiveActors(PxScene* scene);
+    // the time to step the named scene by this update given its activity, 0 when it shouldn't be stepped
+    static f32 sceneTimestep(const std::string& sceneName, f32 deltaTime);
+    // copies the simulated pose (and velocities when asked) of the actor back to the object's traits
+    static void pullRigidbody(PrototypeObject* object, PxRigidDynamic* rigidDynamicActor, bool syncVelocities);
+    // moves the actor to the transform that was edited outside the simulation
+    static void pushRigidbody(Transform* tr, PxRigidActor* actor);
+    // Transform physics sync handler, collects the objects to push on the next update
+    static void PROTOTYPE_DYNAMIC_FN_CALL onTransformPhysicsSync(PrototypeObject* object);
+    static void                           internalCreateConvexMeshCollider(PrototypeObject* object, PxConvexMesh* convexMesh);
+    // puts the shape on the collision layer, the simulation filter data word3 holds the layer index and the events bits for
+    // the filter shader and the query filter data word0 holds the layer bit for the raycasts layer masks
+    static void shapeSetFilterData(PxShape* shape, u32 layer, u32 events);
+    // adds the actor to the current scene, or queues it while an actor batch is open
+    static void sceneAddActor(PxRigidActor* actor);
 
     static PrototypePhysxEventsCallback*                       gEventsCallback;
-    static physx::PxDefaultAllocator                           gAllocator;
+    static PrototypePhysxAllocator                             gAllocator;
     static physx::PxFoundation*                                gFoundation;
     static physx::PxPhysics*                                   gPhysics;
-    static physx::PxDefaultCpuDispatcher*                      gDispatcher;
+    static PrototypePhysxCpuDispatcher*                        gDispatcher;
     static physx::PxCooking*                                   gCooking;
     static physx::PxScene*                                     gScene;
     static physx::PxMaterial*                                  gMaterial;
     static physx::PxPvd*                                       gPvd;
-    static snippetvehicle::VehicleSceneQueryData*              gVehicleSceneQueryData;
-    static physx::PxBatchQuery*                                gBatchQuery;
     static physx::PxVehicleDrivableSurfaceToTireFrictionPairs* gFrictionPairs;
-    static physx::PxVehicleDrive4W**                           gVehicles;
-    static physx::PxVehicleDrive4WRawInputData*                gVehicleInputData;
-    static size_t*                                             gNumVehicles;
+    static PhysxSceneData*                                     gSceneData;
+    static std::vector<physx::PxVehicleDrive4W*>*              gVehicles;
+    static std::vector<PrototypeObject*>*                      gVehicleObjects;
+    static std::vector<physx::PxVehicleDrive4WRawInputData>*   gVehicleInputData;
     static size_t*                                             gControlledVehicleIndex;
-    // query data
-    static std::array<PxWheelQueryResult, PROTOTYPE_MAX_NUM_VEHICLES * 4>    gWheelQueryResults;
-    static std::array<PxVehicleWheelQueryResult, PROTOTYPE_MAX_NUM_VEHICLES> gVehiclesQueryResults;
-    static bool                                                              _isPlaying;
-    bool                                                                     _needsRecord;
-    static std::unordered_map<std::string, PhysxSceneData>                   _scenes;
+    // guards the write side of the vehicle inputs, plugins may update their vehicles from any thread
+    static std::mutex                                          gVehicleInputsLock;
+    static std::vector<PrototypeObject*>                       gPhysicsSyncObjects;
+    static std::vector<physx::PxActor*>                        gPendingActors;
+    static bool                                                gActorBatch;
+    static bool                                                _isPlaying;
+    bool                                                       _needsRecord;
+    PrototypePhysicsLockstep                                   _lockstep;
+    std::vector<PrototypePhysicsQueryBatch>                    _queryBatches;
+    static std::unordered_map<std::string, PhysxSceneData>     _scenes;
+
+    // stepping policy by scene name, scenes without an entry are active
+    static std::unordered_map<std::string, PrototypePhysicsSceneActivity> _sceneActivities;
+    // the scenes stepped by the current update
+    static std::vector<PhysxSceneStep> gSceneSteps;
 };
\ No newline at end of file
@@ -2384,7 +2384,7 @@ PrototypeVulkanRenderer::updateUniformBuffer(u32 currentImageIndex)
     PtvUniformBufferObject ubo          = {};
     for (size_t r = 0; r < renderedObjects.size(); ++r) {
         Transform* transform    = renderedObjects[r]->getTransformTrait();
-        ubo.transforms[r].model = transform->modelScaled();
+        ubo.transforms[r].model = transform->worldModelScaled();
     }
 
     Camera* cam           = _mainCamera.object->getCameraTrait();
@@ -50,10 +50,9 @@ onCameraEditDispatch(PrototypeObject* o)
         if (ImGui::BeginPopupContextItem(buff)) {
             if (ImGui::Selectable("Delete " PrototypeTraitTypeAbsoluteStringCamera " trait")) {
                 PrototypePipelineQueue queue = {};
-                auto cmd       = std::make_unique<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
+                auto cmd       = queue.record<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
                 cmd->object    = o;
                 cmd->traitMask = PrototypeTraitTypeMaskCamera;
-                queue.record(std::move(cmd));
                 PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
             }
             ImGui::EndPopup();
@@ -207,10 +206,9 @@ onColliderEditDispatch(PrototypeObject* o)
         if (ImGui::BeginPopupContextItem(buff)) {
             if (ImGui::Selectable("Delete " PrototypeTraitTypeAbsoluteStringCollider " trait")) {
                 PrototypePipelineQueue queue = {};
-                auto cmd       = std::make_unique<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
+                auto cmd       = queue.record<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
                 cmd->object    = o;
                 cmd->traitMask = PrototypeTraitTypeMaskCollider;
-                queue.record(std::move(cmd));
                 PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
             }
             ImGui::EndPopup();
@@ -247,10 +245,9 @@ onMeshRendererEditDispatch(PrototypeObject* o)
         if (ImGui::BeginPopupContextItem(buff)) {
             if (ImGui::Selectable("Delete " PrototypeTraitTypeAbsoluteStringMeshRenderer " trait")) {
                 PrototypePipelineQueue queue = {};
-                auto cmd       = std::make_unique<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
+                auto cmd       = queue.record<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
                 cmd->object    = o;
                 cmd->traitMask = PrototypeTraitTypeMaskMeshRenderer;
-                queue.record(std::move(cmd));
                 PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
             }
             ImGui::EndPopup();
@@ -359,10 +356,9 @@ onRigidbodyEditDispatch(PrototypeObject* o)
         if (ImGui::BeginPopupContextItem(buff)) {
             if (ImGui::Selectable("Delete " PrototypeTraitTypeAbsoluteStringRigidbody " trait")) {
                 PrototypePipelineQueue queue = {};
-                auto cmd       = std::make_unique<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
+                auto cmd       = queue.record<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
                 cmd->object    = o;
                 cmd->traitMask = PrototypeTraitTypeMaskRigidbody;
-                queue.record(std::move(cmd));
                 PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
             }
             ImGui::EndPopup();
@@ -505,10 +501,9 @@ onTransformEditDispatch(PrototypeObject* o)
         if (ImGui::BeginPopupContextItem(buff)) {
             if (ImGui::Selectable("Delete " PrototypeTraitTypeAbsoluteStringTransform " trait")) {
                 PrototypePipelineQueue queue = {};
-                auto cmd       = std::make_unique<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
+                auto cmd       = queue.record<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeRemoveTraits>();
                 cmd->object    = o;
                 cmd->traitMask = PrototypeTraitTypeMaskTransform;
-                queue.record(std::move(cmd));
                 PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
             }
             ImGui::EndPopup();
@@ -1167,16 +1162,14 @@ PrototypeVulkanUI::drawFrame(u32 fbid, i32 width, i32 height)
                             if (ImGui::BeginPopupContextItem()) {
                                 if (ImGui::Selectable("Add child node")) {
                                     PrototypePipelineQueue queue = {};
-                                    auto cmd = std::make_unique<PrototypePipelineCommand_shortcutEditorAddSceneNodeToNode>();
+                                    auto cmd = queue.record<PrototypePipelineCommand_shortcutEditorAddSceneNodeToNode>();
                                     cmd->parentNode = node;
-                                    queue.record(std::move(cmd));
                                     PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                                 }
                                 if (ImGui::Selectable("Delete")) {
                                     PrototypePipelineQueue queue = {};
-                                    auto cmd  = std::make_unique<PrototypePipelineCommand_shortcutEditorRemoveSceneNode>();
+                                    auto cmd  = queue.record<PrototypePipelineCommand_shortcutEditorRemoveSceneNode>();
                                     cmd->node = node;
-                                    queue.record(std::move(cmd));
                                     PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                                 }
                                 for (size_t itrait = 0; itrait < PrototypeTraitTypeCount; ++itrait) {
@@ -1184,10 +1177,9 @@ PrototypeVulkanUI::drawFrame(u32 fbid, i32 width, i32 height)
                                           ("Add " + PrototypeTraitTypeAbsoluteStringArray[itrait] + " trait").c_str())) {
                                         PrototypePipelineQueue queue = {};
                                         auto                   cmd =
-                                          std::make_unique<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeAddTraits>();
+                                          queue.record<PrototypePipelineCommand_shortcutEditorSelectedSceneNodeAddTraits>();
                                         cmd->object    = node->object().value();
                                         cmd->traitMask = (1 << itrait);
-                                        queue.record(std::move(cmd));
                                         PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                                     }
                                 }
@@ -1250,9 +1242,8 @@ PrototypeVulkanUI::drawFrame(u32 fbid, i32 width, i32 height)
                             if (ImGui::BeginPopupContextItem()) {
                                 if (ImGui::Selectable("Add child node")) {
                                     PrototypePipelineQueue queue = {};
-                                    auto cmd = std::make_unique<PrototypePipelineCommand_shortcutEditorAddSceneNodeToLayer>();
+                                    auto cmd = queue.record<PrototypePipelineCommand_shortcutEditorAddSceneNodeToLayer>();
                                     cmd->parentLayer = layer;
-                                    queue.record(std::move(cmd));
                                     PrototypePipelines::shortcutsQueue.push_back(std::move(queue));
                                 }
                                 ImGui::EndPopup();
@@ -110,7 +110,7 @@ PrototypeVulkanUiSceneView::onDrawFrame(PrototypeUIState_ state, void* awesomeFo
                     Camera* cam = _camera->object->getCameraTrait();
 
                     static glm::mat4 SelectedModelMatrix;
-                    SelectedModelMatrix = tr->modelScaled();
+                    SelectedModelMatrix = tr->worldModelScaled();
                     ImGuizmo::Manipulate(&cam->viewMatrix()[0][0],
                                          &cam->projectionMatrix()[0][0],
                                          _guizmoOperation,
@@ -124,7 +124,7 @@ PrototypeVulkanUiSceneView::onDrawFrame(PrototypeUIState_ state, void* awesomeFo
                     if (ImGuizmo::IsUsing()) {
                         state |= PrototypeUIState_GuizmoUsed;
                         _isUsingGuizmo = true;
-                        tr->setModelScaled(&SelectedModelMatrix[0][0]);
+                        tr->setWorldModelScaled(&SelectedModelMatrix[0][0]);
                         tr->updateComponentsFromMatrix();
                         if (_guizmoOperation == ImGuizmo::OPERATION::SCALE) {
                             PrototypeEngineInternalApplication::physics->scaleCollider(selectedObject, tr->scale());
@@ -410,7 +410,7 @@ PrototypeVulkanUiSceneView::onSceneViewClick(const glm::vec2& coordinates, const
       ray, camViewMatrix, camProjectionMatrix, coordinates.x, coordinates.y, Size.x, Size.y);
 
     auto optHit =
-      PrototypeEngineInternalApplication::physics->raycast({ camPosition.x, camPosition.y, camPosition.z }, ray, cam->zfar());
+      PrototypeEngineInternalApplication::physics->raycast({ camPosition.x, camPosition.y, camPosition.z }, ray, cam->zfar(), 0);
     if (optHit.has_value()) {
         auto hit = optHit.value();
         if (hit && hit->parentNode()) {
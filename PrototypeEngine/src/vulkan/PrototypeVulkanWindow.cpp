@@ -23,6 +23,7 @@
 #include "../core/PrototypeEngine.h"
 #include "../core/PrototypeDatabase.h"
 #include "../core/PrototypePluginInstance.h"
+#include "../core/PrototypeRecorder.h"
 #include "../core/PrototypeScene.h"
 
 #include <PrototypeCommon/Logger.h>
@@ -87,6 +88,8 @@ PrototypeVulkanWindow::init(i32 width, i32 height)
     if (!glfwInit()) { PrototypeLogger::fatal("Failed to initialize glfw %s:%i", __FILE__, __LINE__); }
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
     glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
+    // benchmarks and replays run headless
+    if (PrototypeEngineInternalApplication::headless) { glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); }
     _handle = glfwCreateWindow(
       (i32)_resolution.x, (i32)_resolution.y, "Prototype [" PROTOTYPE_TARGET_NAME "] [VULKAN]", nullptr, nullptr);
     if (!_handle) {
@@ -122,16 +125,24 @@ PrototypeVulkanWindow::deInit()
 void
 PrototypeVulkanWindow::setSize(i32 width, i32 height)
 {
-    prototypeWindowGlfwWindowSizeCallback(_handle, width, height);
+    if (width < 1 || height < 1) { return; }
+    onWindowResizeFn(width, height);
 }
 
 bool
 PrototypeVulkanWindow::update()
 {
-    _deltaTime = glfwGetTime() - _time;
-    _time      = glfwGetTime();
-
-    glfwPollEvents();
+    PrototypeRecorder* recorder = PrototypeEngineInternalApplication::recorder;
+    if (recorder->isReplaying()) {
+        // live events are dropped by the callbacks, the recorded ones get dispatched instead
+        glfwPollEvents();
+        if (!recorder->replayFrame(this, _time, _deltaTime)) { PrototypeEngineInternalApplication::shouldQuit = true; }
+    } else {
+        _deltaTime = glfwGetTime() - _time;
+        _time      = glfwGetTime();
+        recorder->recordFrame(_time, _deltaTime);
+        glfwPollEvents();
+    }
 
     return glfwWindowShouldClose(_handle) || PrototypeEngineInternalApplication::shouldQuit;
 }
@@ -554,6 +565,7 @@ static void
 prototypeWindowGlfwWindowSizeCallback(GLFWwindow* handle, i32 width, i32 height)
 {
     if (width < 1 || height < 1) { return; }
+    if (!PrototypeEngineInternalApplication::recorder->captureWindowResize(width, height)) { return; }
     PrototypeVulkanWindow* window = static_cast<PrototypeVulkanWindow*>(glfwGetWindowUserPointer(handle));
     window->onWindowResizeFn(width, height);
 }
@@ -561,6 +573,7 @@ prototypeWindowGlfwWindowSizeCallback(GLFWwindow* handle, i32 width, i32 height)
 static void
 prototypeWindowGlfwMouseBtnCallback(GLFWwindow* handle, i32 button, i32 action, i32 mods)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureMouse(button, action, mods)) { return; }
     PrototypeVulkanWindow* window = static_cast<PrototypeVulkanWindow*>(glfwGetWindowUserPointer(handle));
     window->onMouseFn(button, action, mods);
 }
@@ -568,6 +581,7 @@ prototypeWindowGlfwMouseBtnCallback(GLFWwindow* handle, i32 button, i32 action,
 static void
 prototypeWindowGlfwCursorPosCallback(GLFWwindow* handle, f64 xpos, f64 ypos)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureMouseMove(xpos, ypos)) { return; }
     PrototypeVulkanWindow* window = static_cast<PrototypeVulkanWindow*>(glfwGetWindowUserPointer(handle));
     window->onMouseMoveFn(xpos, ypos);
 }
@@ -575,6 +589,7 @@ prototypeWindowGlfwCursorPosCallback(GLFWwindow* handle, f64 xpos, f64 ypos)
 static void
 prototypeWindowGlfwScrollCallback(GLFWwindow* handle, f64 xoffset, f64 yoffset)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureMouseScroll(xoffset, yoffset)) { return; }
     PrototypeVulkanWindow* window = static_cast<PrototypeVulkanWindow*>(glfwGetWindowUserPointer(handle));
     window->onMouseScrollFn(xoffset, yoffset);
 }
@@ -582,6 +597,7 @@ prototypeWindowGlfwScrollCallback(GLFWwindow* handle, f64 xoffset, f64 yoffset)
 static void
 prototypeWindowGlfwKeyCallback(GLFWwindow* handle, i32 key, i32 scancode, i32 action, i32 mods)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureKeyboard(key, scancode, action, mods)) { return; }
     PrototypeVulkanWindow* window = static_cast<PrototypeVulkanWindow*>(glfwGetWindowUserPointer(handle));
     window->onKeyboardFn(key, scancode, action, mods);
 }
@@ -593,6 +609,7 @@ prototypeWindowGlfwCharCallback(GLFWwindow* handle, unsigned char c)
 static void
 prototypeWindowGlfwDropCallback(GLFWwindow* handle, i32 numFiles, const char** names)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureWindowDragDrop(numFiles, names)) { return; }
     PrototypeVulkanWindow* window = static_cast<PrototypeVulkanWindow*>(glfwGetWindowUserPointer(handle));
     window->onWindowDragDropFn(numFiles, names);
 }
@@ -600,6 +617,7 @@ prototypeWindowGlfwDropCallback(GLFWwindow* handle, i32 numFiles, const char** n
 static void
 prototypeWindowGlfwIconifyCallback(GLFWwindow* handle, int status)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureWindowIconify(status == GLFW_TRUE)) { return; }
     PrototypeVulkanWindow* window = static_cast<PrototypeVulkanWindow*>(glfwGetWindowUserPointer(handle));
     if (status == GLFW_TRUE) {
         window->onWindowIconifyFn();
@@ -611,6 +629,7 @@ prototypeWindowGlfwIconifyCallback(GLFWwindow* handle, int status)
 static void
 prototypeWindowGlfwMaximizeCallback(GLFWwindow* handle, int status)
 {
+    if (!PrototypeEngineInternalApplication::recorder->captureWindowMaximize(status == GLFW_TRUE)) { return; }
     PrototypeVulkanWindow* window = static_cast<PrototypeVulkanWindow*>(glfwGetWindowUserPointer(handle));
     if (status == GLFW_TRUE) {
         window->onWindowMaximizeFn();
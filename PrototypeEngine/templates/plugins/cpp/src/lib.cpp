@@ -59,6 +59,9 @@ R"~~#%#~~(
 //             PluginUpdateProtocol() <--- Called every tick, regular update function called in the game loop before rendering ..
 //         PluginEndProtocol()        <--- Called when plugin is dettached from an object or when the object gets destroyed
 // PluginUnloadProtocol()             <--- Called once the engine exits or when you delete the plugin from the engine (unlinkely)
+//
+// PluginUpdateBatchProtocol() can replace PluginUpdateProtocol() with a single call per tick for all the objects, see below
+// PluginSerializeProtocol() and PluginDeserializeProtocol() keep the plugin state over a hot reload, see below
 
 // Called when:
 //     - The engine loads the plugin on startup
@@ -110,6 +113,65 @@ PluginUpdateProtocol(void* object)
     return true;
 }
 
+// Uncomment to update every object attached to this plugin in one call per tick instead of one call per object,
+// PluginUpdateProtocol is no longer called once it is exported
+//
+// Note:
+//     - Export PluginIsUpdateBatchThreadSafe returning true to get the objects split in ranges updated concurrently,
+//       only do so when an update touches nothing but its own objects and never spawns, destroys or moves colliders
+//     - A thread-safe batch may only call these from the range it's given:
+//           Time, DeltaTime
+//           TransformTraitGet* and TransformTraitSet* (one or many objects), TransformTraitTranslate,
+//           TransformTraitRotate, on objects of the range that have no collider
+//           PhysicsRaycastFromLocationAndDirection, PhysicsQueryBatch (no overlap queries with the bullet backend)
+//           FrameAllocate, FrameGetMarker, FrameRewind
+//           TraceBeginZone, TraceEndZone, TraceCounter, consoleLog
+//       everything else (spawning, releasing, traits, cameras, rigidbodies, streaming, submitted query batches,
+//       physics settings) runs on the main thread only
+//     - While a session is recorded or replayed, or physics runs in lockstep, the ranges run one after the other on
+//       the main thread so the calls land in the recorded order
+// PROTOTYPE_PLUGIN_EXTERN PROTOTYPE_PLUGIN_API bool
+// PluginUpdateBatchProtocol(void* const* objects, uint32_t count)
+// {
+//     for (uint32_t i = 0; i < count; ++i) { PluginUpdateProtocol(objects[i]); }
+//     return true;
+// }
+//
+// PROTOTYPE_PLUGIN_EXTERN PROTOTYPE_PLUGIN_API bool
+// PluginIsUpdateBatchThreadSafe()
+// {
+//     return false;
+// }
+
+// Uncomment to carry the plugin state over a hot reload, the objects are then neither ended nor started again and
+// PluginDeserializeProtocol of the recompiled plugin gets the bytes written here right after PluginReloadProtocol
+//
+// Note:
+//     - PluginSerializeProtocol is called with a null buffer first and must return the size it needs
+//     - Only write plain values, pointers into the unloaded plugin are dangling once the recompiled one is loaded
+//     - Return false from PluginDeserializeProtocol when the layout changed, PluginStartProtocol is called again instead
+// struct PluginState
+// {
+//     uint32_t version;
+//     float    elapsed;
+// };
+// static PluginState state = { 1, 0.0f };
+//
+// PROTOTYPE_PLUGIN_EXTERN PROTOTYPE_PLUGIN_API uint64_t
+// PluginSerializeProtocol(void* buffer, uint64_t capacity)
+// {
+//     if (buffer && capacity >= sizeof(state)) { memcpy(buffer, &state, sizeof(state)); }
+//     return sizeof(state);
+// }
+//
+// PROTOTYPE_PLUGIN_EXTERN PROTOTYPE_PLUGIN_API bool
+// PluginDeserializeProtocol(const void* buffer, uint64_t size)
+// {
+//     if (size != sizeof(state) || ((const PluginState*)buffer)->version != state.version) { return false; }
+//     memcpy(&state, buffer, sizeof(state));
+//     return true;
+// }
+
 // Called when:
 //     - The plugin is dettached from an object's script trait
 //     - The plugin is reloaded, before loading the newer compiled version of the plugin
@@ -202,4 +264,11 @@ PluginOnWindowMaximize(void* object)
 PROTOTYPE_PLUGIN_EXTERN PROTOTYPE_PLUGIN_API void
 PluginOnWindowMaximizeRestore(void* object)
 {}
+
+// Called when:
+//     - The last physics update reported contact, trigger or sleep events of the rigidbodies that opted in
+//       through PhysicsSetObjectEvents, once per frame before the scripts update with all of them
+PROTOTYPE_PLUGIN_EXTERN PROTOTYPE_PLUGIN_API void
+PluginOnPhysicsEvents(const PhysicsEvent* events, uint32_t count)
+{}
 )~~#%#~~"
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #if defined(__EMSCRIPTEN__)
@@ -125,6 +126,10 @@ ReloadContext(PrototypeEngineContext* engineContext, PrototypeLoggerData* logger
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
 ObjectDestroy(void* object);
 
+// Destroys every given object and removes them from scene, null objects are skipped
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+ObjectsDestroy(void* const* objects, uint32_t count);
+
 // Returns the id of the given object
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
 ObjectGetId(void* object, int64_t* id);
@@ -320,6 +325,19 @@ ObjectHasRigidbodyTrait(void* object);
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
 ObjectRemoveRigidbodyTrait(void* object);
 
+// Bulk access to the velocities of many rigidbodies at once, same rules as the transform bulk functions
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+RigidbodyTraitGetLinearVelocities(void* const* objects, uint32_t count, FieldVec3* velocities, uint32_t stride);
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+RigidbodyTraitSetLinearVelocities(void* const* objects, uint32_t count, const FieldVec3* velocities, uint32_t stride);
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+RigidbodyTraitGetAngularVelocities(void* const* objects, uint32_t count, FieldVec3* velocities, uint32_t stride);
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+RigidbodyTraitSetAngularVelocities(void* const* objects, uint32_t count, const FieldVec3* velocities, uint32_t stride);
+
 // ----------------------------------------------------------------------------------------------------------
 
 // ----------------------------------------------------------------------------------------------------------
@@ -388,6 +406,36 @@ TransformTraitTranslate(void* object, const FieldVec3& direction, float velocity
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
 TransformTraitRotate(void* object, const FieldVec3& angle, float velocity);
 
+// Bulk versions of the functions above, one call reads or writes the transforms of many objects
+// The work is split across the engine threads, prefer them over a loop of single object calls
+// Note: stride is the distance in bytes between two consecutive values, pass 0 when they are tightly packed
+// Note: an object must not be listed twice in the same call, objects without a transform trait are skipped
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitGetTranslations(void* const* objects, uint32_t count, FieldVec3* translations, uint32_t stride);
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitSetTranslations(void* const* objects, uint32_t count, const FieldVec3* translations, uint32_t stride);
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitGetRotations(void* const* objects, uint32_t count, FieldVec3* eulerAngles, uint32_t stride);
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitSetRotations(void* const* objects, uint32_t count, const FieldVec3* eulerAngles, uint32_t stride);
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitGetScales(void* const* objects, uint32_t count, FieldVec3* scales, uint32_t stride);
+
+// Note: sets the scales, unlike TransformTraitSetScale which adds to them
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitSetScales(void* const* objects, uint32_t count, const FieldVec3* scales, uint32_t stride);
+
+// Model matrices with the scale applied
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitGetModels(void* const* objects, uint32_t count, FieldMat4* models, uint32_t stride);
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitSetModels(void* const* objects, uint32_t count, const FieldMat4* models, uint32_t stride);
+
 // ----------------------------------------------------------------------------------------------------------
 
 // ----------------------------------------------------------------------------------------------------------
@@ -426,6 +474,85 @@ spawnConvexMesh(const char* name);
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
 spawnTriMesh(const char* name);
 
+// Spawns count rigidbody cubes at the given positions, velocities can be null to spawn them at rest
+// objects receives the spawned objects when it isn't null, null entries failed to spawn
+// Note: strides work the same as in the transform bulk functions
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+ObjectsSpawnCubes(uint32_t         count,
+                  const FieldVec3* positions,
+                  uint32_t         positionsStride,
+                  const FieldVec3* velocities,
+                  uint32_t         velocitiesStride,
+                  void**           objects);
+
+// Shape of the objects ObjectsSpawnBatch spawns
+enum SpawnShape
+{
+    SpawnShape_Cube       = 0,
+    SpawnShape_Sphere     = 1,
+    SpawnShape_ConvexMesh = 2 // cooked once per pooled object, reused objects skip the cooking
+};
+
+// Spawns count rigidbody objects of the same shape, mesh, material and collision layer at once,
+// objects released with ObjectsRelease are handed out again before any new one gets created
+// mesh is only read for convex meshes, material and layerName can be null for the defaults
+// rotations (euler angles) and velocities can be null, objects receives the spawned objects when it isn't null
+// Note: strides work the same as in the transform bulk functions
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+ObjectsSpawnBatch(uint32_t         shape,
+                  const char*      mesh,
+                  const char*      material,
+                  const char*      layerName,
+                  uint32_t         count,
+                  const FieldVec3* positions,
+                  uint32_t         positionsStride,
+                  const FieldVec3* rotations,
+                  uint32_t         rotationsStride,
+                  const FieldVec3* velocities,
+                  uint32_t         velocitiesStride,
+                  void**           objects);
+
+// Returns objects spawned by ObjectsSpawnBatch to their pool, they leave the scene until spawned again
+// any other object gets destroyed, null objects are skipped
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+ObjectsRelease(void* const* objects, uint32_t count);
+
+// ----------------------------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------------------------
+// SCENE STREAMING
+// ----------------------------------------------------------------------------------------------------------
+
+// How a streamable layer of the current scene gets loaded
+enum SceneStreamingMode
+{
+    SceneStreamingMode_Distance = 0, // loaded while the focus is within its radius and the memory budget allows it
+    SceneStreamingMode_Loaded   = 1, // kept loaded whatever the distance and the budget
+    SceneStreamingMode_Unloaded = 2  // kept unloaded whatever the distance
+};
+
+// Overrides how the given streamable layer of the current scene gets loaded
+// Returns false if the current scene has no such streamable layer
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API bool
+SceneStreamingSetMode(const char* layerName, uint32_t mode);
+
+// Returns true once every node of the given streamable layer is in the scene
+// Note: layers load in the background, the frame they land on can change from one run to the next
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API bool
+SceneStreamingIsResident(const char* layerName);
+
+// Measures the layers distances from the given point instead of the camera, null follows the camera again
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+SceneStreamingSetFocus(const FieldVec3* focus);
+
+// Sets the estimated bytes the streamed layers may take, the farthest ones get unloaded first, 0 is unlimited
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+SceneStreamingSetBudget(uint64_t bytes);
+
+// Sets the milliseconds a frame may spend adding and removing streamed nodes
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+SceneStreamingSetTimeSlice(float ms);
+
 // ----------------------------------------------------------------------------------------------------------
 
 // ----------------------------------------------------------------------------------------------------------
@@ -437,11 +564,58 @@ PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API double
 Time();
 
 // Returns the delta time (between last 2 frames)
+// Note: returns the fixed physics timestep instead when the settings turn the lockstep mode on
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API double
 DeltaTime();
 
 // ----------------------------------------------------------------------------------------------------------
 
+// ----------------------------------------------------------------------------------------------------------
+// FRAME MEMORY
+// ----------------------------------------------------------------------------------------------------------
+
+// Allocates transient memory that stays valid until the end of the next frame
+// Never free it, the engine recycles the whole frame at once
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+FrameAllocate(void** memory, size_t size, size_t alignment);
+
+// Returns the position of the calling thread in the frame memory, pass it to FrameRewind to drop scratch allocations
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+FrameGetMarker(size_t* marker);
+
+// Drops the frame allocations the calling thread made after the given marker in the current frame
+// Allocations of other threads are never dropped, so markers have to be taken and rewound on the same thread
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+FrameRewind(size_t marker);
+
+// ----------------------------------------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------------------------------------
+// TRACING
+// ----------------------------------------------------------------------------------------------------------
+
+// Registers a named zone once and returns its id, keep the id around instead of registering every call
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TraceRegisterZone(const char* name, uint32_t* id);
+
+// Registers a named counter once and returns its id
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TraceRegisterCounter(const char* name, uint32_t* id);
+
+// Opens a zone on the calling thread, only call TraceEndZone when it returns true
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API bool
+TraceBeginZone(uint32_t id);
+
+// Closes the zone opened by the matching TraceBeginZone
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TraceEndZone(uint32_t id);
+
+// Records the current value of a counter
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TraceCounter(uint32_t id, int64_t value);
+
+// ----------------------------------------------------------------------------------------------------------
+
 // ----------------------------------------------------------------------------------------------------------
 // RENDERING DETAILS
 // ----------------------------------------------------------------------------------------------------------
@@ -466,4 +640,109 @@ PhysicsRaycastFromLocationAndDirection(void** hitObject, const FieldVec3& origin
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
 PhysicsRaycastFromMainCameraViewport(void** hitObject, double x, double y, float rayLength);
 
+// Kind of a batched scene query
+enum PhysicsQueryType
+{
+    PhysicsQueryType_Ray     = 0, // closest hit along origin + direction * length
+    PhysicsQueryType_Sweep   = 1, // closest hit of a sphere of radius moved along origin + direction * length
+    PhysicsQueryType_Overlap = 2  // any object overlapping a sphere of radius at origin
+};
+
+// Kind of bodies a batched scene query can hit, combine them in PhysicsQuery::filterMask
+enum PhysicsQueryFilter
+{
+    PhysicsQueryFilter_Static  = 1 << 0,
+    PhysicsQueryFilter_Dynamic = 1 << 1,
+    PhysicsQueryFilter_All     = PhysicsQueryFilter_Static | PhysicsQueryFilter_Dynamic
+};
+
+// One scene query of a batch
+PROTOTYPE_INTERFACE_EXTERN struct PROTOTYPE_INTERFACE_API PhysicsQuery
+{
+    uint32_t  type;       // PhysicsQueryType
+    uint32_t  filterMask; // PhysicsQueryFilter bits
+    uint32_t  layerMask;  // PhysicsCollisionLayerMask bits, 0 hits every layer
+    FieldVec3 origin;
+    FieldVec3 direction; // doesn't need to be normalized, ignored by overlaps
+    float     length;    // ignored by overlaps
+    float     radius;    // ignored by rays
+};
+
+// Result of one scene query of a batch, object is null when nothing got hit
+PROTOTYPE_INTERFACE_EXTERN struct PROTOTYPE_INTERFACE_API PhysicsQueryHit
+{
+    void*     object;
+    FieldVec3 position;
+    FieldVec3 normal;
+    float     distance;
+};
+
+// Runs the queries in parallel on the physics worker threads and waits for them, hits[i] is the result of queries[i]
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+PhysicsQueryBatch(const PhysicsQuery* queries, uint32_t count, PhysicsQueryHit* hits);
+
+// Queues the queries to run in parallel at the end of the next physics update, right after the simulation step
+// Note: both arrays must stay alive and untouched until then, the hits are ready by the next scripts update
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+PhysicsSubmitQueryBatch(const PhysicsQuery* queries, uint32_t count, PhysicsQueryHit* hits);
+
+// Returns the bit of the named collision layer from the settings, or them together for PhysicsQuery::layerMask
+// Note: returns 0 for unknown layers, which hits every layer
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API uint32_t
+PhysicsCollisionLayerMask(const char* layerName);
+
+// How a physics scene gets stepped while the simulation is playing
+enum PhysicsSceneActivity
+{
+    PhysicsSceneActivity_Active    = 0, // stepped every update
+    PhysicsSceneActivity_Paused    = 1, // kept as it is until activated again
+    PhysicsSceneActivity_Throttled = 2  // stepped rate times per second
+};
+
+// Sets how the physics scene of the named scene gets stepped, all the registered scenes are active by default
+// Note: rate is ignored unless the scene is throttled
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+PhysicsSetSceneActivity(const char* sceneName, uint32_t activity, float rate);
+
+// Physics events a rigidbody can opt in to, combine them in PhysicsSetObjectEvents
+enum PhysicsEventFlag
+{
+    PhysicsEventFlag_Contact = 1 << 0, // contacts found and lost with other rigidbodies
+    PhysicsEventFlag_Trigger = 1 << 1, // rigidbodies entering and leaving this trigger
+    PhysicsEventFlag_Sleep   = 1 << 2, // wake and sleep transitions
+    PhysicsEventFlag_All     = PhysicsEventFlag_Contact | PhysicsEventFlag_Trigger | PhysicsEventFlag_Sleep
+};
+
+// Kind of a physics event
+enum PhysicsEventType
+{
+    PhysicsEventType_ContactFound = 0, // object and other started touching
+    PhysicsEventType_ContactLost  = 1, // object and other stopped touching
+    PhysicsEventType_TriggerEnter = 2, // other entered the trigger object
+    PhysicsEventType_TriggerExit  = 3, // other left the trigger object
+    PhysicsEventType_Wake         = 4, // object woke up, other is null
+    PhysicsEventType_Sleep        = 5  // object went to sleep, other is null
+};
+
+// One physics event of the last physics update, handed to PluginOnPhysicsEvents
+PROTOTYPE_INTERFACE_EXTERN struct PROTOTYPE_INTERFACE_API PhysicsEvent
+{
+    uint32_t  type; // PhysicsEventType
+    void*     object;
+    void*     other;
+    FieldVec3 position; // first contact point, contacts found only
+    FieldVec3 normal;   // at the first contact point pointing from other to object, contacts found only
+    float     impulse;  // summed over the contact points, contacts found only
+};
+
+// Sets the PhysicsEventFlag bits the rigidbody of the given object reports, no events are reported by default
+// Note: events involving two objects are reported when either of them opted in
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+PhysicsSetObjectEvents(void* object, uint32_t events);
+
+// Returns a hash of the poses and velocities of the dynamic bodies of the current scene as of the last physics update
+// Note: two runs fed the same inputs with the lockstep mode on return the same hash after every update
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API uint64_t
+PhysicsStateHash();
+
 // ----------------------------------------------------------------------------------------------------------
\ No newline at end of file
@@ -18,62 +18,106 @@
 
 #include <PrototypeEngine/PrototypeEngineApplication.h>
 
+#include <PrototypeEngine/../../src/core/PrototypeBulk.h>
 #include <PrototypeEngine/../../src/core/PrototypeCameraSystem.h>
 #include <PrototypeEngine/../../src/core/PrototypeEngine.h>
+#include <PrototypeEngine/../../src/core/PrototypeObjectPool.h>
 #include <PrototypeEngine/../../src/core/PrototypePhysics.h>
+#include <PrototypeEngine/../../src/core/PrototypeRecorder.h>
 #include <PrototypeEngine/../../src/core/PrototypeRenderer.h>
 #include <PrototypeEngine/../../src/core/PrototypeScene.h>
 #include <PrototypeEngine/../../src/core/PrototypeSceneLayer.h>
 #include <PrototypeEngine/../../src/core/PrototypeSceneNode.h>
+#include <PrototypeEngine/../../src/core/PrototypeSceneStreamer.h>
 #include <PrototypeEngine/../../src/core/PrototypeShortcuts.h>
+#include <PrototypeEngine/../../src/core/PrototypeTransformHierarchy.h>
 #include <PrototypeEngine/../../src/core/PrototypeUI.h>
 #include <PrototypeEngine/../../src/core/PrototypeUiView.h>
 #include <PrototypeEngine/../../src/core/PrototypeWindow.h>
 
+#include <PrototypeCommon/FrameArena.h>
 #include <PrototypeCommon/Logger.h>
+#include <PrototypeCommon/Tracer.h>
 
 #include <PrototypeTraitSystem/PrototypeTraitSystem.h>
 
 #include <GLFW/glfw3.h>
 
+#define PROTOTYPE_INTERFACE_NO_HIT_ID 0xffffffff
+
+// the batched queries are handed over to the physics as they are
+static_assert(sizeof(PhysicsQuery) == sizeof(PrototypePhysicsQuery), "PhysicsQuery layout mismatch");
+static_assert(sizeof(PhysicsQueryHit) == sizeof(PrototypePhysicsQueryHit), "PhysicsQueryHit layout mismatch");
+static_assert((u32)PhysicsQueryType_Overlap == (u32)PrototypePhysicsQueryType_Overlap, "PhysicsQueryType mismatch");
+static_assert((u32)PhysicsQueryFilter_All == (u32)PrototypePhysicsQueryFilter_All, "PhysicsQueryFilter mismatch");
+static_assert((u32)PhysicsSceneActivity_Throttled == (u32)PrototypePhysicsSceneActivity_Throttled,
+              "PhysicsSceneActivity mismatch");
+static_assert(sizeof(PhysicsEvent) == sizeof(PrototypePhysicsEvent), "PhysicsEvent layout mismatch");
+static_assert((u32)PhysicsEventType_Sleep == (u32)PrototypePhysicsEventType_Sleep, "PhysicsEventType mismatch");
+static_assert((u32)PhysicsEventFlag_All == (u32)RigidbodyEvents_All, "PhysicsEventFlag mismatch");
+static_assert(sizeof(FieldVec3) == sizeof(glm::vec3), "FieldVec3 layout mismatch");
+static_assert(sizeof(FieldMat4) == sizeof(glm::mat4), "FieldMat4 layout mismatch");
+
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
 LoadContext(PrototypeEngineContext* engineContext, PrototypeLoggerData* loggerData)
 {
     PrototypeLogger::setData(loggerData);
-    PrototypeEngineInternalApplication::application  = engineContext->application;
-    PrototypeEngineInternalApplication::renderingApi = engineContext->renderingApi;
-    PrototypeEngineInternalApplication::physicsApi   = engineContext->physicsApi;
-    PrototypeEngineInternalApplication::shouldQuit   = engineContext->shouldQuit;
-    PrototypeEngineInternalApplication::database     = engineContext->database;
-    PrototypeEngineInternalApplication::window       = engineContext->window;
-    PrototypeEngineInternalApplication::renderer     = engineContext->renderer;
-    PrototypeEngineInternalApplication::physics      = engineContext->physics;
-    PrototypeEngineInternalApplication::scene        = engineContext->scene;
+    PrototypeTracer::setData(engineContext->tracerData);
+    PrototypeEngineInternalApplication::application        = engineContext->application;
+    PrototypeEngineInternalApplication::renderingApi       = engineContext->renderingApi;
+    PrototypeEngineInternalApplication::physicsApi         = engineContext->physicsApi;
+    PrototypeEngineInternalApplication::shouldQuit         = engineContext->shouldQuit;
+    PrototypeEngineInternalApplication::headless           = engineContext->headless;
+    PrototypeEngineInternalApplication::database           = engineContext->database;
+    PrototypeEngineInternalApplication::window             = engineContext->window;
+    PrototypeEngineInternalApplication::renderer           = engineContext->renderer;
+    PrototypeEngineInternalApplication::physics            = engineContext->physics;
+    PrototypeEngineInternalApplication::scene              = engineContext->scene;
+    PrototypeEngineInternalApplication::frameArena         = engineContext->frameArena;
+    PrototypeEngineInternalApplication::recorder           = engineContext->recorder;
+    PrototypeEngineInternalApplication::threadpool         = engineContext->threadpool;
+    PrototypeEngineInternalApplication::objectPool         = engineContext->objectPool;
+    PrototypeEngineInternalApplication::transformHierarchy = engineContext->transformHierarchy;
+    PrototypeEngineInternalApplication::sceneStreamer      = engineContext->sceneStreamer;
+    PrototypeEngineInternalApplication::sceneJournal       = engineContext->sceneJournal;
 #if defined(PROTOTYPE_ENABLE_PROFILER)
     PrototypeEngineInternalApplication::profiler = engineContext->profiler;
 #endif
     PrototypeEngineInternalApplication::traitSystemData = engineContext->traitSystemData;
     PrototypeTraitSystemSetData(engineContext->traitSystemData);
+    // transforms moved from plugins report to the same hierarchy as the engine ones
+    Transform::setOnWorldSyncHandler(PrototypeTransformHierarchy::onTransformWorldSync);
 }
 
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
 ReloadContext(PrototypeEngineContext* engineContext, PrototypeLoggerData* loggerData)
 {
     PrototypeLogger::setData(loggerData);
-    PrototypeEngineInternalApplication::application  = engineContext->application;
-    PrototypeEngineInternalApplication::renderingApi = engineContext->renderingApi;
-    PrototypeEngineInternalApplication::physicsApi   = engineContext->physicsApi;
-    PrototypeEngineInternalApplication::shouldQuit   = engineContext->shouldQuit;
-    PrototypeEngineInternalApplication::database     = engineContext->database;
-    PrototypeEngineInternalApplication::window       = engineContext->window;
-    PrototypeEngineInternalApplication::renderer     = engineContext->renderer;
-    PrototypeEngineInternalApplication::physics      = engineContext->physics;
-    PrototypeEngineInternalApplication::scene        = engineContext->scene;
+    PrototypeTracer::setData(engineContext->tracerData);
+    PrototypeEngineInternalApplication::application        = engineContext->application;
+    PrototypeEngineInternalApplication::renderingApi       = engineContext->renderingApi;
+    PrototypeEngineInternalApplication::physicsApi         = engineContext->physicsApi;
+    PrototypeEngineInternalApplication::shouldQuit         = engineContext->shouldQuit;
+    PrototypeEngineInternalApplication::headless           = engineContext->headless;
+    PrototypeEngineInternalApplication::database           = engineContext->database;
+    PrototypeEngineInternalApplication::window             = engineContext->window;
+    PrototypeEngineInternalApplication::renderer           = engineContext->renderer;
+    PrototypeEngineInternalApplication::physics            = engineContext->physics;
+    PrototypeEngineInternalApplication::scene              = engineContext->scene;
+    PrototypeEngineInternalApplication::frameArena         = engineContext->frameArena;
+    PrototypeEngineInternalApplication::recorder           = engineContext->recorder;
+    PrototypeEngineInternalApplication::threadpool         = engineContext->threadpool;
+    PrototypeEngineInternalApplication::objectPool         = engineContext->objectPool;
+    PrototypeEngineInternalApplication::transformHierarchy = engineContext->transformHierarchy;
+    PrototypeEngineInternalApplication::sceneStreamer      = engineContext->sceneStreamer;
+    PrototypeEngineInternalApplication::sceneJournal       = engineContext->sceneJournal;
 #if defined(PROTOTYPE_ENABLE_PROFILER)
     PrototypeEngineInternalApplication::profiler = engineContext->profiler;
 #endif
     PrototypeEngineInternalApplication::traitSystemData = engineContext->traitSystemData;
     PrototypeTraitSystemSetData(engineContext->traitSystemData);
+    // transforms moved from plugins report to the same hierarchy as the engine ones
+    Transform::setOnWorldSyncHandler(PrototypeTransformHierarchy::onTransformWorldSync);
 }
 
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
@@ -83,6 +127,12 @@ ObjectDestroy(void* object)
     if (o) { o->destroy(); }
 }
 
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+ObjectsDestroy(void* const* objects, uint32_t count)
+{
+    PrototypeBulk::destroy((PrototypeObject* const*)objects, count);
+}
+
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
 ObjectGetId(void* object, int64_t* id)
 {
@@ -423,6 +473,30 @@ ObjectRemoveRigidbodyTrait(void* object)
     if (o) { o->removeRigidbodyTrait(); }
 }
 
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+RigidbodyTraitGetLinearVelocities(void* const* objects, uint32_t count, FieldVec3* values, uint32_t stride)
+{
+    PrototypeBulk::getLinearVelocities((PrototypeObject* const*)objects, count, (glm::vec3*)values, stride);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+RigidbodyTraitSetLinearVelocities(void* const* objects, uint32_t count, const FieldVec3* values, uint32_t stride)
+{
+    PrototypeBulk::setLinearVelocities((PrototypeObject* const*)objects, count, (const glm::vec3*)values, stride);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+RigidbodyTraitGetAngularVelocities(void* const* objects, uint32_t count, FieldVec3* values, uint32_t stride)
+{
+    PrototypeBulk::getAngularVelocities((PrototypeObject* const*)objects, count, (glm::vec3*)values, stride);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+RigidbodyTraitSetAngularVelocities(void* const* objects, uint32_t count, const FieldVec3* values, uint32_t stride)
+{
+    PrototypeBulk::setAngularVelocities((PrototypeObject* const*)objects, count, (const glm::vec3*)values, stride);
+}
+
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
 ObjectAddScriptTrait(void* object)
 {
@@ -507,11 +581,7 @@ TransformTraitSetTranslation(void* object, const FieldVec3& translation)
     transform->positionMut().x = translation.x;
     transform->positionMut().y = translation.y;
     transform->positionMut().z = translation.z;
-    glm::mat4 model;
-    PrototypeMaths::buildModelMatrix(model, transform->position(), transform->rotation());
-    PrototypeMaths::buildModelMatrixWithScale(model, transform->scale());
-    transform->setModelScaled(&model[0][0]);
-    transform->updateComponentsFromMatrix();
+    transform->updateMatrixFromComponents();
     if (o->hasColliderTrait()) { transform->setNeedsPhysicsSync(true); }
 }
 
@@ -523,11 +593,7 @@ TransformTraitSetRotation(void* object, const FieldVec3& eulerAngles)
     transform->rotationMut().x = eulerAngles.x;
     transform->rotationMut().y = eulerAngles.y;
     transform->rotationMut().z = eulerAngles.z;
-    glm::mat4 model;
-    PrototypeMaths::buildModelMatrix(model, transform->position(), transform->rotation());
-    PrototypeMaths::buildModelMatrixWithScale(model, transform->scale());
-    transform->setModelScaled(&model[0][0]);
-    transform->updateComponentsFromMatrix();
+    transform->updateMatrixFromComponents();
     if (o->hasColliderTrait()) { transform->setNeedsPhysicsSync(true); }
 }
 
@@ -556,11 +622,7 @@ TransformTraitTranslate(void* object, const FieldVec3& direction, float velocity
     transform->positionMut().x += direction.x * velocity;
     transform->positionMut().y += direction.y * velocity;
     transform->positionMut().z += direction.z * velocity;
-    glm::mat4 model;
-    PrototypeMaths::buildModelMatrix(model, transform->position(), transform->rotation());
-    PrototypeMaths::buildModelMatrixWithScale(model, transform->scale());
-    transform->setModelScaled(&model[0][0]);
-    transform->updateComponentsFromMatrix();
+    transform->updateMatrixFromComponents();
     if (o->hasColliderTrait()) { transform->setNeedsPhysicsSync(true); }
 }
 
@@ -572,14 +634,58 @@ TransformTraitRotate(void* object, const FieldVec3& angle, float velocity)
     transform->rotationMut().x += angle.x * velocity;
     transform->rotationMut().y += angle.y * velocity;
     transform->rotationMut().z += angle.z * velocity;
-    glm::mat4 model;
-    PrototypeMaths::buildModelMatrix(model, transform->position(), transform->rotation());
-    PrototypeMaths::buildModelMatrixWithScale(model, transform->scale());
-    transform->setModelScaled(&model[0][0]);
-    transform->updateComponentsFromMatrix();
+    transform->updateMatrixFromComponents();
     if (o->hasColliderTrait()) { transform->setNeedsPhysicsSync(true); }
 }
 
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitGetTranslations(void* const* objects, uint32_t count, FieldVec3* values, uint32_t stride)
+{
+    PrototypeBulk::getTranslations((PrototypeObject* const*)objects, count, (glm::vec3*)values, stride);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitSetTranslations(void* const* objects, uint32_t count, const FieldVec3* values, uint32_t stride)
+{
+    PrototypeBulk::setTranslations((PrototypeObject* const*)objects, count, (const glm::vec3*)values, stride);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitGetRotations(void* const* objects, uint32_t count, FieldVec3* values, uint32_t stride)
+{
+    PrototypeBulk::getRotations((PrototypeObject* const*)objects, count, (glm::vec3*)values, stride);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitSetRotations(void* const* objects, uint32_t count, const FieldVec3* values, uint32_t stride)
+{
+    PrototypeBulk::setRotations((PrototypeObject* const*)objects, count, (const glm::vec3*)values, stride);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitGetScales(void* const* objects, uint32_t count, FieldVec3* values, uint32_t stride)
+{
+    PrototypeBulk::getScales((PrototypeObject* const*)objects, count, (glm::vec3*)values, stride);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitSetScales(void* const* objects, uint32_t count, const FieldVec3* values, uint32_t stride)
+{
+    PrototypeBulk::setScales((PrototypeObject* const*)objects, count, (const glm::vec3*)values, stride);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitGetModels(void* const* objects, uint32_t count, FieldMat4* values, uint32_t stride)
+{
+    PrototypeBulk::getModels((PrototypeObject* const*)objects, count, (glm::mat4*)values, stride);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TransformTraitSetModels(void* const* objects, uint32_t count, const FieldMat4* values, uint32_t stride)
+{
+    PrototypeBulk::setModels((PrototypeObject* const*)objects, count, (const glm::mat4*)values, stride);
+}
+
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
 consoleLog(void* object, const char* file, int line, const char* text)
 {
@@ -589,6 +695,7 @@ consoleLog(void* object, const char* file, int line, const char* text)
 PROTOTYPE_EXTERN PROTOTYPE_INTERFACE_API void
 spawnCube()
 {
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_SpawnCube, nullptr, 0);
     auto cameraObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(PrototypeTraitTypeMaskCamera);
     auto cameraObject  = *cameraObjects.begin();
     auto selectedNodes = PrototypeEngineInternalApplication::scene->selectedNodes();
@@ -630,6 +737,7 @@ spawnCube()
 PROTOTYPE_EXTERN PROTOTYPE_INTERFACE_API void
 spawnSphere()
 {
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_SpawnSphere, nullptr, 0);
     auto cameraObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(PrototypeTraitTypeMaskCamera);
     auto cameraObject  = *cameraObjects.begin();
     auto selectedNodes = PrototypeEngineInternalApplication::scene->selectedNodes();
@@ -671,6 +779,7 @@ spawnSphere()
 PROTOTYPE_EXTERN PROTOTYPE_INTERFACE_API void
 spawnConvexMesh(const char* name)
 {
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_SpawnConvexMesh, name, strlen(name));
     auto cameraObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(PrototypeTraitTypeMaskCamera);
     auto cameraObject  = *cameraObjects.begin();
     auto selectedNodes = PrototypeEngineInternalApplication::scene->selectedNodes();
@@ -712,6 +821,7 @@ spawnConvexMesh(const char* name)
 PROTOTYPE_EXTERN PROTOTYPE_INTERFACE_API void
 spawnTriMesh(const char* name)
 {
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_SpawnTriMesh, name, strlen(name));
     auto cameraObjects = PrototypeEngineInternalApplication::scene->fetchObjectsByTraits(PrototypeTraitTypeMaskCamera);
     auto cameraObject  = *cameraObjects.begin();
     auto selectedNodes = PrototypeEngineInternalApplication::scene->selectedNodes();
@@ -750,17 +860,184 @@ spawnTriMesh(const char* name)
     PrototypeEngineInternalApplication::renderer->scheduleRecordPass();
 }
 
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+ObjectsSpawnCubes(uint32_t         count,
+                  const FieldVec3* positions,
+                  uint32_t         positionsStride,
+                  const FieldVec3* velocities,
+                  uint32_t         velocitiesStride,
+                  void**           objects)
+{
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_SpawnCubes, &count, sizeof(count));
+    PrototypeBulk::spawnCubes(count,
+                              (const glm::vec3*)positions,
+                              positionsStride,
+                              (const glm::vec3*)velocities,
+                              velocitiesStride,
+                              (PrototypeObject**)objects);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+ObjectsSpawnBatch(uint32_t         shape,
+                  const char*      mesh,
+                  const char*      material,
+                  const char*      layerName,
+                  uint32_t         count,
+                  const FieldVec3* positions,
+                  uint32_t         positionsStride,
+                  const FieldVec3* rotations,
+                  uint32_t         rotationsStride,
+                  const FieldVec3* velocities,
+                  uint32_t         velocitiesStride,
+                  void**           objects)
+{
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_SpawnBatch, &count, sizeof(count));
+    if (shape >= PrototypeSpawnShape_Count) {
+        PrototypeLogger::warn("Unknown spawn shape %u", shape);
+        return;
+    }
+    PrototypeSpawnArchetype archetype = {};
+    archetype.shape                   = (PrototypeSpawnShape_)shape;
+    archetype.mesh                    = mesh ? mesh : "";
+    archetype.material                = material ? material : "";
+    archetype.layer                   = 0;
+    if (layerName) {
+        auto layer = PrototypeEngineInternalApplication::scene->collisionLayers().layerByName(layerName);
+        if (!layer.has_value()) {
+            PrototypeLogger::warn("Unknown collision layer %s", layerName);
+            return;
+        }
+        archetype.layer = layer.value();
+    }
+    PrototypeEngineInternalApplication::objectPool->spawnBatch(archetype,
+                                                               count,
+                                                               (const glm::vec3*)positions,
+                                                               positionsStride,
+                                                               (const glm::vec3*)rotations,
+                                                               rotationsStride,
+                                                               (const glm::vec3*)velocities,
+                                                               velocitiesStride,
+                                                               (PrototypeObject**)objects);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+ObjectsRelease(void* const* objects, uint32_t count)
+{
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_ReleaseObjects, &count, sizeof(count));
+    PrototypeEngineInternalApplication::objectPool->release((PrototypeObject* const*)objects, count);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API bool
+SceneStreamingSetMode(const char* layerName, uint32_t mode)
+{
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_StreamingMode, &mode, sizeof(mode));
+    if (mode >= PrototypeSceneStreamingMode_Count) {
+        PrototypeLogger::warn("Unknown scene streaming mode %u", mode);
+        return false;
+    }
+    return PrototypeEngineInternalApplication::sceneStreamer->setMode(layerName, (PrototypeSceneStreamingMode_)mode);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API bool
+SceneStreamingIsResident(const char* layerName)
+{
+    const bool resident =
+      PrototypeEngineInternalApplication::sceneStreamer->state(layerName) == PrototypeSceneStreamingState_Resident;
+    PrototypeEngineInternalApplication::recorder->pluginCall(
+      PrototypeRecorderPluginCall_StreamingResident, &resident, sizeof(resident));
+    return resident;
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+SceneStreamingSetFocus(const FieldVec3* focus)
+{
+    if (focus) {
+        PrototypeEngineInternalApplication::sceneStreamer->setFocus(*(const glm::vec3*)focus);
+    } else {
+        PrototypeEngineInternalApplication::sceneStreamer->followCamera();
+    }
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+SceneStreamingSetBudget(uint64_t bytes)
+{
+    PrototypeEngineInternalApplication::sceneStreamer->setBudget(bytes);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+SceneStreamingSetTimeSlice(float ms)
+{
+    PrototypeEngineInternalApplication::sceneStreamer->setTimeSlice(ms);
+}
+
 //
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API double
 Time()
 {
-    return glfwGetTime();
+    // the window time is the recorded one while replaying a session
+    double time = PrototypeEngineInternalApplication::window->time();
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_Time, &time, sizeof(time));
+    return time;
 }
 
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API double
 DeltaTime()
 {
-    return PrototypeEngineInternalApplication::window->deltaTime();
+    double deltaTime = PrototypeEngineInternalApplication::window->deltaTime();
+    // scripts have to advance by the same step as the simulation to stay in lockstep
+    const PrototypePhysicsLockstep& lockstep = PrototypeEngineInternalApplication::physics->lockstep();
+    if (lockstep.enabled) { deltaTime = lockstep.timestep; }
+    PrototypeEngineInternalApplication::recorder->pluginCall(
+      PrototypeRecorderPluginCall_DeltaTime, &deltaTime, sizeof(deltaTime));
+    return deltaTime;
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+FrameAllocate(void** memory, size_t size, size_t alignment)
+{
+    *memory = PrototypeEngineInternalApplication::frameArena->allocate(size, alignment);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+FrameGetMarker(size_t* marker)
+{
+    *marker = PrototypeEngineInternalApplication::frameArena->marker();
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+FrameRewind(size_t marker)
+{
+    PrototypeEngineInternalApplication::frameArena->rewind(marker);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TraceRegisterZone(const char* name, uint32_t* id)
+{
+    *id = PrototypeTracer::registerZone(name, "", 0);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TraceRegisterCounter(const char* name, uint32_t* id)
+{
+    *id = PrototypeTracer::registerCounter(name);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API bool
+TraceBeginZone(uint32_t id)
+{
+    return PrototypeTracer::beginZone(id);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TraceEndZone(uint32_t id)
+{
+    PrototypeTracer::endZone(id);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+TraceCounter(uint32_t id, int64_t value)
+{
+    PrototypeTracer::counter(id, value);
 }
 
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
@@ -777,12 +1054,87 @@ PhysicsRaycastFromLocationAndDirection(void** hitObject, const FieldVec3& origin
     glm::vec3* glmorigin    = (glm::vec3*)&origin;
     glm::vec3* glmdirection = (glm::vec3*)&direction;
     *glmdirection           = glm::normalize(*glmdirection);
-    auto hit                = PrototypeEngineInternalApplication::physics->raycast(*glmorigin, *glmdirection, rayLength);
+    auto hit                = PrototypeEngineInternalApplication::physics->raycast(*glmorigin, *glmdirection, rayLength, 0);
     if (hit.has_value()) {
         *hitObject = hit.value();
     } else {
         *hitObject = nullptr;
     }
+    u32 hitId = hit.has_value() ? hit.value()->id() : PROTOTYPE_INTERFACE_NO_HIT_ID;
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_Raycast, &hitId, sizeof(hitId));
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+PhysicsQueryBatch(const PhysicsQuery* queries, uint32_t count, PhysicsQueryHit* hits)
+{
+    PrototypeEngineInternalApplication::physics->queryBatch(
+      (const PrototypePhysicsQuery*)queries, count, (PrototypePhysicsQueryHit*)hits);
+    // the ids only matter to the recorder, skip gathering them when it's off
+    if (PrototypeEngineInternalApplication::recorder->mode() == PrototypeRecorderMode_Off) { return; }
+    u32* hitIds = PrototypeEngineInternalApplication::frameArena->allocateArray<u32>(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        hitIds[i] = hits[i].object ? ((PrototypeObject*)hits[i].object)->id() : PROTOTYPE_INTERFACE_NO_HIT_ID;
+    }
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_QueryBatch, hitIds, sizeof(u32) * count);
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+PhysicsSubmitQueryBatch(const PhysicsQuery* queries, uint32_t count, PhysicsQueryHit* hits)
+{
+    PrototypeEngineInternalApplication::physics->submitQueryBatch(
+      (const PrototypePhysicsQuery*)queries, count, (PrototypePhysicsQueryHit*)hits);
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_SubmitQueryBatch, &count, sizeof(count));
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API uint32_t
+PhysicsCollisionLayerMask(const char* layerName)
+{
+    auto layer = PrototypeEngineInternalApplication::scene->collisionLayers().layerByName(layerName);
+    if (!layer.has_value()) {
+        PrototypeLogger::warn("Unknown collision layer %s", layerName);
+        return 0;
+    }
+    return 1u << layer.value();
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+PhysicsSetSceneActivity(const char* sceneName, uint32_t activity, float rate)
+{
+    if (activity >= PrototypePhysicsSceneActivity_Count) {
+        PrototypeLogger::warn("Unknown physics scene activity %u", activity);
+        return;
+    }
+    PrototypeEngineInternalApplication::physics->setSceneActivity(sceneName, (PrototypePhysicsSceneActivity_)activity, rate);
+    struct
+    {
+        u32 activity;
+        f32 rate;
+    } call = { activity, rate };
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_SceneActivity, &call, sizeof(call));
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API uint64_t
+PhysicsStateHash()
+{
+    return PrototypeEngineInternalApplication::physics->stateHash();
+}
+
+PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
+PhysicsSetObjectEvents(void* object, uint32_t events)
+{
+    PrototypeObject* o = (PrototypeObject*)object;
+    if (!o || !o->hasRigidbodyTrait()) {
+        PrototypeLogger::warn("PhysicsSetObjectEvents called on an object without a rigidbody");
+        return;
+    }
+    o->getRigidbodyTrait()->setEvents(events & RigidbodyEvents_All);
+    PrototypeEngineInternalApplication::physics->updateRigidbodyEvents(o);
+    struct
+    {
+        u32 id;
+        u32 events;
+    } call = { o->id(), events };
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_ObjectEvents, &call, sizeof(call));
 }
 
 PROTOTYPE_INTERFACE_EXTERN PROTOTYPE_INTERFACE_API void
@@ -798,6 +1150,8 @@ PhysicsRaycastFromMainCameraViewport(void** hitObject, double x, double y, float
     glm::vec3        ray;
     PrototypeMaths::projectRayFromClipSpacePoint(ray, camViewMatrix, camProjectionMatrix, x, y, sceneViewSize.x, sceneViewSize.y);
     glm::vec3 pos = { camPosition.x, camPosition.y, camPosition.z };
-    auto      hit = PrototypeEngineInternalApplication::physics->raycast(pos, ray, rayLength);
+    auto      hit = PrototypeEngineInternalApplication::physics->raycast(pos, ray, rayLength, 0);
     if (hit.has_value()) { *hitObject = hit.value(); }
+    u32 hitId = hit.has_value() ? hit.value()->id() : PROTOTYPE_INTERFACE_NO_HIT_ID;
+    PrototypeEngineInternalApplication::recorder->pluginCall(PrototypeRecorderPluginCall_Raycast, &hitId, sizeof(hitId));
 }
\ No newline at end of file
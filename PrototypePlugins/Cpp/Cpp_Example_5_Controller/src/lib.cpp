@@ -232,4 +232,8 @@ PluginOnWindowMaximize(void* object)
 
 PROTOTYPE_PLUGIN_EXTERN PROTOTYPE_PLUGIN_API void
 PluginOnWindowMaximizeRestore(void* object)
+{}
+
+PROTOTYPE_PLUGIN_EXTERN PROTOTYPE_PLUGIN_API void
+PluginOnPhysicsEvents(const PhysicsEvent* events, uint32_t count)
 {}
\ No newline at end of file
@@ -202,3 +202,10 @@ PluginOnWindowMaximize(void* object)
 PROTOTYPE_PLUGIN_EXTERN PROTOTYPE_PLUGIN_API void
 PluginOnWindowMaximizeRestore(void* object)
 {}
+
+// Called when:
+//     - The last physics update reported contact, trigger or sleep events of the rigidbodies that opted in
+//       through PhysicsSetObjectEvents, once per frame before the scripts update with all of them
+PROTOTYPE_PLUGIN_EXTERN PROTOTYPE_PLUGIN_API void
+PluginOnPhysicsEvents(const PhysicsEvent* events, uint32_t count)
+{}
@@ -54,6 +54,7 @@ struct Attachable(Trait) Collider
     void setDepth(f32 depth);
     void setDensity(f32 density);
     void setNameRef(std::string nameRef);
+    void setLayer(u32 layer);
 
     void*                 shapeRef();
     const ColliderShape_& shapeType() const;
@@ -63,6 +64,7 @@ struct Attachable(Trait) Collider
     const f32&            depth() const;
     const f32&            density() const;
     const std::string&    nameRef() const;
+    const u32&            layer() const;
 
     PrototypeObject* object();
     static void      setOnEditDispatchHandler(onEditDispatchHandlerFn onEditDispatchHandler);
@@ -70,6 +72,10 @@ struct Attachable(Trait) Collider
     static void      to_json(nlohmann::json & j, const Collider& c);
     static void      from_json(const nlohmann::json& j, Collider& c, PrototypeObject* o);
 
+    // names of the collision layers, the layer is saved by name and loaded back to its index
+    static void                            setLayerNames(std::vector<std::string> layerNames);
+    static const std::vector<std::string>& layerNames();
+
   private:
     friend struct PrototypeObject;
     PrototypeObject*               _object;
@@ -97,5 +103,7 @@ struct Attachable(Trait) Collider
             f32 _density;
         };
     };
-    std::string _nameRef;
+    std::string                     _nameRef;
+    u32                             _layer;
+    static std::vector<std::string> _layerNames;
 };
@@ -107,6 +107,9 @@ typedef void(PROTOTYPE_DYNAMIC_FN_CALL* logScriptFn)(PrototypeObject*, Script*);
 typedef void(PROTOTYPE_DYNAMIC_FN_CALL* logTransformFn)(PrototypeObject*, Transform*);
 typedef void(PROTOTYPE_DYNAMIC_FN_CALL* logVehicleChasisFn)(PrototypeObject*, VehicleChasis*);
 
+// called with the mask of the trait whenever one of its saved fields changes, physics workers call it too
+typedef void(PROTOTYPE_DYNAMIC_FN_CALL* changeTraitFn)(PrototypeObject*, MASK_TYPE);
+
 static const MASK_TYPE PrototypeTraitTypeCount = 7;
 
 static const MASK_TYPE PrototypeTraitTypeIndexCamera        = 0;
@@ -295,6 +298,8 @@ struct PrototypeTraitSystemData
     logScriptFn        _logScriptCbFn;
     logTransformFn     _logTransformCbFn;
     logVehicleChasisFn _logVehicleChasisCbFn;
+
+    changeTraitFn _changeTraitCbFn;
 };
 
 struct PrototypeTraitSystem
@@ -359,6 +364,9 @@ struct PrototypeTraitSystem
     static void setTransformTraitLogCbFnPtr(logTransformFn cbfn);
     static void setVehicleChasisTraitLogCbFnPtr(logVehicleChasisFn cbfn);
 
+    static void setTraitChangeCbFnPtr(changeTraitFn cbfn);
+    static void dispatchTraitChange(PrototypeObject* object, MASK_TYPE traitMask);
+
     static PrototypeTraitSystemData* data();
     static void                      setData(PrototypeTraitSystemData* data);
 
@@ -23,6 +23,16 @@ struct PrototypeObject;
 
 typedef void(PROTOTYPE_DYNAMIC_FN_CALL* onEditDispatchHandlerFn)(PrototypeObject* o);
 
+// physics events a rigidbody opts in to, the physics only generates the events of pairs where one of them asked for it
+enum RigidbodyEvents_
+{
+    RigidbodyEvents_Contact = 1 << 0, // started or stopped touching another rigidbody
+    RigidbodyEvents_Trigger = 1 << 1, // a rigidbody entered or left the trigger
+    RigidbodyEvents_Sleep   = 1 << 2, // went to sleep or woke up
+
+    RigidbodyEvents_All = RigidbodyEvents_Contact | RigidbodyEvents_Trigger | RigidbodyEvents_Sleep
+};
+
 struct Attachable(Trait) Rigidbody
 {
     void setRigidbodyRef(void* rigidbodyRef);
@@ -39,6 +49,7 @@ struct Attachable(Trait) Rigidbody
     void setLockAngularZ(bool lock);
     void setStatic(bool value);
     void setTrigger(bool value);
+    void setEvents(u32 events);
 
     void*            rigidbodyRef();
     const glm::vec3& linearVelocity() const;
@@ -65,6 +76,7 @@ struct Attachable(Trait) Rigidbody
     bool&            lockAngularZMut();
     const bool&      isStatic() const;
     const bool&      isTrigger() const;
+    const u32&       events() const;
 
     PrototypeObject* object();
     static void      setOnEditDispatchHandler(onEditDispatchHandlerFn onEditDispatchHandler);
@@ -90,4 +102,5 @@ struct Attachable(Trait) Rigidbody
     bool                           _lockAngularZ;
     bool                           _static;
     bool                           _trigger;
+    u32                            _events; // RigidbodyEvents_ bits
 };
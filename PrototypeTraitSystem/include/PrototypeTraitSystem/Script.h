@@ -28,6 +28,7 @@ typedef void(PROTOTYPE_DYNAMIC_FN_CALL* onEditDispatchHandlerFn)(PrototypeObject
 struct PrototypeEngineContext;
 struct PrototypeLoggerData;
 struct PrototypeObject;
+struct PrototypePluginInstance;
 
 typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginLoadProtocolFn)(PrototypeEngineContext*, PrototypeLoggerData*);
 typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginReloadProtocolFn)(PrototypeEngineContext*, PrototypeLoggerData*);
@@ -35,6 +36,8 @@ typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginStartProtocolFn)(PrototypeObject*)
 typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginUpdateProtocolFn)(PrototypeObject*);
 typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginEndProtocolFn)(PrototypeObject*);
 typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginUnloadProtocolFn)();
+typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginUpdateBatchProtocolFn)(PrototypeObject* const* objects, u32 count);
+typedef bool(PROTOTYPE_DYNAMIC_FN_CALL* PluginIsUpdateBatchThreadSafeFn)();
 
 typedef void(PROTOTYPE_DYNAMIC_FN_CALL* PluginOnMouseFn)(PrototypeObject*, i32 button, i32 action, i32 mods);
 typedef void(PROTOTYPE_DYNAMIC_FN_CALL* PluginOnMouseMoveFn)(PrototypeObject*, f64 x, f64 y);
@@ -75,6 +78,9 @@ struct ScriptCodeLink
     PluginOnWindowIconifyRestoreFn  _OnWindowIconifyRestore;
     PluginOnWindowMaximizeFn        _OnWindowMaximize;
     PluginOnWindowMaximizeRestoreFn _OnWindowMaximizeRestore;
+    PluginUpdateBatchProtocolFn     _UpdateBatchProtocol;
+    bool                            _updateBatchThreadSafe;
+    PrototypePluginInstance*        _instance;
 };
 
 struct Attachable(Trait) Script
@@ -31,7 +31,14 @@ struct Attachable(Trait) Transform
     void setModel(const glm::mat4& model);
     void setModel(const float* model);
     void setModelScaled(const float* modelScaled);
+    // the matrices got written directly, position rotation and scale get decomposed out of them on the next read
     void updateComponentsFromMatrix();
+    // position rotation and scale got written, the matrices get composed out of them and nothing needs decomposing
+    void updateMatrixFromComponents();
+    // updateMatrixFromComponents for many transforms, their matrices get composed together by the batched maths kernels
+    static void updateMatricesFromComponents(Transform* const* transforms, size_t count);
+    // sets the world position and orientation of a physics pose, roots take them as they are without decomposing
+    void setWorldPose(const glm::vec3& position, const glm::quat& orientation);
 
     const glm::vec3& position();
     glm::vec3&       positionMut();
@@ -43,24 +50,50 @@ struct Attachable(Trait) Transform
     glm::mat4&       modelMut();
     const glm::mat4& modelScaled() const;
 
+    // the matrices above are local to the closest parent transform, the world ones get composed by the engine
+    // transform hierarchy and match the local ones for transforms without a parent
+    const glm::mat4& worldModel() const;
+    const glm::mat4& worldModelScaled() const;
+    // sets the local matrices from world ones, the parent world matrix is the one of the last hierarchy update
+    void             setWorldModel(const float* worldModel);
+    void             setWorldModelScaled(const float* worldModelScaled);
+    void             setHierarchyLinks(bool hasParent, bool hasChildren);
+    void             updateWorldModel(const glm::mat4& parentWorldModelScaled);
+    const bool&      needsWorldSync() const;
+
     const bool& needsPhysicsSync() const;
     void        setNeedsPhysicsSync(bool needsPhysicsSync);
 
     PrototypeObject* object();
     static void      setOnEditDispatchHandler(onEditDispatchHandlerFn onEditDispatchHandler);
+    // called whenever needsPhysicsSync goes from false to true so the physics can keep a list of the transforms to push
+    static void      setOnPhysicsSyncHandler(onEditDispatchHandlerFn onPhysicsSyncHandler);
+    // called whenever needsWorldSync goes from false to true, transforms outside of any hierarchy never need it
+    static void      setOnWorldSyncHandler(onEditDispatchHandlerFn onWorldSyncHandler);
     static void      onEditDispatch(PrototypeObject * o);
     static void      to_json(nlohmann::json & j, const Transform& t);
     static void      from_json(const nlohmann::json& j, Transform& t, PrototypeObject* o);
 
   private:
     friend struct PrototypeObject;
+    void onLocalModelChanged();
+    void syncComponents();
+
     glm::mat4x4                    _model;
     glm::mat4x4                    _modelScaled;
+    glm::mat4x4                    _worldModel;
+    glm::mat4x4                    _worldModelScaled;
+    glm::mat4x4                    _parentWorldModelScaled;
     glm::vec3                      _position;
     glm::vec3                      _rotation;
     glm::vec3                      _scale;
     PrototypeObject*               _object;
     static onEditDispatchHandlerFn _onEditDispatchHandler;
+    static onEditDispatchHandlerFn _onPhysicsSyncHandler;
+    static onEditDispatchHandlerFn _onWorldSyncHandler;
     bool                           _needsPhysicsSync;
     bool                           _needsComponentsSync;
+    bool                           _needsWorldSync;
+    bool                           _hasParent;
+    bool                           _hasChildren;
 };
@@ -13,6 +13,7 @@
 /// limitations under the License.
 
 #include "../include/PrototypeTraitSystem/Camera.h"
+#include "../include/PrototypeTraitSystem/PrototypeTraitSystem.h"
 
 #include <glm/ext.hpp>
 #include <glm/glm.hpp>
@@ -159,6 +160,7 @@ void
 Camera::onEditDispatch(PrototypeObject* o)
 {
     if (_onEditDispatchHandler) { _onEditDispatchHandler(o); }
+    PrototypeTraitSystem::dispatchTraitChange(o, PrototypeTraitTypeMaskCamera);
 }
 
 void
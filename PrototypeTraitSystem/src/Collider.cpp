@@ -13,12 +13,15 @@
 /// limitations under the License.
 
 #include "../include/PrototypeTraitSystem/Collider.h"
+#include "../include/PrototypeTraitSystem/PrototypeTraitSystem.h"
 
 #include <PrototypeCommon/Logger.h>
 
+#include <algorithm>
 #include <utility>
 
-onEditDispatchHandlerFn Collider::_onEditDispatchHandler = nullptr;
+onEditDispatchHandlerFn  Collider::_onEditDispatchHandler = nullptr;
+std::vector<std::string> Collider::_layerNames;
 
 void
 Collider::setShapeRef(void* shape)
@@ -30,42 +33,56 @@ void
 Collider::setShapeType(ColliderShape_ shapeType)
 {
     _shapeType = shapeType;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskCollider);
 }
 
 void
 Collider::setWidth(f32 width)
 {
     _width = width;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskCollider);
 }
 
 void
 Collider::setRadius(f32 radius)
 {
     _radius = radius;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskCollider);
 }
 
 void
 Collider::setHeight(f32 height)
 {
     _height = height;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskCollider);
 }
 
 void
 Collider::setDepth(f32 depth)
 {
     _depth = depth;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskCollider);
 }
 
 void
 Collider::setDensity(f32 density)
 {
     _density = density;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskCollider);
 }
 
 void
 Collider::setNameRef(std::string nameRef)
 {
     _nameRef = std::move(nameRef);
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskCollider);
+}
+
+void
+Collider::setLayer(u32 layer)
+{
+    _layer = layer;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskCollider);
 }
 
 void*
@@ -116,6 +133,12 @@ Collider::nameRef() const
     return _nameRef;
 }
 
+const u32&
+Collider::layer() const
+{
+    return _layer;
+}
+
 PrototypeObject*
 Collider::object()
 {
@@ -132,6 +155,19 @@ void
 Collider::onEditDispatch(PrototypeObject* o)
 {
     if (_onEditDispatchHandler) { _onEditDispatchHandler(o); }
+    PrototypeTraitSystem::dispatchTraitChange(o, PrototypeTraitTypeMaskCollider);
+}
+
+void
+Collider::setLayerNames(std::vector<std::string> layerNames)
+{
+    _layerNames = std::move(layerNames);
+}
+
+const std::vector<std::string>&
+Collider::layerNames()
+{
+    return _layerNames;
 }
 
 void
@@ -145,10 +181,12 @@ Collider::to_json(nlohmann::json& j, const Collider& c)
     const char* field_depth     = "depth";
     const char* field_radius    = "radius";
     const char* field_density   = "density";
+    const char* field_layer     = "layer";
 
     j[field_name]      = PROTOTYPE_STRINGIFY(Collider);
     j[field_name_ref]  = c._nameRef;
     j[field_shapeType] = c._shapeType;
+    if (c._layer > 0 && c._layer < _layerNames.size()) { j[field_layer] = _layerNames[c._layer]; }
     if (j.at(field_shapeType) == ColliderShape_Plane) {
         j[field_width]  = c._width;
         j[field_height] = c._height;
@@ -186,6 +224,19 @@ Collider::from_json(const nlohmann::json& j, Collider& c, PrototypeObject* o)
     const char* field_depth     = "depth";
     const char* field_radius    = "radius";
     const char* field_density   = "density";
+    const char* field_layer     = "layer";
+
+    // colliders without a layer or with one that isn't defined anymore stay on the default layer
+    c._layer = 0;
+    if (j.contains(field_layer)) {
+        const std::string layerName = j.at(field_layer).get<std::string>();
+        auto              it        = std::find(_layerNames.begin(), _layerNames.end(), layerName);
+        if (it != _layerNames.end()) {
+            c._layer = (u32)(it - _layerNames.begin());
+        } else {
+            PrototypeLogger::warn("Unknown collision layer %s, using the default layer", layerName.c_str());
+        }
+    }
 
     if (j.at(field_shapeType) == ColliderShape_Plane_Str) {
         c._shapeType = ColliderShape_Plane;
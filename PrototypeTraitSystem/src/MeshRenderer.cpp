@@ -13,6 +13,7 @@
 /// limitations under the License.
 
 #include "../include/PrototypeTraitSystem/MeshRenderer.h"
+#include "../include/PrototypeTraitSystem/PrototypeTraitSystem.h"
 
 #include <utility>
 
@@ -22,18 +23,21 @@ void
 MeshRenderer::setData(std::vector<MeshRendererMeshMaterialTuple>& data)
 {
     _data = std::move(data);
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskMeshRenderer);
 }
 
 void
 MeshRenderer::setMeshAtIndex(size_t index, std::string mesh)
 {
     if (index >= 0 && index < _data.size()) { _data[index].mesh = mesh; }
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskMeshRenderer);
 }
 
 void
 MeshRenderer::setMaterialAtIndex(size_t index, std::string material)
 {
     if (index >= 0 && index < _data.size()) { _data[index].material = material; }
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskMeshRenderer);
 }
 
 std::vector<MeshRendererMeshMaterialTuple>&
@@ -58,6 +62,7 @@ void
 MeshRenderer::onEditDispatch(PrototypeObject* o)
 {
     if (_onEditDispatchHandler) { _onEditDispatchHandler(o); }
+    PrototypeTraitSystem::dispatchTraitChange(o, PrototypeTraitTypeMaskMeshRenderer);
 }
 
 void
@@ -48,6 +48,7 @@ PrototypeTraitSystemData::PrototypeTraitSystemData()
   , _reuseVehicleChasisCbFn(nullptr)
   , _removeVehicleChasisCbFn(nullptr)
   , _logVehicleChasisCbFn(nullptr)
+  , _changeTraitCbFn(nullptr)
 
 {}
 
@@ -1082,6 +1083,20 @@ PrototypeTraitSystem::setVehicleChasisTraitLogCbFnPtr(logVehicleChasisFn cbfn)
     PrototypeTraitSystem::_data->_logVehicleChasisCbFn = cbfn;
 }
 
+void
+PrototypeTraitSystem::setTraitChangeCbFnPtr(changeTraitFn cbfn)
+{
+    PrototypeTraitSystem::_data->_changeTraitCbFn = cbfn;
+}
+
+void
+PrototypeTraitSystem::dispatchTraitChange(PrototypeObject* object, MASK_TYPE traitMask)
+{
+    if (object && PrototypeTraitSystem::_data && PrototypeTraitSystem::_data->_changeTraitCbFn) {
+        PrototypeTraitSystem::_data->_changeTraitCbFn(object, traitMask);
+    }
+}
+
 extern void**
 PrototypeTraitSystemGetDataInternal()
 {
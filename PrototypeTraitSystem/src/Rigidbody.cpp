@@ -13,6 +13,7 @@
 /// limitations under the License.
 
 #include "../include/PrototypeTraitSystem/Rigidbody.h"
+#include "../include/PrototypeTraitSystem/PrototypeTraitSystem.h"
 
 onEditDispatchHandlerFn Rigidbody::_onEditDispatchHandler = nullptr;
 
@@ -26,78 +27,98 @@ void
 Rigidbody::setLinearVelocity(glm::vec3 linearVelocity)
 {
     _linearVelocity = linearVelocity;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setLinearDamping(f32 linearDamping)
 {
     _linearDamping = linearDamping;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setAngularVelocity(glm::vec3 angularVelocity)
 {
     _angularVelocity = angularVelocity;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setAngularDamping(f32 angularDamping)
 {
     _angularDamping = angularDamping;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setMass(f32 mass)
 {
     _mass = mass;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setLockLinearX(bool lock)
 {
     _lockLinearX = lock;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setLockLinearY(bool lock)
 {
     _lockLinearY = lock;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setLockLinearZ(bool lock)
 {
     _lockLinearZ = lock;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setLockAngularX(bool lock)
 {
     _lockAngularX = lock;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setLockAngularY(bool lock)
 {
     _lockAngularY = lock;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setLockAngularZ(bool lock)
 {
     _lockAngularZ = lock;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setStatic(bool value)
 {
     _static = value;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
 Rigidbody::setTrigger(bool value)
 {
     _trigger = value;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
+}
+
+void
+Rigidbody::setEvents(u32 events)
+{
+    _events = events;
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskRigidbody);
 }
 
 void*
@@ -250,6 +271,12 @@ Rigidbody::isTrigger() const
     return _trigger;
 }
 
+const u32&
+Rigidbody::events() const
+{
+    return _events;
+}
+
 PrototypeObject*
 Rigidbody::object()
 {
@@ -266,6 +293,7 @@ void
 Rigidbody::onEditDispatch(PrototypeObject* o)
 {
     if (_onEditDispatchHandler) { _onEditDispatchHandler(o); }
+    PrototypeTraitSystem::dispatchTraitChange(o, PrototypeTraitTypeMaskRigidbody);
 }
 
 void
@@ -285,6 +313,7 @@ Rigidbody::to_json(nlohmann::json& j, const Rigidbody& rb)
     const char* field_lock_angular_z   = "lockAngularZ";
     const char* field_static           = "static";
     const char* field_trigger          = "trigger";
+    const char* field_events           = "events";
 
     j[field_name]             = PROTOTYPE_STRINGIFY(Rigidbody);
     j[field_linear_velocity]  = rb._linearVelocity;
@@ -300,6 +329,13 @@ Rigidbody::to_json(nlohmann::json& j, const Rigidbody& rb)
     j[field_lock_angular_z]   = rb._lockAngularZ;
     j[field_static]           = rb._static;
     j[field_trigger]          = rb._trigger;
+    if (rb._events != 0) {
+        nlohmann::json events = nlohmann::json::array();
+        if (rb._events & RigidbodyEvents_Contact) { events.push_back("contact"); }
+        if (rb._events & RigidbodyEvents_Trigger) { events.push_back("trigger"); }
+        if (rb._events & RigidbodyEvents_Sleep) { events.push_back("sleep"); }
+        j[field_events] = events;
+    }
 }
 
 void
@@ -318,6 +354,7 @@ Rigidbody::from_json(const nlohmann::json& j, Rigidbody& rb, PrototypeObject* o)
     const char* field_lock_angular_z   = "lockAngularZ";
     const char* field_static           = "static";
     const char* field_trigger          = "trigger";
+    const char* field_events           = "events";
 
     if (j.find(field_linear_velocity) != j.end()) {
         rb._linearVelocity = j.at(field_linear_velocity);
@@ -354,6 +391,19 @@ Rigidbody::from_json(const nlohmann::json& j, Rigidbody& rb, PrototypeObject* o)
     } else {
         rb._trigger = false;
     }
+    rb._events = 0;
+    if (j.find(field_events) != j.end()) {
+        for (const auto& event : j.at(field_events)) {
+            const std::string name = event.get<std::string>();
+            if (name == "contact") {
+                rb._events |= RigidbodyEvents_Contact;
+            } else if (name == "trigger") {
+                rb._events |= RigidbodyEvents_Trigger;
+            } else if (name == "sleep") {
+                rb._events |= RigidbodyEvents_Sleep;
+            }
+        }
+    }
     if (j.find(field_lock_linear_x) != j.end()) {
         j.at(field_lock_linear_x).get_to(rb._lockLinearX);
     } else {
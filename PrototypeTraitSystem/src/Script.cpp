@@ -43,7 +43,7 @@ Script::to_json(nlohmann::json& j, const Script& s)
 {
     const char* field_name = "name";
 
-    j[field_name] = PROTOTYPE_STRINGIFY(Collider);
+    j[field_name] = PROTOTYPE_STRINGIFY(Script);
 }
 
 void
@@ -13,12 +13,29 @@
 /// limitations under the License.
 
 #include "../include/PrototypeTraitSystem/Transform.h"
+#include "../include/PrototypeTraitSystem/PrototypeTraitSystem.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
 
+#include <algorithm>
+
 onEditDispatchHandlerFn Transform::_onEditDispatchHandler = nullptr;
+onEditDispatchHandlerFn Transform::_onPhysicsSyncHandler  = nullptr;
+onEditDispatchHandlerFn Transform::_onWorldSyncHandler    = nullptr;
+
+// the rigid part of a world matrix, its basis vectors normalized
+static inline glm::mat4
+unscaled(const glm::mat4& model)
+{
+    glm::mat4 result = model;
+    for (int c = 0; c < 3; ++c) {
+        const f32 length = glm::length(glm::vec3(result[c]));
+        if (length > 0.0f) { result[c] /= length; }
+    }
+    return result;
+}
 
 void
 Transform::setModel(const glm::mat4& model)
@@ -26,6 +43,7 @@ Transform::setModel(const glm::mat4& model)
     _model       = model;
     _modelScaled = _model;
     PrototypeMaths::buildModelMatrixWithScale(_modelScaled, _scale);
+    onLocalModelChanged();
     // updateComponentsFromMatrix();
 }
 
@@ -35,6 +53,7 @@ Transform::setModel(const float* model)
     _model       = glm::make_mat4(model);
     _modelScaled = _model;
     PrototypeMaths::buildModelMatrixWithScale(_modelScaled, _scale);
+    onLocalModelChanged();
     // updateComponentsFromMatrix();
 }
 
@@ -44,6 +63,7 @@ Transform::setModelScaled(const float* modelScaled)
     _modelScaled = glm::make_mat4(modelScaled);
     _model       = _modelScaled;
     PrototypeMaths::buildModelMatrixWithScale(_model, { 1.0f / _scale.x, 1.0f / _scale.y, 1.0f / _scale.z });
+    onLocalModelChanged();
 }
 
 void
@@ -52,153 +72,103 @@ Transform::updateComponentsFromMatrix()
     _needsComponentsSync = true;
 }
 
-const glm::vec3&
-Transform::position()
+void
+Transform::updateMatrixFromComponents()
 {
-    if (_needsComponentsSync) {
-        _needsComponentsSync = false;
-        glm::quat orientation;
-        glm::vec3 skew, position, scale;
-        glm::vec4 perspective;
-        glm::decompose(_modelScaled, scale, orientation, position, skew, perspective);
-        glm::vec3 rotation     = glm::degrees(glm::eulerAngles(orientation));
-        _position              = { position.x, position.y, position.z };
-        _rotation              = { rotation.x, rotation.y, rotation.z };
-        _scale                 = { scale.x, scale.y, scale.z };
-        constexpr f32 clampMin = 0.001f;
-        if (_scale.x < clampMin || _scale.y < clampMin || _scale.z < clampMin) {
-            _scale.x     = _scale.x < clampMin ? clampMin : _scale.x;
-            _scale.y     = _scale.y < clampMin ? clampMin : _scale.y;
-            _scale.z     = _scale.z < clampMin ? clampMin : _scale.z;
-            _modelScaled = _model;
-            PrototypeMaths::buildModelMatrixWithScale(_modelScaled, _scale);
+    glm::quat orientation;
+    PrototypeMaths::buildModelOrientation(orientation, _rotation);
+    PrototypeMaths::composeModelMatrices(&_model, &_position, &orientation, nullptr, 1);
+    PrototypeMaths::composeModelMatrices(&_modelScaled, &_position, &orientation, &_scale, 1);
+    _needsComponentsSync = false;
+    onLocalModelChanged();
+}
+
+void
+Transform::updateMatricesFromComponents(Transform* const* transforms, size_t count)
+{
+    constexpr size_t batchSize = 64;
+    glm::vec3        positions[batchSize];
+    glm::quat        orientations[batchSize];
+    glm::vec3        scales[batchSize];
+    glm::mat4        models[batchSize];
+    glm::mat4        modelsScaled[batchSize];
+    for (size_t first = 0; first < count; first += batchSize) {
+        const size_t size = std::min(batchSize, count - first);
+        for (size_t i = 0; i < size; ++i) {
+            Transform* transform = transforms[first + i];
+            if (transform->_needsComponentsSync) { transform->syncComponents(); }
+            positions[i] = transform->_position;
+            scales[i]    = transform->_scale;
+            PrototypeMaths::buildModelOrientation(orientations[i], transform->_rotation);
+        }
+        PrototypeMaths::composeModelMatrices(models, positions, orientations, nullptr, size);
+        PrototypeMaths::composeModelMatrices(modelsScaled, positions, orientations, scales, size);
+        for (size_t i = 0; i < size; ++i) {
+            Transform* transform    = transforms[first + i];
+            transform->_model       = models[i];
+            transform->_modelScaled = modelsScaled[i];
+            transform->onLocalModelChanged();
         }
     }
+}
+
+void
+Transform::setWorldPose(const glm::vec3& position, const glm::quat& orientation)
+{
+    if (_hasParent) {
+        glm::mat4 worldModel;
+        PrototypeMaths::composeModelMatrices(&worldModel, &position, &orientation, nullptr, 1);
+        setWorldModel(&worldModel[0][0]);
+        updateComponentsFromMatrix();
+        return;
+    }
+    if (_needsComponentsSync) { syncComponents(); }
+    _position = position;
+    PrototypeMaths::decomposeModelOrientation(orientation, _rotation);
+    PrototypeMaths::composeModelMatrices(&_model, &_position, &orientation, nullptr, 1);
+    PrototypeMaths::composeModelMatrices(&_modelScaled, &_position, &orientation, &_scale, 1);
+    onLocalModelChanged();
+}
+
+const glm::vec3&
+Transform::position()
+{
+    if (_needsComponentsSync) { syncComponents(); }
     return _position;
 }
 
 glm::vec3&
 Transform::positionMut()
 {
-    if (_needsComponentsSync) {
-        _needsComponentsSync = false;
-        glm::quat orientation;
-        glm::vec3 skew, position, scale;
-        glm::vec4 perspective;
-        glm::decompose(_modelScaled, scale, orientation, position, skew, perspective);
-        glm::vec3 rotation     = glm::degrees(glm::eulerAngles(orientation));
-        _position              = { position.x, position.y, position.z };
-        _rotation              = { rotation.x, rotation.y, rotation.z };
-        _scale                 = { scale.x, scale.y, scale.z };
-        constexpr f32 clampMin = 0.001f;
-        if (_scale.x < clampMin || _scale.y < clampMin || _scale.z < clampMin) {
-            _scale.x     = _scale.x < clampMin ? clampMin : _scale.x;
-            _scale.y     = _scale.y < clampMin ? clampMin : _scale.y;
-            _scale.z     = _scale.z < clampMin ? clampMin : _scale.z;
-            _modelScaled = _model;
-            PrototypeMaths::buildModelMatrixWithScale(_modelScaled, _scale);
-        }
-    }
+    if (_needsComponentsSync) { syncComponents(); }
     return _position;
 }
 
 const glm::vec3&
 Transform::rotation()
 {
-    if (_needsComponentsSync) {
-        _needsComponentsSync = false;
-        glm::quat orientation;
-        glm::vec3 skew, position, scale;
-        glm::vec4 perspective;
-        glm::decompose(_modelScaled, scale, orientation, position, skew, perspective);
-        glm::vec3 rotation     = glm::degrees(glm::eulerAngles(orientation));
-        _position              = { position.x, position.y, position.z };
-        _rotation              = { rotation.x, rotation.y, rotation.z };
-        _scale                 = { scale.x, scale.y, scale.z };
-        constexpr f32 clampMin = 0.001f;
-        if (_scale.x < clampMin || _scale.y < clampMin || _scale.z < clampMin) {
-            _scale.x     = _scale.x < clampMin ? clampMin : _scale.x;
-            _scale.y     = _scale.y < clampMin ? clampMin : _scale.y;
-            _scale.z     = _scale.z < clampMin ? clampMin : _scale.z;
-            _modelScaled = _model;
-            PrototypeMaths::buildModelMatrixWithScale(_modelScaled, _scale);
-        }
-    }
+    if (_needsComponentsSync) { syncComponents(); }
     return _rotation;
 }
 
 glm::vec3&
 Transform::rotationMut()
 {
-    if (_needsComponentsSync) {
-        _needsComponentsSync = false;
-        glm::quat orientation;
-        glm::vec3 skew, position, scale;
-        glm::vec4 perspective;
-        glm::decompose(_modelScaled, scale, orientation, position, skew, perspective);
-        glm::vec3 rotation     = glm::degrees(glm::eulerAngles(orientation));
-        _position              = { position.x, position.y, position.z };
-        _rotation              = { rotation.x, rotation.y, rotation.z };
-        _scale                 = { scale.x, scale.y, scale.z };
-        constexpr f32 clampMin = 0.001f;
-        if (_scale.x < clampMin || _scale.y < clampMin || _scale.z < clampMin) {
-            _scale.x     = _scale.x < clampMin ? clampMin : _scale.x;
-            _scale.y     = _scale.y < clampMin ? clampMin : _scale.y;
-            _scale.z     = _scale.z < clampMin ? clampMin : _scale.z;
-            _modelScaled = _model;
-            PrototypeMaths::buildModelMatrixWithScale(_modelScaled, _scale);
-        }
-    }
+    if (_needsComponentsSync) { syncComponents(); }
     return _rotation;
 }
 
 const glm::vec3&
 Transform::scale()
 {
-    if (_needsComponentsSync) {
-        _needsComponentsSync = false;
-        glm::quat orientation;
-        glm::vec3 skew, position, scale;
-        glm::vec4 perspective;
-        glm::decompose(_modelScaled, scale, orientation, position, skew, perspective);
-        glm::vec3 rotation     = glm::degrees(glm::eulerAngles(orientation));
-        _position              = { position.x, position.y, position.z };
-        _rotation              = { rotation.x, rotation.y, rotation.z };
-        _scale                 = { scale.x, scale.y, scale.z };
-        constexpr f32 clampMin = 0.001f;
-        if (_scale.x < clampMin || _scale.y < clampMin || _scale.z < clampMin) {
-            _scale.x     = _scale.x < clampMin ? clampMin : _scale.x;
-            _scale.y     = _scale.y < clampMin ? clampMin : _scale.y;
-            _scale.z     = _scale.z < clampMin ? clampMin : _scale.z;
-            _modelScaled = _model;
-            PrototypeMaths::buildModelMatrixWithScale(_modelScaled, _scale);
-        }
-    }
+    if (_needsComponentsSync) { syncComponents(); }
     return _scale;
 }
 
 glm::vec3&
 Transform::scaleMut()
 {
-    if (_needsComponentsSync) {
-        _needsComponentsSync = false;
-        glm::quat orientation;
-        glm::vec3 skew, position, scale;
-        glm::vec4 perspective;
-        glm::decompose(_modelScaled, scale, orientation, position, skew, perspective);
-        glm::vec3 rotation     = glm::degrees(glm::eulerAngles(orientation));
-        _position              = { position.x, position.y, position.z };
-        _rotation              = { rotation.x, rotation.y, rotation.z };
-        _scale                 = { scale.x, scale.y, scale.z };
-        constexpr f32 clampMin = 0.001f;
-        if (_scale.x < clampMin || _scale.y < clampMin || _scale.z < clampMin) {
-            _scale.x     = _scale.x < clampMin ? clampMin : _scale.x;
-            _scale.y     = _scale.y < clampMin ? clampMin : _scale.y;
-            _scale.z     = _scale.z < clampMin ? clampMin : _scale.z;
-            _modelScaled = _model;
-            PrototypeMaths::buildModelMatrixWithScale(_modelScaled, _scale);
-        }
-    }
+    if (_needsComponentsSync) { syncComponents(); }
     return _scale;
 }
 
@@ -220,6 +190,67 @@ Transform::modelScaled() const
     return _modelScaled;
 }
 
+const glm::mat4&
+Transform::worldModel() const
+{
+    return _worldModel;
+}
+
+const glm::mat4&
+Transform::worldModelScaled() const
+{
+    return _worldModelScaled;
+}
+
+void
+Transform::setWorldModel(const float* worldModel)
+{
+    if (!_hasParent) {
+        setModel(worldModel);
+        return;
+    }
+    glm::mat4 worldModelScaled = glm::make_mat4(worldModel);
+    PrototypeMaths::buildModelMatrixWithScale(worldModelScaled, scale());
+    setWorldModelScaled(&worldModelScaled[0][0]);
+}
+
+void
+Transform::setWorldModelScaled(const float* worldModelScaled)
+{
+    if (!_hasParent) {
+        setModelScaled(worldModelScaled);
+        return;
+    }
+    glm::mat4 modelScaled = glm::make_mat4(worldModelScaled);
+    glm::mat4 parentInverse;
+    PrototypeMaths::invertAffineMatrices(&parentInverse, &_parentWorldModelScaled, 1);
+    PrototypeMaths::multiplyMatrices(&modelScaled, &parentInverse, &modelScaled, 1);
+    setModelScaled(&modelScaled[0][0]);
+}
+
+void
+Transform::setHierarchyLinks(bool hasParent, bool hasChildren)
+{
+    _hasParent   = hasParent;
+    _hasChildren = hasChildren;
+    if (!_hasParent) { _parentWorldModelScaled = glm::mat4(1.0f); }
+}
+
+void
+Transform::updateWorldModel(const glm::mat4& parentWorldModelScaled)
+{
+    _parentWorldModelScaled = parentWorldModelScaled;
+    PrototypeMaths::multiplyMatrices(&_worldModelScaled, &_parentWorldModelScaled, &_modelScaled, 1);
+    _worldModel             = _hasParent ? unscaled(_worldModelScaled) : _model;
+    _needsWorldSync         = false;
+}
+
+const bool&
+Transform::needsWorldSync() const
+{
+    return _needsWorldSync;
+}
+
 const bool&
 Transform::needsPhysicsSync() const
 {
@@ -229,6 +260,7 @@ Transform::needsPhysicsSync() const
 void
 Transform::setNeedsPhysicsSync(bool needsPhysicsSync)
 {
+    if (needsPhysicsSync && !_needsPhysicsSync && _onPhysicsSyncHandler) { _onPhysicsSyncHandler(_object); }
     _needsPhysicsSync = needsPhysicsSync;
 }
 
@@ -244,10 +276,23 @@ Transform::setOnEditDispatchHandler(onEditDispatchHandlerFn onEditDispatchHandle
     _onEditDispatchHandler = onEditDispatchHandler;
 }
 
+void
+Transform::setOnPhysicsSyncHandler(onEditDispatchHandlerFn onPhysicsSyncHandler)
+{
+    _onPhysicsSyncHandler = onPhysicsSyncHandler;
+}
+
+void
+Transform::setOnWorldSyncHandler(onEditDispatchHandlerFn onWorldSyncHandler)
+{
+    _onWorldSyncHandler = onWorldSyncHandler;
+}
+
 void
 Transform::onEditDispatch(PrototypeObject* o)
 {
     if (_onEditDispatchHandler) { _onEditDispatchHandler(o); }
+    PrototypeTraitSystem::dispatchTraitChange(o, PrototypeTraitTypeMaskTransform);
 }
 
 void
@@ -282,4 +327,35 @@ Transform::from_json(const nlohmann::json& j, Transform& t, PrototypeObject* o)
     t._object              = o;
     t._needsPhysicsSync    = true;
     t._needsComponentsSync = false;
+    t.onLocalModelChanged();
+}
+
+void
+Transform::syncComponents()
+{
+    _needsComponentsSync = false;
+    PrototypeMaths::decomposeModelMatrix(_modelScaled, _position, _rotation, _scale);
+    constexpr f32 clampMin = 0.001f;
+    if (_scale.x < clampMin || _scale.y < clampMin || _scale.z < clampMin) {
+        _scale.x     = _scale.x < clampMin ? clampMin : _scale.x;
+        _scale.y     = _scale.y < clampMin ? clampMin : _scale.y;
+        _scale.z     = _scale.z < clampMin ? clampMin : _scale.z;
+        _modelScaled = _model;
+        PrototypeMaths::buildModelMatrixWithScale(_modelScaled, _scale);
+    }
+}
+
+void
+Transform::onLocalModelChanged()
+{
+    PrototypeTraitSystem::dispatchTraitChange(_object, PrototypeTraitTypeMaskTransform);
+    // roots stay in sync right away, only transforms in a hierarchy wait for the next hierarchy update
+    if (!_hasParent) {
+        _worldModel       = _model;
+        _worldModelScaled = _modelScaled;
+    }
+    if ((_hasParent || _hasChildren) && !_needsWorldSync) {
+        _needsWorldSync = true;
+        if (_onWorldSyncHandler) { _onWorldSyncHandler(_object); }
+    }
 }
\ No newline at end of file
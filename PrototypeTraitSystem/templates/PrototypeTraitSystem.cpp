@@ -27,6 +27,7 @@ PrototypeTraitSystemData::PrototypeTraitSystemData()
         , _remove{{ trait.name.functionName }}CbFn(nullptr)
         , _log{{ trait.name.functionName }}CbFn(nullptr)
     {% endfor %}
+    , _changeTraitCbFn(nullptr)
 {}
 
 PrototypeTraitSystemData::~PrototypeTraitSystemData() {}
@@ -288,6 +289,18 @@ PrototypeTraitSystem::objects()
     }
 {% endfor %}
 
+void PrototypeTraitSystem::setTraitChangeCbFnPtr(changeTraitFn cbfn)
+{
+    PrototypeTraitSystem::_data->_changeTraitCbFn = cbfn;
+}
+
+void PrototypeTraitSystem::dispatchTraitChange(PrototypeObject* object, MASK_TYPE traitMask)
+{
+    if (object && PrototypeTraitSystem::_data && PrototypeTraitSystem::_data->_changeTraitCbFn) {
+        PrototypeTraitSystem::_data->_changeTraitCbFn(object, traitMask);
+    }
+}
+
 extern void**
 PrototypeTraitSystemGetDataInternal()
 {
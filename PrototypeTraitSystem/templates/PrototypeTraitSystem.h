@@ -61,6 +61,9 @@ struct PrototypeTraitSystem;
     typedef void(PROTOTYPE_DYNAMIC_FN_CALL* log{{ trait.name.functionName }}Fn)(PrototypeObject*, {{ trait.name.text }}*);
 {% endfor %}
 
+// called with the mask of the trait whenever one of its saved fields changes, physics workers call it too
+typedef void(PROTOTYPE_DYNAMIC_FN_CALL* changeTraitFn)(PrototypeObject*, MASK_TYPE);
+
 static const MASK_TYPE PrototypeTraitTypeCount = {{ data.count }};
 
 {% for trait in data.traits -%}
@@ -175,6 +178,8 @@ struct PrototypeTraitSystemData
     {% for trait in data.traits -%}
         log{{ trait.name.functionName }}Fn _log{{ trait.name.functionName }}CbFn;
     {% endfor %}
+
+    changeTraitFn _changeTraitCbFn;
 };
 
 struct PrototypeTraitSystem
@@ -210,6 +215,9 @@ struct PrototypeTraitSystem
     {% for trait in data.traits -%}
         static void set{{ trait.name.functionName }}TraitLogCbFnPtr(log{{ trait.name.functionName }}Fn cbfn);
     {% endfor %}
+
+    static void setTraitChangeCbFnPtr(changeTraitFn cbfn);
+    static void dispatchTraitChange(PrototypeObject* object, MASK_TYPE traitMask);
     
     static PrototypeTraitSystemData* data();
     static void                      setData(PrototypeTraitSystemData* data);